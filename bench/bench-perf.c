@@ -0,0 +1,119 @@
+/**
+ * @file bench-perf.c
+ * @brief perf_event_open 기반 하드웨어/소프트웨어 카운터 수집
+ *
+ * 벤치마크의 측정 구간을 사이클, 명령어, 캐시 미스, 컨텍스트 스위치, 시스템 콜 수로 계측합니다.
+ * 컨테이너 등에서 perf 이벤트를 열 수 없으면 해당 카운터만 건너뜁니다.
+ */
+#include "bench-perf.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYSCALL_TRACEPOINT_ID_PATH_1 "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id"
+#define SYSCALL_TRACEPOINT_ID_PATH_2 "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"
+
+static const char *g_kapchPerfNames[BENCH_PERF_COUNT] = {
+    "cycles",
+    "instructions",
+    "cache_misses",
+    "context_switches",
+    "syscalls",
+};
+
+
+static long long readTracepointId(void)
+{
+    const char *kapchPaths[] = { SYSCALL_TRACEPOINT_ID_PATH_1, SYSCALL_TRACEPOINT_ID_PATH_2 };
+
+    for (size_t i = 0; i < sizeof(kapchPaths) / sizeof(kapchPaths[0]); i++) {
+        FILE *pFile = fopen(kapchPaths[i], "r");
+        long long llId = -1;
+        if (pFile == NULL) {
+            continue;
+        }
+        if (fscanf(pFile, "%lld", &llId) != 1) {
+            llId = -1;
+        }
+        fclose(pFile);
+        if (llId >= 0) {
+            return llId;
+        }
+    }
+    return -1;
+}
+
+static int openPerfEvent(unsigned int uiType, unsigned long long ullConfig)
+{
+    struct perf_event_attr stAttr;
+
+    memset(&stAttr, 0, sizeof(stAttr));
+    stAttr.size = sizeof(stAttr);
+    stAttr.type = uiType;
+    stAttr.config = ullConfig;
+    stAttr.disabled = 1;
+    stAttr.inherit = 1;
+    stAttr.exclude_hv = 1;
+
+    // 권한이 부족하면 커널 구간을 제외하고 다시 시도
+    int iFd = (int)syscall(SYS_perf_event_open, &stAttr, 0, -1, -1, 0);
+    if (iFd < 0 && uiType != PERF_TYPE_TRACEPOINT) {
+        stAttr.exclude_kernel = 1;
+        iFd = (int)syscall(SYS_perf_event_open, &stAttr, 0, -1, -1, 0);
+    }
+    return iFd;
+}
+
+
+int startBenchPerf(BenchPerf *pstPerf)
+{
+    int iOpened = 0;
+    long long llTracepoint = readTracepointId();
+
+    memset(pstPerf, 0, sizeof(*pstPerf));
+    pstPerf->aiFd[BENCH_PERF_CYCLES] = openPerfEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    pstPerf->aiFd[BENCH_PERF_INSTRUCTIONS] = openPerfEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    pstPerf->aiFd[BENCH_PERF_CACHE_MISSES] = openPerfEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    pstPerf->aiFd[BENCH_PERF_CONTEXT_SWITCHES] = openPerfEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+    pstPerf->aiFd[BENCH_PERF_SYSCALLS] = (llTracepoint >= 0)
+                                       ? openPerfEvent(PERF_TYPE_TRACEPOINT, (unsigned long long)llTracepoint) : -1;
+
+    for (int i = 0; i < BENCH_PERF_COUNT; i++) {
+        if (pstPerf->aiFd[i] >= 0) {
+            ioctl(pstPerf->aiFd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(pstPerf->aiFd[i], PERF_EVENT_IOC_ENABLE, 0);
+            iOpened++;
+        }
+    }
+    return iOpened;
+}
+
+void stopBenchPerf(BenchPerf *pstPerf)
+{
+    for (int i = 0; i < BENCH_PERF_COUNT; i++) {
+        if (pstPerf->aiFd[i] < 0) {
+            continue;
+        }
+        ioctl(pstPerf->aiFd[i], PERF_EVENT_IOC_DISABLE, 0);
+        pstPerf->aiValid[i] = (read(pstPerf->aiFd[i], &pstPerf->aullValue[i], sizeof(pstPerf->aullValue[i]))
+                               == (ssize_t)sizeof(pstPerf->aullValue[i]));
+        close(pstPerf->aiFd[i]);
+        pstPerf->aiFd[i] = -1;
+    }
+}
+
+int hasBenchPerf(const BenchPerf *kpstPerf, BenchPerfCounter eId)
+{
+    return kpstPerf->aiValid[eId];
+}
+
+const char *getBenchPerfName(BenchPerfCounter eId)
+{
+    return g_kapchPerfNames[eId];
+}
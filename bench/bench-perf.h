@@ -0,0 +1,68 @@
+#ifndef BENCH_PERF_H
+#define BENCH_PERF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 벤치마크 측정 구간에서 수집하는 카운터 목록
+ */
+typedef enum {
+    BENCH_PERF_CYCLES = 0,          /**< CPU 사이클 */
+    BENCH_PERF_INSTRUCTIONS,        /**< 실행한 명령어 수 */
+    BENCH_PERF_CACHE_MISSES,        /**< 마지막 단계 캐시 미스 */
+    BENCH_PERF_CONTEXT_SWITCHES,    /**< 컨텍스트 스위치 */
+    BENCH_PERF_SYSCALLS,            /**< 시스템 콜 진입 (raw_syscalls:sys_enter 추적점) */
+    BENCH_PERF_COUNT
+} BenchPerfCounter;
+
+/**
+ * @brief 측정 구간의 perf_event_open 카운터 묶음
+ *
+ * @details 열지 못하거나 읽지 못한 카운터는 값이 보고되지 않습니다. 카운터는 inherit 모드로 열려
+ *          구간 안에서 생성되어 구간이 끝나기 전에 종료된 스레드의 값도 합산됩니다.
+ */
+typedef struct {
+    int aiFd[BENCH_PERF_COUNT];                     /**< 측정 중인 카운터 fd (열지 못했으면 -1) */
+    int aiValid[BENCH_PERF_COUNT];                  /**< 값을 읽었으면 1 */
+    unsigned long long aullValue[BENCH_PERF_COUNT];
+} BenchPerf;
+
+/**
+ * @brief 카운터를 열고 측정을 시작합니다.
+ *
+ * @param pstPerf 카운터 묶음 포인터
+ * @return 열린 카운터 수 (0이면 perf 이벤트를 사용할 수 없음)
+ */
+int startBenchPerf(BenchPerf *);
+
+/**
+ * @brief 측정을 끝내고 값을 읽은 뒤 카운터를 닫습니다.
+ *
+ * @param pstPerf 카운터 묶음 포인터
+ */
+void stopBenchPerf(BenchPerf *);
+
+/**
+ * @brief 카운터 값을 사용할 수 있는지 반환합니다.
+ *
+ * @param kpstPerf 카운터 묶음 포인터
+ * @param eId 카운터 종류
+ * @return 사용 가능하면 1, 아니면 0
+ */
+int hasBenchPerf(const BenchPerf *, BenchPerfCounter);
+
+/**
+ * @brief 카운터 이름을 반환합니다.
+ *
+ * @param eId 카운터 종류
+ * @return 카운터 이름 문자열
+ */
+const char *getBenchPerfName(BenchPerfCounter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
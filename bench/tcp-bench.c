@@ -0,0 +1,443 @@
+/**
+ * @file tcp-bench.c
+ * @brief 송수신 방식별 처리량 및 메시지당 비용 벤치마크
+ *
+ * 루프백 TCP 연결 한 개로 송수신 방식마다 같은 수의 메시지를 보내고, 처리량과 함께
+ * perf_event_open 카운터로 메시지당 사이클, 명령어, 캐시 미스, 컨텍스트 스위치, 시스템 콜 수와
+ * 라이브러리 카운터로 메시지당 복사 바이트 수를 보고합니다. perf 이벤트를 사용할 수 없으면
+ * 해당 열은 n/a로 표시되며, 시스템 콜 수는 라이브러리의 송수신 호출 수로 대체합니다.
+ * frame 방식은 페이로드에 전송 시각을 실어 메시지 단위 지연 백분위도 보고합니다.
+ * -i로 장애 설정을 주면 양쪽 소켓에 setConnImpairment()를 적용하여 장애 상황의 처리량과
+ * 꼬리 지연을 측정합니다.
+ * 할당 추적 모드(TCP_ALLOC_TRACK)로 빌드되므로, 워밍업 이후 송수신 스레드에서 할당이 일어나면
+ * 메시지당 할당 수와 호출 위치를 보고하고 실패로 처리합니다. 장애 설정의 전송 대기열은
+ * 복사본을 할당하므로 -i를 준 경우에는 보고만 합니다.
+ *
+ * codec 방식은 코덱 파이프라인(프레임 코덱)으로 BENCH_CODEC_BATCH개씩 묶어 보냅니다.
+ *
+ * 사용법: tcp-bench [-n 메시지 수] [-s 메시지 크기] [-p 포트] [-m 방식] [-i 장애 설정]
+ * 방식: send, sendv, frame, adaptive, codec, all (기본값)
+ * 장애 설정 예: -i delay=500,jitter=200,rate=50000000,write=1024,read=512
+ */
+#include "tcp-sock.h"
+#include "tcp-alloc.h"
+#include "tcp-codec.h"
+#include "tcp-conn.h"
+#include "tcp-frame.h"
+#include "tcp-impair.h"
+#include "tcp-metrics.h"
+#include "bench-perf.h"
+
+#include <unistd.h>
+#include <sys/uio.h>
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_MSGS      200000
+#define BENCH_DEFAULT_SIZE      256
+#define BENCH_DEFAULT_PORT      12380
+#define BENCH_HEADER_SIZE       8
+#define BENCH_WARMUP_MSGS       1000    /**< 할당 감시 전 워밍업 메시지 수 (최대 전체의 1/10) */
+#define BENCH_CODEC_BATCH       16      /**< codec 방식에서 한 번에 보내는 메시지 수 */
+
+typedef enum {
+    BENCH_MODE_SEND = 0,        /**< sendMessage() / recvMsgBlocking() */
+    BENCH_MODE_SENDV,           /**< sendMessageV() (헤더 + 본문) / recvMsgBlocking() */
+    BENCH_MODE_FRAME,           /**< sendFrame() / recvFrame() */
+    BENCH_MODE_ADAPTIVE,        /**< sendMessage() / recvMsgAdaptive() */
+    BENCH_MODE_CODEC,           /**< queueCodecMessage() + flushCodecPipe() / recvCodecMessage() (프레임 코덱) */
+    BENCH_MODE_COUNT
+} BenchMode;
+
+typedef struct {
+    BenchMode eMode;
+    int iSock;
+    size_t uiMsgSize;
+    long lMsgs;
+    int iResult;
+    TcpHistogram *pstLatency;   /**< 메시지 단위 지연 (frame 방식 수신 측) */
+    long lWarmup;               /**< 할당 감시를 시작할 메시지 순번 */
+    unsigned long long ullAllocs;   /**< 워밍업 이후 할당 수 */
+} BenchPeer;
+
+static const char *g_kapchModeNames[BENCH_MODE_COUNT] = {
+    "send",
+    "sendv",
+    "frame",
+    "adaptive",
+    "codec",
+};
+
+
+static void startAllocGuard(int *piArmed)
+{
+    if (!*piArmed && isAllocTrackingEnabled()) {
+        armAllocGuard();
+        *piArmed = 1;
+    }
+}
+
+static void finishAllocGuard(BenchPeer *pstPeer, int iArmed, const char *kpchWho)
+{
+    pstPeer->ullAllocs = 0;
+    if (iArmed) {
+        pstPeer->ullAllocs = disarmAllocGuard();
+        if (pstPeer->ullAllocs > 0) {
+            reportAllocViolations(stderr, kpchWho);
+        }
+    }
+}
+
+static void *runReceiver(void *pvArg)
+{
+    BenchPeer *pstPeer = (BenchPeer *)pvArg;
+    size_t uiCapacity = pstPeer->uiMsgSize + BENCH_HEADER_SIZE + TCP_RECV_MAX_SIZE;
+    void *pvBuffer = malloc(uiCapacity);
+    unsigned long long ullExpected = (unsigned long long)pstPeer->lMsgs * pstPeer->uiMsgSize;
+    unsigned long long ullReceived = 0;
+    void *pvAdaptive = NULL;
+    TcpCodecPipe *pstPipe = NULL;
+    int iArmed = 0;
+
+    if (pstPeer->eMode == BENCH_MODE_SENDV) {
+        ullExpected += (unsigned long long)pstPeer->lMsgs * BENCH_HEADER_SIZE;
+    }
+    unsigned long long ullWarmupBytes = ullExpected / (unsigned long long)pstPeer->lMsgs
+                                      * (unsigned long long)pstPeer->lWarmup;
+
+    pstPeer->iResult = 0;
+    if (pvBuffer == NULL) {
+        pstPeer->iResult = -1;
+        return NULL;
+    }
+
+    if (pstPeer->eMode == BENCH_MODE_FRAME) {
+        for (long i = 0; i < pstPeer->lMsgs; i++) {
+            TcpFrameHeader stHeader;
+            if (i == pstPeer->lWarmup) {
+                startAllocGuard(&iArmed);
+            }
+            if (recvFrame(pstPeer->iSock, pvBuffer, uiCapacity, &stHeader) < 0) {
+                pstPeer->iResult = -1;
+                break;
+            }
+            if (pstPeer->pstLatency != NULL) {
+                unsigned long long ullSendNsec;
+                memcpy(&ullSendNsec, pvBuffer, sizeof(ullSendNsec));
+                recordHistogram(pstPeer->pstLatency, getMonotonicNsec() - ullSendNsec);
+            }
+        }
+    } else if (pstPeer->eMode == BENCH_MODE_CODEC) {
+        pstPipe = (TcpCodecPipe *)malloc(sizeof(TcpCodecPipe));
+        if (pstPipe == NULL) {
+            pstPeer->iResult = -1;
+        } else {
+            initCodecPipe(pstPipe, pstPeer->iSock, pvBuffer, uiCapacity);
+            pushCodecLayer(pstPipe, getFrameCodec(), NULL);
+        }
+        for (long i = 0; i < pstPeer->lMsgs && pstPeer->iResult == 0; i++) {
+            TcpCodecMsg stMsg;
+            if (i == pstPeer->lWarmup) {
+                startAllocGuard(&iArmed);
+            }
+            if (recvCodecMessage(pstPipe, &stMsg) <= 0) {
+                pstPeer->iResult = -1;
+            }
+        }
+    } else if (pstPeer->eMode == BENCH_MODE_ADAPTIVE) {
+        size_t uiAdaptiveCapacity = 0;
+        while (ullReceived < ullExpected) {
+            if (ullReceived >= ullWarmupBytes) {
+                startAllocGuard(&iArmed);
+            }
+            int iReceived = recvMsgAdaptive(pstPeer->iSock, &pvAdaptive, &uiAdaptiveCapacity);
+            if (iReceived <= 0) {
+                pstPeer->iResult = -1;
+                break;
+            }
+            ullReceived += (unsigned long long)iReceived;
+        }
+    } else {
+        while (ullReceived < ullExpected) {
+            if (ullReceived >= ullWarmupBytes) {
+                startAllocGuard(&iArmed);
+            }
+            int iReceived = recvMsgBlocking(pstPeer->iSock, pvBuffer, uiCapacity);
+            if (iReceived <= 0) {
+                pstPeer->iResult = -1;
+                break;
+            }
+            ullReceived += (unsigned long long)iReceived;
+        }
+    }
+
+    finishAllocGuard(pstPeer, iArmed, "receiver");
+    free(pstPipe);
+    free(pvAdaptive);
+    free(pvBuffer);
+    return NULL;
+}
+
+static void *runSender(void *pvArg)
+{
+    BenchPeer *pstPeer = (BenchPeer *)pvArg;
+    char *pchPayload = (char *)malloc(pstPeer->uiMsgSize);
+    char achHeader[BENCH_HEADER_SIZE];
+    TcpCodecPipe *pstPipe = NULL;
+    int iArmed = 0;
+
+    pstPeer->iResult = 0;
+    if (pstPeer->eMode == BENCH_MODE_CODEC) {
+        pstPipe = (TcpCodecPipe *)malloc(sizeof(TcpCodecPipe));
+        if (pstPipe != NULL) {
+            initCodecPipe(pstPipe, pstPeer->iSock, NULL, 0);
+            pushCodecLayer(pstPipe, getFrameCodec(), NULL);
+        }
+    }
+    if (pchPayload == NULL || (pstPeer->eMode == BENCH_MODE_CODEC && pstPipe == NULL)) {
+        pstPeer->iResult = -1;
+        free(pchPayload);
+        free(pstPipe);
+        return NULL;
+    }
+    memset(pchPayload, 'b', pstPeer->uiMsgSize);
+    memset(achHeader, 'h', sizeof(achHeader));
+
+    for (long i = 0; i < pstPeer->lMsgs && pstPeer->iResult == 0; i++) {
+        int iSent;
+        if (i == pstPeer->lWarmup) {
+            startAllocGuard(&iArmed);
+        }
+        if (pstPeer->eMode == BENCH_MODE_SENDV) {
+            struct iovec astIov[2];
+            astIov[0].iov_base = achHeader;
+            astIov[0].iov_len = sizeof(achHeader);
+            astIov[1].iov_base = pchPayload;
+            astIov[1].iov_len = pstPeer->uiMsgSize;
+            iSent = sendMessageV(pstPeer->iSock, astIov, 2);
+        } else if (pstPeer->eMode == BENCH_MODE_FRAME) {
+            if (pstPeer->pstLatency != NULL) {
+                unsigned long long ullSendNsec = getMonotonicNsec();
+                memcpy(pchPayload, &ullSendNsec, sizeof(ullSendNsec));
+            }
+            iSent = sendFrame(pstPeer->iSock, pchPayload, pstPeer->uiMsgSize, NULL);
+        } else if (pstPeer->eMode == BENCH_MODE_CODEC) {
+            struct iovec stIov;
+            stIov.iov_base = pchPayload;
+            stIov.iov_len = pstPeer->uiMsgSize;
+            iSent = queueCodecMessage(pstPipe, &stIov, 1);
+            if (iSent == 0 && ((i + 1) % BENCH_CODEC_BATCH == 0 || i + 1 == pstPeer->lMsgs)) {
+                iSent = flushCodecPipe(pstPipe);
+            }
+        } else {
+            // 부분 쓰기(장애 설정의 write 등)가 발생하면 나머지를 이어서 전송
+            size_t uiDone = 0;
+            do {
+                iSent = sendMessage(pstPeer->iSock, pchPayload + uiDone, pstPeer->uiMsgSize - uiDone);
+                uiDone += (iSent > 0) ? (size_t)iSent : 0;
+            } while (iSent >= 0 && uiDone < pstPeer->uiMsgSize);
+        }
+        if (iSent < 0) {
+            pstPeer->iResult = -1;
+        }
+    }
+
+    finishAllocGuard(pstPeer, iArmed, "sender");
+    free(pstPipe);
+    free(pchPayload);
+    return NULL;
+}
+
+static void printPerMessage(const BenchPerf *kpstPerf, BenchPerfCounter eId, long lMsgs)
+{
+    if (hasBenchPerf(kpstPerf, eId)) {
+        printf(" %12.2f", (double)kpstPerf->aullValue[eId] / (double)lMsgs);
+    } else {
+        printf(" %12s", "n/a");
+    }
+}
+
+static int runBenchMode(BenchMode eMode, int iServerSock, int iPort, size_t uiMsgSize, long lMsgs,
+                        const TcpImpairment *kpstImpair)
+{
+    int iClientSock = createClientSocket("127.0.0.1", iPort);
+    if (iClientSock < 0) {
+        return -1;
+    }
+    int iPeerSock = acceptClientSocket(iServerSock);
+    if (iPeerSock < 0) {
+        close(iClientSock);
+        return -1;
+    }
+
+    if (kpstImpair != NULL
+        && (setConnImpairment(iClientSock, kpstImpair) < 0 || setConnImpairment(iPeerSock, kpstImpair) < 0)) {
+        close(iClientSock);
+        close(iPeerSock);
+        return -1;
+    }
+
+    // 지연은 전송 시각을 페이로드 앞 8바이트에 싣는 frame 방식에서만 측정
+    static TcpHistogram s_stLatency;
+    TcpHistogram *pstLatency = NULL;
+    if (eMode == BENCH_MODE_FRAME && uiMsgSize >= sizeof(unsigned long long)) {
+        resetHistogram(&s_stLatency);
+        pstLatency = &s_stLatency;
+    }
+
+    long lWarmup = lMsgs / 10 < BENCH_WARMUP_MSGS ? lMsgs / 10 : BENCH_WARMUP_MSGS;
+    BenchPeer stSender = { eMode, iClientSock, uiMsgSize, lMsgs, 0, pstLatency, lWarmup, 0 };
+    BenchPeer stReceiver = { eMode, iPeerSock, uiMsgSize, lMsgs, 0, pstLatency, lWarmup, 0 };
+    pthread_t stSendThread;
+    pthread_t stRecvThread;
+    BenchPerf stPerf;
+
+    unsigned long long ullBytesBefore = getMetricCounter(TCP_COUNTER_BYTES_SENT)
+                                      + getMetricCounter(TCP_COUNTER_BYTES_RECEIVED);
+    unsigned long long ullCallsBefore = getMetricCounter(TCP_COUNTER_SEND_CALLS)
+                                      + getMetricCounter(TCP_COUNTER_RECV_CALLS);
+
+    // 카운터는 측정 스레드 생성 전에 열어야 inherit로 두 스레드가 모두 계측됨
+    startBenchPerf(&stPerf);
+    unsigned long long ullStart = getMonotonicNsec();
+    pthread_create(&stRecvThread, NULL, runReceiver, &stReceiver);
+    pthread_create(&stSendThread, NULL, runSender, &stSender);
+    pthread_join(stSendThread, NULL);
+    pthread_join(stRecvThread, NULL);
+    unsigned long long ullElapsed = getMonotonicNsec() - ullStart;
+    stopBenchPerf(&stPerf);
+
+    unsigned long long ullBytes = getMetricCounter(TCP_COUNTER_BYTES_SENT)
+                                + getMetricCounter(TCP_COUNTER_BYTES_RECEIVED) - ullBytesBefore;
+    unsigned long long ullCalls = getMetricCounter(TCP_COUNTER_SEND_CALLS)
+                                + getMetricCounter(TCP_COUNTER_RECV_CALLS) - ullCallsBefore;
+    double dSeconds = (double)ullElapsed / 1e9;
+
+    printf("%-9s %10.0f %9.1f", g_kapchModeNames[eMode], (double)lMsgs / dSeconds,
+           (double)lMsgs * (double)uiMsgSize / dSeconds / (1024.0 * 1024.0));
+    printPerMessage(&stPerf, BENCH_PERF_CYCLES, lMsgs);
+    printPerMessage(&stPerf, BENCH_PERF_INSTRUCTIONS, lMsgs);
+    printPerMessage(&stPerf, BENCH_PERF_CACHE_MISSES, lMsgs);
+    printPerMessage(&stPerf, BENCH_PERF_CONTEXT_SWITCHES, lMsgs);
+    if (hasBenchPerf(&stPerf, BENCH_PERF_SYSCALLS)) {
+        printPerMessage(&stPerf, BENCH_PERF_SYSCALLS, lMsgs);
+    } else {
+        printf(" %9.2f(lib)", (double)ullCalls / (double)lMsgs);
+    }
+    printf(" %12.1f", (double)ullBytes / (double)lMsgs);
+    unsigned long long ullAllocs = stSender.ullAllocs + stReceiver.ullAllocs;
+    if (isAllocTrackingEnabled()) {
+        printf(" %10.3f", (double)ullAllocs / (double)(lMsgs - lWarmup));
+    } else {
+        printf(" %10s", "n/a");
+    }
+    if (pstLatency != NULL) {
+        printf(" %9.1f %9.1f %9.1f", (double)getHistogramPercentile(pstLatency, 50.0) / 1000.0,
+               (double)getHistogramPercentile(pstLatency, 99.0) / 1000.0,
+               (double)getHistogramPercentile(pstLatency, 99.9) / 1000.0);
+    } else {
+        printf(" %9s %9s %9s", "-", "-", "-");
+    }
+    printf("%s", (stSender.iResult == 0 && stReceiver.iResult == 0) ? "" : "  (failed)");
+    // 장애 설정의 전송 대기열은 설계상 할당하므로 무할당 보장은 장애 설정이 없을 때만 검사
+    int iAllocFailed = (ullAllocs > 0 && kpstImpair == NULL);
+    printf("%s\n", iAllocFailed ? "  (allocates)" : "");
+
+    if (kpstImpair != NULL) {
+        setConnImpairment(iClientSock, NULL);
+        setConnImpairment(iPeerSock, NULL);
+    }
+    removeConnInfo(iClientSock);
+    removeConnInfo(iPeerSock);
+    close(iClientSock);
+    close(iPeerSock);
+    return (stSender.iResult == 0 && stReceiver.iResult == 0 && !iAllocFailed) ? 0 : -1;
+}
+
+
+int main(int argc, char *argv[])
+{
+    long lMsgs = BENCH_DEFAULT_MSGS;
+    size_t uiMsgSize = BENCH_DEFAULT_SIZE;
+    int iPort = BENCH_DEFAULT_PORT;
+    int iModeMask = (1 << BENCH_MODE_COUNT) - 1;
+    TcpImpairment stImpair;
+    const TcpImpairment *kpstImpair = NULL;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "n:s:p:m:i:")) != -1) {
+        switch (iOpt) {
+        case 'n':
+            lMsgs = atol(optarg);
+            break;
+        case 's':
+            uiMsgSize = (size_t)atol(optarg);
+            break;
+        case 'p':
+            iPort = atoi(optarg);
+            break;
+        case 'm':
+            iModeMask = 0;
+            for (int i = 0; i < BENCH_MODE_COUNT; i++) {
+                if (strcmp(optarg, g_kapchModeNames[i]) == 0) {
+                    iModeMask = 1 << i;
+                }
+            }
+            if (strcmp(optarg, "all") == 0) {
+                iModeMask = (1 << BENCH_MODE_COUNT) - 1;
+            }
+            break;
+        case 'i':
+            if (parseImpairment(optarg, &stImpair) < 0) {
+                return EXIT_FAILURE;
+            }
+            kpstImpair = &stImpair;
+            break;
+        default:
+            iModeMask = 0;
+            break;
+        }
+    }
+    if (iModeMask == 0 || lMsgs <= 0 || uiMsgSize == 0 || uiMsgSize > TCP_FRAME_MAX_PAYLOAD) {
+        fprintf(stderr, "usage: %s [-n msgs] [-s size] [-p port] [-m send|sendv|frame|adaptive|codec|all] [-i impairment]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (isPortAvailable(iPort) != 0) {
+        fprintf(stderr, "port %d is in use\n", iPort);
+        return EXIT_FAILURE;
+    }
+    int iServerSock = createServerSocket(iPort, 8);
+    if (iServerSock < 0) {
+        return EXIT_FAILURE;
+    }
+
+    BenchPerf stProbe;
+    if (startBenchPerf(&stProbe) == 0) {
+        printf("# perf events unavailable (perf_event_paranoid or container policy); reporting library counters only\n");
+    }
+    stopBenchPerf(&stProbe);
+
+    printf("# %ld messages of %zu bytes over loopback TCP\n", lMsgs, uiMsgSize);
+    if (kpstImpair != NULL) {
+        printf("# impairment: delay %u us, jitter %u us, rate %llu B/s, write %u, read %u, stall %u/1000 x %u us\n",
+               kpstImpair->uiDelayUsec, kpstImpair->uiJitterUsec, kpstImpair->ullRateBytes, kpstImpair->uiMaxWrite,
+               kpstImpair->uiMaxRead, kpstImpair->uiStallPermille, kpstImpair->uiStallUsec);
+    }
+    printf("%-9s %10s %9s %12s %12s %12s %12s %12s %12s %10s %9s %9s %9s\n", "mode", "msgs/s", "MB/s", "cycles/msg",
+           "instr/msg", "llc_miss/msg", "ctxsw/msg", "syscalls/msg", "bytes/msg", "allocs/msg", "p50_us", "p99_us", "p999_us");
+
+    int iResult = 0;
+    for (int i = 0; i < BENCH_MODE_COUNT; i++) {
+        if ((iModeMask & (1 << i)) && runBenchMode((BenchMode)i, iServerSock, iPort, uiMsgSize, lMsgs, kpstImpair) < 0) {
+            iResult = -1;
+        }
+    }
+
+    close(iServerSock);
+    return (iResult == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
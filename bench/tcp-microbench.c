@@ -0,0 +1,394 @@
+/**
+ * @file tcp-microbench.c
+ * @brief 핵심 자료구조 마이크로벤치마크
+ *
+ * 루프백 종단 간 벤치마크(tcp-bench)와 별도로, 송수신 경로에서 반복 호출되는 구성 요소를
+ * 하나씩 측정합니다. 벤치마크마다 워밍업 반복을 버린 뒤 정해진 횟수만큼 반복하여
+ * 연산당 시간의 중앙값, 평균, 표준편차, 최소/최대와 연산당 사이클 수를 보고합니다.
+ *
+ * 사용법: tcp-microbench [-r 반복 수] [-w 워밍업 반복 수] [-n 반복당 연산 수] [-f 이름 필터]
+ */
+#include "tcp-conn.h"
+#include "tcp-frame.h"
+#include "tcp-http.h"
+#include "tcp-metrics.h"
+#include "tcp-resp.h"
+#include "tcp-timer.h"
+#include "tcp-ws.h"
+
+#include <unistd.h>
+#include <math.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MICRO_DEFAULT_REPS      10
+#define MICRO_DEFAULT_WARMUP    2
+#define MICRO_DEFAULT_ITERS     1000000L
+#define MICRO_MAX_REPS          1000
+
+/**
+ * @brief 연결 테이블 벤치마크에 쓰는 소켓 번호 범위 (실제 소켓과 겹치지 않도록 큰 번호 사용)
+ */
+#define MICRO_CONN_FD_BASE      500000
+#define MICRO_CONN_COUNT        1024
+
+#define MICRO_TIMER_COUNT       1024
+
+#define MICRO_WS_PAYLOAD        4096
+
+typedef struct {
+    const char *kpchName;
+    void (*pfnSetup)(void);
+    unsigned long long (*pfnRun)(long);     /**< 연산 수를 받아 최적화 방지용 값을 반환 */
+    void (*pfnTeardown)(void);
+} MicroBench;
+
+typedef struct {
+    double dMedian;
+    double dMean;
+    double dStddev;
+    double dMin;
+    double dMax;
+    double dCycles;
+} MicroResult;
+
+static volatile unsigned long long g_ullSink;
+
+static unsigned char g_aucPlainHeader[TCP_FRAME_MAX_HEADER];
+static unsigned char g_aucTraceHeader[TCP_FRAME_MAX_HEADER];
+static TcpTimerWheel g_stWheel;
+static TcpTimer g_astTimers[MICRO_TIMER_COUNT];
+static TcpHistogram g_stHistogram;
+static unsigned char g_aucWsPayload[MICRO_WS_PAYLOAD];
+
+
+static void setupFrame(void)
+{
+    TcpTraceContext stTrace;
+    memset(&stTrace, 0x5a, sizeof(stTrace));
+    encodeFrameHeader(g_aucPlainHeader, 1234, NULL);
+    encodeFrameHeader(g_aucTraceHeader, 1234, &stTrace);
+}
+
+static unsigned long long runFrameEncode(long lIters)
+{
+    unsigned char aucHeader[TCP_FRAME_MAX_HEADER];
+    unsigned long long ullSum = 0;
+
+    for (long i = 0; i < lIters; i++) {
+        ullSum += (unsigned long long)encodeFrameHeader(aucHeader, (size_t)i & 0xffff, NULL);
+        ullSum += aucHeader[3];
+    }
+    return ullSum;
+}
+
+static unsigned long long runFrameParse(long lIters)
+{
+    TcpFrameHeader stHeader;
+    unsigned long long ullSum = 0;
+
+    for (long i = 0; i < lIters; i++) {
+        ullSum += (unsigned long long)parseFrameHeader(g_aucPlainHeader, sizeof(g_aucPlainHeader), &stHeader);
+        ullSum += stHeader.uiPayloadLength;
+    }
+    return ullSum;
+}
+
+static unsigned long long runFrameParseTrace(long lIters)
+{
+    TcpFrameHeader stHeader;
+    unsigned long long ullSum = 0;
+
+    for (long i = 0; i < lIters; i++) {
+        ullSum += (unsigned long long)parseFrameHeader(g_aucTraceHeader, sizeof(g_aucTraceHeader), &stHeader);
+        ullSum += stHeader.stTrace.aucSpanId[0];
+    }
+    return ullSum;
+}
+
+static void timerNop(TcpTimer *pstTimer, void *pvArg)
+{
+    (void)pstTimer;
+    g_ullSink += (unsigned long long)(size_t)pvArg;
+}
+
+static void setupTimer(void)
+{
+    initTimerWheel(&g_stWheel, 0, 0, 0);
+    for (int i = 0; i < MICRO_TIMER_COUNT; i++) {
+        initTimer(&g_astTimers[i], timerNop, (void *)(size_t)i);
+    }
+}
+
+static void teardownTimer(void)
+{
+    destroyTimerWheel(&g_stWheel);
+}
+
+static unsigned long long runTimerArmCancel(long lIters)
+{
+    for (long i = 0; i < lIters; i++) {
+        TcpTimer *pstTimer = &g_astTimers[i & (MICRO_TIMER_COUNT - 1)];
+        armTimer(&g_stWheel, pstTimer, (unsigned long long)(i & 4095) * TCP_TIMER_DEFAULT_TICK_NSEC);
+        cancelTimer(&g_stWheel, pstTimer);
+    }
+    return g_stWheel.uiArmed;
+}
+
+/**
+ * @brief 휠 전체에 타이머가 흩어져 있는 상태에서 한 틱씩 진행하며 만료된 타이머를 다시 설정합니다.
+ */
+static void setupTimerAdvance(void)
+{
+    setupTimer();
+    for (int i = 0; i < MICRO_TIMER_COUNT; i++) {
+        armTimer(&g_stWheel, &g_astTimers[i], (unsigned long long)(i + 1) * TCP_TIMER_DEFAULT_TICK_NSEC * 3);
+    }
+}
+
+static void rearmTimer(TcpTimer *pstTimer, void *pvArg)
+{
+    (void)pvArg;
+    armTimer(&g_stWheel, pstTimer,
+             g_stWheel.ullStartNsec + (g_stWheel.ullCurrentTick + MICRO_TIMER_COUNT) * g_stWheel.ullTickNsec);
+}
+
+static unsigned long long runTimerAdvance(long lIters)
+{
+    unsigned long long ullSum = 0;
+
+    for (int i = 0; i < MICRO_TIMER_COUNT; i++) {
+        g_astTimers[i].pfnCallback = rearmTimer;
+    }
+    unsigned long long ullNow = g_stWheel.ullStartNsec + g_stWheel.ullCurrentTick * g_stWheel.ullTickNsec;
+    for (long i = 0; i < lIters; i++) {
+        ullNow += g_stWheel.ullTickNsec;
+        ullSum += (unsigned long long)advanceTimerWheel(&g_stWheel, ullNow);
+    }
+    return ullSum;
+}
+
+static void setupConn(void)
+{
+    for (int i = 0; i < MICRO_CONN_COUNT; i++) {
+        registerConnInfo(MICRO_CONN_FD_BASE + i);
+    }
+}
+
+static void teardownConn(void)
+{
+    for (int i = 0; i < MICRO_CONN_COUNT; i++) {
+        removeConnInfo(MICRO_CONN_FD_BASE + i);
+    }
+}
+
+static unsigned long long runConnRegisterRemove(long lIters)
+{
+    unsigned long long ullSum = 0;
+
+    for (long i = 0; i < lIters; i++) {
+        int iSock = MICRO_CONN_FD_BASE + MICRO_CONN_COUNT + (int)(i & (MICRO_CONN_COUNT - 1));
+        ullSum += (unsigned long long)registerConnInfo(iSock)->uiRecvSize;
+        removeConnInfo(iSock);
+    }
+    return ullSum;
+}
+
+static unsigned long long runConnLookup(long lIters)
+{
+    unsigned long long ullSum = 0;
+
+    for (long i = 0; i < lIters; i++) {
+        // 캐시 지역성이 없도록 곱셈 해시로 순서를 섞음
+        int iSock = MICRO_CONN_FD_BASE + (int)(((unsigned long)i * 2654435761UL) & (MICRO_CONN_COUNT - 1));
+        TcpConnInfo *pstConn = findConnInfo(iSock);
+        ullSum += (pstConn != NULL) ? (unsigned long long)pstConn->iSock : 0;
+    }
+    return ullSum;
+}
+
+static unsigned long long runHistogramRecord(long lIters)
+{
+    for (long i = 0; i < lIters; i++) {
+        recordHistogram(&g_stHistogram, ((unsigned long long)i * 2654435761ULL) & 0xfffff);
+    }
+    return g_stHistogram.ullCount;
+}
+
+static unsigned long long runCounterAdd(long lIters)
+{
+    for (long i = 0; i < lIters; i++) {
+        addMetricCounter(TCP_COUNTER_SEND_CALLS, 1);
+    }
+    return getMetricCounter(TCP_COUNTER_SEND_CALLS);
+}
+
+static unsigned long long runHttpParse(long lIters)
+{
+    static const char s_kachRequest[] =
+        "GET /api/v1/metrics?format=json HTTP/1.1\r\n"
+        "Host: backend.internal:8080\r\n"
+        "User-Agent: health-checker/2.1 (linux; x86_64)\r\n"
+        "Accept: application/json, text/plain;q=0.9\r\n"
+        "Accept-Encoding: gzip, deflate\r\n"
+        "Connection: keep-alive\r\n"
+        "X-Request-Id: 4f9c2d1e-7a3b-4c8e-9f01-2b3c4d5e6f70\r\n"
+        "\r\n";
+    TcpHttpRequest stRequest;
+    unsigned long long ullSum = 0;
+
+    for (long i = 0; i < lIters; i++) {
+        ullSum += (unsigned long long)parseHttpRequest(s_kachRequest, sizeof(s_kachRequest) - 1, &stRequest);
+        ullSum += (unsigned long long)stRequest.iHeaders;
+    }
+    return ullSum;
+}
+
+static unsigned long long runRespParse(long lIters)
+{
+    // HGETALL 같은 작은 배열 응답 하나
+    static const char s_kachReply[] =
+        "*6\r\n$4\r\nname\r\n$7\r\nbackend\r\n$4\r\nport\r\n:8080\r\n"
+        "$6\r\nstatus\r\n+healthy\r\n";
+    TcpRespValue astValues[8];
+    unsigned long long ullSum = 0;
+    int iValues;
+
+    for (long i = 0; i < lIters; i++) {
+        ullSum += (unsigned long long)parseRespValue(s_kachReply, sizeof(s_kachReply) - 1, astValues, 8, &iValues);
+        ullSum += (unsigned long long)iValues;
+    }
+    return ullSum;
+}
+
+static unsigned long long runWsUnmask(long lIters)
+{
+    static const unsigned char s_aucMask[4] = { 0x37, 0xfa, 0x21, 0x3d };
+
+    // 연산 하나는 4KB 페이로드 한 번의 마스크 해제
+    for (long i = 0; i < lIters; i++) {
+        maskWsPayload(g_aucWsPayload, sizeof(g_aucWsPayload), s_aucMask, 0);
+    }
+    return g_aucWsPayload[(size_t)lIters % MICRO_WS_PAYLOAD];
+}
+
+static const MicroBench g_astBenches[] = {
+    { "frame_encode",         setupFrame,        runFrameEncode,        NULL },
+    { "frame_parse",          setupFrame,        runFrameParse,         NULL },
+    { "frame_parse_trace",    setupFrame,        runFrameParseTrace,    NULL },
+    { "timer_arm_cancel",     setupTimer,        runTimerArmCancel,     teardownTimer },
+    { "timer_advance",        setupTimerAdvance, runTimerAdvance,       teardownTimer },
+    { "conn_register_remove", setupConn,         runConnRegisterRemove, teardownConn },
+    { "conn_lookup",          setupConn,         runConnLookup,         teardownConn },
+    { "histogram_record",     NULL,              runHistogramRecord,    NULL },
+    { "counter_add",          NULL,              runCounterAdd,         NULL },
+    { "http_parse",           NULL,              runHttpParse,          NULL },
+    { "resp_parse",           NULL,              runRespParse,          NULL },
+    { "ws_unmask_4k",         NULL,              runWsUnmask,           NULL },
+};
+
+
+static int compareDouble(const void *kpvA, const void *kpvB)
+{
+    double dA = *(const double *)kpvA;
+    double dB = *(const double *)kpvB;
+    return (dA > dB) - (dA < dB);
+}
+
+static void runMicroBench(const MicroBench *kpstBench, int iReps, int iWarmup, long lIters, MicroResult *pstResult)
+{
+    double adNsec[MICRO_MAX_REPS];
+    double adCycles[MICRO_MAX_REPS];
+
+    if (kpstBench->pfnSetup != NULL) {
+        kpstBench->pfnSetup();
+    }
+    for (int i = 0; i < iWarmup; i++) {
+        g_ullSink += kpstBench->pfnRun(lIters);
+    }
+    for (int i = 0; i < iReps; i++) {
+        unsigned long long ullCycles = getCycleCount();
+        unsigned long long ullStart = getMonotonicNsec();
+        g_ullSink += kpstBench->pfnRun(lIters);
+        adNsec[i] = (double)(getMonotonicNsec() - ullStart) / (double)lIters;
+        adCycles[i] = (double)(getCycleCount() - ullCycles) / (double)lIters;
+    }
+    if (kpstBench->pfnTeardown != NULL) {
+        kpstBench->pfnTeardown();
+    }
+
+    double dSum = 0.0;
+    for (int i = 0; i < iReps; i++) {
+        dSum += adNsec[i];
+    }
+    pstResult->dMean = dSum / iReps;
+
+    double dVar = 0.0;
+    for (int i = 0; i < iReps; i++) {
+        dVar += (adNsec[i] - pstResult->dMean) * (adNsec[i] - pstResult->dMean);
+    }
+    pstResult->dStddev = (iReps > 1) ? sqrt(dVar / (iReps - 1)) : 0.0;
+
+    qsort(adNsec, (size_t)iReps, sizeof(double), compareDouble);
+    qsort(adCycles, (size_t)iReps, sizeof(double), compareDouble);
+    pstResult->dMedian = adNsec[iReps / 2];
+    pstResult->dMin = adNsec[0];
+    pstResult->dMax = adNsec[iReps - 1];
+    pstResult->dCycles = adCycles[iReps / 2];
+}
+
+
+int main(int argc, char *argv[])
+{
+    int iReps = MICRO_DEFAULT_REPS;
+    int iWarmup = MICRO_DEFAULT_WARMUP;
+    long lIters = MICRO_DEFAULT_ITERS;
+    const char *kpchFilter = NULL;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "r:w:n:f:")) != -1) {
+        switch (iOpt) {
+        case 'r':
+            iReps = atoi(optarg);
+            break;
+        case 'w':
+            iWarmup = atoi(optarg);
+            break;
+        case 'n':
+            lIters = atol(optarg);
+            break;
+        case 'f':
+            kpchFilter = optarg;
+            break;
+        default:
+            iReps = 0;
+            break;
+        }
+    }
+    if (iReps <= 0 || iReps > MICRO_MAX_REPS || iWarmup < 0 || lIters <= 0) {
+        fprintf(stderr, "usage: %s [-r reps (1-%d)] [-w warmup reps] [-n iterations per rep] [-f name filter]\n",
+                argv[0], MICRO_MAX_REPS);
+        return EXIT_FAILURE;
+    }
+
+    printf("# %d reps (+%d warmup) x %ld ops, cycle counter %.2f GHz\n", iReps, iWarmup, lIters,
+           (double)getCycleFrequency() / 1e9);
+    printf("%-22s %10s %10s %10s %10s %10s %8s %12s\n", "benchmark", "median_ns", "mean_ns", "stddev",
+           "min_ns", "max_ns", "cv_%", "cycles/op");
+
+    for (size_t i = 0; i < sizeof(g_astBenches) / sizeof(g_astBenches[0]); i++) {
+        const MicroBench *kpstBench = &g_astBenches[i];
+        if (kpchFilter != NULL && strstr(kpstBench->kpchName, kpchFilter) == NULL) {
+            continue;
+        }
+
+        MicroResult stResult;
+        runMicroBench(kpstBench, iReps, iWarmup, lIters, &stResult);
+        printf("%-22s %10.2f %10.2f %10.2f %10.2f %10.2f %8.1f %12.1f\n", kpstBench->kpchName,
+               stResult.dMedian, stResult.dMean, stResult.dStddev, stResult.dMin, stResult.dMax,
+               (stResult.dMean > 0.0) ? stResult.dStddev * 100.0 / stResult.dMean : 0.0, stResult.dCycles);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/**
+ * @file tcp-resp-bench.c
+ * @brief RESP 파이프라인 클라이언트 처리량 벤치마크
+ *
+ * 같은 프로세스의 스레드로 RESP 대역 서버(GET/SET/PING만 처리하는 최소 서버)를 루프백에 띄우고,
+ * 파이프라인 클라이언트(tcp-resp)로 GET/SET을 번갈아 보내며 파이프라인 깊이별로 다음을 보고합니다.
+ * - 초당 명령 수와 깊이 1 대비 배율
+ * - 묶음(깊이만큼의 명령) 왕복 지연 중앙값/99백분위
+ * - 명령당 송수신 시스템 콜 수 (클라이언트와 대역 서버 합계)
+ *
+ * 대역 서버는 수신 묶음마다 응답을 한 번에 보내므로, 측정값은 실제 서버의 명령 처리 비용이
+ * 아니라 코덱, 묶어 보내기, 왕복 횟수의 효과를 보여 줍니다.
+ *
+ * 사용법: tcp-resp-bench [-n 깊이별 명령 수] [-s 값 크기] [-p 포트]
+ */
+#include "tcp-sock.h"
+#include "tcp-resp.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+
+#include <unistd.h>
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RESP_BENCH_DEFAULT_OPS      200000L
+#define RESP_BENCH_DEFAULT_SIZE     32
+#define RESP_BENCH_DEFAULT_PORT     12395
+#define RESP_BENCH_MAX_SIZE         TCP_RESP_INLINE_MAX
+#define RESP_BENCH_BUFFER           (256 * 1024)
+#define RESP_BENCH_VALUES           16
+
+static const int g_aiDepths[] = { 1, 4, 16, 64, 256, 1024 };
+
+typedef struct {
+    int iServerSock;
+    size_t uiValueSize;
+} RespBenchServer;
+
+static char g_achValue[RESP_BENCH_MAX_SIZE];
+
+
+/**
+ * @brief 대역 서버 연결 하나를 처리합니다.
+ *
+ * 수신한 명령을 모두 해석한 뒤 응답을 송신 버퍼에 모아 sendMessage() 한 번으로 보냅니다.
+ */
+static void serveRespConn(int iSock, size_t uiValueSize)
+{
+    static char s_achIn[RESP_BENCH_BUFFER];
+    static char s_achOut[RESP_BENCH_BUFFER];
+    TcpRespValue astValues[RESP_BENCH_VALUES];
+    size_t uiStart = 0;
+    size_t uiEnd = 0;
+
+    for (;;) {
+        int iReceived = recvMsgBlocking(iSock, s_achIn + uiEnd, sizeof(s_achIn) - uiEnd);
+        if (iReceived <= 0) {
+            return;
+        }
+        uiEnd += (size_t)iReceived;
+
+        size_t uiOut = 0;
+        int iValues;
+        int iLength;
+        while ((iLength = parseRespValue(s_achIn + uiStart, uiEnd - uiStart, astValues, RESP_BENCH_VALUES,
+                                         &iValues)) > 0) {
+            uiStart += (size_t)iLength;
+            if (sizeof(s_achOut) - uiOut < uiValueSize + 64) {
+                if (sendMessage(iSock, s_achOut, uiOut) < 0) {
+                    return;
+                }
+                uiOut = 0;
+            }
+            const TcpRespValue *kpstName = &astValues[1];
+            if (kpstName->uiLength == 3 && memcmp(kpstName->kpchData, "GET", 3) == 0) {
+                uiOut += (size_t)encodeRespHeader(s_achOut + uiOut, TCP_RESP_BULK, (long long)uiValueSize);
+                memcpy(s_achOut + uiOut, g_achValue, uiValueSize);
+                uiOut += uiValueSize;
+                memcpy(s_achOut + uiOut, "\r\n", 2);
+                uiOut += 2;
+            } else if (kpstName->uiLength == 3 && memcmp(kpstName->kpchData, "SET", 3) == 0) {
+                memcpy(s_achOut + uiOut, "+OK\r\n", 5);
+                uiOut += 5;
+            } else {
+                memcpy(s_achOut + uiOut, "+PONG\r\n", 7);
+                uiOut += 7;
+            }
+        }
+        if (iLength < 0) {
+            fprintf(stderr, "serveRespConn: malformed command\n");
+            return;
+        }
+        memmove(s_achIn, s_achIn + uiStart, uiEnd - uiStart);
+        uiEnd -= uiStart;
+        uiStart = 0;
+        if (uiOut > 0 && sendMessage(iSock, s_achOut, uiOut) < 0) {
+            return;
+        }
+    }
+}
+
+static void *runRespServer(void *pvArg)
+{
+    RespBenchServer *pstServer = (RespBenchServer *)pvArg;
+    int iSock = acceptClientSocket(pstServer->iServerSock);
+
+    if (iSock >= 0) {
+        serveRespConn(iSock, pstServer->uiValueSize);
+        removeConnInfo(iSock);
+        close(iSock);
+    }
+    return NULL;
+}
+
+static void countReply(void *pvArg, const TcpRespValue *kpstReply, int iValues)
+{
+    (void)kpstReply;
+    (void)iValues;
+    (*(long *)pvArg)++;
+}
+
+/**
+ * @brief 깊이만큼 명령을 넣고 모든 응답을 받는 묶음을 반복합니다.
+ *
+ * @return 성공 시 0, 실패 시 -1
+ */
+static int runDepth(TcpRespClient *pstClient, int iDepth, long lOps, size_t uiValueSize, TcpHistogram *pstHistogram)
+{
+    static const char *s_kapchGet[] = { "GET", "bench:key" };
+    static const size_t s_kauiGet[] = { 3, 9 };
+    const char *apchSet[] = { "SET", "bench:key", g_achValue };
+    const size_t auiSet[] = { 3, 9, uiValueSize };
+    long lReplies = 0;
+
+    resetHistogram(pstHistogram);
+    for (long lDone = 0; lDone < lOps; lDone += iDepth) {
+        unsigned long long ullStart = getMonotonicNsec();
+        for (int i = 0; i < iDepth; i++) {
+            long long llCommand = ((lDone + i) & 1)
+                                  ? queueRespCommand(pstClient, 3, apchSet, auiSet, countReply, &lReplies)
+                                  : queueRespCommand(pstClient, 2, s_kapchGet, s_kauiGet, countReply, &lReplies);
+            if (llCommand < 0) {
+                return -1;
+            }
+        }
+        if (pumpRespClient(pstClient, iDepth) != iDepth) {
+            fprintf(stderr, "runDepth: missing replies at depth %d\n", iDepth);
+            return -1;
+        }
+        recordHistogram(pstHistogram, getMonotonicNsec() - ullStart);
+    }
+    return (lReplies == lOps) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    static TcpRespClient s_stClient;
+    static char s_achBuffer[RESP_BENCH_BUFFER];
+    static TcpRespValue s_astValues[RESP_BENCH_VALUES];
+    static TcpHistogram s_stBatch;
+    long lOps = RESP_BENCH_DEFAULT_OPS;
+    long lValueSize = RESP_BENCH_DEFAULT_SIZE;
+    int iPort = RESP_BENCH_DEFAULT_PORT;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "n:s:p:")) != -1) {
+        switch (iOpt) {
+        case 'n':
+            lOps = atol(optarg);
+            break;
+        case 's':
+            lValueSize = atol(optarg);
+            break;
+        case 'p':
+            iPort = atoi(optarg);
+            break;
+        default:
+            lOps = 0;
+            break;
+        }
+    }
+    if (lOps <= 0 || lValueSize < 0 || lValueSize > RESP_BENCH_MAX_SIZE) {
+        fprintf(stderr, "usage: %s [-n commands per depth] [-s value size (0-%d)] [-p port]\n", argv[0],
+                RESP_BENCH_MAX_SIZE);
+        return EXIT_FAILURE;
+    }
+    memset(g_achValue, 'v', sizeof(g_achValue));
+
+    if (isPortAvailable(iPort) != 0) {
+        fprintf(stderr, "port %d is in use\n", iPort);
+        return EXIT_FAILURE;
+    }
+    RespBenchServer stServer;
+    stServer.iServerSock = createServerSocket(iPort, 1);
+    stServer.uiValueSize = (size_t)lValueSize;
+    if (stServer.iServerSock < 0) {
+        return EXIT_FAILURE;
+    }
+    pthread_t tServer;
+    if (pthread_create(&tServer, NULL, runRespServer, &stServer) != 0) {
+        perror("pthread_create");
+        return EXIT_FAILURE;
+    }
+    int iSock = createClientSocket("127.0.0.1", iPort);
+    if (iSock < 0) {
+        return EXIT_FAILURE;
+    }
+    initRespClient(&s_stClient, iSock, s_achBuffer, sizeof(s_achBuffer), s_astValues, RESP_BENCH_VALUES);
+
+    printf("# %ld GET/SET commands per depth, %ld-byte values, in-process stand-in server on 127.0.0.1:%d\n",
+           lOps, lValueSize, iPort);
+    printf("# syscalls/op counts send and recv calls on both ends\n");
+    printf("%6s %12s %8s %12s %12s %12s\n", "depth", "ops/s", "speedup", "batch_p50_us", "batch_p99_us",
+           "syscalls/op");
+
+    double dBase = 0.0;
+    int iStatus = EXIT_SUCCESS;
+    for (size_t i = 0; i < sizeof(g_aiDepths) / sizeof(g_aiDepths[0]); i++) {
+        int iDepth = g_aiDepths[i];
+        long lRun = (lOps + iDepth - 1) / iDepth * iDepth;
+        unsigned long long ullCalls = getMetricCounter(TCP_COUNTER_SEND_CALLS) + getMetricCounter(TCP_COUNTER_RECV_CALLS);
+        unsigned long long ullStart = getMonotonicNsec();
+
+        if (runDepth(&s_stClient, iDepth, lRun, (size_t)lValueSize, &s_stBatch) < 0) {
+            iStatus = EXIT_FAILURE;
+            break;
+        }
+        unsigned long long ullElapsed = getMonotonicNsec() - ullStart;
+        ullCalls = getMetricCounter(TCP_COUNTER_SEND_CALLS) + getMetricCounter(TCP_COUNTER_RECV_CALLS) - ullCalls;
+
+        double dRate = (double)lRun * 1e9 / (double)(ullElapsed ? ullElapsed : 1);
+        if (dBase == 0.0) {
+            dBase = dRate;
+        }
+        printf("%6d %12.0f %7.1fx %12.1f %12.1f %12.3f\n", iDepth, dRate, dRate / dBase,
+               (double)getHistogramPercentile(&s_stBatch, 50.0) / 1000.0,
+               (double)getHistogramPercentile(&s_stBatch, 99.0) / 1000.0, (double)ullCalls / (double)lRun);
+    }
+
+    removeConnInfo(iSock);
+    close(iSock);
+    pthread_join(tServer, NULL);
+    close(stServer.iServerSock);
+    return iStatus;
+}
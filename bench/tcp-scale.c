@@ -0,0 +1,475 @@
+/**
+ * @file tcp-scale.c
+ * @brief 연결 수 규모별 자원 사용량 및 지연 벤치마크
+ *
+ * RLIMIT_NOFILE을 올린 뒤 라이브러리(createClientSocketFrom(), acceptClientSocket())로
+ * 루프백 연결을 단계별로 늘려 가며, 단계마다 다음을 보고합니다.
+ * - 유휴 연결당 프로세스 RSS 증가량 (/proc/self/statm)
+ * - 유휴 연결당 커널 소켓 버퍼 메모리 (/proc/net/sockstat의 TCP mem)와
+ *   소켓 객체 슬랩 메모리 (/proc/slabinfo의 TCP, sock_inode_cache, 읽을 수 있을 때만)
+ * - 연결 수립(connect + accept) 속도
+ * - 모든 서버 측 소켓을 등록한 epoll 루프에서 한 연결에 데이터가 왔을 때의
+ *   반복 지연 (epoll_wait() + recvMsgTimeout())
+ * - 클라이언트가 연결을 닫은 뒤 서버 측 루프가 TCP_DISCONNECTION을 받기까지의 지연
+ *
+ * 클라이언트와 서버가 한 프로세스에 있으므로 연결당 값은 양쪽 소켓 두 개를 합한 값입니다.
+ * 출발지 주소 하나당 임시 포트가 수만 개로 제한되므로 127.0.0.x 주소 여러 개에 나누어 연결합니다.
+ * 파일 디스크립터 한도를 올릴 수 없으면 가능한 연결 수로 줄여서 측정합니다.
+ *
+ * 사용법: tcp-scale [-n 연결 수] [-s 단계 크기] [-a 출발지 주소 수] [-p 포트] [-k 표본 수]
+ */
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SCALE_DEFAULT_CONNS     100000L
+#define SCALE_DEFAULT_STEP      10000L
+#define SCALE_DEFAULT_PORT      12390
+#define SCALE_DEFAULT_SAMPLES   1000
+#define SCALE_DISC_SAMPLES      100
+#define SCALE_MAX_SOURCES       254
+#define SCALE_CONNS_PER_SOURCE  20000L      /**< 출발지 주소 하나에 맡기는 연결 수 (임시 포트 범위보다 작게) */
+#define SCALE_BATCH             512         /**< accept 대기 큐가 넘치지 않도록 나누어 연결하는 단위 */
+#define SCALE_BACKLOG           4096
+#define SCALE_FD_RESERVE        256
+#define SCALE_EPOLL_EVENTS      64
+
+typedef struct {
+    int iServerSock;
+    int iEpoll;
+    int iSources;
+    int iPort;
+    long lNextSource;
+    char aachSource[SCALE_MAX_SOURCES][16];
+} ScaleContext;
+
+typedef struct {
+    long lRssPages;
+    long lSockMemPages;
+    long long llSlabBytes;      /**< 읽을 수 없으면 -1 */
+} ScaleMemory;
+
+
+static int raiseFdLimit(rlim_t ullNeeded, rlim_t *pullLimit)
+{
+    struct rlimit stLimit;
+
+    if (getrlimit(RLIMIT_NOFILE, &stLimit) < 0) {
+        perror("getrlimit");
+        return -1;
+    }
+    if (stLimit.rlim_cur >= ullNeeded) {
+        *pullLimit = stLimit.rlim_cur;
+        return 0;
+    }
+
+    // 하드 한도도 부족하면 올려 보고 (CAP_SYS_RESOURCE 필요), 실패하면 하드 한도까지만 올림
+    if (stLimit.rlim_max < ullNeeded) {
+        struct rlimit stRaised;
+        stRaised.rlim_cur = ullNeeded;
+        stRaised.rlim_max = ullNeeded;
+        if (setrlimit(RLIMIT_NOFILE, &stRaised) == 0) {
+            *pullLimit = ullNeeded;
+            return 0;
+        }
+    }
+    stLimit.rlim_cur = stLimit.rlim_max < ullNeeded ? stLimit.rlim_max : ullNeeded;
+    if (setrlimit(RLIMIT_NOFILE, &stLimit) < 0) {
+        perror("setrlimit");
+        return -1;
+    }
+    *pullLimit = stLimit.rlim_cur;
+    return 0;
+}
+
+static void readMemory(ScaleMemory *pstMemory)
+{
+    FILE *pFile;
+    char achLine[512];
+
+    pstMemory->lRssPages = 0;
+    pstMemory->lSockMemPages = 0;
+    pstMemory->llSlabBytes = -1;
+
+    if ((pFile = fopen("/proc/self/statm", "r")) != NULL) {
+        long lSize;
+        if (fscanf(pFile, "%ld %ld", &lSize, &pstMemory->lRssPages) != 2) {
+            pstMemory->lRssPages = 0;
+        }
+        fclose(pFile);
+    }
+
+    if ((pFile = fopen("/proc/net/sockstat", "r")) != NULL) {
+        while (fgets(achLine, sizeof(achLine), pFile) != NULL) {
+            const char *kpchMem;
+            if (strncmp(achLine, "TCP:", 4) == 0 && (kpchMem = strstr(achLine, " mem ")) != NULL) {
+                pstMemory->lSockMemPages = atol(kpchMem + 5);
+            }
+        }
+        fclose(pFile);
+    }
+
+    if ((pFile = fopen("/proc/slabinfo", "r")) != NULL) {
+        long long llBytes = 0;
+        while (fgets(achLine, sizeof(achLine), pFile) != NULL) {
+            char achName[64];
+            long lActive;
+            long lTotal;
+            long lSize;
+            if (sscanf(achLine, "%63s %ld %ld %ld", achName, &lActive, &lTotal, &lSize) == 4
+                && (strcmp(achName, "TCP") == 0 || strcmp(achName, "sock_inode_cache") == 0)) {
+                llBytes += (long long)lActive * lSize;
+            }
+        }
+        fclose(pFile);
+        pstMemory->llSlabBytes = llBytes;
+    }
+}
+
+static void closeConnection(int iSock)
+{
+    removeConnInfo(iSock);
+    close(iSock);
+}
+
+static int connectOne(ScaleContext *pstCtx, int *piClient)
+{
+    const char *kpchSource = pstCtx->aachSource[pstCtx->lNextSource++ % pstCtx->iSources];
+
+    *piClient = createClientSocketFrom(kpchSource, "127.0.0.1", pstCtx->iPort);
+    return *piClient < 0 ? -1 : 0;
+}
+
+static int acceptOne(ScaleContext *pstCtx, int *piServer)
+{
+    struct epoll_event stEvent;
+
+    *piServer = acceptClientSocket(pstCtx->iServerSock);
+    if (*piServer < 0) {
+        return -1;
+    }
+
+    memset(&stEvent, 0, sizeof(stEvent));
+    stEvent.events = EPOLLIN | EPOLLRDHUP;
+    stEvent.data.fd = *piServer;
+    if (epoll_ctl(pstCtx->iEpoll, EPOLL_CTL_ADD, *piServer, &stEvent) < 0) {
+        perror("epoll_ctl");
+        closeConnection(*piServer);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 연결을 lCount개 추가합니다 (서버 측 소켓은 epoll에 등록).
+ *
+ * @details connect를 모두 마친 뒤 accept하면 accept 대기 큐가 넘쳐 SYN 재전송(1초)이
+ *          섞이므로, SCALE_BATCH개씩 connect와 accept를 번갈아 합니다.
+ *
+ * @return 실제로 추가한 연결 수
+ */
+static long openConnections(ScaleContext *pstCtx, int *piClients, int *piServers, long lCount)
+{
+    long lOpened = 0;
+
+    while (lOpened < lCount) {
+        long lBatch = lCount - lOpened < SCALE_BATCH ? lCount - lOpened : SCALE_BATCH;
+        long lConnected = 0;
+
+        while (lConnected < lBatch && connectOne(pstCtx, &piClients[lOpened + lConnected]) == 0) {
+            lConnected++;
+        }
+        for (long i = 0; i < lConnected; i++) {
+            if (acceptOne(pstCtx, &piServers[lOpened + i]) < 0) {
+                // 상대 소켓을 받지 못한 클라이언트는 돌려줄 수 없으므로 닫음
+                for (long j = i; j < lConnected; j++) {
+                    closeConnection(piClients[lOpened + j]);
+                }
+                return lOpened + i;
+            }
+        }
+        lOpened += lConnected;
+        if (lConnected < lBatch) {
+            break;
+        }
+    }
+    return lOpened;
+}
+
+/**
+ * @brief 임의의 연결 하나에 1바이트를 보내고, 이벤트 루프 한 번(epoll_wait + 수신)의 지연을 잽니다.
+ */
+static int measureLoop(ScaleContext *pstCtx, const int *kpiClients, long lConns, int iSamples,
+                       TcpHistogram *pstHistogram)
+{
+    struct epoll_event astEvents[SCALE_EPOLL_EVENTS];
+    char achBuffer[64];
+
+    resetHistogram(pstHistogram);
+    for (int i = 0; i < iSamples; i++) {
+        long lIndex = random() % lConns;
+        int iHandled = 0;
+
+        if (sendMessage(kpiClients[lIndex], "x", 1) != 1) {
+            return -1;
+        }
+
+        unsigned long long ullStart = getMonotonicNsec();
+        while (iHandled == 0) {
+            int iReady = epoll_wait(pstCtx->iEpoll, astEvents, SCALE_EPOLL_EVENTS, 1000);
+            if (iReady < 0 && errno != EINTR) {
+                perror("epoll_wait");
+                return -1;
+            }
+            if (iReady == 0) {
+                fprintf(stderr, "no event within 1 s for connection %ld\n", lIndex);
+                return -1;
+            }
+            for (int j = 0; j < iReady; j++) {
+                if (recvMsgTimeout(astEvents[j].data.fd, achBuffer, sizeof(achBuffer), 0) > 0) {
+                    iHandled++;
+                }
+            }
+        }
+        recordHistogram(pstHistogram, getMonotonicNsec() - ullStart);
+    }
+    return 0;
+}
+
+/**
+ * @brief 새 연결을 만들어 클라이언트 쪽을 닫고, 서버 쪽 루프가 종료를 감지하기까지의 지연을 잽니다.
+ */
+/**
+ * @brief 종료 지연 측정을 중간에 그만둘 때 남은 표본 연결을 닫습니다.
+ *
+ * @details iFirst번 클라이언트는 측정하며 이미 닫았으므로 서버 쪽만 닫습니다.
+ *          서버 쪽 소켓은 close()로 epoll 등록도 함께 사라집니다.
+ */
+static void closeSamples(const int *kpiClients, const int *kpiServers, int iFirst, int iSamples)
+{
+    closeConnection(kpiServers[iFirst]);
+    for (int i = iFirst + 1; i < iSamples; i++) {
+        closeConnection(kpiClients[i]);
+        closeConnection(kpiServers[i]);
+    }
+}
+
+static int measureDisconnect(ScaleContext *pstCtx, int iSamples, TcpHistogram *pstHistogram)
+{
+    int aiClients[SCALE_DISC_SAMPLES];
+    int aiServers[SCALE_DISC_SAMPLES];
+    struct epoll_event astEvents[SCALE_EPOLL_EVENTS];
+    char achBuffer[64];
+
+    resetHistogram(pstHistogram);
+    iSamples = (int)openConnections(pstCtx, aiClients, aiServers, iSamples);
+
+    for (int i = 0; i < iSamples; i++) {
+        int iDetected = 0;
+
+        unsigned long long ullStart = getMonotonicNsec();
+        closeConnection(aiClients[i]);
+        while (!iDetected) {
+            int iReady = epoll_wait(pstCtx->iEpoll, astEvents, SCALE_EPOLL_EVENTS, 1000);
+            if (iReady < 0 && errno != EINTR) {
+                perror("epoll_wait");
+                closeSamples(aiClients, aiServers, i, iSamples);
+                return -1;
+            }
+            if (iReady == 0) {
+                fprintf(stderr, "disconnect of socket %d not detected within 1 s\n", aiServers[i]);
+                closeSamples(aiClients, aiServers, i, iSamples);
+                return -1;
+            }
+            for (int j = 0; j < iReady; j++) {
+                if (astEvents[j].data.fd == aiServers[i]
+                    && recvMsgTimeout(aiServers[i], achBuffer, sizeof(achBuffer), 0) == TCP_DISCONNECTION) {
+                    iDetected = 1;
+                }
+            }
+        }
+        recordHistogram(pstHistogram, getMonotonicNsec() - ullStart);
+        closeConnection(aiServers[i]);
+    }
+    return iSamples;
+}
+
+static void printPerConn(long long llBytes, long lConns)
+{
+    printf(" %11.0f", (double)llBytes / (double)lConns);
+}
+
+
+int main(int argc, char *argv[])
+{
+    long lConns = SCALE_DEFAULT_CONNS;
+    long lStep = SCALE_DEFAULT_STEP;
+    int iSources = 0;
+    int iSamples = SCALE_DEFAULT_SAMPLES;
+    int iOpt;
+    ScaleContext stCtx;
+    static TcpHistogram s_stLoop;
+    static TcpHistogram s_stDisconnect;
+
+    memset(&stCtx, 0, sizeof(stCtx));
+    stCtx.iPort = SCALE_DEFAULT_PORT;
+
+    while ((iOpt = getopt(argc, argv, "n:s:a:p:k:")) != -1) {
+        switch (iOpt) {
+        case 'n':
+            lConns = atol(optarg);
+            break;
+        case 's':
+            lStep = atol(optarg);
+            break;
+        case 'a':
+            iSources = atoi(optarg);
+            break;
+        case 'p':
+            stCtx.iPort = atoi(optarg);
+            break;
+        case 'k':
+            iSamples = atoi(optarg);
+            break;
+        default:
+            lConns = 0;
+            break;
+        }
+    }
+    if (lConns <= 0 || lStep <= 0 || iSamples <= 0 || iSources < 0 || iSources > SCALE_MAX_SOURCES) {
+        fprintf(stderr, "usage: %s [-n connections] [-s step] [-a source addresses (1-%d)] [-p port] [-k samples]\n",
+                argv[0], SCALE_MAX_SOURCES);
+        return EXIT_FAILURE;
+    }
+
+    rlim_t ullLimit;
+    rlim_t ullNeeded = (rlim_t)(lConns + SCALE_DISC_SAMPLES) * 2 + SCALE_FD_RESERVE;
+    if (raiseFdLimit(ullNeeded, &ullLimit) < 0) {
+        return EXIT_FAILURE;
+    }
+    if (ullLimit < ullNeeded) {
+        long lCapped = ((long)ullLimit - SCALE_FD_RESERVE) / 2 - SCALE_DISC_SAMPLES;
+        printf("# RLIMIT_NOFILE limited to %llu; measuring up to %ld connections instead of %ld\n",
+               (unsigned long long)ullLimit, lCapped, lConns);
+        lConns = lCapped;
+        if (lConns <= 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (iSources == 0) {
+        iSources = (int)((lConns + SCALE_DISC_SAMPLES) / SCALE_CONNS_PER_SOURCE) + 1;
+        if (iSources > SCALE_MAX_SOURCES) {
+            iSources = SCALE_MAX_SOURCES;
+        }
+    }
+    stCtx.iSources = iSources;
+    for (int i = 0; i < iSources; i++) {
+        snprintf(stCtx.aachSource[i], sizeof(stCtx.aachSource[i]), "127.0.0.%d", i + 1);
+    }
+
+    if (isPortAvailable(stCtx.iPort) != 0) {
+        fprintf(stderr, "port %d is in use\n", stCtx.iPort);
+        return EXIT_FAILURE;
+    }
+
+    int *piClients = (int *)malloc(sizeof(int) * lConns);
+    int *piServers = (int *)malloc(sizeof(int) * lConns);
+    if (piClients == NULL || piServers == NULL) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    stCtx.iServerSock = createServerSocket(stCtx.iPort, SCALE_BACKLOG);
+    if (stCtx.iServerSock < 0) {
+        fprintf(stderr, "cannot listen on port %d\n", stCtx.iPort);
+        return EXIT_FAILURE;
+    }
+    stCtx.iEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (stCtx.iEpoll < 0) {
+        perror("epoll_create1");
+        return EXIT_FAILURE;
+    }
+
+    ScaleMemory stBase;
+    readMemory(&stBase);
+
+    printf("# up to %ld loopback connections in steps of %ld from %d source addresses (127.0.0.1-%d)\n",
+           lConns, lStep, iSources, iSources);
+    printf("# per-connection values cover both ends (client + server socket) in this process\n");
+    if (stBase.llSlabBytes < 0) {
+        printf("# /proc/slabinfo unreadable; slab_B/conn reported as n/a\n");
+    }
+    printf("%9s %10s %11s %11s %11s %12s %12s %12s %12s\n", "conns", "accept/s", "rss_B/conn", "kmem_B/conn",
+           "slab_B/conn", "loop_p50_us", "loop_p99_us", "disc_p50_us", "disc_p99_us");
+
+    long lOpen = 0;
+    int iResult = EXIT_SUCCESS;
+    while (lOpen < lConns) {
+        long lWant = lConns - lOpen < lStep ? lConns - lOpen : lStep;
+
+        unsigned long long ullStart = getMonotonicNsec();
+        long lOpened = openConnections(&stCtx, piClients + lOpen, piServers + lOpen, lWant);
+        unsigned long long ullElapsed = getMonotonicNsec() - ullStart;
+        lOpen += lOpened;
+        if (lOpened < lWant) {
+            fprintf(stderr, "stopped at %ld connections\n", lOpen);
+            iResult = EXIT_FAILURE;
+            if (lOpened == 0) {
+                break;
+            }
+        }
+
+        ScaleMemory stNow;
+        readMemory(&stNow);
+        long lPage = sysconf(_SC_PAGESIZE);
+
+        printf("%9ld %10.0f", lOpen, (double)lOpened * 1e9 / (double)(ullElapsed ? ullElapsed : 1));
+        printPerConn((long long)(stNow.lRssPages - stBase.lRssPages) * lPage, lOpen);
+        printPerConn((long long)(stNow.lSockMemPages - stBase.lSockMemPages) * lPage, lOpen);
+        if (stNow.llSlabBytes >= 0 && stBase.llSlabBytes >= 0) {
+            printPerConn(stNow.llSlabBytes - stBase.llSlabBytes, lOpen);
+        } else {
+            printf(" %11s", "n/a");
+        }
+
+        if (measureLoop(&stCtx, piClients, lOpen, iSamples, &s_stLoop) == 0) {
+            printf(" %12.1f %12.1f", (double)getHistogramPercentile(&s_stLoop, 50.0) / 1000.0,
+                   (double)getHistogramPercentile(&s_stLoop, 99.0) / 1000.0);
+        } else {
+            printf(" %12s %12s", "-", "-");
+            iResult = EXIT_FAILURE;
+        }
+        if (measureDisconnect(&stCtx, SCALE_DISC_SAMPLES, &s_stDisconnect) > 0) {
+            printf(" %12.1f %12.1f\n", (double)getHistogramPercentile(&s_stDisconnect, 50.0) / 1000.0,
+                   (double)getHistogramPercentile(&s_stDisconnect, 99.0) / 1000.0);
+        } else {
+            printf(" %12s %12s\n", "-", "-");
+            iResult = EXIT_FAILURE;
+        }
+        fflush(stdout);
+
+        if (lOpened < lWant) {
+            break;
+        }
+    }
+
+    for (long i = 0; i < lOpen; i++) {
+        closeConnection(piClients[i]);
+        closeConnection(piServers[i]);
+    }
+    close(stCtx.iEpoll);
+    close(stCtx.iServerSock);
+    free(piClients);
+    free(piServers);
+    return iResult;
+}
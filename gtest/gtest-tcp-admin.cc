@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-admin.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+
+/**
+ * @test 관리 서버 연결 테이블 덤프 테스트
+ *
+ * socketpair 연결을 등록하고 송수신한 뒤, UNIX 도메인 소켓 관리 서버에 접속하여
+ * 덤프에 두 연결과 송수신 바이트가 포함되는지 확인합니다.
+ */
+TEST(TcpAdminTest, DumpConnections)
+{
+    char achPath[64];
+    snprintf(achPath, sizeof(achPath), "/tmp/tcpsock-admin.%d", (int)getpid());
+    ASSERT_GE(startAdminServer(achPath, 0), 0);
+    ASSERT_EQ(startAdminServer(achPath, 0), -1);
+
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+    registerConnInfo(aiSockPair[0]);
+    registerConnInfo(aiSockPair[1]);
+
+    char achBuffer[123];
+    memset(achBuffer, 'x', sizeof(achBuffer));
+    ASSERT_EQ(sendMessage(aiSockPair[0], achBuffer, sizeof(achBuffer)), (int)sizeof(achBuffer));
+
+    int iSock = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(iSock, 0);
+    struct sockaddr_un stAddr;
+    memset(&stAddr, 0, sizeof(stAddr));
+    stAddr.sun_family = AF_UNIX;
+    strcpy(stAddr.sun_path, achPath);
+    ASSERT_EQ(connect(iSock, (struct sockaddr *)&stAddr, sizeof(stAddr)), 0);
+
+    std::string strDump;
+    char achRead[4096];
+    ssize_t received;
+    while ((received = recv(iSock, achRead, sizeof(achRead), 0)) > 0) {
+        strDump.append(achRead, (size_t)received);
+    }
+    close(iSock);
+
+    ASSERT_NE(strDump.find("# connections"), std::string::npos);
+    ASSERT_NE(strDump.find("# threads"), std::string::npos);
+
+    // 송신 측: bytes_out 123, 수신 측: 수신 큐에 123 바이트 대기
+    char achLine[64];
+    snprintf(achLine, sizeof(achLine), "\n%-6d %-24s", aiSockPair[0], "unix");
+    size_t uiPos = strDump.find(achLine);
+    ASSERT_NE(uiPos, std::string::npos);
+    ASSERT_NE(strDump.substr(uiPos, strDump.find('\n', uiPos + 1) - uiPos).find(" 123 "), std::string::npos);
+    snprintf(achLine, sizeof(achLine), "\n%-6d %-24s", aiSockPair[1], "unix");
+    uiPos = strDump.find(achLine);
+    ASSERT_NE(uiPos, std::string::npos);
+    ASSERT_NE(strDump.substr(uiPos, strDump.find('\n', uiPos + 1) - uiPos).find(" 123 "), std::string::npos);
+
+    stopAdminServer();
+    ASSERT_NE(access(achPath, F_OK), 0);
+
+    removeConnInfo(aiSockPair[0]);
+    removeConnInfo(aiSockPair[1]);
+    close(aiSockPair[0]);
+    close(aiSockPair[1]);
+}
+
+/**
+ * @test 연결이 TCP_ADMIN_MAX_CONNS개를 넘으면 덤프가 잘린 사실을 출력하는지 테스트
+ *
+ * 실제 소켓이 아닌 큰 fd 번호를 연결 테이블에 등록하여 상한을 넘깁니다.
+ */
+TEST(TcpAdminTest, DumpReportsTruncation)
+{
+    const int iFirst = TCP_CONN_MAX_FDS - TCP_ADMIN_MAX_CONNS - 1;
+
+    for (int iSock = iFirst; iSock < TCP_CONN_MAX_FDS; iSock++) {
+        ASSERT_NE(registerConnInfo(iSock), nullptr);
+    }
+
+    char *pchDump = NULL;
+    size_t uiSize = 0;
+    FILE *pFile = open_memstream(&pchDump, &uiSize);
+    ASSERT_NE(pFile, nullptr);
+    int iCount = writeAdminDump(pFile);
+    fclose(pFile);
+    std::string strDump(pchDump, uiSize);
+    free(pchDump);
+
+    for (int iSock = iFirst; iSock < TCP_CONN_MAX_FDS; iSock++) {
+        removeConnInfo(iSock);
+    }
+
+    ASSERT_EQ(iCount, TCP_ADMIN_MAX_CONNS);
+    char achLine[64];
+    snprintf(achLine, sizeof(achLine), "# truncated after %d connections\n", TCP_ADMIN_MAX_CONNS);
+    ASSERT_NE(strDump.find(achLine), std::string::npos);
+    snprintf(achLine, sizeof(achLine), "\n%-6d ", TCP_CONN_MAX_FDS - 1);
+    ASSERT_EQ(strDump.find(achLine), std::string::npos);
+}
+
+/**
+ * @test 덤프를 읽지 않는 클라이언트가 관리 서버를 멈추지 않는지 테스트
+ *
+ * 소켓 버퍼보다 큰 덤프를 만들고 읽지 않은 채 기다린 뒤, 관리 서버가 연결을 끊고
+ * stopAdminServer()가 반환되는지 확인합니다.
+ */
+TEST(TcpAdminTest, DropsStalledClient)
+{
+    const int iFirst = TCP_CONN_MAX_FDS - TCP_ADMIN_MAX_CONNS;
+    char achPath[64];
+    snprintf(achPath, sizeof(achPath), "/tmp/tcpsock-admin-stall.%d", (int)getpid());
+
+    for (int iSock = iFirst; iSock < TCP_CONN_MAX_FDS; iSock++) {
+        ASSERT_NE(registerConnInfo(iSock), nullptr);
+    }
+    ASSERT_GE(startAdminServer(achPath, 0), 0);
+
+    int iSock = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(iSock, 0);
+    struct sockaddr_un stAddr;
+    memset(&stAddr, 0, sizeof(stAddr));
+    stAddr.sun_family = AF_UNIX;
+    strcpy(stAddr.sun_path, achPath);
+    ASSERT_EQ(connect(iSock, (struct sockaddr *)&stAddr, sizeof(stAddr)), 0);
+
+    unsigned long long ullStart = getMonotonicNsec();
+    stopAdminServer();
+    ASSERT_LT(getMonotonicNsec() - ullStart, 5000000000ULL);
+
+    // 관리 서버가 끊은 연결은 덤프 일부를 읽은 뒤 끝남
+    char achRead[65536];
+    size_t uiTotal = 0;
+    ssize_t received;
+    while ((received = recv(iSock, achRead, sizeof(achRead), 0)) > 0) {
+        uiTotal += (size_t)received;
+    }
+    close(iSock);
+    ASSERT_GT(uiTotal, 0U);
+
+    for (int iSock = iFirst; iSock < TCP_CONN_MAX_FDS; iSock++) {
+        removeConnInfo(iSock);
+    }
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include "tcp-alloc.h"
+#include "tcp-conn.h"
+#include "tcp-frame.h"
+#include "tcp-sock.h"
+#include <thread>
+#include <sys/socket.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+
+/**
+ * @brief 감시 구간 위반 위치 확인용 할당 함수 (인라인되지 않도록 함)
+ */
+__attribute__((noinline)) void *allocateForGuardTest(size_t uiSize)
+{
+    void *pvPtr = malloc(uiSize);
+    __asm__ __volatile__("" : : "r"(pvPtr) : "memory");
+    return pvPtr;
+}
+
+
+/**
+ * @test 할당 카운터가 스레드별로 분리되어 세어지는지 테스트
+ */
+TEST(TcpAllocTest, CountsPerThread)
+{
+    if (!isAllocTrackingEnabled()) {
+        GTEST_SKIP() << "built without TCP_ALLOC_TRACK";
+    }
+
+    TcpAllocCounts stBefore;
+    TcpAllocCounts stAfter;
+    getThreadAllocCounts(&stBefore);
+
+    std::thread worker([]() {
+        for (int i = 0; i < 10; i++) {
+            free(allocateForGuardTest(64));
+        }
+    });
+    worker.join();
+
+    getThreadAllocCounts(&stAfter);
+    unsigned long long ullThreadAllocs = stAfter.ullAllocs;
+    void *pvPtr = allocateForGuardTest(100);
+    getThreadAllocCounts(&stAfter);
+    free(pvPtr);
+
+    ASSERT_EQ(stAfter.ullAllocs, ullThreadAllocs + 1);
+    ASSERT_GE(stAfter.ullBytes, stBefore.ullBytes + 100);
+}
+
+/**
+ * @test 정렬 할당 함수도 카운터에 세어지는지 테스트
+ */
+TEST(TcpAllocTest, CountsAlignedAllocations)
+{
+    if (!isAllocTrackingEnabled()) {
+        GTEST_SKIP() << "built without TCP_ALLOC_TRACK";
+    }
+
+    TcpAllocCounts stBefore;
+    TcpAllocCounts stAfter;
+    void *pvAligned = NULL;
+
+    getThreadAllocCounts(&stBefore);
+    ASSERT_EQ(posix_memalign(&pvAligned, 64, 200), 0);
+    ASSERT_EQ((unsigned long)pvAligned % 64, 0UL);
+    void *pvAlloc = aligned_alloc(128, 256);
+    ASSERT_NE(pvAlloc, nullptr);
+    ASSERT_EQ((unsigned long)pvAlloc % 128, 0UL);
+    getThreadAllocCounts(&stAfter);
+    free(pvAligned);
+    free(pvAlloc);
+
+    ASSERT_EQ(stAfter.ullAllocs, stBefore.ullAllocs + 2);
+    ASSERT_EQ(stAfter.ullBytes, stBefore.ullBytes + 456);
+    ASSERT_EQ(posix_memalign(&pvAligned, 3, 16), EINVAL);
+}
+
+/**
+ * @test 감시 구간의 할당이 위반으로 세어지고 호출 위치가 기록되는지 테스트
+ */
+TEST(TcpAllocTest, GuardRecordsCallSite)
+{
+    if (!isAllocTrackingEnabled()) {
+        GTEST_SKIP() << "built without TCP_ALLOC_TRACK";
+    }
+
+    armAllocGuard();
+    void *pvFirst = allocateForGuardTest(48);
+    void *pvSecond = allocateForGuardTest(48);
+    unsigned long long ullViolations = disarmAllocGuard();
+    free(pvFirst);
+    free(pvSecond);
+
+    TcpAllocSite astSites[TCP_ALLOC_MAX_SITES];
+    ASSERT_EQ(ullViolations, 2ULL);
+    ASSERT_EQ(getAllocViolationSites(astSites, TCP_ALLOC_MAX_SITES), 1);
+    ASSERT_EQ(astSites[0].ullCount, 2ULL);
+    ASSERT_EQ(astSites[0].uiLastSize, (size_t)48);
+
+    Dl_info stInfo;
+    ASSERT_NE(dladdr(astSites[0].kpvCaller, &stInfo), 0);
+    ASSERT_NE(stInfo.dli_sname, nullptr);
+    ASSERT_NE(strstr(stInfo.dli_sname, "allocateForGuardTest"), nullptr);
+
+    // 다시 감시하면 이전 기록은 지워짐
+    armAllocGuard();
+    ASSERT_EQ(disarmAllocGuard(), 0ULL);
+    ASSERT_EQ(getAllocViolationSites(astSites, TCP_ALLOC_MAX_SITES), 0);
+}
+
+/**
+ * @test 워밍업 이후 프레임 송수신과 적응형 수신 경로가 할당하지 않는지 테스트
+ *
+ * 작은 메시지 사이에 주기적으로 큰 묶음을 섞어, 적응형 수신 버퍼가 축소와 확장을
+ * 반복하며 재할당하지 않는지도 확인합니다.
+ */
+TEST(TcpAllocTest, SteadyStateIsAllocationFree)
+{
+    if (!isAllocTrackingEnabled()) {
+        GTEST_SKIP() << "built without TCP_ALLOC_TRACK";
+    }
+
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+    registerConnInfo(aiSockPair[0]);
+    registerConnInfo(aiSockPair[1]);
+
+    static char s_achBulk[32768];
+    char achPayload[256];
+    char achBuffer[1024];
+    void *pvAdaptive = NULL;
+    size_t uiCapacity = 0;
+    TcpFrameHeader stHeader;
+    memset(s_achBulk, 'b', sizeof(s_achBulk));
+    memset(achPayload, 'p', sizeof(achPayload));
+
+    auto runRound = [&](int iRound) {
+        int iFailures = 0;
+        iFailures += sendFrame(aiSockPair[1], achPayload, sizeof(achPayload), NULL) != (int)sizeof(achPayload);
+        iFailures += recvFrame(aiSockPair[0], achBuffer, sizeof(achBuffer), &stHeader) != (int)sizeof(achPayload);
+
+        const void *kpvData = (iRound % 64 == 0) ? (const void *)s_achBulk : (const void *)achPayload;
+        size_t uiLength = (iRound % 64 == 0) ? sizeof(s_achBulk) : sizeof(achPayload);
+        iFailures += sendMessage(aiSockPair[1], kpvData, uiLength) != (int)uiLength;
+        size_t uiReceived = 0;
+        while (uiReceived < uiLength) {
+            int iReceived = recvMsgAdaptive(aiSockPair[0], &pvAdaptive, &uiCapacity);
+            if (iReceived <= 0) {
+                return iFailures + 1;
+            }
+            uiReceived += (size_t)iReceived;
+        }
+        return iFailures;
+    };
+
+    int iFailures = 0;
+    for (int i = 0; i < 128; i++) {
+        iFailures += runRound(i);
+    }
+    armAllocGuard();
+    for (int i = 0; i < 2048; i++) {
+        iFailures += runRound(i);
+    }
+    unsigned long long ullViolations = disarmAllocGuard();
+    if (ullViolations > 0) {
+        reportAllocViolations(stderr, "SteadyStateIsAllocationFree");
+    }
+
+    removeConnInfo(aiSockPair[0]);
+    removeConnInfo(aiSockPair[1]);
+    close(aiSockPair[0]);
+    close(aiSockPair[1]);
+    free(pvAdaptive);
+
+    ASSERT_EQ(iFailures, 0);
+    ASSERT_EQ(ullViolations, 0ULL);
+}
@@ -0,0 +1,372 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-balance.h"
+#include "tcp-metrics.h"
+#include <unistd.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BALANCE_TEST_PORT       12402
+#define BALANCE_TEST_KEYS       20000
+
+
+static std::string makeKey(int i)
+{
+    return "user:" + std::to_string(i);
+}
+
+/**
+ * @test Maglev 테이블 균등성과 멤버십 변경 시 키 이동 테스트
+ *
+ * 테이블 자리가 백엔드마다 고르게 나뉘고, 백엔드 하나를 빼면 그 백엔드의 키만 대부분 옮겨지며,
+ * 같은 백엔드를 다시 넣으면 원래 배정으로 돌아오는지 확인합니다.
+ */
+TEST(TcpBalanceTest, MaglevIsBalancedWithMinimalDisruption)
+{
+    static TcpBalancer s_stBalancer;
+    const int iBackends = 5;
+
+    initBalancer(&s_stBalancer, TCP_BALANCE_P2C_INFLIGHT);
+    ASSERT_EQ(lookupBackend(&s_stBalancer, "k", 1), -1);
+    for (int i = 0; i < iBackends; i++) {
+        std::string strEndpoint = "10.0.0." + std::to_string(i + 1) + ":6379";
+        ASSERT_EQ(addBackend(&s_stBalancer, strEndpoint.c_str()), i);
+    }
+    ASSERT_EQ(addBackend(&s_stBalancer, "10.0.0.3:6379"), 2);
+
+    int aiShare[iBackends] = { 0 };
+    for (int i = 0; i < TCP_BALANCE_TABLE_SIZE; i++) {
+        ASSERT_GE(s_stBalancer.asTable[i], 0);
+        aiShare[s_stBalancer.asTable[i]]++;
+    }
+    for (int i = 0; i < iBackends; i++) {
+        ASSERT_NEAR(aiShare[i], TCP_BALANCE_TABLE_SIZE / iBackends, TCP_BALANCE_TABLE_SIZE / iBackends / 20);
+    }
+
+    std::vector<int> vecBefore;
+    for (int i = 0; i < BALANCE_TEST_KEYS; i++) {
+        std::string strKey = makeKey(i);
+        vecBefore.push_back(lookupBackend(&s_stBalancer, strKey.data(), strKey.size()));
+        ASSERT_EQ(lookupBackend(&s_stBalancer, strKey.data(), strKey.size()), vecBefore.back());
+    }
+
+    ASSERT_EQ(removeBackend(&s_stBalancer, "10.0.0.3:6379"), 0);
+    ASSERT_EQ(removeBackend(&s_stBalancer, "10.0.0.3:6379"), -1);
+    int iMovedOthers = 0;
+    int iOthers = 0;
+    for (int i = 0; i < BALANCE_TEST_KEYS; i++) {
+        std::string strKey = makeKey(i);
+        int iAfter = lookupBackend(&s_stBalancer, strKey.data(), strKey.size());
+        ASSERT_NE(iAfter, 2);
+        if (vecBefore[i] != 2) {
+            iOthers++;
+            iMovedOthers += (iAfter != vecBefore[i]);
+        }
+    }
+    ASSERT_LT(iMovedOthers * 100, iOthers * 3);
+
+    ASSERT_EQ(addBackend(&s_stBalancer, "10.0.0.3:6379"), 2);
+    for (int i = 0; i < BALANCE_TEST_KEYS; i++) {
+        std::string strKey = makeKey(i);
+        ASSERT_EQ(lookupBackend(&s_stBalancer, strKey.data(), strKey.size()), vecBefore[i]);
+    }
+    destroyBalancer(&s_stBalancer);
+}
+
+/**
+ * @brief 루프백 백엔드 두 개를 띄운 테스트 픽스처 (연결은 accept 큐에 쌓임)
+ */
+class TcpBalanceConnTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        for (int i = 0; i < 2; i++) {
+            int iPort = BALANCE_TEST_PORT + i;
+            if (isPortAvailable(iPort) != 0) {
+                GTEST_SKIP() << "port " << iPort << " in use";
+            }
+            m_aiServers[i] = createServerSocket(iPort, 64);
+            ASSERT_GE(m_aiServers[i], 0);
+            m_astrEndpoints[i] = "127.0.0.1:" + std::to_string(iPort);
+        }
+    }
+
+    void TearDown() override
+    {
+        for (int i = 0; i < 2; i++) {
+            if (m_aiServers[i] >= 0) {
+                close(m_aiServers[i]);
+            }
+        }
+    }
+
+    void addBoth(TcpBalancer *pstBalancer)
+    {
+        ASSERT_EQ(addBackend(pstBalancer, m_astrEndpoints[0].c_str()), 0);
+        ASSERT_EQ(addBackend(pstBalancer, m_astrEndpoints[1].c_str()), 1);
+        for (int i = 0; m_astrKeys[0].empty() || m_astrKeys[1].empty(); i++) {
+            std::string strKey = makeKey(i);
+            int iBackend = lookupBackend(pstBalancer, strKey.data(), strKey.size());
+            if (m_astrKeys[iBackend].empty()) {
+                m_astrKeys[iBackend] = strKey;
+            }
+        }
+    }
+
+    // 백엔드에 배정된 키로 요청을 보내 결과를 반영
+    void runRequests(TcpBalancer *pstBalancer, int iBackend, int iCount, int iFailed, int iDelayMsec)
+    {
+        TcpBalanceConn stConn;
+        for (int i = 0; i < iCount; i++) {
+            ASSERT_EQ(acquireBackendConn(pstBalancer, m_astrKeys[iBackend].data(), m_astrKeys[iBackend].size(), &stConn), 0);
+            ASSERT_EQ(stConn.iBackend, iBackend);
+            if (iDelayMsec > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(iDelayMsec));
+            }
+            releaseBackendConn(pstBalancer, &stConn, iFailed);
+        }
+    }
+
+    int m_aiServers[2] = { -1, -1 };
+    std::string m_astrEndpoints[2];
+    std::string m_astrKeys[2];
+};
+
+/**
+ * @test 진행 중인 요청 수 기반 P2C와 연결 재사용 테스트
+ */
+TEST_F(TcpBalanceConnTest, TwoChoicesByInFlightWithPooling)
+{
+    static TcpBalancer s_stBalancer;
+    TcpBalanceConn stFirst;
+    TcpBalanceConn stSecond;
+
+    initBalancer(&s_stBalancer, TCP_BALANCE_P2C_INFLIGHT);
+    addBoth(&s_stBalancer);
+
+    // 한쪽이 요청을 들고 있으면 다른 쪽이 뽑힘
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stFirst), 0);
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stSecond), 0);
+        ASSERT_NE(stFirst.iBackend, stSecond.iBackend);
+        releaseBackendConn(&s_stBalancer, &stSecond, 0);
+        releaseBackendConn(&s_stBalancer, &stFirst, 0);
+    }
+    ASSERT_EQ(s_stBalancer.astBackends[0].iIdle, 1);
+    ASSERT_EQ(s_stBalancer.astBackends[1].iIdle, 1);
+    ASSERT_EQ(s_stBalancer.astBackends[0].uiInFlight + s_stBalancer.astBackends[1].uiInFlight, 0U);
+    ASSERT_EQ(s_stBalancer.astBackends[0].ullRequests + s_stBalancer.astBackends[1].ullRequests, 40ULL);
+
+    // 재사용한 연결은 새로 연결하지 않음, 실패한 연결은 닫힘
+    unsigned long long ullConnects = getMetricCounter(TCP_COUNTER_CONNECTS);
+    ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stFirst), 0);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_CONNECTS), ullConnects);
+    int iBackend = stFirst.iBackend;
+    releaseBackendConn(&s_stBalancer, &stFirst, 1);
+    ASSERT_EQ(stFirst.iSock, -1);
+    ASSERT_EQ(s_stBalancer.astBackends[iBackend].iIdle, 0);
+    ASSERT_EQ(s_stBalancer.astBackends[iBackend].ullFailures, 1ULL);
+
+    // 키가 있으면 Maglev 테이블의 백엔드
+    ASSERT_EQ(acquireBackendConn(&s_stBalancer, "session:42", 10, &stFirst), 0);
+    ASSERT_EQ(stFirst.iBackend, lookupBackend(&s_stBalancer, "session:42", 10));
+    releaseBackendConn(&s_stBalancer, &stFirst, 0);
+
+    destroyBalancer(&s_stBalancer);
+}
+
+/**
+ * @test EWMA 지연 기반 P2C 테스트
+ *
+ * 한 백엔드의 요청만 느리게 끝내면 이후 요청이 빠른 백엔드로 몰리는지 확인합니다.
+ */
+TEST_F(TcpBalanceConnTest, TwoChoicesByEwmaLatency)
+{
+    static TcpBalancer s_stBalancer;
+    TcpBalanceConn stConn;
+
+    initBalancer(&s_stBalancer, TCP_BALANCE_P2C_EWMA);
+    addBoth(&s_stBalancer);
+
+    for (int i = 0; i < 8; i++) {
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stConn), 0);
+        if (stConn.iBackend == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        releaseBackendConn(&s_stBalancer, &stConn, 0);
+    }
+    ASSERT_GT(s_stBalancer.astBackends[0].ullEwmaNsec, 10ULL * 1000000ULL);
+    ASSERT_GT(s_stBalancer.astBackends[1].ullEwmaNsec, 0ULL);
+
+    TcpBalanceConn astHeld[8];
+    for (TcpBalanceConn &stHeld : astHeld) {
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stHeld), 0);
+        ASSERT_EQ(stHeld.iBackend, 1);
+    }
+    for (TcpBalanceConn &stHeld : astHeld) {
+        releaseBackendConn(&s_stBalancer, &stHeld, 0);
+    }
+    destroyBalancer(&s_stBalancer);
+}
+
+/**
+ * @test 멤버십 변경과 빌려 간 연결 테스트
+ *
+ * 빠진 백엔드는 더 이상 뽑히지 않고, 빠지기 전에 빌려 간 연결은 반납할 때 닫히는지 확인합니다.
+ */
+TEST_F(TcpBalanceConnTest, RemovedBackendConnectionsAreClosed)
+{
+    static TcpBalancer s_stBalancer;
+    TcpBalanceConn stConn;
+
+    initBalancer(&s_stBalancer, TCP_BALANCE_P2C_INFLIGHT);
+    addBoth(&s_stBalancer);
+    do {
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stConn), 0);
+        if (stConn.iBackend != 0) {
+            releaseBackendConn(&s_stBalancer, &stConn, 0);
+        }
+    } while (stConn.iBackend != 0);
+
+    ASSERT_EQ(removeBackend(&s_stBalancer, m_astrEndpoints[0].c_str()), 0);
+    for (int i = 0; i < 10; i++) {
+        TcpBalanceConn stOther;
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stOther), 0);
+        ASSERT_EQ(stOther.iBackend, 1);
+        releaseBackendConn(&s_stBalancer, &stOther, 0);
+    }
+    releaseBackendConn(&s_stBalancer, &stConn, 0);
+    ASSERT_EQ(s_stBalancer.astBackends[0].iIdle, 0);
+
+    ASSERT_EQ(removeBackend(&s_stBalancer, m_astrEndpoints[1].c_str()), 0);
+    ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stConn), -1);
+    destroyBalancer(&s_stBalancer);
+}
+
+/**
+ * @test 연속 실패 제외, 지수 제외 시간, 탐침 후 점진적 재투입 테스트
+ */
+TEST_F(TcpBalanceConnTest, ConsecutiveFailuresEjectWithBackoffAndProbe)
+{
+    static TcpBalancer s_stBalancer;
+    TcpOutlierConfig stConfig;
+    TcpBalanceConn stConn;
+
+    memset(&stConfig, 0, sizeof(stConfig));
+    stConfig.uiConsecutiveFailures = 3;
+    stConfig.uiEjectTimeMsec = 50;
+    stConfig.uiMaxEjectTimeMsec = 400;
+    stConfig.uiRampTimeMsec = 1000;
+    initBalancer(&s_stBalancer, TCP_BALANCE_P2C_INFLIGHT);
+    setOutlierConfig(&s_stBalancer, &stConfig);
+    addBoth(&s_stBalancer);
+
+    std::vector<std::string> vecHomeKeys;
+    for (int i = 0; i < 1000; i++) {
+        std::string strKey = makeKey(i);
+        if (lookupBackend(&s_stBalancer, strKey.data(), strKey.size()) == 0) {
+            vecHomeKeys.push_back(strKey);
+        }
+    }
+    ASSERT_GT(vecHomeKeys.size(), 200U);
+
+    unsigned long long ullEjections = getMetricCounter(TCP_COUNTER_BACKEND_EJECTIONS);
+    runRequests(&s_stBalancer, 0, 2, 1, 0);
+    ASSERT_EQ(s_stBalancer.astBackends[0].iEjected, 0);
+    runRequests(&s_stBalancer, 0, 1, 1, 0);
+    ASSERT_EQ(s_stBalancer.astBackends[0].iEjected, 1);
+    ASSERT_EQ(s_stBalancer.astBackends[0].uiEjections, 1U);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_BACKEND_EJECTIONS), ullEjections + 1);
+
+    // 제외된 동안 키 있는 요청과 P2C 모두 다른 백엔드로
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(lookupBackend(&s_stBalancer, m_astrKeys[0].data(), m_astrKeys[0].size()), 1);
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stConn), 0);
+        ASSERT_EQ(stConn.iBackend, 1);
+        releaseBackendConn(&s_stBalancer, &stConn, 0);
+    }
+    ASSERT_EQ(checkBackendHealth(&s_stBalancer), 1);
+
+    // 제외 시간이 지나면 탐침 연결로 다시 넣고, 그 연결은 풀에 들어감
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    ASSERT_EQ(checkBackendHealth(&s_stBalancer), 0);
+    ASSERT_EQ(s_stBalancer.astBackends[0].iEjected, 0);
+    ASSERT_EQ(s_stBalancer.astBackends[0].iIdle, 1);
+
+    // 램프 동안에는 키 있는 요청도 일부 키만 돌아오고, 같은 키는 늘 같은 백엔드로 감
+    size_t uiReturned = 0;
+    for (const std::string &strKey : vecHomeKeys) {
+        int iBackend = lookupBackend(&s_stBalancer, strKey.data(), strKey.size());
+        ASSERT_EQ(lookupBackend(&s_stBalancer, strKey.data(), strKey.size()), iBackend);
+        uiReturned += (iBackend == 0);
+    }
+    ASSERT_GT(uiReturned, 0U);
+    ASSERT_LT(uiReturned, vecHomeKeys.size() * 3 / 10);
+
+    // 램프 동안에는 P2C 몫이 작음
+    int iPicks = 0;
+    for (int i = 0; i < 200; i++) {
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, NULL, 0, &stConn), 0);
+        iPicks += (stConn.iBackend == 0);
+        releaseBackendConn(&s_stBalancer, &stConn, 0);
+    }
+    ASSERT_LT(iPicks, 60);
+
+    // 램프가 끝나면 모든 키가 원래 백엔드로 돌아옴
+    s_stBalancer.astBackends[0].ullRampStartNsec = getMonotonicNsec() - 1000ULL * 1000000ULL;
+    for (const std::string &strKey : vecHomeKeys) {
+        ASSERT_EQ(lookupBackend(&s_stBalancer, strKey.data(), strKey.size()), 0);
+    }
+
+    // 다시 제외되면 두 배로, 탐침이 실패하면 또 두 배로
+    runRequests(&s_stBalancer, 0, 3, 1, 0);
+    ASSERT_EQ(s_stBalancer.astBackends[0].uiEjections, 2U);
+    ASSERT_GT(s_stBalancer.astBackends[0].ullEjectUntilNsec, getMonotonicNsec() + 60ULL * 1000000ULL);
+
+    close(m_aiServers[0]);
+    m_aiServers[0] = -1;
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    ASSERT_EQ(checkBackendHealth(&s_stBalancer), 1);
+    ASSERT_EQ(s_stBalancer.astBackends[0].uiEjections, 3U);
+    ASSERT_GT(s_stBalancer.astBackends[0].ullEjectUntilNsec, getMonotonicNsec() + 150ULL * 1000000ULL);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_BACKEND_EJECTIONS), ullEjections + 3);
+    destroyBalancer(&s_stBalancer);
+}
+
+/**
+ * @test p99 지연 이상치 제외와 동시 제외 비율 상한 테스트
+ */
+TEST_F(TcpBalanceConnTest, LatencyOutlierIsEjectedWithinLimit)
+{
+    static TcpBalancer s_stBalancer;
+    TcpOutlierConfig stConfig;
+
+    memset(&stConfig, 0, sizeof(stConfig));
+    stConfig.uiMinRequests = 5;
+    initBalancer(&s_stBalancer, TCP_BALANCE_P2C_INFLIGHT);
+    setOutlierConfig(&s_stBalancer, &stConfig);
+    addBoth(&s_stBalancer);
+
+    // 표본이 모자라면 판정하지 않음
+    runRequests(&s_stBalancer, 0, 4, 0, 3);
+    runRequests(&s_stBalancer, 1, 10, 0, 0);
+    ASSERT_EQ(checkBackendHealth(&s_stBalancer), 0);
+
+    runRequests(&s_stBalancer, 0, 10, 0, 3);
+    runRequests(&s_stBalancer, 1, 10, 0, 0);
+    ASSERT_EQ(checkBackendHealth(&s_stBalancer), 1);
+    ASSERT_EQ(s_stBalancer.astBackends[0].iEjected, 1);
+    ASSERT_GE(s_stBalancer.astBackends[0].ullLastP99Nsec, 3ULL * 1000000ULL);
+    ASSERT_LT(s_stBalancer.astBackends[1].ullLastP99Nsec, 1000000ULL);
+
+    // 절반이 이미 제외되었으므로 남은 백엔드는 실패가 이어져도 제외하지 않음
+    runRequests(&s_stBalancer, 1, TCP_BALANCE_DEFAULT_CONSECUTIVE, 1, 0);
+    ASSERT_EQ(s_stBalancer.astBackends[1].iEjected, 0);
+    ASSERT_EQ(checkBackendHealth(&s_stBalancer), 1);
+    ASSERT_EQ(s_stBalancer.iActive, 1);
+    destroyBalancer(&s_stBalancer);
+}
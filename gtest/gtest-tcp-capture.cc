@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-capture.h"
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/**
+ * @test 송수신 데이터와 연결 제거가 순서대로 기록되는지 테스트
+ */
+TEST(TcpCaptureTest, RecordsStreams)
+{
+    char achPath[64];
+    snprintf(achPath, sizeof(achPath), "/tmp/tcpsock-capture.%d", (int)getpid());
+
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+    registerConnInfo(aiSockPair[0]);
+    registerConnInfo(aiSockPair[1]);
+
+    ASSERT_EQ(startTrafficCapture(achPath, 4096), 0);
+    ASSERT_EQ(startTrafficCapture(achPath, 4096), -1);
+
+    char achBuffer[16];
+    ASSERT_EQ(sendMessage(aiSockPair[0], "hello", 5), 5);
+    ASSERT_EQ(recvMsgBlocking(aiSockPair[1], achBuffer, sizeof(achBuffer)), 5);
+
+    struct iovec astIov[2];
+    astIov[0].iov_base = (void *)"ab";
+    astIov[0].iov_len = 2;
+    astIov[1].iov_base = (void *)"cd";
+    astIov[1].iov_len = 2;
+    ASSERT_EQ(sendMessageV(aiSockPair[1], astIov, 2), 4);
+    // 빈 데이터는 기록하지 않음
+    captureTraffic(aiSockPair[1], TCP_CAPTURE_OUT, "", 0);
+    captureTrafficV(aiSockPair[1], TCP_CAPTURE_OUT, astIov, 2, 0);
+    ASSERT_EQ(recvMsgTimeout(aiSockPair[0], achBuffer, sizeof(achBuffer), 100), 4);
+
+    unsigned long long ullConnId = findConnStats(aiSockPair[0])->ullCreatedNsec;
+    removeConnInfo(aiSockPair[0]);
+    removeConnInfo(aiSockPair[1]);
+    ASSERT_GT(stopTrafficCapture(), 0ULL);
+    ASSERT_EQ(stopTrafficCapture(), 0ULL);
+
+    const struct {
+        int iSock;
+        int iDirection;
+        const char *kpchData;
+    } kastExpected[] = {
+        { aiSockPair[0], TCP_CAPTURE_OUT, "hello" },
+        { aiSockPair[1], TCP_CAPTURE_IN, "hello" },
+        { aiSockPair[1], TCP_CAPTURE_OUT, "abcd" },
+        { aiSockPair[0], TCP_CAPTURE_IN, "abcd" },
+        { aiSockPair[0], TCP_CAPTURE_CLOSE, "" },
+        { aiSockPair[1], TCP_CAPTURE_CLOSE, "" },
+    };
+
+    size_t uiSize = 0;
+    const TcpCaptureHeader *kpstHeader = openTrafficCapture(achPath, &uiSize);
+    ASSERT_TRUE(kpstHeader != NULL);
+    ASSERT_EQ(kpstHeader->ullDropped, 0ULL);
+
+    const TcpCaptureRecord *kpstRecord = NULL;
+    unsigned long long ullLastOffset = 0;
+    for (size_t i = 0; i < sizeof(kastExpected) / sizeof(kastExpected[0]); i++) {
+        kpstRecord = nextTrafficRecord(kpstHeader, kpstRecord);
+        ASSERT_TRUE(kpstRecord != NULL);
+        ASSERT_EQ(kpstRecord->iSock, kastExpected[i].iSock);
+        ASSERT_EQ(kpstRecord->iDirection, kastExpected[i].iDirection);
+        ASSERT_EQ(kpstRecord->uiLength, strlen(kastExpected[i].kpchData));
+        ASSERT_EQ(memcmp(TCP_CAPTURE_DATA(kpstRecord), kastExpected[i].kpchData, kpstRecord->uiLength), 0);
+        ASSERT_GE(kpstRecord->ullOffsetNsec, ullLastOffset);
+        ullLastOffset = kpstRecord->ullOffsetNsec;
+        if (kpstRecord->iSock == aiSockPair[0]) {
+            ASSERT_EQ(kpstRecord->ullConnId, ullConnId);
+        }
+    }
+    ASSERT_TRUE(nextTrafficRecord(kpstHeader, kpstRecord) == NULL);
+
+    munmap((void *)kpstHeader, uiSize);
+    unlink(achPath);
+    close(aiSockPair[0]);
+    close(aiSockPair[1]);
+}
+
+/**
+ * @test 영역이 가득 차면 레코드를 버리고 개수를 세며, 등록되지 않은 소켓은 기록하지 않는지 테스트
+ */
+TEST(TcpCaptureTest, DropsWhenFull)
+{
+    char achPath[64];
+    snprintf(achPath, sizeof(achPath), "/tmp/tcpsock-capture.%d", (int)getpid());
+
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+    registerConnInfo(aiSockPair[0]);
+    removeConnInfo(aiSockPair[1]);
+    unsigned long long ullConnId = findConnStats(aiSockPair[0])->ullCreatedNsec;
+
+    char achBuffer[256];
+    memset(achBuffer, 'd', sizeof(achBuffer));
+    ASSERT_EQ(startTrafficCapture(achPath, 128), 0);
+    // 등록되지 않은 소켓은 연결 식별자가 없으므로 기록하지 않음
+    ASSERT_EQ(sendMessage(aiSockPair[1], achBuffer, 16), 16);
+    ASSERT_EQ(sendMessage(aiSockPair[0], achBuffer, 32), 32);
+    ASSERT_EQ(sendMessage(aiSockPair[0], achBuffer, sizeof(achBuffer)), (int)sizeof(achBuffer));
+
+    // 마무리 전에는 넘친 예약만큼 ullUsed가 용량보다 크지만 기록된 부분은 읽을 수 있음
+    size_t uiLiveSize = 0;
+    const TcpCaptureHeader *kpstLive = openTrafficCapture(achPath, &uiLiveSize);
+    ASSERT_TRUE(kpstLive != NULL);
+    ASSERT_GT(kpstLive->ullUsed, kpstLive->ullCapacity);
+    const TcpCaptureRecord *kpstLiveRecord = nextTrafficRecord(kpstLive, NULL);
+    ASSERT_TRUE(kpstLiveRecord != NULL);
+    ASSERT_EQ(kpstLiveRecord->uiLength, 32U);
+    munmap((void *)kpstLive, uiLiveSize);
+
+    ASSERT_LE(stopTrafficCapture(), 128ULL);
+
+    size_t uiSize = 0;
+    const TcpCaptureHeader *kpstHeader = openTrafficCapture(achPath, &uiSize);
+    ASSERT_TRUE(kpstHeader != NULL);
+    ASSERT_EQ(kpstHeader->ullDropped, 1ULL);
+
+    const TcpCaptureRecord *kpstRecord = nextTrafficRecord(kpstHeader, NULL);
+    ASSERT_TRUE(kpstRecord != NULL);
+    ASSERT_EQ(kpstRecord->uiLength, 32U);
+    ASSERT_EQ(kpstRecord->iSock, aiSockPair[0]);
+    ASSERT_EQ(kpstRecord->ullConnId, ullConnId);
+    ASSERT_TRUE(nextTrafficRecord(kpstHeader, kpstRecord) == NULL);
+
+    munmap((void *)kpstHeader, uiSize);
+    unlink(achPath);
+    removeConnInfo(aiSockPair[0]);
+    close(aiSockPair[0]);
+    close(aiSockPair[1]);
+}
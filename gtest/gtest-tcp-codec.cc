@@ -0,0 +1,327 @@
+#include <gtest/gtest.h>
+#include "tcp-codec.h"
+#include "tcp-frame.h"
+#include "tcp-resp.h"
+#include "tcp-sock.h"
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+
+
+/*
+ * 시험용 압축 코덱: (반복 횟수 1B, 바이트 1B) 쌍으로 된 런 길이 부호화
+ */
+static int decodeRunLength(void *pvState, void *pvData, size_t uiLength, TcpCodecMsg *pstMsg)
+{
+    std::vector<char> *pvecOut = (std::vector<char> *)pvState;
+    const unsigned char *kpucData = (const unsigned char *)pvData;
+
+    if (uiLength % 2 != 0) {
+        return -1;
+    }
+    pvecOut->clear();
+    for (size_t i = 0; i < uiLength; i += 2) {
+        pvecOut->insert(pvecOut->end(), kpucData[i], (char)kpucData[i + 1]);
+    }
+    pstMsg->pvData = pvecOut->data();
+    pstMsg->uiLength = pvecOut->size();
+    return (int)uiLength;
+}
+
+static int encodeRunLength(TcpCodecPipe *pstPipe, void *, struct iovec *pstIov, int iIov, int)
+{
+    std::string strIn;
+    for (int i = 0; i < iIov; i++) {
+        strIn.append((const char *)pstIov[i].iov_base, pstIov[i].iov_len);
+    }
+    unsigned char *pucOut = (unsigned char *)allocCodecScratch(pstPipe, strIn.size() * 2);
+    if (pucOut == NULL) {
+        return TCP_CODEC_NEED_SPACE;
+    }
+    size_t uiOut = 0;
+    for (size_t i = 0; i < strIn.size();) {
+        size_t uiRun = 1;
+        while (i + uiRun < strIn.size() && uiRun < 255 && strIn[i + uiRun] == strIn[i]) {
+            uiRun++;
+        }
+        pucOut[uiOut++] = (unsigned char)uiRun;
+        pucOut[uiOut++] = (unsigned char)strIn[i];
+        i += uiRun;
+    }
+    pstIov[0].iov_base = pucOut;
+    pstIov[0].iov_len = uiOut;
+    return 1;
+}
+
+static const TcpCodec s_stRunLengthCodec = { "rle", decodeRunLength, encodeRunLength };
+
+static std::string toString(const TcpCodecMsg &stMsg)
+{
+    return std::string((const char *)stMsg.pvData, stMsg.uiLength);
+}
+
+
+/**
+ * @brief 코덱 파이프라인 테스트 클래스
+ *
+ * socketpair()의 한쪽을 보내는 파이프라인, 다른 쪽을 받는 파이프라인으로 사용합니다.
+ */
+class TcpCodecTest : public ::testing::Test
+{
+protected:
+    int aiSockPair[2];
+    std::unique_ptr<TcpCodecPipe> pstSender;
+    std::unique_ptr<TcpCodecPipe> pstReceiver;
+    std::vector<char> vecBuffer;
+
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+        pstSender.reset(new TcpCodecPipe);
+        pstReceiver.reset(new TcpCodecPipe);
+        vecBuffer.resize(4096);
+        initCodecPipe(pstSender.get(), aiSockPair[0], NULL, 0);
+        initCodecPipe(pstReceiver.get(), aiSockPair[1], vecBuffer.data(), vecBuffer.size());
+    }
+
+    void TearDown() override {
+        close(aiSockPair[0]);
+        close(aiSockPair[1]);
+    }
+
+    int queue(const std::string &strData) {
+        struct iovec stIov;
+        stIov.iov_base = (void *)strData.data();
+        stIov.iov_len = strData.size();
+        return queueCodecMessage(pstSender.get(), &stIov, 1);
+    }
+};
+
+
+/**
+ * @test 짧은 메시지 여러 개가 iovec 하나로 묶여 나가고, 받는 쪽은 수신 버퍼 안에서 복사 없이
+ *       돌려주며, 긴 페이로드는 참조로 보내는지 테스트
+ */
+TEST_F(TcpCodecTest, FrameCodecBatchesAndDecodesInPlace)
+{
+    TcpFrameCodecState stReceived;
+    ASSERT_EQ(pushCodecLayer(pstSender.get(), getFrameCodec(), NULL), 0);
+    ASSERT_EQ(pushCodecLayer(pstReceiver.get(), getFrameCodec(), &stReceived), 0);
+
+    std::vector<std::string> vecMessages;
+    for (int i = 0; i < 40; i++) {
+        vecMessages.push_back("message-" + std::to_string(i) + std::string((size_t)i, '.'));
+        ASSERT_EQ(queue(vecMessages.back()), 0);
+    }
+    ASSERT_EQ(pstSender->iIov, 1);
+    ASSERT_EQ(pstSender->ullQueued, 40u);
+    ASSERT_EQ(flushCodecPipe(pstSender.get()), 0);
+
+    TcpCodecMsg stMsg;
+    for (int i = 0; i < 40; i++) {
+        ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+        ASSERT_EQ(toString(stMsg), vecMessages[(size_t)i]);
+        ASSERT_GE((char *)stMsg.pvData, vecBuffer.data());
+        ASSERT_LT((char *)stMsg.pvData, vecBuffer.data() + vecBuffer.size());
+    }
+
+    // 긴 페이로드는 헤더만 스크래치에 쓰고 호출자 버퍼를 그대로 가리킴
+    std::string strLarge(1000, 'L');
+    ASSERT_EQ(queue(strLarge), 0);
+    ASSERT_EQ(pstSender->iIov, 2);
+    ASSERT_EQ(pstSender->astIov[1].iov_base, (void *)strLarge.data());
+    ASSERT_EQ(flushCodecPipe(pstSender.get()), 0);
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+    ASSERT_EQ(toString(stMsg), strLarge);
+
+    // 상태로 넘긴 추적 컨텍스트가 프레임 헤더에 실림
+    TcpTraceContext stTrace;
+    memset(&stTrace, 0, sizeof(stTrace));
+    stTrace.aucTraceId[0] = 0xab;
+    stTrace.ucFlags = 1;
+    TcpFrameCodecState stSent;
+    stSent.kpstTrace = &stTrace;
+    pstSender->astLayers[0].pvState = &stSent;
+    ASSERT_EQ(queue("traced"), 0);
+    ASSERT_EQ(flushCodecPipe(pstSender.get()), 0);
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+    ASSERT_EQ(toString(stMsg), "traced");
+    ASSERT_TRUE(stReceived.stLastHeader.ucFlags & TCP_FRAME_FLAG_TRACE);
+    ASSERT_EQ(stReceived.stLastHeader.stTrace.aucTraceId[0], 0xab);
+}
+
+/**
+ * @test 스크래치가 모자라도 짧은 조각을 호출자 버퍼 참조로 남기지 않는지 테스트
+ *
+ * 한 스택 버퍼를 메시지마다 덮어쓰며 큐에 넣어, 스크래치가 바닥나는 지점의 메시지도 넣을 때의
+ * 내용 그대로 도착하는지 확인합니다.
+ */
+TEST_F(TcpCodecTest, ShortPiecesAreCopiedWhenScratchRunsOut)
+{
+    ASSERT_EQ(pushCodecLayer(pstSender.get(), getFrameCodec(), NULL), 0);
+    ASSERT_EQ(pushCodecLayer(pstReceiver.get(), getFrameCodec(), NULL), 0);
+
+    const int iMessages = TCP_CODEC_SCRATCH_SIZE / (TCP_CODEC_INLINE_MAX + TCP_FRAME_HEADER_SIZE) + 8;
+    char achPayload[TCP_CODEC_INLINE_MAX];
+    struct iovec stIov;
+    stIov.iov_base = achPayload;
+    stIov.iov_len = sizeof(achPayload);
+    for (int i = 0; i < iMessages; i++) {
+        memset(achPayload, 'a' + i % 26, sizeof(achPayload));
+        ASSERT_EQ(queueCodecMessage(pstSender.get(), &stIov, 1), 0);
+        for (int j = 0; j < pstSender->iIov; j++) {
+            ASSERT_NE(pstSender->astIov[j].iov_base, (void *)achPayload);
+        }
+    }
+    memset(achPayload, '!', sizeof(achPayload));
+    ASSERT_EQ(flushCodecPipe(pstSender.get()), 0);
+
+    TcpCodecMsg stMsg;
+    for (int i = 0; i < iMessages; i++) {
+        ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+        ASSERT_EQ(toString(stMsg), std::string(sizeof(achPayload), (char)('a' + i % 26))) << "message " << i;
+    }
+}
+
+/**
+ * @test 프레이밍 아래에 압축 코덱을 쌓으면 와이어에는 압축된 페이로드가 실리고 받는 쪽은
+ *       원래 메시지를 돌려받는지 테스트
+ */
+TEST_F(TcpCodecTest, StackedCompressionUnderFraming)
+{
+    std::vector<char> vecInflated;
+    ASSERT_EQ(pushCodecLayer(pstSender.get(), getFrameCodec(), NULL), 0);
+    ASSERT_EQ(pushCodecLayer(pstSender.get(), &s_stRunLengthCodec, NULL), 1);
+    ASSERT_EQ(pushCodecLayer(pstReceiver.get(), getFrameCodec(), NULL), 0);
+    ASSERT_EQ(pushCodecLayer(pstReceiver.get(), &s_stRunLengthCodec, &vecInflated), 1);
+
+    std::string strPayload = std::string(4000, 'a') + "xyz";
+    struct iovec astIov[2];
+    astIov[0].iov_base = (void *)strPayload.data();
+    astIov[0].iov_len = 2000;
+    astIov[1].iov_base = (void *)(strPayload.data() + 2000);
+    astIov[1].iov_len = strPayload.size() - 2000;
+    ASSERT_EQ(queueCodecMessage(pstSender.get(), astIov, 2), 0);
+    ASSERT_EQ(queue("bbbb"), 0);
+    ASSERT_EQ(flushCodecPipe(pstSender.get()), 0);
+
+    unsigned char aucHeader[TCP_FRAME_HEADER_SIZE];
+    TcpFrameHeader stHeader;
+    ASSERT_EQ(recv(aiSockPair[1], aucHeader, sizeof(aucHeader), MSG_PEEK), (ssize_t)sizeof(aucHeader));
+    ASSERT_EQ(parseFrameHeader(aucHeader, sizeof(aucHeader), &stHeader), TCP_FRAME_HEADER_SIZE);
+    ASSERT_EQ(stHeader.uiPayloadLength, (4000 / 255 + 1 + 3) * 2u);
+
+    TcpCodecMsg stMsg;
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+    ASSERT_EQ(toString(stMsg), strPayload);
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+    ASSERT_EQ(toString(stMsg), "bbbb");
+
+    // 안쪽 코덱이 거부하면 실패
+    unsigned char aucOdd[TCP_FRAME_HEADER_SIZE + 3];
+    encodeFrameHeader(aucOdd, 3, NULL);
+    memcpy(aucOdd + TCP_FRAME_HEADER_SIZE, "\x01x\x01", 3);
+    ASSERT_EQ(write(aiSockPair[0], aucOdd, sizeof(aucOdd)), (ssize_t)sizeof(aucOdd));
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), -1);
+}
+
+/**
+ * @test 나뉘어 도착한 메시지를 기다리고, 버퍼 끝에 걸친 메시지는 앞으로 당기며,
+ *       버퍼보다 큰 메시지와 메시지 중간의 연결 종료는 실패로 처리하는지 테스트
+ */
+TEST_F(TcpCodecTest, FragmentedInputCompactionAndErrors)
+{
+    initCodecPipe(pstReceiver.get(), aiSockPair[1], vecBuffer.data(), 64);
+    ASSERT_EQ(pushCodecLayer(pstSender.get(), getFrameCodec(), NULL), 0);
+    ASSERT_EQ(pushCodecLayer(pstReceiver.get(), getFrameCodec(), NULL), 0);
+
+    std::string strPayload(40, 'p');
+    for (int i = 0; i < 3; i++) {
+        strPayload[0] = (char)('0' + i);
+        ASSERT_EQ(queue(strPayload), 0);
+    }
+    ASSERT_EQ(flushCodecPipe(pstSender.get()), 0);
+    TcpCodecMsg stMsg;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+        ASSERT_EQ(stMsg.uiLength, 40u);
+        ASSERT_EQ(((char *)stMsg.pvData)[0], (char)('0' + i));
+    }
+
+    unsigned char aucFrame[TCP_FRAME_HEADER_SIZE + 5];
+    encodeFrameHeader(aucFrame, 5, NULL);
+    memcpy(aucFrame + TCP_FRAME_HEADER_SIZE, "split", 5);
+    ASSERT_EQ(write(aiSockPair[0], aucFrame, 3), 3);
+    std::thread writer([&]() {
+        usleep(20000);
+        ASSERT_EQ(write(aiSockPair[0], aucFrame + 3, sizeof(aucFrame) - 3), (ssize_t)sizeof(aucFrame) - 3);
+    });
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+    writer.join();
+    ASSERT_EQ(toString(stMsg), "split");
+
+    ASSERT_EQ(write(aiSockPair[0], aucFrame, 4), 4);
+    shutdown(aiSockPair[0], SHUT_WR);
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), -1);
+
+    initCodecPipe(pstReceiver.get(), aiSockPair[1], vecBuffer.data(), 64);
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), -1);
+    ASSERT_EQ(pushCodecLayer(pstReceiver.get(), getFrameCodec(), NULL), 0);
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), TCP_DISCONNECTION);
+}
+
+/**
+ * @test 버퍼보다 큰 메시지는 실패하고, 코덱은 TCP_CODEC_MAX_LAYERS개까지만 쌓이는지 테스트
+ */
+TEST_F(TcpCodecTest, OversizedMessageAndLayerLimit)
+{
+    initCodecPipe(pstReceiver.get(), aiSockPair[1], vecBuffer.data(), 64);
+    ASSERT_EQ(pushCodecLayer(pstSender.get(), getFrameCodec(), NULL), 0);
+    ASSERT_EQ(pushCodecLayer(pstReceiver.get(), getFrameCodec(), NULL), 0);
+    ASSERT_EQ(queue(std::string(100, 'x')), 0);
+    ASSERT_EQ(flushCodecPipe(pstSender.get()), 0);
+    TcpCodecMsg stMsg;
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), -1);
+
+    for (int i = 1; i < TCP_CODEC_MAX_LAYERS; i++) {
+        ASSERT_EQ(pushCodecLayer(pstSender.get(), getFrameCodec(), NULL), i);
+    }
+    ASSERT_EQ(pushCodecLayer(pstSender.get(), getFrameCodec(), NULL), -1);
+}
+
+/**
+ * @test RESP 코덱이 파이프라인으로 도착한 값을 하나씩 나누고, 인코딩된 명령은 그대로 보내는지 테스트
+ */
+TEST_F(TcpCodecTest, RespCodecSplitsValues)
+{
+    TcpRespValue astValues[8];
+    TcpRespCodecState stState;
+    stState.pstValues = astValues;
+    stState.iMaxValues = 8;
+    ASSERT_EQ(pushCodecLayer(pstSender.get(), getRespCodec(), &stState), 0);
+    ASSERT_EQ(pushCodecLayer(pstReceiver.get(), getRespCodec(), &stState), 0);
+
+    const char *kapchArgv[] = { "GET", "key" };
+    const size_t auiLengths[] = { 3, 3 };
+    char achCommand[64];
+    int iCommand = encodeRespCommand(achCommand, sizeof(achCommand), 2, kapchArgv, auiLengths);
+    ASSERT_EQ(queue(std::string(achCommand, (size_t)iCommand)), 0);
+    ASSERT_EQ(queue("+OK\r\n:5\r\n"), 0);
+    ASSERT_EQ(flushCodecPipe(pstSender.get()), 0);
+
+    TcpCodecMsg stMsg;
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+    ASSERT_EQ(toString(stMsg), std::string(achCommand, (size_t)iCommand));
+    ASSERT_EQ(stState.iValues, 3);
+    ASSERT_EQ(astValues[0].ucType, TCP_RESP_ARRAY);
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+    ASSERT_EQ(toString(stMsg), "+OK\r\n");
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), 1);
+    ASSERT_EQ(astValues[0].llInteger, 5);
+
+    ASSERT_EQ(write(aiSockPair[0], "?bad\r\n", 6), 6);
+    ASSERT_EQ(recvCodecMessage(pstReceiver.get(), &stMsg), -1);
+}
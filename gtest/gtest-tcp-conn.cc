@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+/**
+ * @brief 연결 테이블 및 적응형 수신 테스트 클래스
+ *
+ * socketpair()로 만든 한 쌍의 스트림 소켓을 사용하여 포트 없이
+ * 수신 크기 조절 동작을 검증합니다.
+ */
+class TcpConnTest : public ::testing::Test
+{
+protected:
+    int aiSockPair[2];
+    void *pvBuffer;
+    size_t uiCapacity;
+
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+        // 직접 close() 된 이전 소켓의 엔트리가 같은 번호로 남아 있을 수 있음
+        ASSERT_NE(registerConnInfo(aiSockPair[0]), nullptr);
+        removeConnInfo(aiSockPair[1]);
+        pvBuffer = NULL;
+        uiCapacity = 0;
+    }
+
+    void TearDown() override {
+        removeConnInfo(aiSockPair[0]);
+        removeConnInfo(aiSockPair[1]);
+        close(aiSockPair[0]);
+        close(aiSockPair[1]);
+        free(pvBuffer);
+    }
+};
+
+
+/**
+ * @test 대량 수신 시 FIONREAD 힌트로 요청 크기가 한 번에 확장되는지 테스트
+ */
+TEST_F(TcpConnTest, GrowsForBulkFlow)
+{
+    char chData[32768];
+    memset(chData, 'a', sizeof(chData));
+    ASSERT_EQ(sendMessage(aiSockPair[1], chData, sizeof(chData)), (int)sizeof(chData));
+
+    int iFirst = recvMsgAdaptive(aiSockPair[0], &pvBuffer, &uiCapacity);
+    ASSERT_EQ(iFirst, TCP_RECV_INIT_SIZE);
+
+    // 남은 데이터는 한 번의 수신으로 모두 읽혀야 함
+    int iSecond = recvMsgAdaptive(aiSockPair[0], &pvBuffer, &uiCapacity);
+    ASSERT_EQ(iFirst + iSecond, (int)sizeof(chData));
+    ASSERT_GE(uiCapacity, sizeof(chData) - TCP_RECV_INIT_SIZE);
+}
+
+/**
+ * @test 소량 송수신이 반복되면 요청 크기와 버퍼가 최소 클래스로 줄어드는지 테스트
+ */
+TEST_F(TcpConnTest, ShrinksForChattyFlow)
+{
+    const char *kpchMsg = "ping";
+
+    for (int i = 0; i < 16; i++) {
+        ASSERT_EQ(sendMessage(aiSockPair[1], kpchMsg, strlen(kpchMsg)), (int)strlen(kpchMsg));
+        ASSERT_EQ(recvMsgAdaptive(aiSockPair[0], &pvBuffer, &uiCapacity), (int)strlen(kpchMsg));
+    }
+
+    ASSERT_EQ(getAdaptiveRecvSize(aiSockPair[0]), (size_t)TCP_RECV_MIN_SIZE);
+    ASSERT_LT(uiCapacity, (size_t)TCP_RECV_INIT_SIZE);
+}
+
+/**
+ * @test 몰린 수신으로 키운 버퍼가 유예 시간 동안은 유지되고, 그 뒤 소량 수신에서 반환되는지 테스트
+ */
+TEST_F(TcpConnTest, ReleasesBufferAfterBurst)
+{
+    char chData[32768];
+    const char *kpchMsg = "ping";
+
+    memset(chData, 'a', sizeof(chData));
+    ASSERT_EQ(sendMessage(aiSockPair[1], chData, sizeof(chData)), (int)sizeof(chData));
+    for (int iTotal = 0; iTotal < (int)sizeof(chData);) {
+        int iReceived = recvMsgAdaptive(aiSockPair[0], &pvBuffer, &uiCapacity);
+        ASSERT_GT(iReceived, 0);
+        iTotal += iReceived;
+    }
+    size_t uiGrown = uiCapacity;
+    ASSERT_GE(uiGrown, sizeof(chData) / 2);
+
+    // 유예 시간 안의 소량 수신에서는 버퍼를 유지
+    for (int i = 0; i < 16; i++) {
+        ASSERT_EQ(sendMessage(aiSockPair[1], kpchMsg, strlen(kpchMsg)), (int)strlen(kpchMsg));
+        ASSERT_EQ(recvMsgAdaptive(aiSockPair[0], &pvBuffer, &uiCapacity), (int)strlen(kpchMsg));
+    }
+    ASSERT_EQ(uiCapacity, uiGrown);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    ASSERT_EQ(sendMessage(aiSockPair[1], kpchMsg, strlen(kpchMsg)), (int)strlen(kpchMsg));
+    ASSERT_EQ(recvMsgAdaptive(aiSockPair[0], &pvBuffer, &uiCapacity), (int)strlen(kpchMsg));
+    ASSERT_LT(uiCapacity, (size_t)TCP_RECV_INIT_SIZE);
+}
+
+/**
+ * @test 등록되지 않은 소켓의 적응형 수신이 연결 테이블 엔트리를 만들지 않는지 테스트
+ */
+TEST_F(TcpConnTest, UnregisteredSocketIsNotTracked)
+{
+    const char *kpchMsg = "ping";
+    long long llOpen = getMetricGauge(TCP_GAUGE_OPEN_CONNECTIONS);
+
+    ASSERT_EQ(sendMessage(aiSockPair[0], kpchMsg, strlen(kpchMsg)), (int)strlen(kpchMsg));
+    ASSERT_EQ(recvMsgAdaptive(aiSockPair[1], &pvBuffer, &uiCapacity), (int)strlen(kpchMsg));
+
+    ASSERT_EQ(findConnInfo(aiSockPair[1]), nullptr);
+    ASSERT_EQ(getMetricGauge(TCP_GAUGE_OPEN_CONNECTIONS), llOpen);
+    ASSERT_EQ(uiCapacity, (size_t)TCP_RECV_INIT_SIZE);
+}
+
+/**
+ * @test 연결 종료 감지 및 연결 테이블 엔트리 제거 테스트
+ */
+TEST_F(TcpConnTest, DisconnectionResetsHistory)
+{
+    const char *kpchMsg = "ping";
+    for (int i = 0; i < 4; i++) {
+        sendMessage(aiSockPair[1], kpchMsg, strlen(kpchMsg));
+        recvMsgAdaptive(aiSockPair[0], &pvBuffer, &uiCapacity);
+    }
+    ASSERT_LT(getAdaptiveRecvSize(aiSockPair[0]), (size_t)TCP_RECV_INIT_SIZE);
+
+    shutdown(aiSockPair[1], SHUT_WR);
+    ASSERT_EQ(recvMsgAdaptive(aiSockPair[0], &pvBuffer, &uiCapacity), TCP_DISCONNECTION);
+
+    removeConnInfo(aiSockPair[0]);
+    ASSERT_EQ(getAdaptiveRecvSize(aiSockPair[0]), (size_t)TCP_RECV_INIT_SIZE);
+}
+
+/**
+ * @test 등록과 제거가 반복되는 동안 다른 스레드의 테이블 스캔이 지운 엔트리를 돌려주지 않는지 테스트
+ */
+TEST_F(TcpConnTest, ScanSkipsEntriesBeingRemoved)
+{
+    std::atomic<bool> bStop{false};
+    std::thread thChurn([&]() {
+        while (!bStop) {
+            registerConnInfo(aiSockPair[1]);
+            removeConnInfo(aiSockPair[1]);
+        }
+    });
+
+    TcpConnStats astStats[64];
+    int iBadRows = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while (std::chrono::steady_clock::now() < deadline) {
+        int iCount = snapshotConnTable(astStats, 64);
+        for (int i = 0; i < iCount; i++) {
+            iBadRows += (astStats[i].iSock < 0);
+        }
+    }
+    bStop = true;
+    thChurn.join();
+    ASSERT_EQ(iBadRows, 0);
+}
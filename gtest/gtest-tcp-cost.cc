@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-cost.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <thread>
+
+#define COST_TEST_FD_BASE       200000
+#define COST_TEST_LIGHT_CONNS   (TCP_COST_TOPN_SLOTS * 4)
+
+
+/**
+ * @test 송수신 비용이 연결 통계에 누적되는지 테스트
+ */
+TEST(TcpCostTest, AccountsSendRecv)
+{
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+    registerConnInfo(aiSockPair[0]);
+    registerConnInfo(aiSockPair[1]);
+
+    char achBuffer[64];
+    memset(achBuffer, 'c', sizeof(achBuffer));
+
+    // 꺼져 있으면 기록하지 않음
+    ASSERT_EQ(beginConnCost(), 0ULL);
+    ASSERT_EQ(sendMessage(aiSockPair[0], achBuffer, sizeof(achBuffer)), (int)sizeof(achBuffer));
+    ASSERT_EQ(findConnStats(aiSockPair[0])->aullCostCycles[TCP_COST_SEND], 0ULL);
+
+    setConnCostAccounting(1);
+    ASSERT_EQ(recvMsgBlocking(aiSockPair[1], achBuffer, sizeof(achBuffer)), (int)sizeof(achBuffer));
+    ASSERT_EQ(sendMessage(aiSockPair[0], achBuffer, sizeof(achBuffer)), (int)sizeof(achBuffer));
+    unsigned long long ullStart = beginConnCost();
+    endConnCost(aiSockPair[1], TCP_COST_HANDLER, ullStart);
+    setConnCostAccounting(0);
+
+    ASSERT_GT(findConnStats(aiSockPair[0])->aullCostCycles[TCP_COST_SEND], 0ULL);
+    ASSERT_GT(findConnStats(aiSockPair[1])->aullCostCycles[TCP_COST_RECV], 0ULL);
+    ASSERT_EQ(findConnStats(aiSockPair[1])->aullCostCycles[TCP_COST_SEND], 0ULL);
+
+    removeConnInfo(aiSockPair[0]);
+    removeConnInfo(aiSockPair[1]);
+    close(aiSockPair[0]);
+    close(aiSockPair[1]);
+}
+
+/**
+ * @test 슬롯 수보다 많은 연결 중 비용이 큰 연결이 상위에 남는지 테스트
+ *
+ * 소켓 없이 연결 테이블에 번호만 등록하고, 가벼운 연결 사이사이에 무거운 연결의 비용을
+ * 기록한 뒤 상위 N 보고의 순서와 오차 범위를 확인합니다.
+ */
+TEST(TcpCostTest, TopNHeavyHitters)
+{
+    const int kiHeavy = COST_TEST_FD_BASE + COST_TEST_LIGHT_CONNS;
+    const int kiMedium = kiHeavy + 1;
+
+    for (int i = 0; i <= COST_TEST_LIGHT_CONNS + 1; i++) {
+        registerConnInfo(COST_TEST_FD_BASE + i);
+    }
+
+    setConnCostAccounting(1);
+    resetConnCostTopN();
+    for (int i = 0; i < COST_TEST_LIGHT_CONNS; i++) {
+        endConnCost(COST_TEST_FD_BASE + i, TCP_COST_HANDLER, getCycleCount() - 10);
+        endConnCost(kiHeavy, TCP_COST_HANDLER, getCycleCount() - 10000);
+        if (i % 2 == 0) {
+            endConnCost(kiMedium, TCP_COST_HANDLER, getCycleCount() - 1000);
+        }
+    }
+    setConnCostAccounting(0);
+
+    TcpCostEntry astTop[3];
+    ASSERT_EQ(getConnCostTopN(astTop, 3), 3);
+    ASSERT_EQ(astTop[0].iSock, kiHeavy);
+    ASSERT_EQ(astTop[1].iSock, kiMedium);
+
+    // space-saving 추정치는 실제 값 이상이며 오차만큼만 과대
+    unsigned long long ullActual = findConnStats(kiHeavy)->aullCostCycles[TCP_COST_HANDLER];
+    ASSERT_GE(astTop[0].ullCycles, ullActual);
+    ASSERT_LE(astTop[0].ullCycles - astTop[0].ullError, ullActual);
+
+    for (int i = 0; i <= COST_TEST_LIGHT_CONNS + 1; i++) {
+        removeConnInfo(COST_TEST_FD_BASE + i);
+    }
+    resetConnCostTopN();
+}
+
+/**
+ * @test 종료한 스레드의 스케치 값이 상위 N 보고에 남는지 테스트
+ *
+ * 스레드를 차례로 실행하여 같은 연결의 비용을 기록하고, 스레드가 모두 종료한 뒤에도
+ * 보고된 비용이 연결 통계의 누적 비용과 같은지 확인합니다.
+ */
+TEST(TcpCostTest, FoldsExitedThreads)
+{
+    const int kiSock = COST_TEST_FD_BASE;
+
+    registerConnInfo(kiSock);
+    setConnCostAccounting(1);
+    resetConnCostTopN();
+    for (int i = 0; i < 16; i++) {
+        std::thread worker([kiSock]() {
+            endConnCost(kiSock, TCP_COST_HANDLER, getCycleCount() - 1000);
+        });
+        worker.join();
+    }
+    setConnCostAccounting(0);
+
+    TcpCostEntry astTop[1];
+    ASSERT_EQ(getConnCostTopN(astTop, 1), 1);
+    ASSERT_EQ(astTop[0].iSock, kiSock);
+    ASSERT_EQ(astTop[0].ullCycles, findConnStats(kiSock)->aullCostCycles[TCP_COST_HANDLER]);
+    ASSERT_EQ(astTop[0].ullError, 0ULL);
+
+    removeConnInfo(kiSock);
+    resetConnCostTopN();
+}
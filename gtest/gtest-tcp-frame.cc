@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-frame.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <string>
+
+
+/**
+ * @brief 프레이밍 테스트 클래스
+ *
+ * socketpair()로 만든 스트림 소켓 쌍에서 프레임 송수신을 검증합니다.
+ */
+class TcpFrameTest : public ::testing::Test
+{
+protected:
+    int aiSockPair[2];
+
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+    }
+
+    void TearDown() override {
+        close(aiSockPair[0]);
+        close(aiSockPair[1]);
+    }
+};
+
+
+/**
+ * @test 추적 컨텍스트 없이 프레임 여러 개를 연속으로 송수신하는지 테스트
+ */
+TEST_F(TcpFrameTest, SendAndReceiveFrames)
+{
+    const char *kpchFirst = "first frame";
+    const char *kpchSecond = "second";
+    ASSERT_EQ(sendFrame(aiSockPair[1], kpchFirst, strlen(kpchFirst), NULL), (int)strlen(kpchFirst));
+    ASSERT_EQ(sendFrame(aiSockPair[1], kpchSecond, strlen(kpchSecond), NULL), (int)strlen(kpchSecond));
+    ASSERT_EQ(sendFrame(aiSockPair[1], NULL, 0, NULL), 0);
+
+    char chBuffer[64];
+    TcpFrameHeader stHeader;
+    int iLength = recvFrame(aiSockPair[0], chBuffer, sizeof(chBuffer), &stHeader);
+    ASSERT_EQ(iLength, (int)strlen(kpchFirst));
+    ASSERT_EQ(std::string(chBuffer, stHeader.uiPayloadLength), kpchFirst);
+    ASSERT_EQ(stHeader.ucFlags & TCP_FRAME_FLAG_TRACE, 0);
+
+    iLength = recvFrame(aiSockPair[0], chBuffer, sizeof(chBuffer), &stHeader);
+    ASSERT_EQ(std::string(chBuffer, iLength), kpchSecond);
+
+    // 빈 프레임은 0, 연결 종료는 TCP_FRAME_CLOSED로 구분됨
+    ASSERT_EQ(recvFrame(aiSockPair[0], chBuffer, sizeof(chBuffer), &stHeader), 0);
+    ASSERT_EQ(stHeader.uiPayloadLength, 0U);
+
+    close(aiSockPair[1]);
+    ASSERT_EQ(recvFrame(aiSockPair[0], chBuffer, sizeof(chBuffer), NULL), TCP_FRAME_CLOSED);
+}
+
+/**
+ * @test 추적 컨텍스트가 프레임 헤더를 통해 그대로 전달되는지 테스트
+ */
+TEST_F(TcpFrameTest, PropagatesTraceContext)
+{
+    TcpTraceContext stTrace;
+    memset(&stTrace, 0, sizeof(stTrace));
+    for (int i = 0; i < TCP_TRACE_ID_SIZE; i++) {
+        stTrace.aucTraceId[i] = (unsigned char)i;
+    }
+    stTrace.aucSpanId[0] = 0xAB;
+    stTrace.ucFlags = 0;
+
+    ASSERT_EQ(sendFrame(aiSockPair[1], "payload", 7, &stTrace), 7);
+
+    char chBuffer[16];
+    TcpFrameHeader stHeader;
+    ASSERT_EQ(recvFrame(aiSockPair[0], chBuffer, sizeof(chBuffer), &stHeader), 7);
+    ASSERT_EQ(stHeader.uiHeaderLength, (unsigned int)TCP_FRAME_MAX_HEADER);
+    ASSERT_TRUE(stHeader.ucFlags & TCP_FRAME_FLAG_TRACE);
+    ASSERT_EQ(memcmp(stHeader.stTrace.aucTraceId, stTrace.aucTraceId, TCP_TRACE_ID_SIZE), 0);
+    ASSERT_EQ(stHeader.stTrace.aucSpanId[0], 0xAB);
+}
+
+/**
+ * @test 불완전/잘못된 헤더 해석 및 버퍼 초과 페이로드 처리 테스트
+ */
+TEST_F(TcpFrameTest, RejectsInvalidFrames)
+{
+    unsigned char aucHeader[TCP_FRAME_MAX_HEADER];
+    TcpFrameHeader stHeader;
+
+    ASSERT_EQ(encodeFrameHeader(aucHeader, 100, NULL), TCP_FRAME_HEADER_SIZE);
+    ASSERT_EQ(parseFrameHeader(aucHeader, TCP_FRAME_HEADER_SIZE - 1, &stHeader), 0);
+    ASSERT_EQ(parseFrameHeader(aucHeader, TCP_FRAME_HEADER_SIZE, &stHeader), TCP_FRAME_HEADER_SIZE);
+    ASSERT_EQ(stHeader.uiPayloadLength, 100u);
+
+    aucHeader[4] = 0x80;
+    ASSERT_EQ(parseFrameHeader(aucHeader, TCP_FRAME_HEADER_SIZE, &stHeader), -1);
+    ASSERT_EQ(encodeFrameHeader(aucHeader, TCP_FRAME_MAX_PAYLOAD + 1, NULL), -1);
+
+    char chPayload[32] = {0};
+    char chSmall[8];
+    ASSERT_EQ(sendFrame(aiSockPair[1], chPayload, sizeof(chPayload), NULL), (int)sizeof(chPayload));
+    ASSERT_EQ(recvFrame(aiSockPair[0], chSmall, sizeof(chSmall), NULL), -1);
+}
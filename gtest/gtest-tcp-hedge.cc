@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-frame.h"
+#include "tcp-hedge.h"
+#include "tcp-metrics.h"
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define HEDGE_TEST_PORT     12406
+
+
+/**
+ * @brief 받은 프레임을 정해진 지연 뒤 그대로 돌려주는 대역 백엔드
+ *
+ * m_bHeaderOnly이면 응답 헤더만 보내고 페이로드 없이 멈춥니다.
+ */
+class EchoBackend
+{
+public:
+    int start(int iPort)
+    {
+        m_iListen = createServerSocket(iPort, 64);
+        if (m_iListen < 0) {
+            return -1;
+        }
+        m_thAccept = std::thread(&EchoBackend::acceptLoop, this);
+        return 0;
+    }
+
+    void stop()
+    {
+        m_bStop = true;
+        if (m_thAccept.joinable()) {
+            m_thAccept.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mtxConns);
+            for (int iSock : m_vecConns) {
+                shutdown(iSock, SHUT_RDWR);
+            }
+        }
+        for (std::thread &thConn : m_vecThreads) {
+            thConn.join();
+        }
+        if (m_iListen >= 0) {
+            close(m_iListen);
+        }
+    }
+
+    std::atomic<int> m_iDelayMsec{0};
+    std::atomic<bool> m_bHeaderOnly{false};
+
+private:
+    void acceptLoop()
+    {
+        while (!m_bStop) {
+            struct pollfd stFd = { m_iListen, POLLIN, 0 };
+            if (poll(&stFd, 1, 10) <= 0) {
+                continue;
+            }
+            int iSock = accept(m_iListen, NULL, NULL);
+            if (iSock < 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(m_mtxConns);
+            m_vecConns.push_back(iSock);
+            m_vecThreads.emplace_back(&EchoBackend::serveConn, this, iSock);
+        }
+    }
+
+    void serveConn(int iSock)
+    {
+        char achBuffer[256];
+        unsigned char aucHeader[TCP_FRAME_MAX_HEADER];
+        TcpFrameHeader stHeader;
+
+        int iLength;
+
+        while ((iLength = recvFrame(iSock, achBuffer, sizeof(achBuffer), &stHeader)) >= 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_iDelayMsec.load()));
+            // 취소된 요청의 연결은 이미 닫혔을 수 있으므로 SIGPIPE 없이 보냄
+            int iHeader = encodeFrameHeader(aucHeader, (size_t)iLength, NULL);
+            if (send(iSock, aucHeader, (size_t)iHeader, MSG_NOSIGNAL) != iHeader
+                || (!m_bHeaderOnly && send(iSock, achBuffer, (size_t)iLength, MSG_NOSIGNAL) != iLength)) {
+                break;
+            }
+        }
+        close(iSock);
+    }
+
+    int m_iListen = -1;
+    std::atomic<bool> m_bStop{false};
+    std::thread m_thAccept;
+    std::mutex m_mtxConns;
+    std::vector<int> m_vecConns;
+    std::vector<std::thread> m_vecThreads;
+};
+
+/**
+ * @brief 느린 백엔드(0번)와 빠른 백엔드(1번)를 둔 테스트 픽스처
+ */
+class TcpHedgeTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        for (int i = 0; i < 2; i++) {
+            if (isPortAvailable(HEDGE_TEST_PORT + i) != 0) {
+                GTEST_SKIP() << "port " << HEDGE_TEST_PORT + i << " in use";
+            }
+        }
+        for (int i = 0; i < 2; i++) {
+            ASSERT_EQ(m_astBackends[i].start(HEDGE_TEST_PORT + i), 0);
+            m_iStarted++;
+        }
+        m_astBackends[0].m_iDelayMsec = 60;
+
+        TcpOutlierConfig stOutlier;
+        memset(&stOutlier, 0, sizeof(stOutlier));
+        stOutlier.uiMinRequests = 5;
+        initBalancer(&s_stBalancer, TCP_BALANCE_P2C_INFLIGHT);
+        setOutlierConfig(&s_stBalancer, &stOutlier);
+        for (int i = 0; i < 2; i++) {
+            std::string strEndpoint = "127.0.0.1:" + std::to_string(HEDGE_TEST_PORT + i);
+            ASSERT_EQ(addBackend(&s_stBalancer, strEndpoint.c_str()), i);
+        }
+        for (int i = 0; m_astrKeys[0].empty() || m_astrKeys[1].empty(); i++) {
+            std::string strKey = "item:" + std::to_string(i);
+            int iBackend = lookupBackend(&s_stBalancer, strKey.data(), strKey.size());
+            if (m_astrKeys[iBackend].empty()) {
+                m_astrKeys[iBackend] = strKey;
+            }
+        }
+
+        TcpHedgeConfig stConfig;
+        memset(&stConfig, 0, sizeof(stConfig));
+        stConfig.uiDefaultDelayUsec = 5000;
+        initHedgeBudget(&s_stBudget, 10, 1);
+        ASSERT_EQ(initHedgeClient(&m_stClient, &s_stBalancer, &s_stBudget, &stConfig), 0);
+        m_iReady = 1;
+    }
+
+    void TearDown() override
+    {
+        if (m_iReady) {
+            destroyHedgeClient(&m_stClient);
+            destroyBalancer(&s_stBalancer);
+        }
+        for (int i = 0; i < m_iStarted; i++) {
+            m_astBackends[i].stop();
+        }
+    }
+
+    // 백엔드에 배정된 키로 중복 요청을 보내고 걸린 시간(ms)을 돌려줌
+    long long request(int iBackend, int iTimeoutMsec, int *piResult, int *piHedged)
+    {
+        char achResponse[64];
+        auto start = std::chrono::steady_clock::now();
+        *piResult = sendHedgedRequest(&m_stClient, m_astrKeys[iBackend].data(), m_astrKeys[iBackend].size(),
+                                      "GET item", 8, achResponse, sizeof(achResponse), iTimeoutMsec, piHedged);
+        if (*piResult == 8) {
+            EXPECT_EQ(memcmp(achResponse, "GET item", 8), 0);
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static TcpBalancer s_stBalancer;
+    static TcpHedgeBudget s_stBudget;
+    TcpHedgeClient m_stClient;
+    EchoBackend m_astBackends[2];
+    std::string m_astrKeys[2];
+    int m_iStarted = 0;
+    int m_iReady = 0;
+};
+
+TcpBalancer TcpHedgeTest::s_stBalancer;
+TcpHedgeBudget TcpHedgeTest::s_stBudget;
+
+/**
+ * @test 느린 백엔드의 요청이 중복 요청으로 빨리 끝나고 늦은 요청은 취소되는지 테스트
+ */
+TEST_F(TcpHedgeTest, HedgeWinsAgainstSlowBackend)
+{
+    int iResult;
+    int iHedged;
+    unsigned long long ullHedges = getMetricCounter(TCP_COUNTER_HEDGES);
+    unsigned long long ullWins = getMetricCounter(TCP_COUNTER_HEDGE_WINS);
+
+    long long llElapsed = request(0, 0, &iResult, &iHedged);
+    ASSERT_EQ(iResult, 8);
+    ASSERT_EQ(iHedged, 2);
+    ASSERT_LT(llElapsed, 40);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_HEDGES), ullHedges + 1);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_HEDGE_WINS), ullWins + 1);
+
+    // 늦은 요청의 연결은 닫히고, 이긴 연결만 풀로 돌아감
+    ASSERT_EQ(s_stBalancer.astBackends[0].uiInFlight, 0U);
+    ASSERT_EQ(s_stBalancer.astBackends[0].iIdle, 0);
+    ASSERT_EQ(s_stBalancer.astBackends[0].ullFailures, 0ULL);
+    ASSERT_EQ(s_stBalancer.astBackends[1].iIdle, 1);
+
+    // 빠른 백엔드는 중복 요청 없이 응답
+    llElapsed = request(1, 0, &iResult, &iHedged);
+    ASSERT_EQ(iResult, 8);
+    ASSERT_EQ(iHedged, 0);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_HEDGES), ullHedges + 1);
+}
+
+/**
+ * @test 예산이 바닥나면 중복 요청 없이 기다리고, 제한 시간이 지나면 실패하는지 테스트
+ */
+TEST_F(TcpHedgeTest, BudgetCapsHedgesAndTimeoutFails)
+{
+    int iResult;
+    int iHedged;
+    unsigned long long ullDenied = getMetricCounter(TCP_COUNTER_HEDGE_DENIED);
+
+    request(0, 0, &iResult, &iHedged);
+    ASSERT_EQ(iHedged, 2);
+
+    // 요청 하나당 토큰 0.1개이므로 다음 중복 요청까지 여러 요청이 필요
+    long long llElapsed = request(0, 0, &iResult, &iHedged);
+    ASSERT_EQ(iResult, 8);
+    ASSERT_EQ(iHedged, 0);
+    ASSERT_GE(llElapsed, 50);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_HEDGE_DENIED), ullDenied + 1);
+
+    llElapsed = request(0, 20, &iResult, &iHedged);
+    ASSERT_EQ(iResult, -1);
+    ASSERT_LT(llElapsed, 50);
+    ASSERT_EQ(s_stBalancer.astBackends[0].uiInFlight, 0U);
+    ASSERT_EQ(s_stBalancer.astBackends[0].ullFailures, 1ULL);
+}
+
+/**
+ * @test 중복 요청 시점이 백엔드의 최근 지연 백분위를 따르는지 테스트
+ *
+ * 요청이 늘 30ms 이상 걸리던 백엔드는 기본 대기 시간(5ms)보다 늦어도 중복 요청하지 않습니다.
+ */
+TEST_F(TcpHedgeTest, ThresholdAdaptsToBackendLatency)
+{
+    TcpBalanceConn stConn;
+    int iResult;
+    int iHedged;
+
+    m_astBackends[0].m_iDelayMsec = 10;
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(acquireBackendConn(&s_stBalancer, m_astrKeys[0].data(), m_astrKeys[0].size(), &stConn), 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        releaseBackendConn(&s_stBalancer, &stConn, 0);
+    }
+    ASSERT_GE(getBackendLatency(&s_stBalancer, 0, 95.0), 30ULL * 1000000ULL);
+
+    request(0, 0, &iResult, &iHedged);
+    ASSERT_EQ(iResult, 8);
+    ASSERT_EQ(iHedged, 0);
+
+    // 평가 구간이 바뀌어도 직전 구간의 지연을 씀
+    checkBackendHealth(&s_stBalancer);
+    ASSERT_GE(getBackendLatency(&s_stBalancer, 0, 95.0), 30ULL * 1000000ULL);
+}
+
+/**
+ * @test 백엔드가 응답 헤더만 보내고 멈춰도 중복 요청과 제한 시간이 제때 처리되는지 테스트
+ */
+TEST_F(TcpHedgeTest, StalledPartialResponseDoesNotBlock)
+{
+    int iResult;
+    int iHedged;
+
+    m_astBackends[0].m_iDelayMsec = 0;
+    m_astBackends[0].m_bHeaderOnly = true;
+
+    // 헤더만 받은 첫 요청을 기다리지 않고 중복 요청의 응답을 씀
+    long long llElapsed = request(0, 0, &iResult, &iHedged);
+    ASSERT_EQ(iResult, 8);
+    ASSERT_EQ(iHedged, 2);
+    ASSERT_LT(llElapsed, 40);
+
+    // 예산이 바닥나 중복 요청을 못 해도 제한 시간에 끝남
+    llElapsed = request(0, 30, &iResult, &iHedged);
+    ASSERT_EQ(iResult, -1);
+    ASSERT_EQ(iHedged, 0);
+    ASSERT_GE(llElapsed, 30);
+    ASSERT_LT(llElapsed, 200);
+    ASSERT_EQ(s_stBalancer.astBackends[0].uiInFlight, 0U);
+}
@@ -0,0 +1,333 @@
+#include <gtest/gtest.h>
+#include "tcp-http.h"
+#include "tcp-sock.h"
+#include <thread>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static std::string toString(const TcpHttpStr &stStr)
+{
+    return std::string(stStr.kpchData, stStr.uiLength);
+}
+
+
+/**
+ * @brief HTTP 코덱 테스트 클래스
+ *
+ * socketpair()의 한쪽을 서버(코덱), 다른 쪽을 직접 요청을 쓰는 클라이언트로 사용합니다.
+ */
+class TcpHttpTest : public ::testing::Test
+{
+protected:
+    int aiSockPair[2];
+    std::vector<char> vecBuffer;
+    TcpHttpConn stConn;
+
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+        vecBuffer.resize(4096);
+        initHttpConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+    }
+
+    void TearDown() override {
+        close(aiSockPair[0]);
+        close(aiSockPair[1]);
+    }
+
+    void writeClient(const std::string &strData) {
+        ASSERT_EQ(write(aiSockPair[1], strData.data(), strData.size()), (ssize_t)strData.size());
+    }
+
+    std::string readClient(size_t uiLength) {
+        std::string strData(uiLength, '\0');
+        size_t uiDone = 0;
+        while (uiDone < uiLength) {
+            ssize_t received = read(aiSockPair[1], &strData[uiDone], uiLength - uiDone);
+            if (received <= 0) {
+                break;
+            }
+            uiDone += (size_t)received;
+        }
+        strData.resize(uiDone);
+        return strData;
+    }
+
+    // 빈 줄까지의 응답 헤더와 Content-Length 만큼의 본문
+    std::string readResponse() {
+        std::string strResponse;
+        while (strResponse.find("\r\n\r\n") == std::string::npos) {
+            std::string strByte = readClient(1);
+            if (strByte.empty()) {
+                return strResponse;
+            }
+            strResponse += strByte;
+        }
+        size_t uiLength = strResponse.find("Content-Length: ");
+        if (uiLength != std::string::npos) {
+            strResponse += readClient((size_t)atoi(strResponse.c_str() + uiLength + 16));
+        }
+        return strResponse;
+    }
+};
+
+
+/**
+ * @test 요청 줄과 헤더가 수신 버퍼를 가리키는 문자열로 해석되는지 테스트
+ */
+TEST(TcpHttpParseTest, ParsesRequestLineAndHeaders)
+{
+    std::string strRequest =
+        "POST /api/v1/items?limit=10 HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "X-Padded:   value with spaces  \t\r\n"
+        "X-Url: http://example.com:8080/path\r\n"
+        "Content-Length: 5\r\n"
+        "\r\n"
+        "hello";
+    TcpHttpRequest stRequest;
+
+    int iHeader = parseHttpRequest(strRequest.data(), strRequest.size(), &stRequest);
+    ASSERT_EQ(iHeader, (int)strRequest.size() - 5);
+    ASSERT_EQ(toString(stRequest.stMethod), "POST");
+    ASSERT_EQ(toString(stRequest.stTarget), "/api/v1/items?limit=10");
+    ASSERT_EQ(stRequest.iMinorVersion, 1);
+    ASSERT_EQ(stRequest.iHeaders, 4);
+    ASSERT_EQ(stRequest.stMethod.kpchData, strRequest.data());
+    ASSERT_EQ(toString(stRequest.astHeaders[1].stName), "X-Padded");
+    ASSERT_EQ(toString(stRequest.astHeaders[1].stValue), "value with spaces");
+    ASSERT_EQ(toString(*findHttpHeader(&stRequest, "x-url")), "http://example.com:8080/path");
+    ASSERT_EQ(findHttpHeader(&stRequest, "Missing"), nullptr);
+    ASSERT_EQ(stRequest.ullContentLength, 5ULL);
+    ASSERT_EQ(stRequest.ucChunked, 0);
+    ASSERT_EQ(stRequest.ucKeepAlive, 1);
+
+    // 요청의 모든 앞부분은 데이터 부족
+    for (size_t i = 0; i < (size_t)iHeader; i++) {
+        ASSERT_EQ(parseHttpRequest(strRequest.data(), i, &stRequest), 0) << "prefix " << i;
+    }
+}
+
+/**
+ * @test 연결 유지 판단과 잘못된 요청 거부를 테스트
+ */
+TEST(TcpHttpParseTest, KeepAliveAndValidation)
+{
+    TcpHttpRequest stRequest;
+    struct {
+        const char *kpchRequest;
+        int iExpected;
+        int iKeepAlive;
+    } astCases[] = {
+        { "GET / HTTP/1.1\r\n\r\n", 18, 1 },
+        { "GET / HTTP/1.1\r\nConnection: close\r\n\r\n", 37, 0 },
+        { "GET / HTTP/1.0\r\n\r\n", 18, 0 },
+        { "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n", 42, 1 },
+        { "GET / HTTP/1.1\n\n", 16, 1 },
+        { "\r\nGET / HTTP/1.1\r\n\r\n", 20, 1 },
+        { "GET / HTTP/2.0\r\n\r\n", -1, 0 },
+        { "GET /\r\n\r\n", -1, 0 },
+        { "GET  HTTP/1.1\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nBad Name: x\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nName : x\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\n: x\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nA: b\r\n folded\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nA: b\rc\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nA: b\x01\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nContent-Length: 1\r\nTransfer-Encoding: chunked\r\n\r\n", -1, 0 },
+        { "GET / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", -1, 0 },
+    };
+
+    for (size_t i = 0; i < sizeof(astCases) / sizeof(astCases[0]); i++) {
+        const char *kpchRequest = astCases[i].kpchRequest;
+        int iResult = parseHttpRequest(kpchRequest, strlen(kpchRequest), &stRequest);
+        ASSERT_EQ(iResult, astCases[i].iExpected) << kpchRequest;
+        if (iResult > 0) {
+            ASSERT_EQ(stRequest.ucKeepAlive, astCases[i].iKeepAlive) << kpchRequest;
+        }
+    }
+
+    std::string strMany = "GET / HTTP/1.1\r\n";
+    for (int i = 0; i <= TCP_HTTP_MAX_HEADERS; i++) {
+        strMany += "X-" + std::to_string(i) + ": v\r\n";
+    }
+    strMany += "\r\n";
+    ASSERT_EQ(parseHttpRequest(strMany.data(), strMany.size(), &stRequest), TCP_HTTP_ERR_TOO_MANY_HEADERS);
+}
+
+/**
+ * @test 벡터 단위 경계 곳곳에 놓인 구분자, 공백과 제어 문자를 바이트 단위와 같게 찾는지 테스트
+ */
+TEST(TcpHttpParseTest, DelimiterScanAcrossVectorBoundaries)
+{
+    TcpHttpRequest stRequest;
+
+    for (size_t uiName = 1; uiName < 80; uiName++) {
+        for (size_t uiValue = 0; uiValue < 80; uiValue += 3) {
+            std::string strName(uiName, 'n');
+            std::string strValue(uiValue, 'v');
+            std::string strRequest = "GET / HTTP/1.1\r\n" + strName + ": " + strValue + "\r\n\r\n";
+            ASSERT_EQ(parseHttpRequest(strRequest.data(), strRequest.size(), &stRequest), (int)strRequest.size());
+            ASSERT_EQ(stRequest.astHeaders[0].stName.uiLength, uiName);
+            ASSERT_EQ(stRequest.astHeaders[0].stValue.uiLength, uiValue);
+
+            // 이름 안의 공백은 거부됨
+            std::string strSpace = strRequest;
+            strSpace[16 + uiName / 2] = ' ';
+            ASSERT_EQ(parseHttpRequest(strSpace.data(), strSpace.size(), &stRequest), -1) << uiName;
+
+            // 값 안의 탭과 상위 비트 문자는 허용되고, 제어 문자는 어디에 있어도 거부됨
+            if (uiValue > 0) {
+                std::string strTab = strRequest;
+                strTab[16 + uiName + 2 + uiValue / 2] = '\t';
+                strTab[16 + uiName + 2 + uiValue - 1] = (char)0xc3;
+                ASSERT_GT(parseHttpRequest(strTab.data(), strTab.size(), &stRequest), 0);
+
+                std::string strBad = strRequest;
+                strBad[16 + uiName + 2 + uiValue / 2] = 0x7f;
+                ASSERT_EQ(parseHttpRequest(strBad.data(), strBad.size(), &stRequest), -1) << uiName << " " << uiValue;
+            }
+        }
+    }
+}
+
+/**
+ * @test 한 번에 도착한 파이프라인 요청들을 순서대로 본문까지 돌려주는지 테스트
+ */
+TEST_F(TcpHttpTest, PipelinedKeepAlive)
+{
+    writeClient("GET /health HTTP/1.1\r\nHost: a\r\n\r\n"
+                "POST /echo HTTP/1.1\r\nContent-Length: 11\r\n\r\nhello world"
+                "POST /chunks HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                "5;name=value\r\nhello\r\n1\r\n,\r\n6\r\n world\r\n0\r\nX-Trailer: t\r\n\r\n"
+                "GET /last HTTP/1.1\r\nConnection: close\r\n\r\n");
+
+    TcpHttpRequest stRequest;
+    const char *kpchExpected[][2] = {
+        { "/health", "" }, { "/echo", "hello world" }, { "/chunks", "hello, world" }, { "/last", "" },
+    };
+    for (int i = 0; i < 4; i++) {
+        ASSERT_GT(recvHttpRequest(&stConn, &stRequest), 0);
+        ASSERT_EQ(toString(stRequest.stTarget), kpchExpected[i][0]);
+        ASSERT_EQ(toString(stRequest.stBody), kpchExpected[i][1]);
+        ASSERT_EQ(stRequest.ucKeepAlive, i < 3);
+
+        // 본문은 수신 버퍼 안을 가리킴
+        ASSERT_GE(stRequest.stTarget.kpchData, vecBuffer.data());
+        ASSERT_LT(stRequest.stTarget.kpchData, vecBuffer.data() + vecBuffer.size());
+
+        TcpHttpHeader stHeader = { { "X-Index", 7 }, { kpchExpected[i][0], strlen(kpchExpected[i][0]) } };
+        ASSERT_EQ(sendHttpResponse(aiSockPair[0], 200, &stHeader, 1, stRequest.stBody.kpchData,
+                                   stRequest.stBody.uiLength, stRequest.ucKeepAlive ? 0 : TCP_HTTP_CLOSE),
+                  (int)stRequest.stBody.uiLength);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        std::string strResponse = readResponse();
+        std::string strBody = kpchExpected[i][1];
+        std::string strExpected = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(strBody.size()) + "\r\n"
+                                + (i == 3 ? "Connection: close\r\n" : "") + "X-Index: " + kpchExpected[i][0]
+                                + "\r\n\r\n" + strBody;
+        ASSERT_EQ(strResponse, strExpected);
+    }
+}
+
+/**
+ * @test 조금씩 나누어 도착하는 요청과 버퍼 앞쪽으로 당기기가 필요한 본문을 테스트
+ */
+TEST_F(TcpHttpTest, FragmentedRequestsAndCompaction)
+{
+    std::string strBody(3000, 'x');
+    for (size_t i = 0; i < strBody.size(); i++) {
+        strBody[i] = (char)('a' + i % 26);
+    }
+    std::string strChunked;
+    for (size_t i = 0; i < strBody.size(); i += 700) {
+        std::string strPart = strBody.substr(i, 700);
+        char achSize[16];
+        snprintf(achSize, sizeof(achSize), "%zX\r\n", strPart.size());
+        strChunked += achSize + strPart + "\r\n";
+    }
+    std::string strStream = "POST /a HTTP/1.1\r\nContent-Length: 3000\r\n\r\n" + strBody
+                          + "POST /b HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n" + strChunked + "0\r\n\r\n"
+                          + "POST /c HTTP/1.1\r\nContent-Length: 3000\r\n\r\n" + strBody;
+
+    std::thread writer([&]() {
+        for (size_t i = 0; i < strStream.size(); i += 97) {
+            std::string strPiece = strStream.substr(i, 97);
+            if (write(aiSockPair[1], strPiece.data(), strPiece.size()) != (ssize_t)strPiece.size()) {
+                break;
+            }
+            usleep(100);
+        }
+    });
+
+    TcpHttpRequest stRequest;
+    const char *kpchTargets[] = { "/a", "/b", "/c" };
+    for (int i = 0; i < 3; i++) {
+        ASSERT_GT(recvHttpRequest(&stConn, &stRequest), 0);
+        ASSERT_EQ(toString(stRequest.stTarget), kpchTargets[i]);
+        ASSERT_EQ(toString(stRequest.stBody), strBody);
+    }
+    writer.join();
+
+    close(aiSockPair[1]);
+    aiSockPair[1] = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(recvHttpRequest(&stConn, &stRequest), TCP_DISCONNECTION);
+}
+
+/**
+ * @test Expect: 100-continue에 중간 응답을 보내고, 버퍼를 넘는 요청은 413/431로 거부하는지 테스트
+ */
+TEST_F(TcpHttpTest, ContinueAndErrorResponses)
+{
+    TcpHttpRequest stRequest;
+
+    writeClient("PUT /upload HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 4\r\n\r\n");
+    std::thread writer([&]() {
+        std::string strContinue = readResponse();
+        if (strContinue == "HTTP/1.1 100 Continue\r\n\r\n") {
+            writeClient("data");
+        }
+    });
+    ASSERT_GT(recvHttpRequest(&stConn, &stRequest), 0);
+    writer.join();
+    ASSERT_EQ(toString(stRequest.stBody), "data");
+
+    writeClient("POST / HTTP/1.1\r\nContent-Length: 5000\r\n\r\n");
+    ASSERT_EQ(recvHttpRequest(&stConn, &stRequest), -1);
+    ASSERT_EQ(readResponse(), "HTTP/1.1 413 Content Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+
+    initHttpConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+    writeClient("GET / HTTP/1.1\r\nX-Big: " + std::string(5000, 'b') + "\r\n\r\n");
+    ASSERT_EQ(recvHttpRequest(&stConn, &stRequest), -1);
+    ASSERT_EQ(readResponse(),
+              "HTTP/1.1 431 Request Header Fields Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+}
+
+/**
+ * @test chunked 응답과 본문 없는 상태 코드의 응답 형식을 테스트
+ */
+TEST_F(TcpHttpTest, ChunkedAndBodylessResponses)
+{
+    TcpHttpHeader stHeader = { { "Content-Type", 12 }, { "text/plain", 10 } };
+
+    ASSERT_EQ(sendHttpResponse(aiSockPair[0], 200, &stHeader, 1, "first", 5, TCP_HTTP_CHUNKED), 5);
+    ASSERT_EQ(sendHttpChunk(aiSockPair[0], "second chunk!!!!!", 17), 17);
+    ASSERT_EQ(sendHttpChunk(aiSockPair[0], NULL, 0), 0);
+    ASSERT_EQ(sendHttpResponse(aiSockPair[0], 204, NULL, 0, "ignored", 7, TCP_HTTP_CLOSE), 0);
+
+    std::string strExpected = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nContent-Type: text/plain\r\n\r\n"
+                              "5\r\nfirst\r\n11\r\nsecond chunk!!!!!\r\n0\r\n\r\n"
+                              "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+    ASSERT_EQ(readClient(strExpected.size()), strExpected);
+
+    std::vector<TcpHttpHeader> vecHeaders(TCP_HTTP_MAX_RESPONSE_HEADERS + 1, stHeader);
+    ASSERT_EQ(sendHttpResponse(aiSockPair[0], 200, vecHeaders.data(), (int)vecHeaders.size(), NULL, 0, 0), -1);
+}
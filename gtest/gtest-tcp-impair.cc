@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-impair.h"
+#include "tcp-metrics.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+#include <thread>
+
+class TcpImpairTest : public ::testing::Test {
+protected:
+    int aiSockPair[2];
+
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+        registerConnInfo(aiSockPair[0]);
+        registerConnInfo(aiSockPair[1]);
+    }
+
+    void TearDown() override {
+        removeConnInfo(aiSockPair[0]);
+        removeConnInfo(aiSockPair[1]);
+        close(aiSockPair[0]);
+        close(aiSockPair[1]);
+    }
+};
+
+
+/**
+ * @test 설정 문자열 해석 테스트
+ */
+TEST(TcpImpairParseTest, ParseSpec)
+{
+    TcpImpairment stImpair;
+
+    ASSERT_EQ(parseImpairment("delay=200,jitter=50,rate=1000000,write=512,read=256,stall=5:2000,queue=4096",
+                              &stImpair), 0);
+    ASSERT_EQ(stImpair.uiDelayUsec, 200U);
+    ASSERT_EQ(stImpair.uiJitterUsec, 50U);
+    ASSERT_EQ(stImpair.ullRateBytes, 1000000ULL);
+    ASSERT_EQ(stImpair.uiMaxWrite, 512U);
+    ASSERT_EQ(stImpair.uiMaxRead, 256U);
+    ASSERT_EQ(stImpair.uiStallPermille, 5U);
+    ASSERT_EQ(stImpair.uiStallUsec, 2000U);
+    ASSERT_EQ(stImpair.uiQueueLimit, 4096U);
+    ASSERT_EQ(parseImpairment("loss=1", &stImpair), -1);
+    ASSERT_EQ(parseImpairment("delay", &stImpair), -1);
+}
+
+/**
+ * @test 지연과 부분 쓰기/읽기 테스트
+ */
+TEST_F(TcpImpairTest, DelayAndPartialIo)
+{
+    TcpImpairment stImpair;
+    char achBuffer[64];
+
+    ASSERT_EQ(parseImpairment("delay=20000,write=10", &stImpair), 0);
+    ASSERT_EQ(setConnImpairment(aiSockPair[0], &stImpair), 0);
+    ASSERT_EQ(parseImpairment("read=7", &stImpair), 0);
+    ASSERT_EQ(setConnImpairment(aiSockPair[1], &stImpair), 0);
+    ASSERT_EQ(setConnImpairment(-1, &stImpair), -1);
+
+    unsigned long long ullStart = getMonotonicNsec();
+    ASSERT_EQ(sendMessage(aiSockPair[0], "0123456789abcdefghij", 20), 10);
+
+    // sendMessageV는 부분 쓰기를 반복하여 모두 전송
+    struct iovec astIov[2];
+    astIov[0].iov_base = (void *)"klmnopqrst";
+    astIov[0].iov_len = 10;
+    astIov[1].iov_base = (void *)"uvwxy";
+    astIov[1].iov_len = 5;
+    ASSERT_EQ(sendMessageV(aiSockPair[0], astIov, 2), 15);
+
+    char achReceived[32];
+    int iReceived = 0;
+    while (iReceived < 25) {
+        int iRet = recvMsgBlocking(aiSockPair[1], achBuffer, sizeof(achBuffer));
+        ASSERT_GT(iRet, 0);
+        ASSERT_LE(iRet, 7);
+        memcpy(achReceived + iReceived, achBuffer, (size_t)iRet);
+        iReceived += iRet;
+    }
+    ASSERT_GE(getMonotonicNsec() - ullStart, 20000000ULL);
+    ASSERT_EQ(memcmp(achReceived, "0123456789klmnopqrstuvwxy", 25), 0);
+
+    ASSERT_EQ(setConnImpairment(aiSockPair[0], NULL), 0);
+    ASSERT_EQ(setConnImpairment(aiSockPair[1], NULL), 0);
+    ASSERT_EQ(sendMessage(aiSockPair[0], "0123456789abcdefghij", 20), 20);
+}
+
+/**
+ * @test 대역폭 한도와 해제 시 대기열 비우기 테스트
+ */
+TEST_F(TcpImpairTest, RateLimitAndFlush)
+{
+    TcpImpairment stImpair;
+    char achPayload[1000];
+    char achBuffer[4096];
+
+    memset(achPayload, 'r', sizeof(achPayload));
+    ASSERT_EQ(parseImpairment("rate=100000", &stImpair), 0);
+    ASSERT_EQ(setConnImpairment(aiSockPair[0], &stImpair), 0);
+
+    unsigned long long ullStart = getMonotonicNsec();
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(sendMessage(aiSockPair[0], achPayload, sizeof(achPayload)), (int)sizeof(achPayload));
+    }
+    // 5000바이트 / 100000바이트/초 = 50ms
+    ASSERT_EQ(setConnImpairment(aiSockPair[0], NULL), 0);
+    ASSERT_GE(getMonotonicNsec() - ullStart, 45000000ULL);
+
+    int iReceived = 0;
+    while (iReceived < 5000) {
+        int iRet = recvMsgBlocking(aiSockPair[1], achBuffer, sizeof(achBuffer));
+        ASSERT_GT(iRet, 0);
+        iReceived += iRet;
+    }
+    ASSERT_EQ(iReceived, 5000);
+}
+
+/**
+ * @test 대기열 공간을 기다리는 송신 중에 연결을 제거하는 테스트
+ */
+TEST_F(TcpImpairTest, ReleaseWhileSenderWaits)
+{
+    TcpImpairment stImpair;
+    char achPayload[1000];
+
+    memset(achPayload, 'w', sizeof(achPayload));
+    ASSERT_EQ(parseImpairment("rate=1000,queue=1000", &stImpair), 0);
+    ASSERT_EQ(setConnImpairment(aiSockPair[0], &stImpair), 0);
+    ASSERT_EQ(sendMessage(aiSockPair[0], achPayload, sizeof(achPayload)), (int)sizeof(achPayload));
+
+    // 대기열이 가득 차 있으므로 두 번째 송신은 공간을 기다림
+    int iResult = 0;
+    std::thread stSender([&]() {
+        iResult = sendMessage(aiSockPair[0], achPayload, sizeof(achPayload));
+    });
+    usleep(20000);
+    removeConnInfo(aiSockPair[0]);
+    stSender.join();
+    ASSERT_EQ(iResult, -1);
+    ASSERT_EQ(findConnInfo(aiSockPair[0]), (TcpConnInfo *)NULL);
+}
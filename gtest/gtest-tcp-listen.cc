@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-listen.h"
+#include "tcp-metrics.h"
+#include <unistd.h>
+#include <thread>
+#include <chrono>
+
+#define LISTEN_TEST_PORT    12360
+#define LISTEN_TEST_BACKLOG 4
+#define LISTEN_TEST_CLIENTS 3
+
+
+static void onListenAlert(int iListenSock, int iReasons, const TcpListenStats *kpstStats, void *pvArg)
+{
+    (void)iListenSock;
+    (void)kpstStats;
+    __atomic_or_fetch((int *)pvArg, iReasons, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * @test accept 큐 길이/한도 샘플링 및 경보 테스트
+ *
+ * accept 하지 않은 연결을 쌓은 뒤 큐 길이와 한도가 게이지에 반영되고,
+ * 사용률이 임계값을 넘으면 경보 콜백이 호출되는지 확인합니다.
+ */
+TEST(TcpListenTest, QueueDepthAlert)
+{
+    if (isPortAvailable(LISTEN_TEST_PORT) != 0) {
+        GTEST_SKIP() << "port " << LISTEN_TEST_PORT << " in use";
+    }
+    int iListenSock = createServerSocket(LISTEN_TEST_PORT, LISTEN_TEST_BACKLOG);
+
+    TcpListenStats stStats;
+    ASSERT_EQ(sampleListenQueue(iListenSock, &stStats), 0);
+    ASSERT_EQ(stStats.uiQueueLength, 0U);
+    ASSERT_EQ(stStats.uiBacklog, (unsigned int)LISTEN_TEST_BACKLOG);
+
+    int aiClients[LISTEN_TEST_CLIENTS];
+    for (int i = 0; i < LISTEN_TEST_CLIENTS; i++) {
+        aiClients[i] = createClientSocket("127.0.0.1", LISTEN_TEST_PORT);
+        ASSERT_GE(aiClients[i], 0);
+    }
+
+    ASSERT_EQ(sampleListenQueue(iListenSock, &stStats), 0);
+    ASSERT_EQ(stStats.uiQueueLength, (unsigned int)LISTEN_TEST_CLIENTS);
+    ASSERT_EQ(getMetricGauge(TCP_GAUGE_ACCEPT_QUEUE), LISTEN_TEST_CLIENTS);
+    ASSERT_EQ(getMetricGauge(TCP_GAUGE_ACCEPT_BACKLOG), LISTEN_TEST_BACKLOG);
+
+    int iReasons = 0;
+    unsigned long long ullAlerts = getMetricCounter(TCP_COUNTER_LISTEN_ALERTS);
+    ASSERT_EQ(startListenMonitor(iListenSock, 20, 50, onListenAlert, &iReasons), 0);
+    for (int i = 0; i < 100 && __atomic_load_n(&iReasons, __ATOMIC_RELAXED) == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stopListenMonitor();
+
+    ASSERT_TRUE(iReasons & TCP_LISTEN_ALERT_QUEUE);
+    ASSERT_GT(getMetricCounter(TCP_COUNTER_LISTEN_ALERTS), ullAlerts);
+
+    for (int i = 0; i < LISTEN_TEST_CLIENTS; i++) {
+        removeConnInfo(aiClients[i]);
+        close(aiClients[i]);
+    }
+    close(iListenSock);
+
+    // 수신 대기 소켓이 아니면 실패
+    ASSERT_EQ(sampleListenQueue(aiClients[0], &stStats), -1);
+}
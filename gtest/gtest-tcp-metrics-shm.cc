@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+#include "tcp-metrics-shm.h"
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/**
+ * @test 공유 메모리 세그먼트 게시 및 외부 조회 테스트
+ *
+ * 세그먼트를 파일로 게시하고 socketpair로 송수신한 뒤, 별도 매핑으로 연 세그먼트에서
+ * 카운터, 게이지, 연결 통계가 보이는지 확인합니다.
+ */
+TEST(TcpMetricsShmTest, PublishAndRead)
+{
+    char achPath[64];
+    snprintf(achPath, sizeof(achPath), "/tmp/tcpsock-gtest.%d", (int)getpid());
+
+    unsigned long long ullSentBefore = getMetricCounter(TCP_COUNTER_BYTES_SENT);
+    int iFd = publishMetricsShm(achPath, 0);
+    ASSERT_GE(iFd, 0);
+    ASSERT_NE(getPublishedMetricsShm(), (const TcpMetricsSegment *)NULL);
+    ASSERT_EQ(publishMetricsShm(achPath, 0), -1);
+    // 게시 이전의 값이 그대로 옮겨졌는지 확인
+    ASSERT_GE(getMetricCounter(TCP_COUNTER_BYTES_SENT), ullSentBefore);
+
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+    ASSERT_NE(registerConnInfo(aiSockPair[0]), (TcpConnInfo *)NULL);
+    ASSERT_NE(registerConnInfo(aiSockPair[1]), (TcpConnInfo *)NULL);
+    long long llOpen = getMetricGauge(TCP_GAUGE_OPEN_CONNECTIONS);
+    ASSERT_GE(llOpen, 2);
+
+    char achBuffer[100];
+    memset(achBuffer, 'a', sizeof(achBuffer));
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(sendMessage(aiSockPair[0], achBuffer, sizeof(achBuffer)), (int)sizeof(achBuffer));
+        ASSERT_EQ(recvMsgBlocking(aiSockPair[1], achBuffer, sizeof(achBuffer)), (int)sizeof(achBuffer));
+    }
+
+    size_t uiSize = 0;
+    const TcpMetricsSegment *kpstSegment = openMetricsShm(achPath, &uiSize);
+    ASSERT_NE(kpstSegment, (const TcpMetricsSegment *)NULL);
+    ASSERT_EQ(kpstSegment->stHeader.iPid, (int)getpid());
+    ASSERT_STREQ(kpstSegment->stHeader.aachCounterNames[TCP_COUNTER_BYTES_SENT], "bytes_sent");
+    ASSERT_EQ(kpstSegment->stHeader.allGauges[TCP_GAUGE_OPEN_CONNECTIONS], llOpen);
+
+    unsigned long long ullSent = 0;
+    for (unsigned int i = 0; i < kpstSegment->stHeader.uiThreadSlots; i++) {
+        if (kpstSegment->astThreads[i].uiInUse) {
+            ullSent += kpstSegment->astThreads[i].aullCounters[TCP_COUNTER_BYTES_SENT];
+        }
+    }
+    ASSERT_EQ(ullSent, getMetricCounter(TCP_COUNTER_BYTES_SENT));
+    ASSERT_GE(ullSent, ullSentBefore + 300);
+
+    TcpConnStats stStats;
+    ASSERT_EQ(readConnStatsSnapshot(&TCP_SHM_CONN_SLOTS(kpstSegment)[aiSockPair[0]], &stStats), 1);
+    ASSERT_EQ(stStats.iSock, aiSockPair[0]);
+    ASSERT_EQ(stStats.ullBytesOut, 300ULL);
+    ASSERT_EQ(stStats.ullMsgsOut, 3ULL);
+    ASSERT_EQ(readConnStatsSnapshot(&TCP_SHM_CONN_SLOTS(kpstSegment)[aiSockPair[1]], &stStats), 1);
+    ASSERT_EQ(stStats.ullBytesIn, 300ULL);
+    ASSERT_EQ(stStats.ullMsgsIn, 3ULL);
+
+    // 연결을 제거하면 슬롯이 비고 게이지가 감소
+    removeConnInfo(aiSockPair[0]);
+    removeConnInfo(aiSockPair[1]);
+    ASSERT_EQ(readConnStatsSnapshot(&TCP_SHM_CONN_SLOTS(kpstSegment)[aiSockPair[0]], &stStats), 0);
+    ASSERT_EQ(kpstSegment->stHeader.allGauges[TCP_GAUGE_OPEN_CONNECTIONS], llOpen - 2);
+
+    // 쓰는 쪽이 갱신 도중 멈춘 슬롯(홀수 시퀀스)은 무한히 기다리지 않고 -1
+    TcpConnStats stStalled;
+    memset(&stStalled, 0, sizeof(stStalled));
+    stStalled.uiSeq = 1;
+    ASSERT_EQ(readConnStatsSnapshot(&stStalled, &stStats), -1);
+
+    close(aiSockPair[0]);
+    close(aiSockPair[1]);
+    munmap((void *)kpstSegment, uiSize);
+    unlink(achPath);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "tcp-metrics.h"
+#include "tcp-metrics-shm.h"
+#include "tcp-frame.h"
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+
+/**
+ * @test 히스토그램 백분위 계산 테스트
+ *
+ * 1~1000 값을 기록한 뒤 백분위 값이 버킷 오차(25%) 범위 안에 있는지 확인합니다.
+ */
+TEST(TcpMetricsTest, HistogramPercentile)
+{
+    TcpHistogram stHist;
+    resetHistogram(&stHist);
+
+    for (unsigned long long i = 1; i <= 1000; i++) {
+        recordHistogram(&stHist, i);
+    }
+
+    ASSERT_EQ(stHist.ullCount, 1000ULL);
+    ASSERT_EQ(stHist.ullMax, 1000ULL);
+    ASSERT_EQ(stHist.ullSum, 500500ULL);
+
+    unsigned long long ullP50 = getHistogramPercentile(&stHist, 50.0);
+    ASSERT_GE(ullP50, 500ULL);
+    ASSERT_LE(ullP50, 625ULL);
+    ASSERT_EQ(getHistogramPercentile(&stHist, 100.0), 1000ULL);
+}
+
+/**
+ * @test 빈 히스토그램과 큰 값 기록 테스트
+ */
+TEST(TcpMetricsTest, HistogramEdgeValues)
+{
+    TcpHistogram stHist;
+    resetHistogram(&stHist);
+    ASSERT_EQ(getHistogramPercentile(&stHist, 99.0), 0ULL);
+
+    recordHistogram(&stHist, 0);
+    recordHistogram(&stHist, ~0ULL);
+    ASSERT_EQ(getHistogramPercentile(&stHist, 50.0), 0ULL);
+    ASSERT_EQ(getHistogramPercentile(&stHist, 100.0), ~0ULL);
+}
+
+/**
+ * @test 여러 스레드에서 동시에 기록해도 개수가 유실되지 않는지 테스트
+ */
+TEST(TcpMetricsTest, HistogramConcurrentRecord)
+{
+    TcpHistogram stHist;
+    resetHistogram(&stHist);
+
+    std::vector<std::thread> vecThreads;
+    for (int t = 0; t < 4; t++) {
+        vecThreads.emplace_back([&stHist]() {
+            for (int i = 0; i < 10000; i++) {
+                recordHistogram(&stHist, (unsigned long long)i);
+            }
+        });
+    }
+    for (auto &thread : vecThreads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(stHist.ullCount, 40000ULL);
+    ASSERT_STREQ(getMetricHistogramName(TCP_METRIC_WIRE_TO_APP), "wire_to_app_ns");
+    ASSERT_EQ(getMetricHistogram(TCP_METRIC_HISTOGRAM_COUNT), nullptr);
+}
+
+static int countThreadSlots(void)
+{
+    int iCount = 0;
+    for (int i = 0; i < TCP_SHM_THREAD_SLOTS; i++) {
+        iCount += (int)__atomic_load_n(&g_pstMetricsSegment->astThreads[i].uiInUse, __ATOMIC_ACQUIRE);
+    }
+    return iCount;
+}
+
+/**
+ * @test 종료한 스레드의 슬롯이 반납되어 슬롯 수보다 많은 스레드도 자기 슬롯을 쓰는지 테스트
+ *
+ * 반납된 슬롯의 카운터는 공용 슬롯으로 옮겨지므로 전역 합계는 유지됩니다.
+ */
+TEST(TcpMetricsTest, ThreadSlotsAreReleased)
+{
+    addMetricCounter(TCP_COUNTER_RESOLVE_FAILURES, 0);
+    unsigned long long ullBefore = getMetricCounter(TCP_COUNTER_RESOLVE_FAILURES);
+    int iSlots = countThreadSlots();
+    int iOwnSlots = 0;
+
+    for (int t = 0; t < TCP_SHM_THREAD_SLOTS + 44; t++) {
+        std::thread thread([&iOwnSlots]() {
+            addMetricCounter(TCP_COUNTER_RESOLVE_FAILURES, 1);
+            int iTid = (int)syscall(SYS_gettid);
+            for (int i = 0; i < TCP_SHM_THREAD_SLOTS - 1; i++) {
+                if (g_pstMetricsSegment->astThreads[i].iTid == iTid) {
+                    iOwnSlots++;
+                    break;
+                }
+            }
+        });
+        thread.join();
+    }
+
+    ASSERT_EQ(iOwnSlots, TCP_SHM_THREAD_SLOTS + 44);
+    ASSERT_EQ(countThreadSlots(), iSlots);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_RESOLVE_FAILURES), ullBefore + TCP_SHM_THREAD_SLOTS + 44);
+    ASSERT_STREQ(g_pstMetricsSegment->astThreads[TCP_SHM_THREAD_SLOTS - 1].achName, "overflow");
+}
+
+/**
+ * @test 프레임 하나를 수신-처리-응답하는 동안 단계별 지연이 기록되는지 테스트
+ */
+TEST(TcpMetricsTest, StageBreakdown)
+{
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+
+    unsigned long long aullBefore[TCP_METRIC_HISTOGRAM_COUNT];
+    for (int i = 0; i < TCP_METRIC_HISTOGRAM_COUNT; i++) {
+        aullBefore[i] = getMetricHistogram((TcpMetricHistogram)i)->ullCount;
+    }
+
+    setStageSampleRate(1);
+    ASSERT_EQ(sendFrame(aiSockPair[1], "request", 7, NULL), 7);
+
+    TcpStageStamps stStages;
+    ASSERT_EQ(beginStageStamps(&stStages), 1);
+    char chBuffer[16];
+    ASSERT_EQ(recvFrame(aiSockPair[0], chBuffer, sizeof(chBuffer), NULL), 7);
+    markStage(&stStages, TCP_STAGE_HANDOFF);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    markStage(&stStages, TCP_STAGE_HANDLER_RETURN);
+    ASSERT_EQ(sendFrame(aiSockPair[0], "response", 8, NULL), 8);
+    endStageStamps(&stStages);
+
+    for (int i = TCP_METRIC_STAGE_RECV; i <= TCP_METRIC_STAGE_TOTAL; i++) {
+        ASSERT_EQ(getMetricHistogram((TcpMetricHistogram)i)->ullCount, aullBefore[i] + 1)
+            << getMetricHistogramName((TcpMetricHistogram)i);
+    }
+    ASSERT_GE(getMetricHistogram(TCP_METRIC_STAGE_HANDLER)->ullMax, 2000000ULL);
+
+    // 샘플링을 끄면 기록되지 않음
+    setStageSampleRate(0);
+    ASSERT_EQ(beginStageStamps(&stStages), 0);
+    ASSERT_EQ(recvFrame(aiSockPair[1], chBuffer, sizeof(chBuffer), NULL), 8);
+    endStageStamps(&stStages);
+    ASSERT_EQ(getMetricHistogram(TCP_METRIC_STAGE_TOTAL)->ullCount, aullBefore[TCP_METRIC_STAGE_TOTAL] + 1);
+
+    close(aiSockPair[0]);
+    close(aiSockPair[1]);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "tcp-probe.h"
+#include <elf.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief 실행 파일의 .note.stapsdt 섹션에서 USDT 추적점 이름을 읽습니다.
+ *
+ * @param strProvider 찾을 provider 이름
+ * @return 추적점 이름 집합 (섹션이 없으면 빈 집합)
+ */
+static std::set<std::string> readProbeNames(const std::string &strProvider)
+{
+    std::set<std::string> setNames;
+    std::ifstream stream("/proc/self/exe", std::ios::binary);
+    std::vector<char> vecImage((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    if (vecImage.size() < sizeof(Elf64_Ehdr)) {
+        return setNames;
+    }
+
+    const Elf64_Ehdr *kpstEhdr = reinterpret_cast<const Elf64_Ehdr *>(vecImage.data());
+    const Elf64_Shdr *kpstShdrs = reinterpret_cast<const Elf64_Shdr *>(vecImage.data() + kpstEhdr->e_shoff);
+    const char *kpchShStr = vecImage.data() + kpstShdrs[kpstEhdr->e_shstrndx].sh_offset;
+
+    for (int i = 0; i < kpstEhdr->e_shnum; i++) {
+        if (strcmp(kpchShStr + kpstShdrs[i].sh_name, ".note.stapsdt") != 0) {
+            continue;
+        }
+
+        size_t uiOffset = kpstShdrs[i].sh_offset;
+        size_t uiEnd = uiOffset + kpstShdrs[i].sh_size;
+        while (uiOffset + sizeof(Elf64_Nhdr) <= uiEnd) {
+            const Elf64_Nhdr *kpstNote = reinterpret_cast<const Elf64_Nhdr *>(vecImage.data() + uiOffset);
+            size_t uiName = uiOffset + sizeof(Elf64_Nhdr);
+            size_t uiDesc = uiName + ((kpstNote->n_namesz + 3) & ~3u);
+
+            // desc: pc(8B), base(8B), semaphore(8B), provider, name, args
+            const char *kpchProvider = vecImage.data() + uiDesc + 3 * sizeof(unsigned long long);
+            const char *kpchName = kpchProvider + strlen(kpchProvider) + 1;
+            if (kpstNote->n_type == 3 && strProvider == kpchProvider) {
+                setNames.insert(kpchName);
+            }
+            uiOffset = uiDesc + ((kpstNote->n_descsz + 3) & ~3u);
+        }
+    }
+    return setNames;
+}
+
+
+/**
+ * @test 송수신 경로의 USDT 추적점이 바이너리에 포함되었는지 테스트
+ */
+TEST(TcpProbeTest, ProbesAreEmitted)
+{
+#if defined(TCP_SOCK_NO_PROBES) || !(defined(__x86_64__) || defined(__aarch64__))
+    GTEST_SKIP() << "USDT probes are disabled on this build.";
+#endif
+    std::set<std::string> setNames = readProbeNames("tcpsock");
+
+    const char *kapchExpected[] = {
+        "accept", "connect_start", "connect_done", "send", "recv", "timeout", "disconnect", "close",
+    };
+    for (const char *kpchName : kapchExpected) {
+        ASSERT_EQ(setNames.count(kpchName), 1u) << "Missing USDT probe: " << kpchName;
+    }
+}
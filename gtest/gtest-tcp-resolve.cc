@@ -0,0 +1,433 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-resolve.h"
+#include "tcp-metrics.h"
+#include <unistd.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define RESOLVE_TEST_PORT       12398
+#define RESOLVE_TEST_TIMEOUT    100
+
+
+/**
+ * @brief 시험용 DNS 응답기
+ *
+ * 127.0.0.1의 임시 UDP 포트에서 다음 이름에만 답하고, 나머지는 SOA와 함께 NXDOMAIN으로 답합니다.
+ * - api.test: A 127.0.0.1, 127.0.0.2 + AAAA ::1 (TTL 1초)
+ * - db.corp.test: A 127.0.0.3 (TTL 300초)
+ * - slow.test: 답하지 않음 (시간 초과)
+ */
+class StandInDns
+{
+public:
+    StandInDns() : m_iSock(-1), m_iStop(0), m_iQueries(0)
+    {
+        struct sockaddr_in stAddr;
+        socklen_t uiLen = sizeof(stAddr);
+
+        m_iSock = socket(AF_INET, SOCK_DGRAM, 0);
+        memset(&stAddr, 0, sizeof(stAddr));
+        stAddr.sin_family = AF_INET;
+        stAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_iSock, (struct sockaddr *)&stAddr, sizeof(stAddr));
+        getsockname(m_iSock, (struct sockaddr *)&stAddr, &uiLen);
+        m_iPort = ntohs(stAddr.sin_port);
+        m_stThread = std::thread(&StandInDns::serve, this);
+    }
+
+    ~StandInDns()
+    {
+        m_iStop = 1;
+        m_stThread.join();
+        close(m_iSock);
+    }
+
+    int port() const { return m_iPort; }
+    int queries() const { return m_iQueries.load(); }
+
+private:
+    static void putRecord(unsigned char *pucOut, int *piOffset, int iType, unsigned int uiTtl,
+                          const unsigned char *kpucData, int iLength)
+    {
+        unsigned char *pucRecord = pucOut + *piOffset;
+        pucRecord[0] = 0xc0;                    // 질문의 이름을 가리키는 압축 포인터
+        pucRecord[1] = 12;
+        pucRecord[2] = 0;
+        pucRecord[3] = (unsigned char)iType;
+        pucRecord[4] = 0;
+        pucRecord[5] = 1;
+        pucRecord[6] = (unsigned char)(uiTtl >> 24);
+        pucRecord[7] = (unsigned char)(uiTtl >> 16);
+        pucRecord[8] = (unsigned char)(uiTtl >> 8);
+        pucRecord[9] = (unsigned char)uiTtl;
+        pucRecord[10] = 0;
+        pucRecord[11] = (unsigned char)iLength;
+        memcpy(pucRecord + 12, kpucData, (size_t)iLength);
+        *piOffset += 12 + iLength;
+    }
+
+    static std::string questionName(const unsigned char *kpucPacket, int iLength, int *piEnd)
+    {
+        std::string strName;
+        int iOffset = 12;
+        while (iOffset < iLength && kpucPacket[iOffset] != 0) {
+            if (!strName.empty()) {
+                strName += '.';
+            }
+            strName.append((const char *)kpucPacket + iOffset + 1, kpucPacket[iOffset]);
+            iOffset += kpucPacket[iOffset] + 1;
+        }
+        *piEnd = iOffset + 5;
+        return strName;
+    }
+
+    void answer(const unsigned char *kpucQuery, int iLength, struct sockaddr_in *pstPeer, socklen_t uiPeerLen)
+    {
+        unsigned char aucOut[512];
+        int iEnd;
+        std::string strName = questionName(kpucQuery, iLength, &iEnd);
+        int iType = kpucQuery[iEnd - 3];
+        int iAnswers = 0;
+
+        if (strName == "slow.test") {
+            return;
+        }
+        memcpy(aucOut, kpucQuery, (size_t)iEnd);
+        int iOffset = iEnd;
+        if (strcasecmp(strName.c_str(), "api.test") == 0) {
+            static const unsigned char s_aucA1[4] = { 127, 0, 0, 1 };
+            static const unsigned char s_aucA2[4] = { 127, 0, 0, 2 };
+            static const unsigned char s_aucV6[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+            if (iType == 1) {
+                putRecord(aucOut, &iOffset, 1, 1, s_aucA1, 4);
+                putRecord(aucOut, &iOffset, 1, 1, s_aucA2, 4);
+                iAnswers = 2;
+            } else {
+                putRecord(aucOut, &iOffset, 28, 1, s_aucV6, 16);
+                iAnswers = 1;
+            }
+        } else if (strName == "db.corp.test") {
+            static const unsigned char s_aucA[4] = { 127, 0, 0, 3 };
+            if (iType == 1) {
+                putRecord(aucOut, &iOffset, 1, 300, s_aucA, 4);
+                iAnswers = 1;
+            }
+        } else {
+            // NXDOMAIN + SOA (TTL 600, MINIMUM 2 → 부정 캐시 2초)
+            unsigned char aucSoa[22];
+            memset(aucSoa, 0, sizeof(aucSoa));
+            aucSoa[21] = 2;
+            putRecord(aucOut, &iOffset, 6, 600, aucSoa, sizeof(aucSoa));
+            aucOut[3] = 3;
+            aucOut[9] = 1;
+        }
+        aucOut[2] |= 0x80;
+        aucOut[7] = (unsigned char)iAnswers;
+        sendto(m_iSock, aucOut, (size_t)iOffset, 0, (struct sockaddr *)pstPeer, uiPeerLen);
+    }
+
+    void serve()
+    {
+        unsigned char aucPacket[512];
+        while (!m_iStop) {
+            struct pollfd stPoll = { m_iSock, POLLIN, 0 };
+            if (poll(&stPoll, 1, 20) <= 0) {
+                continue;
+            }
+            struct sockaddr_in stPeer;
+            socklen_t uiPeerLen = sizeof(stPeer);
+            ssize_t lReceived = recvfrom(m_iSock, aucPacket, sizeof(aucPacket), 0, (struct sockaddr *)&stPeer,
+                                         &uiPeerLen);
+            if (lReceived > 12) {
+                m_iQueries++;
+                answer(aucPacket, (int)lReceived, &stPeer, uiPeerLen);
+            }
+        }
+    }
+
+    int m_iSock;
+    int m_iPort;
+    volatile int m_iStop;
+    std::atomic<int> m_iQueries;
+    std::thread m_stThread;
+};
+
+/**
+ * @brief 임시 hosts 파일과 resolv.conf로 해석기를 설정하는 테스트 픽스처
+ */
+class TcpResolveTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        strcpy(m_achHosts, "/tmp/tcp-resolve-hosts-XXXXXX");
+        strcpy(m_achConf, "/tmp/tcp-resolve-conf-XXXXXX");
+        close(mkstemp(m_achHosts));
+        close(mkstemp(m_achConf));
+        writeFile(m_achHosts, "# 시험용 hosts\n"
+                              "10.0.0.1   web.test web   # 주석\n"
+                              "fd00::1    web.test\n"
+                              "127.0.0.1  svc.test\n");
+        writeFile(m_achConf, "nameserver 127.0.0.1\nsearch corp.test\noptions ndots:1\n");
+
+        memset(&m_stConfig, 0, sizeof(m_stConfig));
+        m_stConfig.kpchHostsPath = m_achHosts;
+        m_stConfig.kpchResolvConfPath = m_achConf;
+        m_stConfig.uiNameserverPort = (unsigned int)m_stDns.port();
+        m_stConfig.uiTimeoutMsec = RESOLVE_TEST_TIMEOUT;
+        m_stConfig.uiAttempts = 1;
+        ASSERT_EQ(startResolver(&m_stConfig), 0);
+    }
+
+    void TearDown() override
+    {
+        stopResolver();
+        unlink(m_achHosts);
+        unlink(m_achConf);
+    }
+
+    static void writeFile(const char *kpchPath, const char *kpchText)
+    {
+        FILE *pstFile = fopen(kpchPath, "w");
+        fputs(kpchText, pstFile);
+        fclose(pstFile);
+    }
+
+    static std::string addrText(const TcpResolvedAddr &stAddr)
+    {
+        char achText[INET6_ADDRSTRLEN];
+        inet_ntop(stAddr.iFamily, stAddr.aucAddr, achText, sizeof(achText));
+        return achText;
+    }
+
+    StandInDns m_stDns;
+    char m_achHosts[64];
+    char m_achConf[64];
+    TcpResolverConfig m_stConfig;
+};
+
+
+/**
+ * @test 엔드포인트 문자열 분리 테스트
+ */
+TEST(TcpResolveEndpointTest, ParsesEndpoints)
+{
+    char achHost[TCP_RESOLVE_HOST_MAX];
+    int iPort = 0;
+
+    ASSERT_EQ(parseEndpoint("cache.internal:6379", achHost, sizeof(achHost), &iPort), 0);
+    ASSERT_STREQ(achHost, "cache.internal");
+    ASSERT_EQ(iPort, 6379);
+    ASSERT_EQ(parseEndpoint("[fd00::1]:443", achHost, sizeof(achHost), &iPort), 0);
+    ASSERT_STREQ(achHost, "fd00::1");
+    ASSERT_EQ(iPort, 443);
+
+    ASSERT_EQ(parseEndpoint("fd00::1:443", achHost, sizeof(achHost), &iPort), -1);
+    ASSERT_EQ(parseEndpoint("host:", achHost, sizeof(achHost), &iPort), -1);
+    ASSERT_EQ(parseEndpoint("host:70000", achHost, sizeof(achHost), &iPort), -1);
+    ASSERT_EQ(parseEndpoint(":80", achHost, sizeof(achHost), &iPort), -1);
+    ASSERT_EQ(parseEndpoint("host", achHost, sizeof(achHost), &iPort), -1);
+}
+
+/**
+ * @test 숫자 주소와 hosts 파일 해석 테스트
+ *
+ * 숫자 주소는 그대로, hosts 파일의 이름은 대소문자를 무시하고 여러 줄의 주소를 IPv6 먼저
+ * 모으며, 캐시를 비우면 바뀐 hosts 파일이 반영되는지 확인합니다.
+ */
+TEST_F(TcpResolveTest, NumericAndHostsFile)
+{
+    TcpResolveResult stResult;
+
+    ASSERT_EQ(resolveHost("192.0.2.7", &stResult), 0);
+    ASSERT_EQ(stResult.iSource, TCP_RESOLVE_SOURCE_NUMERIC);
+    ASSERT_EQ(addrText(stResult.astAddrs[0]), "192.0.2.7");
+
+    ASSERT_EQ(resolveHost("WEB.test", &stResult), 0);
+    ASSERT_EQ(stResult.iSource, TCP_RESOLVE_SOURCE_HOSTS);
+    ASSERT_EQ(stResult.iCached, 0);
+    ASSERT_EQ(stResult.iAddrs, 2);
+    ASSERT_EQ(stResult.astAddrs[0].iFamily, AF_INET6);
+    ASSERT_EQ(addrText(stResult.astAddrs[0]), "fd00::1");
+    ASSERT_EQ(addrText(stResult.astAddrs[1]), "10.0.0.1");
+
+    ASSERT_EQ(resolveHost("web", &stResult), 0);
+    ASSERT_EQ(addrText(stResult.astAddrs[0]), "10.0.0.1");
+
+    writeFile(m_achHosts, "10.0.0.9 web.test\n");
+    ASSERT_EQ(resolveHost("web.test", &stResult), 0);
+    ASSERT_EQ(stResult.iCached, 1);
+    ASSERT_EQ(stResult.iAddrs, 2);
+    flushResolverCache();
+    ASSERT_EQ(resolveHost("web.test", &stResult), 0);
+    ASSERT_EQ(stResult.iAddrs, 1);
+    ASSERT_EQ(addrText(stResult.astAddrs[0]), "10.0.0.9");
+    ASSERT_EQ(m_stDns.queries(), 0);
+}
+
+/**
+ * @test DNS 응답 캐시와 TTL 만료 테스트
+ */
+TEST_F(TcpResolveTest, DnsAnswersAreCachedForTtl)
+{
+    TcpResolveResult stResult;
+    unsigned long long ullHits = getMetricCounter(TCP_COUNTER_RESOLVE_HITS);
+
+    ASSERT_EQ(resolveHost("api.test", &stResult), 0);
+    ASSERT_EQ(stResult.iSource, TCP_RESOLVE_SOURCE_DNS);
+    ASSERT_EQ(stResult.iAddrs, 3);
+    ASSERT_EQ(addrText(stResult.astAddrs[0]), "::1");
+    ASSERT_EQ(addrText(stResult.astAddrs[1]), "127.0.0.1");
+    ASSERT_EQ(addrText(stResult.astAddrs[2]), "127.0.0.2");
+    ASSERT_EQ(stResult.uiTtl, 1U);
+    ASSERT_EQ(m_stDns.queries(), 2);
+
+    ASSERT_EQ(resolveHost("API.TEST", &stResult), 0);
+    ASSERT_EQ(stResult.iCached, 1);
+    ASSERT_EQ(stResult.iAddrs, 3);
+    ASSERT_EQ(m_stDns.queries(), 2);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_RESOLVE_HITS), ullHits + 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    ASSERT_EQ(resolveHost("api.test", &stResult), 0);
+    ASSERT_EQ(stResult.iCached, 0);
+    ASSERT_EQ(m_stDns.queries(), 4);
+}
+
+/**
+ * @test 부정 캐시와 검색 도메인 테스트
+ *
+ * 없는 이름은 SOA에서 얻은 시간 동안 다시 묻지 않고, 점이 없는 이름은 검색 도메인을 붙여
+ * 먼저 질의하는지 확인합니다.
+ */
+TEST_F(TcpResolveTest, NegativeCacheAndSearchDomains)
+{
+    TcpResolveResult stResult;
+
+    ASSERT_EQ(resolveHost("missing.test", &stResult), TCP_RESOLVE_NOT_FOUND);
+    ASSERT_EQ(stResult.uiTtl, 2U);
+    int iQueries = m_stDns.queries();
+    ASSERT_EQ(resolveHost("missing.test", &stResult), TCP_RESOLVE_NOT_FOUND);
+    ASSERT_EQ(stResult.iCached, 1);
+    ASSERT_EQ(m_stDns.queries(), iQueries);
+
+    ASSERT_EQ(resolveHost("db", &stResult), 0);
+    ASSERT_EQ(stResult.iAddrs, 1);
+    ASSERT_EQ(addrText(stResult.astAddrs[0]), "127.0.0.3");
+    ASSERT_EQ(m_stDns.queries(), iQueries + 2);
+
+    ASSERT_EQ(resolveHost("db.", &stResult), TCP_RESOLVE_NOT_FOUND);
+}
+
+/**
+ * @test 시간 초과는 캐시하지 않는지 테스트
+ */
+TEST_F(TcpResolveTest, TimeoutsAreNotCached)
+{
+    TcpResolveResult stResult;
+    unsigned long long ullFailures = getMetricCounter(TCP_COUNTER_RESOLVE_FAILURES);
+
+    unsigned long long ullStart = getMonotonicNsec();
+    ASSERT_EQ(resolveHost("slow.test", &stResult), -1);
+    ASSERT_GE(getMonotonicNsec() - ullStart, (unsigned long long)RESOLVE_TEST_TIMEOUT * 1000000ULL);
+    ASSERT_EQ(getMetricCounter(TCP_COUNTER_RESOLVE_FAILURES), ullFailures + 1);
+
+    int iQueries = m_stDns.queries();
+    ASSERT_EQ(resolveHost("slow.test", &stResult), -1);
+    ASSERT_EQ(m_stDns.queries(), iQueries + 2);
+}
+
+struct AsyncOutcome {
+    std::atomic<int> iDone;
+    int iStatus;
+    int iAddrs;
+    std::thread::id stThread;
+};
+
+static void onResolved(const char *kpchHost, const TcpResolveResult *kpstResult, void *pvArg)
+{
+    AsyncOutcome *pstOutcome = (AsyncOutcome *)pvArg;
+    (void)kpchHost;
+    pstOutcome->iStatus = kpstResult->iStatus;
+    pstOutcome->iAddrs = kpstResult->iAddrs;
+    pstOutcome->stThread = std::this_thread::get_id();
+    pstOutcome->iDone.store(1);
+}
+
+static void waitOutcome(AsyncOutcome *pstOutcome)
+{
+    for (int i = 0; i < 200 && pstOutcome->iDone.load() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+/**
+ * @test 비동기 해석 테스트
+ *
+ * 느린 이름이 해석 스레드 하나를 붙잡고 있어도 다른 이름은 다른 스레드에서 완료되고,
+ * 호출 스레드는 기다리지 않으며, 캐시에 있는 이름은 호출 스레드에서 바로 완료되는지 확인합니다.
+ */
+TEST_F(TcpResolveTest, AsyncResolutionRunsOffThread)
+{
+    AsyncOutcome astOutcomes[3];
+    for (AsyncOutcome &stOutcome : astOutcomes) {
+        stOutcome.iDone.store(0);
+    }
+
+    unsigned long long ullStart = getMonotonicNsec();
+    ASSERT_EQ(resolveHostAsync("slow.test", onResolved, &astOutcomes[0]), 0);
+    ASSERT_EQ(resolveHostAsync("api.test", onResolved, &astOutcomes[1]), 0);
+    ASSERT_LT(getMonotonicNsec() - ullStart, (unsigned long long)RESOLVE_TEST_TIMEOUT * 1000000ULL / 2);
+
+    waitOutcome(&astOutcomes[1]);
+    ASSERT_EQ(astOutcomes[1].iDone.load(), 1);
+    ASSERT_EQ(astOutcomes[1].iStatus, 0);
+    ASSERT_EQ(astOutcomes[1].iAddrs, 3);
+    ASSERT_NE(astOutcomes[1].stThread, std::this_thread::get_id());
+
+    ASSERT_EQ(resolveHostAsync("api.test", onResolved, &astOutcomes[2]), 1);
+    ASSERT_EQ(astOutcomes[2].iDone.load(), 1);
+    ASSERT_EQ(astOutcomes[2].stThread, std::this_thread::get_id());
+
+    waitOutcome(&astOutcomes[0]);
+    ASSERT_EQ(astOutcomes[0].iDone.load(), 1);
+    ASSERT_EQ(astOutcomes[0].iStatus, -1);
+
+    ASSERT_EQ(resolveHostAsync("", onResolved, &astOutcomes[0]), -1);
+}
+
+/**
+ * @test "host:port" 엔드포인트 연결 테스트
+ */
+TEST_F(TcpResolveTest, ConnectsByEndpointName)
+{
+    if (isPortAvailable(RESOLVE_TEST_PORT) != 0) {
+        GTEST_SKIP() << "port " << RESOLVE_TEST_PORT << " in use";
+    }
+    int iServerSock = createServerSocket(RESOLVE_TEST_PORT, 4);
+    ASSERT_GE(iServerSock, 0);
+
+    std::string strEndpoint = "svc.test:" + std::to_string(RESOLVE_TEST_PORT);
+    int iSock = createClientSocketTo(strEndpoint.c_str());
+    ASSERT_GE(iSock, 0);
+    int iPeer = acceptClientSocket(iServerSock);
+    ASSERT_GE(iPeer, 0);
+    ASSERT_EQ(sendMessage(iSock, "ping", 4), 4);
+    char achBuffer[4];
+    ASSERT_EQ(recvMsgBlocking(iPeer, achBuffer, sizeof(achBuffer)), 4);
+
+    ASSERT_EQ(createClientSocketTo("missing.test:80"), -1);
+
+    removeConnInfo(iSock);
+    close(iSock);
+    removeConnInfo(iPeer);
+    close(iPeer);
+    close(iServerSock);
+}
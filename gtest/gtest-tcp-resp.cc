@@ -0,0 +1,386 @@
+#include <gtest/gtest.h>
+#include "tcp-resp.h"
+#include "tcp-sock.h"
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+
+
+static std::string toString(const TcpRespValue &stValue)
+{
+    return std::string(stValue.kpchData, stValue.uiLength);
+}
+
+static int parseString(const char *kpchData, TcpRespValue *pstValues, int iMaxValues, int *piValues)
+{
+    return parseRespValue(kpchData, strlen(kpchData), pstValues, iMaxValues, piValues);
+}
+
+/**
+ * @brief 인-프로세스 RESP 대역 서버
+ *
+ * 받은 명령을 해석하여 수신 묶음마다 응답을 한 번에 보냅니다.
+ * - ECHO x: bulk x
+ * - STRLEN x: x의 길이
+ * - INCR: 1부터 증가하는 integer
+ * - PUBLISH x: push ["message", x] 후 +OK
+ * - 그 외: -ERR
+ */
+static void serveResp(int iSock)
+{
+    std::vector<char> vecBuffer(1 << 16);
+    TcpRespValue astValues[16];
+    size_t uiStart = 0;
+    size_t uiEnd = 0;
+    long long llCounter = 0;
+
+    for (;;) {
+        ssize_t received = read(iSock, vecBuffer.data() + uiEnd, vecBuffer.size() - uiEnd);
+        if (received <= 0) {
+            return;
+        }
+        uiEnd += (size_t)received;
+
+        std::string strOut;
+        int iValues;
+        int iLength;
+        while ((iLength = parseRespValue(vecBuffer.data() + uiStart, uiEnd - uiStart, astValues, 16, &iValues)) > 0) {
+            uiStart += (size_t)iLength;
+            std::string strCommand = toString(astValues[1]);
+            char achHeader[24];
+            if (strCommand == "ECHO") {
+                strOut.append(achHeader, (size_t)encodeRespHeader(achHeader, TCP_RESP_BULK, (long long)astValues[2].uiLength));
+                strOut += toString(astValues[2]) + "\r\n";
+            } else if (strCommand == "STRLEN") {
+                strOut.append(achHeader, (size_t)encodeRespHeader(achHeader, TCP_RESP_INTEGER, (long long)astValues[2].uiLength));
+            } else if (strCommand == "INCR") {
+                strOut.append(achHeader, (size_t)encodeRespHeader(achHeader, TCP_RESP_INTEGER, ++llCounter));
+            } else if (strCommand == "PUBLISH") {
+                strOut += ">2\r\n$7\r\nmessage\r\n";
+                strOut.append(achHeader, (size_t)encodeRespHeader(achHeader, TCP_RESP_BULK, (long long)astValues[2].uiLength));
+                strOut += toString(astValues[2]) + "\r\n+OK\r\n";
+            } else {
+                strOut += "-ERR unknown command\r\n";
+            }
+        }
+        if (iLength < 0) {
+            return;
+        }
+        memmove(vecBuffer.data(), vecBuffer.data() + uiStart, uiEnd - uiStart);
+        uiEnd -= uiStart;
+        uiStart = 0;
+        if (!strOut.empty() && write(iSock, strOut.data(), strOut.size()) != (ssize_t)strOut.size()) {
+            return;
+        }
+    }
+}
+
+
+/**
+ * @test RESP2 값과 중첩 배열이 전위 순서 배열로 해석되고, 부족한 데이터는 기다리는지 테스트
+ */
+TEST(TcpRespParseTest, ParsesResp2Values)
+{
+    TcpRespValue astValues[16];
+    int iValues;
+
+    ASSERT_EQ(parseString("+OK\r\n", astValues, 16, &iValues), 5);
+    ASSERT_EQ(astValues[0].ucType, TCP_RESP_SIMPLE);
+    ASSERT_EQ(toString(astValues[0]), "OK");
+
+    ASSERT_EQ(parseString("-ERR wrong type\r\n", astValues, 16, &iValues), 17);
+    ASSERT_EQ(astValues[0].ucType, TCP_RESP_ERROR);
+    ASSERT_EQ(toString(astValues[0]), "ERR wrong type");
+
+    ASSERT_EQ(parseString(":-9223372036854775808\r\n", astValues, 16, &iValues), 23);
+    ASSERT_EQ(astValues[0].llInteger, (-9223372036854775807LL - 1));
+    ASSERT_EQ(parseString(":9223372036854775808\r\n", astValues, 16, &iValues), -1);
+
+    ASSERT_EQ(parseString("$5\r\nhe\r\no\r\n", astValues, 16, &iValues), 11);
+    ASSERT_EQ(toString(astValues[0]), "he\r\no");
+    ASSERT_EQ(parseString("$-1\r\n", astValues, 16, &iValues), 5);
+    ASSERT_EQ(astValues[0].ucNull, 1);
+    ASSERT_EQ(parseString("*-1\r\n", astValues, 16, &iValues), 5);
+    ASSERT_EQ(astValues[0].ucNull, 1);
+
+    std::string strNested = "*3\r\n:1\r\n*2\r\n$1\r\na\r\n+b\r\n$0\r\n\r\n";
+    ASSERT_EQ(parseString(strNested.c_str(), astValues, 16, &iValues), (int)strNested.size());
+    ASSERT_EQ(iValues, 6);
+    ASSERT_EQ(astValues[0].uiElements, 3u);
+    ASSERT_EQ(astValues[0].uiSpan, 6u);
+    ASSERT_EQ(astValues[1].llInteger, 1);
+    ASSERT_EQ(astValues[2].uiElements, 2u);
+    ASSERT_EQ(astValues[2].uiSpan, 3u);
+    ASSERT_EQ(toString(astValues[3]), "a");
+    ASSERT_EQ(toString(astValues[4]), "b");
+    ASSERT_EQ(astValues[2 + astValues[2].uiSpan].uiLength, 0u);
+
+    // 어느 위치에서 잘려도 데이터 부족으로 판단
+    for (size_t i = 0; i < strNested.size(); i++) {
+        ASSERT_EQ(parseRespValue(strNested.data(), i, astValues, 16, &iValues), 0) << i;
+    }
+    ASSERT_EQ(parseString(strNested.c_str(), astValues, 4, &iValues), TCP_RESP_ERR_TOO_MANY);
+
+    ASSERT_EQ(parseString("$3\r\nabcd\r\n", astValues, 16, &iValues), -1);
+    ASSERT_EQ(parseString(":12a\r\n", astValues, 16, &iValues), -1);
+    ASSERT_EQ(parseString("+OK\rX", astValues, 16, &iValues), -1);
+    ASSERT_EQ(parseString("?\r\n", astValues, 16, &iValues), -1);
+    ASSERT_EQ(parseString("$-2\r\n", astValues, 16, &iValues), -1);
+
+    std::string strDeep;
+    for (int i = 0; i < TCP_RESP_MAX_DEPTH + 1; i++) {
+        strDeep += "*1\r\n";
+    }
+    strDeep += ":0\r\n";
+    TcpRespValue astDeep[TCP_RESP_MAX_DEPTH + 2];
+    ASSERT_EQ(parseString(strDeep.c_str(), astDeep, TCP_RESP_MAX_DEPTH + 2, &iValues), -1);
+}
+
+/**
+ * @test RESP3 값을 해석하고 attribute는 건너뛰는지 테스트
+ */
+TEST(TcpRespParseTest, ParsesResp3Values)
+{
+    TcpRespValue astValues[16];
+    int iValues;
+
+    std::string strMap = "%2\r\n+first\r\n:1\r\n+second\r\n#t\r\n";
+    ASSERT_EQ(parseString(strMap.c_str(), astValues, 16, &iValues), (int)strMap.size());
+    ASSERT_EQ(astValues[0].ucType, TCP_RESP_MAP);
+    ASSERT_EQ(astValues[0].uiElements, 4u);
+    ASSERT_EQ(toString(astValues[3]), "second");
+    ASSERT_EQ(astValues[4].ucType, TCP_RESP_BOOLEAN);
+    ASSERT_EQ(astValues[4].llInteger, 1);
+
+    ASSERT_EQ(parseString("~2\r\n,3.25\r\n,-inf\r\n", astValues, 16, &iValues), 18);
+    ASSERT_EQ(astValues[0].ucType, TCP_RESP_SET);
+    ASSERT_DOUBLE_EQ(astValues[1].dDouble, 3.25);
+    ASSERT_TRUE(astValues[2].dDouble < -1e308);
+
+    ASSERT_EQ(parseString("_\r\n", astValues, 16, &iValues), 3);
+    ASSERT_EQ(astValues[0].ucNull, 1);
+    ASSERT_EQ(parseString("(3492890328409238509324850943850943825024385\r\n", astValues, 16, &iValues), 46);
+    ASSERT_EQ(astValues[0].uiLength, 43u);
+    ASSERT_EQ(parseString("=15\r\ntxt:Some string\r\n", astValues, 16, &iValues), 22);
+    ASSERT_EQ(toString(astValues[0]), "Some string");
+    ASSERT_EQ(parseString("!10\r\nSYNTAX bad\r\n", astValues, 16, &iValues), 17);
+    ASSERT_EQ(astValues[0].ucType, TCP_RESP_BULK_ERROR);
+
+    std::string strAttribute = "|1\r\n+ttl\r\n:3600\r\n*2\r\n:1\r\n|1\r\n+k\r\n+v\r\n:2\r\n";
+    ASSERT_EQ(parseString(strAttribute.c_str(), astValues, 16, &iValues), (int)strAttribute.size());
+    ASSERT_EQ(iValues, 3);
+    ASSERT_EQ(astValues[0].ucType, TCP_RESP_ARRAY);
+    ASSERT_EQ(astValues[2].llInteger, 2);
+
+    ASSERT_EQ(parseString(">2\r\n+message\r\n+hi\r\n", astValues, 16, &iValues), 19);
+    ASSERT_EQ(astValues[0].ucType, TCP_RESP_PUSH);
+
+    ASSERT_EQ(parseString("#x\r\n", astValues, 16, &iValues), -1);
+    ASSERT_EQ(parseString("_x\r\n", astValues, 16, &iValues), -1);
+    ASSERT_EQ(parseString(",1.5x\r\n", astValues, 16, &iValues), -1);
+    ASSERT_EQ(parseString("%-1\r\n", astValues, 16, &iValues), -1);
+}
+
+/**
+ * @test 이어진 attribute 수만 개를 스택 증가 없이 건너뛰고, 중첩 깊이 제한은 유지되는지 테스트
+ */
+TEST(TcpRespParseTest, SkipsLongAttributeChains)
+{
+    TcpRespValue astValues[16];
+    int iValues;
+    std::string strChain;
+    for (int i = 0; i < 65536; i++) {
+        strChain += "|0\r\n";
+    }
+
+    ASSERT_EQ(parseString(strChain.c_str(), astValues, 16, &iValues), 0);
+    strChain += ":1\r\n";
+    ASSERT_EQ(parseString(strChain.c_str(), astValues, 16, &iValues), (int)strChain.size());
+    ASSERT_EQ(iValues, 1);
+    ASSERT_EQ(astValues[0].llInteger, 1);
+
+    // attribute 값 안에 attribute를 넣는 중첩은 깊이마다 한 단계씩 셈
+    std::string strNested = ":1\r\n";
+    for (int i = 0; i < 4; i++) {
+        strNested = "|1\r\n+k\r\n" + strNested + ":1\r\n";
+    }
+    ASSERT_EQ(parseString(strNested.c_str(), astValues, 16, &iValues), (int)strNested.size());
+    for (int i = 4; i <= TCP_RESP_MAX_DEPTH; i++) {
+        strNested = "|1\r\n+k\r\n" + strNested + ":1\r\n";
+    }
+    ASSERT_EQ(parseString(strNested.c_str(), astValues, 16, &iValues), -1);
+}
+
+/**
+ * @test 명령이 bulk string 배열로 인코딩되어 그대로 해석되는지 테스트
+ */
+TEST(TcpRespParseTest, EncodesCommands)
+{
+    const char *kapchArgv[] = { "SET", "key", "" };
+    const size_t auiLengths[] = { 3, 3, 0 };
+    char achOut[128];
+    TcpRespValue astValues[8];
+    int iValues;
+
+    int iLength = encodeRespCommand(achOut, sizeof(achOut), 3, kapchArgv, auiLengths);
+    ASSERT_EQ(std::string(achOut, (size_t)iLength), "*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$0\r\n\r\n");
+    ASSERT_EQ(parseRespValue(achOut, (size_t)iLength, astValues, 8, &iValues), iLength);
+    ASSERT_EQ(iValues, 4);
+    ASSERT_EQ(encodeRespCommand(achOut, 40, 3, kapchArgv, auiLengths), -1);
+
+    ASSERT_EQ(std::string(achOut, (size_t)encodeRespHeader(achOut, TCP_RESP_INTEGER, -42)), ":-42\r\n");
+    ASSERT_EQ(std::string(achOut, (size_t)encodeRespHeader(achOut, TCP_RESP_ARRAY, 0)), "*0\r\n");
+}
+
+
+/**
+ * @brief 파이프라인 클라이언트 테스트 클래스
+ *
+ * socketpair()의 한쪽을 클라이언트, 다른 쪽을 대역 서버 스레드로 사용합니다.
+ */
+class TcpRespClientTest : public ::testing::Test
+{
+protected:
+    int aiSockPair[2];
+    std::unique_ptr<TcpRespClient> pstClient;
+    std::vector<char> vecBuffer;
+    TcpRespValue astValues[16];
+    std::thread server;
+
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+        pstClient.reset(new TcpRespClient);
+        vecBuffer.resize(256);
+        initRespClient(pstClient.get(), aiSockPair[0], vecBuffer.data(), vecBuffer.size(), astValues, 16);
+        server = std::thread(serveResp, aiSockPair[1]);
+    }
+
+    void TearDown() override {
+        shutdown(aiSockPair[0], SHUT_WR);
+        server.join();
+        close(aiSockPair[0]);
+        close(aiSockPair[1]);
+    }
+
+    long long queue(const std::vector<std::string> &vecArgs, TcpRespCallback pfnCallback, void *pvArg) {
+        const char *apchArgv[4];
+        size_t auiLengths[4];
+        for (size_t i = 0; i < vecArgs.size(); i++) {
+            apchArgv[i] = vecArgs[i].data();
+            auiLengths[i] = vecArgs[i].size();
+        }
+        return queueRespCommand(pstClient.get(), (int)vecArgs.size(), apchArgv, auiLengths, pfnCallback, pvArg);
+    }
+};
+
+// 응답을 문자열로 모음 (integer는 숫자, 문자열은 내용)
+static void collectReply(void *pvArg, const TcpRespValue *kpstReply, int)
+{
+    std::vector<std::string> *pvecReplies = (std::vector<std::string> *)pvArg;
+    if (kpstReply[0].ucType == TCP_RESP_INTEGER) {
+        pvecReplies->push_back(std::to_string(kpstReply[0].llInteger));
+    } else {
+        pvecReplies->push_back(std::string(1, (char)kpstReply[0].ucType) + toString(kpstReply[0]));
+    }
+}
+
+/**
+ * @test 여러 명령을 송신 버퍼 한 구간에 모아 보내고 응답이 보낸 순서대로 처리되는지 테스트
+ */
+TEST_F(TcpRespClientTest, PipelinedRepliesResolveInOrder)
+{
+    std::vector<std::string> vecReplies;
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(queue({ "INCR", "counter" }, collectReply, &vecReplies), i);
+    }
+    ASSERT_EQ(queue({ "NOPE" }, collectReply, &vecReplies), 100);
+    ASSERT_EQ(pstClient->iIov, 1);
+    ASSERT_TRUE(vecReplies.empty());
+
+    ASSERT_EQ(waitRespReply(pstClient.get(), 49), 0);
+    ASSERT_GE(vecReplies.size(), 50u);
+    size_t uiDone = vecReplies.size();
+    ASSERT_EQ(pumpRespClient(pstClient.get(), 1000), (int)(101 - uiDone));
+    ASSERT_EQ(vecReplies.size(), 101u);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(vecReplies[(size_t)i], std::to_string(i + 1));
+    }
+    ASSERT_EQ(vecReplies[100], "-ERR unknown command");
+    ASSERT_EQ(pumpRespClient(pstClient.get(), 1), 0);
+    ASSERT_EQ(waitRespReply(pstClient.get(), 101), -1);
+}
+
+static void countPush(void *pvArg, const TcpRespValue *kpstReply, int iValues)
+{
+    std::vector<std::string> *pvecPushes = (std::vector<std::string> *)pvArg;
+    ASSERT_EQ(iValues, 3);
+    pvecPushes->push_back(toString(kpstReply[2]));
+}
+
+/**
+ * @test 긴 인자는 복사 없이 iovec으로 보내고, 수신 버퍼를 앞으로 당기며 큰 응답을 받고,
+ *       push 메시지는 명령 순서를 소비하지 않는지 테스트
+ */
+TEST_F(TcpRespClientTest, LargeArgumentsAndPushMessages)
+{
+    std::vector<std::string> vecReplies;
+    std::vector<std::string> vecPushes;
+    std::string strLarge(TCP_RESP_INLINE_MAX + 1, 'x');
+    std::string strMedium(150, 'm');
+
+    setRespPushHandler(pstClient.get(), countPush, &vecPushes);
+    // 긴 인자가 호출자의 문자열을 그대로 가리키도록 직접 넣음
+    const char *kapchArgv[] = { "STRLEN", strLarge.data() };
+    const size_t auiLengths[] = { 6, strLarge.size() };
+    ASSERT_EQ(queueRespCommand(pstClient.get(), 2, kapchArgv, auiLengths, collectReply, &vecReplies), 0);
+    ASSERT_EQ(pstClient->iIov, 3);
+    ASSERT_EQ(pstClient->astIov[1].iov_base, (void *)strLarge.data());
+
+    // 256바이트 버퍼에 150바이트 응답 여러 개를 받으면 앞으로 당기는 일이 생김
+    for (int i = 0; i < 8; i++) {
+        ASSERT_EQ(queue({ "ECHO", strMedium }, collectReply, &vecReplies), i + 1);
+    }
+    ASSERT_EQ(queue({ "PUBLISH", "news" }, collectReply, &vecReplies), 9);
+    long long llLast = queue({ "INCR", "c" }, collectReply, &vecReplies);
+    ASSERT_EQ(waitRespReply(pstClient.get(), llLast), 0);
+
+    ASSERT_EQ(vecReplies.size(), 11u);
+    ASSERT_EQ(vecReplies[0], std::to_string(strLarge.size()));
+    for (int i = 1; i <= 8; i++) {
+        ASSERT_EQ(vecReplies[(size_t)i], "$" + strMedium);
+    }
+    ASSERT_EQ(vecReplies[9], "+OK");
+    ASSERT_EQ(vecReplies[10], "1");
+    ASSERT_EQ(vecPushes, std::vector<std::string>({ "news" }));
+
+    // 수신 버퍼보다 큰 응답은 실패
+    ASSERT_EQ(queue({ "ECHO", strLarge }, NULL, NULL), 11);
+    ASSERT_EQ(pumpRespClient(pstClient.get(), 1), -1);
+}
+
+static void checkSequence(void *pvArg, const TcpRespValue *kpstReply, int)
+{
+    long long *pllExpected = (long long *)pvArg;
+    ASSERT_EQ(kpstReply[0].llInteger, ++*pllExpected);
+}
+
+/**
+ * @test 응답을 기다리는 명령이 TCP_RESP_MAX_PENDING개를 넘으면 자동으로 응답을 받으며 진행하는지 테스트
+ */
+TEST_F(TcpRespClientTest, PipelineDepthIsBounded)
+{
+    long long llExpected = 0;
+    const int iCommands = TCP_RESP_MAX_PENDING * 3 + 7;
+
+    for (int i = 0; i < iCommands; i++) {
+        ASSERT_EQ(queue({ "INCR", "c" }, checkSequence, &llExpected), i);
+        ASSERT_LE(pstClient->ullQueued - pstClient->ullResolved, (unsigned long long)TCP_RESP_MAX_PENDING);
+    }
+    ASSERT_EQ(waitRespReply(pstClient.get(), iCommands - 1), 0);
+    ASSERT_EQ(llExpected, iCommands);
+}
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include "tcp-sniff.h"
+#include "tcp-frame.h"
+#include "tcp-http.h"
+#include "tcp-ws.h"
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include <thread>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+
+#define SNIFF_TEST_PORT     12365
+
+
+/**
+ * @brief 프로토콜 판별 테스트 클래스
+ */
+class TcpSniffTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {
+        clearSniffCodecs();
+    }
+
+    void TearDown() override {
+        clearSniffCodecs();
+    }
+};
+
+static void closeHandled(int iSock)
+{
+    removeConnInfo(iSock);
+    close(iSock);
+}
+
+// 프레임 하나를 그대로 돌려줌
+static void handleFrameConn(int iSock, void *)
+{
+    char achBuffer[256];
+    TcpFrameHeader stHeader;
+    int iLength = recvFrame(iSock, achBuffer, sizeof(achBuffer), &stHeader);
+    if (iLength >= 0) {
+        sendFrame(iSock, achBuffer, (size_t)iLength, NULL);
+    }
+    closeHandled(iSock);
+}
+
+// 요청 대상을 본문으로 응답
+static void handleHttpConn(int iSock, void *)
+{
+    char achBuffer[1024];
+    TcpHttpConn stConn;
+    TcpHttpRequest stRequest;
+    initHttpConn(&stConn, iSock, achBuffer, sizeof(achBuffer));
+    if (recvHttpRequest(&stConn, &stRequest) > 0) {
+        sendHttpResponse(iSock, 200, NULL, 0, stRequest.stTarget.kpchData, stRequest.stTarget.uiLength,
+                         TCP_HTTP_CLOSE);
+    }
+    closeHandled(iSock);
+}
+
+// 핸드셰이크 후 메시지 하나를 그대로 돌려줌
+static void handleWsConn(int iSock, void *)
+{
+    unsigned char aucBuffer[1024];
+    TcpWsConn stConn;
+    TcpWsMessage stMessage;
+    initWsConn(&stConn, iSock, aucBuffer, sizeof(aucBuffer));
+    if (acceptWsHandshake(&stConn) > 0 && recvWsMessage(&stConn, &stMessage) > 0) {
+        sendWsMessage(iSock, stMessage.ucOpcode, stMessage.pvData, stMessage.uiLength);
+    }
+    closeHandled(iSock);
+}
+
+static std::string readAll(int iSock)
+{
+    std::string strData;
+    char achBuffer[512];
+    for (;;) {
+        ssize_t received = read(iSock, achBuffer, sizeof(achBuffer));
+        if (received <= 0) {
+            break;
+        }
+        strData.append(achBuffer, (size_t)received);
+    }
+    return strData;
+}
+
+
+/**
+ * @test 판별 함수가 첫 바이트로 프로토콜을 구분하고, 부족하면 더 기다리는지 테스트
+ */
+TEST_F(TcpSniffTest, MatchersClassifyFirstBytes)
+{
+    unsigned char aucFrame[TCP_FRAME_MAX_HEADER];
+    encodeFrameHeader(aucFrame, 300, NULL);
+    const unsigned char *kpucGet = (const unsigned char *)"GET /chat HTTP/1.1\r\nUpgrade: websocket\r\n\r\n";
+    const unsigned char *kpucPost = (const unsigned char *)"POST /api HTTP/1.1\r\n";
+    const unsigned char *kpucTls = (const unsigned char *)"\x16\x03\x01\x02\x00\x01";
+
+    ASSERT_EQ(matchFrameProtocol(aucFrame, TCP_FRAME_HEADER_SIZE), TCP_SNIFF_MATCH);
+    ASSERT_EQ(matchFrameProtocol(aucFrame, 3), TCP_SNIFF_NEED_MORE);
+    ASSERT_EQ(matchFrameProtocol(kpucGet, 5), TCP_SNIFF_NO_MATCH);
+    ASSERT_EQ(matchFrameProtocol(kpucTls, 6), TCP_SNIFF_NO_MATCH);
+
+    ASSERT_EQ(matchHttpProtocol(kpucPost, 5), TCP_SNIFF_MATCH);
+    ASSERT_EQ(matchHttpProtocol(kpucPost, 3), TCP_SNIFF_NEED_MORE);
+    ASSERT_EQ(matchHttpProtocol(aucFrame, TCP_FRAME_HEADER_SIZE), TCP_SNIFF_NO_MATCH);
+    ASSERT_EQ(matchHttpProtocol(kpucTls, 6), TCP_SNIFF_NO_MATCH);
+
+    size_t uiGet = strlen((const char *)kpucGet);
+    ASSERT_EQ(matchWsProtocol(kpucGet, uiGet), TCP_SNIFF_MATCH);
+    ASSERT_EQ(matchWsProtocol(kpucGet, uiGet - 2), TCP_SNIFF_NEED_MORE);
+    ASSERT_EQ(matchWsProtocol(kpucGet, 2), TCP_SNIFF_NEED_MORE);
+    ASSERT_EQ(matchWsProtocol(kpucPost, strlen((const char *)kpucPost)), TCP_SNIFF_NO_MATCH);
+    ASSERT_EQ(matchWsProtocol((const unsigned char *)"GET / HTTP/1.1\r\n\r\n", 18), TCP_SNIFF_NO_MATCH);
+}
+
+/**
+ * @test 한 수신 대기 포트에서 프레이밍, HTTP, WebSocket 연결을 각 코덱으로 넘기고
+ *       알 수 없는 프로토콜은 닫는지 테스트
+ */
+TEST_F(TcpSniffTest, DispatchesProtocolsOnOnePort)
+{
+    if (isPortAvailable(SNIFF_TEST_PORT) != 0) {
+        GTEST_SKIP() << "port " << SNIFF_TEST_PORT << " in use";
+    }
+    int iListenSock = createServerSocket(SNIFF_TEST_PORT, 16);
+    ASSERT_GE(iListenSock, 0);
+    ASSERT_EQ(enableDeferredAccept(iListenSock, 2), 0);
+
+    ASSERT_EQ(registerSniffCodec("ws", matchWsProtocol, handleWsConn, NULL), 0);
+    ASSERT_EQ(registerSniffCodec("http", matchHttpProtocol, handleHttpConn, NULL), 1);
+    ASSERT_EQ(registerSniffCodec("frame", matchFrameProtocol, handleFrameConn, NULL), 2);
+    ASSERT_STREQ(getSniffCodecName(1), "http");
+
+    std::vector<int> vecDispatched;
+    std::thread acceptor([&]() {
+        for (int i = 0; i < 4; i++) {
+            vecDispatched.push_back(acceptSniffedConn(iListenSock, 1000));
+        }
+    });
+
+    // 프레이밍
+    int iSock = createClientSocket("127.0.0.1", SNIFF_TEST_PORT);
+    ASSERT_GE(iSock, 0);
+    char achBuffer[256];
+    TcpFrameHeader stHeader;
+    ASSERT_EQ(sendFrame(iSock, "ping", 4, NULL), 4);
+    ASSERT_EQ(recvFrame(iSock, achBuffer, sizeof(achBuffer), &stHeader), 4);
+    ASSERT_EQ(memcmp(achBuffer, "ping", 4), 0);
+    closeHandled(iSock);
+
+    // HTTP
+    iSock = createClientSocket("127.0.0.1", SNIFF_TEST_PORT);
+    ASSERT_GE(iSock, 0);
+    ASSERT_EQ(sendMessage(iSock, "GET /health HTTP/1.1\r\n\r\n", 24), 24);
+    ASSERT_EQ(readAll(iSock), "HTTP/1.1 200 OK\r\nContent-Length: 7\r\nConnection: close\r\n\r\n/health");
+    closeHandled(iSock);
+
+    // WebSocket: 업그레이드 요청을 나누어 보내 판별 단계가 헤더 끝까지 기다리는지 확인
+    iSock = createClientSocket("127.0.0.1", SNIFF_TEST_PORT);
+    ASSERT_GE(iSock, 0);
+    const char *kpchFirst = "GET /chat HTTP/1.1\r\nHost: localhost\r\n";
+    const char *kpchRest = "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    ASSERT_EQ(sendMessage(iSock, kpchFirst, strlen(kpchFirst)), (int)strlen(kpchFirst));
+    usleep(30000);
+    ASSERT_EQ(sendMessage(iSock, kpchRest, strlen(kpchRest)), (int)strlen(kpchRest));
+    static const unsigned char s_aucMask[4] = {1, 2, 3, 4};
+    unsigned char aucFrame[TCP_WS_MAX_HEADER + 2];
+    int iHeader = encodeWsFrameHeader(aucFrame, TCP_WS_OP_TEXT, 1, 2, s_aucMask);
+    memcpy(aucFrame + iHeader, "hi", 2);
+    maskWsPayload(aucFrame + iHeader, 2, s_aucMask, 0);
+    ASSERT_EQ(sendMessage(iSock, aucFrame, (size_t)iHeader + 2), iHeader + 2);
+    std::string strResponse = readAll(iSock);
+    ASSERT_EQ(strResponse.compare(0, 34, "HTTP/1.1 101 Switching Protocols\r\n"), 0);
+    ASSERT_EQ(strResponse.substr(strResponse.size() - 4), std::string("\x81\x02hi", 4));
+    closeHandled(iSock);
+
+    // 알 수 없는 프로토콜 (TLS ClientHello 첫 바이트)
+    iSock = createClientSocket("127.0.0.1", SNIFF_TEST_PORT);
+    ASSERT_GE(iSock, 0);
+    ASSERT_EQ(sendMessage(iSock, "\x16\x03\x01\x02\x00\x01", 6), 6);
+    ASSERT_EQ(readAll(iSock), "");
+    closeHandled(iSock);
+
+    acceptor.join();
+    close(iListenSock);
+    ASSERT_EQ(vecDispatched, std::vector<int>({2, 1, 0, TCP_SNIFF_UNKNOWN}));
+}
+
+/**
+ * @test 데이터가 없으면 시간 초과, 판단하지 못하면 불일치, 상대가 닫으면 종료를 반환하고
+ *       엿본 데이터는 소비하지 않는지 테스트
+ */
+TEST_F(TcpSniffTest, TimeoutAndCloseLeaveDataUnconsumed)
+{
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+    ASSERT_EQ(registerSniffCodec("http", matchHttpProtocol, handleHttpConn, NULL), 0);
+
+    ASSERT_EQ(sniffProtocol(aiSockPair[0], 30), TCP_TIME_OUT);
+
+    ASSERT_EQ(write(aiSockPair[1], "GE", 2), 2);
+    ASSERT_EQ(sniffProtocol(aiSockPair[0], 30), TCP_SNIFF_UNKNOWN);
+
+    ASSERT_EQ(write(aiSockPair[1], "T / HTTP/1.1\r\n\r\n", 16), 16);
+    ASSERT_EQ(sniffProtocol(aiSockPair[0], 30), 0);
+
+    char achBuffer[32];
+    ASSERT_EQ(recv(aiSockPair[0], achBuffer, sizeof(achBuffer), 0), 18);
+    ASSERT_EQ(memcmp(achBuffer, "GET / HTTP/1.1\r\n\r\n", 18), 0);
+
+    close(aiSockPair[1]);
+    ASSERT_EQ(sniffProtocol(aiSockPair[0], 30), TCP_SNIFF_CLOSED);
+    close(aiSockPair[0]);
+}
@@ -1,11 +1,15 @@
 #include <gtest/gtest.h>
 #include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
 #include <thread>
 #include <chrono>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
 #include <iostream>
 
 constexpr int TEST_PORT = 12347;
@@ -83,6 +87,7 @@ protected:
     void TearDown() override {
         // 모든 소켓 닫기
         if (iClientSock > 0) {
+            removeConnInfo(iClientSock);
             close(iClientSock);
         }
         if (iServerSock > 0) {
@@ -103,6 +108,29 @@ TEST_F(TcpSocketTest, CreateServerSocket)
     ASSERT_GE(iServerSock, 0) << "Failed to create server socket.";
 }
 
+/**
+ * @brief 사용 중인 포트로 서버 소켓 생성 실패 테스트
+ *
+ * 다른 소켓이 이미 바인드한 포트이면 프로세스를 종료하지 않고 -1을 반환하는지 확인합니다.
+ */
+TEST_F(TcpSocketTest, CreateServerSocket_PortInUse)
+{
+    int iBusySock = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(iBusySock, 0);
+    struct sockaddr_in stAddr;
+    memset(&stAddr, 0, sizeof(stAddr));
+    stAddr.sin_family = AF_INET;
+    stAddr.sin_addr.s_addr = INADDR_ANY;
+    stAddr.sin_port = htons(TEST_PORT + 1);
+    if (bind(iBusySock, (struct sockaddr *)&stAddr, sizeof(stAddr)) < 0 || listen(iBusySock, 1) < 0) {
+        close(iBusySock);
+        GTEST_SKIP() << "Port " << TEST_PORT + 1 << " is already in use. Skipping test.";
+    }
+
+    ASSERT_EQ(createServerSocket(TEST_PORT + 1, MAX_CLIENTS), -1);
+    close(iBusySock);
+}
+
 /**
  * @brief 클라이언트 소켓 생성 및 서버 연결 테스트
  * 
@@ -334,6 +362,216 @@ TEST_F(TcpSocketTest, ReceiveWithTimeout_SuccessfulReceive)
     close(iSock);
     server_thread.join();
 }
+
+/**
+ * @test 1024 이상의 파일 디스크립터와 1초 이상의 타임아웃으로 recvMsgTimeout을 호출하는 테스트
+ *
+ * 출발지 주소를 지정해 연결한 소켓을 높은 번호로 복제한 뒤 수신하므로, select()의
+ * FD_SETSIZE 제한 없이 대기하는지와 createClientSocketFrom()의 바인드를 함께 확인합니다.
+ */
+TEST_F(TcpSocketTest, ReceiveWithTimeout_HighDescriptor)
+{
+    constexpr int HIGH_FD = 1500;
+    if (sysconf(_SC_OPEN_MAX) <= HIGH_FD) {
+        GTEST_SKIP() << "RLIMIT_NOFILE too low for descriptor " << HIGH_FD;
+    }
+
+    std::thread server_thread([this]() {
+        iClientSock = acceptClient();
+        ASSERT_GE(iClientSock, 0) << "Failed to accept client connection.";
+        EchoServerWithDelay(200);
+    });
+
+    int iSock = createClientSocketFrom(TEST_IP, TEST_IP, TEST_PORT);
+    ASSERT_GT(iSock, 0);
+    ASSERT_EQ(dup2(iSock, HIGH_FD), HIGH_FD);
+
+    const char* chMsg = "Hello, server!";
+    ASSERT_EQ(sendMessage(HIGH_FD, chMsg, strlen(chMsg)), (int)strlen(chMsg));
+
+    char chRecvMsg[128] = {0};
+    int iRecvSize = recvMsgTimeout(HIGH_FD, chRecvMsg, sizeof(chRecvMsg), 1500);
+    ASSERT_EQ(std::string(chRecvMsg, iRecvSize > 0 ? iRecvSize : 0), std::string(chMsg));
+
+    close(HIGH_FD);
+    close(iSock);
+    server_thread.join();
+}
+
+/**
+ * @test 커널 RX/TX 타임스탬프 수신 테스트
+ *
+ * 서버 소켓은 RX 타임스탬프를, 클라이언트 소켓은 TX ACK 타임스탬프를 활성화한 뒤
+ * 메시지 한 건에 대한 커널 수신 ~ 애플리케이션, 전송 ~ ACK 지연이 기록되는지 확인합니다.
+ */
+TEST_F(TcpSocketTest, KernelTimestamping)
+{
+    std::thread server_thread([this]() {
+        iClientSock = acceptClient();
+        ASSERT_GE(iClientSock, 0) << "Failed to accept client connection.";
+        // accept()로 받은 소켓은 연결 테이블에 없으므로 등록한 뒤에만 활성화됨
+        long long llOpen = getMetricGauge(TCP_GAUGE_OPEN_CONNECTIONS);
+        ASSERT_EQ(enableSocketTimestamping(iClientSock, TCP_TSTAMP_RX), -1);
+        ASSERT_EQ(getMetricGauge(TCP_GAUGE_OPEN_CONNECTIONS), llOpen);
+        ASSERT_NE(registerConnInfo(iClientSock), nullptr);
+        ASSERT_EQ(enableSocketTimestamping(iClientSock, TCP_TSTAMP_RX), 0);
+
+        char chBuffer[128] = {0};
+        TcpRxTimestamp stRxStamp;
+        int iRecvSize = recvMsgTimestamped(iClientSock, chBuffer, sizeof(chBuffer), &stRxStamp);
+        ASSERT_GT(iRecvSize, 0);
+        ASSERT_NE(stRxStamp.stSoftware.tv_sec, 0) << "No RX software timestamp.";
+    });
+
+    int iSock = createClientSocket(TEST_IP, TEST_PORT);
+    ASSERT_GT(iSock, 0);
+    ASSERT_EQ(enableSocketTimestamping(iSock, TCP_TSTAMP_TX), 0);
+
+    // 서버가 RX 타임스탬프를 활성화할 시간을 줌
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    unsigned long long ullAckCount = getMetricHistogram(TCP_METRIC_APP_TO_ACK)->ullCount;
+    const char* chMsg = "Hello, server!";
+    ASSERT_EQ(sendMessage(iSock, chMsg, strlen(chMsg)), (int)strlen(chMsg));
+
+    struct pollfd stPollFd = {iSock, 0, 0};
+    ASSERT_EQ(poll(&stPollFd, 1, 1000), 1);
+    ASSERT_TRUE(stPollFd.revents & POLLERR);
+
+    TcpTxTimestamp stTxStamp;
+    ASSERT_EQ(readTxTimestamp(iSock, &stTxStamp), 1);
+    ASSERT_EQ(stTxStamp.uiId, strlen(chMsg) - 1);
+    ASSERT_GT(stTxStamp.ullAppToAckNsec, 0ULL);
+    ASSERT_EQ(getMetricHistogram(TCP_METRIC_APP_TO_ACK)->ullCount, ullAckCount + 1);
+    ASSERT_EQ(readTxTimestamp(iSock, &stTxStamp), 0);
+
+    // 다시 활성화해도 커널이 ID를 이어 세므로 다음 전송의 ACK가 그 전송과 짝지어짐
+    ASSERT_EQ(enableSocketTimestamping(iSock, TCP_TSTAMP_TX | TCP_TSTAMP_RX), 0);
+    ASSERT_EQ(sendMessage(iSock, chMsg, strlen(chMsg)), (int)strlen(chMsg));
+    ASSERT_EQ(poll(&stPollFd, 1, 1000), 1);
+    ASSERT_EQ(readTxTimestamp(iSock, &stTxStamp), 1);
+    ASSERT_EQ(stTxStamp.uiId, 2 * strlen(chMsg) - 1);
+    ASSERT_GT(stTxStamp.ullAppToAckNsec, 0ULL);
+
+    // TX 타임스탬프를 끄면 대기열도 해제됨
+    ASSERT_EQ(enableSocketTimestamping(iSock, TCP_TSTAMP_RX), 0);
+    ASSERT_EQ(findConnInfo(iSock)->pstTxStamps, nullptr);
+
+    server_thread.join();
+    close(iSock);
+}
+
+/**
+ * @brief 연결 경쟁 테스트용 주소 목록 항목을 만듭니다.
+ */
+static void makeLoopbackAddr(struct sockaddr_storage *pstStorage, int iPort)
+{
+    struct sockaddr_in *pstIn = (struct sockaddr_in *)pstStorage;
+    memset(pstStorage, 0, sizeof(*pstStorage));
+    pstIn->sin_family = AF_INET;
+    pstIn->sin_port = htons(iPort);
+    pstIn->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+/**
+ * @brief SYN에 응답하지 않는 주소를 만듭니다.
+ *
+ * backlog 0인 수신 대기 소켓의 accept 큐를 연결 하나로 채우면 이후의 SYN은 버려지므로,
+ * 그 포트로의 연결은 응답 없는 경로처럼 멈춥니다.
+ *
+ * @return 포트 번호 (piListen, piFiller에 닫아야 할 소켓을 돌려줌)
+ */
+static int makeStalledPort(int *piListen, int *piFiller)
+{
+    struct sockaddr_storage stAddr;
+    socklen_t uiLen = sizeof(stAddr);
+
+    makeLoopbackAddr(&stAddr, 0);
+    *piListen = socket(AF_INET, SOCK_STREAM, 0);
+    bind(*piListen, (struct sockaddr *)&stAddr, sizeof(struct sockaddr_in));
+    listen(*piListen, 0);
+    getsockname(*piListen, (struct sockaddr *)&stAddr, &uiLen);
+    int iPort = ntohs(((struct sockaddr_in *)&stAddr)->sin_port);
+    *piFiller = createClientSocketAddr((struct sockaddr *)&stAddr, sizeof(struct sockaddr_in));
+    return iPort;
+}
+
+static int getPeerPort(int iSock)
+{
+    struct sockaddr_in stPeer;
+    socklen_t uiLen = sizeof(stPeer);
+    getpeername(iSock, (struct sockaddr *)&stPeer, &uiLen);
+    return ntohs(stPeer.sin_port);
+}
+
+/**
+ * @test 응답 없는 첫 주소를 건너뛰는 연결 경쟁 테스트
+ *
+ * 첫 주소가 멈춰 있어도 시도 간격 뒤에 시작한 두 번째 주소로 연결되고, 연결 지연이 첫 주소의
+ * 시간 초과가 아니라 간격 정도인지 확인합니다. 반환한 소켓은 블로킹 모드여야 합니다.
+ */
+TEST_F(TcpSocketTest, ConnectRace_SkipsStalledAddress)
+{
+    int iListen;
+    int iFiller;
+    struct sockaddr_storage astAddrs[2];
+    makeLoopbackAddr(&astAddrs[0], makeStalledPort(&iListen, &iFiller));
+    makeLoopbackAddr(&astAddrs[1], TEST_PORT);
+    ASSERT_GE(iFiller, 0);
+
+    unsigned long long ullStart = getMonotonicNsec();
+    int iSock = createClientSocketRace(astAddrs, 2, 50, 5000);
+    unsigned long long ullElapsed = getMonotonicNsec() - ullStart;
+    ASSERT_GE(iSock, 0);
+    ASSERT_EQ(getPeerPort(iSock), TEST_PORT);
+    ASSERT_GE(ullElapsed, 45ULL * 1000000ULL);
+    ASSERT_LT(ullElapsed, 1000ULL * 1000000ULL);
+    ASSERT_FALSE(fcntl(iSock, F_GETFL) & O_NONBLOCK);
+
+    close(iSock);
+    close(iFiller);
+    close(iListen);
+}
+
+/**
+ * @test 실패한 시도 뒤에 간격을 기다리지 않는지, 전체 제한 시간을 지키는지 테스트
+ */
+TEST_F(TcpSocketTest, ConnectRace_FailuresAndTimeout)
+{
+    int iListen;
+    int iFiller;
+    int iStalledPort = makeStalledPort(&iListen, &iFiller);
+    struct sockaddr_storage astAddrs[2];
+
+    // 닫힌 포트는 바로 거부되므로 5초 간격을 기다리지 않고 다음 주소로 연결
+    int iClosed = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_storage stClosed;
+    socklen_t uiLen = sizeof(stClosed);
+    makeLoopbackAddr(&stClosed, 0);
+    bind(iClosed, (struct sockaddr *)&stClosed, sizeof(struct sockaddr_in));
+    getsockname(iClosed, (struct sockaddr *)&stClosed, &uiLen);
+    makeLoopbackAddr(&astAddrs[0], ntohs(((struct sockaddr_in *)&stClosed)->sin_port));
+    makeLoopbackAddr(&astAddrs[1], TEST_PORT);
+
+    unsigned long long ullStart = getMonotonicNsec();
+    int iSock = createClientSocketRace(astAddrs, 2, 5000, 0);
+    ASSERT_GE(iSock, 0);
+    ASSERT_LT(getMonotonicNsec() - ullStart, 1000ULL * 1000000ULL);
+    close(iSock);
+
+    // 모든 주소가 멈춰 있으면 제한 시간에 실패
+    makeLoopbackAddr(&astAddrs[0], iStalledPort);
+    makeLoopbackAddr(&astAddrs[1], iStalledPort);
+    ullStart = getMonotonicNsec();
+    ASSERT_EQ(createClientSocketRace(astAddrs, 2, 50, 200), -1);
+    unsigned long long ullElapsed = getMonotonicNsec() - ullStart;
+    ASSERT_GE(ullElapsed, 195ULL * 1000000ULL);
+    ASSERT_LT(ullElapsed, 2000ULL * 1000000ULL);
+
+    close(iClosed);
+    close(iFiller);
+    close(iListen);
+}
 #endif
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
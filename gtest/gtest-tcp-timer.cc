@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "tcp-timer.h"
+#include <string.h>
+
+#define TIMER_TEST_TICK_NSEC    1000ULL
+#define TIMER_TEST_SLOTS        8
+
+static int g_aiFired[4];
+static int g_iFireOrder;
+
+static void recordFire(TcpTimer *pstTimer, void *pvArg)
+{
+    (void)pstTimer;
+    g_aiFired[(long)pvArg] = ++g_iFireOrder;
+}
+
+static void rearmSelf(TcpTimer *pstTimer, void *pvArg)
+{
+    TcpTimerWheel *pstWheel = (TcpTimerWheel *)pvArg;
+    if (++g_iFireOrder < 3) {
+        armTimer(pstWheel, pstTimer, pstWheel->ullStartNsec + (pstWheel->ullCurrentTick + 2) * TIMER_TEST_TICK_NSEC);
+    }
+}
+
+
+/**
+ * @test 설정/취소/만료 시각과 바퀴 수를 넘는 타이머를 테스트
+ */
+TEST(TcpTimerTest, ArmCancelAdvance)
+{
+    TcpTimerWheel stWheel;
+    TcpTimer astTimers[4];
+
+    ASSERT_EQ(initTimerWheel(&stWheel, 6, TIMER_TEST_TICK_NSEC, 0), -1);
+    ASSERT_EQ(initTimerWheel(&stWheel, TIMER_TEST_SLOTS, TIMER_TEST_TICK_NSEC, 0), 0);
+    memset(g_aiFired, 0, sizeof(g_aiFired));
+    g_iFireOrder = 0;
+    for (long i = 0; i < 4; i++) {
+        initTimer(&astTimers[i], recordFire, (void *)i);
+    }
+
+    armTimer(&stWheel, &astTimers[0], 3 * TIMER_TEST_TICK_NSEC);
+    armTimer(&stWheel, &astTimers[1], 2500);            // 3틱으로 올림
+    armTimer(&stWheel, &astTimers[2], 5 * TIMER_TEST_TICK_NSEC);
+    armTimer(&stWheel, &astTimers[3], 20 * TIMER_TEST_TICK_NSEC);   // 두 바퀴 뒤, 같은 슬롯
+    ASSERT_EQ(stWheel.uiArmed, 4U);
+    cancelTimer(&stWheel, &astTimers[2]);
+    cancelTimer(&stWheel, &astTimers[2]);
+    ASSERT_EQ(stWheel.uiArmed, 3U);
+    ASSERT_EQ(getNextTimerExpiry(&stWheel), 3 * TIMER_TEST_TICK_NSEC);
+
+    ASSERT_EQ(advanceTimerWheel(&stWheel, 2999), 0);
+    ASSERT_EQ(advanceTimerWheel(&stWheel, 3000), 2);
+    ASSERT_GT(g_aiFired[0], 0);
+    ASSERT_GT(g_aiFired[1], 0);
+    ASSERT_EQ(g_aiFired[2], 0);
+
+    // 한 바퀴 지난 슬롯을 지나도 바퀴 수가 남은 타이머는 만료되지 않음
+    ASSERT_EQ(advanceTimerWheel(&stWheel, 12 * TIMER_TEST_TICK_NSEC), 0);
+    ASSERT_EQ(g_aiFired[3], 0);
+    ASSERT_EQ(advanceTimerWheel(&stWheel, 100 * TIMER_TEST_TICK_NSEC), 1);
+    ASSERT_EQ(g_aiFired[3], 3);
+    ASSERT_EQ(stWheel.uiArmed, 0U);
+    ASSERT_EQ(getNextTimerExpiry(&stWheel), 0ULL);
+
+    destroyTimerWheel(&stWheel);
+}
+
+/**
+ * @test 콜백 안에서 같은 타이머를 다시 설정할 수 있는지 테스트
+ */
+TEST(TcpTimerTest, RearmFromCallback)
+{
+    TcpTimerWheel stWheel;
+    TcpTimer stTimer;
+
+    ASSERT_EQ(initTimerWheel(&stWheel, TIMER_TEST_SLOTS, TIMER_TEST_TICK_NSEC, 0), 0);
+    g_iFireOrder = 0;
+    initTimer(&stTimer, rearmSelf, &stWheel);
+    armTimer(&stWheel, &stTimer, 0);
+
+    int iFired = 0;
+    for (unsigned long long ullNow = 0; ullNow <= 20 * TIMER_TEST_TICK_NSEC; ullNow += TIMER_TEST_TICK_NSEC) {
+        iFired += advanceTimerWheel(&stWheel, ullNow);
+    }
+    ASSERT_EQ(iFired, 3);
+    ASSERT_EQ(stWheel.uiArmed, 0U);
+    destroyTimerWheel(&stWheel);
+}
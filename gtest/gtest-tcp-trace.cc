@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "tcp-sock.h"
+#include "tcp-frame.h"
+#include "tcp-trace.h"
+#include "tcp-metrics.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+/**
+ * @test 샘플링 비율에 따른 추적 시작 테스트
+ */
+TEST(TcpTraceTest, SampleRate)
+{
+    TcpTraceContext stCtx;
+
+    setTraceSampleRate(0);
+    ASSERT_EQ(startTrace(&stCtx), 0);
+    ASSERT_FALSE(TCP_TRACE_SAMPLED(&stCtx));
+
+    setTraceSampleRate(1);
+    ASSERT_EQ(startTrace(&stCtx), 1);
+    ASSERT_TRUE(TCP_TRACE_SAMPLED(&stCtx));
+
+    TcpTraceContext stChild;
+    newChildSpan(&stCtx, &stChild);
+    ASSERT_EQ(memcmp(stChild.aucTraceId, stCtx.aucTraceId, TCP_TRACE_ID_SIZE), 0);
+    ASSERT_NE(memcmp(stChild.aucSpanId, stCtx.aucSpanId, TCP_SPAN_ID_SIZE), 0);
+    ASSERT_EQ(stChild.ucFlags, stCtx.ucFlags);
+
+    setTraceSampleRate(0);
+}
+
+/**
+ * @test 샘플링된 프레임 송수신 스팬이 JSON 파일로 내보내지는지 테스트
+ */
+TEST(TcpTraceTest, ExportSpans)
+{
+    int aiSockPair[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+
+    setTraceSampleRate(1);
+    clearTraceSpans();
+
+    TcpTraceContext stCtx;
+    ASSERT_EQ(startTrace(&stCtx), 1);
+    ASSERT_EQ(sendFrame(aiSockPair[1], "traced", 6, &stCtx), 6);
+
+    char chBuffer[16];
+    TcpFrameHeader stHeader;
+    ASSERT_EQ(recvFrame(aiSockPair[0], chBuffer, sizeof(chBuffer), &stHeader), 6);
+
+    unsigned long long ullStart = getMonotonicNsec();
+    recordSpan(&stHeader.stTrace, TCP_SPAN_HANDLER, aiSockPair[0], 6, ullStart, getMonotonicNsec());
+
+    // 샘플링되지 않은 컨텍스트는 기록되지 않음
+    TcpTraceContext stUnsampled;
+    memset(&stUnsampled, 0, sizeof(stUnsampled));
+    recordSpan(&stUnsampled, TCP_SPAN_HANDLER, aiSockPair[0], 6, ullStart, getMonotonicNsec());
+
+    char achPath[] = "/tmp/tcp-trace-XXXXXX";
+    int iFd = mkstemp(achPath);
+    ASSERT_GE(iFd, 0);
+    close(iFd);
+
+    ASSERT_EQ(exportTraceSpans(achPath), 4);
+
+    std::ifstream stream(achPath);
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    std::string strJson = ss.str();
+    ASSERT_NE(strJson.find("\"traceEvents\""), std::string::npos);
+    ASSERT_NE(strJson.find("\"name\":\"enqueue\""), std::string::npos);
+    ASSERT_NE(strJson.find("\"name\":\"send\""), std::string::npos);
+    ASSERT_NE(strJson.find("\"name\":\"recv\""), std::string::npos);
+    ASSERT_NE(strJson.find("\"name\":\"handler\""), std::string::npos);
+
+    clearTraceSpans();
+    ASSERT_EQ(exportTraceSpans(achPath), 0);
+
+    unlink(achPath);
+    setTraceSampleRate(0);
+    close(aiSockPair[0]);
+    close(aiSockPair[1]);
+}
+
+/**
+ * @test 종료한 스레드의 스팬 버퍼를 재사용해도 이전 스팬이 원래 스레드로 내보내지는지 테스트
+ */
+TEST(TcpTraceTest, ReusesExitedThreadBuffers)
+{
+    TcpTraceContext stCtx;
+    int aiTids[2] = {0, 0};
+
+    setTraceSampleRate(1);
+    ASSERT_EQ(startTrace(&stCtx), 1);
+    clearTraceSpans();
+    for (int i = 0; i < 2; i++) {
+        std::thread worker([&stCtx, &aiTids, i]() {
+            aiTids[i] = (int)syscall(SYS_gettid);
+            recordSpan(&stCtx, TCP_SPAN_HANDLER, -1, 0, getMonotonicNsec(), getMonotonicNsec());
+        });
+        worker.join();
+    }
+
+    char achPath[] = "/tmp/tcp-trace-XXXXXX";
+    int iFd = mkstemp(achPath);
+    ASSERT_GE(iFd, 0);
+    close(iFd);
+    ASSERT_EQ(exportTraceSpans(achPath), 2);
+
+    std::ifstream stream(achPath);
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    std::string strJson = ss.str();
+    for (int i = 0; i < 2; i++) {
+        ASSERT_NE(strJson.find("\"tid\":" + std::to_string(aiTids[i]) + ","), std::string::npos);
+    }
+
+    clearTraceSpans();
+    unlink(achPath);
+    setTraceSampleRate(0);
+}
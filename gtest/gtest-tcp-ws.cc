@@ -0,0 +1,342 @@
+#include <gtest/gtest.h>
+#include "tcp-ws.h"
+#include "tcp-sock.h"
+#include <thread>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * @brief WebSocket 코덱 테스트 클래스
+ *
+ * socketpair()의 한쪽을 서버(코덱), 다른 쪽을 직접 프레임을 만드는 클라이언트로 사용합니다.
+ */
+class TcpWsTest : public ::testing::Test
+{
+protected:
+    int aiSockPair[2];
+    std::vector<unsigned char> vecBuffer;
+    TcpWsConn stConn;
+
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, aiSockPair), 0);
+        vecBuffer.resize(128 * 1024);
+        initWsConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+    }
+
+    void TearDown() override {
+        close(aiSockPair[0]);
+        close(aiSockPair[1]);
+    }
+
+    // 클라이언트 -> 서버 프레임 (마스크 적용)
+    std::string makeClientFrame(unsigned char ucOpcode, int iFin, const std::string &strPayload) {
+        static const unsigned char s_aucMask[4] = {0x37, 0xfa, 0x21, 0x3d};
+        unsigned char aucHeader[TCP_WS_MAX_HEADER];
+        int iHeader = encodeWsFrameHeader(aucHeader, ucOpcode, iFin, strPayload.size(), s_aucMask);
+        std::string strPayloadMasked = strPayload;
+        maskWsPayload(&strPayloadMasked[0], strPayloadMasked.size(), s_aucMask, 0);
+        return std::string((const char *)aucHeader, iHeader) + strPayloadMasked;
+    }
+
+    void writeClient(const std::string &strData) {
+        ASSERT_EQ(write(aiSockPair[1], strData.data(), strData.size()), (ssize_t)strData.size());
+    }
+
+    std::string readClient(size_t uiLength) {
+        std::string strData(uiLength, '\0');
+        size_t uiDone = 0;
+        while (uiDone < uiLength) {
+            ssize_t received = read(aiSockPair[1], &strData[uiDone], uiLength - uiDone);
+            if (received <= 0) {
+                break;
+            }
+            uiDone += (size_t)received;
+        }
+        strData.resize(uiDone);
+        return strData;
+    }
+
+    // 빈 줄까지의 HTTP 응답
+    std::string readResponse() {
+        std::string strResponse;
+        while (strResponse.find("\r\n\r\n") == std::string::npos) {
+            std::string strByte = readClient(1);
+            if (strByte.empty()) {
+                break;
+            }
+            strResponse += strByte;
+        }
+        return strResponse;
+    }
+
+    // 서버 -> 클라이언트 프레임 하나 (마스크 없음)
+    std::string readServerFrame(unsigned char *pucOpcode) {
+        std::string strHeader = readClient(2);
+        if (strHeader.size() < 2) {
+            return "";
+        }
+        size_t uiExtra = ((unsigned char)strHeader[1] == 126) ? 2 : ((unsigned char)strHeader[1] == 127) ? 8 : 0;
+        strHeader += readClient(uiExtra);
+        TcpWsFrameHeader stHeader;
+        if (parseWsFrameHeader(strHeader.data(), strHeader.size(), &stHeader) <= 0) {
+            return "";
+        }
+        *pucOpcode = stHeader.ucOpcode;
+        return readClient((size_t)stHeader.ullPayloadLength);
+    }
+};
+
+static const char *g_kpchUpgrade =
+    "GET /chat HTTP/1.1\r\n"
+    "Host: server.example.com\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: keep-alive, Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Version: 13\r\n"
+    "\r\n";
+
+
+/**
+ * @test RFC 6455 예시 키로 Sec-WebSocket-Accept 값을 계산하는지 테스트
+ */
+TEST(TcpWsCodecTest, AcceptKeyMatchesRfcExample)
+{
+    const char *kpchKey = "dGhlIHNhbXBsZSBub25jZQ==";
+    char achAccept[TCP_WS_ACCEPT_KEY_SIZE + 1];
+
+    computeWsAcceptKey(kpchKey, strlen(kpchKey), achAccept);
+    ASSERT_STREQ(achAccept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+/**
+ * @test SIMD 마스크 적용이 길이, 시작 위상, 정렬과 관계없이 바이트 단위 계산과 같은지 테스트
+ */
+TEST(TcpWsCodecTest, MaskMatchesScalarReference)
+{
+    const unsigned char aucMask[4] = {0x12, 0x34, 0x56, 0x78};
+    unsigned char aucData[300];
+    unsigned char aucExpected[300];
+
+    for (size_t uiAlign = 0; uiAlign < 4; uiAlign++) {
+        for (size_t uiLength = 0; uiLength + uiAlign <= sizeof(aucData); uiLength += 7) {
+            for (size_t uiOffset = 0; uiOffset < 4; uiOffset++) {
+                for (size_t i = 0; i < sizeof(aucData); i++) {
+                    aucData[i] = (unsigned char)(i * 31 + uiLength);
+                }
+                memcpy(aucExpected, aucData, sizeof(aucData));
+                for (size_t i = 0; i < uiLength; i++) {
+                    aucExpected[uiAlign + i] ^= aucMask[(uiOffset + i) & 3];
+                }
+                maskWsPayload(aucData + uiAlign, uiLength, aucMask, uiOffset);
+                ASSERT_EQ(memcmp(aucData, aucExpected, sizeof(aucData)), 0)
+                    << "align " << uiAlign << " length " << uiLength << " offset " << uiOffset;
+            }
+        }
+    }
+}
+
+/**
+ * @test 길이 형식별 헤더 인코딩/해석과 잘못된 헤더 거부 테스트
+ */
+TEST(TcpWsCodecTest, HeaderRoundTripAndValidation)
+{
+    const unsigned char aucMask[4] = {1, 2, 3, 4};
+    unsigned char aucHeader[TCP_WS_MAX_HEADER];
+    TcpWsFrameHeader stHeader;
+    const unsigned long long aullLengths[] = {0, 125, 126, 65535, 65536, 1ULL << 40};
+
+    for (unsigned long long ullLength : aullLengths) {
+        int iHeader = encodeWsFrameHeader(aucHeader, TCP_WS_OP_BINARY, 1, ullLength, aucMask);
+        ASSERT_EQ(parseWsFrameHeader(aucHeader, iHeader - 1, &stHeader), 0);
+        ASSERT_EQ(parseWsFrameHeader(aucHeader, iHeader, &stHeader), iHeader);
+        ASSERT_EQ(stHeader.ullPayloadLength, ullLength);
+        ASSERT_EQ(stHeader.ucOpcode, TCP_WS_OP_BINARY);
+        ASSERT_EQ(stHeader.ucFin, 1);
+        ASSERT_EQ(stHeader.ucMasked, 1);
+        ASSERT_EQ(memcmp(stHeader.aucMask, aucMask, 4), 0);
+    }
+
+    const unsigned char aucReserved[2] = {0xC1, 0x00};      // RSV1
+    const unsigned char aucOpcode[2] = {0x83, 0x00};        // 예약 opcode
+    const unsigned char aucFragPing[2] = {0x09, 0x00};      // FIN 없는 ping
+    const unsigned char aucLongPing[4] = {0x89, 0x7E, 0x00, 0x7E};
+    ASSERT_EQ(parseWsFrameHeader(aucReserved, 2, &stHeader), -1);
+    ASSERT_EQ(parseWsFrameHeader(aucOpcode, 2, &stHeader), -1);
+    ASSERT_EQ(parseWsFrameHeader(aucFragPing, 2, &stHeader), -1);
+    ASSERT_EQ(parseWsFrameHeader(aucLongPing, 4, &stHeader), -1);
+}
+
+/**
+ * @test 핸드셰이크, 단일/조각/대용량 메시지, ping/pong, close 교환 테스트
+ *
+ * 업그레이드 요청 바로 뒤에 첫 프레임을 붙여 보내, 요청 뒤에 남은 데이터가 프레임으로
+ * 이어서 해석되는지도 확인합니다.
+ */
+TEST_F(TcpWsTest, HandshakeEchoAndClose)
+{
+    std::thread server_thread([this]() {
+        ASSERT_EQ(acceptWsHandshake(&stConn), 1);
+        ASSERT_STREQ(stConn.achPath, "/chat");
+
+        TcpWsMessage stMessage;
+        int iOpcode;
+        while ((iOpcode = recvWsMessage(&stConn, &stMessage)) > 0) {
+            ASSERT_EQ(sendWsMessage(stConn.iSock, stMessage.ucOpcode, stMessage.pvData, stMessage.uiLength),
+                      (int)stMessage.uiLength);
+        }
+        ASSERT_EQ(iOpcode, TCP_DISCONNECTION);
+        ASSERT_EQ(stConn.usCloseCode, TCP_WS_CLOSE_NORMAL);
+    });
+
+    writeClient(std::string(g_kpchUpgrade) + makeClientFrame(TCP_WS_OP_TEXT, 1, "hello"));
+
+    std::string strResponse = readResponse();
+    ASSERT_EQ(strResponse.compare(0, 12, "HTTP/1.1 101"), 0);
+    ASSERT_NE(strResponse.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"), std::string::npos);
+
+    unsigned char ucOpcode = 0;
+    ASSERT_EQ(readServerFrame(&ucOpcode), "hello");
+    ASSERT_EQ(ucOpcode, TCP_WS_OP_TEXT);
+
+    // 조각 메시지 사이에 ping
+    writeClient(makeClientFrame(TCP_WS_OP_BINARY, 0, "abc") + makeClientFrame(TCP_WS_OP_PING, 1, "p")
+                + makeClientFrame(TCP_WS_OP_CONTINUATION, 0, "de")
+                + makeClientFrame(TCP_WS_OP_CONTINUATION, 1, "fg"));
+    ASSERT_EQ(readServerFrame(&ucOpcode), "p");
+    ASSERT_EQ(ucOpcode, TCP_WS_OP_PONG);
+    ASSERT_EQ(readServerFrame(&ucOpcode), "abcdefg");
+    ASSERT_EQ(ucOpcode, TCP_WS_OP_BINARY);
+
+    // 64비트 길이 형식의 큰 메시지
+    std::string strLarge(70000, '\0');
+    for (size_t i = 0; i < strLarge.size(); i++) {
+        strLarge[i] = (char)(i * 7);
+    }
+    writeClient(makeClientFrame(TCP_WS_OP_BINARY, 1, strLarge));
+    ASSERT_EQ(readServerFrame(&ucOpcode), strLarge);
+
+    writeClient(makeClientFrame(TCP_WS_OP_CLOSE, 1, std::string("\x03\xe8", 2)));
+    ASSERT_EQ(readServerFrame(&ucOpcode), std::string("\x03\xe8", 2));
+    ASSERT_EQ(ucOpcode, TCP_WS_OP_CLOSE);
+
+    server_thread.join();
+}
+
+/**
+ * @test 잘못된 업그레이드 요청에 400/426 응답을 보내는지 테스트
+ */
+TEST_F(TcpWsTest, RejectsInvalidHandshake)
+{
+    writeClient("GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 8\r\n"
+                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n");
+    ASSERT_EQ(acceptWsHandshake(&stConn), -1);
+    std::string strResponse = readResponse();
+    ASSERT_EQ(strResponse.compare(0, 12, "HTTP/1.1 426"), 0);
+    ASSERT_NE(strResponse.find("Sec-WebSocket-Version: 13\r\n"), std::string::npos);
+
+    initWsConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+    writeClient("GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 13\r\n\r\n");
+    ASSERT_EQ(acceptWsHandshake(&stConn), -1);
+    ASSERT_EQ(readResponse().compare(0, 12, "HTTP/1.1 400"), 0);
+}
+
+/**
+ * @test 빈 줄 전에 연결이 끊기면 성공과 구분되는 TCP_DISCONNECTION을 반환하는지 테스트
+ */
+TEST_F(TcpWsTest, DisconnectBeforeRequestEnds)
+{
+    writeClient("GET /chat HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n");
+    shutdown(aiSockPair[1], SHUT_WR);
+    ASSERT_EQ(acceptWsHandshake(&stConn), TCP_DISCONNECTION);
+}
+
+/**
+ * @test 마스크되지 않은 프레임과 버퍼보다 큰 메시지에 close(1002/1009)로 응답하는지 테스트
+ */
+TEST_F(TcpWsTest, ClosesOnProtocolErrors)
+{
+    TcpWsMessage stMessage;
+    unsigned char aucHeader[TCP_WS_MAX_HEADER];
+    unsigned char ucOpcode = 0;
+
+    int iHeader = encodeWsFrameHeader(aucHeader, TCP_WS_OP_TEXT, 1, 2, NULL);
+    writeClient(std::string((const char *)aucHeader, iHeader) + "hi");
+    ASSERT_EQ(recvWsMessage(&stConn, &stMessage), -1);
+    ASSERT_EQ(readServerFrame(&ucOpcode), std::string("\x03\xea", 2));
+    ASSERT_EQ(ucOpcode, TCP_WS_OP_CLOSE);
+
+    std::vector<unsigned char> vecSmall(64);
+    initWsConn(&stConn, aiSockPair[0], vecSmall.data(), vecSmall.size());
+    writeClient(makeClientFrame(TCP_WS_OP_BINARY, 1, std::string(100, 'x')));
+    ASSERT_EQ(recvWsMessage(&stConn, &stMessage), -1);
+    ASSERT_EQ(readServerFrame(&ucOpcode), std::string("\x03\xf1", 2));
+}
+
+/**
+ * @test 잘못된 UTF-8 텍스트에 1007, 보낼 수 없는 close 코드에 1002로 응답하는지 테스트
+ */
+TEST_F(TcpWsTest, ValidatesUtf8AndCloseCodes)
+{
+    TcpWsMessage stMessage;
+    unsigned char ucOpcode = 0;
+
+    // 올바른 2~4바이트 문자, 조각 경계에 걸친 문자
+    writeClient(makeClientFrame(TCP_WS_OP_TEXT, 1, "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80"));
+    ASSERT_EQ(recvWsMessage(&stConn, &stMessage), TCP_WS_OP_TEXT);
+    writeClient(makeClientFrame(TCP_WS_OP_TEXT, 0, "\xe2\x82") + makeClientFrame(TCP_WS_OP_CONTINUATION, 1, "\xac"));
+    ASSERT_EQ(recvWsMessage(&stConn, &stMessage), TCP_WS_OP_TEXT);
+    ASSERT_EQ(std::string((const char *)stMessage.pvData, stMessage.uiLength), "\xe2\x82\xac");
+    // 바이너리 메시지는 검사하지 않음
+    writeClient(makeClientFrame(TCP_WS_OP_BINARY, 1, "\xff"));
+    ASSERT_EQ(recvWsMessage(&stConn, &stMessage), TCP_WS_OP_BINARY);
+
+    const std::string kastBadText[] = {
+        "\xff",                     // 시작 바이트가 될 수 없음
+        "\xc0\xaf",                 // 과잉 표현
+        "\xe0\x80\xaf",             // 과잉 표현
+        "\xed\xa0\x80",             // 서로게이트
+        "\xf4\x90\x80\x80",         // U+10FFFF 초과
+        "abcdefgh\xe2\x82",         // 잘린 문자
+    };
+    for (const std::string &kstrText : kastBadText) {
+        initWsConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+        writeClient(makeClientFrame(TCP_WS_OP_TEXT, 1, kstrText));
+        ASSERT_EQ(recvWsMessage(&stConn, &stMessage), -1);
+        ASSERT_EQ(readServerFrame(&ucOpcode), std::string("\x03\xef", 2));
+        ASSERT_EQ(ucOpcode, TCP_WS_OP_CLOSE);
+    }
+
+    // 조각난 텍스트는 다 이어 붙인 뒤 검사
+    initWsConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+    writeClient(makeClientFrame(TCP_WS_OP_TEXT, 0, "\xed") + makeClientFrame(TCP_WS_OP_CONTINUATION, 1, "\xa0\x80"));
+    ASSERT_EQ(recvWsMessage(&stConn, &stMessage), -1);
+    ASSERT_EQ(readServerFrame(&ucOpcode), std::string("\x03\xef", 2));
+
+    // 프레임에 담을 수 없거나 정의되지 않은 close 코드
+    const unsigned short kausBadCodes[] = { 0, 999, 1004, 1005, 1006, 1015, 2000, 2999, 5000 };
+    for (unsigned short usCode : kausBadCodes) {
+        initWsConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+        std::string strPayload = { (char)(usCode >> 8), (char)(usCode & 0xff) };
+        writeClient(makeClientFrame(TCP_WS_OP_CLOSE, 1, strPayload));
+        ASSERT_EQ(recvWsMessage(&stConn, &stMessage), -1) << usCode;
+        ASSERT_EQ(readServerFrame(&ucOpcode), std::string("\x03\xea", 2)) << usCode;
+    }
+
+    // close 사유도 UTF-8이어야 함
+    initWsConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+    writeClient(makeClientFrame(TCP_WS_OP_CLOSE, 1, std::string("\x03\xe8\xff", 3)));
+    ASSERT_EQ(recvWsMessage(&stConn, &stMessage), -1);
+    ASSERT_EQ(readServerFrame(&ucOpcode), std::string("\x03\xef", 2));
+
+    // 애플리케이션 범위 코드와 올바른 사유는 그대로 응답
+    initWsConn(&stConn, aiSockPair[0], vecBuffer.data(), vecBuffer.size());
+    writeClient(makeClientFrame(TCP_WS_OP_CLOSE, 1, std::string("\x0f\xa0" "bye", 5)));
+    ASSERT_EQ(recvWsMessage(&stConn, &stMessage), TCP_DISCONNECTION);
+    ASSERT_EQ(stConn.usCloseCode, 4000);
+    ASSERT_EQ(readServerFrame(&ucOpcode), std::string("\x0f\xa0", 2));
+}
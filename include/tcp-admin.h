@@ -0,0 +1,59 @@
+#ifndef TCP_ADMIN_H
+#define TCP_ADMIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+/**
+ * @brief   관리 서버가 한 번에 덤프하는 최대 연결 수 (넘으면 "# truncated" 줄을 출력)
+ */
+#define TCP_ADMIN_MAX_CONNS     65536
+
+/**
+ * @brief 관리(introspection) 서버를 시작합니다.
+ *
+ * @details 별도 스레드에서 UNIX 도메인 소켓 또는 루프백(127.0.0.1) TCP 포트로 접속을 받아,
+ *          접속마다 writeAdminDump()의 결과를 고정 크기 조각으로 나누어 전송한 뒤 연결을 닫습니다.
+ *          2초 안에 덤프를 모두 읽지 않는 클라이언트는 연결을 끊습니다.
+ *          연결 테이블은 시퀀스 잠금 스냅샷으로 읽으므로 송수신 스레드를 멈추지 않습니다.
+ *          관리 연결 자체는 연결 테이블과 카운터에 기록되지 않습니다.
+ *
+ * 사용 예: socat - UNIX-CONNECT:/run/app.admin 또는 nc 127.0.0.1 <포트>
+ *
+ * @param kpchUdsPath UNIX 도메인 소켓 경로 (NULL이면 iPort 사용)
+ * @param iPort 루프백 TCP 포트 (kpchUdsPath가 NULL일 때만 사용)
+ * @return 성공 시 수신 대기 소켓 디스크립터, 실패 또는 이미 실행 중이면 -1 반환
+ */
+int startAdminServer(const char *, int);
+
+/**
+ * @brief 관리 서버를 중지하고 스레드가 끝날 때까지 기다립니다.
+ *
+ * @details UNIX 도메인 소켓 경로는 삭제됩니다.
+ */
+void stopAdminServer(void);
+
+/**
+ * @brief 프로세스 요약, 스레드별 카운터, 연결 테이블을 텍스트로 기록합니다.
+ *
+ * @details 연결마다 fd, 상대 주소, 경과/유휴 시간, 송수신 바이트, 수신/전송 큐 깊이,
+ *          TCP_INFO의 RTT/혼잡 윈도우, 소유 스레드, CPU 비용을 한 줄로 출력하며,
+ *          CPU 비용 측정이 켜져 있으면 비용이 큰 연결 목록도 함께 출력합니다. 연결 테이블은
+ *          고정 크기 배치로 나누어 읽으며 출력하고, TCP_ADMIN_MAX_CONNS개를 넘으면 나머지를 생략하고
+ *          "# truncated after N connections" 줄을 남깁니다.
+ *          큐 깊이와 TCP_INFO는 스냅샷을 읽은 뒤 fd로 조회하므로, 조회 후 연결 식별자(등록 시각)를
+ *          다시 확인하여 그 사이 연결이 닫히거나 번호가 재사용된 연결의 줄은 출력하지 않습니다.
+ *
+ * @param pFile 출력 스트림
+ * @return 출력한 연결 수, 실패 시 -1 반환
+ */
+int writeAdminDump(FILE *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
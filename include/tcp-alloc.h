@@ -0,0 +1,93 @@
+#ifndef TCP_ALLOC_H
+#define TCP_ALLOC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief   스레드마다 기록하는 위반 호출 위치의 최대 개수
+ * @details 서로 다른 위치가 이보다 많으면 나머지는 위반 수에만 더해집니다.
+ */
+#define TCP_ALLOC_MAX_SITES     16
+
+/**
+ * @brief 스레드별 할당 카운터
+ */
+typedef struct {
+    unsigned long long ullAllocs;   /**< malloc/calloc/realloc/정렬 할당 호출 수 (C++ new 포함) */
+    unsigned long long ullFrees;    /**< NULL이 아닌 포인터의 free 호출 수 */
+    unsigned long long ullBytes;    /**< 요청한 바이트 합계 */
+} TcpAllocCounts;
+
+/**
+ * @brief 할당 감시 중에 발생한 할당의 호출 위치
+ */
+typedef struct {
+    const void *kpvCaller;          /**< 할당 함수를 호출한 위치 (반환 주소) */
+    unsigned long long ullCount;    /**< 이 위치에서의 할당 횟수 */
+    size_t uiLastSize;              /**< 마지막으로 요청한 크기 */
+} TcpAllocSite;
+
+/**
+ * @brief 할당 추적 모드로 빌드되었는지 확인합니다.
+ *
+ * @details TCP_ALLOC_TRACK을 정의하고 빌드한 시험/벤치마크 실행 파일에서는 malloc, calloc,
+ *          realloc, free와 정렬 할당 함수(posix_memalign, aligned_alloc, memalign, valloc, pvalloc)를
+ *          가로채 호출한 스레드의 카운터를 올립니다. 공유 라이브러리 빌드에는
+ *          포함하지 않으며, 이때 다른 함수들은 아무 것도 세지 않습니다.
+ *
+ * @return 추적 중이면 1, 아니면 0
+ */
+int isAllocTrackingEnabled(void);
+
+/**
+ * @brief 호출한 스레드의 할당 카운터를 읽습니다.
+ *
+ * @param pstCounts 결과를 저장할 구조체
+ */
+void getThreadAllocCounts(TcpAllocCounts *);
+
+/**
+ * @brief 호출한 스레드의 할당 감시를 시작합니다.
+ *
+ * @details 워밍업이 끝난 정상 상태 구간에 들어갈 때 호출합니다. 이후 이 스레드의 모든 할당은
+ *          위반으로 세고 호출 위치를 기록합니다. 이전 위반 기록은 지웁니다.
+ */
+void armAllocGuard(void);
+
+/**
+ * @brief 호출한 스레드의 할당 감시를 끝냅니다.
+ *
+ * @return 감시 중에 발생한 할당 수
+ */
+unsigned long long disarmAllocGuard(void);
+
+/**
+ * @brief 마지막 감시 구간의 위반 호출 위치를 복사합니다.
+ *
+ * @param pstSites 결과를 저장할 배열
+ * @param iMax 배열 크기
+ * @return 복사한 위치 수
+ */
+int getAllocViolationSites(TcpAllocSite *, int);
+
+/**
+ * @brief 마지막 감시 구간의 위반 호출 위치를 심볼 이름과 함께 출력합니다.
+ *
+ * @details 심볼은 dladdr()로 찾으므로 실행 파일의 함수 이름까지 보려면 -rdynamic으로 링크합니다.
+ *          모듈 기준 오프셋도 함께 출력하므로 addr2line으로 소스 줄을 찾을 수 있습니다.
+ *
+ * @param pFile 출력 스트림
+ * @param kpchWho 출력 앞에 붙일 이름 (스레드 구분용)
+ */
+void reportAllocViolations(FILE *, const char *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
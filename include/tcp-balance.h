@@ -0,0 +1,285 @@
+#ifndef TCP_BALANCE_H
+#define TCP_BALANCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <pthread.h>
+#include "tcp-resolve.h"
+#include "tcp-metrics.h"
+
+/**
+ * @brief   백엔드 집합의 최대 백엔드 수
+ */
+#define TCP_BALANCE_MAX_BACKENDS    64
+
+/**
+ * @brief   백엔드별로 보관하는 최대 유휴 연결 수
+ */
+#define TCP_BALANCE_POOL_SIZE       8
+
+/**
+ * @brief   엔드포인트 문자열 최대 길이 (NUL 포함)
+ */
+#define TCP_BALANCE_ENDPOINT_MAX    (TCP_RESOLVE_HOST_MAX + 8)
+
+/**
+ * @brief   Maglev 조회 테이블 크기 (소수, 백엔드 수의 100배 이상 권장)
+ */
+#define TCP_BALANCE_TABLE_SIZE      16381
+
+/**
+ * @brief   EWMA 지연 평활 계수 (새 표본 가중치 1/2^N)
+ */
+#define TCP_BALANCE_EWMA_SHIFT      3
+
+/**
+ * @brief   이상치 제외 설정 기본값
+ */
+#define TCP_BALANCE_DEFAULT_MIN_REQUESTS    20      /**< 평가 구간에 이만큼 요청을 처리한 백엔드만 통계로 판정 */
+#define TCP_BALANCE_DEFAULT_CONSECUTIVE     5       /**< 연속 실패가 이만큼이면 바로 제외 */
+#define TCP_BALANCE_DEFAULT_FAILURE_PERCENT 50      /**< 평가 구간 실패율 (%) */
+#define TCP_BALANCE_DEFAULT_LATENCY_FACTOR  300     /**< 집합 p99 중앙값 대비 배율 (%) */
+#define TCP_BALANCE_DEFAULT_LATENCY_FLOOR   1000    /**< 이보다 빠른 p99는 이상치로 보지 않음 (us) */
+#define TCP_BALANCE_DEFAULT_EJECT_TIME      1000    /**< 첫 제외 시간 (ms, 다시 제외될 때마다 두 배) */
+#define TCP_BALANCE_DEFAULT_MAX_EJECT_TIME  30000   /**< 제외 시간 상한 (ms) */
+#define TCP_BALANCE_DEFAULT_MAX_EJECT_PERCENT 50    /**< 동시에 제외할 수 있는 백엔드 비율 (%) */
+#define TCP_BALANCE_DEFAULT_RAMP_TIME       5000    /**< 다시 넣은 뒤 P2C 몫을 되찾는 시간 (ms) */
+
+/**
+ * @brief 키가 없는 요청의 백엔드 선택 방식 (power of two choices)
+ */
+typedef enum {
+    TCP_BALANCE_P2C_INFLIGHT = 0,       /**< 진행 중인 요청 수가 적은 쪽 */
+    TCP_BALANCE_P2C_EWMA,               /**< EWMA 지연 x (진행 중인 요청 수 + 1)이 작은 쪽 */
+} TcpBalancePolicy;
+
+/**
+ * @brief 백엔드 하나의 상태
+ */
+typedef struct {
+    int iActive;                                /**< 집합에 속해 있으면 1 */
+    unsigned int uiGeneration;                  /**< 슬롯을 재사용할 때마다 증가 (이전 연결 구분) */
+    char achEndpoint[TCP_BALANCE_ENDPOINT_MAX]; /**< "host:port" */
+    unsigned int uiOffset;                      /**< Maglev 순열 시작 위치 */
+    unsigned int uiSkip;                        /**< Maglev 순열 간격 */
+    unsigned int uiInFlight;                    /**< 진행 중인 요청 수 */
+    unsigned long long ullEwmaNsec;             /**< 요청 지연 EWMA (0이면 표본 없음) */
+    unsigned long long ullRequests;             /**< 완료한 요청 수 */
+    unsigned long long ullFailures;             /**< 실패한 요청 수 */
+    int iIdle;                                  /**< 유휴 연결 수 */
+    int aiIdle[TCP_BALANCE_POOL_SIZE];          /**< 유휴 연결 (마지막에 반납한 것부터 재사용) */
+    int iEjected;                               /**< 이상치로 제외되어 있으면 1 */
+    unsigned int uiEjections;                   /**< 제외 시간 배수 (건강한 평가 구간마다 1씩 감소) */
+    unsigned int uiConsecutiveFailures;         /**< 연속 실패 수 */
+    unsigned long long ullEjectUntilNsec;       /**< 제외가 끝나 탐침할 시각 */
+    unsigned long long ullRampStartNsec;        /**< 다시 넣은 시각 (0이면 램프 없음) */
+    unsigned long long ullWindowRequests;       /**< 평가 구간에 완료한 요청 수 */
+    unsigned long long ullWindowFailures;       /**< 평가 구간에 실패한 요청 수 */
+    unsigned long long ullLastP99Nsec;          /**< 직전 평가 구간의 p99 지연 (표본이 적으면 0) */
+    TcpHistogram stWindow;                      /**< 평가 구간의 성공 요청 지연 분포 */
+    TcpHistogram stLastWindow;                  /**< 표본이 있던 직전 평가 구간의 지연 분포 */
+} TcpBackend;
+
+/**
+ * @brief 제외된 백엔드를 다시 넣기 전에 새 연결로 상태를 확인하는 함수
+ *
+ * @param iSock 백엔드에 새로 연결한 소켓
+ * @param pvArg 설정에 지정한 인자
+ * @return 건강하면 0, 아니면 -1 (다시 더 오래 제외)
+ */
+typedef int (*TcpBackendProbe)(int, void *);
+
+/**
+ * @brief 이상치 제외 설정 (0이나 NULL인 항목은 기본값 사용)
+ */
+typedef struct {
+    unsigned int uiMinRequests;                 /**< 통계 판정에 필요한 평가 구간 요청 수 */
+    unsigned int uiConsecutiveFailures;         /**< 바로 제외하는 연속 실패 수 */
+    unsigned int uiFailurePercent;              /**< 제외하는 평가 구간 실패율 (%) */
+    unsigned int uiLatencyFactorPercent;        /**< 제외하는 p99 배율 (집합 p99 중앙값 대비 %) */
+    unsigned int uiLatencyFloorUsec;            /**< 이상치로 보는 최소 p99 (us) */
+    unsigned int uiEjectTimeMsec;               /**< 첫 제외 시간 */
+    unsigned int uiMaxEjectTimeMsec;            /**< 제외 시간 상한 */
+    unsigned int uiMaxEjectPercent;             /**< 동시에 제외할 수 있는 백엔드 비율 (%) */
+    unsigned int uiRampTimeMsec;                /**< 다시 넣은 뒤 P2C와 키 있는 요청의 몫을 되찾는 시간 */
+    TcpBackendProbe pfnProbe;                   /**< 탐침 함수 (NULL이면 연결 성공만 확인) */
+    void *pvProbeArg;                           /**< 탐침 함수 인자 */
+} TcpOutlierConfig;
+
+/**
+ * @brief 백엔드 집합과 연결 풀
+ *
+ * @details 백엔드별 Maglev 순열(시작 위치, 간격)은 넣을 때 한 번 계산해 두고, 멤버십이 바뀔 때만
+ *          테이블을 다시 채웁니다. Maglev는 남은 백엔드의 자리를 대부분 유지하므로 백엔드 하나가
+ *          빠지거나 들어올 때 다른 백엔드로 옮겨지는 키는 약 1/N입니다. 이상치로 제외된 백엔드도
+ *          테이블에서 빠지며, 그 키는 제외가 끝나면 돌아옵니다. 모든 함수는 내부 잠금으로 보호되며,
+ *          구조체가 크므로 정적 변수나 힙에 둡니다.
+ */
+typedef struct {
+    pthread_mutex_t stLock;
+    int iPolicy;                                /**< TcpBalancePolicy */
+    unsigned long long ullRandom;               /**< 백엔드 추첨용 xorshift 상태 */
+    TcpOutlierConfig stOutlier;                 /**< 이상치 제외 설정 (기본값 채움) */
+    int iBackends;                              /**< 사용 중인 슬롯 수 (빈 슬롯 포함) */
+    int iMembers;                               /**< 집합에 속한 백엔드 수 (제외된 백엔드 포함) */
+    int iActive;                                /**< 선택 대상 백엔드 수 (제외된 백엔드 빼고) */
+    int aiActive[TCP_BALANCE_MAX_BACKENDS];     /**< 선택 대상 백엔드 슬롯 번호 */
+    TcpBackend astBackends[TCP_BALANCE_MAX_BACKENDS];
+    unsigned long long ullRebuilds;             /**< 테이블 재구성 횟수 */
+    unsigned long long ullEjections;            /**< 이상치 제외 횟수 */
+    short asTable[TCP_BALANCE_TABLE_SIZE];      /**< Maglev 테이블 (백엔드 슬롯 번호, 비었으면 -1) */
+} TcpBalancer;
+
+/**
+ * @brief 풀에서 빌린 연결
+ */
+typedef struct {
+    int iSock;                          /**< 소켓 파일 디스크립터 */
+    int iBackend;                       /**< 백엔드 슬롯 번호 */
+    unsigned int uiGeneration;          /**< 빌릴 때의 백엔드 세대 */
+    unsigned long long ullStartNsec;    /**< 빌린 시각 (지연 측정 시작) */
+} TcpBalanceConn;
+
+/**
+ * @brief 백엔드 집합을 초기화합니다.
+ *
+ * @param pstBalancer 초기화할 백엔드 집합
+ * @param iPolicy 키 없는 요청의 선택 방식 (TcpBalancePolicy)
+ */
+void initBalancer(TcpBalancer *, int);
+
+/**
+ * @brief 이상치 제외 설정을 바꿉니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param kpstConfig 설정 (NULL이면 기본값)
+ */
+void setOutlierConfig(TcpBalancer *, const TcpOutlierConfig *);
+
+/**
+ * @brief 모든 유휴 연결을 닫고 백엔드 집합을 정리합니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ */
+void destroyBalancer(TcpBalancer *);
+
+/**
+ * @brief 백엔드를 집합에 넣고 Maglev 테이블을 다시 채웁니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param kpchEndpoint "host:port" 엔드포인트 (연결은 처음 빌릴 때 만듦)
+ * @return 성공 시 백엔드 슬롯 번호, 이미 있으면 그 번호, 실패 시 -1 반환
+ */
+int addBackend(TcpBalancer *, const char *);
+
+/**
+ * @brief 백엔드를 집합에서 빼고 유휴 연결을 닫은 뒤 Maglev 테이블을 다시 채웁니다.
+ *
+ * @details 빌려 간 연결은 반납할 때 닫힙니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param kpchEndpoint 엔드포인트
+ * @return 성공 시 0, 없는 백엔드이면 -1 반환
+ */
+int removeBackend(TcpBalancer *, const char *);
+
+/**
+ * @brief 키가 배정된 백엔드를 Maglev 테이블에서 찾습니다.
+ *
+ * @details acquireBackendConn()과 같은 규칙을 따르므로, 다시 넣은 지 얼마 안 된 백엔드의 키는
+ *          램프 가중치만큼만 그 백엔드로, 나머지는 테이블의 다음 자리의 백엔드로 배정됩니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param kpvKey 키
+ * @param uiKeyLength 키 길이
+ * @return 백엔드 슬롯 번호, 백엔드가 없으면 -1 반환
+ */
+int lookupBackend(TcpBalancer *, const void *, size_t);
+
+/**
+ * @brief 백엔드를 골라 연결을 빌립니다.
+ *
+ * @details 키가 있으면 Maglev 테이블로(같은 키는 같은 백엔드), 없으면 임의의 두 백엔드 중 정책상
+ *          부하가 적은 쪽을 고릅니다. 유휴 연결이 있으면 재사용하고, 없으면 createClientSocketTo()로
+ *          새로 연결합니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param kpvKey 키 (NULL이면 P2C)
+ * @param uiKeyLength 키 길이
+ * @param pstConn 빌린 연결
+ * @return 성공 시 0, 백엔드가 없거나 연결하지 못하면 -1 반환
+ */
+int acquireBackendConn(TcpBalancer *, const void *, size_t, TcpBalanceConn *);
+
+/**
+ * @brief iExclude가 아닌 백엔드를 P2C로 골라 연결을 빌립니다 (중복 요청용).
+ *
+ * @details 다른 선택 대상 백엔드가 없으면 같은 백엔드의 다른 연결을 빌립니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param iExclude 빼고 고를 백엔드 슬롯 번호
+ * @param pstConn 빌린 연결
+ * @return 성공 시 0, 백엔드가 없거나 연결하지 못하면 -1 반환
+ */
+int acquireOtherBackendConn(TcpBalancer *, int, TcpBalanceConn *);
+
+/**
+ * @brief 빌린 연결을 반납하고 요청 결과를 백엔드 통계에 반영합니다.
+ *
+ * @details 실패한 연결, 풀이 가득 찬 경우, 집합에서 빠진 백엔드의 연결은 닫습니다. 연속 실패가
+ *          설정 값에 이르면 백엔드를 바로 제외합니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param pstConn 반납할 연결
+ * @param iFailed 요청이 실패했으면 1 (연결을 닫음)
+ */
+void releaseBackendConn(TcpBalancer *, TcpBalanceConn *, int);
+
+/**
+ * @brief 응답을 기다리던 요청을 취소하고 연결을 닫습니다.
+ *
+ * @details 응답이 아직 스트림에 남아 있을 수 있으므로 풀에 돌려주지 않으며, 백엔드의 지연과
+ *          실패 통계에는 반영하지 않습니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param pstConn 취소할 연결
+ */
+void cancelBackendConn(TcpBalancer *, TcpBalanceConn *);
+
+/**
+ * @brief 백엔드의 최근 요청 지연 백분위를 구합니다.
+ *
+ * @details 현재 평가 구간에 uiMinRequests 이상 표본이 있으면 그 구간에서, 아니면 표본이 있던 직전
+ *          평가 구간에서 계산합니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @param iBackend 백엔드 슬롯 번호
+ * @param dPercentile 백분위 (0.0 ~ 100.0)
+ * @return 지연 (ns), 표본이 없으면 0
+ */
+unsigned long long getBackendLatency(TcpBalancer *, int, double);
+
+/**
+ * @brief 평가 구간 통계로 이상치 백엔드를 제외하고, 제외 시간이 끝난 백엔드를 탐침합니다.
+ *
+ * @details 평가 구간에 uiMinRequests 이상 처리한 백엔드 중 실패율이 uiFailurePercent 이상이거나
+ *          p99 지연이 그 백엔드들 p99 중앙값의 uiLatencyFactorPercent 배를 넘는 백엔드를 제외한 뒤
+ *          구간 통계를 비웁니다. 제외 시간은 제외될 때마다 두 배가 되고, 건강한 구간을 지날 때마다
+ *          배수가 줄어듭니다. 제외가 끝난 백엔드는 새로 연결하여(pfnProbe가 있으면 그 연결로 heartbeat를
+ *          보내) 건강하면 다시 넣고, 아니면 더 오래 제외합니다. 다시 넣은 백엔드는 uiRampTimeMsec 동안
+ *          P2C 선택 확률과 돌아오는 키의 비율이 점차 늘어납니다. 탐침은 잠금 밖에서 블로킹으로 연결하므로 타이밍 휠 콜백이나
+ *          관리 스레드에서 평가 주기마다 호출합니다.
+ *
+ * @param pstBalancer 백엔드 집합
+ * @return 호출이 끝난 뒤 제외되어 있는 백엔드 수
+ */
+int checkBackendHealth(TcpBalancer *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
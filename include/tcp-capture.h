@@ -0,0 +1,128 @@
+#ifndef TCP_CAPTURE_H
+#define TCP_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+/**
+ * @brief   캡처 파일 형식을 정의합니다.
+ * @details 파일은 TcpCaptureHeader 뒤에 레코드가 이어지며, 각 레코드는 TcpCaptureRecord 뒤에
+ *          uiLength 바이트의 데이터가 8바이트 경계까지 채워져 이어집니다.
+ */
+#define TCP_CAPTURE_MAGIC       "TCPCAP"
+#define TCP_CAPTURE_VERSION     1
+#define TCP_CAPTURE_ALIGN       8
+#define TCP_CAPTURE_DEFAULT_SIZE (64ULL * 1024 * 1024)
+
+/**
+ * @brief 레코드 방향
+ */
+typedef enum {
+    TCP_CAPTURE_IN = 1,                 /**< 이 프로세스가 수신한 데이터 */
+    TCP_CAPTURE_OUT = 2,                /**< 이 프로세스가 전송한 데이터 */
+    TCP_CAPTURE_CLOSE = 3,              /**< 연결 제거 (데이터 없음) */
+    TCP_CAPTURE_ACCEPT = 4,             /**< 수락한 연결 등록 (데이터 없음) */
+    TCP_CAPTURE_CONNECT = 5,            /**< 연결한 연결 등록 (데이터 없음) */
+} TcpCaptureDirection;
+
+/**
+ * @brief 캡처 파일 헤더
+ */
+typedef struct {
+    char achMagic[8];                   /**< TCP_CAPTURE_MAGIC */
+    unsigned int uiVersion;             /**< TCP_CAPTURE_VERSION */
+    unsigned int uiReserved;
+    unsigned long long ullStartNsec;    /**< 캡처 시작 시각 (CLOCK_MONOTONIC) */
+    unsigned long long ullCapacity;     /**< 레코드 영역 크기 */
+    unsigned long long ullUsed;         /**< 예약된 레코드 영역 크기 */
+    unsigned long long ullDropped;      /**< 공간 부족으로 기록하지 못한 레코드 수 */
+} TcpCaptureHeader;
+
+/**
+ * @brief 캡처 레코드 머리
+ *
+ * @details uiCommitted는 데이터 기록이 끝난 뒤 마지막으로 1이 됩니다. 0인 레코드는 기록 도중
+ *          캡처가 끝난 것이므로 건너뜁니다.
+ */
+typedef struct {
+    unsigned int uiCommitted;           /**< 기록 완료 여부 */
+    unsigned int uiLength;              /**< 데이터 길이 */
+    int iSock;                          /**< 소켓 파일 디스크립터 */
+    int iDirection;                     /**< TcpCaptureDirection */
+    unsigned long long ullConnId;       /**< 연결 식별자 (같은 번호의 재사용 구분, 연결 등록 시각, 0이 아님) */
+    unsigned long long ullOffsetNsec;   /**< 캡처 시작 이후 경과 시간 */
+} TcpCaptureRecord;
+
+/**
+ * @brief 송수신 데이터 캡처를 시작합니다.
+ *
+ * @details 연결 테이블에 등록된 연결의 송수신 데이터를 시각과 함께 메모리 매핑된 파일에 기록합니다.
+ *          등록되지 않은 소켓은 재사용된 번호와 구분할 연결 식별자가 없으므로 기록하지 않습니다.
+ *          기록은 잠금 없이 영역을 예약한 뒤 복사하므로 여러 스레드에서 동시에 송수신할 수 있으며,
+ *          영역이 가득 차면 이후 레코드는 버리고 ullDropped를 증가시킵니다.
+ *
+ * @param kpchPath 캡처 파일 경로
+ * @param ullCapacity 레코드 영역 크기 (0이면 TCP_CAPTURE_DEFAULT_SIZE)
+ * @return 성공 시 0, 실패 또는 이미 캡처 중이면 -1 반환
+ */
+int startTrafficCapture(const char *, unsigned long long);
+
+/**
+ * @brief 캡처를 끝내고 파일을 사용한 크기로 줄입니다.
+ *
+ * @details 새 기록을 막은 뒤 기록 중인 스레드가 끝날 때까지 기다리고 파일을 닫습니다.
+ *
+ * @return 기록한 바이트 수 (헤더 제외), 캡처 중이 아니면 0
+ */
+unsigned long long stopTrafficCapture(void);
+
+/**
+ * @brief 송수신 데이터를 캡처 파일에 기록합니다 (라이브러리 내부용).
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @param eDirection 방향
+ * @param kpvData 데이터
+ * @param uiLength 데이터 길이
+ */
+void captureTraffic(int, TcpCaptureDirection, const void *, size_t);
+
+/**
+ * @brief iovec 배열의 앞부분 uiLength 바이트를 캡처 파일에 기록합니다 (라이브러리 내부용).
+ */
+void captureTrafficV(int, TcpCaptureDirection, const struct iovec *, int, size_t);
+
+/**
+ * @brief 캡처 파일을 읽기 전용으로 엽니다.
+ *
+ * @details stopTrafficCapture()로 마무리되지 않은 파일(기록 중이거나 넘친 채 종료된 경우)도
+ *          용량 안에 기록된 레코드까지 읽을 수 있습니다.
+ *
+ * @param kpchPath 캡처 파일 경로
+ * @param puiSize 매핑된 크기를 저장할 포인터
+ * @return 성공 시 헤더 포인터, 실패 또는 형식 불일치 시 NULL
+ */
+const TcpCaptureHeader *openTrafficCapture(const char *, size_t *);
+
+/**
+ * @brief 다음 레코드를 반환합니다.
+ *
+ * @param kpstHeader openTrafficCapture()의 반환값
+ * @param kpstRecord 이전 레코드 (NULL이면 첫 레코드)
+ * @return 다음 기록 완료 레코드, 없으면 NULL
+ */
+const TcpCaptureRecord *nextTrafficRecord(const TcpCaptureHeader *, const TcpCaptureRecord *);
+
+/**
+ * @brief 레코드의 데이터 포인터를 반환합니다.
+ */
+#define TCP_CAPTURE_DATA(kpstRecord) ((const unsigned char *)((kpstRecord) + 1))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef TCP_CODEC_H
+#define TCP_CODEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <sys/uio.h>
+#include "tcp-sock.h"
+
+/**
+ * @brief   파이프라인에 쌓을 수 있는 최대 코덱 수
+ */
+#define TCP_CODEC_MAX_LAYERS    4
+
+/**
+ * @brief   메시지 하나를 인코딩하는 동안 쓸 수 있는 최대 iovec 개수
+ */
+#define TCP_CODEC_MAX_MSG_IOV   16
+
+/**
+ * @brief   송신 대기열의 스크래치 영역 크기 (코덱 헤더, 변환 결과, 짧은 페이로드 복사본)
+ */
+#define TCP_CODEC_SCRATCH_SIZE  65536
+
+/**
+ * @brief   송신 대기열로 복사하는 페이로드 조각 최대 길이 (더 긴 조각은 iovec으로 참조)
+ */
+#define TCP_CODEC_INLINE_MAX    256
+
+/**
+ * @brief   인코딩 함수 반환값: 스크래치 영역이 부족함 (대기열을 보낸 뒤 다시 시도)
+ */
+#define TCP_CODEC_NEED_SPACE    -2
+
+typedef struct TcpCodecPipe TcpCodecPipe;
+
+/**
+ * @brief 해석한 메시지
+ */
+typedef struct {
+    void *pvData;               /**< 메시지 (수신 버퍼 또는 코덱 상태 안, 다음 수신 전까지 유효) */
+    size_t uiLength;            /**< 메시지 길이 */
+} TcpCodecMsg;
+
+/**
+ * @brief 코덱 인터페이스
+ *
+ * @details 파이프라인의 첫 번째(와이어 쪽) 코덱은 수신 버퍼에서 메시지 경계를 찾고, 그 안쪽
+ *          코덱은 바깥 코덱이 돌려준 메시지 하나를 통째로 변환합니다(압축 해제 등).
+ *
+ * pfnDecode(pvState, pvData, uiLength, pstMsg)
+ *   - pvData: 해석할 데이터 (바꿔 써도 됨, 마스크 해제 같은 제자리 변환용)
+ *   - 반환값: 소비한 바이트 수, 데이터가 부족하면 0, 잘못된 데이터면 -1
+ *   - 안쪽 코덱은 입력 전체를 소비해야 합니다.
+ *
+ * pfnEncode(pstPipe, pvState, pstIov, iIov, iMaxIov)
+ *   - pstIov의 메시지를 제자리에서 감싸거나 변환합니다. 헤더나 변환 결과는
+ *     allocCodecScratch()로 받은 영역에 씁니다.
+ *   - 반환값: 새 iovec 개수, 스크래치가 부족하면 TCP_CODEC_NEED_SPACE, 실패 시 -1
+ */
+typedef struct {
+    const char *kpchName;
+    int (*pfnDecode)(void *, void *, size_t, TcpCodecMsg *);
+    int (*pfnEncode)(TcpCodecPipe *, void *, struct iovec *, int, int);
+} TcpCodec;
+
+typedef struct {
+    const TcpCodec *kpstCodec;
+    void *pvState;
+} TcpCodecLayer;
+
+/**
+ * @brief 코덱 파이프라인 (연결 하나의 수신 버퍼와 송신 대기열)
+ *
+ * @details 수신은 호출자가 준 버퍼에서 남은 데이터를 앞으로 당겨 가며 recvMsgBlocking()으로
+ *          채우고, 송신은 인코딩한 메시지를 대기열에 모았다가 sendMessageV() 한 번으로 보냅니다.
+ *          따라서 연결 통계, 캡처, 장애 시뮬레이션이 모든 코덱에 그대로 적용됩니다.
+ *          구조체가 크므로 정적 변수나 힙에 둡니다.
+ */
+struct TcpCodecPipe {
+    int iSock;                                  /**< 소켓 파일 디스크립터 */
+    int iLayers;                                /**< 코덱 수 */
+    TcpCodecLayer astLayers[TCP_CODEC_MAX_LAYERS]; /**< 코덱 (0번이 와이어 쪽) */
+    char *pchBuffer;                            /**< 수신 버퍼 */
+    size_t uiCapacity;                          /**< 수신 버퍼 크기 (바깥 메시지 최대 크기) */
+    size_t uiStart;                             /**< 해석하지 않은 데이터의 시작 위치 */
+    size_t uiEnd;                               /**< 수신한 데이터의 끝 위치 */
+    size_t uiConsumed;                          /**< 직전에 돌려준 메시지의 길이 (다음 수신 때 소비) */
+    int iIov;                                   /**< 송신 대기열 iovec 개수 */
+    size_t uiScratchUsed;                       /**< 스크래치 사용량 */
+    unsigned long long ullQueued;               /**< 대기열에 있는 메시지 수 */
+    struct iovec astIov[TCP_IOV_MAX];           /**< 송신 대기열 */
+    unsigned char aucScratch[TCP_CODEC_SCRATCH_SIZE]; /**< 스크래치 영역 */
+};
+
+/**
+ * @brief 파이프라인을 초기화합니다.
+ *
+ * @param pstPipe 초기화할 파이프라인
+ * @param iSock 연결 소켓
+ * @param pvBuffer 수신 버퍼
+ * @param uiCapacity 수신 버퍼 크기
+ */
+void initCodecPipe(TcpCodecPipe *, int, void *, size_t);
+
+/**
+ * @brief 코덱을 안쪽에 쌓습니다 (처음 쌓은 코덱이 와이어 쪽).
+ *
+ * @param pstPipe 파이프라인
+ * @param kpstCodec 코덱
+ * @param pvState 코덱 상태 (코덱 함수에 그대로 전달)
+ * @return 성공 시 코덱 위치, 실패 시 -1 반환
+ */
+int pushCodecLayer(TcpCodecPipe *, const TcpCodec *, void *);
+
+/**
+ * @brief 인코딩 중인 메시지에 쓸 스크래치 영역을 할당합니다 (대기열을 보낼 때까지 유효).
+ *
+ * @param pstPipe 파이프라인
+ * @param uiSize 크기
+ * @return 영역 포인터, 부족하면 NULL 반환
+ */
+void *allocCodecScratch(TcpCodecPipe *, size_t);
+
+/**
+ * @brief 메시지 하나를 수신하여 모든 코덱으로 해석합니다.
+ *
+ * @details 직전에 돌려준 메시지는 이때 소비되므로, 그 메시지를 가리키는 포인터는 더 이상
+ *          유효하지 않습니다. 한 번에 도착한 여러 메시지는 버퍼에 남겨 두었다가 차례로 돌려줍니다.
+ *
+ * @param pstPipe 파이프라인
+ * @param pstMsg 해석한 메시지
+ * @return 성공 시 1, 연결 종료 시 TCP_DISCONNECTION, 실패 시 -1 반환
+ */
+int recvCodecMessage(TcpCodecPipe *, TcpCodecMsg *);
+
+/**
+ * @brief 메시지를 안쪽 코덱부터 인코딩하여 송신 대기열에 넣습니다.
+ *
+ * @details TCP_CODEC_INLINE_MAX 이하의 조각은 스크래치로 복사하고, 더 긴 조각은 가리키기만
+ *          하므로 flushCodecPipe()까지 유지해야 합니다. 대기열이 차거나 스크래치가 모자라면
+ *          대기열과 이 메시지를 바로 보냅니다.
+ *
+ * @param pstPipe 파이프라인
+ * @param kpstIov 메시지 조각
+ * @param iIov 조각 개수 (최대 TCP_CODEC_MAX_MSG_IOV)
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int queueCodecMessage(TcpCodecPipe *, const struct iovec *, int);
+
+/**
+ * @brief 송신 대기열을 sendMessageV() 한 번으로 보냅니다.
+ *
+ * @param pstPipe 파이프라인
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int flushCodecPipe(TcpCodecPipe *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
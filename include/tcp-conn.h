@@ -0,0 +1,179 @@
+#ifndef TCP_CONN_H
+#define TCP_CONN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "tcp-metrics.h"
+
+/**
+ * @brief   적응형 수신 크기(버퍼 클래스)의 범위를 정의합니다.
+ * @details 수신 요청 크기는 최소~최대 사이의 2의 거듭제곱 클래스 중 하나로 결정됩니다.
+ *          초기 크기는 BUFFER_SIZE와 동일합니다.
+ */
+#define TCP_RECV_MIN_SIZE       64
+#define TCP_RECV_INIT_SIZE      1024
+#define TCP_RECV_MAX_SIZE       65536
+
+/**
+ * @brief   연결 테이블이 관리할 수 있는 최대 파일 디스크립터 수
+ */
+#define TCP_CONN_MAX_FDS        (1024 * 1024)
+
+/**
+ * @brief   전송 타임스탬프 대기열의 슬롯 수
+ */
+#define TCP_TX_STAMP_SLOTS      16
+
+/**
+ * @brief 커널 TX ACK 타임스탬프를 기다리는 전송 기록 대기열
+ *
+ * @details 전송 ID(SOF_TIMESTAMPING_OPT_ID 바이트 오프셋)와 전송 시각을 보관하며,
+ *          가득 차면 가장 오래된 기록을 덮어씁니다.
+ */
+typedef struct {
+    unsigned int auiKey[TCP_TX_STAMP_SLOTS];                /**< 전송 ID */
+    unsigned long long aullSendNsec[TCP_TX_STAMP_SLOTS];    /**< 전송 시각 (CLOCK_REALTIME, ns) */
+    unsigned int uiHead;
+    unsigned int uiTail;
+} TcpTxStampRing;
+
+/**
+ * @brief 연결별 상태 정보
+ *
+ * @details 소켓 파일 디스크립터 단위로 유지되며, 최근 수신 크기 이력을 바탕으로
+ *          다음 수신 요청 크기를 결정하는 데 사용됩니다.
+ */
+struct TcpImpairState;
+
+typedef struct {
+    int iSock;                  /**< 소켓 파일 디스크립터 (미사용 시 -1) */
+    int iInUse;                 /**< 엔트리 사용 여부 */
+    unsigned int uiRecvSize;    /**< 현재 수신 요청 크기 (버퍼 클래스) */
+    unsigned int uiShrinkCount; /**< 연속으로 작은 수신이 발생한 횟수 */
+    unsigned int uiLastRequest; /**< 마지막 수신 요청 크기 */
+    unsigned int uiLastRecv;    /**< 마지막 수신 바이트 수 */
+    unsigned long long ullHoldNsec; /**< 키운 버퍼가 마지막으로 필요했던 시각 (0이면 유예 없음) */
+    int iTimestamping;          /**< 활성화된 타임스탬프 플래그 (TCP_TSTAMP_*) */
+    unsigned int uiTxKey;       /**< 타임스탬프 활성화 이후 전송한 바이트 수 */
+    TcpTxStampRing *pstTxStamps;/**< TX ACK 타임스탬프 대기열 (TX 타임스탬프 사용 시) */
+    TcpConnStats *pstStats;     /**< 연결 통계 (게시된 공유 메모리 슬롯 또는 stLocalStats) */
+    TcpConnStats stLocalStats;  /**< 공유 메모리 슬롯이 없을 때 사용하는 연결 통계 */
+    struct TcpImpairState *pstImpair; /**< 네트워크 장애 시뮬레이션 상태 (설정 시) */
+} TcpConnInfo;
+
+/**
+ * @brief 연결 테이블에서 소켓의 상태 정보를 조회합니다.
+ *
+ * @details 등록되지 않은 소켓이면 기본값으로 초기화한 엔트리를 생성합니다.
+ *          엔트리는 해당 소켓을 사용하는 스레드에서만 갱신해야 합니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @return 성공 시 상태 정보 포인터, 범위를 벗어나거나 메모리 부족 시 NULL
+ */
+TcpConnInfo *getConnInfo(int);
+
+/**
+ * @brief 연결 테이블에서 등록된 소켓의 상태 정보를 조회합니다.
+ *
+ * @details getConnInfo()와 달리 엔트리를 생성하지 않으므로 송수신 경로에서 사용합니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @return 등록된 경우 상태 정보 포인터, 아니면 NULL
+ */
+TcpConnInfo *findConnInfo(int);
+
+/**
+ * @brief 등록된 소켓의 연결 통계를 반환합니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @return 등록된 경우 연결 통계 포인터, 아니면 NULL
+ */
+TcpConnStats *findConnStats(int);
+
+/**
+ * @brief 연결 테이블에서 소켓의 상태 정보를 제거합니다.
+ *
+ * @details handleClientDisconnection()에서 자동으로 호출됩니다. 소켓을 직접 close() 한 경우,
+ *          같은 번호가 재사용되기 전에 호출해야 이전 연결의 이력이 남지 않습니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ */
+void removeConnInfo(int);
+
+/**
+ * @brief 새 연결을 연결 테이블에 등록합니다.
+ *
+ * @details 같은 번호의 이전 엔트리가 남아 있으면 제거한 뒤 새로 생성합니다.
+ *          acceptClientSocket()과 createClientSocket()에서 자동으로 호출됩니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @return 성공 시 상태 정보 포인터, 실패 시 NULL
+ */
+TcpConnInfo *registerConnInfo(int);
+
+/**
+ * @brief 등록된 모든 연결의 통계를 현재 메트릭 세그먼트의 슬롯으로 옮깁니다.
+ *
+ * @details publishMetricsShm()에서 호출되며, 게시 이전에 등록된 연결도 외부에서 보이게 합니다.
+ */
+void rebindConnStats(void);
+
+/**
+ * @brief 등록된 모든 연결의 통계를 복사합니다.
+ *
+ * @details 잠금 없이 각 연결의 시퀀스 잠금으로 일관된 값을 읽으므로, 송수신 중인 스레드를
+ *          멈추지 않고 다른 스레드(관리 서버 등)에서 호출할 수 있습니다.
+ *
+ * @param pstOut 통계를 저장할 배열
+ * @param iMax 배열 크기
+ * @return 복사한 연결 수
+ */
+int snapshotConnTable(TcpConnStats *, int);
+
+/**
+ * @brief 등록된 연결의 통계를 fd 순서로 나누어 복사합니다.
+ *
+ * @details snapshotConnTable()과 같지만 *piCursor 이상의 fd부터 iMax개까지만 복사하고 다음에
+ *          이어서 볼 fd를 *piCursor에 저장하므로, 작은 배열로 전체 테이블을 차례로 읽을 수 있습니다.
+ *
+ * @param piCursor 처음 호출 시 0, 이후 호출은 이전 호출이 저장한 값
+ * @param pstOut 통계를 저장할 배열
+ * @param iMax 배열 크기
+ * @return 복사한 연결 수 (0이면 테이블 끝)
+ */
+int scanConnTable(int *, TcpConnStats *, int);
+
+/**
+ * @brief 소켓의 다음 수신 요청 크기를 반환합니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @return 수신 요청 크기 (바이트 단위)
+ */
+size_t getAdaptiveRecvSize(int);
+
+/**
+ * @brief 연결별 수신 이력에 맞춰 버퍼 크기를 조절하며 메시지를 수신합니다.
+ *
+ * @details 직전 수신이 버퍼를 가득 채웠다면 FIONREAD로 대기 중인 바이트 수를 확인하여
+ *          한 번의 recv()로 읽을 수 있도록 요청 크기를 키우고, 연속으로 작은 수신이 발생하면
+ *          한 단계씩 줄입니다. 버퍼는 요청 크기에 맞게 realloc() 되므로 malloc()으로 할당한
+ *          버퍼(또는 NULL)를 전달해야 하며, 사용 후 free()로 해제합니다. 한 번 키운 버퍼는
+ *          다시 필요해지지 않은 채 100ms가 지난 뒤의 수신에서 줄여 반환합니다.
+ *          수신 이력은 연결 테이블에 등록된 소켓에만 기록되며, 등록되지 않은 소켓은
+ *          TCP_RECV_INIT_SIZE로 받습니다.
+ *
+ * @param iSock 데이터를 수신할 소켓 디스크립터
+ * @param ppvBuffer 수신 버퍼 포인터의 주소 (필요 시 재할당됨)
+ * @param puiCapacity 수신 버퍼 크기의 주소 (재할당 시 갱신됨)
+ * @return 성공 시 수신한 바이트 수, 연결 종료 시 TCP_DISCONNECTION, 실패 시 -1 반환
+ */
+int recvMsgAdaptive(int, void **, size_t *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
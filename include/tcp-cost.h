@@ -0,0 +1,80 @@
+#ifndef TCP_COST_H
+#define TCP_COST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tcp-metrics.h"
+
+/**
+ * @brief   스레드별 상위 N 스케치(space-saving)의 슬롯 수
+ * @details 연결 수와 관계없이 스레드마다 이 수만큼의 엔트리만 유지합니다.
+ *          상위 N 보고의 정확도는 N이 슬롯 수보다 충분히 작을 때 보장됩니다.
+ */
+#define TCP_COST_TOPN_SLOTS     64
+
+/**
+ * @brief 상위 N 보고의 엔트리
+ */
+typedef struct {
+    int iSock;                          /**< 소켓 파일 디스크립터 */
+    unsigned long long ullCreatedNsec;  /**< 연결 등록 시각 (같은 번호의 재사용 구분) */
+    unsigned long long ullCycles;       /**< 누적 CPU 비용 추정치 (getCycleCount() 단위) */
+    unsigned long long ullError;        /**< 추정치의 최대 과대 오차 */
+} TcpCostEntry;
+
+/**
+ * @brief 연결별 CPU 비용 측정을 켜거나 끕니다.
+ *
+ * @details 꺼져 있으면 송수신 경로의 비용은 분기 한 번입니다. 기본값은 꺼짐입니다.
+ *
+ * @param iEnable 1이면 켜기, 0이면 끄기
+ */
+void setConnCostAccounting(int);
+
+/**
+ * @brief 비용 측정 구간을 시작합니다.
+ *
+ * @return 측정 중이면 현재 사이클 카운터 값, 아니면 0
+ */
+unsigned long long beginConnCost(void);
+
+/**
+ * @brief 비용 측정 구간을 끝내고 연결 통계와 상위 N 스케치에 기록합니다.
+ *
+ * @details 라이브러리는 수신/전송/프레임 해석 비용을 자동으로 기록합니다.
+ *          핸들러 비용은 애플리케이션이 TCP_COST_HANDLER로 기록합니다.
+ *          recvMsgBlocking()처럼 데이터를 기다리는 호출은 대기 시간도 비용에 포함되므로,
+ *          정확한 값이 필요하면 수신 가능 통지 이후에 호출하거나 recvMsgTimeout()을 사용합니다.
+ *
+ * @param iSock 연결 소켓 (연결 테이블에 등록되지 않았으면 무시)
+ * @param eKind 비용 분류
+ * @param ullStart beginConnCost()의 반환값 (0이면 무시)
+ */
+void endConnCost(int, TcpCostKind, unsigned long long);
+
+/**
+ * @brief CPU 비용이 큰 연결을 내림차순으로 반환합니다.
+ *
+ * @details 모든 스레드의 스케치를 합쳐 계산하며, 스케치를 갱신하는 스레드를 잠시 잠급니다.
+ *          종료한 스레드의 스케치는 하나의 스케치로 합쳐져 보고에 남고, 새 스레드가 재사용합니다.
+ *
+ * @param pstOut 결과를 저장할 배열
+ * @param iMax 배열 크기
+ * @return 저장한 엔트리 수
+ */
+int getConnCostTopN(TcpCostEntry *, int);
+
+/**
+ * @brief 상위 N 스케치를 비웁니다(과금 구간 시작 등).
+ *
+ * @details 연결 통계의 누적 비용은 유지됩니다.
+ */
+void resetConnCostTopN(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
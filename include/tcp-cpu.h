@@ -0,0 +1,42 @@
+#ifndef TCP_CPU_H
+#define TCP_CPU_H
+
+/**
+ * @file tcp-cpu.h
+ * @brief 실행 중인 CPU의 명령어 집합 확인 (라이브러리 내부용, 헤더 전용)
+ *
+ * SIMD 경로를 고르는 코덱들이 함께 사용합니다. 확인 결과는 처음 한 번만 구해 캐시하므로
+ * 호출 비용은 원자적 읽기 한 번입니다.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 실행 중인 CPU가 AVX2를 지원하는지 확인합니다.
+ *
+ * @return 지원하면 1, 지원하지 않거나 x86이 아니면 0
+ */
+static inline int hasCpuAvx2(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    // 0: 미확인, 1: 없음, 2: 있음
+    static int s_iAvx2 = 0;
+    int iAvx2 = __atomic_load_n(&s_iAvx2, __ATOMIC_RELAXED);
+    if (iAvx2 == 0) {
+        __builtin_cpu_init();
+        iAvx2 = __builtin_cpu_supports("avx2") ? 2 : 1;
+        __atomic_store_n(&s_iAvx2, iAvx2, __ATOMIC_RELAXED);
+    }
+    return iAvx2 == 2;
+#else
+    return 0;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
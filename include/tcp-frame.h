@@ -0,0 +1,151 @@
+#ifndef TCP_FRAME_H
+#define TCP_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "tcp-trace.h"
+#include "tcp-codec.h"
+
+/**
+ * @brief   프레임 헤더 형식을 정의합니다.
+ * @details | 페이로드 길이 (4B, 네트워크 바이트 순서) | 플래그 (1B) | [추적 컨텍스트 (25B)] | 페이로드 |
+ *          추적 컨텍스트는 TCP_FRAME_FLAG_TRACE 플래그가 있을 때만 포함되며,
+ *          추적 ID(16B), 스팬 ID(8B), 추적 플래그(1B) 순서입니다.
+ */
+#define TCP_FRAME_HEADER_SIZE   5
+#define TCP_FRAME_TRACE_SIZE    (TCP_TRACE_ID_SIZE + TCP_SPAN_ID_SIZE + 1)
+#define TCP_FRAME_MAX_HEADER    (TCP_FRAME_HEADER_SIZE + TCP_FRAME_TRACE_SIZE)
+#define TCP_FRAME_MAX_PAYLOAD   (16 * 1024 * 1024)
+
+#define TCP_FRAME_FLAG_TRACE    0x01
+
+/**
+ * @brief   recvFrame() 반환값 (TCP_TIME_OUT(-2)과 겹치지 않게 -3부터 사용)
+ */
+#define TCP_FRAME_CLOSED        -3      /**< 다음 프레임이 시작되기 전에 연결 종료 */
+#define TCP_FRAME_PENDING       -4      /**< 프레임을 다 받지 못했고 지금 읽을 데이터가 없음 */
+
+/**
+ * @brief 해석된 프레임 헤더
+ */
+typedef struct {
+    unsigned int uiPayloadLength;   /**< 페이로드 길이 */
+    unsigned int uiHeaderLength;    /**< 추적 컨텍스트를 포함한 헤더 길이 */
+    unsigned char ucFlags;          /**< TCP_FRAME_FLAG_* */
+    TcpTraceContext stTrace;        /**< 추적 컨텍스트 (TCP_FRAME_FLAG_TRACE가 있을 때만 유효) */
+} TcpFrameHeader;
+
+/**
+ * @brief recvFrameNonBlocking()이 여러 번에 걸쳐 받는 프레임의 진행 상태
+ */
+typedef struct {
+    unsigned char aucHeader[TCP_FRAME_MAX_HEADER];  /**< 지금까지 받은 헤더 */
+    unsigned int uiHeaderReceived;      /**< 받은 헤더 바이트 수 */
+    unsigned int uiPayloadReceived;     /**< 받은 페이로드 바이트 수 */
+    int iHeaderDone;                    /**< 헤더 해석 완료 여부 */
+    TcpFrameHeader stHeader;            /**< 해석한 헤더 (iHeaderDone일 때만 유효) */
+    unsigned long long ullRecvNsec;     /**< 첫 헤더 바이트를 받은 시각 */
+} TcpFrameReader;
+
+/**
+ * @brief 프레임 코덱 상태 (getFrameCodec()을 쌓을 때 넘기며, NULL이면 추적 컨텍스트 없이 동작)
+ */
+typedef struct {
+    const TcpTraceContext *kpstTrace;   /**< 보낼 때 함께 전달할 추적 컨텍스트 (NULL이면 생략) */
+    TcpFrameHeader stLastHeader;        /**< 마지막으로 받은 프레임 헤더 */
+} TcpFrameCodecState;
+
+/**
+ * @brief 프레임 헤더를 버퍼에 기록합니다.
+ *
+ * @param pucOut 헤더를 기록할 버퍼 (최소 TCP_FRAME_MAX_HEADER 바이트)
+ * @param uiPayloadLength 페이로드 길이
+ * @param kpstTrace 함께 전달할 추적 컨텍스트 (NULL이면 생략)
+ * @return 기록한 헤더 길이, 페이로드가 너무 크면 -1 반환
+ */
+int encodeFrameHeader(unsigned char *, size_t, const TcpTraceContext *);
+
+/**
+ * @brief 버퍼에서 프레임 헤더를 해석합니다.
+ *
+ * @param kpvData 수신 데이터
+ * @param uiLength 수신 데이터 길이
+ * @param pstHeader 해석 결과를 저장할 구조체 포인터
+ * @return 헤더 길이, 데이터가 부족하면 0, 잘못된 헤더면 -1 반환
+ */
+int parseFrameHeader(const void *, size_t, TcpFrameHeader *);
+
+/**
+ * @brief 길이 접두 프레임을 전송합니다(전체 전송 완료까지 블로킹).
+ *
+ * @details 헤더와 페이로드를 한 번의 writev()로 전송합니다. 샘플링된 추적 컨텍스트가 주어지면
+ *          enqueue(헤더 구성), send(시스템 콜) 스팬을 기록합니다.
+ *
+ * @param iSock 데이터를 전송할 소켓 디스크립터
+ * @param kpvPayload 전송할 페이로드
+ * @param uiLength 페이로드 길이
+ * @param kpstTrace 함께 전달할 추적 컨텍스트 (NULL이면 생략)
+ * @return 성공 시 전송한 페이로드 바이트 수, 실패 시 -1 반환
+ */
+int sendFrame(int, const void *, size_t, const TcpTraceContext *);
+
+/**
+ * @brief 길이 접두 프레임 하나를 수신합니다(프레임 전체 수신 완료까지 블로킹).
+ *
+ * @details 샘플링된 추적 컨텍스트가 포함된 프레임이면 recv 스팬을 기록합니다.
+ *          페이로드가 버퍼보다 크거나 헤더가 잘못되면 -1을 반환하며, 이후 스트림 위치를
+ *          보장할 수 없으므로 연결을 닫아야 합니다.
+ *          빈 프레임은 0을 반환하므로, 연결 종료는 TCP_DISCONNECTION(0) 대신 TCP_FRAME_CLOSED로 알립니다.
+ *
+ * @param iSock 데이터를 수신할 소켓 디스크립터
+ * @param pvBuffer 페이로드를 저장할 버퍼
+ * @param uiCapacity 버퍼 크기
+ * @param pstHeader 수신한 헤더(추적 컨텍스트 포함)를 저장할 구조체 포인터 (NULL 가능)
+ * @return 성공 시 수신한 페이로드 바이트 수, 연결 종료 시 TCP_FRAME_CLOSED, 실패 시 -1 반환
+ */
+int recvFrame(int, void *, size_t, TcpFrameHeader *);
+
+/**
+ * @brief 수신 진행 상태를 처음으로 되돌립니다.
+ *
+ * @param pstReader 수신 진행 상태
+ */
+void initFrameReader(TcpFrameReader *);
+
+/**
+ * @brief 지금 읽을 수 있는 만큼만 받아 프레임 하나를 이어서 조립합니다(블로킹 없음).
+ *
+ * @details 블로킹 소켓에서도 MSG_DONTWAIT로 받으므로, 상대가 프레임 중간에서 멈춰도
+ *          호출자의 poll() 루프가 타이머와 제한 시간을 계속 처리할 수 있습니다.
+ *          프레임을 다 받으면 pstReader를 다음 프레임용으로 초기화합니다.
+ *          한 프레임을 받는 동안 pvBuffer와 uiCapacity는 바꾸지 않아야 합니다.
+ *
+ * @param iSock 데이터를 수신할 소켓 디스크립터
+ * @param pstReader 수신 진행 상태 (처음 쓰기 전에 initFrameReader()로 초기화)
+ * @param pvBuffer 페이로드를 저장할 버퍼
+ * @param uiCapacity 버퍼 크기
+ * @param pstHeader 수신한 헤더를 저장할 구조체 포인터 (NULL 가능)
+ * @return 프레임을 다 받으면 페이로드 바이트 수, 아직 덜 받았으면 TCP_FRAME_PENDING,
+ *         연결 종료 시 TCP_FRAME_CLOSED, 실패 시 -1 반환
+ */
+int recvFrameNonBlocking(int, TcpFrameReader *, void *, size_t, TcpFrameHeader *);
+
+/**
+ * @brief 길이 접두 프레이밍 코덱을 반환합니다.
+ *
+ * @details 코덱 파이프라인의 와이어 쪽에 쌓으면 프레임 페이로드를 수신 버퍼 안에서 복사 없이
+ *          돌려주고, 보낼 때는 헤더만 스크래치에 써서 페이로드 앞에 붙입니다.
+ *          상태는 TcpFrameCodecState 또는 NULL입니다.
+ *
+ * @return 프레임 코덱
+ */
+const TcpCodec *getFrameCodec(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
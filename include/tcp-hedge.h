@@ -0,0 +1,110 @@
+#ifndef TCP_HEDGE_H
+#define TCP_HEDGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "tcp-balance.h"
+#include "tcp-timer.h"
+
+/**
+ * @brief   중복 요청 설정 기본값
+ */
+#define TCP_HEDGE_DEFAULT_PERCENTILE    95      /**< 중복 요청을 보내는 지연 백분위 */
+#define TCP_HEDGE_DEFAULT_DELAY         10000   /**< 지연 표본이 없을 때의 대기 시간 (us) */
+#define TCP_HEDGE_DEFAULT_MIN_DELAY     500     /**< 대기 시간 하한 (us) */
+#define TCP_HEDGE_DEFAULT_BUDGET        10      /**< 요청 대비 중복 요청 비율 상한 (%) */
+#define TCP_HEDGE_DEFAULT_BURST         10      /**< 한꺼번에 쓸 수 있는 중복 요청 수 */
+
+/**
+ * @brief 여러 요청 스레드가 함께 쓰는 중복 요청 예산 (토큰 버킷)
+ *
+ * @details 요청 하나마다 uiBudgetPercent / 100개의 토큰이 쌓이고(uiBurst개 상한) 중복 요청은
+ *          토큰 하나를 씁니다. 토큰은 원자적으로 갱신되므로 잠금 없이 공유합니다.
+ */
+typedef struct {
+    unsigned int uiBudgetPercent;       /**< 요청 대비 중복 요청 비율 상한 (%) */
+    unsigned int uiBurst;               /**< 토큰 상한 */
+    long long llMilliTokens;            /**< 남은 토큰 x 1000 */
+} TcpHedgeBudget;
+
+/**
+ * @brief 중복 요청 설정 (0인 항목은 기본값 사용)
+ */
+typedef struct {
+    unsigned int uiPercentile;          /**< 첫 요청 백엔드의 이 지연 백분위를 넘기면 중복 요청 */
+    unsigned int uiDefaultDelayUsec;    /**< 지연 표본이 없을 때의 대기 시간 */
+    unsigned int uiMinDelayUsec;        /**< 대기 시간 하한 */
+} TcpHedgeConfig;
+
+/**
+ * @brief 멱등 요청을 중복으로 보내는 클라이언트 (요청 스레드마다 하나)
+ *
+ * @details 요청과 응답은 길이 접두 프레임(tcp-frame.h) 하나씩이며, 중복 요청과 제한 시간 타이머는
+ *          자신의 타이밍 휠로 구동합니다. 타이밍 휠에 잠금이 없으므로 한 스레드에서만 사용합니다.
+ */
+typedef struct {
+    TcpBalancer *pstBalancer;           /**< 연결을 빌릴 백엔드 집합 */
+    TcpHedgeBudget *pstBudget;          /**< 공유 예산 */
+    TcpHedgeConfig stConfig;            /**< 설정 (기본값 채움) */
+    TcpTimerWheel stWheel;              /**< 중복 요청/제한 시간 타이머 */
+    void *pvHedgeBuffer;                /**< 중복 요청의 응답을 받는 버퍼 (첫 요청과 동시에 받으므로 따로 둠) */
+    size_t uiHedgeBufferSize;           /**< pvHedgeBuffer 크기 */
+} TcpHedgeClient;
+
+/**
+ * @brief 중복 요청 예산을 초기화합니다.
+ *
+ * @param pstBudget 예산
+ * @param uiBudgetPercent 요청 대비 중복 요청 비율 상한 (%, 0이면 TCP_HEDGE_DEFAULT_BUDGET)
+ * @param uiBurst 토큰 상한 (0이면 TCP_HEDGE_DEFAULT_BURST, 처음에는 가득 참)
+ */
+void initHedgeBudget(TcpHedgeBudget *, unsigned int, unsigned int);
+
+/**
+ * @brief 중복 요청 클라이언트를 초기화합니다.
+ *
+ * @param pstClient 클라이언트
+ * @param pstBalancer 연결을 빌릴 백엔드 집합
+ * @param pstBudget 여러 클라이언트가 함께 쓰는 예산
+ * @param kpstConfig 설정 (NULL이면 기본값)
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int initHedgeClient(TcpHedgeClient *, TcpBalancer *, TcpHedgeBudget *, const TcpHedgeConfig *);
+
+/**
+ * @brief 중복 요청 클라이언트의 타이밍 휠과 응답 버퍼를 해제합니다.
+ *
+ * @param pstClient 클라이언트
+ */
+void destroyHedgeClient(TcpHedgeClient *);
+
+/**
+ * @brief 멱등 요청을 보내고, 늦으면 다른 연결로 한 번 더 보내 먼저 온 응답을 받습니다.
+ *
+ * @details 첫 요청 백엔드의 최근 지연 백분위(getBackendLatency())만큼 기다려도 응답이 없고 예산이
+ *          남아 있으면 acquireOtherBackendConn()으로 빌린 연결에 같은 요청을 보냅니다. 먼저 온
+ *          응답의 연결은 반납하여 지연을 기록하고, 나머지 요청은 cancelBackendConn()으로 연결을 닫아
+ *          취소합니다. 응답은 recvFrameNonBlocking()으로 연결마다 이어 받으므로, 백엔드가 프레임
+ *          중간에서 멈춰도 중복 요청과 제한 시간은 제때 처리됩니다.
+ *
+ * @param pstClient 클라이언트
+ * @param kpvKey 백엔드 선택 키 (NULL이면 P2C, 중복 요청은 항상 P2C)
+ * @param uiKeyLength 키 길이
+ * @param kpvRequest 요청 페이로드
+ * @param uiRequestLength 요청 길이
+ * @param pvResponse 응답 페이로드를 저장할 버퍼
+ * @param uiCapacity 버퍼 크기
+ * @param iTimeoutMsec 전체 제한 시간 (0 이하이면 제한 없음)
+ * @param piHedged 중복 요청을 보냈으면 1, 그 응답이 먼저 왔으면 2를 저장 (NULL 가능)
+ * @return 성공 시 응답 페이로드 바이트 수, 실패 또는 시간 초과 시 -1 반환
+ */
+int sendHedgedRequest(TcpHedgeClient *, const void *, size_t, const void *, size_t, void *, size_t, int, int *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
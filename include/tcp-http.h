@@ -0,0 +1,185 @@
+#ifndef TCP_HTTP_H
+#define TCP_HTTP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief   요청 하나에서 해석하는 헤더 최대 개수
+ */
+#define TCP_HTTP_MAX_HEADERS            32
+
+/**
+ * @brief   sendHttpResponse()로 보낼 수 있는 헤더 최대 개수 (헤더마다 iovec 4개 사용)
+ */
+#define TCP_HTTP_MAX_RESPONSE_HEADERS   14
+
+/**
+ * @brief   parseHttpRequest() 오류 코드: 헤더가 TCP_HTTP_MAX_HEADERS개보다 많음
+ */
+#define TCP_HTTP_ERR_TOO_MANY_HEADERS   -2
+
+/**
+ * @brief   sendHttpResponse() 옵션
+ */
+#define TCP_HTTP_CLOSE                  0x1     /**< Connection: close를 붙임 */
+#define TCP_HTTP_CHUNKED                0x2     /**< Transfer-Encoding: chunked로 보내고 본문은 첫 조각으로 보냄 */
+
+/**
+ * @brief 수신 버퍼 안의 문자열 (NUL 종료되지 않음)
+ */
+typedef struct {
+    const char *kpchData;       /**< 시작 위치 */
+    size_t uiLength;            /**< 길이 */
+} TcpHttpStr;
+
+/**
+ * @brief 헤더 이름과 값 (값의 앞뒤 공백은 제외)
+ */
+typedef struct {
+    TcpHttpStr stName;
+    TcpHttpStr stValue;
+} TcpHttpHeader;
+
+/**
+ * @brief 해석한 HTTP/1.x 요청
+ *
+ * @details 모든 문자열은 수신 버퍼를 가리키므로 다음 recvHttpRequest() 호출 전까지만
+ *          유효합니다. chunked 본문은 수신 버퍼 안에서 조각 헤더를 걷어내고 이어 붙인 결과를
+ *          가리킵니다.
+ */
+typedef struct {
+    TcpHttpStr stMethod;                            /**< 메서드 */
+    TcpHttpStr stTarget;                            /**< 요청 대상 (경로와 쿼리) */
+    int iMinorVersion;                              /**< HTTP/1.x의 x (0 또는 1) */
+    int iHeaders;                                   /**< 헤더 개수 */
+    TcpHttpHeader astHeaders[TCP_HTTP_MAX_HEADERS]; /**< 헤더 (수신 순서) */
+    TcpHttpStr stBody;                              /**< 본문 (recvHttpRequest()가 채움) */
+    unsigned long long ullContentLength;            /**< Content-Length 값 (chunked이면 0) */
+    unsigned char ucChunked;                        /**< Transfer-Encoding: chunked이면 1 */
+    unsigned char ucKeepAlive;                      /**< 응답 후 연결을 유지해야 하면 1 */
+    unsigned char ucExpectContinue;                 /**< Expect: 100-continue이면 1 */
+} TcpHttpRequest;
+
+/**
+ * @brief 서버 측 HTTP 연결 상태
+ *
+ * @details 호출자가 제공한 수신 버퍼 하나로 요청을 읽으며, 파이프라인으로 이어서 도착한
+ *          요청은 버퍼에 남겨 두었다가 다음 호출에서 돌려줍니다. 요청 최대 크기(헤더 + 본문)는
+ *          버퍼 크기입니다.
+ */
+typedef struct {
+    int iSock;                  /**< 소켓 파일 디스크립터 */
+    char *pchBuffer;            /**< 수신 버퍼 */
+    size_t uiCapacity;          /**< 수신 버퍼 크기 */
+    size_t uiStart;             /**< 아직 돌려주지 않은 데이터의 시작 위치 */
+    size_t uiEnd;               /**< 수신한 데이터의 끝 위치 */
+    size_t uiConsumed;          /**< 직전에 돌려준 요청이 차지한 바이트 수 */
+} TcpHttpConn;
+
+/**
+ * @brief 버퍼에서 요청 줄과 헤더를 해석합니다.
+ *
+ * @details 줄 끝과 헤더 이름의 ':'는 x86에서 실행 중인 CPU에 따라 AVX2 또는 SSE2로
+ *          32/16바이트씩 찾으며, 같은 비교로 허용되지 않는 제어 문자도 걸러냅니다.
+ *          Content-Length와 Transfer-Encoding이 함께 있거나, Content-Length 값이 서로
+ *          다르거나, chunked가 아닌 전송 코딩이면 잘못된 요청으로 봅니다. 본문은 해석하지
+ *          않으므로 stBody는 비워 둡니다.
+ *
+ * @param kpvData 수신 데이터
+ * @param uiLength 수신 데이터 길이
+ * @param pstRequest 해석 결과를 저장할 구조체 포인터
+ * @return 빈 줄까지의 헤더 길이, 데이터가 부족하면 0, 잘못된 요청이면 -1,
+ *         헤더가 너무 많으면 TCP_HTTP_ERR_TOO_MANY_HEADERS 반환
+ */
+int parseHttpRequest(const void *, size_t, TcpHttpRequest *);
+
+/**
+ * @brief 이름이 일치하는 첫 번째 헤더 값을 찾습니다 (대소문자 무시).
+ *
+ * @param kpstRequest 해석한 요청
+ * @param kpchName 헤더 이름
+ * @return 헤더 값, 없으면 NULL 반환
+ */
+const TcpHttpStr *findHttpHeader(const TcpHttpRequest *, const char *);
+
+/**
+ * @brief 쉼표로 구분한 헤더 값에 토큰이 있는지 확인합니다 (대소문자 무시).
+ *
+ * @param kpstValue 헤더 값 (예: Connection: keep-alive, Upgrade)
+ * @param kpchToken 찾을 토큰
+ * @return 있으면 1, 없으면 0 반환
+ */
+int hasHttpToken(const TcpHttpStr *, const char *);
+
+/**
+ * @brief 상태 코드의 사유 문구를 반환합니다.
+ *
+ * @param iStatus 상태 코드
+ * @return 사유 문구 (모르는 코드면 "Unknown")
+ */
+const char *getHttpReason(int);
+
+/**
+ * @brief HTTP 연결 상태를 초기화합니다.
+ *
+ * @param pstConn 초기화할 연결 상태
+ * @param iSock 연결 소켓
+ * @param pvBuffer 수신 버퍼 (연결을 닫을 때까지 유지)
+ * @param uiCapacity 수신 버퍼 크기 (최대 요청 크기)
+ */
+void initHttpConn(TcpHttpConn *, int, void *, size_t);
+
+/**
+ * @brief 요청 하나를 본문까지 수신합니다(요청 전체 수신까지 블로킹).
+ *
+ * @details 직전에 돌려준 요청을 버리고, 버퍼에 남은 파이프라인 요청부터 해석합니다.
+ *          chunked 본문은 버퍼 안에서 이어 붙이고 트레일러는 건너뜁니다. 본문을 기다려야
+ *          하는 Expect: 100-continue 요청에는 100 Continue를 먼저 보냅니다. 요청이
+ *          잘못되었으면 400, 헤더가 버퍼보다 크거나 너무 많으면 431, 본문이 버퍼에 들어가지
+ *          않으면 413 응답을 보내고 -1을 반환하며, 이때 연결은 닫아야 합니다.
+ *
+ * @param pstConn 연결 상태
+ * @param pstRequest 수신한 요청 (문자열은 수신 버퍼를 가리킴)
+ * @return 성공 시 요청 전체 길이, 연결 종료 시 TCP_DISCONNECTION, 실패 시 -1 반환
+ */
+int recvHttpRequest(TcpHttpConn *, TcpHttpRequest *);
+
+/**
+ * @brief 응답 하나를 전송합니다(전체 전송 완료까지 블로킹).
+ *
+ * @details 상태 줄과 Content-Length(또는 Transfer-Encoding), Connection 헤더만 스택에서
+ *          만들고, 호출자의 헤더와 본문은 복사하지 않고 iovec으로 묶어 sendMessageV()
+ *          한 번으로 보냅니다. TCP_HTTP_CHUNKED이면 본문(있으면)을 첫 조각으로 보내며,
+ *          이후 sendHttpChunk()로 이어 보내고 길이 0 조각으로 끝냅니다.
+ *          1xx, 204, 304 응답에는 본문 길이 헤더를 붙이지 않습니다.
+ *
+ * @param iSock 데이터를 전송할 소켓 디스크립터
+ * @param iStatus 상태 코드
+ * @param kpstHeaders 추가 헤더 (NULL 가능)
+ * @param iHeaders 추가 헤더 개수 (최대 TCP_HTTP_MAX_RESPONSE_HEADERS)
+ * @param kpvBody 본문 (NULL 가능)
+ * @param uiLength 본문 길이
+ * @param iFlags TCP_HTTP_CLOSE, TCP_HTTP_CHUNKED 조합
+ * @return 성공 시 전송한 본문 바이트 수, 실패 시 -1 반환
+ */
+int sendHttpResponse(int, int, const TcpHttpHeader *, int, const void *, size_t, int);
+
+/**
+ * @brief chunked 응답의 조각 하나를 전송합니다.
+ *
+ * @param iSock 데이터를 전송할 소켓 디스크립터
+ * @param kpvData 조각 데이터
+ * @param uiLength 조각 길이 (0이면 마지막 조각을 보내 응답을 끝냄)
+ * @return 성공 시 전송한 데이터 바이트 수, 실패 시 -1 반환
+ */
+int sendHttpChunk(int, const void *, size_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
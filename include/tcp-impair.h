@@ -0,0 +1,97 @@
+#ifndef TCP_IMPAIR_H
+#define TCP_IMPAIR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "tcp-conn.h"
+
+/**
+ * @brief   전송 대기열 기본 한도 (바이트)
+ * @details 지연 중인 데이터가 이 크기에 도달하면 송신 함수가 소켓 버퍼가 가득 찬 것처럼 대기합니다.
+ */
+#define TCP_IMPAIR_DEFAULT_QUEUE    (256 * 1024)
+
+/**
+ * @brief 연결별 네트워크 장애 설정
+ *
+ * @details 0인 항목은 해당 장애를 적용하지 않습니다. 지연/지터/대역폭은 이 연결에서
+ *          전송하는 방향에만 적용되므로, 양방향에 적용하려면 양쪽 소켓에 설정합니다.
+ */
+typedef struct {
+    unsigned int uiDelayUsec;           /**< 추가 단방향 지연 */
+    unsigned int uiJitterUsec;          /**< 지연에 더할 균등 분포 지터의 최대값 */
+    unsigned long long ullRateBytes;    /**< 대역폭 한도 (바이트/초) */
+    unsigned int uiMaxWrite;            /**< 송신 호출 한 번에 받아들이는 최대 바이트 (부분 쓰기) */
+    unsigned int uiMaxRead;             /**< 수신 호출 한 번에 돌려주는 최대 바이트 (부분 읽기) */
+    unsigned int uiStallPermille;       /**< 송수신 호출마다 멈춤이 발생할 확률 (천분율) */
+    unsigned int uiStallUsec;           /**< 멈춤 시간 */
+    unsigned int uiQueueLimit;          /**< 전송 대기열 한도 (0이면 TCP_IMPAIR_DEFAULT_QUEUE) */
+} TcpImpairment;
+
+/**
+ * @brief "delay=200,jitter=50,rate=1000000,write=512,read=256,stall=5:2000,queue=65536" 형식의
+ *        문자열을 해석합니다.
+ *
+ * @details 시간은 마이크로초, rate는 바이트/초, stall은 "천분율:마이크로초" 입니다.
+ *          지정하지 않은 항목은 0입니다.
+ *
+ * @param kpchSpec 설정 문자열
+ * @param pstImpair 결과를 저장할 구조체
+ * @return 성공 시 0, 알 수 없는 항목이 있으면 -1 반환
+ */
+int parseImpairment(const char *, TcpImpairment *);
+
+/**
+ * @brief 연결에 네트워크 장애를 설정하거나 해제합니다 (디버그/성능 시험용).
+ *
+ * @details 설정된 연결의 송신 데이터는 실제 전송 대신 복사되어 대기열에 들어가고,
+ *          장애 스레드가 타이밍 휠에 따라 지연/대역폭에 맞춰 전송합니다. 부분 쓰기/읽기와
+ *          멈춤은 호출한 스레드에서 적용됩니다. 모든 연결이 하나의 잠금과 스레드를 공유하므로
+ *          운영 환경에서는 사용하지 않습니다.
+ *          해제(NULL)할 때는 대기열이 모두 전송될 때까지 기다리므로, 소켓을 닫기 전에 해제합니다.
+ *
+ * @param iSock 연결 소켓 (연결 테이블에 등록되어 있어야 함)
+ * @param kpstImpair 장애 설정 (NULL이면 해제)
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int setConnImpairment(int, const TcpImpairment *);
+
+/**
+ * @brief 장애가 설정된 연결로 데이터를 전송합니다 (라이브러리 내부용).
+ *
+ * @details 대기열에 공간이 생길 때까지 기다린 뒤 받아들인 바이트 수를 반환합니다.
+ *          앞선 실제 전송이 실패했거나 기다리는 동안 연결이 제거되면 errno를 설정하고 -1을
+ *          반환합니다. 호출 직전에 장애가 해제되었으면 바로 writev()로 전송합니다.
+ */
+ssize_t sendImpaired(TcpConnInfo *, const struct iovec *, int);
+
+/**
+ * @brief 수신 요청 크기에 부분 읽기와 멈춤을 적용합니다 (라이브러리 내부용).
+ *
+ * @details 장애가 설정된 연결이 하나도 없으면 원자적 읽기 한 번으로 돌아갑니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @param uiLength 요청 크기
+ * @return 적용 후 요청 크기
+ */
+size_t limitImpairedRecv(int, size_t);
+
+/**
+ * @brief 연결의 장애 상태와 대기 중인 데이터를 버립니다 (removeConnInfo()에서 호출).
+ *
+ * @details 대기열 공간을 기다리던 송신 스레드는 EPIPE로 돌려보내고, 상태를 사용 중인
+ *          송신 스레드가 모두 빠져나간 뒤 해제합니다.
+ */
+void releaseConnImpairment(TcpConnInfo *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef TCP_LISTEN_H
+#define TCP_LISTEN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   수신 대기 큐 경보의 기본 임계값 (accept 큐 한도 대비 사용률, %)
+ */
+#define TCP_LISTEN_DEFAULT_QUEUE_PERCENT    80
+
+/**
+ * @brief 수신 대기 소켓의 큐 상태 샘플
+ */
+typedef struct {
+    unsigned int uiQueueLength;         /**< 현재 accept 큐 길이 (TCP_INFO tcpi_unacked) */
+    unsigned int uiBacklog;             /**< accept 큐 한도 (TCP_INFO tcpi_sacked) */
+    unsigned long long ullOverflows;    /**< 시스템 전체 ListenOverflows 누적값 */
+    unsigned long long ullDrops;        /**< 시스템 전체 ListenDrops 누적값 */
+} TcpListenStats;
+
+/**
+ * @brief 경보 사유
+ */
+typedef enum {
+    TCP_LISTEN_ALERT_QUEUE = 0x01,      /**< accept 큐 사용률이 임계값 이상 */
+    TCP_LISTEN_ALERT_OVERFLOW = 0x02,   /**< 직전 샘플 이후 ListenOverflows/ListenDrops 증가 */
+} TcpListenAlert;
+
+/**
+ * @brief 수신 대기 큐 경보 콜백
+ *
+ * @details 모니터 스레드에서 호출됩니다. accept 작업자를 늘리는 등의 대응을 여기서 수행합니다.
+ *
+ * @param iListenSock 수신 대기 소켓
+ * @param iReasons 경보 사유 (TcpListenAlert 조합)
+ * @param kpstStats 경보를 발생시킨 샘플
+ * @param pvArg startListenMonitor()에 전달한 인자
+ */
+typedef void (*TcpListenAlertHandler)(int, int, const TcpListenStats *, void *);
+
+/**
+ * @brief 수신 대기 소켓의 큐 상태를 샘플링하고 게이지를 갱신합니다.
+ *
+ * @details createServerSocket()으로 만든 소켓에 TCP_INFO를 조회하고 /proc/net/netstat의
+ *          ListenOverflows/ListenDrops를 읽습니다. /proc을 읽지 못하면 두 값은 0입니다.
+ *
+ * @param iListenSock 수신 대기 소켓
+ * @param pstStats 샘플을 저장할 구조체 포인터
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int sampleListenQueue(int, TcpListenStats *);
+
+/**
+ * @brief 수신 대기 큐 모니터 스레드를 시작합니다.
+ *
+ * @details 주기마다 sampleListenQueue()를 호출하고, accept 큐 사용률이 임계값 이상이거나
+ *          오버플로/드롭 카운터가 증가하면 listen_alerts 카운터를 올리고 콜백을 호출합니다.
+ *
+ * @param iListenSock 수신 대기 소켓
+ * @param iIntervalMsec 샘플링 주기 (ms)
+ * @param uiQueuePercent 경보 임계값 (%, 0이면 TCP_LISTEN_DEFAULT_QUEUE_PERCENT)
+ * @param pfnHandler 경보 콜백 (NULL 가능)
+ * @param pvArg 콜백 인자
+ * @return 성공 시 0, 실패 또는 이미 실행 중이면 -1 반환
+ */
+int startListenMonitor(int, int, unsigned int, TcpListenAlertHandler, void *);
+
+/**
+ * @brief 수신 대기 큐 모니터 스레드를 중지합니다.
+ */
+void stopListenMonitor(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
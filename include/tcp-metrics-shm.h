@@ -0,0 +1,138 @@
+#ifndef TCP_METRICS_SHM_H
+#define TCP_METRICS_SHM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "tcp-metrics.h"
+
+/**
+ * @brief   공유 메모리 메트릭 세그먼트의 형식을 정의합니다.
+ * @details 세그먼트는 헤더, 스레드 슬롯, 히스토그램, 연결 슬롯 순서로 배치됩니다.
+ *          형식이 바뀌면 TCP_SHM_VERSION을 올리며, 읽는 쪽은 매직과 버전을 먼저 확인해야 합니다.
+ */
+#define TCP_SHM_MAGIC           "TCPSHM"
+#define TCP_SHM_VERSION         2
+#define TCP_SHM_NAME_SIZE       32
+#define TCP_SHM_MAX_COUNTERS    32
+#define TCP_SHM_MAX_GAUGES      16
+#define TCP_SHM_MAX_HISTOGRAMS  32
+#define TCP_SHM_THREAD_SLOTS    256
+#define TCP_SHM_DEFAULT_CONNS   4096
+
+/**
+ * @brief 세그먼트 헤더
+ *
+ * @details uiSeq는 세그먼트 전체에 대한 시퀀스 잠금(seqlock)으로, 초기화 중에는 홀수입니다.
+ */
+typedef struct {
+    char achMagic[8];                                           /**< TCP_SHM_MAGIC */
+    unsigned int uiVersion;                                     /**< TCP_SHM_VERSION */
+    unsigned int uiSeq;                                         /**< 초기화 중이면 홀수 */
+    unsigned int uiCounterCount;                                /**< 사용 중인 카운터 수 */
+    unsigned int uiGaugeCount;                                  /**< 사용 중인 게이지 수 */
+    unsigned int uiHistogramCount;                              /**< 사용 중인 히스토그램 수 */
+    unsigned int uiThreadSlots;                                 /**< 스레드 슬롯 수 */
+    unsigned int uiConnSlots;                                   /**< 연결 슬롯 수 */
+    int iPid;                                                   /**< 게시한 프로세스 ID */
+    unsigned long long ullStartNsec;                            /**< 게시 시각 (CLOCK_MONOTONIC) */
+    unsigned long long ullCycleHz;                              /**< 연결별 CPU 비용 단위의 초당 증가량 */
+    char aachCounterNames[TCP_SHM_MAX_COUNTERS][TCP_SHM_NAME_SIZE];
+    char aachGaugeNames[TCP_SHM_MAX_GAUGES][TCP_SHM_NAME_SIZE];
+    char aachHistogramNames[TCP_SHM_MAX_HISTOGRAMS][TCP_SHM_NAME_SIZE];
+    long long allGauges[TCP_SHM_MAX_GAUGES];                    /**< 게이지 값 */
+} TcpShmHeader;
+
+/**
+ * @brief 스레드별 카운터 슬롯
+ *
+ * @details 각 스레드는 자신의 슬롯만 갱신하므로 카운터 갱신 시 캐시 라인 경합이 없습니다.
+ *          전역 카운터 값은 모든 슬롯의 합입니다.
+ */
+typedef struct {
+    int iTid;                                                   /**< 스레드 ID (미사용 시 0) */
+    unsigned int uiInUse;                                       /**< 슬롯 사용 여부 */
+    char achName[16];                                           /**< 스레드 이름 */
+    unsigned long long aullCounters[TCP_SHM_MAX_COUNTERS];
+} __attribute__((aligned(64))) TcpShmThreadSlot;
+
+/**
+ * @brief 메트릭 세그먼트 (연결 슬롯은 구조체 뒤에 uiConnSlots 개가 이어짐)
+ */
+typedef struct {
+    TcpShmHeader stHeader;
+    TcpShmThreadSlot astThreads[TCP_SHM_THREAD_SLOTS];
+    TcpHistogram astHistograms[TCP_SHM_MAX_HISTOGRAMS];
+} __attribute__((aligned(64))) TcpMetricsSegment;
+
+/**
+ * @brief 세그먼트의 연결 슬롯 배열을 반환합니다.
+ */
+#define TCP_SHM_CONN_SLOTS(pstSegment) \
+    ((TcpConnStats *)((char *)(pstSegment) + sizeof(TcpMetricsSegment)))
+
+/**
+ * @brief 현재 메트릭이 기록되는 세그먼트 (라이브러리 내부용)
+ *
+ * @details 게시 전에는 프로세스 내부의 정적 세그먼트를, 게시 후에는 공유 메모리 세그먼트를 가리킵니다.
+ */
+extern TcpMetricsSegment *g_pstMetricsSegment;
+
+/**
+ * @brief 소켓에 대응하는 공유 메모리 연결 슬롯을 반환합니다(라이브러리 내부용).
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @return 게시 중이고 슬롯 범위 안이면 슬롯 포인터, 아니면 NULL
+ */
+TcpConnStats *acquireConnStatsSlot(int);
+
+/**
+ * @brief 라이브러리 메트릭을 공유 메모리 세그먼트에 게시합니다.
+ *
+ * @details 호출 시점까지의 값을 세그먼트로 복사한 뒤, 이후의 모든 카운터/게이지/히스토그램/연결 통계는
+ *          세그먼트에 직접 기록됩니다(시스템 콜 없음). 연결 통계는 파일 디스크립터 번호가
+ *          uiConnSlots 미만인 연결만 게시됩니다. 전환 도중 다른 스레드의 갱신 일부가 유실될 수 있으므로
+ *          프로그램 시작 시 호출하는 것을 권장합니다.
+ *
+ * @param kpchPath 세그먼트 파일 경로 (예: /dev/shm/tcpsock.1234), NULL이면 memfd를 사용
+ *                 (외부 도구는 /proc/<pid>/fd/<반환값> 으로 접근)
+ * @param uiConnSlots 연결 슬롯 수 (0이면 TCP_SHM_DEFAULT_CONNS)
+ * @return 성공 시 세그먼트 파일 디스크립터, 실패 시 -1 반환
+ */
+int publishMetricsShm(const char *, unsigned int);
+
+/**
+ * @brief 게시 중인 세그먼트를 반환합니다.
+ *
+ * @return 게시 중이면 세그먼트 포인터, 아니면 NULL
+ */
+const TcpMetricsSegment *getPublishedMetricsShm(void);
+
+/**
+ * @brief 외부 프로세스에서 세그먼트 파일을 읽기 전용으로 엽니다.
+ *
+ * @param kpchPath 세그먼트 파일 경로
+ * @param puiSize 매핑된 크기를 저장할 포인터
+ * @return 성공 시 세그먼트 포인터, 실패 또는 형식 불일치 시 NULL
+ */
+const TcpMetricsSegment *openMetricsShm(const char *, size_t *);
+
+/**
+ * @brief 연결 슬롯 하나를 시퀀스 잠금으로 일관되게 복사합니다.
+ *
+ * @details 갱신 중인 슬롯은 다시 읽으며, 정해진 횟수 안에 일관된 값을 얻지 못하면
+ *          (쓰는 스레드가 갱신 도중 종료된 경우 등) 포기합니다.
+ *
+ * @param kpstSlot 세그먼트의 연결 슬롯
+ * @param pstOut 복사할 구조체 포인터
+ * @return 사용 중인 슬롯이면 1, 비어 있으면 0, 일관된 값을 읽지 못하면 -1
+ */
+int readConnStatsSnapshot(const TcpConnStats *, TcpConnStats *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef TCP_METRICS_H
+#define TCP_METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief   히스토그램 버킷 구성을 정의합니다.
+ * @details 값(나노초 등)을 2의 거듭제곱 구간으로 나눈 뒤, 각 구간을 다시
+ *          TCP_HIST_SUB_BUCKETS 개로 균등 분할합니다. 상대 오차는 최대 25% 입니다.
+ */
+#define TCP_HIST_SUB_BITS       2
+#define TCP_HIST_SUB_BUCKETS    (1 << TCP_HIST_SUB_BITS)
+#define TCP_HIST_BUCKETS        (64 * TCP_HIST_SUB_BUCKETS)
+
+/**
+ * @brief 지연 시간 등 분포를 기록하는 히스토그램
+ *
+ * @details 모든 필드는 원자적으로 갱신되므로 여러 스레드에서 동시에 기록할 수 있습니다.
+ */
+typedef struct {
+    unsigned long long aullBuckets[TCP_HIST_BUCKETS];
+    unsigned long long ullCount;
+    unsigned long long ullSum;
+    unsigned long long ullMax;
+} TcpHistogram;
+
+/**
+ * @brief 라이브러리가 기록하는 히스토그램 목록
+ */
+typedef enum {
+    TCP_METRIC_WIRE_TO_APP = 0,     /**< 커널 RX 타임스탬프 ~ 애플리케이션 수신 완료 (ns) */
+    TCP_METRIC_APP_TO_ACK,          /**< 애플리케이션 전송 ~ 상대방 ACK 수신 (ns) */
+    TCP_METRIC_STAGE_RECV,          /**< 수신 가능 통지 ~ 수신 완료 (ns) */
+    TCP_METRIC_STAGE_PARSE,         /**< 수신 완료 ~ 헤더 해석 완료 (ns) */
+    TCP_METRIC_STAGE_HANDOFF,       /**< 해석 완료 ~ 핸들러 전달 (ns) */
+    TCP_METRIC_STAGE_HANDLER,       /**< 핸들러 전달 ~ 핸들러 반환 (ns) */
+    TCP_METRIC_STAGE_ENQUEUE,       /**< 핸들러 반환 ~ 응답 전송 요청 (ns) */
+    TCP_METRIC_STAGE_SYSCALL,       /**< 응답 전송 요청 ~ 전송 시스템 콜 완료 (ns) */
+    TCP_METRIC_STAGE_TOTAL,         /**< 첫 단계 ~ 마지막 단계 (ns) */
+    TCP_METRIC_HISTOGRAM_COUNT
+} TcpMetricHistogram;
+
+/**
+ * @brief 라이브러리가 기록하는 카운터 목록 (스레드별로 누적되며 전역 값은 합계)
+ */
+typedef enum {
+    TCP_COUNTER_BYTES_SENT = 0,     /**< 전송한 바이트 수 */
+    TCP_COUNTER_BYTES_RECEIVED,     /**< 수신한 바이트 수 */
+    TCP_COUNTER_SEND_CALLS,         /**< 전송 시스템 콜 횟수 */
+    TCP_COUNTER_RECV_CALLS,         /**< 수신 시스템 콜 횟수 */
+    TCP_COUNTER_ACCEPTS,            /**< 수락한 연결 수 */
+    TCP_COUNTER_CONNECTS,           /**< 성공한 연결 수 */
+    TCP_COUNTER_CONNECT_FAILURES,   /**< 실패한 연결 수 */
+    TCP_COUNTER_TIMEOUTS,           /**< 수신 타임아웃 횟수 */
+    TCP_COUNTER_DISCONNECTS,        /**< 감지한 연결 종료 수 */
+    TCP_COUNTER_LISTEN_ALERTS,      /**< 수신 대기 큐 경보 횟수 */
+    TCP_COUNTER_RESOLVE_HITS,       /**< 이름 해석 캐시 적중 수 (부정 캐시 포함) */
+    TCP_COUNTER_RESOLVE_QUERIES,    /**< 보낸 DNS 질의 수 */
+    TCP_COUNTER_RESOLVE_FAILURES,   /**< 실패한 이름 해석 수 (없는 이름 제외) */
+    TCP_COUNTER_BACKEND_EJECTIONS,  /**< 이상치 백엔드 제외 횟수 (탐침 실패로 다시 제외 포함) */
+    TCP_COUNTER_HEDGES,             /**< 보낸 중복 요청 수 */
+    TCP_COUNTER_HEDGE_WINS,         /**< 중복 요청의 응답이 먼저 온 횟수 */
+    TCP_COUNTER_HEDGE_DENIED,       /**< 예산이 모자라 보내지 않은 중복 요청 수 */
+    TCP_METRIC_COUNTER_COUNT
+} TcpMetricCounter;
+
+/**
+ * @brief 라이브러리가 기록하는 게이지 목록
+ */
+typedef enum {
+    TCP_GAUGE_OPEN_CONNECTIONS = 0, /**< 연결 테이블에 등록된 연결 수 */
+    TCP_GAUGE_ACCEPT_QUEUE,         /**< 수신 대기 소켓의 accept 큐 길이 (마지막 샘플) */
+    TCP_GAUGE_ACCEPT_BACKLOG,       /**< 수신 대기 소켓의 accept 큐 한도 */
+    TCP_GAUGE_LISTEN_OVERFLOWS,     /**< 시스템 전체 ListenOverflows (/proc/net/netstat) */
+    TCP_GAUGE_LISTEN_DROPS,         /**< 시스템 전체 ListenDrops (/proc/net/netstat) */
+    TCP_METRIC_GAUGE_COUNT
+} TcpMetricGauge;
+
+/**
+ * @brief 연결별 CPU 비용 분류
+ */
+typedef enum {
+    TCP_COST_RECV = 0,              /**< 수신 시스템 콜 */
+    TCP_COST_SEND,                  /**< 전송 시스템 콜 */
+    TCP_COST_PARSE,                 /**< 프레임 헤더 해석 */
+    TCP_COST_HANDLER,               /**< 애플리케이션 핸들러 */
+    TCP_COST_KIND_COUNT
+} TcpCostKind;
+
+/**
+ * @brief 연결별 통계
+ *
+ * @details 공유 메모리 게시 중에는 세그먼트의 연결 슬롯에 직접 기록되며,
+ *          uiSeq 시퀀스 잠금으로 읽는 쪽이 일관된 값을 얻을 수 있습니다(기록 중이면 홀수).
+ */
+typedef struct {
+    unsigned int uiSeq;                 /**< 시퀀스 잠금 */
+    int iSock;                          /**< 소켓 파일 디스크립터 (미사용 시 -1) */
+    int iOwnerTid;                      /**< 연결을 등록한 스레드 ID */
+    unsigned int uiReserved;
+    unsigned long long ullCreatedNsec;  /**< 등록 시각 (CLOCK_MONOTONIC) */
+    unsigned long long ullLastActiveNsec;/**< 마지막 송수신 시각 (CLOCK_MONOTONIC) */
+    unsigned long long ullBytesIn;      /**< 수신 바이트 수 */
+    unsigned long long ullBytesOut;     /**< 전송 바이트 수 */
+    unsigned long long ullMsgsIn;       /**< 수신 시스템 콜 횟수 */
+    unsigned long long ullMsgsOut;      /**< 전송 시스템 콜 횟수 */
+    unsigned long long aullCostCycles[TCP_COST_KIND_COUNT]; /**< 분류별 CPU 비용 (getCycleCount() 단위) */
+} TcpConnStats;
+
+/**
+ * @brief 요청 처리 단계
+ *
+ * @details 각 단계의 히스토그램에는 직전에 기록된 단계로부터의 경과 시간이 기록됩니다.
+ */
+typedef enum {
+    TCP_STAGE_READY = 0,        /**< 수신 가능 통지 (select 반환, 프레임 헤더 도착) */
+    TCP_STAGE_RECV,             /**< 수신 시스템 콜 완료 */
+    TCP_STAGE_PARSE,            /**< 프레임 헤더 해석 완료 */
+    TCP_STAGE_HANDOFF,          /**< 핸들러 전달 (애플리케이션이 기록) */
+    TCP_STAGE_HANDLER_RETURN,   /**< 핸들러 반환 (애플리케이션이 기록) */
+    TCP_STAGE_ENQUEUE,          /**< 응답 전송 요청 */
+    TCP_STAGE_SENT,             /**< 전송 시스템 콜 완료 */
+    TCP_STAGE_COUNT
+} TcpStage;
+
+/**
+ * @brief 요청 하나의 단계별 시각 기록
+ */
+typedef struct {
+    unsigned long long aullStampNsec[TCP_STAGE_COUNT]; /**< 단계별 시각 (기록되지 않은 단계는 0) */
+    int iSampled;                                      /**< 샘플링 여부 */
+} TcpStageStamps;
+
+/**
+ * @brief 현재 스레드에 연결된 단계 기록 (샘플링되지 않았으면 NULL)
+ */
+extern __thread TcpStageStamps *t_pstThreadStages;
+
+/**
+ * @brief 현재 스레드에 연결된 요청의 단계 시각을 기록합니다.
+ *
+ * @details 라이브러리 송수신 함수 내부에서 사용하며, 샘플링되지 않은 요청의 비용은 분기 한 번입니다.
+ *          이미 기록된 단계는 덮어쓰지 않습니다.
+ */
+#define TCP_STAGE_MARK(eStage) \
+    do { \
+        if (t_pstThreadStages != NULL && t_pstThreadStages->aullStampNsec[eStage] == 0) { \
+            t_pstThreadStages->aullStampNsec[eStage] = getMonotonicNsec(); \
+        } \
+    } while (0)
+
+/**
+ * @brief 단조 증가 시계(CLOCK_MONOTONIC)의 현재 시각을 나노초로 반환합니다.
+ */
+unsigned long long getMonotonicNsec(void);
+
+/**
+ * @brief 실시간 시계(CLOCK_REALTIME)의 현재 시각을 나노초로 반환합니다.
+ *
+ * @details 커널 소켓 타임스탬프와 비교할 때 사용합니다.
+ */
+unsigned long long getRealtimeNsec(void);
+
+/**
+ * @brief CPU 사이클 카운터(x86 TSC, AArch64 CNTVCT)를 읽습니다.
+ *
+ * @details 시스템 콜 없이 읽을 수 있어 호출 단위 비용 측정에 사용합니다.
+ *          사이클 카운터가 없는 아키텍처에서는 getMonotonicNsec()과 같습니다.
+ */
+unsigned long long getCycleCount(void);
+
+/**
+ * @brief getCycleCount()의 초당 증가량을 반환합니다.
+ *
+ * @details 첫 호출 시 단조 시계와 비교하여 한 번 보정하고 이후에는 캐시된 값을 반환합니다.
+ */
+unsigned long long getCycleFrequency(void);
+
+/**
+ * @brief 히스토그램에 값을 기록합니다.
+ *
+ * @param pstHist 히스토그램 포인터
+ * @param ullValue 기록할 값
+ */
+void recordHistogram(TcpHistogram *, unsigned long long);
+
+/**
+ * @brief 히스토그램에서 백분위 값을 계산합니다.
+ *
+ * @param pstHist 히스토그램 포인터
+ * @param dPercentile 백분위 (0.0 ~ 100.0)
+ * @return 해당 백분위가 속한 버킷의 상한값, 기록이 없으면 0
+ */
+unsigned long long getHistogramPercentile(const TcpHistogram *, double);
+
+/**
+ * @brief 히스토그램을 초기화합니다.
+ *
+ * @param pstHist 히스토그램 포인터
+ */
+void resetHistogram(TcpHistogram *);
+
+/**
+ * @brief 라이브러리 히스토그램을 반환합니다.
+ *
+ * @param eId 히스토그램 종류
+ * @return 히스토그램 포인터, 범위를 벗어나면 NULL
+ */
+TcpHistogram *getMetricHistogram(TcpMetricHistogram);
+
+/**
+ * @brief 라이브러리 히스토그램의 이름을 반환합니다.
+ *
+ * @param eId 히스토그램 종류
+ * @return 히스토그램 이름 문자열, 범위를 벗어나면 NULL
+ */
+const char *getMetricHistogramName(TcpMetricHistogram);
+
+/**
+ * @brief 현재 스레드의 카운터를 증가시킵니다.
+ *
+ * @param eId 카운터 종류
+ * @param ullDelta 증가량
+ */
+void addMetricCounter(TcpMetricCounter, unsigned long long);
+
+/**
+ * @brief 모든 스레드의 카운터 합계를 반환합니다.
+ *
+ * @param eId 카운터 종류
+ * @return 카운터 합계
+ */
+unsigned long long getMetricCounter(TcpMetricCounter);
+
+/**
+ * @brief 카운터의 이름을 반환합니다.
+ *
+ * @param eId 카운터 종류
+ * @return 카운터 이름 문자열, 범위를 벗어나면 NULL
+ */
+const char *getMetricCounterName(TcpMetricCounter);
+
+/**
+ * @brief 게이지 값을 증감합니다.
+ *
+ * @param eId 게이지 종류
+ * @param llDelta 증감량
+ */
+void addMetricGauge(TcpMetricGauge, long long);
+
+/**
+ * @brief 게이지 값을 설정합니다.
+ *
+ * @param eId 게이지 종류
+ * @param llValue 설정할 값
+ */
+void setMetricGauge(TcpMetricGauge, long long);
+
+/**
+ * @brief 게이지 값을 반환합니다.
+ *
+ * @param eId 게이지 종류
+ * @return 게이지 값
+ */
+long long getMetricGauge(TcpMetricGauge);
+
+/**
+ * @brief 게이지의 이름을 반환합니다.
+ *
+ * @param eId 게이지 종류
+ * @return 게이지 이름 문자열, 범위를 벗어나면 NULL
+ */
+const char *getMetricGaugeName(TcpMetricGauge);
+
+/**
+ * @brief 연결 통계를 초기화합니다.
+ *
+ * @param pstStats 연결 통계 포인터
+ * @param iSock 소켓 파일 디스크립터 (-1이면 미사용으로 표시)
+ */
+void initConnStats(TcpConnStats *, int);
+
+/**
+ * @brief 전송 시스템 콜 한 번의 결과를 카운터와 연결 통계에 기록합니다.
+ *
+ * @param pstStats 연결 통계 포인터 (등록되지 않은 연결이면 NULL)
+ * @param uiBytes 전송한 바이트 수
+ */
+void countSend(TcpConnStats *, size_t);
+
+/**
+ * @brief 수신 시스템 콜 한 번의 결과를 카운터와 연결 통계에 기록합니다.
+ *
+ * @param pstStats 연결 통계 포인터 (등록되지 않은 연결이면 NULL)
+ * @param uiBytes 수신한 바이트 수
+ */
+void countRecv(TcpConnStats *, size_t);
+
+/**
+ * @brief 단계별 지연 측정의 샘플링 비율을 설정합니다.
+ *
+ * @param uiOneInN 스레드마다 N개 요청 중 1개를 측정 (0이면 비활성화)
+ */
+void setStageSampleRate(unsigned int);
+
+/**
+ * @brief 요청 하나의 단계별 시각 기록을 시작하고 현재 스레드에 연결합니다.
+ *
+ * @details 샘플링된 경우, endStageStamps()를 호출할 때까지 현재 스레드의 수신/해석/전송 함수가
+ *          해당 단계의 시각을 자동으로 기록합니다. 핸들러 전달/반환은 markStage()로 기록합니다.
+ *
+ * @param pstStages 단계 기록 구조체 포인터
+ * @return 샘플링된 경우 1, 아니면 0
+ */
+int beginStageStamps(TcpStageStamps *);
+
+/**
+ * @brief 단계 시각을 직접 기록합니다.
+ *
+ * @param pstStages 단계 기록 구조체 포인터
+ * @param eStage 기록할 단계
+ */
+void markStage(TcpStageStamps *, TcpStage);
+
+/**
+ * @brief 단계별 경과 시간을 히스토그램에 기록하고 현재 스레드와의 연결을 해제합니다.
+ *
+ * @param pstStages 단계 기록 구조체 포인터
+ */
+void endStageStamps(TcpStageStamps *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef TCP_PROBE_H
+#define TCP_PROBE_H
+
+/**
+ * @file tcp-probe.h
+ * @brief USDT(User Statically-Defined Tracing) 정적 추적점 정의
+ *
+ * 송수신 경로에 systemtap sys/sdt.h와 호환되는 정적 추적점을 삽입합니다. 추적점은 nop 명령 하나와
+ * .note.stapsdt ELF 노트로만 구성되므로 런타임 의존성이 없고, bpftrace/perf가 연결하지 않았을 때의
+ * 비용은 nop 한 번과 인자 준비뿐입니다. 헤더 전용이며, sys/sdt.h가 없는 환경에서는 동일한 형식의
+ * 노트를 직접 생성합니다. TCP_SOCK_NO_PROBES를 정의하면 모든 추적점이 제거됩니다.
+ *
+ * 추적점 목록 (provider: tcpsock):
+ * - accept(fd, listen_fd, errno)
+ * - connect_start(fd, port)
+ * - connect_done(fd, result, errno)
+ * - send(fd, bytes, errno)
+ * - recv(fd, bytes, errno)
+ * - timeout(fd, timeout_msec)
+ * - disconnect(fd)
+ * - close(fd)
+ *
+ * 사용 예: bpftrace -e 'usdt:./libtcpsock.so:tcpsock:send { @bytes = hist(arg1); }'
+ */
+
+#if !defined(TCP_SOCK_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TCP_PROBE_USE_SYS_SDT   1
+#endif
+#endif
+
+#if defined(TCP_SOCK_NO_PROBES)
+
+#define TCP_PROBE1(name, a1)                    do { } while (0)
+#define TCP_PROBE2(name, a1, a2)                do { } while (0)
+#define TCP_PROBE3(name, a1, a2, a3)            do { } while (0)
+
+#elif defined(TCP_PROBE_USE_SYS_SDT)
+
+#define TCP_PROBE1(name, a1)                    DTRACE_PROBE1(tcpsock, name, a1)
+#define TCP_PROBE2(name, a1, a2)                DTRACE_PROBE2(tcpsock, name, a1, a2)
+#define TCP_PROBE3(name, a1, a2, a3)            DTRACE_PROBE3(tcpsock, name, a1, a2, a3)
+
+#elif (defined(__x86_64__) || defined(__aarch64__)) && defined(__GNUC__)
+
+/**
+ * @brief sys/sdt.h 형식(버전 3)의 .note.stapsdt 노트를 생성합니다.
+ *
+ * @details 모든 인자는 부호 있는 8바이트 값(-8@)으로 전달합니다.
+ *          .stapsdt.base 심볼은 prelink 보정을 위해 sys/sdt.h와 같은 방식으로 한 번만 정의합니다.
+ */
+#define TCP_PROBE_ASM(name, argfmt) \
+    "990: nop\n" \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+    ".balign 4\n" \
+    ".4byte 992f-991f, 994f-993f, 3\n" \
+    "991: .asciz \"stapsdt\"\n" \
+    "992: .balign 4\n" \
+    "993: .8byte 990b\n" \
+    ".8byte _.stapsdt.base\n" \
+    ".8byte 0\n" \
+    ".asciz \"tcpsock\"\n" \
+    ".asciz \"" #name "\"\n" \
+    ".asciz \"" argfmt "\"\n" \
+    "994: .balign 4\n" \
+    ".popsection\n" \
+    ".ifndef _.stapsdt.base\n" \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+    ".weak _.stapsdt.base\n" \
+    ".hidden _.stapsdt.base\n" \
+    "_.stapsdt.base: .space 1\n" \
+    ".size _.stapsdt.base, 1\n" \
+    ".popsection\n" \
+    ".endif\n"
+
+#define TCP_PROBE1(name, a1) \
+    __asm__ __volatile__ (TCP_PROBE_ASM(name, "-8@%0") \
+        :: "nor" ((long long)(a1)))
+#define TCP_PROBE2(name, a1, a2) \
+    __asm__ __volatile__ (TCP_PROBE_ASM(name, "-8@%0 -8@%1") \
+        :: "nor" ((long long)(a1)), "nor" ((long long)(a2)))
+#define TCP_PROBE3(name, a1, a2, a3) \
+    __asm__ __volatile__ (TCP_PROBE_ASM(name, "-8@%0 -8@%1 -8@%2") \
+        :: "nor" ((long long)(a1)), "nor" ((long long)(a2)), "nor" ((long long)(a3)))
+
+#else
+
+#define TCP_PROBE1(name, a1)                    do { } while (0)
+#define TCP_PROBE2(name, a1, a2)                do { } while (0)
+#define TCP_PROBE3(name, a1, a2, a3)            do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef TCP_RESOLVE_H
+#define TCP_RESOLVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <sys/socket.h>
+
+/**
+ * @brief   이름 하나에 대해 보관하는 최대 주소 수
+ */
+#define TCP_RESOLVE_MAX_ADDRS           8
+
+/**
+ * @brief   호스트 이름 최대 길이 (NUL 포함)
+ */
+#define TCP_RESOLVE_HOST_MAX            256
+
+/**
+ * @brief   캐시 항목 수 (2의 거듭제곱)
+ */
+#define TCP_RESOLVE_CACHE_SIZE          256
+
+/**
+ * @brief   해석 대기열 길이
+ */
+#define TCP_RESOLVE_MAX_QUEUE           256
+
+/**
+ * @brief   해석 스레드 최대 수
+ */
+#define TCP_RESOLVE_MAX_THREADS         8
+
+/**
+ * @brief   resolv.conf에서 읽는 최대 네임서버/검색 도메인 수
+ */
+#define TCP_RESOLVE_MAX_SERVERS         3
+#define TCP_RESOLVE_MAX_SEARCH          6
+
+/**
+ * @brief   설정 기본값
+ */
+#define TCP_RESOLVE_DEFAULT_THREADS     2
+#define TCP_RESOLVE_DEFAULT_TIMEOUT     1000    /**< 질의 한 번의 대기 시간 (ms) */
+#define TCP_RESOLVE_DEFAULT_ATTEMPTS    2       /**< 네임서버 목록을 도는 횟수 */
+#define TCP_RESOLVE_DEFAULT_NEGATIVE    30      /**< SOA가 없을 때 없는 이름을 캐시하는 시간 (초) */
+#define TCP_RESOLVE_DEFAULT_HOSTS_TTL   60      /**< hosts 파일 결과를 캐시하는 시간 (초) */
+#define TCP_RESOLVE_DEFAULT_MAX_TTL     3600    /**< 캐시 유지 시간 상한 (초) */
+
+/**
+ * @brief   해석 결과 상태: 이름이 없거나 주소 레코드가 없음 (부정 캐시 대상)
+ */
+#define TCP_RESOLVE_NOT_FOUND           -2
+
+/**
+ * @brief 해석 결과를 얻은 곳
+ */
+typedef enum {
+    TCP_RESOLVE_SOURCE_NUMERIC = 0,     /**< 숫자 주소 문자열 */
+    TCP_RESOLVE_SOURCE_HOSTS,           /**< hosts 파일 */
+    TCP_RESOLVE_SOURCE_DNS,             /**< DNS 질의 */
+} TcpResolveSource;
+
+/**
+ * @brief 해석한 주소 하나
+ */
+typedef struct {
+    int iFamily;                        /**< AF_INET 또는 AF_INET6 */
+    unsigned char aucAddr[16];          /**< 네트워크 바이트 순서 주소 (IPv4는 앞 4바이트) */
+} TcpResolvedAddr;
+
+/**
+ * @brief 이름 해석 결과
+ *
+ * @details 주소는 IPv6, IPv4 순서로 각각 받은 순서를 유지합니다.
+ */
+typedef struct {
+    int iStatus;                        /**< 0: 성공, TCP_RESOLVE_NOT_FOUND: 없는 이름, -1: 실패 (시간 초과 등) */
+    int iSource;                        /**< TcpResolveSource */
+    int iCached;                        /**< 캐시에서 찾았으면 1 */
+    unsigned int uiTtl;                 /**< 남은 캐시 유지 시간 (초) */
+    int iAddrs;                         /**< 주소 수 */
+    TcpResolvedAddr astAddrs[TCP_RESOLVE_MAX_ADDRS];
+} TcpResolveResult;
+
+/**
+ * @brief 해석기 설정 (0이나 NULL인 항목은 resolv.conf 값 또는 기본값 사용)
+ */
+typedef struct {
+    const char *kpchHostsPath;          /**< hosts 파일 (NULL이면 /etc/hosts) */
+    const char *kpchResolvConfPath;     /**< resolv.conf (NULL이면 /etc/resolv.conf) */
+    unsigned int uiNameserverPort;      /**< 네임서버 UDP 포트 (0이면 53, 대역 응답기 시험용) */
+    unsigned int uiThreads;             /**< 해석 스레드 수 */
+    unsigned int uiTimeoutMsec;         /**< 질의 한 번의 대기 시간 */
+    unsigned int uiAttempts;            /**< 네임서버 목록을 도는 횟수 */
+    unsigned int uiNegativeTtl;         /**< SOA가 없을 때 없는 이름을 캐시하는 시간 (초) */
+    unsigned int uiHostsTtl;            /**< hosts 파일 결과를 캐시하는 시간 (초) */
+    unsigned int uiMaxTtl;              /**< 캐시 유지 시간 상한 (초) */
+    unsigned int uiAttemptDelayMsec;    /**< createClientSocketTo()의 연결 시도 간격 (0이면 TCP_CONNECT_RACE_DELAY) */
+    unsigned int uiConnectTimeoutMsec;  /**< createClientSocketTo()의 연결 제한 시간 (0이면 제한 없음) */
+} TcpResolverConfig;
+
+/**
+ * @brief 비동기 해석 완료 콜백
+ *
+ * @details 캐시에서 바로 찾은 경우에는 resolveHostAsync()를 호출한 스레드에서, 그 밖에는
+ *          해석 스레드에서 호출됩니다. 이벤트 루프는 여기서 결과를 자신의 큐로 넘깁니다.
+ *
+ * @param kpchHost 요청한 이름
+ * @param kpstResult 해석 결과
+ * @param pvArg resolveHostAsync()에 전달한 인자
+ */
+typedef void (*TcpResolveCallback)(const char *, const TcpResolveResult *, void *);
+
+/**
+ * @brief 해석기 설정을 바꾸고 해석 스레드를 시작합니다.
+ *
+ * @param kpstConfig 설정 (NULL이면 기본값)
+ * @return 성공 시 0, 실패 또는 이미 실행 중이면 -1 반환
+ */
+int startResolver(const TcpResolverConfig *);
+
+/**
+ * @brief 해석 스레드를 중지하고 캐시를 비우며 설정을 기본값으로 되돌립니다.
+ *
+ * @details 대기열에 남은 요청은 iStatus -1로 완료 처리합니다.
+ */
+void stopResolver(void);
+
+/**
+ * @brief 이름을 해석합니다 (호출 스레드에서 블로킹).
+ *
+ * @details 숫자 주소, 캐시, hosts 파일, DNS 순서로 찾습니다. hosts 파일과 resolv.conf는 캐시에서
+ *          찾지 못할 때마다 다시 읽으므로 변경 사항이 바로 반영됩니다. 해석기를 시작하지 않아도
+ *          현재 설정으로 동작합니다.
+ *
+ * @param kpchHost 이름 또는 숫자 주소
+ * @param pstResult 해석 결과
+ * @return 성공 시 0, 없는 이름이면 TCP_RESOLVE_NOT_FOUND, 실패 시 -1 반환 (pstResult->iStatus와 같음)
+ */
+int resolveHost(const char *, TcpResolveResult *);
+
+/**
+ * @brief 이름 해석을 해석 스레드에 맡깁니다.
+ *
+ * @param kpchHost 이름 또는 숫자 주소
+ * @param pfnCallback 완료 콜백
+ * @param pvArg 콜백 인자
+ * @return 바로 완료했으면 1 (콜백 호출 완료), 대기열에 넣었으면 0, 실패 시 -1 반환
+ */
+int resolveHostAsync(const char *, TcpResolveCallback, void *);
+
+/**
+ * @brief 캐시를 비웁니다.
+ */
+void flushResolverCache(void);
+
+/**
+ * @brief "host:port" 또는 "[v6 주소]:port" 형식의 엔드포인트를 나눕니다.
+ *
+ * @param kpchEndpoint 엔드포인트 문자열
+ * @param pchHost 이름을 저장할 버퍼
+ * @param uiHostSize 버퍼 크기
+ * @param piPort 포트
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int parseEndpoint(const char *, char *, size_t, int *);
+
+/**
+ * @brief 해석한 주소와 포트로 소켓 주소를 만듭니다.
+ *
+ * @param kpstAddr 해석한 주소
+ * @param iPort 포트
+ * @param pstStorage 소켓 주소를 저장할 구조체
+ * @return 소켓 주소 길이
+ */
+socklen_t makeResolvedSockAddr(const TcpResolvedAddr *, int, struct sockaddr_storage *);
+
+/**
+ * @brief "host:port" 엔드포인트를 해석하여 연결합니다.
+ *
+ * @details 해석한 주소들로 createClientSocketRace()를 호출하므로 IPv6/IPv4 주소를 번갈아 가며
+ *          설정의 시도 간격마다 연결을 시작하고, 처음 연결된 소켓을 돌려줍니다.
+ *          이름은 resolveHost()로 호출 스레드에서 해석하므로, 캐시에 없으면 최대
+ *          (질의 제한 시간 x 시도 횟수 x 네임서버 수 x 검색 후보 수)만큼 블로킹합니다.
+ *          이벤트 루프에서는 resolveHostAsync()로 해석한 뒤 makeResolvedSockAddr()와
+ *          createClientSocketRace()로 연결합니다.
+ *
+ * @param kpchEndpoint 엔드포인트 문자열
+ * @return 생성된 클라이언트 소켓 파일 디스크립터를 반환. 실패 시 -1을 반환합니다.
+ */
+int createClientSocketTo(const char *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
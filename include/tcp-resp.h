@@ -0,0 +1,248 @@
+#ifndef TCP_RESP_H
+#define TCP_RESP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <sys/uio.h>
+#include "tcp-sock.h"
+#include "tcp-codec.h"
+
+/**
+ * @brief   값 종류 (와이어 형식의 첫 바이트)
+ * @details RESP2: simple string, error, integer, bulk string, array
+ *          RESP3: null, double, boolean, bulk error, verbatim string, big number, map, set, push
+ */
+#define TCP_RESP_SIMPLE         '+'
+#define TCP_RESP_ERROR          '-'
+#define TCP_RESP_INTEGER        ':'
+#define TCP_RESP_BULK           '$'
+#define TCP_RESP_ARRAY          '*'
+#define TCP_RESP_NULL           '_'
+#define TCP_RESP_DOUBLE         ','
+#define TCP_RESP_BOOLEAN        '#'
+#define TCP_RESP_BULK_ERROR     '!'
+#define TCP_RESP_VERBATIM       '='
+#define TCP_RESP_BIG_NUMBER     '('
+#define TCP_RESP_MAP            '%'
+#define TCP_RESP_SET            '~'
+#define TCP_RESP_PUSH           '>'
+#define TCP_RESP_ATTRIBUTE      '|'
+
+/**
+ * @brief   집합 값 최대 중첩 깊이
+ */
+#define TCP_RESP_MAX_DEPTH      16
+
+/**
+ * @brief   parseRespValue() 오류 코드: 값 개수가 배열 크기를 넘음
+ */
+#define TCP_RESP_ERR_TOO_MANY   -2
+
+/**
+ * @brief   클라이언트 파이프라인 최대 깊이 (응답을 기다리는 명령 수)
+ */
+#define TCP_RESP_MAX_PENDING    1024
+
+/**
+ * @brief   클라이언트 송신 버퍼 크기
+ */
+#define TCP_RESP_OUT_SIZE       65536
+
+/**
+ * @brief   송신 버퍼로 복사하는 인자 최대 길이 (더 긴 인자는 복사하지 않고 iovec으로 보냄)
+ */
+#define TCP_RESP_INLINE_MAX     512
+
+/**
+ * @brief 해석한 RESP 값
+ *
+ * @details 집합(array, map, set, push)의 원소는 배열에서 바로 뒤에 전위 순서로 이어지며,
+ *          uiSpan으로 하위 값 전체를 건너뛸 수 있습니다. 문자열은 수신 버퍼를 가리킵니다.
+ */
+typedef struct {
+    unsigned char ucType;       /**< TCP_RESP_* */
+    unsigned char ucNull;       /**< RESP2 null bulk/array 또는 RESP3 null이면 1 */
+    unsigned int uiSpan;        /**< 이 값과 모든 하위 값의 개수 */
+    size_t uiElements;          /**< 집합의 직계 원소 수 (map은 키와 값을 합한 수) */
+    const char *kpchData;       /**< 문자열 값 (verbatim은 형식 접두어 "txt:"를 뺀 내용) */
+    size_t uiLength;            /**< 문자열 길이 */
+    long long llInteger;        /**< integer 값, boolean이면 0 또는 1 */
+    double dDouble;             /**< double 값 */
+} TcpRespValue;
+
+/**
+ * @brief 명령 응답을 받는 함수 (명령을 보낸 순서대로 호출됨)
+ *
+ * @param pvArg 명령을 넣을 때 전달한 인자
+ * @param kpstReply 응답 값 (kpstReply[0]이 최상위 값, 다음 응답 처리 전까지 유효)
+ * @param iValues 값 개수
+ */
+typedef void (*TcpRespCallback)(void *, const TcpRespValue *, int);
+
+typedef struct {
+    TcpRespCallback pfnCallback;
+    void *pvArg;
+} TcpRespPending;
+
+/**
+ * @brief RESP 코덱 상태 (getRespCodec()을 쌓을 때 반드시 넘김)
+ */
+typedef struct {
+    TcpRespValue *pstValues;    /**< 마지막으로 받은 값을 해석해 둘 배열 */
+    int iMaxValues;             /**< 값 배열 크기 */
+    int iValues;                /**< 해석한 값 개수 */
+} TcpRespCodecState;
+
+/**
+ * @brief 파이프라인 RESP 클라이언트
+ *
+ * @details 명령은 송신 버퍼에 쌓아 두었다가 flushRespClient()에서 writev() 한 번으로 보내며,
+ *          응답은 수신 버퍼에서 해석하여 보낸 순서대로 각 명령의 콜백으로 넘깁니다.
+ *          명령 번호(queueRespCommand()의 반환값)로 특정 응답을 기다릴 수 있습니다.
+ *          구조체가 크므로 정적 변수나 힙에 둡니다.
+ */
+typedef struct {
+    int iSock;                                          /**< 소켓 파일 디스크립터 */
+    char *pchBuffer;                                    /**< 수신 버퍼 */
+    size_t uiCapacity;                                  /**< 수신 버퍼 크기 (응답 최대 크기) */
+    size_t uiStart;                                     /**< 해석하지 않은 응답의 시작 위치 */
+    size_t uiEnd;                                       /**< 수신한 데이터의 끝 위치 */
+    TcpRespValue *pstValues;                            /**< 응답 해석용 값 배열 */
+    int iMaxValues;                                     /**< 값 배열 크기 */
+    int iIov;                                           /**< 보낼 iovec 개수 */
+    size_t uiOutUsed;                                   /**< 송신 버퍼 사용량 */
+    struct iovec astIov[TCP_IOV_MAX];                   /**< 보낼 데이터 (송신 버퍼 구간과 긴 인자) */
+    char achOut[TCP_RESP_OUT_SIZE];                     /**< 송신 버퍼 */
+    TcpRespPending astPending[TCP_RESP_MAX_PENDING];    /**< 응답을 기다리는 명령 (원형 큐) */
+    unsigned long long ullQueued;                       /**< 넣은 명령 수 (다음 명령 번호) */
+    unsigned long long ullResolved;                     /**< 응답을 받은 명령 수 */
+    TcpRespCallback pfnPush;                            /**< RESP3 push 메시지 처리 함수 (NULL이면 버림) */
+    void *pvPushArg;                                    /**< push 처리 함수 인자 */
+} TcpRespClient;
+
+/**
+ * @brief 버퍼에서 RESP 값 하나를 해석합니다.
+ *
+ * @details 요청(bulk string 배열)과 응답 모두에 사용하며, RESP3 attribute는 해석한 뒤 버리고
+ *          뒤따르는 값을 돌려줍니다. 스트리밍 문자열/집합과 인라인 명령은 지원하지 않습니다.
+ *
+ * @param kpvData 수신 데이터
+ * @param uiLength 수신 데이터 길이
+ * @param pstValues 해석 결과를 저장할 값 배열
+ * @param iMaxValues 값 배열 크기
+ * @param piValues 저장한 값 개수
+ * @return 값 하나의 길이, 데이터가 부족하면 0, 잘못된 형식이면 -1,
+ *         값이 배열보다 많으면 TCP_RESP_ERR_TOO_MANY 반환
+ */
+int parseRespValue(const void *, size_t, TcpRespValue *, int, int *);
+
+/**
+ * @brief 명령을 bulk string 배열로 인코딩합니다.
+ *
+ * @param pchOut 기록할 버퍼
+ * @param uiSize 버퍼 크기
+ * @param iArgc 인자 개수
+ * @param kppchArgv 인자
+ * @param kpuiArgLengths 인자 길이
+ * @return 기록한 길이, 버퍼가 부족하면 -1 반환
+ */
+int encodeRespCommand(char *, size_t, int, const char *const *, const size_t *);
+
+/**
+ * @brief "<종류><정수>\r\n" 형태의 헤더를 기록합니다 (integer, bulk 길이, 집합 원소 수 등).
+ *
+ * @param pchOut 기록할 버퍼 (최소 24바이트)
+ * @param chType TCP_RESP_*
+ * @param llValue 값
+ * @return 기록한 길이
+ */
+int encodeRespHeader(char *, char, long long);
+
+/**
+ * @brief RESP 코덱을 반환합니다.
+ *
+ * @details 코덱 파이프라인의 와이어 쪽에 쌓으면 완전한 RESP 값 하나의 원문을 메시지로 돌려주고
+ *          해석한 값은 상태의 값 배열에 둡니다. 보낼 때는 이미 RESP로 인코딩된 메시지
+ *          (encodeRespCommand() 등)를 그대로 내보냅니다.
+ *
+ * @return RESP 코덱
+ */
+const TcpCodec *getRespCodec(void);
+
+/**
+ * @brief 클라이언트를 초기화합니다.
+ *
+ * @param pstClient 초기화할 클라이언트
+ * @param iSock 서버와 연결된 소켓
+ * @param pvBuffer 수신 버퍼 (응답 하나가 들어갈 크기)
+ * @param uiCapacity 수신 버퍼 크기
+ * @param pstValues 응답 해석용 값 배열 (응답 하나의 값 개수 이상)
+ * @param iMaxValues 값 배열 크기
+ */
+void initRespClient(TcpRespClient *, int, void *, size_t, TcpRespValue *, int);
+
+/**
+ * @brief RESP3 push 메시지(pub/sub 등) 처리 함수를 설정합니다.
+ *
+ * @param pstClient 클라이언트
+ * @param pfnPush 처리 함수 (NULL이면 버림)
+ * @param pvArg 처리 함수 인자
+ */
+void setRespPushHandler(TcpRespClient *, TcpRespCallback, void *);
+
+/**
+ * @brief 명령을 송신 버퍼에 넣습니다.
+ *
+ * @details TCP_RESP_INLINE_MAX 이하의 인자는 송신 버퍼로 복사하고, 더 긴 인자는 가리키기만
+ *          하므로 다음 flushRespClient()까지 유지해야 합니다. 송신 버퍼나 iovec이 차면 먼저
+ *          보내고, 응답을 기다리는 명령이 TCP_RESP_MAX_PENDING개이면 응답 하나를 받을 때까지
+ *          블로킹합니다.
+ *
+ * @param pstClient 클라이언트
+ * @param iArgc 인자 개수
+ * @param kppchArgv 인자
+ * @param kpuiArgLengths 인자 길이
+ * @param pfnCallback 응답 처리 함수 (NULL이면 응답을 버림)
+ * @param pvArg 응답 처리 함수 인자
+ * @return 성공 시 명령 번호, 실패 시 -1 반환
+ */
+long long queueRespCommand(TcpRespClient *, int, const char *const *, const size_t *, TcpRespCallback, void *);
+
+/**
+ * @brief 쌓아 둔 명령을 writev() 한 번(iovec이 많으면 sendMessageV() 한 번)으로 보냅니다.
+ *
+ * @param pstClient 클라이언트
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int flushRespClient(TcpRespClient *);
+
+/**
+ * @brief 쌓아 둔 명령을 보내고, 응답을 iMinReplies개 이상 받을 때까지 콜백을 호출합니다.
+ *
+ * @details 이미 수신한 응답은 모두 처리합니다. iMinReplies가 기다리는 명령 수보다 크면
+ *          기다리는 명령 수까지만 받습니다.
+ *
+ * @param pstClient 클라이언트
+ * @param iMinReplies 최소로 받을 응답 수
+ * @return 처리한 응답 수, 응답을 하나도 처리하지 못하고 연결이 끊기면 TCP_DISCONNECTION,
+ *         실패 시 -1 반환
+ */
+int pumpRespClient(TcpRespClient *, int);
+
+/**
+ * @brief 명령 번호의 응답이 처리될 때까지 기다립니다.
+ *
+ * @param pstClient 클라이언트
+ * @param llCommand queueRespCommand()가 반환한 명령 번호
+ * @return 성공 시 0, 연결 종료나 실패 시 -1 반환
+ */
+int waitRespReply(TcpRespClient *, long long);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
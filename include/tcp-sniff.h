@@ -0,0 +1,152 @@
+#ifndef TCP_SNIFF_H
+#define TCP_SNIFF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief   등록할 수 있는 코덱 최대 개수
+ */
+#define TCP_SNIFF_MAX_CODECS    8
+
+/**
+ * @brief   판별에 쓰는 첫 바이트 최대 길이 (WebSocket 업그레이드 요청 헤더 전체가 들어갈 크기)
+ */
+#define TCP_SNIFF_PEEK_SIZE     2048
+
+/**
+ * @brief   판별 함수 반환값
+ */
+#define TCP_SNIFF_NO_MATCH      0       /**< 이 코덱의 연결이 아님 */
+#define TCP_SNIFF_MATCH         1       /**< 이 코덱의 연결 */
+#define TCP_SNIFF_NEED_MORE     2       /**< 더 받아야 판단할 수 있음 */
+
+/**
+ * @brief   sniffProtocol() 오류 코드 (TCP_TIME_OUT 외)
+ */
+#define TCP_SNIFF_UNKNOWN       -1      /**< 일치하는 코덱 없음 */
+#define TCP_SNIFF_CLOSED        -3      /**< 첫 데이터 전에 연결 종료 */
+#define TCP_SNIFF_ACCEPT_FAILED -4      /**< acceptSniffedConn()의 accept 실패 */
+
+/**
+ * @brief 연결의 첫 바이트로 프로토콜을 판별하는 함수
+ *
+ * @param kpucData 지금까지 도착한 첫 바이트 (소켓에서 소비하지 않은 데이터)
+ * @param uiLength 데이터 길이
+ * @return TCP_SNIFF_MATCH, TCP_SNIFF_NO_MATCH, TCP_SNIFF_NEED_MORE 중 하나
+ */
+typedef int (*TcpSniffMatcher)(const unsigned char *, size_t);
+
+/**
+ * @brief 판별된 연결을 넘겨받는 함수 (소켓 소유권도 넘어감)
+ *
+ * @param iSock 연결 소켓 (첫 바이트는 아직 소켓 수신 큐에 그대로 있음)
+ * @param pvArg 등록 시 전달한 인자
+ */
+typedef void (*TcpSniffHandler)(int, void *);
+
+/**
+ * @brief 길이 접두 프레이밍(tcp-frame) 연결인지 판별합니다.
+ *
+ * @details 첫 5바이트가 올바른 프레임 헤더(길이 상한, 알려진 플래그)이면 일치로 봅니다.
+ */
+int matchFrameProtocol(const unsigned char *, size_t);
+
+/**
+ * @brief HTTP/1.x 요청인지 판별합니다.
+ *
+ * @details 대문자 메서드 토큰 뒤에 공백이 오면 일치로 봅니다.
+ */
+int matchHttpProtocol(const unsigned char *, size_t);
+
+/**
+ * @brief WebSocket 업그레이드 요청인지 판별합니다.
+ *
+ * @details 요청 헤더 전체가 도착할 때까지 기다렸다가 GET 요청의 Upgrade 헤더에 websocket이
+ *          있으면 일치로 봅니다. HTTP 코덱보다 먼저 등록해야 합니다.
+ */
+int matchWsProtocol(const unsigned char *, size_t);
+
+/**
+ * @brief 판별 함수와 처리 함수를 등록합니다.
+ *
+ * @details 등록 순서가 우선순위이며, 앞선 코덱이 TCP_SNIFF_NEED_MORE를 반환하면 뒤의 코덱이
+ *          일치하더라도 데이터를 더 기다립니다. 연결을 받기 시작하기 전에 등록합니다.
+ *
+ * @param kpchName 코덱 이름 (로그용, 문자열은 유지되어야 함)
+ * @param pfnMatch 판별 함수
+ * @param pfnHandler 처리 함수
+ * @param pvArg 처리 함수에 전달할 인자
+ * @return 성공 시 코덱 번호, 실패 시 -1 반환
+ */
+int registerSniffCodec(const char *, TcpSniffMatcher, TcpSniffHandler, void *);
+
+/**
+ * @brief 등록한 코덱을 모두 지웁니다.
+ */
+void clearSniffCodecs(void);
+
+/**
+ * @brief 등록한 코덱의 이름을 반환합니다.
+ *
+ * @param iCodec 코덱 번호
+ * @return 코덱 이름, 없는 번호면 NULL 반환
+ */
+const char *getSniffCodecName(int);
+
+/**
+ * @brief 수신 대기 소켓에 TCP_DEFER_ACCEPT를 설정합니다.
+ *
+ * @details 첫 데이터가 도착한 연결만 accept()가 돌려주므로, 판별 단계가 데이터를 기다리며
+ *          블로킹하는 일이 줄어듭니다. 클라이언트가 먼저 말하는 프로토콜에만 사용합니다.
+ *
+ * @param iServerSock createServerSocket()으로 만든 수신 대기 소켓
+ * @param iSeconds 데이터를 기다릴 최대 시간 (초, 지나면 데이터 없이도 accept됨)
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int enableDeferredAccept(int, int);
+
+/**
+ * @brief 첫 바이트를 MSG_PEEK으로 엿보아 등록한 코덱 중 하나로 판별합니다.
+ *
+ * @details 데이터를 소비하지 않으므로 판별 뒤 코덱은 처음부터 그대로 수신합니다. 데이터가
+ *          더 필요하면 SO_RCVLOWAT을 올려 다음 바이트가 도착할 때까지 poll()로 기다립니다.
+ *          시간이 다 되거나 TCP_SNIFF_PEEK_SIZE만큼 받아도 판단하지 못한 코덱은 일치하지
+ *          않은 것으로 봅니다.
+ *
+ * @param iSock 연결 소켓
+ * @param iTimeoutMs 첫 데이터를 기다릴 최대 시간 (밀리초)
+ * @return 코덱 번호, 일치하는 코덱이 없으면 TCP_SNIFF_UNKNOWN, 시간 초과 시 TCP_TIME_OUT,
+ *         연결 종료 시 TCP_SNIFF_CLOSED 반환
+ */
+int sniffProtocol(int, int);
+
+/**
+ * @brief 판별한 코덱의 처리 함수로 연결을 넘깁니다.
+ *
+ * @details 판별하지 못한 연결은 닫습니다.
+ *
+ * @param iSock 연결 소켓
+ * @param iTimeoutMs 첫 데이터를 기다릴 최대 시간 (밀리초)
+ * @return 처리한 코덱 번호, 판별하지 못하면 sniffProtocol()의 오류 코드 반환
+ */
+int dispatchSniffedConn(int, int);
+
+/**
+ * @brief 연결 하나를 받아 판별한 코덱으로 넘깁니다.
+ *
+ * @param iServerSock 수신 대기 소켓
+ * @param iTimeoutMs 첫 데이터를 기다릴 최대 시간 (밀리초)
+ * @return 처리한 코덱 번호, accept 실패 시 TCP_SNIFF_ACCEPT_FAILED, 판별하지 못하면
+ *         sniffProtocol()의 오류 코드 반환
+ */
+int acceptSniffedConn(int, int);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
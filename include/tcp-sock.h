@@ -8,6 +8,8 @@ extern "C" {
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netinet/tcp.h> // TCP_KEEPIDLE 등 TCP 옵션 정의
+#include <sys/uio.h>
+#include <time.h>
 
 
 /**
@@ -18,6 +20,48 @@ extern "C" {
 #define TCP_TIME_OUT            -2
 #define TCP_DISCONNECTION       0
 
+/**
+ * @brief   sendMessageV()가 한 번에 처리할 수 있는 최대 iovec 개수
+ */
+#define TCP_IOV_MAX             64
+
+/**
+ * @brief   createClientSocketRace()가 동시에 시도하는 최대 주소 수
+ */
+#define TCP_CONNECT_RACE_MAX    16
+
+/**
+ * @brief   연결 경쟁의 기본 시도 간격 (ms, RFC 8305 권장값)
+ */
+#define TCP_CONNECT_RACE_DELAY  250
+
+/**
+ * @brief   커널 타임스탬프(SO_TIMESTAMPING) 활성화 플래그
+ * @details TCP_TSTAMP_RX: 소프트웨어 RX 타임스탬프, TCP_TSTAMP_TX: 상대방 ACK 시점의 TX 타임스탬프,
+ *          TCP_TSTAMP_HW: NIC 하드웨어 RX 타임스탬프(지원하는 장치에서만 유효)
+ */
+#define TCP_TSTAMP_RX           0x01
+#define TCP_TSTAMP_TX           0x02
+#define TCP_TSTAMP_HW           0x04
+
+/**
+ * @brief 수신 데이터와 함께 전달되는 커널 RX 타임스탬프
+ */
+typedef struct {
+    struct timespec stSoftware;         /**< 커널 소프트웨어 타임스탬프 (CLOCK_REALTIME) */
+    struct timespec stHardware;         /**< NIC 하드웨어 타임스탬프 (없으면 0) */
+    unsigned long long ullWireToAppNsec;/**< 커널 수신 ~ 애플리케이션 수신 완료 지연 (ns) */
+} TcpRxTimestamp;
+
+/**
+ * @brief 에러 큐에서 읽은 커널 TX ACK 타임스탬프
+ */
+typedef struct {
+    unsigned int uiId;                  /**< 전송 ID (타임스탬프 활성화 이후 마지막 바이트의 오프셋) */
+    struct timespec stAck;              /**< 상대방이 ACK 한 시각 (CLOCK_REALTIME) */
+    unsigned long long ullAppToAckNsec; /**< sendMessage() ~ ACK 수신 지연 (ns), 전송 기록이 없으면 0 */
+} TcpTxTimestamp;
+
 /**
  * @brief 포트가 사용 중인지 확인하는 함수
  *
@@ -35,7 +79,8 @@ int isPortAvailable(int iPort);
  * @param iPort 서버가 연결을 수신할 포트 번호
  * @param iMaxClients 허용할 최대 클라이언트 수
  * 
- * @return 서버 소켓에 대한 파일 디스크립터를 반환.
+ * @return 서버 소켓에 대한 파일 디스크립터를 반환. 소켓 생성, 옵션 설정, 바인드, 수신 대기 중 하나라도
+ *         실패하면 프로세스를 종료하지 않고 만든 소켓을 닫은 뒤 -1을 반환합니다.
  */
 int createServerSocket(int, int);
 
@@ -49,6 +94,56 @@ int createServerSocket(int, int);
  */
 int createClientSocket(const char*, int);
 
+/**
+ * @brief 지정한 출발지 주소에 바인드한 클라이언트 소켓을 생성하여 서버에 연결합니다.
+ *
+ * @details 출발지 주소 하나당 임시 포트는 수만 개로 제한되므로, 한 서버로 그보다 많은
+ *          연결을 만들 때 여러 로컬 주소(예: 127.0.0.x)에 나누어 연결합니다.
+ *
+ * @param kpchLocalIp 출발지 IP 주소 (NULL이면 커널이 선택)
+ * @param kpchIp 서버의 IP 주소
+ * @param iPort 서버의 포트 번호
+ *
+ * @return 생성된 클라이언트 소켓 파일 디스크립터를 반환. 실패 시 -1을 반환합니다.
+ */
+int createClientSocketFrom(const char*, const char*, int);
+
+/**
+ * @brief 소켓 주소(IPv4 또는 IPv6)로 클라이언트 소켓을 생성하여 서버에 연결합니다.
+ *
+ * @param kpstAddr 서버 소켓 주소
+ * @param uiAddrLen 소켓 주소 길이
+ *
+ * @return 생성된 클라이언트 소켓 파일 디스크립터를 반환. 실패 시 -1을 반환합니다.
+ */
+int createClientSocketAddr(const struct sockaddr*, socklen_t);
+
+/**
+ * @brief 여러 주소로 연결을 경쟁시켜 가장 먼저 연결된 소켓을 반환합니다 (Happy Eyeballs, RFC 8305).
+ *
+ * @details IPv6/IPv4 주소를 번갈아 가며 간격마다 새 논블로킹 연결을 시작하고, 진행 중인 시도가
+ *          실패하면 간격을 기다리지 않고 다음 주소를 시도합니다. 처음 연결된 소켓을 블로킹 모드로
+ *          되돌려 반환하고 나머지 시도는 취소합니다. 따라서 연결 지연은 목록의 첫 주소가 아니라
+ *          가장 빠른 경로의 지연이 됩니다.
+ *
+ * @param kpstAddrs 서버 소켓 주소 목록 (선호 순서, 최대 TCP_CONNECT_RACE_MAX개 사용)
+ * @param iAddrs 주소 수
+ * @param iDelayMsec 시도 간격 (ms, 0이면 모든 주소를 한꺼번에 시도)
+ * @param iTimeoutMsec 전체 제한 시간 (ms, 0 이하이면 제한 없음)
+ *
+ * @return 생성된 클라이언트 소켓 파일 디스크립터를 반환. 실패 시 -1을 반환합니다.
+ */
+int createClientSocketRace(const struct sockaddr_storage*, int, int, int);
+
+/**
+ * @brief 서버 소켓에서 클라이언트 연결을 수락합니다.
+ *
+ * @param iServerSock createServerSocket()으로 생성한 서버 소켓 파일 디스크립터
+ *
+ * @return 수락한 클라이언트 소켓 파일 디스크립터를 반환. 실패 시 -1을 반환합니다.
+ */
+int acceptClientSocket(int);
+
 /**
  * @brief 클라이언트 연결 해제 처리
  * 
@@ -87,6 +182,18 @@ void setSocketBufferSize(int, int, int);
  */
 int sendMessage(int, const void *, size_t);
 
+/**
+ * @brief 여러 버퍼를 하나의 writev() 호출로 모아 전송(scatter-gather, 전체 전송 완료까지 블로킹).
+ *
+ * @details 부분 전송이 발생하면 남은 부분을 이어서 전송합니다. 호출자의 iovec 배열은 변경하지 않습니다.
+ *
+ * @param iSock 데이터를 전송할 소켓 디스크립터
+ * @param kpstIov 전송할 버퍼 목록
+ * @param iIovCnt 버퍼 개수 (최대 TCP_IOV_MAX)
+ * @return 성공 시 전송한 전체 바이트 수, 실패 시 -1 반환
+ */
+int sendMessageV(int, const struct iovec *, int);
+
 /**
  * @brief TCP 소켓에서 메시지 수신(전체 수신 완료까지 블로킹).
  *
@@ -100,6 +207,8 @@ int recvMsgBlocking(int, void *, size_t);
 /**
  * @brief TCP 소켓에서 메시지 수신(지정한 시간만큼 대기 후 타임아웃 처리).
  *
+ * @details poll()로 대기하므로 1024 이상의 파일 디스크립터에도 사용할 수 있습니다.
+ *
  * @param iSock 데이터를 수신할 소켓 디스크립터
  * @param pvBuffer 수신 데이터를 저장할 버퍼 포인터
  * @param iLength 수신할 바이트 수
@@ -108,6 +217,47 @@ int recvMsgBlocking(int, void *, size_t);
  */
 int recvMsgTimeout(int, void *, size_t, int);
 
+/**
+ * @brief 소켓의 커널 타임스탬프(SO_TIMESTAMPING)를 활성화합니다.
+ *
+ * @details TX 타임스탬프는 SOF_TIMESTAMPING_OPT_ID를 사용하므로 연결이 수립된 소켓에서,
+ *          데이터를 전송하기 전에 활성화해야 합니다. 활성화 이후 sendMessage()의 전송 시각이 기록되어
+ *          readTxTimestamp()에서 ACK까지의 지연이 계산됩니다.
+ *          TX가 켜진 채로 다시 호출하면 커널처럼 전송 ID를 이어 세고, TX를 끄면 전송 기록을 해제합니다.
+ *          연결 테이블에 등록된 소켓(acceptClientSocket(), createClientSocket() 또는
+ *          registerConnInfo())에서만 사용할 수 있습니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @param iFlags TCP_TSTAMP_RX, TCP_TSTAMP_TX, TCP_TSTAMP_HW 조합
+ * @return 성공 시 0, 등록되지 않은 소켓이거나 실패 시 -1 반환
+ */
+int enableSocketTimestamping(int, int);
+
+/**
+ * @brief TCP 소켓에서 메시지와 커널 RX 타임스탬프를 함께 수신합니다.
+ *
+ * @details 소프트웨어 타임스탬프가 있으면 커널 수신 ~ 애플리케이션 수신 완료 지연을
+ *          TCP_METRIC_WIRE_TO_APP 히스토그램에 기록합니다.
+ *
+ * @param iSock 데이터를 수신할 소켓 디스크립터
+ * @param pvBuffer 수신 데이터를 저장할 버퍼 포인터
+ * @param iLength 수신할 바이트 수
+ * @param pstStamp 타임스탬프를 저장할 구조체 포인터
+ * @return 성공 시 수신한 바이트 수, 연결 종료 시 TCP_DISCONNECTION, 실패 시 -1 반환
+ */
+int recvMsgTimestamped(int, void *, size_t, TcpRxTimestamp *);
+
+/**
+ * @brief 소켓 에러 큐에서 TX ACK 타임스탬프를 하나 읽습니다(논블로킹).
+ *
+ * @details 대응하는 전송 기록이 있으면 전송 ~ ACK 지연을 TCP_METRIC_APP_TO_ACK 히스토그램에 기록합니다.
+ *
+ * @param iSock 소켓 파일 디스크립터
+ * @param pstStamp 타임스탬프를 저장할 구조체 포인터
+ * @return 타임스탬프를 읽으면 1, 대기 중인 타임스탬프가 없으면 0, 실패 시 -1 반환
+ */
+int readTxTimestamp(int, TcpTxTimestamp *);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,115 @@
+#ifndef TCP_TIMER_H
+#define TCP_TIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   타이밍 휠 기본 구성을 정의합니다.
+ * @details 슬롯 수는 2의 거듭제곱이어야 하며, 슬롯 수 × 틱 간격을 넘는 타이머는
+ *          같은 슬롯에서 바퀴 수를 기다렸다가 만료됩니다.
+ */
+#define TCP_TIMER_DEFAULT_SLOTS     512
+#define TCP_TIMER_DEFAULT_TICK_NSEC 100000ULL
+
+struct TcpTimer;
+
+/**
+ * @brief 타이머 만료 콜백
+ *
+ * @details 콜백 안에서 같은 타이머나 다른 타이머를 다시 설정하거나 취소할 수 있습니다.
+ */
+typedef void (*TcpTimerCallback)(struct TcpTimer *, void *);
+
+/**
+ * @brief 타이머 (사용자 구조체에 포함시켜 사용하는 침투형 노드)
+ */
+typedef struct TcpTimer {
+    struct TcpTimer *pstNext;
+    struct TcpTimer *pstPrev;
+    unsigned long long ullExpireTick;   /**< 만료 틱 */
+    TcpTimerCallback pfnCallback;       /**< 만료 콜백 */
+    void *pvArg;                        /**< 콜백 인자 */
+    int iArmed;                         /**< 설정 여부 */
+} TcpTimer;
+
+/**
+ * @brief 해시 타이밍 휠
+ *
+ * @details 설정/취소는 O(1)이며, 틱마다 현재 슬롯만 확인합니다. 잠금이 없으므로
+ *          한 스레드에서만 사용하거나 호출자가 잠금으로 보호해야 합니다.
+ */
+typedef struct {
+    TcpTimer *pstSlots;                 /**< 슬롯별 리스트 머리 (센티널) */
+    unsigned int uiSlotMask;            /**< 슬롯 수 - 1 */
+    unsigned int uiArmed;               /**< 설정된 타이머 수 */
+    unsigned long long ullTickNsec;     /**< 틱 간격 */
+    unsigned long long ullStartNsec;    /**< 0번 틱의 시각 */
+    unsigned long long ullCurrentTick;  /**< 마지막으로 처리한 틱 */
+} TcpTimerWheel;
+
+/**
+ * @brief 타이밍 휠을 초기화합니다.
+ *
+ * @param pstWheel 타이밍 휠
+ * @param uiSlots 슬롯 수 (2의 거듭제곱, 0이면 TCP_TIMER_DEFAULT_SLOTS)
+ * @param ullTickNsec 틱 간격 (0이면 TCP_TIMER_DEFAULT_TICK_NSEC)
+ * @param ullNowNsec 현재 시각 (CLOCK_MONOTONIC)
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int initTimerWheel(TcpTimerWheel *, unsigned int, unsigned long long, unsigned long long);
+
+/**
+ * @brief 타이밍 휠의 슬롯 메모리를 해제합니다. 설정된 타이머는 실행되지 않습니다.
+ */
+void destroyTimerWheel(TcpTimerWheel *);
+
+/**
+ * @brief 타이머를 초기화합니다.
+ *
+ * @param pstTimer 타이머
+ * @param pfnCallback 만료 콜백
+ * @param pvArg 콜백 인자
+ */
+void initTimer(TcpTimer *, TcpTimerCallback, void *);
+
+/**
+ * @brief 타이머를 설정합니다. 이미 설정되어 있으면 만료 시각을 바꿉니다.
+ *
+ * @details 만료 시각은 다음 틱 경계로 올림되며, 이미 지난 시각이면 다음 틱에 만료됩니다.
+ *
+ * @param pstWheel 타이밍 휠
+ * @param pstTimer 타이머
+ * @param ullExpireNsec 만료 시각 (CLOCK_MONOTONIC)
+ */
+void armTimer(TcpTimerWheel *, TcpTimer *, unsigned long long);
+
+/**
+ * @brief 타이머를 취소합니다. 설정되지 않은 타이머는 무시합니다.
+ */
+void cancelTimer(TcpTimerWheel *, TcpTimer *);
+
+/**
+ * @brief 현재 시각까지의 틱을 처리하고 만료된 타이머의 콜백을 호출합니다.
+ *
+ * @param pstWheel 타이밍 휠
+ * @param ullNowNsec 현재 시각 (CLOCK_MONOTONIC)
+ * @return 호출한 콜백 수
+ */
+int advanceTimerWheel(TcpTimerWheel *, unsigned long long);
+
+/**
+ * @brief 다음으로 처리할 타이머가 있는 틱의 시각을 반환합니다.
+ *
+ * @details 바퀴 수가 남은 타이머가 있는 슬롯이면 실제 만료보다 이른 시각이 반환될 수 있습니다.
+ *
+ * @return 다음 깨어날 시각, 설정된 타이머가 없으면 0
+ */
+unsigned long long getNextTimerExpiry(const TcpTimerWheel *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef TCP_TRACE_H
+#define TCP_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   추적 컨텍스트 크기 정의 (W3C Trace Context와 동일한 ID 길이)
+ */
+#define TCP_TRACE_ID_SIZE       16
+#define TCP_SPAN_ID_SIZE        8
+
+/**
+ * @brief   추적 플래그: 샘플링된 요청이면 스팬을 기록합니다.
+ */
+#define TCP_TRACE_FLAG_SAMPLED  0x01
+
+/**
+ * @brief   스레드별 스팬 버퍼의 슬롯 수 (가득 차면 오래된 스팬부터 덮어씀)
+ */
+#define TCP_SPAN_BUFFER_SLOTS   4096
+
+/**
+ * @brief 프레임과 함께 전달되는 추적 컨텍스트
+ */
+typedef struct {
+    unsigned char aucTraceId[TCP_TRACE_ID_SIZE];    /**< 요청 전체를 식별하는 ID */
+    unsigned char aucSpanId[TCP_SPAN_ID_SIZE];      /**< 현재 구간(스팬)을 식별하는 ID */
+    unsigned char ucFlags;                          /**< TCP_TRACE_FLAG_* */
+} TcpTraceContext;
+
+/**
+ * @brief 기록되는 스팬의 종류
+ */
+typedef enum {
+    TCP_SPAN_ENQUEUE = 0,   /**< 프레임 헤더 구성 ~ 전송 시스템 콜 직전 */
+    TCP_SPAN_SEND,          /**< 전송 시스템 콜 */
+    TCP_SPAN_RECV,          /**< 프레임 헤더 수신 시작 ~ 페이로드 수신 완료 */
+    TCP_SPAN_HANDLER,       /**< 애플리케이션 핸들러 처리 */
+    TCP_SPAN_KIND_COUNT
+} TcpSpanKind;
+
+/**
+ * @brief 추적 컨텍스트가 샘플링된 요청인지 확인합니다.
+ *
+ * @details 스팬 기록 여부는 이 분기 하나로 결정되므로, 추적을 사용하지 않을 때의 비용은 분기 한 번입니다.
+ */
+#define TCP_TRACE_SAMPLED(pstCtx) \
+    ((pstCtx) != NULL && ((pstCtx)->ucFlags & TCP_TRACE_FLAG_SAMPLED))
+
+/**
+ * @brief 새 추적의 샘플링 비율을 설정합니다.
+ *
+ * @param uiOneInN N개 중 1개 요청을 샘플링 (0이면 추적 비활성화, 1이면 전부 샘플링)
+ */
+void setTraceSampleRate(unsigned int);
+
+/**
+ * @brief 새 추적(루트 스팬)을 시작합니다.
+ *
+ * @details 임의의 추적 ID와 스팬 ID를 생성하고, 샘플링 비율에 따라 SAMPLED 플래그를 설정합니다.
+ *
+ * @param pstCtx 생성된 추적 컨텍스트를 저장할 포인터
+ * @return 샘플링된 경우 1, 아니면 0
+ */
+int startTrace(TcpTraceContext *);
+
+/**
+ * @brief 상위 컨텍스트를 이어받는 하위 스팬 컨텍스트를 생성합니다.
+ *
+ * @details 추적 ID와 플래그는 그대로 유지하고 스팬 ID만 새로 생성합니다.
+ *
+ * @param kpstParent 상위 추적 컨텍스트 (수신한 프레임의 컨텍스트 등)
+ * @param pstChild 생성된 컨텍스트를 저장할 포인터
+ */
+void newChildSpan(const TcpTraceContext *, TcpTraceContext *);
+
+/**
+ * @brief 현재 스레드의 스팬 버퍼에 스팬을 기록합니다.
+ *
+ * @details 샘플링되지 않은 컨텍스트는 무시합니다. 스팬 버퍼는 스레드별로 할당되며 잠금 없이 기록됩니다.
+ *
+ * @param kpstCtx 추적 컨텍스트
+ * @param eKind 스팬 종류
+ * @param iSock 관련 소켓 파일 디스크립터 (없으면 -1)
+ * @param uiBytes 처리한 바이트 수
+ * @param ullStartNsec 시작 시각 (getMonotonicNsec())
+ * @param ullEndNsec 종료 시각 (getMonotonicNsec())
+ */
+void recordSpan(const TcpTraceContext *, TcpSpanKind, int, unsigned int,
+                unsigned long long, unsigned long long);
+
+/**
+ * @brief 모든 스레드의 스팬을 Chrome Trace Event 형식(JSON)으로 파일에 저장합니다.
+ *
+ * @details 저장된 파일은 chrome://tracing 또는 Perfetto UI에서 열 수 있습니다.
+ *          기록 중인 스레드를 멈추지 않으며, 저장 도중 덮어써진 스팬은 제외됩니다.
+ *
+ * @param kpchPath 저장할 파일 경로
+ * @return 성공 시 저장한 스팬 수, 실패 시 -1 반환
+ */
+int exportTraceSpans(const char *);
+
+/**
+ * @brief 모든 스레드의 스팬 버퍼를 비웁니다.
+ */
+void clearTraceSpans(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef TCP_WS_H
+#define TCP_WS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief   WebSocket 프레임 opcode (RFC 6455)
+ */
+#define TCP_WS_OP_CONTINUATION  0x0
+#define TCP_WS_OP_TEXT          0x1
+#define TCP_WS_OP_BINARY        0x2
+#define TCP_WS_OP_CLOSE         0x8
+#define TCP_WS_OP_PING          0x9
+#define TCP_WS_OP_PONG          0xA
+
+/**
+ * @brief   WebSocket 종료 코드
+ */
+#define TCP_WS_CLOSE_NORMAL     1000
+#define TCP_WS_CLOSE_PROTOCOL   1002
+#define TCP_WS_CLOSE_BAD_DATA   1007
+#define TCP_WS_CLOSE_TOO_BIG    1009
+
+/**
+ * @brief   프레임 헤더 최대 길이 (2B + 확장 길이 8B + 마스크 키 4B)
+ */
+#define TCP_WS_MAX_HEADER       14
+
+/**
+ * @brief   제어 프레임(close/ping/pong) 페이로드 최대 길이
+ */
+#define TCP_WS_MAX_CONTROL      125
+
+/**
+ * @brief   핸드셰이크 Sec-WebSocket-Accept 값 길이 (base64(SHA-1), NUL 제외)
+ */
+#define TCP_WS_ACCEPT_KEY_SIZE  28
+
+#define TCP_WS_PATH_SIZE        256
+
+/**
+ * @brief 해석된 WebSocket 프레임 헤더
+ */
+typedef struct {
+    unsigned long long ullPayloadLength;    /**< 페이로드 길이 */
+    unsigned int uiHeaderLength;            /**< 마스크 키를 포함한 헤더 길이 */
+    unsigned char ucOpcode;                 /**< TCP_WS_OP_* */
+    unsigned char ucFin;                    /**< 메시지의 마지막 프레임이면 1 */
+    unsigned char ucMasked;                 /**< 마스크 키가 있으면 1 */
+    unsigned char aucMask[4];               /**< 마스크 키 */
+} TcpWsFrameHeader;
+
+/**
+ * @brief 서버 측 WebSocket 연결 상태
+ *
+ * @details 호출자가 제공한 수신 버퍼 하나로 핸드셰이크 요청과 프레임을 읽습니다.
+ *          페이로드는 버퍼 안에서 바로 마스크를 풀고, 조각난 메시지는 버퍼 앞쪽으로 모아
+ *          이어 붙이므로 메시지 최대 크기는 버퍼 크기입니다.
+ */
+typedef struct {
+    int iSock;                          /**< 소켓 파일 디스크립터 */
+    unsigned char *pucBuffer;           /**< 수신 버퍼 */
+    size_t uiCapacity;                  /**< 수신 버퍼 크기 */
+    size_t uiStart;                     /**< 아직 해석하지 않은 데이터의 시작 위치 */
+    size_t uiEnd;                       /**< 수신한 데이터의 끝 위치 */
+    size_t uiMessageLength;             /**< 버퍼 앞쪽에 모은 조각 메시지 길이 */
+    unsigned char ucMessageOpcode;      /**< 조립 중인 조각 메시지의 opcode (없으면 0) */
+    unsigned char ucDelivered;          /**< 직전 호출이 조립한 메시지를 돌려주었으면 1 */
+    unsigned char ucCloseSent;          /**< close 프레임을 보냈으면 1 */
+    unsigned short usCloseCode;         /**< 상대가 보낸 종료 코드 (없으면 0) */
+    char achPath[TCP_WS_PATH_SIZE];     /**< 핸드셰이크 요청 경로 */
+} TcpWsConn;
+
+/**
+ * @brief 수신한 WebSocket 메시지
+ */
+typedef struct {
+    unsigned char ucOpcode;     /**< TCP_WS_OP_TEXT 또는 TCP_WS_OP_BINARY */
+    void *pvData;               /**< 수신 버퍼 안의 페이로드 (다음 recvWsMessage() 호출 전까지 유효) */
+    size_t uiLength;            /**< 페이로드 길이 */
+} TcpWsMessage;
+
+/**
+ * @brief WebSocket 프레임 헤더를 버퍼에 기록합니다.
+ *
+ * @param pucOut 헤더를 기록할 버퍼 (최소 TCP_WS_MAX_HEADER 바이트)
+ * @param ucOpcode TCP_WS_OP_*
+ * @param iFin 메시지의 마지막 프레임이면 1
+ * @param uiPayloadLength 페이로드 길이
+ * @param kpucMask 마스크 키 4바이트 (NULL이면 마스크 없음, 서버가 보내는 프레임)
+ * @return 기록한 헤더 길이
+ */
+int encodeWsFrameHeader(unsigned char *, unsigned char, int, unsigned long long, const unsigned char *);
+
+/**
+ * @brief 버퍼에서 WebSocket 프레임 헤더를 해석합니다.
+ *
+ * @details 예약 비트가 켜져 있거나, 알 수 없는 opcode이거나, 제어 프레임이 조각나 있거나
+ *          TCP_WS_MAX_CONTROL보다 길면 잘못된 헤더로 봅니다.
+ *
+ * @param kpvData 수신 데이터
+ * @param uiLength 수신 데이터 길이
+ * @param pstHeader 해석 결과를 저장할 구조체 포인터
+ * @return 헤더 길이, 데이터가 부족하면 0, 잘못된 헤더면 -1 반환
+ */
+int parseWsFrameHeader(const void *, size_t, TcpWsFrameHeader *);
+
+/**
+ * @brief 페이로드에 마스크 키를 적용합니다(마스크 적용과 해제는 같은 연산).
+ *
+ * @details 제자리에서 XOR 하며, x86에서는 실행 중인 CPU에 따라 AVX2 또는 SSE2로
+ *          32/16바이트씩 처리합니다. 페이로드를 나누어 처리할 때는 앞서 처리한 바이트 수를
+ *          uiOffset으로 주면 마스크 키의 위상이 이어집니다.
+ *
+ * @param pvData 페이로드
+ * @param uiLength 페이로드 길이
+ * @param kpucMask 마스크 키 4바이트
+ * @param uiOffset 페이로드 시작부터 pvData까지의 바이트 수
+ */
+void maskWsPayload(void *, size_t, const unsigned char *, size_t);
+
+/**
+ * @brief Sec-WebSocket-Key에 대한 Sec-WebSocket-Accept 값을 계산합니다.
+ *
+ * @param kpchKey 클라이언트가 보낸 키 (base64 문자열)
+ * @param uiKeyLength 키 길이
+ * @param pchOut 결과를 저장할 버퍼 (최소 TCP_WS_ACCEPT_KEY_SIZE + 1 바이트, NUL 종료)
+ */
+void computeWsAcceptKey(const char *, size_t, char *);
+
+/**
+ * @brief WebSocket 연결 상태를 초기화합니다.
+ *
+ * @param pstConn 초기화할 연결 상태
+ * @param iSock 연결 소켓
+ * @param pvBuffer 수신 버퍼 (연결을 닫을 때까지 유지)
+ * @param uiCapacity 수신 버퍼 크기 (최대 메시지 크기 + 헤더)
+ */
+void initWsConn(TcpWsConn *, int, void *, size_t);
+
+/**
+ * @brief HTTP 업그레이드 요청을 읽고 101 응답을 보냅니다(요청 전체 수신까지 블로킹).
+ *
+ * @details GET 요청의 Upgrade: websocket, Connection: Upgrade, Sec-WebSocket-Version: 13,
+ *          Sec-WebSocket-Key를 확인합니다. 요청이 잘못되면 400(버전이 다르면 426) 응답을
+ *          보내고 -1을 반환합니다. 요청 뒤에 이어서 도착한 프레임은 버퍼에 남겨 둡니다.
+ *          확장(permessage-deflate 등)과 하위 프로토콜은 협상하지 않습니다.
+ *
+ * @param pstConn initWsConn()으로 초기화한 연결 상태 (요청 경로는 achPath에 저장)
+ * @return 성공 시 1, 요청을 다 받기 전에 연결이 끊기면 TCP_DISCONNECTION, 실패 시 -1 반환
+ */
+int acceptWsHandshake(TcpWsConn *);
+
+/**
+ * @brief 데이터 메시지 하나를 수신합니다(메시지 전체 수신까지 블로킹).
+ *
+ * @details 조각난 메시지는 이어 붙여 하나로 돌려주며, 사이에 끼어든 ping에는 pong으로
+ *          응답하고 pong은 무시합니다. close를 받으면 (아직 보내지 않았다면) 같은 코드로
+ *          close를 응답하고 TCP_DISCONNECTION을 반환합니다. 마스크되지 않은 프레임 등 규약
+ *          위반이면 1002, 메시지가 버퍼보다 크면 1009로 close를 보내고 -1을 반환합니다.
+ *          받은 close의 코드가 보낼 수 없는 값(1005/1006/1015, 1000 미만, 정의되지 않은 범위)이면
+ *          1002로 응답합니다. 텍스트 메시지와 close 사유가 올바른 UTF-8이 아니면 1007로 close를
+ *          보내고 -1을 반환하며, 조각난 텍스트 메시지는 다 이어 붙인 뒤 검사합니다.
+ *
+ * @param pstConn 연결 상태
+ * @param pstMessage 수신한 메시지 (페이로드는 수신 버퍼를 가리킴)
+ * @return 성공 시 opcode(TCP_WS_OP_TEXT/BINARY), 연결 종료 시 TCP_DISCONNECTION, 실패 시 -1 반환
+ */
+int recvWsMessage(TcpWsConn *, TcpWsMessage *);
+
+/**
+ * @brief WebSocket 프레임 하나를 전송합니다(전체 전송 완료까지 블로킹).
+ *
+ * @details 서버가 보내는 프레임이므로 마스크하지 않으며, 헤더와 페이로드를 한 번의
+ *          writev()로 전송합니다.
+ *
+ * @param iSock 데이터를 전송할 소켓 디스크립터
+ * @param ucOpcode TCP_WS_OP_*
+ * @param kpvPayload 페이로드
+ * @param uiLength 페이로드 길이
+ * @return 성공 시 전송한 페이로드 바이트 수, 실패 시 -1 반환
+ */
+int sendWsMessage(int, unsigned char, const void *, size_t);
+
+/**
+ * @brief close 프레임을 전송합니다.
+ *
+ * @details 이미 close를 보냈으면 아무 것도 하지 않습니다. 이후 상대의 close 응답은
+ *          recvWsMessage()가 TCP_DISCONNECTION으로 알려 줍니다.
+ *
+ * @param pstConn 연결 상태
+ * @param usCode 종료 코드 (TCP_WS_CLOSE_*)
+ * @param kpchReason 종료 사유 (NULL 가능, 123바이트까지)
+ * @return 성공 시 0, 실패 시 -1 반환
+ */
+int sendWsClose(TcpWsConn *, unsigned short, const char *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
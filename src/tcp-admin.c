@@ -0,0 +1,385 @@
+/**
+ * @file tcp-admin.c
+ * @brief 연결 테이블을 조회하는 관리(introspection) 서버 구현
+ *
+ * 장애 상황에서 어떤 연결이 멈춰 있는지 확인할 수 있도록 연결 테이블과 스레드별 카운터를
+ * 텍스트로 덤프합니다. 관리 서버 스레드는 연결 통계를 시퀀스 잠금으로 읽고, 큐 깊이와
+ * TCP_INFO는 해당 소켓에 대한 조회 시스템 콜로 얻으므로 송수신 스레드에 개입하지 않습니다.
+ *
+ * 주요 기능:
+ * - UNIX 도메인 소켓/루프백 TCP 관리 서버
+ * - 연결별 상대 주소, 큐 깊이, RTT/혼잡 윈도우, 소유 스레드, 마지막 활동 시각 덤프
+ * - 스레드별 송수신 카운터 덤프
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tcp-admin.h"
+#include "tcp-conn.h"
+#include "tcp-cost.h"
+#include "tcp-metrics.h"
+#include "tcp-metrics-shm.h"
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <linux/sockios.h>
+#include <pthread.h>
+#include <poll.h>
+#include <errno.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ADMIN_TOP_COST_CONNS    10
+#define ADMIN_CONN_BATCH        64
+#define ADMIN_DUMP_CHUNK        4096    /**< 클라이언트로 한 번에 내보내는 덤프 크기 */
+#define ADMIN_SEND_TIMEOUT_MSEC 2000    /**< 접속마다 덤프 전송에 허용하는 시간 */
+
+/**
+ * @brief 덤프를 받는 관리 클라이언트
+ */
+typedef struct {
+    int iSock;
+    unsigned long long ullDeadlineNsec; /**< 이 시각까지 전송하지 못하면 연결을 끊음 */
+    int iFailed;                        /**< 전송을 포기했으면 1 (남은 출력은 버림) */
+} AdminClient;
+
+static int g_iAdminSock = -1;
+static pthread_t g_stAdminThread;
+static char g_achAdminPath[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+
+static void formatPeer(int iSock, char *pchOut, size_t uiSize)
+{
+    struct sockaddr_storage stAddr;
+    socklen_t uiAddrLen = sizeof(stAddr);
+    char achHost[INET6_ADDRSTRLEN];
+
+    if (getpeername(iSock, (struct sockaddr *)&stAddr, &uiAddrLen) < 0) {
+        snprintf(pchOut, uiSize, "-");
+    } else if (stAddr.ss_family == AF_INET) {
+        struct sockaddr_in *pstIn = (struct sockaddr_in *)&stAddr;
+        inet_ntop(AF_INET, &pstIn->sin_addr, achHost, sizeof(achHost));
+        snprintf(pchOut, uiSize, "%s:%d", achHost, ntohs(pstIn->sin_port));
+    } else if (stAddr.ss_family == AF_INET6) {
+        struct sockaddr_in6 *pstIn6 = (struct sockaddr_in6 *)&stAddr;
+        inet_ntop(AF_INET6, &pstIn6->sin6_addr, achHost, sizeof(achHost));
+        snprintf(pchOut, uiSize, "[%s]:%d", achHost, ntohs(pstIn6->sin6_port));
+    } else if (stAddr.ss_family == AF_UNIX) {
+        snprintf(pchOut, uiSize, "unix");
+    } else {
+        snprintf(pchOut, uiSize, "af%d", (int)stAddr.ss_family);
+    }
+}
+
+static void writeThreadStats(FILE *pFile)
+{
+    const TcpMetricsSegment *kpstSegment = __atomic_load_n(&g_pstMetricsSegment, __ATOMIC_ACQUIRE);
+
+    fprintf(pFile, "# threads\n");
+    fprintf(pFile, "%-8s %-16s %14s %14s %12s %12s %10s\n",
+            "tid", "name", "bytes_sent", "bytes_recv", "send_calls", "recv_calls", "timeouts");
+    for (int i = 0; i < TCP_SHM_THREAD_SLOTS; i++) {
+        const TcpShmThreadSlot *kpstSlot = &kpstSegment->astThreads[i];
+        if (!__atomic_load_n(&kpstSlot->uiInUse, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        fprintf(pFile, "%-8d %-16.16s %14llu %14llu %12llu %12llu %10llu\n", kpstSlot->iTid, kpstSlot->achName,
+                __atomic_load_n(&kpstSlot->aullCounters[TCP_COUNTER_BYTES_SENT], __ATOMIC_RELAXED),
+                __atomic_load_n(&kpstSlot->aullCounters[TCP_COUNTER_BYTES_RECEIVED], __ATOMIC_RELAXED),
+                __atomic_load_n(&kpstSlot->aullCounters[TCP_COUNTER_SEND_CALLS], __ATOMIC_RELAXED),
+                __atomic_load_n(&kpstSlot->aullCounters[TCP_COUNTER_RECV_CALLS], __ATOMIC_RELAXED),
+                __atomic_load_n(&kpstSlot->aullCounters[TCP_COUNTER_TIMEOUTS], __ATOMIC_RELAXED));
+    }
+}
+
+static unsigned long long cyclesToUsec(unsigned long long ullCycles)
+{
+    return (unsigned long long)((double)ullCycles * 1e6 / (double)getCycleFrequency());
+}
+
+static void writeTopCost(FILE *pFile)
+{
+    TcpCostEntry astTop[ADMIN_TOP_COST_CONNS];
+    int iCount = getConnCostTopN(astTop, ADMIN_TOP_COST_CONNS);
+
+    fprintf(pFile, "# top cpu %d\n", iCount);
+    fprintf(pFile, "%-6s %12s %12s\n", "fd", "cpu_us", "error_us");
+    for (int i = 0; i < iCount; i++) {
+        fprintf(pFile, "%-6d %12llu %12llu\n", astTop[i].iSock, cyclesToUsec(astTop[i].ullCycles),
+                cyclesToUsec(astTop[i].ullError));
+    }
+}
+
+/**
+ * @brief 덤프 스트림의 버퍼가 찰 때마다 클라이언트로 전송합니다 (fopencookie 쓰기 함수).
+ *
+ * 읽지 않는 클라이언트가 관리 스레드와 stopAdminServer()를 붙잡지 않도록, 접속할 때 정한
+ * 기한이 지나면 전송을 포기하고 -1을 반환합니다.
+ */
+static ssize_t writeAdminClient(void *pvCookie, const char *kpchData, size_t uiLength)
+{
+    AdminClient *pstClient = (AdminClient *)pvCookie;
+    size_t uiRemain = uiLength;
+
+    if (pstClient->iFailed) {
+        return -1;
+    }
+    while (uiRemain > 0) {
+        ssize_t sent = send(pstClient->iSock, kpchData, uiRemain, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent >= 0) {
+            kpchData += sent;
+            uiRemain -= (size_t)sent;
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            pstClient->iFailed = 1;
+            return -1;
+        }
+
+        unsigned long long ullNow = getMonotonicNsec();
+        if (ullNow >= pstClient->ullDeadlineNsec) {
+            fprintf(stderr, "admin client did not read the dump within %d ms\n", ADMIN_SEND_TIMEOUT_MSEC);
+            pstClient->iFailed = 1;
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        struct pollfd stPoll;
+        stPoll.fd = pstClient->iSock;
+        stPoll.events = POLLOUT;
+        stPoll.revents = 0;
+        poll(&stPoll, 1, (int)((pstClient->ullDeadlineNsec - ullNow + 999999ULL) / 1000000ULL));
+    }
+    return (ssize_t)uiLength;
+}
+
+static void *runAdminServer(void *pvArg)
+{
+    int iListenSock = (int)(long)pvArg;
+
+    for (;;) {
+        int iClientSock = accept(iListenSock, NULL, NULL);
+        if (iClientSock < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+
+        // 고정 크기 버퍼가 찰 때마다 바로 전송하므로 덤프 크기와 관계없이 메모리 사용량이 일정함
+        char achChunk[ADMIN_DUMP_CHUNK];
+        AdminClient stClient;
+        cookie_io_functions_t stIo = { NULL, writeAdminClient, NULL, NULL };
+        stClient.iSock = iClientSock;
+        stClient.iFailed = 0;
+        stClient.ullDeadlineNsec = getMonotonicNsec() + (unsigned long long)ADMIN_SEND_TIMEOUT_MSEC * 1000000ULL;
+        FILE *pFile = fopencookie(&stClient, "w", stIo);
+        if (pFile != NULL) {
+            setvbuf(pFile, achChunk, _IOFBF, sizeof(achChunk));
+            writeAdminDump(pFile);
+            fclose(pFile);
+        }
+        close(iClientSock);
+    }
+    return NULL;
+}
+
+/**
+ * @brief 관리 서버의 수신 대기 소켓을 생성합니다.
+ *
+ * createServerSocket()은 모든 주소(INADDR_ANY)에 바인드하고 UNIX 도메인 소켓을 지원하지 않으므로,
+ * 덤프가 외부에 노출되지 않도록 UNIX 도메인 소켓이나 루프백에만 직접 바인드합니다.
+ * 관리 연결은 연결 테이블과 카운터에 남지 않도록 acceptClientSocket() 대신 accept()로 받습니다.
+ */
+static int createAdminSocket(const char *kpchUdsPath, int iPort)
+{
+    int iSock;
+
+    if (kpchUdsPath != NULL) {
+        struct sockaddr_un stAddr;
+        if (strlen(kpchUdsPath) >= sizeof(stAddr.sun_path)) {
+            fprintf(stderr, "admin socket path too long: %s\n", kpchUdsPath);
+            return -1;
+        }
+        if ((iSock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+            perror("Socket failed");
+            return -1;
+        }
+        memset(&stAddr, 0, sizeof(stAddr));
+        stAddr.sun_family = AF_UNIX;
+        strcpy(stAddr.sun_path, kpchUdsPath);
+        unlink(kpchUdsPath);
+        if (bind(iSock, (struct sockaddr *)&stAddr, sizeof(stAddr)) < 0) {
+            perror("Bind failed");
+            close(iSock);
+            return -1;
+        }
+    } else {
+        struct sockaddr_in stAddr;
+        int iSockOpt = 1;
+        if ((iSock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+            perror("Socket failed");
+            return -1;
+        }
+        setsockopt(iSock, SOL_SOCKET, SO_REUSEADDR, &iSockOpt, sizeof(iSockOpt));
+        memset(&stAddr, 0, sizeof(stAddr));
+        stAddr.sin_family = AF_INET;
+        stAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        stAddr.sin_port = htons(iPort);
+        if (bind(iSock, (struct sockaddr *)&stAddr, sizeof(stAddr)) < 0) {
+            perror("Bind failed");
+            close(iSock);
+            return -1;
+        }
+    }
+
+    if (listen(iSock, 8) < 0) {
+        perror("Listen failed");
+        close(iSock);
+        return -1;
+    }
+    return iSock;
+}
+
+
+/**
+ * @brief 연결 한 줄을 출력합니다. 스냅샷 뒤에 연결이 바뀌었으면 출력하지 않고 0을 반환합니다.
+ */
+static int writeConnLine(FILE *pFile, const TcpConnStats *kpstStats, unsigned long long ullNow)
+{
+    char achPeer[INET6_ADDRSTRLEN + 16];
+    int iRxQueue = -1;
+    int iTxQueue = -1;
+    struct tcp_info stInfo;
+    socklen_t uiInfoLen = sizeof(stInfo);
+
+    formatPeer(kpstStats->iSock, achPeer, sizeof(achPeer));
+    ioctl(kpstStats->iSock, SIOCINQ, &iRxQueue);
+    ioctl(kpstStats->iSock, SIOCOUTQ, &iTxQueue);
+    memset(&stInfo, 0, sizeof(stInfo));
+    int iHasInfo = (getsockopt(kpstStats->iSock, IPPROTO_TCP, TCP_INFO, &stInfo, &uiInfoLen) == 0);
+
+    // 스냅샷 뒤에 연결이 닫히고 같은 번호가 재사용됐다면 위 커널 값은 다른 연결의 것이므로 줄을 버림
+    TcpConnStats *pstLive = findConnStats(kpstStats->iSock);
+    if (pstLive == NULL
+        || __atomic_load_n(&pstLive->ullCreatedNsec, __ATOMIC_ACQUIRE) != kpstStats->ullCreatedNsec) {
+        return 0;
+    }
+
+    unsigned long long ullAge = (ullNow > kpstStats->ullCreatedNsec) ? ullNow - kpstStats->ullCreatedNsec : 0;
+    unsigned long long ullIdle = (ullNow > kpstStats->ullLastActiveNsec)
+                               ? ullNow - kpstStats->ullLastActiveNsec : 0;
+    fprintf(pFile, "%-6d %-24s %10llu %10llu %12llu %12llu %8d %8d ", kpstStats->iSock, achPeer,
+            ullAge / 1000000ULL, ullIdle / 1000000ULL, kpstStats->ullBytesIn, kpstStats->ullBytesOut,
+            iRxQueue, iTxQueue);
+    if (iHasInfo) {
+        fprintf(pFile, "%8u %6u", stInfo.tcpi_rtt, stInfo.tcpi_snd_cwnd);
+    } else {
+        fprintf(pFile, "%8s %6s", "-", "-");
+    }
+    unsigned long long ullCostCycles = 0;
+    for (int j = 0; j < TCP_COST_KIND_COUNT; j++) {
+        ullCostCycles += kpstStats->aullCostCycles[j];
+    }
+    fprintf(pFile, " %8d %10llu\n", kpstStats->iOwnerTid, cyclesToUsec(ullCostCycles));
+    return 1;
+}
+
+int writeAdminDump(FILE *pFile)
+{
+    TcpConnStats astBatch[ADMIN_CONN_BATCH];
+    unsigned long long ullNow = getMonotonicNsec();
+    int iCursor = 0;
+    int iCount = 0;
+    int iWritten = 0;
+    int iBatch;
+
+    fprintf(pFile, "# process\n");
+    fprintf(pFile, "pid %d\n", (int)getpid());
+    for (int i = 0; i < TCP_METRIC_GAUGE_COUNT; i++) {
+        fprintf(pFile, "%s %lld\n", getMetricGaugeName((TcpMetricGauge)i), getMetricGauge((TcpMetricGauge)i));
+    }
+    for (int i = 0; i < TCP_METRIC_COUNTER_COUNT; i++) {
+        fprintf(pFile, "%s %llu\n", getMetricCounterName((TcpMetricCounter)i),
+                getMetricCounter((TcpMetricCounter)i));
+    }
+    writeThreadStats(pFile);
+    writeTopCost(pFile);
+
+    // 연결 테이블은 작은 배치로 나누어 읽으며 바로 출력하므로 연결 수와 무관하게 메모리를 쓰지 않음
+    fprintf(pFile, "# connections %lld\n", getMetricGauge(TCP_GAUGE_OPEN_CONNECTIONS));
+    fprintf(pFile, "%-6s %-24s %10s %10s %12s %12s %8s %8s %8s %6s %8s %10s\n", "fd", "peer", "age_ms", "idle_ms",
+            "bytes_in", "bytes_out", "rx_q", "tx_q", "rtt_us", "cwnd", "owner", "cpu_us");
+    while (iCount < TCP_ADMIN_MAX_CONNS && !ferror(pFile)) {
+        int iMax = (TCP_ADMIN_MAX_CONNS - iCount < ADMIN_CONN_BATCH) ? TCP_ADMIN_MAX_CONNS - iCount : ADMIN_CONN_BATCH;
+        if ((iBatch = scanConnTable(&iCursor, astBatch, iMax)) == 0) {
+            break;
+        }
+        for (int i = 0; i < iBatch; i++) {
+            iWritten += writeConnLine(pFile, &astBatch[i], ullNow);
+        }
+        iCount += iBatch;
+    }
+    if (iCount >= TCP_ADMIN_MAX_CONNS && scanConnTable(&iCursor, astBatch, 1) > 0) {
+        fprintf(pFile, "# truncated after %d connections\n", iCount);
+    }
+    return iWritten;
+}
+
+int startAdminServer(const char *kpchUdsPath, int iPort)
+{
+    if (g_iAdminSock >= 0) {
+        fprintf(stderr, "admin server already running\n");
+        return -1;
+    }
+
+    int iSock = createAdminSocket(kpchUdsPath, iPort);
+    if (iSock < 0) {
+        return -1;
+    }
+
+    if (pthread_create(&g_stAdminThread, NULL, runAdminServer, (void *)(long)iSock) != 0) {
+        perror("pthread_create failed");
+        close(iSock);
+        if (kpchUdsPath != NULL) {
+            unlink(kpchUdsPath);
+        }
+        return -1;
+    }
+    pthread_setname_np(g_stAdminThread, "tcp-admin");
+
+    g_achAdminPath[0] = '\0';
+    if (kpchUdsPath != NULL) {
+        strcpy(g_achAdminPath, kpchUdsPath);
+    }
+    g_iAdminSock = iSock;
+    return iSock;
+}
+
+void stopAdminServer(void)
+{
+    if (g_iAdminSock < 0) {
+        return;
+    }
+
+    // 대기 중인 accept()를 깨운 뒤 스레드 종료를 기다림
+    shutdown(g_iAdminSock, SHUT_RDWR);
+    pthread_join(g_stAdminThread, NULL);
+    close(g_iAdminSock);
+    g_iAdminSock = -1;
+
+    if (g_achAdminPath[0] != '\0') {
+        unlink(g_achAdminPath);
+        g_achAdminPath[0] = '\0';
+    }
+}
@@ -0,0 +1,244 @@
+/**
+ * @file tcp-alloc.c
+ * @brief 스레드별 할당 추적과 정상 상태 무할당 감시
+ *
+ * TCP_ALLOC_TRACK을 정의하고 빌드하면 malloc, calloc, realloc, free와 정렬 할당 함수
+ * (posix_memalign, aligned_alloc, memalign, valloc, pvalloc)를 가로채 glibc의 __libc_* 구현으로
+ * 넘기면서 호출한 스레드의 카운터를 올립니다. 감시가 켜진 스레드에서는
+ * 할당마다 호출 위치(반환 주소)를 기록하여, 워밍업 이후 송수신 경로에 할당이 끼어들면
+ * 어느 함수에서 발생했는지 바로 보고합니다.
+ *
+ * 가로채기는 실행 파일에 정적으로 링크하는 시험/벤치마크 빌드 전용입니다. 카운터를
+ * initial-exec TLS로 두어 가로챈 함수 안에서 다시 할당이 일어나지 않도록 하기 위함이며,
+ * 공유 라이브러리 빌드에서는 조회 함수만 남고 아무 것도 세지 않습니다.
+ *
+ * 주요 기능:
+ * - 스레드별 할당/해제 횟수와 바이트 수
+ * - 감시 구간의 위반 호출 위치 기록
+ * - dladdr()를 이용한 호출 위치 심볼 출력
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tcp-alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef TCP_ALLOC_TRACK
+#include <dlfcn.h>
+#include <errno.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void *__libc_memalign(size_t, size_t);
+extern void *__libc_valloc(size_t);
+extern void *__libc_pvalloc(size_t);
+extern void __libc_free(void *);
+#ifdef __cplusplus
+}
+#endif
+
+// C++로 빌드할 때 glibc 선언(noexcept)과 예외 명세를 맞춤
+#ifdef __cplusplus
+#define ALLOC_NOEXCEPT noexcept
+#else
+#define ALLOC_NOEXCEPT
+#endif
+
+// 동적 TLS(__tls_get_addr)는 처음 접근할 때 할당할 수 있으므로 initial-exec 모델을 강제
+#define ALLOC_TLS __thread __attribute__((tls_model("initial-exec")))
+
+static ALLOC_TLS TcpAllocCounts t_stCounts;
+static ALLOC_TLS int t_iGuardArmed;
+static ALLOC_TLS unsigned long long t_ullViolations;
+static ALLOC_TLS int t_iSites;
+static ALLOC_TLS TcpAllocSite t_astSites[TCP_ALLOC_MAX_SITES];
+
+
+static void noteAlloc(size_t uiSize, const void *kpvCaller)
+{
+    t_stCounts.ullAllocs++;
+    t_stCounts.ullBytes += uiSize;
+    if (!t_iGuardArmed) {
+        return;
+    }
+
+    t_ullViolations++;
+    for (int i = 0; i < t_iSites; i++) {
+        if (t_astSites[i].kpvCaller == kpvCaller) {
+            t_astSites[i].ullCount++;
+            t_astSites[i].uiLastSize = uiSize;
+            return;
+        }
+    }
+    if (t_iSites < TCP_ALLOC_MAX_SITES) {
+        t_astSites[t_iSites].kpvCaller = kpvCaller;
+        t_astSites[t_iSites].ullCount = 1;
+        t_astSites[t_iSites].uiLastSize = uiSize;
+        t_iSites++;
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *malloc(size_t uiSize) ALLOC_NOEXCEPT
+{
+    noteAlloc(uiSize, __builtin_return_address(0));
+    return __libc_malloc(uiSize);
+}
+
+void *calloc(size_t uiCount, size_t uiSize) ALLOC_NOEXCEPT
+{
+    noteAlloc(uiCount * uiSize, __builtin_return_address(0));
+    return __libc_calloc(uiCount, uiSize);
+}
+
+void *realloc(void *pvPtr, size_t uiSize) ALLOC_NOEXCEPT
+{
+    noteAlloc(uiSize, __builtin_return_address(0));
+    return __libc_realloc(pvPtr, uiSize);
+}
+
+int posix_memalign(void **ppvPtr, size_t uiAlign, size_t uiSize) ALLOC_NOEXCEPT
+{
+    if (uiAlign % sizeof(void *) != 0 || (uiAlign & (uiAlign - 1)) != 0 || uiAlign == 0) {
+        return EINVAL;
+    }
+    noteAlloc(uiSize, __builtin_return_address(0));
+    void *pvPtr = __libc_memalign(uiAlign, uiSize);
+    if (pvPtr == NULL) {
+        return ENOMEM;
+    }
+    *ppvPtr = pvPtr;
+    return 0;
+}
+
+void *aligned_alloc(size_t uiAlign, size_t uiSize) ALLOC_NOEXCEPT
+{
+    noteAlloc(uiSize, __builtin_return_address(0));
+    return __libc_memalign(uiAlign, uiSize);
+}
+
+void *memalign(size_t uiAlign, size_t uiSize) ALLOC_NOEXCEPT
+{
+    noteAlloc(uiSize, __builtin_return_address(0));
+    return __libc_memalign(uiAlign, uiSize);
+}
+
+void *valloc(size_t uiSize) ALLOC_NOEXCEPT
+{
+    noteAlloc(uiSize, __builtin_return_address(0));
+    return __libc_valloc(uiSize);
+}
+
+void *pvalloc(size_t uiSize) ALLOC_NOEXCEPT
+{
+    noteAlloc(uiSize, __builtin_return_address(0));
+    return __libc_pvalloc(uiSize);
+}
+
+void free(void *pvPtr) ALLOC_NOEXCEPT
+{
+    if (pvPtr != NULL) {
+        t_stCounts.ullFrees++;
+    }
+    __libc_free(pvPtr);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* TCP_ALLOC_TRACK */
+
+
+int isAllocTrackingEnabled(void)
+{
+#ifdef TCP_ALLOC_TRACK
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void getThreadAllocCounts(TcpAllocCounts *pstCounts)
+{
+#ifdef TCP_ALLOC_TRACK
+    *pstCounts = t_stCounts;
+#else
+    memset(pstCounts, 0, sizeof(*pstCounts));
+#endif
+}
+
+void armAllocGuard(void)
+{
+#ifdef TCP_ALLOC_TRACK
+    t_ullViolations = 0;
+    t_iSites = 0;
+    t_iGuardArmed = 1;
+#endif
+}
+
+unsigned long long disarmAllocGuard(void)
+{
+#ifdef TCP_ALLOC_TRACK
+    t_iGuardArmed = 0;
+    return t_ullViolations;
+#else
+    return 0;
+#endif
+}
+
+int getAllocViolationSites(TcpAllocSite *pstSites, int iMax)
+{
+#ifdef TCP_ALLOC_TRACK
+    int iCount = t_iSites < iMax ? t_iSites : iMax;
+    memcpy(pstSites, t_astSites, sizeof(TcpAllocSite) * (size_t)(iCount > 0 ? iCount : 0));
+    return iCount;
+#else
+    (void)pstSites;
+    (void)iMax;
+    return 0;
+#endif
+}
+
+void reportAllocViolations(FILE *pFile, const char *kpchWho)
+{
+#ifdef TCP_ALLOC_TRACK
+    if (t_ullViolations == 0) {
+        return;
+    }
+    fprintf(pFile, "%s: %llu allocation(s) in steady state\n", kpchWho, t_ullViolations);
+    for (int i = 0; i < t_iSites; i++) {
+        const TcpAllocSite *kpstSite = &t_astSites[i];
+        Dl_info stInfo;
+
+        memset(&stInfo, 0, sizeof(stInfo));
+        if (dladdr(kpstSite->kpvCaller, &stInfo) != 0 && stInfo.dli_sname != NULL) {
+            fprintf(pFile, "  %llu x %zu bytes at %s+0x%lx",
+                    kpstSite->ullCount, kpstSite->uiLastSize, stInfo.dli_sname,
+                    (unsigned long)((const char *)kpstSite->kpvCaller - (const char *)stInfo.dli_saddr));
+        } else {
+            fprintf(pFile, "  %llu x %zu bytes at %p", kpstSite->ullCount, kpstSite->uiLastSize,
+                    kpstSite->kpvCaller);
+        }
+        if (stInfo.dli_fname != NULL) {
+            fprintf(pFile, " (%s+0x%lx)", stInfo.dli_fname,
+                    (unsigned long)((const char *)kpstSite->kpvCaller - (const char *)stInfo.dli_fbase));
+        }
+        fprintf(pFile, "\n");
+    }
+    if (t_ullViolations > 0 && t_iSites == TCP_ALLOC_MAX_SITES) {
+        fprintf(pFile, "  (only the first %d call sites are recorded)\n", TCP_ALLOC_MAX_SITES);
+    }
+#else
+    (void)pFile;
+    (void)kpchWho;
+#endif
+}
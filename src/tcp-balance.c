@@ -0,0 +1,642 @@
+/**
+ * @file tcp-balance.c
+ * @brief 백엔드 집합의 클라이언트 측 부하 분산과 연결 풀 구현
+ *
+ * 백엔드 목록에서 임의로 하나를 골라 createClientSocket()을 부르면 느린 백엔드에도 같은 몫의
+ * 요청이 가고, 상태를 가진 백엔드에서는 같은 키가 매번 다른 곳으로 가서 캐시가 식습니다.
+ * 이 모듈은 백엔드별 연결 풀 위에서 키 없는 요청은 임의의 두 백엔드 중 부하가 적은 쪽으로
+ * (power of two choices), 키가 있는 요청은 Maglev 일관 해시 테이블로 보냅니다. 느리거나 실패가 잦은
+ * 백엔드는 일정 시간 선택 대상에서 빼서 다른 요청의 꼬리 지연을 지킵니다.
+ *
+ * 주요 기능:
+ * - 진행 중인 요청 수 또는 EWMA 지연 기반 P2C 선택
+ * - Maglev 테이블 (멤버십이 바뀔 때만 재구성, 키 이동 최소화)
+ * - 백엔드별 유휴 연결 재사용
+ * - 연속 실패, 실패율, p99 지연 기반 이상치 제외와 탐침 후 점진적 재투입
+ */
+#include "tcp-balance.h"
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+
+#include <unistd.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static unsigned long long hashBalanceKey(const void *kpvKey, size_t uiLength, unsigned long long ullSeed)
+{
+    const unsigned char *kpucKey = (const unsigned char *)kpvKey;
+    unsigned long long ullHash = 14695981039346656037ULL ^ ullSeed;
+
+    for (size_t i = 0; i < uiLength; i++) {
+        ullHash = (ullHash ^ kpucKey[i]) * 1099511628211ULL;
+    }
+    // FNV 결과의 하위 비트 편향을 줄이기 위한 마무리 섞기
+    ullHash ^= ullHash >> 33;
+    ullHash *= 0xff51afd7ed558ccdULL;
+    ullHash ^= ullHash >> 33;
+    return ullHash;
+}
+
+static unsigned int nextBalanceRandom(TcpBalancer *pstBalancer)
+{
+    unsigned long long ullState = pstBalancer->ullRandom;
+    ullState ^= ullState << 13;
+    ullState ^= ullState >> 7;
+    ullState ^= ullState << 17;
+    pstBalancer->ullRandom = ullState;
+    return (unsigned int)(ullState >> 32);
+}
+
+static unsigned int getConfigValue(unsigned int uiValue, unsigned int uiDefault)
+{
+    return (uiValue != 0) ? uiValue : uiDefault;
+}
+
+static void closeBalanceSocket(int iSock)
+{
+    removeConnInfo(iSock);
+    close(iSock);
+}
+
+/**
+ * @brief 집합에 속한 백엔드로 Maglev 테이블을 채웁니다 (잠금 보유 상태에서 호출).
+ *
+ * @details 각 백엔드는 자신의 순열(offset + j * skip) 순서로 빈 자리를 하나씩 차지하며,
+ *          모든 자리가 찰 때까지 돌아가며 반복합니다.
+ */
+static void rebuildMaglevTable(TcpBalancer *pstBalancer)
+{
+    unsigned int auiNext[TCP_BALANCE_MAX_BACKENDS];
+    int iFilled = 0;
+
+    memset(pstBalancer->asTable, 0xff, sizeof(pstBalancer->asTable));
+    memset(auiNext, 0, sizeof(auiNext));
+    pstBalancer->ullRebuilds++;
+    if (pstBalancer->iActive == 0) {
+        return;
+    }
+
+    while (iFilled < TCP_BALANCE_TABLE_SIZE) {
+        for (int i = 0; i < pstBalancer->iActive && iFilled < TCP_BALANCE_TABLE_SIZE; i++) {
+            int iBackend = pstBalancer->aiActive[i];
+            const TcpBackend *kpstBackend = &pstBalancer->astBackends[iBackend];
+            unsigned int uiSlot;
+            do {
+                uiSlot = (unsigned int)(((unsigned long long)kpstBackend->uiOffset
+                                         + (unsigned long long)auiNext[i] * kpstBackend->uiSkip)
+                                        % TCP_BALANCE_TABLE_SIZE);
+                auiNext[i]++;
+            } while (pstBalancer->asTable[uiSlot] >= 0);
+            pstBalancer->asTable[uiSlot] = (short)iBackend;
+            iFilled++;
+        }
+    }
+}
+
+/**
+ * @brief 집합에 속한 백엔드 목록을 다시 만들고 테이블을 채웁니다 (잠금 보유 상태에서 호출).
+ */
+static void refreshBalanceMembers(TcpBalancer *pstBalancer)
+{
+    pstBalancer->iMembers = 0;
+    pstBalancer->iActive = 0;
+    for (int i = 0; i < pstBalancer->iBackends; i++) {
+        if (pstBalancer->astBackends[i].iActive) {
+            pstBalancer->iMembers++;
+            if (!pstBalancer->astBackends[i].iEjected) {
+                pstBalancer->aiActive[pstBalancer->iActive++] = i;
+            }
+        }
+    }
+    rebuildMaglevTable(pstBalancer);
+}
+
+/**
+ * @brief 백엔드를 제외 상태로 두고 제외 시간을 정합니다 (잠금 보유 상태에서 호출).
+ *
+ * @details 제외 시간은 uiEjectTimeMsec x 2^(배수 - 1)이며 uiMaxEjectTimeMsec를 넘지 않습니다.
+ */
+static void setBackendEjected(TcpBalancer *pstBalancer, TcpBackend *pstBackend, unsigned long long ullNow)
+{
+    const TcpOutlierConfig *kpstConfig = &pstBalancer->stOutlier;
+    unsigned long long ullEjectMsec = kpstConfig->uiEjectTimeMsec;
+
+    pstBackend->uiEjections++;
+    for (unsigned int i = 1; i < pstBackend->uiEjections && ullEjectMsec < kpstConfig->uiMaxEjectTimeMsec; i++) {
+        ullEjectMsec <<= 1;
+    }
+    if (ullEjectMsec > kpstConfig->uiMaxEjectTimeMsec) {
+        ullEjectMsec = kpstConfig->uiMaxEjectTimeMsec;
+    }
+    pstBackend->ullEjectUntilNsec = ullNow + ullEjectMsec * 1000000ULL;
+    pstBackend->ullRampStartNsec = 0;
+    pstBalancer->ullEjections++;
+    addMetricCounter(TCP_COUNTER_BACKEND_EJECTIONS, 1);
+}
+
+/**
+ * @brief 선택 대상에 있는 백엔드를 제외합니다 (잠금 보유 상태에서 호출).
+ *
+ * @return 제외했으면 0, 이미 제외되었거나 uiMaxEjectPercent를 넘으면 -1 반환
+ */
+static int ejectBackend(TcpBalancer *pstBalancer, TcpBackend *pstBackend, unsigned long long ullNow)
+{
+    int iEjected = pstBalancer->iMembers - pstBalancer->iActive;
+
+    if (pstBackend->iEjected
+        || (iEjected + 1) * 100 > pstBalancer->iMembers * (int)pstBalancer->stOutlier.uiMaxEjectPercent) {
+        return -1;
+    }
+    // 실패가 이어진 백엔드의 유휴 연결은 끊겼을 가능성이 높으므로 닫음
+    while (pstBackend->iIdle > 0) {
+        closeBalanceSocket(pstBackend->aiIdle[--pstBackend->iIdle]);
+    }
+    pstBackend->iEjected = 1;
+    setBackendEjected(pstBalancer, pstBackend, ullNow);
+    refreshBalanceMembers(pstBalancer);
+    return 0;
+}
+
+/**
+ * @brief 요청 실패를 반영하고 연속 실패가 설정 값에 이르면 제외합니다 (잠금 보유 상태에서 호출).
+ */
+static void countBackendFailure(TcpBalancer *pstBalancer, TcpBackend *pstBackend)
+{
+    pstBackend->ullFailures++;
+    pstBackend->ullWindowFailures++;
+    if (++pstBackend->uiConsecutiveFailures >= pstBalancer->stOutlier.uiConsecutiveFailures) {
+        ejectBackend(pstBalancer, pstBackend, getMonotonicNsec());
+    }
+}
+
+static int findBackend(const TcpBalancer *kpstBalancer, const char *kpchEndpoint)
+{
+    for (int i = 0; i < kpstBalancer->iBackends; i++) {
+        if (kpstBalancer->astBackends[i].iActive && strcmp(kpstBalancer->astBackends[i].achEndpoint, kpchEndpoint) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void initBalancer(TcpBalancer *pstBalancer, int iPolicy)
+{
+    memset(pstBalancer, 0, sizeof(*pstBalancer));
+    pthread_mutex_init(&pstBalancer->stLock, NULL);
+    pstBalancer->iPolicy = iPolicy;
+    pstBalancer->ullRandom = getMonotonicNsec() | 1;
+    memset(pstBalancer->asTable, 0xff, sizeof(pstBalancer->asTable));
+    setOutlierConfig(pstBalancer, NULL);
+}
+
+void setOutlierConfig(TcpBalancer *pstBalancer, const TcpOutlierConfig *kpstConfig)
+{
+    TcpOutlierConfig stConfig;
+
+    if (kpstConfig != NULL) {
+        stConfig = *kpstConfig;
+    } else {
+        memset(&stConfig, 0, sizeof(stConfig));
+    }
+    stConfig.uiMinRequests = getConfigValue(stConfig.uiMinRequests, TCP_BALANCE_DEFAULT_MIN_REQUESTS);
+    stConfig.uiConsecutiveFailures = getConfigValue(stConfig.uiConsecutiveFailures, TCP_BALANCE_DEFAULT_CONSECUTIVE);
+    stConfig.uiFailurePercent = getConfigValue(stConfig.uiFailurePercent, TCP_BALANCE_DEFAULT_FAILURE_PERCENT);
+    stConfig.uiLatencyFactorPercent = getConfigValue(stConfig.uiLatencyFactorPercent, TCP_BALANCE_DEFAULT_LATENCY_FACTOR);
+    stConfig.uiLatencyFloorUsec = getConfigValue(stConfig.uiLatencyFloorUsec, TCP_BALANCE_DEFAULT_LATENCY_FLOOR);
+    stConfig.uiEjectTimeMsec = getConfigValue(stConfig.uiEjectTimeMsec, TCP_BALANCE_DEFAULT_EJECT_TIME);
+    stConfig.uiMaxEjectTimeMsec = getConfigValue(stConfig.uiMaxEjectTimeMsec, TCP_BALANCE_DEFAULT_MAX_EJECT_TIME);
+    stConfig.uiMaxEjectPercent = getConfigValue(stConfig.uiMaxEjectPercent, TCP_BALANCE_DEFAULT_MAX_EJECT_PERCENT);
+    stConfig.uiRampTimeMsec = getConfigValue(stConfig.uiRampTimeMsec, TCP_BALANCE_DEFAULT_RAMP_TIME);
+
+    pthread_mutex_lock(&pstBalancer->stLock);
+    pstBalancer->stOutlier = stConfig;
+    pthread_mutex_unlock(&pstBalancer->stLock);
+}
+
+void destroyBalancer(TcpBalancer *pstBalancer)
+{
+    pthread_mutex_lock(&pstBalancer->stLock);
+    for (int i = 0; i < pstBalancer->iBackends; i++) {
+        TcpBackend *pstBackend = &pstBalancer->astBackends[i];
+        while (pstBackend->iIdle > 0) {
+            closeBalanceSocket(pstBackend->aiIdle[--pstBackend->iIdle]);
+        }
+        pstBackend->iActive = 0;
+    }
+    pstBalancer->iActive = 0;
+    pthread_mutex_unlock(&pstBalancer->stLock);
+    pthread_mutex_destroy(&pstBalancer->stLock);
+}
+
+int addBackend(TcpBalancer *pstBalancer, const char *kpchEndpoint)
+{
+    if (strlen(kpchEndpoint) >= TCP_BALANCE_ENDPOINT_MAX) {
+        fprintf(stderr, "addBackend: endpoint too long\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&pstBalancer->stLock);
+    int iBackend = findBackend(pstBalancer, kpchEndpoint);
+    if (iBackend >= 0) {
+        pthread_mutex_unlock(&pstBalancer->stLock);
+        return iBackend;
+    }
+    // 빈 슬롯을 재사용하여 슬롯 번호(테이블 값)를 작게 유지
+    for (iBackend = 0; iBackend < pstBalancer->iBackends && pstBalancer->astBackends[iBackend].iActive; iBackend++) {
+    }
+    if (iBackend == TCP_BALANCE_MAX_BACKENDS) {
+        pthread_mutex_unlock(&pstBalancer->stLock);
+        fprintf(stderr, "addBackend: more than %d backends\n", TCP_BALANCE_MAX_BACKENDS);
+        return -1;
+    }
+    if (iBackend == pstBalancer->iBackends) {
+        pstBalancer->iBackends++;
+    }
+
+    TcpBackend *pstBackend = &pstBalancer->astBackends[iBackend];
+    unsigned int uiGeneration = pstBackend->uiGeneration + 1;
+    size_t uiLength = strlen(kpchEndpoint);
+    memset(pstBackend, 0, sizeof(*pstBackend));
+    pstBackend->iActive = 1;
+    pstBackend->uiGeneration = uiGeneration;
+    memcpy(pstBackend->achEndpoint, kpchEndpoint, uiLength + 1);
+    pstBackend->uiOffset = (unsigned int)(hashBalanceKey(kpchEndpoint, uiLength, 0) % TCP_BALANCE_TABLE_SIZE);
+    pstBackend->uiSkip = (unsigned int)(hashBalanceKey(kpchEndpoint, uiLength, 1) % (TCP_BALANCE_TABLE_SIZE - 1)) + 1;
+    refreshBalanceMembers(pstBalancer);
+    pthread_mutex_unlock(&pstBalancer->stLock);
+    return iBackend;
+}
+
+int removeBackend(TcpBalancer *pstBalancer, const char *kpchEndpoint)
+{
+    pthread_mutex_lock(&pstBalancer->stLock);
+    int iBackend = findBackend(pstBalancer, kpchEndpoint);
+    if (iBackend < 0) {
+        pthread_mutex_unlock(&pstBalancer->stLock);
+        return -1;
+    }
+    TcpBackend *pstBackend = &pstBalancer->astBackends[iBackend];
+    while (pstBackend->iIdle > 0) {
+        closeBalanceSocket(pstBackend->aiIdle[--pstBackend->iIdle]);
+    }
+    pstBackend->iActive = 0;
+    pstBackend->iEjected = 0;
+    pstBackend->uiGeneration++;
+    refreshBalanceMembers(pstBalancer);
+    pthread_mutex_unlock(&pstBalancer->stLock);
+    return 0;
+}
+
+/**
+ * @brief 정책에 따른 백엔드 부하 (작을수록 선호)
+ */
+static unsigned long long getBackendLoad(const TcpBalancer *kpstBalancer, const TcpBackend *kpstBackend)
+{
+    if (kpstBalancer->iPolicy == TCP_BALANCE_P2C_EWMA) {
+        // 표본이 없는 백엔드는 0이므로 먼저 시도되어 지연이 측정됨
+        return kpstBackend->ullEwmaNsec * (kpstBackend->uiInFlight + 1ULL);
+    }
+    return kpstBackend->uiInFlight;
+}
+
+/**
+ * @brief 다시 넣은 백엔드의 선택 가중치 (천분율, 최소 10%, P2C와 키 있는 요청에 함께 적용)
+ */
+static unsigned int getRampPermille(const TcpBalancer *kpstBalancer, TcpBackend *pstBackend)
+{
+    if (pstBackend->ullRampStartNsec == 0) {
+        return 1000;
+    }
+    unsigned long long ullElapsed = getMonotonicNsec() - pstBackend->ullRampStartNsec;
+    unsigned long long ullRamp = kpstBalancer->stOutlier.uiRampTimeMsec * 1000000ULL;
+    if (ullElapsed >= ullRamp) {
+        pstBackend->ullRampStartNsec = 0;
+        return 1000;
+    }
+    unsigned int uiPermille = (unsigned int)(ullElapsed * 1000 / ullRamp);
+    return (uiPermille < 100) ? 100 : uiPermille;
+}
+
+/**
+ * @brief 임의의 두 백엔드 중 부하가 적은 쪽을 고릅니다 (잠금 보유 상태에서 호출).
+ *
+ * @details 이긴 쪽이 다시 넣은 지 얼마 안 된 백엔드이면 램프 가중치만큼의 확률로만 선택하고
+ *          나머지는 다른 쪽에 보냅니다. iExclude 백엔드는 후보에서 빼며, 그 밖에 후보가 없으면
+ *          iExclude를 돌려줍니다.
+ */
+static int pickTwoChoices(TcpBalancer *pstBalancer, int iExclude)
+{
+    int iSkip = -1;
+    for (int i = 0; i < pstBalancer->iActive && iExclude >= 0; i++) {
+        if (pstBalancer->aiActive[i] == iExclude) {
+            iSkip = i;
+        }
+    }
+    unsigned int uiCandidates = (unsigned int)pstBalancer->iActive - ((iSkip >= 0) ? 1 : 0);
+    if (uiCandidates == 0) {
+        return iExclude;
+    }
+    unsigned int uiFirst = nextBalanceRandom(pstBalancer) % uiCandidates;
+    unsigned int uiSecond = uiFirst;
+    if (uiCandidates > 1) {
+        uiSecond = nextBalanceRandom(pstBalancer) % (uiCandidates - 1);
+        if (uiSecond >= uiFirst) {
+            uiSecond++;
+        }
+    }
+    if (iSkip >= 0) {
+        uiFirst += (uiFirst >= (unsigned int)iSkip) ? 1 : 0;
+        uiSecond += (uiSecond >= (unsigned int)iSkip) ? 1 : 0;
+    }
+    int iFirst = pstBalancer->aiActive[uiFirst];
+    int iSecond = pstBalancer->aiActive[uiSecond];
+    if (iFirst == iSecond) {
+        return iFirst;
+    }
+    if (getBackendLoad(pstBalancer, &pstBalancer->astBackends[iSecond])
+        < getBackendLoad(pstBalancer, &pstBalancer->astBackends[iFirst])) {
+        int iSwap = iFirst;
+        iFirst = iSecond;
+        iSecond = iSwap;
+    }
+    unsigned int uiPermille = getRampPermille(pstBalancer, &pstBalancer->astBackends[iFirst]);
+    if (uiPermille < 1000 && nextBalanceRandom(pstBalancer) % 1000 >= uiPermille) {
+        return iSecond;
+    }
+    return iFirst;
+}
+
+/**
+ * @brief 키의 Maglev 자리에서 백엔드를 찾습니다 (잠금 보유 상태에서 호출).
+ *
+ * @details 자리의 백엔드가 다시 넣은 지 얼마 안 되었으면 키 해시의 상위 비트로 램프 가중치만큼의
+ *          키만 그 백엔드에 보내고, 나머지 키는 테이블의 다음 자리 중 램프가 끝난 백엔드로 보냅니다.
+ *          가중치가 오를수록 받아들이는 키가 늘어나기만 하므로, 한 번 돌아온 키는 다시 옮겨 가지 않습니다.
+ */
+static int lookupKeyedBackend(TcpBalancer *pstBalancer, unsigned long long ullHash)
+{
+    unsigned int uiSlot = (unsigned int)(ullHash % TCP_BALANCE_TABLE_SIZE);
+    int iBackend = pstBalancer->asTable[uiSlot];
+
+    if (iBackend < 0) {
+        return iBackend;
+    }
+    unsigned int uiPermille = getRampPermille(pstBalancer, &pstBalancer->astBackends[iBackend]);
+    if (uiPermille >= 1000 || (unsigned int)((ullHash >> 32) % 1000) < uiPermille) {
+        return iBackend;
+    }
+    for (unsigned int i = 1; i < TCP_BALANCE_TABLE_SIZE; i++) {
+        int iNext = pstBalancer->asTable[(uiSlot + i) % TCP_BALANCE_TABLE_SIZE];
+        if (iNext != iBackend && getRampPermille(pstBalancer, &pstBalancer->astBackends[iNext]) >= 1000) {
+            return iNext;
+        }
+    }
+    return iBackend;
+}
+
+int lookupBackend(TcpBalancer *pstBalancer, const void *kpvKey, size_t uiKeyLength)
+{
+    unsigned long long ullHash = hashBalanceKey(kpvKey, uiKeyLength, 0);
+
+    pthread_mutex_lock(&pstBalancer->stLock);
+    int iBackend = lookupKeyedBackend(pstBalancer, ullHash);
+    pthread_mutex_unlock(&pstBalancer->stLock);
+    return iBackend;
+}
+
+/**
+ * @brief 고른 백엔드의 연결을 빌립니다 (잠금 보유 상태에서 호출, 잠금을 풀고 돌아옴).
+ */
+static int borrowBackendConn(TcpBalancer *pstBalancer, int iBackend, TcpBalanceConn *pstConn)
+{
+    char achEndpoint[TCP_BALANCE_ENDPOINT_MAX];
+    TcpBackend *pstBackend = &pstBalancer->astBackends[iBackend];
+
+    pstBackend->uiInFlight++;
+    pstConn->iBackend = iBackend;
+    pstConn->uiGeneration = pstBackend->uiGeneration;
+    pstConn->iSock = (pstBackend->iIdle > 0) ? pstBackend->aiIdle[--pstBackend->iIdle] : -1;
+    strcpy(achEndpoint, pstBackend->achEndpoint);
+    pthread_mutex_unlock(&pstBalancer->stLock);
+
+    // 연결은 잠금 밖에서 만들어 다른 요청을 막지 않음
+    if (pstConn->iSock < 0) {
+        pstConn->iSock = createClientSocketTo(achEndpoint);
+        if (pstConn->iSock < 0) {
+            pthread_mutex_lock(&pstBalancer->stLock);
+            if (pstBackend->uiGeneration == pstConn->uiGeneration) {
+                pstBackend->uiInFlight--;
+                countBackendFailure(pstBalancer, pstBackend);
+            }
+            pthread_mutex_unlock(&pstBalancer->stLock);
+            return -1;
+        }
+    }
+    pstConn->ullStartNsec = getMonotonicNsec();
+    return 0;
+}
+
+int acquireBackendConn(TcpBalancer *pstBalancer, const void *kpvKey, size_t uiKeyLength, TcpBalanceConn *pstConn)
+{
+    unsigned long long ullHash = (kpvKey != NULL) ? hashBalanceKey(kpvKey, uiKeyLength, 0) : 0;
+
+    pthread_mutex_lock(&pstBalancer->stLock);
+    if (pstBalancer->iActive == 0) {
+        pthread_mutex_unlock(&pstBalancer->stLock);
+        fprintf(stderr, "acquireBackendConn: no backend\n");
+        return -1;
+    }
+    int iBackend = (kpvKey != NULL) ? lookupKeyedBackend(pstBalancer, ullHash) : pickTwoChoices(pstBalancer, -1);
+    return borrowBackendConn(pstBalancer, iBackend, pstConn);
+}
+
+int acquireOtherBackendConn(TcpBalancer *pstBalancer, int iExclude, TcpBalanceConn *pstConn)
+{
+    pthread_mutex_lock(&pstBalancer->stLock);
+    if (pstBalancer->iActive == 0) {
+        pthread_mutex_unlock(&pstBalancer->stLock);
+        fprintf(stderr, "acquireOtherBackendConn: no backend\n");
+        return -1;
+    }
+    int iBackend = pickTwoChoices(pstBalancer, iExclude);
+    if (iBackend < 0 || !pstBalancer->astBackends[iBackend].iActive || pstBalancer->astBackends[iBackend].iEjected) {
+        iBackend = pickTwoChoices(pstBalancer, -1);
+    }
+    return borrowBackendConn(pstBalancer, iBackend, pstConn);
+}
+
+void releaseBackendConn(TcpBalancer *pstBalancer, TcpBalanceConn *pstConn, int iFailed)
+{
+    unsigned long long ullElapsed = getMonotonicNsec() - pstConn->ullStartNsec;
+    int iClose = iFailed;
+
+    pthread_mutex_lock(&pstBalancer->stLock);
+    TcpBackend *pstBackend = &pstBalancer->astBackends[pstConn->iBackend];
+    if (pstBackend->uiGeneration != pstConn->uiGeneration) {
+        iClose = 1;
+    } else {
+        pstBackend->uiInFlight--;
+        pstBackend->ullRequests++;
+        pstBackend->ullWindowRequests++;
+        if (iFailed) {
+            countBackendFailure(pstBalancer, pstBackend);
+        } else {
+            pstBackend->uiConsecutiveFailures = 0;
+            recordHistogram(&pstBackend->stWindow, ullElapsed);
+            if (pstBackend->ullEwmaNsec == 0) {
+                pstBackend->ullEwmaNsec = ullElapsed;
+            } else {
+                long long llDelta = (long long)ullElapsed - (long long)pstBackend->ullEwmaNsec;
+                pstBackend->ullEwmaNsec = (unsigned long long)((long long)pstBackend->ullEwmaNsec
+                                                               + llDelta / (1 << TCP_BALANCE_EWMA_SHIFT));
+            }
+        }
+        if (!iClose && !pstBackend->iEjected && pstBackend->iIdle < TCP_BALANCE_POOL_SIZE) {
+            pstBackend->aiIdle[pstBackend->iIdle++] = pstConn->iSock;
+        } else {
+            iClose = 1;
+        }
+    }
+    pthread_mutex_unlock(&pstBalancer->stLock);
+
+    if (iClose) {
+        closeBalanceSocket(pstConn->iSock);
+    }
+    pstConn->iSock = -1;
+}
+
+void cancelBackendConn(TcpBalancer *pstBalancer, TcpBalanceConn *pstConn)
+{
+    pthread_mutex_lock(&pstBalancer->stLock);
+    TcpBackend *pstBackend = &pstBalancer->astBackends[pstConn->iBackend];
+    if (pstBackend->uiGeneration == pstConn->uiGeneration) {
+        pstBackend->uiInFlight--;
+    }
+    pthread_mutex_unlock(&pstBalancer->stLock);
+
+    closeBalanceSocket(pstConn->iSock);
+    pstConn->iSock = -1;
+}
+
+unsigned long long getBackendLatency(TcpBalancer *pstBalancer, int iBackend, double dPercentile)
+{
+    unsigned long long ullLatency = 0;
+
+    pthread_mutex_lock(&pstBalancer->stLock);
+    const TcpBackend *kpstBackend = &pstBalancer->astBackends[iBackend];
+    if (kpstBackend->stWindow.ullCount >= pstBalancer->stOutlier.uiMinRequests) {
+        ullLatency = getHistogramPercentile(&kpstBackend->stWindow, dPercentile);
+    } else {
+        ullLatency = getHistogramPercentile(&kpstBackend->stLastWindow, dPercentile);
+    }
+    pthread_mutex_unlock(&pstBalancer->stLock);
+    return ullLatency;
+}
+
+/**
+ * @brief 평가 구간 통계로 이상치를 제외하고 구간을 비웁니다 (잠금 보유 상태에서 호출).
+ */
+static void evaluateBackendWindows(TcpBalancer *pstBalancer, unsigned long long ullNow)
+{
+    const TcpOutlierConfig *kpstConfig = &pstBalancer->stOutlier;
+    unsigned long long aullSorted[TCP_BALANCE_MAX_BACKENDS];
+    int iSamples = 0;
+
+    for (int i = 0; i < pstBalancer->iBackends; i++) {
+        TcpBackend *pstBackend = &pstBalancer->astBackends[i];
+        pstBackend->ullLastP99Nsec = 0;
+        if (!pstBackend->iActive || pstBackend->iEjected || pstBackend->ullWindowRequests < kpstConfig->uiMinRequests) {
+            continue;
+        }
+        pstBackend->ullLastP99Nsec = getHistogramPercentile(&pstBackend->stWindow, 99.0);
+        int j = iSamples++;
+        for (; j > 0 && aullSorted[j - 1] > pstBackend->ullLastP99Nsec; j--) {
+            aullSorted[j] = aullSorted[j - 1];
+        }
+        aullSorted[j] = pstBackend->ullLastP99Nsec;
+    }
+
+    // 짝수 개이면 아래쪽 중앙값을 써서 백엔드가 둘일 때 빠른 쪽이 기준이 되도록 함
+    unsigned long long ullMedian = (iSamples > 0) ? aullSorted[(iSamples - 1) / 2] : 0;
+    for (int i = 0; i < pstBalancer->iBackends; i++) {
+        TcpBackend *pstBackend = &pstBalancer->astBackends[i];
+        if (!pstBackend->iActive || pstBackend->iEjected) {
+            continue;
+        }
+        int iOutlier = 0;
+        if (pstBackend->ullWindowRequests >= kpstConfig->uiMinRequests) {
+            iOutlier = (pstBackend->ullWindowFailures * 100 >= pstBackend->ullWindowRequests * kpstConfig->uiFailurePercent)
+                       || (iSamples >= 2
+                           && pstBackend->ullLastP99Nsec >= kpstConfig->uiLatencyFloorUsec * 1000ULL
+                           && pstBackend->ullLastP99Nsec * 100 > ullMedian * kpstConfig->uiLatencyFactorPercent);
+        }
+        if (iOutlier) {
+            ejectBackend(pstBalancer, pstBackend, ullNow);
+        } else if (pstBackend->uiEjections > 0) {
+            pstBackend->uiEjections--;
+        }
+    }
+
+    for (int i = 0; i < pstBalancer->iBackends; i++) {
+        TcpBackend *pstBackend = &pstBalancer->astBackends[i];
+        if (pstBackend->stWindow.ullCount > 0) {
+            pstBackend->stLastWindow = pstBackend->stWindow;
+        }
+        resetHistogram(&pstBackend->stWindow);
+        pstBackend->ullWindowRequests = 0;
+        pstBackend->ullWindowFailures = 0;
+    }
+}
+
+int checkBackendHealth(TcpBalancer *pstBalancer)
+{
+    char achEndpoint[TCP_BALANCE_ENDPOINT_MAX];
+    int iEjected;
+
+    pthread_mutex_lock(&pstBalancer->stLock);
+    unsigned long long ullNow = getMonotonicNsec();
+    evaluateBackendWindows(pstBalancer, ullNow);
+
+    // 제외 시간이 끝난 백엔드를 하나씩 잠금 밖에서 탐침
+    for (int i = 0; i < pstBalancer->iBackends; i++) {
+        TcpBackend *pstBackend = &pstBalancer->astBackends[i];
+        if (!pstBackend->iActive || !pstBackend->iEjected || pstBackend->ullEjectUntilNsec > ullNow) {
+            continue;
+        }
+        unsigned int uiGeneration = pstBackend->uiGeneration;
+        TcpBackendProbe pfnProbe = pstBalancer->stOutlier.pfnProbe;
+        void *pvProbeArg = pstBalancer->stOutlier.pvProbeArg;
+        strcpy(achEndpoint, pstBackend->achEndpoint);
+        pthread_mutex_unlock(&pstBalancer->stLock);
+
+        int iSock = createClientSocketTo(achEndpoint);
+        int iHealthy = (iSock >= 0 && (pfnProbe == NULL || pfnProbe(iSock, pvProbeArg) == 0));
+
+        pthread_mutex_lock(&pstBalancer->stLock);
+        ullNow = getMonotonicNsec();
+        if (pstBackend->iActive && pstBackend->iEjected && pstBackend->uiGeneration == uiGeneration) {
+            if (iHealthy) {
+                pstBackend->iEjected = 0;
+                pstBackend->uiConsecutiveFailures = 0;
+                pstBackend->ullRampStartNsec = ullNow;
+                refreshBalanceMembers(pstBalancer);
+                if (pstBackend->iIdle < TCP_BALANCE_POOL_SIZE) {
+                    pstBackend->aiIdle[pstBackend->iIdle++] = iSock;
+                    iSock = -1;
+                }
+            } else {
+                setBackendEjected(pstBalancer, pstBackend, ullNow);
+            }
+        }
+        if (iSock >= 0) {
+            closeBalanceSocket(iSock);
+        }
+    }
+    iEjected = pstBalancer->iMembers - pstBalancer->iActive;
+    pthread_mutex_unlock(&pstBalancer->stLock);
+    return iEjected;
+}
@@ -0,0 +1,291 @@
+/**
+ * @file tcp-capture.c
+ * @brief 송수신 데이터 캡처 구현
+ *
+ * 송수신 경로에서 연결별 바이트 스트림을 시각과 함께 메모리 매핑된 로그 파일에 기록합니다.
+ * 레코드 영역은 원자적 덧셈으로 예약하므로 기록 스레드 사이에 잠금이 없고,
+ * 캡처가 꺼져 있을 때 송수신 경로의 비용은 포인터 확인 한 번입니다.
+ *
+ * 주요 기능:
+ * - 캡처 파일 생성 및 레코드 기록
+ * - 캡처 종료 시 사용한 크기로 파일 축소
+ * - 재생 도구를 위한 읽기 전용 열기 및 레코드 순회
+ */
+#include "tcp-capture.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define CAPTURE_RECORD_SIZE(uiLength) \
+    ((sizeof(TcpCaptureRecord) + (uiLength) + TCP_CAPTURE_ALIGN - 1) & ~(size_t)(TCP_CAPTURE_ALIGN - 1))
+
+static TcpCaptureHeader *g_pstCapture;
+static size_t g_uiCaptureMapSize;
+static int g_iCaptureFd = -1;
+static int g_iCaptureWriters;
+
+
+/**
+ * @brief 레코드 영역을 예약합니다. 공간이 부족하면 NULL을 반환합니다.
+ */
+static TcpCaptureRecord *reserveRecord(TcpCaptureHeader *pstHeader, int iSock, unsigned long long ullConnId,
+                                       TcpCaptureDirection eDirection, size_t uiLength)
+{
+    unsigned long long ullSize = CAPTURE_RECORD_SIZE(uiLength);
+    unsigned long long ullOffset = __atomic_fetch_add(&pstHeader->ullUsed, ullSize, __ATOMIC_RELAXED);
+    if (ullOffset + ullSize > pstHeader->ullCapacity) {
+        // 넘친 예약은 되돌리지 않음 (이후 레코드도 모두 버려지므로 ullUsed는 종료 시 보정)
+        __atomic_fetch_add(&pstHeader->ullDropped, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    TcpCaptureRecord *pstRecord = (TcpCaptureRecord *)((char *)(pstHeader + 1) + ullOffset);
+    pstRecord->uiLength = (unsigned int)uiLength;
+    pstRecord->iSock = iSock;
+    pstRecord->iDirection = (int)eDirection;
+    pstRecord->ullConnId = ullConnId;
+    pstRecord->ullOffsetNsec = getMonotonicNsec() - pstHeader->ullStartNsec;
+    return pstRecord;
+}
+
+/**
+ * @brief 연결 테이블에 등록된 연결의 식별자를 가져옵니다. 등록되지 않은 소켓이면 0을 반환합니다.
+ *
+ * @details 재생 도구가 연결을 식별자로 구분하므로, 식별자가 없는 소켓의 데이터는 기록하지 않습니다.
+ */
+static unsigned long long getCaptureConnId(int iSock)
+{
+    TcpConnStats *pstStats = findConnStats(iSock);
+    return (pstStats != NULL) ? pstStats->ullCreatedNsec : 0;
+}
+
+/**
+ * @brief 기록 중 표시를 남기고 캡처 헤더를 가져옵니다. 캡처 중이 아니면 NULL을 반환합니다.
+ */
+static TcpCaptureHeader *enterCapture(void)
+{
+    if (__atomic_load_n(&g_pstCapture, __ATOMIC_RELAXED) == NULL) {
+        return NULL;
+    }
+    __atomic_fetch_add(&g_iCaptureWriters, 1, __ATOMIC_SEQ_CST);
+    TcpCaptureHeader *pstHeader = __atomic_load_n(&g_pstCapture, __ATOMIC_SEQ_CST);
+    if (pstHeader == NULL) {
+        __atomic_fetch_sub(&g_iCaptureWriters, 1, __ATOMIC_RELEASE);
+    }
+    return pstHeader;
+}
+
+static void leaveCapture(void)
+{
+    __atomic_fetch_sub(&g_iCaptureWriters, 1, __ATOMIC_RELEASE);
+}
+
+
+int startTrafficCapture(const char *kpchPath, unsigned long long ullCapacity)
+{
+    if (__atomic_load_n(&g_pstCapture, __ATOMIC_ACQUIRE) != NULL) {
+        fprintf(stderr, "traffic capture already running\n");
+        return -1;
+    }
+    if (ullCapacity == 0) {
+        ullCapacity = TCP_CAPTURE_DEFAULT_SIZE;
+    }
+    ullCapacity &= ~(unsigned long long)(TCP_CAPTURE_ALIGN - 1);
+
+    int iFd = open(kpchPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (iFd < 0) {
+        perror("open capture file failed");
+        return -1;
+    }
+
+    size_t uiSize = sizeof(TcpCaptureHeader) + (size_t)ullCapacity;
+    if (ftruncate(iFd, (off_t)uiSize) < 0) {
+        perror("ftruncate failed");
+        close(iFd);
+        return -1;
+    }
+
+    void *pvMap = mmap(NULL, uiSize, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+    if (pvMap == MAP_FAILED) {
+        perror("mmap failed");
+        close(iFd);
+        return -1;
+    }
+
+    TcpCaptureHeader *pstHeader = (TcpCaptureHeader *)pvMap;
+    pstHeader->uiVersion = TCP_CAPTURE_VERSION;
+    pstHeader->ullStartNsec = getMonotonicNsec();
+    pstHeader->ullCapacity = ullCapacity;
+    pstHeader->ullUsed = 0;
+    pstHeader->ullDropped = 0;
+    memcpy(pstHeader->achMagic, TCP_CAPTURE_MAGIC, sizeof(TCP_CAPTURE_MAGIC));
+
+    g_iCaptureFd = iFd;
+    g_uiCaptureMapSize = uiSize;
+    __atomic_store_n(&g_pstCapture, pstHeader, __ATOMIC_RELEASE);
+    return 0;
+}
+
+unsigned long long stopTrafficCapture(void)
+{
+    TcpCaptureHeader *pstHeader = __atomic_exchange_n(&g_pstCapture, (TcpCaptureHeader *)NULL, __ATOMIC_SEQ_CST);
+    if (pstHeader == NULL) {
+        return 0;
+    }
+    while (__atomic_load_n(&g_iCaptureWriters, __ATOMIC_ACQUIRE) != 0) {
+        sched_yield();
+    }
+
+    unsigned long long ullUsed = pstHeader->ullUsed;
+    if (ullUsed > pstHeader->ullCapacity) {
+        ullUsed = pstHeader->ullCapacity;
+    }
+    pstHeader->ullUsed = ullUsed;
+
+    msync(pstHeader, g_uiCaptureMapSize, MS_SYNC);
+    munmap(pstHeader, g_uiCaptureMapSize);
+    if (ftruncate(g_iCaptureFd, (off_t)(sizeof(TcpCaptureHeader) + ullUsed)) < 0) {
+        perror("ftruncate failed");
+    }
+    close(g_iCaptureFd);
+    g_iCaptureFd = -1;
+    g_uiCaptureMapSize = 0;
+    return ullUsed;
+}
+
+void captureTraffic(int iSock, TcpCaptureDirection eDirection, const void *kpvData, size_t uiLength)
+{
+    // 연결 종료(0바이트 수신)는 CLOSE 레코드로 남으므로 빈 데이터는 기록하지 않음
+    if (uiLength == 0 && (eDirection == TCP_CAPTURE_IN || eDirection == TCP_CAPTURE_OUT)) {
+        return;
+    }
+    TcpCaptureHeader *pstHeader = enterCapture();
+    if (pstHeader == NULL) {
+        return;
+    }
+
+    unsigned long long ullConnId = getCaptureConnId(iSock);
+    if (ullConnId == 0) {
+        leaveCapture();
+        return;
+    }
+    TcpCaptureRecord *pstRecord = reserveRecord(pstHeader, iSock, ullConnId, eDirection, uiLength);
+    if (pstRecord != NULL) {
+        if (uiLength > 0) {
+            memcpy(pstRecord + 1, kpvData, uiLength);
+        }
+        __atomic_store_n(&pstRecord->uiCommitted, 1, __ATOMIC_RELEASE);
+    }
+    leaveCapture();
+}
+
+void captureTrafficV(int iSock, TcpCaptureDirection eDirection, const struct iovec *kpstIov, int iIovCnt,
+                     size_t uiLength)
+{
+    if (uiLength == 0 && (eDirection == TCP_CAPTURE_IN || eDirection == TCP_CAPTURE_OUT)) {
+        return;
+    }
+    TcpCaptureHeader *pstHeader = enterCapture();
+    if (pstHeader == NULL) {
+        return;
+    }
+
+    unsigned long long ullConnId = getCaptureConnId(iSock);
+    if (ullConnId == 0) {
+        leaveCapture();
+        return;
+    }
+    TcpCaptureRecord *pstRecord = reserveRecord(pstHeader, iSock, ullConnId, eDirection, uiLength);
+    if (pstRecord != NULL) {
+        unsigned char *pucOut = (unsigned char *)(pstRecord + 1);
+        size_t uiRemain = uiLength;
+        for (int i = 0; i < iIovCnt && uiRemain > 0; i++) {
+            size_t uiCopy = (kpstIov[i].iov_len < uiRemain) ? kpstIov[i].iov_len : uiRemain;
+            memcpy(pucOut, kpstIov[i].iov_base, uiCopy);
+            pucOut += uiCopy;
+            uiRemain -= uiCopy;
+        }
+        __atomic_store_n(&pstRecord->uiCommitted, 1, __ATOMIC_RELEASE);
+    }
+    leaveCapture();
+}
+
+const TcpCaptureHeader *openTrafficCapture(const char *kpchPath, size_t *puiSize)
+{
+    int iFd = open(kpchPath, O_RDONLY | O_CLOEXEC);
+    if (iFd < 0) {
+        perror("open failed");
+        return NULL;
+    }
+
+    struct stat stStat;
+    if (fstat(iFd, &stStat) < 0 || (size_t)stStat.st_size < sizeof(TcpCaptureHeader)) {
+        fprintf(stderr, "invalid capture file: %s\n", kpchPath);
+        close(iFd);
+        return NULL;
+    }
+
+    size_t uiSize = (size_t)stStat.st_size;
+    void *pvMap = mmap(NULL, uiSize, PROT_READ, MAP_SHARED, iFd, 0);
+    close(iFd);
+    if (pvMap == MAP_FAILED) {
+        perror("mmap failed");
+        return NULL;
+    }
+
+    // stopTrafficCapture()로 보정되지 않은 파일은 넘친 예약만큼 ullUsed가 용량보다 클 수 있으므로
+    // nextTrafficRecord()와 같이 용량으로 잘라 기록된 부분까지 읽음
+    const TcpCaptureHeader *kpstHeader = (const TcpCaptureHeader *)pvMap;
+    unsigned long long ullUsed = __atomic_load_n(&kpstHeader->ullUsed, __ATOMIC_ACQUIRE);
+    if (ullUsed > kpstHeader->ullCapacity) {
+        ullUsed = kpstHeader->ullCapacity;
+    }
+    if (memcmp(kpstHeader->achMagic, TCP_CAPTURE_MAGIC, sizeof(TCP_CAPTURE_MAGIC)) != 0
+        || kpstHeader->uiVersion != TCP_CAPTURE_VERSION
+        || sizeof(TcpCaptureHeader) + ullUsed > uiSize) {
+        fprintf(stderr, "capture file format mismatch: %s\n", kpchPath);
+        munmap(pvMap, uiSize);
+        return NULL;
+    }
+
+    if (puiSize != NULL) {
+        *puiSize = uiSize;
+    }
+    return kpstHeader;
+}
+
+const TcpCaptureRecord *nextTrafficRecord(const TcpCaptureHeader *kpstHeader, const TcpCaptureRecord *kpstRecord)
+{
+    const char *kpchBase = (const char *)(kpstHeader + 1);
+    unsigned long long ullUsed = __atomic_load_n(&kpstHeader->ullUsed, __ATOMIC_ACQUIRE);
+    if (ullUsed > kpstHeader->ullCapacity) {
+        ullUsed = kpstHeader->ullCapacity;
+    }
+
+    unsigned long long ullOffset = 0;
+    if (kpstRecord != NULL) {
+        ullOffset = (unsigned long long)((const char *)kpstRecord - kpchBase) + CAPTURE_RECORD_SIZE(kpstRecord->uiLength);
+    }
+
+    while (ullOffset + sizeof(TcpCaptureRecord) <= ullUsed) {
+        const TcpCaptureRecord *kpstNext = (const TcpCaptureRecord *)(kpchBase + ullOffset);
+        unsigned long long ullSize = CAPTURE_RECORD_SIZE(kpstNext->uiLength);
+        if (ullOffset + ullSize > ullUsed) {
+            break;
+        }
+        if (__atomic_load_n(&kpstNext->uiCommitted, __ATOMIC_ACQUIRE)) {
+            return kpstNext;
+        }
+        ullOffset += ullSize;
+    }
+    return NULL;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file tcp-codec.c
+ * @brief 쌓을 수 있는 코덱 파이프라인 구현
+ *
+ * 프로토콜마다 recvMsgBlocking() 둘레에 다시 만들던 수신 버퍼 관리(남은 데이터 당기기, 여러
+ * 메시지가 한 번에 도착한 경우, 버퍼보다 큰 메시지)와 송신 묶기를 한곳에 모았습니다. 코덱은
+ * 버퍼에서 메시지를 해석하고 메시지를 감싸는 일만 하며, 파이프라인은 와이어 쪽 코덱이 찾은
+ * 메시지를 안쪽 코덱(압축 해제 등)에 차례로 넘기고, 보낼 때는 안쪽부터 거꾸로 인코딩합니다.
+ *
+ * 주요 기능:
+ * - 호출자 수신 버퍼 안에서의 복사 없는 메시지 해석
+ * - 코덱 헤더와 짧은 조각은 스크래치에 이어 붙이고 긴 조각은 참조하는 송신 대기열
+ * - 대기열 전체를 sendMessageV() 한 번으로 전송
+ */
+#include "tcp-codec.h"
+#include "tcp-sock.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+void initCodecPipe(TcpCodecPipe *pstPipe, int iSock, void *pvBuffer, size_t uiCapacity)
+{
+    pstPipe->iSock = iSock;
+    pstPipe->iLayers = 0;
+    pstPipe->pchBuffer = (char *)pvBuffer;
+    pstPipe->uiCapacity = uiCapacity;
+    pstPipe->uiStart = 0;
+    pstPipe->uiEnd = 0;
+    pstPipe->uiConsumed = 0;
+    pstPipe->iIov = 0;
+    pstPipe->uiScratchUsed = 0;
+    pstPipe->ullQueued = 0;
+}
+
+int pushCodecLayer(TcpCodecPipe *pstPipe, const TcpCodec *kpstCodec, void *pvState)
+{
+    if (pstPipe->iLayers == TCP_CODEC_MAX_LAYERS) {
+        fprintf(stderr, "pushCodecLayer: more than %d layers\n", TCP_CODEC_MAX_LAYERS);
+        return -1;
+    }
+    pstPipe->astLayers[pstPipe->iLayers].kpstCodec = kpstCodec;
+    pstPipe->astLayers[pstPipe->iLayers].pvState = pvState;
+    return pstPipe->iLayers++;
+}
+
+void *allocCodecScratch(TcpCodecPipe *pstPipe, size_t uiSize)
+{
+    if (uiSize > TCP_CODEC_SCRATCH_SIZE - pstPipe->uiScratchUsed) {
+        return NULL;
+    }
+    void *pvScratch = pstPipe->aucScratch + pstPipe->uiScratchUsed;
+    pstPipe->uiScratchUsed += uiSize;
+    return pvScratch;
+}
+
+
+/*
+ * 수신
+ */
+
+/**
+ * @brief 남은 데이터를 버퍼 앞쪽으로 당기고 한 번 수신합니다.
+ *
+ * @return 수신한 바이트 수, 연결 종료 시 TCP_DISCONNECTION, 실패 시 -1
+ */
+static int fillCodecBuffer(TcpCodecPipe *pstPipe)
+{
+    if (pstPipe->uiStart == pstPipe->uiEnd) {
+        pstPipe->uiStart = 0;
+        pstPipe->uiEnd = 0;
+    }
+    if (pstPipe->uiEnd == pstPipe->uiCapacity) {
+        if (pstPipe->uiStart == 0) {
+            fprintf(stderr, "recvCodecMessage: message larger than %zu bytes on socket %d\n",
+                    pstPipe->uiCapacity, pstPipe->iSock);
+            return -1;
+        }
+        size_t uiPending = pstPipe->uiEnd - pstPipe->uiStart;
+        memmove(pstPipe->pchBuffer, pstPipe->pchBuffer + pstPipe->uiStart, uiPending);
+        pstPipe->uiStart = 0;
+        pstPipe->uiEnd = uiPending;
+    }
+
+    int iReceived = recvMsgBlocking(pstPipe->iSock, pstPipe->pchBuffer + pstPipe->uiEnd,
+                                    pstPipe->uiCapacity - pstPipe->uiEnd);
+    if (iReceived > 0) {
+        pstPipe->uiEnd += (size_t)iReceived;
+    }
+    return iReceived;
+}
+
+int recvCodecMessage(TcpCodecPipe *pstPipe, TcpCodecMsg *pstMsg)
+{
+    if (pstPipe->iLayers == 0) {
+        fprintf(stderr, "recvCodecMessage: no codec on socket %d\n", pstPipe->iSock);
+        return -1;
+    }
+    pstPipe->uiStart += pstPipe->uiConsumed;
+    pstPipe->uiConsumed = 0;
+
+    const TcpCodecLayer *kpstWire = &pstPipe->astLayers[0];
+    int iLength;
+    for (;;) {
+        iLength = 0;
+        if (pstPipe->uiStart < pstPipe->uiEnd) {
+            iLength = kpstWire->kpstCodec->pfnDecode(kpstWire->pvState, pstPipe->pchBuffer + pstPipe->uiStart,
+                                                     pstPipe->uiEnd - pstPipe->uiStart, pstMsg);
+        }
+        if (iLength < 0) {
+            fprintf(stderr, "recvCodecMessage: %s decode failed on socket %d\n", kpstWire->kpstCodec->kpchName,
+                    pstPipe->iSock);
+            return -1;
+        }
+        if (iLength > 0) {
+            break;
+        }
+        int iReceived = fillCodecBuffer(pstPipe);
+        if (iReceived <= 0) {
+            if (iReceived == TCP_DISCONNECTION && pstPipe->uiStart != pstPipe->uiEnd) {
+                fprintf(stderr, "recvCodecMessage: connection closed in the middle of a message\n");
+                return -1;
+            }
+            return iReceived;
+        }
+    }
+    pstPipe->uiConsumed = (size_t)iLength;
+
+    for (int i = 1; i < pstPipe->iLayers; i++) {
+        const TcpCodecLayer *kpstLayer = &pstPipe->astLayers[i];
+        TcpCodecMsg stInner;
+        iLength = kpstLayer->kpstCodec->pfnDecode(kpstLayer->pvState, pstMsg->pvData, pstMsg->uiLength, &stInner);
+        if (iLength < 0 || (size_t)iLength != pstMsg->uiLength) {
+            fprintf(stderr, "recvCodecMessage: %s decode failed on socket %d\n", kpstLayer->kpstCodec->kpchName,
+                    pstPipe->iSock);
+            return -1;
+        }
+        *pstMsg = stInner;
+    }
+    return 1;
+}
+
+
+/*
+ * 송신
+ */
+int flushCodecPipe(TcpCodecPipe *pstPipe)
+{
+    int iResult = 0;
+
+    if (pstPipe->iIov > 0) {
+        iResult = sendMessageV(pstPipe->iSock, pstPipe->astIov, pstPipe->iIov);
+    }
+    pstPipe->iIov = 0;
+    pstPipe->uiScratchUsed = 0;
+    pstPipe->ullQueued = 0;
+    return (iResult < 0) ? -1 : 0;
+}
+
+static int isCodecScratch(const TcpCodecPipe *kpstPipe, const void *kpvData)
+{
+    const unsigned char *kpucData = (const unsigned char *)kpvData;
+    return kpucData >= kpstPipe->aucScratch && kpucData < kpstPipe->aucScratch + TCP_CODEC_SCRATCH_SIZE;
+}
+
+/**
+ * @brief 인코딩한 메시지를 대기열에 붙입니다.
+ *
+ * @details 짧은 조각은 스크래치 끝에 복사하고, 직전 iovec 바로 뒤에 이어지는 조각은 그 iovec을
+ *          늘려서 iovec 개수를 줄입니다. 대기열 iovec이나 짧은 조각을 복사할 스크래치가 모자라면
+ *          대기열과 이 메시지를 바로 보내므로, 호출자 메모리를 가리킨 채 돌아가는 짧은 조각은 없습니다.
+ */
+static int appendCodecMessage(TcpCodecPipe *pstPipe, const struct iovec *kpstIov, int iIov)
+{
+    size_t uiCopy = 0;
+
+    for (int i = 0; i < iIov; i++) {
+        if (kpstIov[i].iov_len > 0 && kpstIov[i].iov_len <= TCP_CODEC_INLINE_MAX
+            && !isCodecScratch(pstPipe, kpstIov[i].iov_base)) {
+            uiCopy += kpstIov[i].iov_len;
+        }
+    }
+    if (pstPipe->iIov + iIov > TCP_IOV_MAX || uiCopy > TCP_CODEC_SCRATCH_SIZE - pstPipe->uiScratchUsed) {
+        int iResult = 0;
+        if (pstPipe->iIov > 0) {
+            iResult = sendMessageV(pstPipe->iSock, pstPipe->astIov, pstPipe->iIov);
+        }
+        if (iResult >= 0) {
+            iResult = sendMessageV(pstPipe->iSock, kpstIov, iIov);
+        }
+        pstPipe->iIov = 0;
+        pstPipe->uiScratchUsed = 0;
+        pstPipe->ullQueued = 0;
+        return (iResult < 0) ? -1 : 0;
+    }
+
+    for (int i = 0; i < iIov; i++) {
+        void *pvBase = kpstIov[i].iov_base;
+        size_t uiLength = kpstIov[i].iov_len;
+
+        if (uiLength == 0) {
+            continue;
+        }
+        if (uiLength <= TCP_CODEC_INLINE_MAX && !isCodecScratch(pstPipe, pvBase)) {
+            // 위에서 공간을 확인했으므로 실패하지 않음
+            void *pvCopy = allocCodecScratch(pstPipe, uiLength);
+            memcpy(pvCopy, pvBase, uiLength);
+            pvBase = pvCopy;
+        }
+        struct iovec *pstLast = (pstPipe->iIov > 0) ? &pstPipe->astIov[pstPipe->iIov - 1] : NULL;
+        if (pstLast != NULL && (char *)pstLast->iov_base + pstLast->iov_len == (char *)pvBase) {
+            pstLast->iov_len += uiLength;
+        } else {
+            pstPipe->astIov[pstPipe->iIov].iov_base = pvBase;
+            pstPipe->astIov[pstPipe->iIov++].iov_len = uiLength;
+        }
+    }
+    pstPipe->ullQueued++;
+    return 0;
+}
+
+int queueCodecMessage(TcpCodecPipe *pstPipe, const struct iovec *kpstIov, int iIov)
+{
+    struct iovec astMsg[TCP_CODEC_MAX_MSG_IOV];
+    int iCount = -1;
+
+    if (pstPipe->iLayers == 0 || iIov < 0 || iIov > TCP_CODEC_MAX_MSG_IOV) {
+        fprintf(stderr, "queueCodecMessage: invalid message (%d layers, %d iovecs)\n", pstPipe->iLayers, iIov);
+        return -1;
+    }
+
+    // 스크래치가 모자라면 대기열을 보내고 처음부터 한 번 더 인코딩
+    for (int iAttempt = 0; iAttempt < 2; iAttempt++) {
+        size_t uiMark = pstPipe->uiScratchUsed;
+
+        memcpy(astMsg, kpstIov, sizeof(struct iovec) * (size_t)iIov);
+        iCount = iIov;
+        for (int i = pstPipe->iLayers - 1; i >= 0 && iCount >= 0; i--) {
+            const TcpCodecLayer *kpstLayer = &pstPipe->astLayers[i];
+            iCount = kpstLayer->kpstCodec->pfnEncode(pstPipe, kpstLayer->pvState, astMsg, iCount,
+                                                     TCP_CODEC_MAX_MSG_IOV);
+        }
+        if (iCount >= 0) {
+            break;
+        }
+        pstPipe->uiScratchUsed = uiMark;
+        if (iCount != TCP_CODEC_NEED_SPACE || pstPipe->ullQueued == 0) {
+            break;
+        }
+        if (flushCodecPipe(pstPipe) < 0) {
+            return -1;
+        }
+    }
+    if (iCount < 0) {
+        fprintf(stderr, "queueCodecMessage: %s on socket %d\n",
+                (iCount == TCP_CODEC_NEED_SPACE) ? "message does not fit in scratch" : "encode failed",
+                pstPipe->iSock);
+        return -1;
+    }
+    return appendCodecMessage(pstPipe, astMsg, iCount);
+}
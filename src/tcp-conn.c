@@ -0,0 +1,327 @@
+/**
+ * @file tcp-conn.c
+ * @brief 연결별 상태 테이블과 적응형 수신 크기 조절 구현
+ *
+ * 소켓 파일 디스크립터를 인덱스로 하는 연결 테이블을 관리합니다. 테이블은 1024개 단위의
+ * 청크로 나뉘어 필요할 때만 할당되며, 조회 경로에는 잠금이 없습니다.
+ *
+ * 주요 기능:
+ * - 연결별 상태 정보 조회/생성/제거
+ * - 최근 수신 크기 이력을 이용한 수신 요청 크기(버퍼 클래스) 조절
+ * - FIONREAD 힌트를 이용한 대용량 수신의 시스템 콜 횟수 감소
+ */
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+#include "tcp-metrics-shm.h"
+#include "tcp-capture.h"
+#include "tcp-cost.h"
+#include "tcp-impair.h"
+#include "tcp-probe.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONN_CHUNK_SHIFT        10
+#define CONN_CHUNK_SIZE         (1 << CONN_CHUNK_SHIFT)
+#define CONN_CHUNK_COUNT        (TCP_CONN_MAX_FDS / CONN_CHUNK_SIZE)
+
+/**
+ * @brief 작은 수신이 이 횟수만큼 연속되면 수신 요청 크기를 한 단계 줄입니다.
+ */
+#define RECV_SHRINK_THRESHOLD   2
+
+/**
+ * @brief 버퍼가 요청 크기의 이 배수를 넘으면 메모리 반환을 위해 재할당합니다.
+ */
+#define RECV_RELEASE_FACTOR     4
+
+/**
+ * @brief 큰 버퍼가 마지막으로 필요했던 뒤 이 시간(ns)이 지나야 버퍼를 반환합니다.
+ * @details 간헐적으로 몰리는 수신에서 축소와 확장이 반복되어 정상 상태에서 재할당이
+ *          일어나지 않도록 합니다. 수신 횟수로 세면 빠른 연결일수록 유예가 짧아지므로 시간으로 셉니다.
+ */
+#define RECV_RELEASE_HOLD_NSEC  100000000ULL
+
+static TcpConnInfo *g_pstConnChunks[CONN_CHUNK_COUNT];
+
+
+static TcpConnInfo *lookupConnSlot(int iSock, int iCreate)
+{
+    if (iSock < 0 || iSock >= TCP_CONN_MAX_FDS) {
+        return NULL;
+    }
+
+    TcpConnInfo **ppstChunk = &g_pstConnChunks[iSock >> CONN_CHUNK_SHIFT];
+    TcpConnInfo *pstChunk = __atomic_load_n(ppstChunk, __ATOMIC_ACQUIRE);
+    if (pstChunk == NULL) {
+        if (!iCreate) {
+            return NULL;
+        }
+
+        TcpConnInfo *pstNewChunk = (TcpConnInfo *)calloc(CONN_CHUNK_SIZE, sizeof(TcpConnInfo));
+        if (pstNewChunk == NULL) {
+            return NULL;
+        }
+
+        // 다른 스레드가 먼저 청크를 설치했다면 그 청크를 사용
+        if (__atomic_compare_exchange_n(ppstChunk, &pstChunk, pstNewChunk, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            pstChunk = pstNewChunk;
+        } else {
+            free(pstNewChunk);
+        }
+    }
+
+    return &pstChunk[iSock & (CONN_CHUNK_SIZE - 1)];
+}
+
+static unsigned int roundUpRecvSize(size_t uiSize)
+{
+    unsigned int uiClass = TCP_RECV_MIN_SIZE;
+
+    while (uiClass < uiSize && uiClass < TCP_RECV_MAX_SIZE) {
+        uiClass <<= 1;
+    }
+    return uiClass;
+}
+
+static void recordRecvSize(TcpConnInfo *pstConn, unsigned int uiRequest, unsigned int uiReceived)
+{
+    pstConn->uiLastRequest = uiRequest;
+    pstConn->uiLastRecv = uiReceived;
+
+    if (uiReceived >= uiRequest) {
+        // 버퍼를 가득 채웠으면 아직 읽을 데이터가 남아 있을 가능성이 높으므로 즉시 확장
+        if (pstConn->uiRecvSize < TCP_RECV_MAX_SIZE) {
+            pstConn->uiRecvSize <<= 1;
+        }
+        pstConn->uiShrinkCount = 0;
+    } else if (uiReceived <= (pstConn->uiRecvSize >> 1)) {
+        // 한 단계 작은 클래스로도 충분한 수신이 반복되면 축소
+        if (++pstConn->uiShrinkCount >= RECV_SHRINK_THRESHOLD) {
+            if (pstConn->uiRecvSize > TCP_RECV_MIN_SIZE) {
+                pstConn->uiRecvSize >>= 1;
+            }
+            pstConn->uiShrinkCount = 0;
+        }
+    } else {
+        pstConn->uiShrinkCount = 0;
+    }
+}
+
+
+static void bindConnStats(TcpConnInfo *pstConn)
+{
+    TcpConnStats *pstStats = acquireConnStatsSlot(pstConn->iSock);
+    __atomic_store_n(&pstConn->pstStats, (pstStats != NULL) ? pstStats : &pstConn->stLocalStats, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 사용하지 않는 엔트리를 초기 상태로 되돌립니다 (소유 스레드에서 호출).
+ *
+ * @details scanConnTable()은 iInUse와 pstStats를 원자적으로 읽고 통계는 시퀀스 잠금으로 읽으므로,
+ *          엔트리 전체를 memset하지 않고 pstStats는 원자적으로, 나머지 필드는 일반 저장으로 지웁니다.
+ *          stLocalStats는 시퀀스 번호가 되돌아가지 않도록 initConnStats()로만 초기화하고,
+ *          pstImpair는 releaseConnImpairment()가 장애 잠금 안에서 지웁니다.
+ */
+static void resetConnEntry(TcpConnInfo *pstConn, int iSock)
+{
+    __atomic_store_n(&pstConn->pstStats, (TcpConnStats *)NULL, __ATOMIC_RELEASE);
+    pstConn->iSock = iSock;
+    pstConn->uiRecvSize = 0;
+    pstConn->uiShrinkCount = 0;
+    pstConn->uiLastRequest = 0;
+    pstConn->uiLastRecv = 0;
+    pstConn->ullHoldNsec = 0;
+    pstConn->iTimestamping = 0;
+    pstConn->uiTxKey = 0;
+    pstConn->pstTxStamps = NULL;
+}
+
+
+TcpConnInfo *getConnInfo(int iSock)
+{
+    TcpConnInfo *pstConn = lookupConnSlot(iSock, 1);
+    if (pstConn != NULL && !pstConn->iInUse) {
+        resetConnEntry(pstConn, iSock);
+        pstConn->uiRecvSize = TCP_RECV_INIT_SIZE;
+        bindConnStats(pstConn);
+        initConnStats(pstConn->pstStats, iSock);
+        __atomic_store_n(&pstConn->iInUse, 1, __ATOMIC_RELEASE);
+        addMetricGauge(TCP_GAUGE_OPEN_CONNECTIONS, 1);
+    }
+    return pstConn;
+}
+
+TcpConnInfo *registerConnInfo(int iSock)
+{
+    removeConnInfo(iSock);
+    return getConnInfo(iSock);
+}
+
+TcpConnInfo *findConnInfo(int iSock)
+{
+    TcpConnInfo *pstConn = lookupConnSlot(iSock, 0);
+    if (pstConn == NULL || !pstConn->iInUse) {
+        return NULL;
+    }
+    return pstConn;
+}
+
+TcpConnStats *findConnStats(int iSock)
+{
+    TcpConnInfo *pstConn = findConnInfo(iSock);
+    return (pstConn != NULL) ? pstConn->pstStats : NULL;
+}
+
+void removeConnInfo(int iSock)
+{
+    TcpConnInfo *pstConn = lookupConnSlot(iSock, 0);
+    if (pstConn != NULL) {
+        if (pstConn->iInUse) {
+            captureTraffic(iSock, TCP_CAPTURE_CLOSE, NULL, 0);
+            // 스캐너가 새로 고르지 않도록 사용 표시부터 내림. 이미 고른 스캐너는 iSock이 -1인 통계를 읽고 건너뜀
+            __atomic_store_n(&pstConn->iInUse, 0, __ATOMIC_RELEASE);
+            initConnStats(pstConn->pstStats, -1);
+            addMetricGauge(TCP_GAUGE_OPEN_CONNECTIONS, -1);
+        }
+        releaseConnImpairment(pstConn);
+        free(pstConn->pstTxStamps);
+        resetConnEntry(pstConn, -1);
+    }
+}
+
+void rebindConnStats(void)
+{
+    for (int i = 0; i < CONN_CHUNK_COUNT; i++) {
+        TcpConnInfo *pstChunk = __atomic_load_n(&g_pstConnChunks[i], __ATOMIC_ACQUIRE);
+        if (pstChunk == NULL) {
+            continue;
+        }
+        for (int j = 0; j < CONN_CHUNK_SIZE; j++) {
+            TcpConnInfo *pstConn = &pstChunk[j];
+            if (!__atomic_load_n(&pstConn->iInUse, __ATOMIC_ACQUIRE)) {
+                continue;
+            }
+            TcpConnStats *pstOld = pstConn->pstStats;
+            bindConnStats(pstConn);
+            if (pstConn->pstStats != pstOld) {
+                TcpConnStats stCopy = *pstOld;
+                stCopy.uiSeq = pstConn->pstStats->uiSeq;
+                *pstConn->pstStats = stCopy;
+            }
+        }
+    }
+}
+
+int scanConnTable(int *piCursor, TcpConnStats *pstOut, int iMax)
+{
+    int iCount = 0;
+    int iSock = (*piCursor > 0) ? *piCursor : 0;
+
+    while (iSock < TCP_CONN_MAX_FDS && iCount < iMax) {
+        TcpConnInfo *pstChunk = __atomic_load_n(&g_pstConnChunks[iSock >> CONN_CHUNK_SHIFT], __ATOMIC_ACQUIRE);
+        if (pstChunk == NULL) {
+            iSock = ((iSock >> CONN_CHUNK_SHIFT) + 1) << CONN_CHUNK_SHIFT;
+            continue;
+        }
+        TcpConnInfo *pstConn = &pstChunk[iSock & (CONN_CHUNK_SIZE - 1)];
+        iSock++;
+        if (!__atomic_load_n(&pstConn->iInUse, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        // 소유 스레드가 제거 중이면 포인터가 NULL로 바뀔 수 있음
+        TcpConnStats *pstStats = __atomic_load_n(&pstConn->pstStats, __ATOMIC_ACQUIRE);
+        if (pstStats != NULL && readConnStatsSnapshot(pstStats, &pstOut[iCount]) > 0 && pstOut[iCount].iSock >= 0) {
+            iCount++;
+        }
+    }
+    *piCursor = iSock;
+    return iCount;
+}
+
+int snapshotConnTable(TcpConnStats *pstOut, int iMax)
+{
+    int iCursor = 0;
+    return scanConnTable(&iCursor, pstOut, iMax);
+}
+
+size_t getAdaptiveRecvSize(int iSock)
+{
+    TcpConnInfo *pstConn = lookupConnSlot(iSock, 0);
+    if (pstConn == NULL || !pstConn->iInUse) {
+        return TCP_RECV_INIT_SIZE;
+    }
+    return pstConn->uiRecvSize;
+}
+
+int recvMsgAdaptive(int iSock, void **ppvBuffer, size_t *puiCapacity)
+{
+    TcpConnInfo *pstConn = findConnInfo(iSock);
+    unsigned int uiRequest = (pstConn != NULL) ? pstConn->uiRecvSize : TCP_RECV_INIT_SIZE;
+
+    /**
+     * @brief 직전 수신이 버퍼를 가득 채운 경우에만 FIONREAD로 대기 중인 바이트 수를 확인합니다.
+     *
+     * 소량 송수신에서는 추가 시스템 콜을 하지 않고, 대량 수신에서는 단계별 확장 없이
+     * 한 번에 필요한 클래스로 건너뜁니다.
+     */
+    if (pstConn != NULL && pstConn->uiLastRequest != 0 && pstConn->uiLastRecv >= pstConn->uiLastRequest
+        && uiRequest < TCP_RECV_MAX_SIZE) {
+        int iPending = 0;
+        if (ioctl(iSock, FIONREAD, &iPending) == 0 && (unsigned int)iPending > uiRequest) {
+            uiRequest = roundUpRecvSize((size_t)iPending);
+            pstConn->uiRecvSize = uiRequest;
+        }
+    }
+
+    int iGrow = (*ppvBuffer != NULL && *puiCapacity < uiRequest);
+    int iOversized = (*ppvBuffer != NULL && *puiCapacity >= (size_t)uiRequest * RECV_RELEASE_FACTOR);
+    int iRelease = (iOversized && (pstConn == NULL || pstConn->ullHoldNsec == 0
+                                   || getMonotonicNsec() - pstConn->ullHoldNsec >= RECV_RELEASE_HOLD_NSEC));
+    if (*ppvBuffer == NULL || iGrow || iRelease) {
+        void *pvNewBuffer = realloc(*ppvBuffer, uiRequest);
+        if (pvNewBuffer == NULL) {
+            perror("realloc failed");
+            return -1;
+        }
+        *ppvBuffer = pvNewBuffer;
+        *puiCapacity = uiRequest;
+    }
+    if (pstConn != NULL) {
+        // 키운 버퍼가 다시 필요해질 때마다 반환 유예를 연장하고, 반환하면 유예를 끝냄
+        if (iGrow || (pstConn->ullHoldNsec != 0 && !iOversized)) {
+            pstConn->ullHoldNsec = getMonotonicNsec();
+        } else if (iRelease) {
+            pstConn->ullHoldNsec = 0;
+        }
+    }
+
+    unsigned long long ullCost = beginConnCost();
+    ssize_t received = recv(iSock, *ppvBuffer, limitImpairedRecv(iSock, uiRequest), 0);
+    if (received < 0) {
+        TCP_PROBE3(recv, iSock, -1, errno);
+        perror("recv failed");
+        return -1;
+    }
+    TCP_PROBE3(recv, iSock, received, 0);
+    if (received == 0) {
+        return TCP_DISCONNECTION;
+    }
+    countRecv((pstConn != NULL) ? pstConn->pstStats : NULL, (size_t)received);
+    endConnCost(iSock, TCP_COST_RECV, ullCost);
+    captureTraffic(iSock, TCP_CAPTURE_IN, *ppvBuffer, (size_t)received);
+    TCP_STAGE_MARK(TCP_STAGE_RECV);
+
+    if (pstConn != NULL) {
+        recordRecvSize(pstConn, uiRequest, (unsigned int)received);
+    }
+    return (int)received;
+}
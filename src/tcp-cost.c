@@ -0,0 +1,283 @@
+/**
+ * @file tcp-cost.c
+ * @brief 연결별 CPU 비용 측정과 상위 N 연결(heavy hitter) 추적 구현
+ *
+ * 수신/전송/해석/핸들러 구간의 사이클 카운터 차이를 연결 통계에 누적하고, 스레드별
+ * space-saving 스케치로 비용이 큰 연결을 추적합니다. 스케치는 고정 크기이므로 연결 수와
+ * 관계없이 메모리와 갱신 비용이 일정합니다.
+ *
+ * 주요 기능:
+ * - 사이클 카운터 기반 구간 비용 측정
+ * - 스레드별 space-saving 스케치
+ * - 스케치 병합을 통한 상위 N 보고
+ */
+#include "tcp-cost.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int iSock;
+    unsigned long long ullCreatedNsec;
+    unsigned long long ullCount;
+    unsigned long long ullError;
+} CostSketchEntry;
+
+typedef struct CostSketch {
+    struct CostSketch *pstNext;
+    pthread_mutex_t stLock;             /**< 소유 스레드와 보고 스레드 사이의 잠금 (평소에는 경합 없음) */
+    int iOwned;                         /**< 스레드가 사용 중이면 1 (0이면 다음 스레드가 재사용) */
+    int iUsed;
+    CostSketchEntry astEntries[TCP_COST_TOPN_SLOTS];
+} CostSketch;
+
+static int g_iCostEnabled;
+static CostSketch *g_pstCostSketches;
+
+/**
+ * @brief 종료한 스레드의 스케치 값이 모이는 스케치 (목록에 한 번만 추가되며 재사용되지 않음)
+ */
+static CostSketch g_stRetiredSketch = { NULL, PTHREAD_MUTEX_INITIALIZER, 1, 0, {{0, 0, 0, 0}} };
+
+/**
+ * @brief 스레드 종료 시 스케치를 반납하기 위한 키
+ */
+static pthread_key_t g_stCostSketchKey;
+static pthread_once_t g_stCostSketchOnce = PTHREAD_ONCE_INIT;
+
+static __thread CostSketch *t_pstCostSketch;
+
+
+static void pushSketch(CostSketch *pstSketch)
+{
+    CostSketch *pstHead = __atomic_load_n(&g_pstCostSketches, __ATOMIC_RELAXED);
+    do {
+        pstSketch->pstNext = pstHead;
+    } while (!__atomic_compare_exchange_n(&g_pstCostSketches, &pstHead, pstSketch, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief space-saving 갱신: 없는 키가 들어오면 최소 엔트리를 대체하고 그 값을 오차로 물려받습니다.
+ *
+ * ullError는 다른 스케치에서 옮겨 오는 엔트리의 오차이며, 일반 갱신에서는 0입니다.
+ */
+static void updateSketch(CostSketch *pstSketch, int iSock, unsigned long long ullCreatedNsec,
+                         unsigned long long ullWeight, unsigned long long ullError)
+{
+    CostSketchEntry *pstMin = NULL;
+
+    pthread_mutex_lock(&pstSketch->stLock);
+    for (int i = 0; i < pstSketch->iUsed; i++) {
+        CostSketchEntry *pstEntry = &pstSketch->astEntries[i];
+        if (pstEntry->iSock == iSock && pstEntry->ullCreatedNsec == ullCreatedNsec) {
+            pstEntry->ullCount += ullWeight;
+            pstEntry->ullError += ullError;
+            pthread_mutex_unlock(&pstSketch->stLock);
+            return;
+        }
+        if (pstMin == NULL || pstEntry->ullCount < pstMin->ullCount) {
+            pstMin = pstEntry;
+        }
+    }
+
+    if (pstSketch->iUsed < TCP_COST_TOPN_SLOTS) {
+        CostSketchEntry *pstEntry = &pstSketch->astEntries[pstSketch->iUsed++];
+        pstEntry->iSock = iSock;
+        pstEntry->ullCreatedNsec = ullCreatedNsec;
+        pstEntry->ullCount = ullWeight;
+        pstEntry->ullError = ullError;
+    } else {
+        pstMin->ullError = pstMin->ullCount + ullError;
+        pstMin->ullCount += ullWeight;
+        pstMin->iSock = iSock;
+        pstMin->ullCreatedNsec = ullCreatedNsec;
+    }
+    pthread_mutex_unlock(&pstSketch->stLock);
+}
+
+/**
+ * @brief 종료하는 스레드의 스케치를 반납합니다.
+ *
+ * @details 엔트리는 종료 스레드용 스케치에 space-saving으로 합쳐 보고에 남기고, 비운 스케치는
+ *          다음에 시작하는 스레드가 재사용하므로 목록 길이는 동시에 실행된 스레드 수를 넘지 않습니다.
+ */
+static void releaseThreadSketch(void *pvSketch)
+{
+    CostSketch *pstSketch = (CostSketch *)pvSketch;
+    CostSketchEntry astEntries[TCP_COST_TOPN_SLOTS];
+
+    t_pstCostSketch = NULL;
+    pthread_mutex_lock(&pstSketch->stLock);
+    int iUsed = pstSketch->iUsed;
+    memcpy(astEntries, pstSketch->astEntries, sizeof(CostSketchEntry) * (size_t)iUsed);
+    pstSketch->iUsed = 0;
+    pthread_mutex_unlock(&pstSketch->stLock);
+
+    for (int i = 0; i < iUsed; i++) {
+        updateSketch(&g_stRetiredSketch, astEntries[i].iSock, astEntries[i].ullCreatedNsec,
+                     astEntries[i].ullCount, astEntries[i].ullError);
+    }
+    __atomic_store_n(&pstSketch->iOwned, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 스케치 반납 키를 만들고 종료 스레드용 스케치를 목록에 추가합니다 (한 번만 실행).
+ */
+static void initCostSketches(void)
+{
+    if (pthread_key_create(&g_stCostSketchKey, releaseThreadSketch) != 0) {
+        perror("pthread_key_create failed");
+    }
+    pushSketch(&g_stRetiredSketch);
+}
+
+static CostSketch *getThreadSketch(void)
+{
+    if (t_pstCostSketch != NULL) {
+        return t_pstCostSketch;
+    }
+    pthread_once(&g_stCostSketchOnce, initCostSketches);
+
+    // 종료한 스레드가 반납한 스케치를 먼저 재사용
+    CostSketch *pstSketch;
+    for (pstSketch = __atomic_load_n(&g_pstCostSketches, __ATOMIC_ACQUIRE); pstSketch != NULL;
+         pstSketch = pstSketch->pstNext) {
+        int iFree = 0;
+        if (__atomic_compare_exchange_n(&pstSketch->iOwned, &iFree, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (pstSketch == NULL) {
+        pstSketch = (CostSketch *)calloc(1, sizeof(CostSketch));
+        if (pstSketch == NULL) {
+            return NULL;
+        }
+        pthread_mutex_init(&pstSketch->stLock, NULL);
+        pstSketch->iOwned = 1;
+        pushSketch(pstSketch);
+    }
+
+    pthread_setspecific(g_stCostSketchKey, pstSketch);
+    t_pstCostSketch = pstSketch;
+    return pstSketch;
+}
+
+static int compareCostEntry(const void *kpvLeft, const void *kpvRight)
+{
+    const TcpCostEntry *kpstLeft = (const TcpCostEntry *)kpvLeft;
+    const TcpCostEntry *kpstRight = (const TcpCostEntry *)kpvRight;
+
+    if (kpstLeft->ullCycles != kpstRight->ullCycles) {
+        return (kpstLeft->ullCycles < kpstRight->ullCycles) ? 1 : -1;
+    }
+    return kpstLeft->iSock - kpstRight->iSock;
+}
+
+
+void setConnCostAccounting(int iEnable)
+{
+    __atomic_store_n(&g_iCostEnabled, iEnable ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+unsigned long long beginConnCost(void)
+{
+    if (!__atomic_load_n(&g_iCostEnabled, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+    return getCycleCount();
+}
+
+void endConnCost(int iSock, TcpCostKind eKind, unsigned long long ullStart)
+{
+    if (ullStart == 0 || (unsigned int)eKind >= TCP_COST_KIND_COUNT) {
+        return;
+    }
+
+    unsigned long long ullNow = getCycleCount();
+    unsigned long long ullCycles = (ullNow > ullStart) ? ullNow - ullStart : 0;
+    TcpConnStats *pstStats = findConnStats(iSock);
+    if (pstStats == NULL) {
+        return;
+    }
+
+    __atomic_fetch_add(&pstStats->uiSeq, 1, __ATOMIC_ACQ_REL);
+    __atomic_fetch_add(&pstStats->aullCostCycles[eKind], ullCycles, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pstStats->uiSeq, 1, __ATOMIC_RELEASE);
+
+    CostSketch *pstSketch = getThreadSketch();
+    if (pstSketch != NULL) {
+        updateSketch(pstSketch, iSock, pstStats->ullCreatedNsec, ullCycles, 0);
+    }
+}
+
+int getConnCostTopN(TcpCostEntry *pstOut, int iMax)
+{
+    int iCapacity = 0;
+    for (CostSketch *pstSketch = __atomic_load_n(&g_pstCostSketches, __ATOMIC_ACQUIRE);
+         pstSketch != NULL; pstSketch = pstSketch->pstNext) {
+        iCapacity += TCP_COST_TOPN_SLOTS;
+    }
+    if (iCapacity == 0 || iMax <= 0) {
+        return 0;
+    }
+
+    TcpCostEntry *pstMerged = (TcpCostEntry *)malloc(sizeof(TcpCostEntry) * (size_t)iCapacity);
+    if (pstMerged == NULL) {
+        perror("malloc failed");
+        return 0;
+    }
+
+    // 같은 연결이 여러 스레드 스케치에 있으면 값과 오차를 합산
+    int iCount = 0;
+    for (CostSketch *pstSketch = __atomic_load_n(&g_pstCostSketches, __ATOMIC_ACQUIRE);
+         pstSketch != NULL && iCount < iCapacity; pstSketch = pstSketch->pstNext) {
+        pthread_mutex_lock(&pstSketch->stLock);
+        for (int i = 0; i < pstSketch->iUsed; i++) {
+            const CostSketchEntry *kpstEntry = &pstSketch->astEntries[i];
+            int j;
+            for (j = 0; j < iCount; j++) {
+                if (pstMerged[j].iSock == kpstEntry->iSock && pstMerged[j].ullCreatedNsec == kpstEntry->ullCreatedNsec) {
+                    break;
+                }
+            }
+            if (j == iCount) {
+                if (iCount == iCapacity) {
+                    continue;
+                }
+                pstMerged[j].iSock = kpstEntry->iSock;
+                pstMerged[j].ullCreatedNsec = kpstEntry->ullCreatedNsec;
+                pstMerged[j].ullCycles = 0;
+                pstMerged[j].ullError = 0;
+                iCount++;
+            }
+            pstMerged[j].ullCycles += kpstEntry->ullCount;
+            pstMerged[j].ullError += kpstEntry->ullError;
+        }
+        pthread_mutex_unlock(&pstSketch->stLock);
+    }
+
+    qsort(pstMerged, (size_t)iCount, sizeof(TcpCostEntry), compareCostEntry);
+    if (iCount > iMax) {
+        iCount = iMax;
+    }
+    memcpy(pstOut, pstMerged, sizeof(TcpCostEntry) * (size_t)iCount);
+    free(pstMerged);
+    return iCount;
+}
+
+void resetConnCostTopN(void)
+{
+    for (CostSketch *pstSketch = __atomic_load_n(&g_pstCostSketches, __ATOMIC_ACQUIRE);
+         pstSketch != NULL; pstSketch = pstSketch->pstNext) {
+        pthread_mutex_lock(&pstSketch->stLock);
+        pstSketch->iUsed = 0;
+        pthread_mutex_unlock(&pstSketch->stLock);
+    }
+}
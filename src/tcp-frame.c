@@ -0,0 +1,357 @@
+/**
+ * @file tcp-frame.c
+ * @brief 길이 접두(length-prefix) 프레이밍 구현
+ *
+ * TCP 바이트 스트림 위에서 메시지 경계를 유지하기 위한 프레임 형식과
+ * 송수신 함수를 제공합니다. 프레임 헤더에는 선택적으로 분산 추적 컨텍스트를 실을 수 있습니다.
+ *
+ * 주요 기능:
+ * - 프레임 헤더 인코딩/해석
+ * - 헤더와 페이로드를 한 번에 전송하는 sendFrame()
+ * - 프레임 단위 수신 recvFrame()과 블로킹 없이 이어 받는 recvFrameNonBlocking()
+ * - 코덱 파이프라인용 프레임 코덱
+ */
+#include "tcp-sock.h"
+#include "tcp-frame.h"
+#include "tcp-capture.h"
+#include "tcp-conn.h"
+#include "tcp-cost.h"
+#include "tcp-impair.h"
+#include "tcp-metrics.h"
+#include "tcp-probe.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+
+#include <stdio.h>
+#include <string.h>
+
+
+static int recvAll(int iSock, void *pvBuffer, size_t uiLength)
+{
+    size_t uiReceived = 0;
+
+    while (uiReceived < uiLength) {
+        ssize_t received = recv(iSock, (char *)pvBuffer + uiReceived,
+                                limitImpairedRecv(iSock, uiLength - uiReceived), MSG_WAITALL);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            TCP_PROBE3(recv, iSock, -1, errno);
+            perror("recv failed");
+            return -1;
+        }
+        TCP_PROBE3(recv, iSock, received, 0);
+        if (received == 0) {
+            if (uiReceived == 0) {
+                return TCP_DISCONNECTION;
+            }
+            fprintf(stderr, "recvFrame: connection closed in the middle of a frame\n");
+            return -1;
+        }
+        countRecv(findConnStats(iSock), (size_t)received);
+        captureTraffic(iSock, TCP_CAPTURE_IN, (char *)pvBuffer + uiReceived, (size_t)received);
+        uiReceived += (size_t)received;
+    }
+    return (int)uiReceived;
+}
+
+
+int encodeFrameHeader(unsigned char *pucOut, size_t uiPayloadLength, const TcpTraceContext *kpstTrace)
+{
+    if (uiPayloadLength > TCP_FRAME_MAX_PAYLOAD) {
+        return -1;
+    }
+
+    pucOut[0] = (unsigned char)(uiPayloadLength >> 24);
+    pucOut[1] = (unsigned char)(uiPayloadLength >> 16);
+    pucOut[2] = (unsigned char)(uiPayloadLength >> 8);
+    pucOut[3] = (unsigned char)uiPayloadLength;
+    pucOut[4] = 0;
+
+    if (kpstTrace == NULL) {
+        return TCP_FRAME_HEADER_SIZE;
+    }
+
+    pucOut[4] |= TCP_FRAME_FLAG_TRACE;
+    memcpy(pucOut + TCP_FRAME_HEADER_SIZE, kpstTrace->aucTraceId, TCP_TRACE_ID_SIZE);
+    memcpy(pucOut + TCP_FRAME_HEADER_SIZE + TCP_TRACE_ID_SIZE, kpstTrace->aucSpanId, TCP_SPAN_ID_SIZE);
+    pucOut[TCP_FRAME_MAX_HEADER - 1] = kpstTrace->ucFlags;
+    return TCP_FRAME_MAX_HEADER;
+}
+
+int parseFrameHeader(const void *kpvData, size_t uiLength, TcpFrameHeader *pstHeader)
+{
+    const unsigned char *kpucData = (const unsigned char *)kpvData;
+
+    if (uiLength < TCP_FRAME_HEADER_SIZE) {
+        return 0;
+    }
+
+    pstHeader->uiPayloadLength = ((unsigned int)kpucData[0] << 24) | ((unsigned int)kpucData[1] << 16)
+                               | ((unsigned int)kpucData[2] << 8) | (unsigned int)kpucData[3];
+    pstHeader->ucFlags = kpucData[4];
+    if (pstHeader->uiPayloadLength > TCP_FRAME_MAX_PAYLOAD || (pstHeader->ucFlags & ~TCP_FRAME_FLAG_TRACE)) {
+        return -1;
+    }
+
+    if (!(pstHeader->ucFlags & TCP_FRAME_FLAG_TRACE)) {
+        pstHeader->uiHeaderLength = TCP_FRAME_HEADER_SIZE;
+        memset(&pstHeader->stTrace, 0, sizeof(pstHeader->stTrace));
+        return TCP_FRAME_HEADER_SIZE;
+    }
+
+    if (uiLength < TCP_FRAME_MAX_HEADER) {
+        return 0;
+    }
+    memcpy(pstHeader->stTrace.aucTraceId, kpucData + TCP_FRAME_HEADER_SIZE, TCP_TRACE_ID_SIZE);
+    memcpy(pstHeader->stTrace.aucSpanId, kpucData + TCP_FRAME_HEADER_SIZE + TCP_TRACE_ID_SIZE, TCP_SPAN_ID_SIZE);
+    pstHeader->stTrace.ucFlags = kpucData[TCP_FRAME_MAX_HEADER - 1];
+    pstHeader->uiHeaderLength = TCP_FRAME_MAX_HEADER;
+    return TCP_FRAME_MAX_HEADER;
+}
+
+int sendFrame(int iSock, const void *kpvPayload, size_t uiLength, const TcpTraceContext *kpstTrace)
+{
+    unsigned char aucHeader[TCP_FRAME_MAX_HEADER];
+    int iSampled = TCP_TRACE_SAMPLED(kpstTrace);
+    unsigned long long ullEnqueueNsec = iSampled ? getMonotonicNsec() : 0;
+    TCP_STAGE_MARK(TCP_STAGE_ENQUEUE);
+
+    int iHeaderLength = encodeFrameHeader(aucHeader, uiLength, kpstTrace);
+    if (iHeaderLength < 0) {
+        fprintf(stderr, "sendFrame: payload too large (%zu bytes)\n", uiLength);
+        return -1;
+    }
+
+    struct iovec astIov[2];
+    astIov[0].iov_base = aucHeader;
+    astIov[0].iov_len = (size_t)iHeaderLength;
+    astIov[1].iov_base = (void *)kpvPayload;
+    astIov[1].iov_len = uiLength;
+
+    unsigned long long ullSyscallNsec = 0;
+    if (iSampled) {
+        ullSyscallNsec = getMonotonicNsec();
+        recordSpan(kpstTrace, TCP_SPAN_ENQUEUE, iSock, (unsigned int)uiLength, ullEnqueueNsec, ullSyscallNsec);
+    }
+
+    if (sendMessageV(iSock, astIov, (uiLength > 0) ? 2 : 1) < 0) {
+        return -1;
+    }
+
+    if (iSampled) {
+        recordSpan(kpstTrace, TCP_SPAN_SEND, iSock, (unsigned int)uiLength, ullSyscallNsec, getMonotonicNsec());
+    }
+    return (int)uiLength;
+}
+
+int recvFrame(int iSock, void *pvBuffer, size_t uiCapacity, TcpFrameHeader *pstHeader)
+{
+    unsigned char aucHeader[TCP_FRAME_MAX_HEADER];
+    TcpFrameHeader stHeader;
+
+    int iRet = recvAll(iSock, aucHeader, TCP_FRAME_HEADER_SIZE);
+    if (iRet == TCP_DISCONNECTION) {
+        return TCP_FRAME_CLOSED;
+    } else if (iRet < 0) {
+        return -1;
+    }
+    // 헤더가 도착한 시점부터 수신 구간으로 기록 (그 전의 대기 시간은 제외)
+    unsigned long long ullRecvNsec = getMonotonicNsec();
+    TCP_STAGE_MARK(TCP_STAGE_READY);
+
+    // 헤더를 기다린 시간은 CPU 비용이 아니므로 헤더 도착 이후의 수신만 비용으로 기록
+    unsigned long long ullCost = beginConnCost();
+    if (aucHeader[4] & TCP_FRAME_FLAG_TRACE) {
+        iRet = recvAll(iSock, aucHeader + TCP_FRAME_HEADER_SIZE, TCP_FRAME_TRACE_SIZE);
+    }
+    endConnCost(iSock, TCP_COST_RECV, ullCost);
+    if (iRet <= 0) {
+        return -1;
+    }
+
+    ullCost = beginConnCost();
+    iRet = parseFrameHeader(aucHeader, sizeof(aucHeader), &stHeader);
+    endConnCost(iSock, TCP_COST_PARSE, ullCost);
+    if (iRet <= 0) {
+        fprintf(stderr, "recvFrame: invalid frame header\n");
+        return -1;
+    }
+    if (stHeader.uiPayloadLength > uiCapacity) {
+        fprintf(stderr, "recvFrame: payload (%u bytes) exceeds buffer (%zu bytes)\n",
+                stHeader.uiPayloadLength, uiCapacity);
+        return -1;
+    }
+
+    if (stHeader.uiPayloadLength > 0) {
+        ullCost = beginConnCost();
+        iRet = recvAll(iSock, pvBuffer, stHeader.uiPayloadLength);
+        endConnCost(iSock, TCP_COST_RECV, ullCost);
+        if (iRet <= 0) {
+            return -1;
+        }
+    }
+    TCP_STAGE_MARK(TCP_STAGE_RECV);
+    TCP_STAGE_MARK(TCP_STAGE_PARSE);
+
+    if ((stHeader.ucFlags & TCP_FRAME_FLAG_TRACE) && TCP_TRACE_SAMPLED(&stHeader.stTrace)) {
+        recordSpan(&stHeader.stTrace, TCP_SPAN_RECV, iSock, stHeader.uiPayloadLength,
+                   ullRecvNsec, getMonotonicNsec());
+    }
+
+    if (pstHeader != NULL) {
+        *pstHeader = stHeader;
+    }
+    return (int)stHeader.uiPayloadLength;
+}
+
+void initFrameReader(TcpFrameReader *pstReader)
+{
+    memset(pstReader, 0, sizeof(*pstReader));
+}
+
+int recvFrameNonBlocking(int iSock, TcpFrameReader *pstReader, void *pvBuffer, size_t uiCapacity,
+                         TcpFrameHeader *pstHeader)
+{
+    for (;;) {
+        unsigned char *pucDest;
+        size_t uiWant;
+
+        if (!pstReader->iHeaderDone) {
+            size_t uiHeaderLength = TCP_FRAME_HEADER_SIZE;
+            if (pstReader->uiHeaderReceived >= TCP_FRAME_HEADER_SIZE && (pstReader->aucHeader[4] & TCP_FRAME_FLAG_TRACE)) {
+                uiHeaderLength = TCP_FRAME_MAX_HEADER;
+            }
+            if (pstReader->uiHeaderReceived == uiHeaderLength) {
+                unsigned long long ullCost = beginConnCost();
+                int iRet = parseFrameHeader(pstReader->aucHeader, uiHeaderLength, &pstReader->stHeader);
+                endConnCost(iSock, TCP_COST_PARSE, ullCost);
+                if (iRet <= 0) {
+                    fprintf(stderr, "recvFrameNonBlocking: invalid frame header\n");
+                    return -1;
+                }
+                if (pstReader->stHeader.uiPayloadLength > uiCapacity) {
+                    fprintf(stderr, "recvFrameNonBlocking: payload (%u bytes) exceeds buffer (%zu bytes)\n",
+                            pstReader->stHeader.uiPayloadLength, uiCapacity);
+                    return -1;
+                }
+                pstReader->iHeaderDone = 1;
+                continue;
+            }
+            pucDest = pstReader->aucHeader + pstReader->uiHeaderReceived;
+            uiWant = uiHeaderLength - pstReader->uiHeaderReceived;
+        } else if (pstReader->uiPayloadReceived < pstReader->stHeader.uiPayloadLength) {
+            pucDest = (unsigned char *)pvBuffer + pstReader->uiPayloadReceived;
+            uiWant = pstReader->stHeader.uiPayloadLength - pstReader->uiPayloadReceived;
+        } else {
+            break;
+        }
+
+        unsigned long long ullCost = beginConnCost();
+        ssize_t received = recv(iSock, pucDest, limitImpairedRecv(iSock, uiWant), MSG_DONTWAIT);
+        endConnCost(iSock, TCP_COST_RECV, ullCost);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return TCP_FRAME_PENDING;
+            }
+            TCP_PROBE3(recv, iSock, -1, errno);
+            perror("recv failed");
+            return -1;
+        }
+        TCP_PROBE3(recv, iSock, received, 0);
+        if (received == 0) {
+            if (pstReader->uiHeaderReceived == 0) {
+                return TCP_FRAME_CLOSED;
+            }
+            fprintf(stderr, "recvFrameNonBlocking: connection closed in the middle of a frame\n");
+            return -1;
+        }
+        if (pstReader->uiHeaderReceived == 0) {
+            pstReader->ullRecvNsec = getMonotonicNsec();
+            TCP_STAGE_MARK(TCP_STAGE_READY);
+        }
+        countRecv(findConnStats(iSock), (size_t)received);
+        captureTraffic(iSock, TCP_CAPTURE_IN, pucDest, (size_t)received);
+        if (pstReader->iHeaderDone) {
+            pstReader->uiPayloadReceived += (unsigned int)received;
+        } else {
+            pstReader->uiHeaderReceived += (unsigned int)received;
+        }
+    }
+    TCP_STAGE_MARK(TCP_STAGE_RECV);
+    TCP_STAGE_MARK(TCP_STAGE_PARSE);
+
+    TcpFrameHeader stHeader = pstReader->stHeader;
+    if ((stHeader.ucFlags & TCP_FRAME_FLAG_TRACE) && TCP_TRACE_SAMPLED(&stHeader.stTrace)) {
+        recordSpan(&stHeader.stTrace, TCP_SPAN_RECV, iSock, stHeader.uiPayloadLength,
+                   pstReader->ullRecvNsec, getMonotonicNsec());
+    }
+    if (pstHeader != NULL) {
+        *pstHeader = stHeader;
+    }
+    initFrameReader(pstReader);
+    return (int)stHeader.uiPayloadLength;
+}
+
+
+/*
+ * 코덱 파이프라인
+ */
+static int decodeFrameCodec(void *pvState, void *pvData, size_t uiLength, TcpCodecMsg *pstMsg)
+{
+    TcpFrameHeader stHeader;
+    int iHeader = parseFrameHeader(pvData, uiLength, &stHeader);
+
+    if (iHeader <= 0) {
+        return iHeader;
+    }
+    if (uiLength - (size_t)iHeader < stHeader.uiPayloadLength) {
+        return 0;
+    }
+    if (pvState != NULL) {
+        ((TcpFrameCodecState *)pvState)->stLastHeader = stHeader;
+    }
+    pstMsg->pvData = (char *)pvData + iHeader;
+    pstMsg->uiLength = stHeader.uiPayloadLength;
+    return iHeader + (int)stHeader.uiPayloadLength;
+}
+
+static int encodeFrameCodec(TcpCodecPipe *pstPipe, void *pvState, struct iovec *pstIov, int iIov, int iMaxIov)
+{
+    const TcpTraceContext *kpstTrace = (pvState != NULL) ? ((TcpFrameCodecState *)pvState)->kpstTrace : NULL;
+    size_t uiPayload = 0;
+
+    if (iIov == iMaxIov) {
+        return -1;
+    }
+    for (int i = 0; i < iIov; i++) {
+        uiPayload += pstIov[i].iov_len;
+    }
+    unsigned char *pucHeader = (unsigned char *)allocCodecScratch(pstPipe, (kpstTrace != NULL) ? TCP_FRAME_MAX_HEADER
+                                                                                             : TCP_FRAME_HEADER_SIZE);
+    if (pucHeader == NULL) {
+        return TCP_CODEC_NEED_SPACE;
+    }
+    int iHeader = encodeFrameHeader(pucHeader, uiPayload, kpstTrace);
+    if (iHeader < 0) {
+        return -1;
+    }
+
+    memmove(pstIov + 1, pstIov, sizeof(struct iovec) * (size_t)iIov);
+    pstIov[0].iov_base = pucHeader;
+    pstIov[0].iov_len = (size_t)iHeader;
+    return iIov + 1;
+}
+
+static const TcpCodec g_stFrameCodec = { "frame", decodeFrameCodec, encodeFrameCodec };
+
+const TcpCodec *getFrameCodec(void)
+{
+    return &g_stFrameCodec;
+}
@@ -0,0 +1,269 @@
+/**
+ * @file tcp-hedge.c
+ * @brief 멱등 요청의 중복 전송(hedged request) 구현
+ *
+ * 읽기 전용 요청은 한 번 더 보내도 결과가 같으므로, 첫 요청이 그 백엔드의 평소 지연(p95)을
+ * 넘기면 다른 백엔드에 같은 요청을 보내고 먼저 온 응답을 씁니다. 느린 요청 몇 개가 만드는
+ * 꼬리 지연을 적은 추가 부하로 줄이며, 공유 예산이 전체 중복 요청 비율을 제한합니다.
+ *
+ * 주요 기능:
+ * - 백엔드별 지연 백분위 기반 중복 요청 시점
+ * - 토큰 버킷 중복 요청 예산
+ * - 타이밍 휠 기반 중복 요청/제한 시간 타이머
+ * - 먼저 온 응답 채택과 나머지 요청 취소
+ */
+#include "tcp-hedge.h"
+#include "tcp-frame.h"
+#include "tcp-metrics.h"
+
+#include <poll.h>
+#include <errno.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static unsigned int getConfigValue(unsigned int uiValue, unsigned int uiDefault)
+{
+    return (uiValue != 0) ? uiValue : uiDefault;
+}
+
+static void depositHedgeTokens(TcpHedgeBudget *pstBudget)
+{
+    long long llMax = (long long)pstBudget->uiBurst * 1000;
+    long long llTokens = __atomic_load_n(&pstBudget->llMilliTokens, __ATOMIC_RELAXED);
+    long long llNext;
+
+    do {
+        llNext = llTokens + (long long)pstBudget->uiBudgetPercent * 10;
+        if (llNext > llMax) {
+            llNext = llMax;
+        }
+    } while (llNext != llTokens
+             && !__atomic_compare_exchange_n(&pstBudget->llMilliTokens, &llTokens, llNext, 1,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static int takeHedgeToken(TcpHedgeBudget *pstBudget)
+{
+    long long llTokens = __atomic_load_n(&pstBudget->llMilliTokens, __ATOMIC_RELAXED);
+
+    do {
+        if (llTokens < 1000) {
+            return -1;
+        }
+    } while (!__atomic_compare_exchange_n(&pstBudget->llMilliTokens, &llTokens, llTokens - 1000, 1,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return 0;
+}
+
+static void setTimerFlag(TcpTimer *pstTimer, void *pvArg)
+{
+    (void)pstTimer;
+    *(int *)pvArg = 1;
+}
+
+void initHedgeBudget(TcpHedgeBudget *pstBudget, unsigned int uiBudgetPercent, unsigned int uiBurst)
+{
+    pstBudget->uiBudgetPercent = getConfigValue(uiBudgetPercent, TCP_HEDGE_DEFAULT_BUDGET);
+    pstBudget->uiBurst = getConfigValue(uiBurst, TCP_HEDGE_DEFAULT_BURST);
+    pstBudget->llMilliTokens = (long long)pstBudget->uiBurst * 1000;
+}
+
+int initHedgeClient(TcpHedgeClient *pstClient, TcpBalancer *pstBalancer, TcpHedgeBudget *pstBudget,
+                    const TcpHedgeConfig *kpstConfig)
+{
+    memset(pstClient, 0, sizeof(*pstClient));
+    if (kpstConfig != NULL) {
+        pstClient->stConfig = *kpstConfig;
+    }
+    pstClient->stConfig.uiPercentile = getConfigValue(pstClient->stConfig.uiPercentile, TCP_HEDGE_DEFAULT_PERCENTILE);
+    pstClient->stConfig.uiDefaultDelayUsec = getConfigValue(pstClient->stConfig.uiDefaultDelayUsec, TCP_HEDGE_DEFAULT_DELAY);
+    pstClient->stConfig.uiMinDelayUsec = getConfigValue(pstClient->stConfig.uiMinDelayUsec, TCP_HEDGE_DEFAULT_MIN_DELAY);
+    pstClient->pstBalancer = pstBalancer;
+    pstClient->pstBudget = pstBudget;
+
+    if (initTimerWheel(&pstClient->stWheel, 0, 0, getMonotonicNsec()) != 0) {
+        fprintf(stderr, "initHedgeClient: timer wheel allocation failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+void destroyHedgeClient(TcpHedgeClient *pstClient)
+{
+    destroyTimerWheel(&pstClient->stWheel);
+    free(pstClient->pvHedgeBuffer);
+    pstClient->pvHedgeBuffer = NULL;
+    pstClient->uiHedgeBufferSize = 0;
+}
+
+/**
+ * @brief 중복 요청의 응답 버퍼를 uiCapacity 이상으로 키움 (한 번 키운 버퍼는 계속 재사용)
+ */
+static int reserveHedgeBuffer(TcpHedgeClient *pstClient, size_t uiCapacity)
+{
+    if (pstClient->uiHedgeBufferSize >= uiCapacity) {
+        return 0;
+    }
+    void *pvBuffer = realloc(pstClient->pvHedgeBuffer, uiCapacity);
+    if (pvBuffer == NULL) {
+        perror("realloc failed");
+        return -1;
+    }
+    pstClient->pvHedgeBuffer = pvBuffer;
+    pstClient->uiHedgeBufferSize = uiCapacity;
+    return 0;
+}
+
+/**
+ * @brief 다음 타이머까지 poll()로 기다릴 시간 (ms, 올림)
+ */
+static int getPollTimeout(const TcpTimerWheel *kpstWheel)
+{
+    unsigned long long ullNext = getNextTimerExpiry(kpstWheel);
+    if (ullNext == 0) {
+        return -1;
+    }
+    unsigned long long ullNow = getMonotonicNsec();
+    if (ullNext <= ullNow) {
+        return 0;
+    }
+    return (int)((ullNext - ullNow + 999999ULL) / 1000000ULL);
+}
+
+int sendHedgedRequest(TcpHedgeClient *pstClient, const void *kpvKey, size_t uiKeyLength,
+                      const void *kpvRequest, size_t uiRequestLength, void *pvResponse, size_t uiCapacity,
+                      int iTimeoutMsec, int *piHedged)
+{
+    TcpBalancer *pstBalancer = pstClient->pstBalancer;
+    TcpBalanceConn astConns[2];
+    TcpFrameReader astReaders[2];
+    void *apvBuffers[2] = { pvResponse, NULL };
+    int aiOpen[2] = { 0, 0 };
+    int iConns = 0;
+    int iWinner = -1;
+    int iResult = -1;
+    int iHedgeDue = 0;
+    int iTimedOut = 0;
+    TcpTimer stHedgeTimer;
+    TcpTimer stDeadlineTimer;
+
+    if (piHedged != NULL) {
+        *piHedged = 0;
+    }
+    depositHedgeTokens(pstClient->pstBudget);
+    if (acquireBackendConn(pstBalancer, kpvKey, uiKeyLength, &astConns[0]) != 0) {
+        return -1;
+    }
+    if (sendFrame(astConns[0].iSock, kpvRequest, uiRequestLength, NULL) < 0) {
+        releaseBackendConn(pstBalancer, &astConns[0], 1);
+        return -1;
+    }
+    aiOpen[0] = 1;
+    iConns = 1;
+    initFrameReader(&astReaders[0]);
+    initFrameReader(&astReaders[1]);
+
+    // 첫 요청 백엔드가 평소라면 응답했을 시간이 지나면 중복 요청
+    unsigned long long ullDelay = getBackendLatency(pstBalancer, astConns[0].iBackend,
+                                                    (double)pstClient->stConfig.uiPercentile);
+    if (ullDelay == 0) {
+        ullDelay = pstClient->stConfig.uiDefaultDelayUsec * 1000ULL;
+    }
+    if (ullDelay < pstClient->stConfig.uiMinDelayUsec * 1000ULL) {
+        ullDelay = pstClient->stConfig.uiMinDelayUsec * 1000ULL;
+    }
+    advanceTimerWheel(&pstClient->stWheel, astConns[0].ullStartNsec);
+    initTimer(&stHedgeTimer, setTimerFlag, &iHedgeDue);
+    initTimer(&stDeadlineTimer, setTimerFlag, &iTimedOut);
+    armTimer(&pstClient->stWheel, &stHedgeTimer, astConns[0].ullStartNsec + ullDelay);
+    if (iTimeoutMsec > 0) {
+        armTimer(&pstClient->stWheel, &stDeadlineTimer, astConns[0].ullStartNsec + (unsigned long long)iTimeoutMsec * 1000000ULL);
+    }
+
+    while (iWinner < 0 && !iTimedOut && (aiOpen[0] || aiOpen[1])) {
+        if (iHedgeDue && iConns == 1) {
+            iHedgeDue = 0;
+            if (takeHedgeToken(pstClient->pstBudget) != 0) {
+                addMetricCounter(TCP_COUNTER_HEDGE_DENIED, 1);
+            } else if (reserveHedgeBuffer(pstClient, uiCapacity) == 0
+                       && acquireOtherBackendConn(pstBalancer, astConns[0].iBackend, &astConns[1]) == 0) {
+                iConns = 2;
+                apvBuffers[1] = pstClient->pvHedgeBuffer;
+                if (sendFrame(astConns[1].iSock, kpvRequest, uiRequestLength, NULL) < 0) {
+                    releaseBackendConn(pstBalancer, &astConns[1], 1);
+                } else {
+                    aiOpen[1] = 1;
+                    addMetricCounter(TCP_COUNTER_HEDGES, 1);
+                    if (piHedged != NULL) {
+                        *piHedged = 1;
+                    }
+                }
+            }
+        }
+
+        struct pollfd astFds[2];
+        int aiIndex[2];
+        int iFds = 0;
+        for (int i = 0; i < 2; i++) {
+            if (aiOpen[i]) {
+                astFds[iFds].fd = astConns[i].iSock;
+                astFds[iFds].events = POLLIN;
+                astFds[iFds].revents = 0;
+                aiIndex[iFds++] = i;
+            }
+        }
+        int iReady = poll(astFds, (nfds_t)iFds, getPollTimeout(&pstClient->stWheel));
+        if (iReady < 0 && errno != EINTR) {
+            perror("poll failed");
+            break;
+        }
+
+        for (int i = 0; i < iFds && iReady > 0 && iWinner < 0; i++) {
+            if (astFds[i].revents == 0) {
+                continue;
+            }
+            // 프레임 중간에서 멈춘 백엔드가 타이머 처리를 막지 않도록 읽을 수 있는 만큼만 받음
+            int iConn = aiIndex[i];
+            int iLength = recvFrameNonBlocking(astConns[iConn].iSock, &astReaders[iConn], apvBuffers[iConn],
+                                               uiCapacity, NULL);
+            if (iLength >= 0) {
+                iWinner = iConn;
+                iResult = iLength;
+            } else if (iLength != TCP_FRAME_PENDING) {
+                releaseBackendConn(pstBalancer, &astConns[iConn], 1);
+                aiOpen[iConn] = 0;
+            }
+        }
+        advanceTimerWheel(&pstClient->stWheel, getMonotonicNsec());
+    }
+    cancelTimer(&pstClient->stWheel, &stHedgeTimer);
+    cancelTimer(&pstClient->stWheel, &stDeadlineTimer);
+
+    // 먼저 온 응답의 연결만 풀로 돌려주고, 아직 응답을 기다리는 요청은 연결을 닫아 취소
+    for (int i = 0; i < 2; i++) {
+        if (!aiOpen[i]) {
+            continue;
+        }
+        if (i == iWinner) {
+            releaseBackendConn(pstBalancer, &astConns[i], 0);
+        } else if (iWinner >= 0) {
+            cancelBackendConn(pstBalancer, &astConns[i]);
+        } else {
+            releaseBackendConn(pstBalancer, &astConns[i], 1);
+        }
+    }
+    if (iWinner == 1) {
+        memcpy(pvResponse, apvBuffers[1], (size_t)iResult);
+        addMetricCounter(TCP_COUNTER_HEDGE_WINS, 1);
+        if (piHedged != NULL) {
+            *piHedged = 2;
+        }
+    }
+    if (iTimedOut && iWinner < 0) {
+        fprintf(stderr, "sendHedgedRequest: timed out after %d ms\n", iTimeoutMsec);
+    }
+    return iResult;
+}
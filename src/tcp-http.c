@@ -0,0 +1,771 @@
+/**
+ * @file tcp-http.c
+ * @brief HTTP/1.1 서버 코덱 구현
+ *
+ * 상태 확인, 메트릭, 간단한 API 엔드포인트용 최소 HTTP/1.1 서버 코덱입니다. 요청은 호출자가
+ * 제공한 수신 버퍼 안에서 해석하여 문자열을 복사하지 않고 가리키기만 하며, 응답은 상태 줄만
+ * 스택에서 만들고 나머지는 iovec으로 묶어 sendMessageV()로 보냅니다. 송수신은 다른 코덱과
+ * 같은 경로(sendMessageV(), recvMsgBlocking())를 쓰므로 연결 통계, 캡처, 장애 시뮬레이션이
+ * 그대로 적용됩니다.
+ *
+ * 주요 기능:
+ * - SIMD(AVX2/SSE2)로 줄 끝과 헤더 구분자를 찾는 요청 줄/헤더 해석
+ * - Content-Length, chunked 본문 수신 (chunked는 수신 버퍼 안에서 이어 붙임)
+ * - 파이프라인 keep-alive 요청 처리와 Expect: 100-continue
+ * - scatter-gather 응답 전송과 chunked 응답
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tcp-http.h"
+#include "tcp-sock.h"
+#include "tcp-cpu.h"
+
+#include <sys/uio.h>
+#include <strings.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCAN_X86   1
+#endif
+
+#define HTTP_ERR_TOO_BIG        -2
+#define HTTP_ERR_INVALID        -3
+
+/**
+ * @brief   Content-Length와 chunk 크기 상한 (이보다 크면 어차피 버퍼에 들어가지 않음)
+ */
+#define HTTP_MAX_LENGTH         (1ULL << 60)
+
+#define HTTP_RESPONSE_CONTINUE  "HTTP/1.1 100 Continue\r\n\r\n"
+
+
+/*
+ * 구분자 탐색
+ *
+ * 헤더 이름 끝(':')과 줄 끝('\r', '\n')을 찾으면서, 같은 비교로 허용되지 않는 제어 문자
+ * (HTAB을 제외한 0x00-0x1f, 0x7f)에서도 멈춥니다. 헤더 이름에서는 공백과 HTAB에서도
+ * 멈춥니다. 멈춘 문자가 기대한 구분자가 아니면 잘못된 요청입니다.
+ */
+static inline int isHttpStop(unsigned char ucChar, int iColon)
+{
+    return (ucChar < 0x20 && ucChar != '\t') || ucChar == 0x7f
+        || (iColon && (ucChar == ':' || ucChar == ' ' || ucChar == '\t'));
+}
+
+#ifdef HTTP_SCAN_X86
+__attribute__((target("avx2")))
+static size_t scanAvx2(const char *kpchData, size_t uiLength, int iColon)
+{
+    const __m256i vCtlMax = _mm256_set1_epi8(0x1f);
+    const __m256i vTab = _mm256_set1_epi8('\t');
+    const __m256i vDel = _mm256_set1_epi8(0x7f);
+    const __m256i vColon = _mm256_set1_epi8(iColon ? ':' : 0x7f);
+    const __m256i vSpace = _mm256_set1_epi8(iColon ? ' ' : 0x7f);
+    const __m256i vNameTab = _mm256_set1_epi8(iColon ? '\t' : 0x7f);
+    size_t i = 0;
+
+    for (; i + 32 <= uiLength; i += 32) {
+        __m256i vData = _mm256_loadu_si256((const __m256i *)(kpchData + i));
+        __m256i vStop = _mm256_cmpeq_epi8(_mm256_max_epu8(vData, vCtlMax), vCtlMax);
+        vStop = _mm256_andnot_si256(_mm256_cmpeq_epi8(vData, vTab), vStop);
+        vStop = _mm256_or_si256(vStop, _mm256_cmpeq_epi8(vData, vDel));
+        vStop = _mm256_or_si256(vStop, _mm256_cmpeq_epi8(vData, vColon));
+        vStop = _mm256_or_si256(vStop, _mm256_cmpeq_epi8(vData, vSpace));
+        vStop = _mm256_or_si256(vStop, _mm256_cmpeq_epi8(vData, vNameTab));
+        unsigned int uiMask = (unsigned int)_mm256_movemask_epi8(vStop);
+        if (uiMask != 0) {
+            return i + (size_t)__builtin_ctz(uiMask);
+        }
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static size_t scanSse2(const char *kpchData, size_t uiLength, int iColon)
+{
+    const __m128i vCtlMax = _mm_set1_epi8(0x1f);
+    const __m128i vTab = _mm_set1_epi8('\t');
+    const __m128i vDel = _mm_set1_epi8(0x7f);
+    const __m128i vColon = _mm_set1_epi8(iColon ? ':' : 0x7f);
+    const __m128i vSpace = _mm_set1_epi8(iColon ? ' ' : 0x7f);
+    const __m128i vNameTab = _mm_set1_epi8(iColon ? '\t' : 0x7f);
+    size_t i = 0;
+
+    for (; i + 16 <= uiLength; i += 16) {
+        __m128i vData = _mm_loadu_si128((const __m128i *)(kpchData + i));
+        __m128i vStop = _mm_cmpeq_epi8(_mm_max_epu8(vData, vCtlMax), vCtlMax);
+        vStop = _mm_andnot_si128(_mm_cmpeq_epi8(vData, vTab), vStop);
+        vStop = _mm_or_si128(vStop, _mm_cmpeq_epi8(vData, vDel));
+        vStop = _mm_or_si128(vStop, _mm_cmpeq_epi8(vData, vColon));
+        vStop = _mm_or_si128(vStop, _mm_cmpeq_epi8(vData, vSpace));
+        vStop = _mm_or_si128(vStop, _mm_cmpeq_epi8(vData, vNameTab));
+        unsigned int uiMask = (unsigned int)_mm_movemask_epi8(vStop);
+        if (uiMask != 0) {
+            return i + (size_t)__builtin_ctz(uiMask);
+        }
+    }
+    return i;
+}
+#endif
+
+/**
+ * @brief 첫 번째 구분자(또는 제어 문자)의 위치를 찾습니다.
+ *
+ * @return 구분자 위치, 없으면 uiLength
+ */
+static size_t scanHttpDelimiter(const char *kpchData, size_t uiLength, int iColon)
+{
+    size_t i = 0;
+
+#ifdef HTTP_SCAN_X86
+    // 벡터 단계가 구분자에서 멈추면 아래 루프가 그 위치에서 바로 끝남
+    if (uiLength >= 16) {
+        i = hasCpuAvx2() ? scanAvx2(kpchData, uiLength, iColon) : 0;
+        i += scanSse2(kpchData + i, uiLength - i, iColon);
+    }
+#endif
+    for (; i < uiLength; i++) {
+        if (isHttpStop((unsigned char)kpchData[i], iColon)) {
+            return i;
+        }
+    }
+    return uiLength;
+}
+
+/**
+ * @brief kpchLine부터 줄 끝을 찾습니다 ("\r\n"과 "\n" 모두 허용).
+ *
+ * @return 성공 시 1 (*ppchEol은 내용 끝, *ppchNext는 다음 줄 시작), 데이터가 부족하면 0,
+ *         줄 안에 제어 문자가 있으면 -1
+ */
+static int findHttpLineEnd(const char *kpchLine, const char *kpchEnd, const char **ppchEol, const char **ppchNext)
+{
+    const char *kpchStop = kpchLine + scanHttpDelimiter(kpchLine, (size_t)(kpchEnd - kpchLine), 0);
+
+    if (kpchStop == kpchEnd) {
+        return 0;
+    }
+    if (*kpchStop == '\n') {
+        *ppchEol = kpchStop;
+        *ppchNext = kpchStop + 1;
+        return 1;
+    }
+    if (*kpchStop != '\r') {
+        return -1;
+    }
+    if (kpchStop + 1 == kpchEnd) {
+        return 0;
+    }
+    if (kpchStop[1] != '\n') {
+        return -1;
+    }
+    *ppchEol = kpchStop;
+    *ppchNext = kpchStop + 2;
+    return 1;
+}
+
+static int equalsHttpName(const TcpHttpStr *kpstName, const char *kpchName, size_t uiName)
+{
+    return kpstName->uiLength == uiName && strncasecmp(kpstName->kpchData, kpchName, uiName) == 0;
+}
+
+/**
+ * @brief 쉼표로 구분한 값의 마지막 토큰을 돌려줍니다.
+ */
+static TcpHttpStr lastHttpToken(const TcpHttpStr *kpstValue)
+{
+    TcpHttpStr stToken;
+    const char *kpchEnd = kpstValue->kpchData + kpstValue->uiLength;
+    const char *kpchStart;
+
+    while (kpchEnd > kpstValue->kpchData && (kpchEnd[-1] == ' ' || kpchEnd[-1] == '\t' || kpchEnd[-1] == ',')) {
+        kpchEnd--;
+    }
+    kpchStart = kpchEnd;
+    while (kpchStart > kpstValue->kpchData && kpchStart[-1] != ',') {
+        kpchStart--;
+    }
+    while (kpchStart < kpchEnd && (*kpchStart == ' ' || *kpchStart == '\t')) {
+        kpchStart++;
+    }
+    stToken.kpchData = kpchStart;
+    stToken.uiLength = (size_t)(kpchEnd - kpchStart);
+    return stToken;
+}
+
+static int parseHttpDecimal(const TcpHttpStr *kpstValue, unsigned long long *pullValue)
+{
+    unsigned long long ullValue = 0;
+
+    if (kpstValue->uiLength == 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < kpstValue->uiLength; i++) {
+        char chDigit = kpstValue->kpchData[i];
+        if (chDigit < '0' || chDigit > '9') {
+            return -1;
+        }
+        ullValue = ullValue * 10 + (unsigned long long)(chDigit - '0');
+        if (ullValue > HTTP_MAX_LENGTH) {
+            return -1;
+        }
+    }
+    *pullValue = ullValue;
+    return 0;
+}
+
+
+int hasHttpToken(const TcpHttpStr *kpstValue, const char *kpchToken)
+{
+    const char *kpchValue = kpstValue->kpchData;
+    size_t uiLength = kpstValue->uiLength;
+    size_t uiToken = strlen(kpchToken);
+    size_t i = 0;
+
+    while (i < uiLength) {
+        while (i < uiLength && (kpchValue[i] == ' ' || kpchValue[i] == '\t' || kpchValue[i] == ',')) {
+            i++;
+        }
+        size_t uiStart = i;
+        while (i < uiLength && kpchValue[i] != ',') {
+            i++;
+        }
+        size_t uiEnd = i;
+        while (uiEnd > uiStart && (kpchValue[uiEnd - 1] == ' ' || kpchValue[uiEnd - 1] == '\t')) {
+            uiEnd--;
+        }
+        if (uiEnd - uiStart == uiToken && strncasecmp(kpchValue + uiStart, kpchToken, uiToken) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int parseHttpRequest(const void *kpvData, size_t uiLength, TcpHttpRequest *pstRequest)
+{
+    const char *kpchBegin = (const char *)kpvData;
+    const char *kpchEnd = kpchBegin + uiLength;
+    const char *kpchCur = kpchBegin;
+    const char *kpchEol;
+    const char *kpchNext;
+    int iConnectionClose = 0;
+    int iConnectionKeepAlive = 0;
+    int iContentLength = 0;
+    int iResult;
+
+    pstRequest->iHeaders = 0;
+    pstRequest->stBody.kpchData = NULL;
+    pstRequest->stBody.uiLength = 0;
+    pstRequest->ullContentLength = 0;
+    pstRequest->ucChunked = 0;
+    pstRequest->ucExpectContinue = 0;
+
+    // 앞선 요청 본문 뒤에 붙은 빈 줄은 건너뜀
+    while (kpchCur < kpchEnd && (*kpchCur == '\r' || *kpchCur == '\n')) {
+        if (*kpchCur == '\r') {
+            if (kpchCur + 1 == kpchEnd) {
+                return 0;
+            }
+            if (kpchCur[1] != '\n') {
+                return -1;
+            }
+            kpchCur++;
+        }
+        kpchCur++;
+    }
+
+    // 요청 줄: <메서드> <대상> HTTP/1.<x>
+    if ((iResult = findHttpLineEnd(kpchCur, kpchEnd, &kpchEol, &kpchNext)) <= 0) {
+        return iResult;
+    }
+    const char *kpchMethodEnd = (const char *)memchr(kpchCur, ' ', (size_t)(kpchEol - kpchCur));
+    if (kpchMethodEnd == NULL || kpchMethodEnd == kpchCur) {
+        return -1;
+    }
+    const char *kpchTarget = kpchMethodEnd + 1;
+    const char *kpchTargetEnd = (const char *)memchr(kpchTarget, ' ', (size_t)(kpchEol - kpchTarget));
+    if (kpchTargetEnd == NULL || kpchTargetEnd == kpchTarget) {
+        return -1;
+    }
+    if (kpchEol - kpchTargetEnd != 9 || strncmp(kpchTargetEnd + 1, "HTTP/1.", 7) != 0
+        || (kpchTargetEnd[8] != '0' && kpchTargetEnd[8] != '1')) {
+        return -1;
+    }
+    pstRequest->stMethod.kpchData = kpchCur;
+    pstRequest->stMethod.uiLength = (size_t)(kpchMethodEnd - kpchCur);
+    pstRequest->stTarget.kpchData = kpchTarget;
+    pstRequest->stTarget.uiLength = (size_t)(kpchTargetEnd - kpchTarget);
+    pstRequest->iMinorVersion = kpchTargetEnd[8] - '0';
+    kpchCur = kpchNext;
+
+    // 헤더 줄: <이름>:<공백><값><공백>
+    for (;;) {
+        if (kpchCur == kpchEnd) {
+            return 0;
+        }
+        if (*kpchCur == '\r' || *kpchCur == '\n') {
+            if ((iResult = findHttpLineEnd(kpchCur, kpchEnd, &kpchEol, &kpchNext)) <= 0) {
+                return iResult;
+            }
+            kpchCur = kpchNext;
+            break;
+        }
+        if (*kpchCur == ' ' || *kpchCur == '\t') {
+            return -1;      // obs-fold는 허용하지 않음
+        }
+        if (pstRequest->iHeaders == TCP_HTTP_MAX_HEADERS) {
+            return TCP_HTTP_ERR_TOO_MANY_HEADERS;
+        }
+
+        const char *kpchColon = kpchCur + scanHttpDelimiter(kpchCur, (size_t)(kpchEnd - kpchCur), 1);
+        if (kpchColon == kpchEnd) {
+            return 0;
+        }
+        if (*kpchColon != ':' || kpchColon == kpchCur) {
+            return -1;
+        }
+        const char *kpchValue = kpchColon + 1;
+        while (kpchValue < kpchEnd && (*kpchValue == ' ' || *kpchValue == '\t')) {
+            kpchValue++;
+        }
+        if ((iResult = findHttpLineEnd(kpchValue, kpchEnd, &kpchEol, &kpchNext)) <= 0) {
+            return iResult;
+        }
+        while (kpchEol > kpchValue && (kpchEol[-1] == ' ' || kpchEol[-1] == '\t')) {
+            kpchEol--;
+        }
+
+        TcpHttpHeader *pstHeader = &pstRequest->astHeaders[pstRequest->iHeaders++];
+        pstHeader->stName.kpchData = kpchCur;
+        pstHeader->stName.uiLength = (size_t)(kpchColon - kpchCur);
+        pstHeader->stValue.kpchData = kpchValue;
+        pstHeader->stValue.uiLength = (size_t)(kpchEol - kpchValue);
+        kpchCur = kpchNext;
+
+        // 본문 길이와 연결 유지에 관련된 헤더
+        if (equalsHttpName(&pstHeader->stName, "Content-Length", 14)) {
+            unsigned long long ullLength;
+            if (parseHttpDecimal(&pstHeader->stValue, &ullLength) != 0
+                || (iContentLength && ullLength != pstRequest->ullContentLength)) {
+                return -1;
+            }
+            pstRequest->ullContentLength = ullLength;
+            iContentLength = 1;
+        } else if (equalsHttpName(&pstHeader->stName, "Transfer-Encoding", 17)) {
+            TcpHttpStr stCoding = lastHttpToken(&pstHeader->stValue);
+            if (stCoding.uiLength != 7 || strncasecmp(stCoding.kpchData, "chunked", 7) != 0) {
+                return -1;
+            }
+            pstRequest->ucChunked = 1;
+        } else if (equalsHttpName(&pstHeader->stName, "Connection", 10)) {
+            iConnectionClose |= hasHttpToken(&pstHeader->stValue, "close");
+            iConnectionKeepAlive |= hasHttpToken(&pstHeader->stValue, "keep-alive");
+        } else if (equalsHttpName(&pstHeader->stName, "Expect", 6)) {
+            pstRequest->ucExpectContinue = (pstHeader->stValue.uiLength == 12
+                                            && strncasecmp(pstHeader->stValue.kpchData, "100-continue", 12) == 0);
+        }
+    }
+
+    // 두 방식이 함께 오면 중간 장비와 본문 경계를 다르게 볼 수 있으므로 거부
+    if (pstRequest->ucChunked && iContentLength) {
+        return -1;
+    }
+    if (pstRequest->iMinorVersion >= 1) {
+        pstRequest->ucKeepAlive = (unsigned char)!iConnectionClose;
+    } else {
+        pstRequest->ucKeepAlive = (unsigned char)(iConnectionKeepAlive && !iConnectionClose);
+    }
+    return (int)(kpchCur - kpchBegin);
+}
+
+const TcpHttpStr *findHttpHeader(const TcpHttpRequest *kpstRequest, const char *kpchName)
+{
+    size_t uiName = strlen(kpchName);
+
+    for (int i = 0; i < kpstRequest->iHeaders; i++) {
+        if (equalsHttpName(&kpstRequest->astHeaders[i].stName, kpchName, uiName)) {
+            return &kpstRequest->astHeaders[i].stValue;
+        }
+    }
+    return NULL;
+}
+
+const char *getHttpReason(int iStatus)
+{
+    switch (iStatus) {
+    case 100: return "Continue";
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 411: return "Length Required";
+    case 413: return "Content Too Large";
+    case 426: return "Upgrade Required";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default:  return "Unknown";
+    }
+}
+
+
+/*
+ * 연결 상태와 수신 버퍼
+ */
+void initHttpConn(TcpHttpConn *pstConn, int iSock, void *pvBuffer, size_t uiCapacity)
+{
+    memset(pstConn, 0, sizeof(*pstConn));
+    pstConn->iSock = iSock;
+    pstConn->pchBuffer = (char *)pvBuffer;
+    pstConn->uiCapacity = uiCapacity;
+}
+
+/**
+ * @brief 요청 시작부터 uiNeeded 바이트가 들어갈 자리를 만들고 한 번 수신합니다.
+ *
+ * @return 수신한 바이트 수, 연결 종료 시 TCP_DISCONNECTION, 자리가 없으면 HTTP_ERR_TOO_BIG, 실패 시 -1
+ */
+static int fillHttpBuffer(TcpHttpConn *pstConn, size_t uiNeeded)
+{
+    if (uiNeeded > pstConn->uiCapacity) {
+        return HTTP_ERR_TOO_BIG;
+    }
+    if (pstConn->uiStart + uiNeeded > pstConn->uiCapacity) {
+        // 처리 중인 요청과 뒤따르는 파이프라인 요청을 버퍼 앞쪽으로 당김
+        size_t uiPending = pstConn->uiEnd - pstConn->uiStart;
+        memmove(pstConn->pchBuffer, pstConn->pchBuffer + pstConn->uiStart, uiPending);
+        pstConn->uiStart = 0;
+        pstConn->uiEnd = uiPending;
+    }
+
+    int iReceived = recvMsgBlocking(pstConn->iSock, pstConn->pchBuffer + pstConn->uiEnd,
+                                    pstConn->uiCapacity - pstConn->uiEnd);
+    if (iReceived > 0) {
+        pstConn->uiEnd += (size_t)iReceived;
+    }
+    return iReceived;
+}
+
+static int sendHttpRaw(int iSock, const char *kpchData)
+{
+    struct iovec stIov;
+
+    stIov.iov_base = (void *)kpchData;
+    stIov.iov_len = strlen(kpchData);
+    return sendMessageV(iSock, &stIov, 1);
+}
+
+/**
+ * @brief 요청 시작에서 uiOffset 위치의 줄이 끝날 때까지 수신합니다.
+ *
+ * @return 성공 시 1 (*puiEol, *puiNext는 요청 시작 기준 위치), 그 밖에는 수신/오류 코드
+ */
+static int fillHttpLine(TcpHttpConn *pstConn, size_t uiOffset, size_t *puiEol, size_t *puiNext)
+{
+    for (;;) {
+        const char *kpchBase = pstConn->pchBuffer + pstConn->uiStart;
+        const char *kpchEol;
+        const char *kpchNext;
+        int iResult = findHttpLineEnd(kpchBase + uiOffset, pstConn->pchBuffer + pstConn->uiEnd, &kpchEol, &kpchNext);
+        if (iResult > 0) {
+            *puiEol = (size_t)(kpchEol - kpchBase);
+            *puiNext = (size_t)(kpchNext - kpchBase);
+            return 1;
+        }
+        if (iResult < 0) {
+            return HTTP_ERR_INVALID;
+        }
+        int iReceived = fillHttpBuffer(pstConn, pstConn->uiEnd - pstConn->uiStart + 1);
+        if (iReceived <= 0) {
+            return iReceived;
+        }
+    }
+}
+
+/**
+ * @brief chunked 본문을 수신하며 조각 데이터를 헤더 바로 뒤로 이어 붙입니다.
+ *
+ * @details 모든 위치는 요청 시작 기준이므로 수신 중 버퍼를 당겨도 그대로 유효합니다.
+ *
+ * @return 성공 시 1, 그 밖에는 수신/오류 코드
+ */
+static int recvHttpChunked(TcpHttpConn *pstConn, size_t uiHeader, size_t *puiRequest, size_t *puiBody)
+{
+    size_t uiRaw = uiHeader;
+    size_t uiBody = uiHeader;
+    size_t uiEol;
+    size_t uiNext;
+    int iResult;
+
+    for (;;) {
+        // 조각 크기 줄: <16진수>[;확장]
+        if ((iResult = fillHttpLine(pstConn, uiRaw, &uiEol, &uiNext)) <= 0) {
+            return iResult;
+        }
+        const char *kpchLine = pstConn->pchBuffer + pstConn->uiStart + uiRaw;
+        size_t uiLine = uiEol - uiRaw;
+        unsigned long long ullChunk = 0;
+        size_t i = 0;
+        for (; i < uiLine; i++) {
+            char chDigit = kpchLine[i];
+            int iDigit;
+            if (chDigit >= '0' && chDigit <= '9') {
+                iDigit = chDigit - '0';
+            } else if ((chDigit | 0x20) >= 'a' && (chDigit | 0x20) <= 'f') {
+                iDigit = (chDigit | 0x20) - 'a' + 10;
+            } else {
+                break;
+            }
+            ullChunk = (ullChunk << 4) | (unsigned long long)iDigit;
+            if (ullChunk > HTTP_MAX_LENGTH) {
+                return HTTP_ERR_TOO_BIG;
+            }
+        }
+        size_t uiDigits = i;
+        while (i < uiLine && (kpchLine[i] == ' ' || kpchLine[i] == '\t')) {
+            i++;
+        }
+        if (uiDigits == 0 || (i < uiLine && kpchLine[i] != ';')) {
+            return HTTP_ERR_INVALID;
+        }
+        uiRaw = uiNext;
+
+        if (ullChunk == 0) {
+            break;
+        }
+        if (ullChunk > pstConn->uiCapacity) {
+            return HTTP_ERR_TOO_BIG;
+        }
+
+        size_t uiChunk = (size_t)ullChunk;
+        while (pstConn->uiEnd - pstConn->uiStart < uiRaw + uiChunk + 2) {
+            int iReceived = fillHttpBuffer(pstConn, uiRaw + uiChunk + 2);
+            if (iReceived <= 0) {
+                return iReceived;
+            }
+        }
+        char *pchBase = pstConn->pchBuffer + pstConn->uiStart;
+        if (pchBase[uiRaw + uiChunk] != '\r' || pchBase[uiRaw + uiChunk + 1] != '\n') {
+            return HTTP_ERR_INVALID;
+        }
+        memmove(pchBase + uiBody, pchBase + uiRaw, uiChunk);
+        uiBody += uiChunk;
+        uiRaw += uiChunk + 2;
+    }
+
+    // 트레일러는 빈 줄까지 건너뜀
+    for (;;) {
+        if ((iResult = fillHttpLine(pstConn, uiRaw, &uiEol, &uiNext)) <= 0) {
+            return iResult;
+        }
+        int iEmpty = (uiEol == uiRaw);
+        uiRaw = uiNext;
+        if (iEmpty) {
+            break;
+        }
+    }
+
+    *puiRequest = uiRaw;
+    *puiBody = uiBody - uiHeader;
+    return 1;
+}
+
+static int failHttpRecv(TcpHttpConn *pstConn, int iResult, int iHeaderComplete)
+{
+    const char *kpchResponse;
+
+    if (iResult == HTTP_ERR_TOO_BIG) {
+        fprintf(stderr, "recvHttpRequest: request larger than %zu bytes\n", pstConn->uiCapacity);
+        kpchResponse = iHeaderComplete
+                       ? "HTTP/1.1 413 Content Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n"
+                       : "HTTP/1.1 431 Request Header Fields Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+    } else if (iResult == TCP_HTTP_ERR_TOO_MANY_HEADERS) {
+        fprintf(stderr, "recvHttpRequest: more than %d headers\n", TCP_HTTP_MAX_HEADERS);
+        kpchResponse = "HTTP/1.1 431 Request Header Fields Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+    } else if (iResult == HTTP_ERR_INVALID) {
+        fprintf(stderr, "recvHttpRequest: malformed request\n");
+        kpchResponse = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+    } else {
+        return iResult;
+    }
+    sendHttpRaw(pstConn->iSock, kpchResponse);
+    return -1;
+}
+
+int recvHttpRequest(TcpHttpConn *pstConn, TcpHttpRequest *pstRequest)
+{
+    int iHeader;
+
+    // 직전에 돌려준 요청은 이제 버림
+    pstConn->uiStart += pstConn->uiConsumed;
+    pstConn->uiConsumed = 0;
+    if (pstConn->uiStart == pstConn->uiEnd) {
+        pstConn->uiStart = 0;
+        pstConn->uiEnd = 0;
+    }
+
+    for (;;) {
+        iHeader = parseHttpRequest(pstConn->pchBuffer + pstConn->uiStart, pstConn->uiEnd - pstConn->uiStart,
+                                   pstRequest);
+        if (iHeader != 0) {
+            break;
+        }
+        int iReceived = fillHttpBuffer(pstConn, pstConn->uiEnd - pstConn->uiStart + 1);
+        if (iReceived <= 0) {
+            return failHttpRecv(pstConn, iReceived, 0);
+        }
+    }
+    if (iHeader < 0) {
+        return failHttpRecv(pstConn, (iHeader == -1) ? HTTP_ERR_INVALID : iHeader, 0);
+    }
+
+    const char *kpchParsed = pstConn->pchBuffer + pstConn->uiStart;
+    size_t uiHeader = (size_t)iHeader;
+    size_t uiRequest = uiHeader;
+    size_t uiBody = 0;
+    int iWaitBody = pstRequest->ucChunked || pstRequest->ullContentLength > 0;
+
+    if (!pstRequest->ucChunked && pstRequest->ullContentLength > pstConn->uiCapacity - uiHeader) {
+        return failHttpRecv(pstConn, HTTP_ERR_TOO_BIG, 1);
+    }
+    if (iWaitBody && pstRequest->ucExpectContinue && pstConn->uiEnd - pstConn->uiStart == uiHeader) {
+        if (sendHttpRaw(pstConn->iSock, HTTP_RESPONSE_CONTINUE) < 0) {
+            return -1;
+        }
+    }
+
+    if (pstRequest->ucChunked) {
+        int iResult = recvHttpChunked(pstConn, uiHeader, &uiRequest, &uiBody);
+        if (iResult <= 0) {
+            return failHttpRecv(pstConn, iResult, 1);
+        }
+    } else {
+        uiBody = (size_t)pstRequest->ullContentLength;
+        uiRequest = uiHeader + uiBody;
+        while (pstConn->uiEnd - pstConn->uiStart < uiRequest) {
+            int iReceived = fillHttpBuffer(pstConn, uiRequest);
+            if (iReceived <= 0) {
+                return failHttpRecv(pstConn, iReceived, 1);
+            }
+        }
+    }
+
+    // 수신 중 버퍼를 당겼으면 헤더 위치를 다시 잡음 (헤더 영역은 바뀌지 않았으므로 결과는 같음)
+    if (pstConn->pchBuffer + pstConn->uiStart != kpchParsed) {
+        parseHttpRequest(pstConn->pchBuffer + pstConn->uiStart, uiHeader, pstRequest);
+    }
+    pstRequest->stBody.kpchData = pstConn->pchBuffer + pstConn->uiStart + uiHeader;
+    pstRequest->stBody.uiLength = uiBody;
+    pstConn->uiConsumed = uiRequest;
+    return (int)uiRequest;
+}
+
+
+/*
+ * 응답 전송
+ */
+int sendHttpResponse(int iSock, int iStatus, const TcpHttpHeader *kpstHeaders, int iHeaders,
+                     const void *kpvBody, size_t uiLength, int iFlags)
+{
+    static const char s_kachSeparator[] = ": ";
+    static const char s_kachCrlf[] = "\r\n";
+    struct iovec astIov[TCP_IOV_MAX];
+    char achStatus[128];
+    char achChunk[24];
+    int iIov = 0;
+    int iStatusLength;
+
+    if (iHeaders < 0 || iHeaders > TCP_HTTP_MAX_RESPONSE_HEADERS) {
+        fprintf(stderr, "sendHttpResponse: invalid header count %d\n", iHeaders);
+        return -1;
+    }
+
+    int iNoBody = (iStatus < 200 || iStatus == 204 || iStatus == 304);
+    if (iNoBody) {
+        uiLength = 0;
+        iStatusLength = snprintf(achStatus, sizeof(achStatus), "HTTP/1.1 %d %s\r\n%s", iStatus,
+                                 getHttpReason(iStatus), (iFlags & TCP_HTTP_CLOSE) ? "Connection: close\r\n" : "");
+    } else if (iFlags & TCP_HTTP_CHUNKED) {
+        iStatusLength = snprintf(achStatus, sizeof(achStatus), "HTTP/1.1 %d %s\r\nTransfer-Encoding: chunked\r\n%s",
+                                 iStatus, getHttpReason(iStatus),
+                                 (iFlags & TCP_HTTP_CLOSE) ? "Connection: close\r\n" : "");
+    } else {
+        iStatusLength = snprintf(achStatus, sizeof(achStatus), "HTTP/1.1 %d %s\r\nContent-Length: %zu\r\n%s",
+                                 iStatus, getHttpReason(iStatus), uiLength,
+                                 (iFlags & TCP_HTTP_CLOSE) ? "Connection: close\r\n" : "");
+    }
+    astIov[iIov].iov_base = achStatus;
+    astIov[iIov++].iov_len = (size_t)iStatusLength;
+
+    for (int i = 0; i < iHeaders; i++) {
+        astIov[iIov].iov_base = (void *)kpstHeaders[i].stName.kpchData;
+        astIov[iIov++].iov_len = kpstHeaders[i].stName.uiLength;
+        astIov[iIov].iov_base = (void *)s_kachSeparator;
+        astIov[iIov++].iov_len = 2;
+        astIov[iIov].iov_base = (void *)kpstHeaders[i].stValue.kpchData;
+        astIov[iIov++].iov_len = kpstHeaders[i].stValue.uiLength;
+        astIov[iIov].iov_base = (void *)s_kachCrlf;
+        astIov[iIov++].iov_len = 2;
+    }
+    astIov[iIov].iov_base = (void *)s_kachCrlf;
+    astIov[iIov++].iov_len = 2;
+
+    if (uiLength > 0) {
+        if (iFlags & TCP_HTTP_CHUNKED) {
+            astIov[iIov].iov_base = achChunk;
+            astIov[iIov++].iov_len = (size_t)snprintf(achChunk, sizeof(achChunk), "%zx\r\n", uiLength);
+        }
+        astIov[iIov].iov_base = (void *)kpvBody;
+        astIov[iIov++].iov_len = uiLength;
+        if (iFlags & TCP_HTTP_CHUNKED) {
+            astIov[iIov].iov_base = (void *)s_kachCrlf;
+            astIov[iIov++].iov_len = 2;
+        }
+    }
+
+    if (sendMessageV(iSock, astIov, iIov) < 0) {
+        return -1;
+    }
+    return (int)uiLength;
+}
+
+int sendHttpChunk(int iSock, const void *kpvData, size_t uiLength)
+{
+    static const char s_kachCrlf[] = "\r\n";
+    struct iovec astIov[3];
+    char achChunk[24];
+    int iIov = 0;
+
+    if (uiLength == 0) {
+        return (sendHttpRaw(iSock, "0\r\n\r\n") < 0) ? -1 : 0;
+    }
+    astIov[iIov].iov_base = achChunk;
+    astIov[iIov++].iov_len = (size_t)snprintf(achChunk, sizeof(achChunk), "%zx\r\n", uiLength);
+    astIov[iIov].iov_base = (void *)kpvData;
+    astIov[iIov++].iov_len = uiLength;
+    astIov[iIov].iov_base = (void *)s_kachCrlf;
+    astIov[iIov++].iov_len = 2;
+
+    if (sendMessageV(iSock, astIov, iIov) < 0) {
+        return -1;
+    }
+    return (int)uiLength;
+}
@@ -0,0 +1,500 @@
+/**
+ * @file tcp-impair.c
+ * @brief 디버그용 네트워크 장애 시뮬레이터 구현
+ *
+ * tc(netem)를 쓸 수 없는 환경에서 프레이밍, 타임아웃, 역압(backpressure) 동작을 시험하기 위해
+ * 송수신 경로에 지연, 지터, 대역폭 한도, 부분 쓰기/읽기, 멈춤을 주입합니다.
+ * 송신 데이터는 연결별 대기열에 복사되고, 장애 스레드가 타이밍 휠로 만료 시각을 관리하여
+ * 실제 전송합니다.
+ *
+ * 주요 기능:
+ * - 설정 문자열 해석
+ * - 연결별 전송 대기열과 대역폭/지연 계산
+ * - 타이밍 휠 기반 장애 스레드
+ * - 수신 부분 읽기와 멈춤
+ */
+#include "tcp-impair.h"
+#include "tcp-conn.h"
+#include "tcp-metrics.h"
+#include "tcp-timer.h"
+
+#include <sys/socket.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct ImpairChunk {
+    struct ImpairChunk *pstNext;
+    unsigned long long ullDueNsec;      /**< 전송 가능 시각 */
+    size_t uiLength;
+    size_t uiOffset;                    /**< 이미 전송한 바이트 수 */
+    unsigned char *pucData;
+} ImpairChunk;
+
+typedef struct TcpImpairState {
+    TcpImpairment stConfig;
+    int iSock;
+    int iError;                         /**< 실제 전송 실패 시 errno */
+    TcpTimer stTimer;
+    ImpairChunk *pstHead;
+    ImpairChunk *pstTail;
+    size_t uiQueued;                    /**< 대기열의 미전송 바이트 수 */
+    unsigned long long ullLinkFreeNsec; /**< 대역폭 한도상 다음 데이터가 전송을 시작할 수 있는 시각 */
+    unsigned long long ullLastDueNsec;  /**< 마지막 데이터의 전송 시각 (순서 유지) */
+    int iUsers;                         /**< 상태를 사용 중인 송신 스레드 수 */
+    int iClosing;                       /**< 해제 중이면 1 (새 송신은 해제가 끝날 때까지 대기) */
+} TcpImpairState;
+
+static pthread_mutex_t g_stImpairLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_stImpairWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_stImpairDrain = PTHREAD_COND_INITIALIZER;
+static TcpTimerWheel g_stImpairWheel;
+static int g_iImpairWheelReady;
+static int g_iImpairThreadRunning;
+static int g_iImpairedConns;
+
+static __thread unsigned int t_uiImpairSeed;
+
+
+static unsigned int nextImpairRandom(void)
+{
+    if (t_uiImpairSeed == 0) {
+        t_uiImpairSeed = (unsigned int)getMonotonicNsec() | 1;
+    }
+    // xorshift32
+    t_uiImpairSeed ^= t_uiImpairSeed << 13;
+    t_uiImpairSeed ^= t_uiImpairSeed >> 17;
+    t_uiImpairSeed ^= t_uiImpairSeed << 5;
+    return t_uiImpairSeed;
+}
+
+static void stallIfDrawn(const TcpImpairment *kpstConfig)
+{
+    if (kpstConfig->uiStallPermille > 0 && kpstConfig->uiStallUsec > 0
+        && nextImpairRandom() % 1000 < kpstConfig->uiStallPermille) {
+        usleep(kpstConfig->uiStallUsec);
+    }
+}
+
+static void freeImpairChunks(TcpImpairState *pstState)
+{
+    ImpairChunk *pstChunk = pstState->pstHead;
+    while (pstChunk != NULL) {
+        ImpairChunk *pstNext = pstChunk->pstNext;
+        free(pstChunk);
+        pstChunk = pstNext;
+    }
+    pstState->pstHead = NULL;
+    pstState->pstTail = NULL;
+    pstState->uiQueued = 0;
+}
+
+/**
+ * @brief 연결의 장애 상태를 사용 등록합니다 (잠금 보유).
+ *
+ * 해제 중인 상태이면 해제가 끝날 때까지 기다리며, 대기할 때마다 연결의 상태 포인터를 다시 읽습니다.
+ *
+ * @return 사용 등록한 상태, 장애가 설정되어 있지 않으면 NULL
+ */
+static TcpImpairState *acquireImpairState(TcpConnInfo *pstConn)
+{
+    TcpImpairState *pstState = pstConn->pstImpair;
+    while (pstState != NULL && pstState->iClosing) {
+        pthread_cond_wait(&g_stImpairDrain, &g_stImpairLock);
+        pstState = pstConn->pstImpair;
+    }
+    if (pstState != NULL) {
+        pstState->iUsers++;
+    }
+    return pstState;
+}
+
+/**
+ * @brief acquireImpairState()의 사용 등록을 해제합니다 (잠금 보유).
+ */
+static void putImpairState(TcpImpairState *pstState)
+{
+    pstState->iUsers--;
+    if (pstState->iClosing && pstState->iUsers == 0) {
+        pthread_cond_broadcast(&g_stImpairDrain);
+    }
+}
+
+/**
+ * @brief 사용 중인 송신 스레드가 모두 빠져나간 뒤 장애 상태를 연결에서 떼어냅니다 (잠금 보유).
+ *
+ * 호출자는 먼저 iClosing을 설정해야 하며, 반환 후 잠금을 푼 다음 상태를 해제합니다.
+ */
+static void detachImpairState(TcpConnInfo *pstConn, TcpImpairState *pstState)
+{
+    pthread_cond_broadcast(&g_stImpairDrain);
+    while (pstState->iUsers > 0) {
+        pthread_cond_wait(&g_stImpairDrain, &g_stImpairLock);
+    }
+    cancelTimer(&g_stImpairWheel, &pstState->stTimer);
+    __atomic_store_n(&pstConn->pstImpair, (TcpImpairState *)NULL, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&g_iImpairedConns, 1, __ATOMIC_RELAXED);
+    // 해제를 기다리던 송신 스레드를 깨워 일반 전송으로 돌아가게 함
+    pthread_cond_broadcast(&g_stImpairDrain);
+}
+
+/**
+ * @brief 만료된 데이터를 실제로 전송합니다 (장애 스레드, 잠금 보유).
+ *
+ * 소켓 버퍼가 가득 차면 다음 틱에 다시 시도하고, 남은 데이터가 있으면 가장 앞 데이터의
+ * 전송 시각으로 타이머를 다시 설정합니다.
+ */
+static void flushImpairQueue(TcpTimer *pstTimer, void *pvArg)
+{
+    TcpImpairState *pstState = (TcpImpairState *)pvArg;
+    unsigned long long ullNow = getMonotonicNsec();
+    (void)pstTimer;
+
+    while (pstState->pstHead != NULL && pstState->pstHead->ullDueNsec <= ullNow) {
+        ImpairChunk *pstChunk = pstState->pstHead;
+        ssize_t sent = send(pstState->iSock, pstChunk->pucData + pstChunk->uiOffset,
+                            pstChunk->uiLength - pstChunk->uiOffset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                armTimer(&g_stImpairWheel, &pstState->stTimer, ullNow + g_stImpairWheel.ullTickNsec);
+                return;
+            }
+            pstState->iError = errno;
+            freeImpairChunks(pstState);
+            break;
+        }
+        pstChunk->uiOffset += (size_t)sent;
+        pstState->uiQueued -= (size_t)sent;
+        if (pstChunk->uiOffset < pstChunk->uiLength) {
+            continue;
+        }
+        pstState->pstHead = pstChunk->pstNext;
+        if (pstState->pstHead == NULL) {
+            pstState->pstTail = NULL;
+        }
+        free(pstChunk);
+    }
+
+    if (pstState->pstHead != NULL) {
+        armTimer(&g_stImpairWheel, &pstState->stTimer, pstState->pstHead->ullDueNsec);
+    }
+    pthread_cond_broadcast(&g_stImpairDrain);
+}
+
+static void *runImpairThread(void *pvArg)
+{
+    (void)pvArg;
+
+    pthread_mutex_lock(&g_stImpairLock);
+    while (__atomic_load_n(&g_iImpairedConns, __ATOMIC_RELAXED) > 0 || g_stImpairWheel.uiArmed > 0) {
+        advanceTimerWheel(&g_stImpairWheel, getMonotonicNsec());
+
+        unsigned long long ullNext = getNextTimerExpiry(&g_stImpairWheel);
+        unsigned long long ullNow = getMonotonicNsec();
+        if (ullNext != 0 && ullNext <= ullNow) {
+            continue;
+        }
+
+        // 대기열이 비어 있으면 새 데이터가 들어올 때까지 기다림 (최대 100ms마다 종료 조건 확인)
+        unsigned long long ullWait = (ullNext != 0) ? ullNext - ullNow : 100000000ULL;
+        struct timespec stDeadline;
+        clock_gettime(CLOCK_REALTIME, &stDeadline);
+        stDeadline.tv_sec += (time_t)(ullWait / 1000000000ULL);
+        stDeadline.tv_nsec += (long)(ullWait % 1000000000ULL);
+        if (stDeadline.tv_nsec >= 1000000000L) {
+            stDeadline.tv_sec++;
+            stDeadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&g_stImpairWake, &g_stImpairLock, &stDeadline);
+    }
+    g_iImpairThreadRunning = 0;
+    pthread_mutex_unlock(&g_stImpairLock);
+    return NULL;
+}
+
+/**
+ * @brief 타이밍 휠과 장애 스레드를 준비합니다 (잠금 보유).
+ */
+static int ensureImpairThread(void)
+{
+    if (!g_iImpairWheelReady) {
+        if (initTimerWheel(&g_stImpairWheel, 0, 0, getMonotonicNsec()) < 0) {
+            fprintf(stderr, "impairment timer wheel init failed\n");
+            return -1;
+        }
+        g_iImpairWheelReady = 1;
+    }
+    if (g_iImpairThreadRunning) {
+        return 0;
+    }
+
+    pthread_t stThread;
+    if (pthread_create(&stThread, NULL, runImpairThread, NULL) != 0) {
+        perror("pthread_create failed");
+        return -1;
+    }
+    pthread_detach(stThread);
+    g_iImpairThreadRunning = 1;
+    return 0;
+}
+
+
+int parseImpairment(const char *kpchSpec, TcpImpairment *pstImpair)
+{
+    char achBuffer[256];
+
+    memset(pstImpair, 0, sizeof(*pstImpair));
+    if (kpchSpec == NULL) {
+        return 0;
+    }
+    strncpy(achBuffer, kpchSpec, sizeof(achBuffer) - 1);
+    achBuffer[sizeof(achBuffer) - 1] = '\0';
+
+    char *pchSave = NULL;
+    for (char *pchItem = strtok_r(achBuffer, ",", &pchSave); pchItem != NULL;
+         pchItem = strtok_r(NULL, ",", &pchSave)) {
+        char *pchValue = strchr(pchItem, '=');
+        if (pchValue == NULL) {
+            fprintf(stderr, "invalid impairment item: %s\n", pchItem);
+            return -1;
+        }
+        *pchValue++ = '\0';
+
+        unsigned long long ullValue = strtoull(pchValue, NULL, 10);
+        if (strcmp(pchItem, "delay") == 0) {
+            pstImpair->uiDelayUsec = (unsigned int)ullValue;
+        } else if (strcmp(pchItem, "jitter") == 0) {
+            pstImpair->uiJitterUsec = (unsigned int)ullValue;
+        } else if (strcmp(pchItem, "rate") == 0) {
+            pstImpair->ullRateBytes = ullValue;
+        } else if (strcmp(pchItem, "write") == 0) {
+            pstImpair->uiMaxWrite = (unsigned int)ullValue;
+        } else if (strcmp(pchItem, "read") == 0) {
+            pstImpair->uiMaxRead = (unsigned int)ullValue;
+        } else if (strcmp(pchItem, "queue") == 0) {
+            pstImpair->uiQueueLimit = (unsigned int)ullValue;
+        } else if (strcmp(pchItem, "stall") == 0) {
+            const char *kpchUsec = strchr(pchValue, ':');
+            pstImpair->uiStallPermille = (unsigned int)ullValue;
+            pstImpair->uiStallUsec = (kpchUsec != NULL) ? (unsigned int)strtoul(kpchUsec + 1, NULL, 10) : 0;
+        } else {
+            fprintf(stderr, "unknown impairment item: %s\n", pchItem);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int setConnImpairment(int iSock, const TcpImpairment *kpstImpair)
+{
+    TcpConnInfo *pstConn = findConnInfo(iSock);
+    if (pstConn == NULL) {
+        fprintf(stderr, "setConnImpairment: socket %d is not registered\n", iSock);
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_stImpairLock);
+    TcpImpairState *pstState = pstConn->pstImpair;
+    if (kpstImpair == NULL) {
+        if (pstState != NULL && !pstState->iClosing) {
+            // 이미 송신 중인 스레드는 대기열에 넣을 수 있도록 두고, 대기열이 모두 전송되면 떼어냄
+            pstState->iClosing = 1;
+            while ((pstState->pstHead != NULL && pstState->iError == 0) || pstState->iUsers > 0) {
+                pthread_cond_wait(&g_stImpairDrain, &g_stImpairLock);
+            }
+            detachImpairState(pstConn, pstState);
+            pthread_mutex_unlock(&g_stImpairLock);
+            free(pstState);
+            return 0;
+        }
+        pthread_mutex_unlock(&g_stImpairLock);
+        return 0;
+    }
+
+    if (ensureImpairThread() < 0) {
+        pthread_mutex_unlock(&g_stImpairLock);
+        return -1;
+    }
+    while (pstState != NULL && pstState->iClosing) {
+        pthread_cond_wait(&g_stImpairDrain, &g_stImpairLock);
+        pstState = pstConn->pstImpair;
+    }
+    if (pstState == NULL) {
+        pstState = (TcpImpairState *)calloc(1, sizeof(TcpImpairState));
+        if (pstState == NULL) {
+            pthread_mutex_unlock(&g_stImpairLock);
+            perror("calloc failed");
+            return -1;
+        }
+        pstState->iSock = iSock;
+        initTimer(&pstState->stTimer, flushImpairQueue, pstState);
+        __atomic_fetch_add(&g_iImpairedConns, 1, __ATOMIC_RELAXED);
+    }
+    pstState->stConfig = *kpstImpair;
+    if (pstState->stConfig.uiQueueLimit == 0) {
+        pstState->stConfig.uiQueueLimit = TCP_IMPAIR_DEFAULT_QUEUE;
+    }
+    __atomic_store_n(&pstConn->pstImpair, pstState, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_stImpairLock);
+    return 0;
+}
+
+ssize_t sendImpaired(TcpConnInfo *pstConn, const struct iovec *kpstIov, int iIovCnt)
+{
+    int iSock = pstConn->iSock;
+    size_t uiTotal = 0;
+
+    for (int i = 0; i < iIovCnt; i++) {
+        uiTotal += kpstIov[i].iov_len;
+    }
+
+    pthread_mutex_lock(&g_stImpairLock);
+    TcpImpairState *pstState = acquireImpairState(pstConn);
+    if (pstState == NULL) {
+        // 호출자가 확인한 뒤 장애가 해제됨
+        pthread_mutex_unlock(&g_stImpairLock);
+        return writev(iSock, kpstIov, iIovCnt);
+    }
+    const TcpImpairment *kpstConfig = &pstState->stConfig;
+    TcpImpairment stConfig = *kpstConfig;
+    pthread_mutex_unlock(&g_stImpairLock);
+    stallIfDrawn(&stConfig);
+
+    pthread_mutex_lock(&g_stImpairLock);
+    while (pstState->iError == 0 && pstState->uiQueued >= kpstConfig->uiQueueLimit) {
+        pthread_cond_wait(&g_stImpairDrain, &g_stImpairLock);
+    }
+    if (pstState->iError != 0) {
+        errno = pstState->iError;
+        putImpairState(pstState);
+        pthread_mutex_unlock(&g_stImpairLock);
+        return -1;
+    }
+
+    size_t uiAccept = uiTotal;
+    if (kpstConfig->uiMaxWrite > 0 && uiAccept > kpstConfig->uiMaxWrite) {
+        uiAccept = kpstConfig->uiMaxWrite;
+    }
+    if (uiAccept > kpstConfig->uiQueueLimit - pstState->uiQueued) {
+        uiAccept = kpstConfig->uiQueueLimit - pstState->uiQueued;
+    }
+    if (uiAccept == 0) {
+        putImpairState(pstState);
+        pthread_mutex_unlock(&g_stImpairLock);
+        return 0;
+    }
+
+    ImpairChunk *pstChunk = (ImpairChunk *)malloc(sizeof(ImpairChunk) + uiAccept);
+    if (pstChunk == NULL) {
+        putImpairState(pstState);
+        pthread_mutex_unlock(&g_stImpairLock);
+        errno = ENOMEM;
+        return -1;
+    }
+    pstChunk->pstNext = NULL;
+    pstChunk->uiLength = uiAccept;
+    pstChunk->uiOffset = 0;
+    pstChunk->pucData = (unsigned char *)(pstChunk + 1);
+    size_t uiCopied = 0;
+    for (int i = 0; i < iIovCnt && uiCopied < uiAccept; i++) {
+        size_t uiCopy = kpstIov[i].iov_len;
+        if (uiCopy > uiAccept - uiCopied) {
+            uiCopy = uiAccept - uiCopied;
+        }
+        memcpy(pstChunk->pucData + uiCopied, kpstIov[i].iov_base, uiCopy);
+        uiCopied += uiCopy;
+    }
+
+    // 대역폭 한도: 앞선 데이터의 전송이 끝난 뒤에 전송을 시작하고, 크기만큼 링크를 점유
+    unsigned long long ullNow = getMonotonicNsec();
+    unsigned long long ullStart = (pstState->ullLinkFreeNsec > ullNow) ? pstState->ullLinkFreeNsec : ullNow;
+    unsigned long long ullDone = ullStart;
+    if (kpstConfig->ullRateBytes > 0) {
+        ullDone += (unsigned long long)uiAccept * 1000000000ULL / kpstConfig->ullRateBytes;
+    }
+    pstState->ullLinkFreeNsec = ullDone;
+
+    unsigned long long ullDelay = (unsigned long long)kpstConfig->uiDelayUsec * 1000ULL;
+    if (kpstConfig->uiJitterUsec > 0) {
+        ullDelay += (unsigned long long)(nextImpairRandom() % (kpstConfig->uiJitterUsec + 1)) * 1000ULL;
+    }
+    // 지터가 있어도 바이트 스트림 순서는 유지
+    pstChunk->ullDueNsec = ullDone + ullDelay;
+    if (pstChunk->ullDueNsec < pstState->ullLastDueNsec) {
+        pstChunk->ullDueNsec = pstState->ullLastDueNsec;
+    }
+    pstState->ullLastDueNsec = pstChunk->ullDueNsec;
+
+    if (pstState->pstTail != NULL) {
+        pstState->pstTail->pstNext = pstChunk;
+    } else {
+        pstState->pstHead = pstChunk;
+        armTimer(&g_stImpairWheel, &pstState->stTimer, pstChunk->ullDueNsec);
+        pthread_cond_signal(&g_stImpairWake);
+    }
+    pstState->pstTail = pstChunk;
+    pstState->uiQueued += uiAccept;
+    putImpairState(pstState);
+    pthread_mutex_unlock(&g_stImpairLock);
+    return (ssize_t)uiAccept;
+}
+
+size_t limitImpairedRecv(int iSock, size_t uiLength)
+{
+    if (__atomic_load_n(&g_iImpairedConns, __ATOMIC_RELAXED) == 0) {
+        return uiLength;
+    }
+
+    TcpConnInfo *pstConn = findConnInfo(iSock);
+    if (pstConn == NULL || __atomic_load_n(&pstConn->pstImpair, __ATOMIC_ACQUIRE) == NULL) {
+        return uiLength;
+    }
+
+    // 해제와 겹쳐도 해제된 상태를 읽지 않도록 잠금 안에서 설정을 복사
+    pthread_mutex_lock(&g_stImpairLock);
+    TcpImpairState *pstState = pstConn->pstImpair;
+    if (pstState == NULL || pstState->iClosing) {
+        pthread_mutex_unlock(&g_stImpairLock);
+        return uiLength;
+    }
+    TcpImpairment stConfig = pstState->stConfig;
+    pthread_mutex_unlock(&g_stImpairLock);
+
+    stallIfDrawn(&stConfig);
+    if (stConfig.uiMaxRead > 0 && uiLength > stConfig.uiMaxRead) {
+        uiLength = stConfig.uiMaxRead;
+    }
+    return uiLength;
+}
+
+void releaseConnImpairment(TcpConnInfo *pstConn)
+{
+    if (pstConn->pstImpair == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_stImpairLock);
+    TcpImpairState *pstState = pstConn->pstImpair;
+    if (pstState == NULL || pstState->iClosing) {
+        // 다른 스레드가 이미 해제 중
+        pthread_mutex_unlock(&g_stImpairLock);
+        return;
+    }
+    // 대기열을 버리고, 공간을 기다리던 송신 스레드는 오류로 돌려보냄
+    pstState->iClosing = 1;
+    freeImpairChunks(pstState);
+    if (pstState->iError == 0) {
+        pstState->iError = EPIPE;
+    }
+    detachImpairState(pstConn, pstState);
+    pthread_mutex_unlock(&g_stImpairLock);
+    free(pstState);
+}
@@ -0,0 +1,220 @@
+/**
+ * @file tcp-metrics-shm.c
+ * @brief 메트릭 세그먼트의 공유 메모리 게시 및 외부 조회 구현
+ *
+ * 라이브러리 메트릭을 mmap(MAP_SHARED) 세그먼트로 옮겨, 외부 도구가 대상 프로세스에
+ * 시스템 콜이나 잠금 없이 카운터/게이지/히스토그램/연결 통계를 읽을 수 있게 합니다.
+ *
+ * 주요 기능:
+ * - 파일 경로 또는 memfd를 이용한 세그먼트 게시
+ * - 외부 프로세스의 읽기 전용 매핑 및 형식 검증
+ * - 시퀀스 잠금을 이용한 연결 통계 스냅샷
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tcp-metrics-shm.h"
+#include "tcp-metrics.h"
+#include "tcp-conn.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief 연결 슬롯 스냅샷의 최대 재시도 횟수
+ *
+ * 쓰는 쪽이 갱신 도중 종료되어 시퀀스가 홀수로 남아도 읽는 쪽이 멈추지 않도록 제한합니다.
+ */
+#define CONN_SNAPSHOT_RETRIES   1024
+
+/*
+ * 메트릭이 세그먼트의 고정 크기 배열을 넘으면 빌드를 실패시킴 (C와 C++ 빌드 모두에서 동작하도록
+ * 음수 크기 배열 관용구 사용)
+ */
+typedef char TcpShmCounterFit[(TCP_METRIC_COUNTER_COUNT <= TCP_SHM_MAX_COUNTERS) ? 1 : -1];
+typedef char TcpShmGaugeFit[(TCP_METRIC_GAUGE_COUNT <= TCP_SHM_MAX_GAUGES) ? 1 : -1];
+typedef char TcpShmHistogramFit[(TCP_METRIC_HISTOGRAM_COUNT <= TCP_SHM_MAX_HISTOGRAMS) ? 1 : -1];
+
+static TcpMetricsSegment *g_pstPublishedSegment;
+
+
+static size_t getSegmentSize(unsigned int uiConnSlots)
+{
+    return sizeof(TcpMetricsSegment) + (size_t)uiConnSlots * sizeof(TcpConnStats);
+}
+
+static void copyName(char *pchDest, const char *kpchName)
+{
+    if (kpchName != NULL) {
+        strncpy(pchDest, kpchName, TCP_SHM_NAME_SIZE - 1);
+    }
+}
+
+
+TcpConnStats *acquireConnStatsSlot(int iSock)
+{
+    TcpMetricsSegment *pstSegment = __atomic_load_n(&g_pstPublishedSegment, __ATOMIC_ACQUIRE);
+    if (pstSegment == NULL || iSock < 0 || (unsigned int)iSock >= pstSegment->stHeader.uiConnSlots) {
+        return NULL;
+    }
+    return &TCP_SHM_CONN_SLOTS(pstSegment)[iSock];
+}
+
+int publishMetricsShm(const char *kpchPath, unsigned int uiConnSlots)
+{
+    if (__atomic_load_n(&g_pstPublishedSegment, __ATOMIC_ACQUIRE) != NULL) {
+        fprintf(stderr, "metrics segment already published\n");
+        return -1;
+    }
+    if (uiConnSlots == 0) {
+        uiConnSlots = TCP_SHM_DEFAULT_CONNS;
+    }
+
+    int iFd;
+    if (kpchPath != NULL) {
+        iFd = open(kpchPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    } else {
+        iFd = memfd_create("tcpsock-metrics", MFD_CLOEXEC);
+    }
+    if (iFd < 0) {
+        perror("open metrics segment failed");
+        return -1;
+    }
+
+    size_t uiSize = getSegmentSize(uiConnSlots);
+    if (ftruncate(iFd, (off_t)uiSize) < 0) {
+        perror("ftruncate failed");
+        close(iFd);
+        return -1;
+    }
+
+    void *pvMap = mmap(NULL, uiSize, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+    if (pvMap == MAP_FAILED) {
+        perror("mmap failed");
+        close(iFd);
+        return -1;
+    }
+
+    // 지금까지의 값을 옮긴 뒤 헤더를 채우고, 매직은 마지막에 기록하여 읽는 쪽이 미완성 세그먼트를 거르도록 함
+    TcpMetricsSegment *pstSegment = (TcpMetricsSegment *)pvMap;
+    memcpy(pstSegment, g_pstMetricsSegment, sizeof(TcpMetricsSegment));
+
+    TcpShmHeader *pstHeader = &pstSegment->stHeader;
+    memset(pstHeader->achMagic, 0, sizeof(pstHeader->achMagic));
+    pstHeader->uiSeq = 1;
+    pstHeader->uiVersion = TCP_SHM_VERSION;
+    pstHeader->uiCounterCount = TCP_METRIC_COUNTER_COUNT;
+    pstHeader->uiGaugeCount = TCP_METRIC_GAUGE_COUNT;
+    pstHeader->uiHistogramCount = TCP_METRIC_HISTOGRAM_COUNT;
+    pstHeader->uiThreadSlots = TCP_SHM_THREAD_SLOTS;
+    pstHeader->uiConnSlots = uiConnSlots;
+    pstHeader->iPid = (int)getpid();
+    pstHeader->ullStartNsec = getMonotonicNsec();
+    pstHeader->ullCycleHz = getCycleFrequency();
+    for (int i = 0; i < TCP_METRIC_COUNTER_COUNT; i++) {
+        copyName(pstHeader->aachCounterNames[i], getMetricCounterName((TcpMetricCounter)i));
+    }
+    for (int i = 0; i < TCP_METRIC_GAUGE_COUNT; i++) {
+        copyName(pstHeader->aachGaugeNames[i], getMetricGaugeName((TcpMetricGauge)i));
+    }
+    for (int i = 0; i < TCP_METRIC_HISTOGRAM_COUNT; i++) {
+        copyName(pstHeader->aachHistogramNames[i], getMetricHistogramName((TcpMetricHistogram)i));
+    }
+    for (unsigned int i = 0; i < uiConnSlots; i++) {
+        TCP_SHM_CONN_SLOTS(pstSegment)[i].iSock = -1;
+    }
+
+    memcpy(pstHeader->achMagic, TCP_SHM_MAGIC, sizeof(TCP_SHM_MAGIC));
+    __atomic_store_n(&pstHeader->uiSeq, 2, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&g_pstMetricsSegment, pstSegment, __ATOMIC_RELEASE);
+    __atomic_store_n(&g_pstPublishedSegment, pstSegment, __ATOMIC_RELEASE);
+    rebindConnStats();
+    return iFd;
+}
+
+const TcpMetricsSegment *getPublishedMetricsShm(void)
+{
+    return __atomic_load_n(&g_pstPublishedSegment, __ATOMIC_ACQUIRE);
+}
+
+const TcpMetricsSegment *openMetricsShm(const char *kpchPath, size_t *puiSize)
+{
+    int iFd = open(kpchPath, O_RDONLY | O_CLOEXEC);
+    if (iFd < 0) {
+        perror("open failed");
+        return NULL;
+    }
+
+    struct stat stStat;
+    if (fstat(iFd, &stStat) < 0 || (size_t)stStat.st_size < sizeof(TcpMetricsSegment)) {
+        fprintf(stderr, "invalid metrics segment: %s\n", kpchPath);
+        close(iFd);
+        return NULL;
+    }
+
+    size_t uiSize = (size_t)stStat.st_size;
+    void *pvMap = mmap(NULL, uiSize, PROT_READ, MAP_SHARED, iFd, 0);
+    close(iFd);
+    if (pvMap == MAP_FAILED) {
+        perror("mmap failed");
+        return NULL;
+    }
+
+    const TcpMetricsSegment *kpstSegment = (const TcpMetricsSegment *)pvMap;
+    const TcpShmHeader *kpstHeader = &kpstSegment->stHeader;
+    if ((__atomic_load_n(&kpstHeader->uiSeq, __ATOMIC_ACQUIRE) & 1) != 0
+        || memcmp(kpstHeader->achMagic, TCP_SHM_MAGIC, sizeof(TCP_SHM_MAGIC)) != 0
+        || kpstHeader->uiVersion != TCP_SHM_VERSION
+        || getSegmentSize(kpstHeader->uiConnSlots) > uiSize) {
+        fprintf(stderr, "metrics segment format mismatch: %s\n", kpchPath);
+        munmap(pvMap, uiSize);
+        return NULL;
+    }
+
+    if (puiSize != NULL) {
+        *puiSize = uiSize;
+    }
+    return kpstSegment;
+}
+
+int readConnStatsSnapshot(const TcpConnStats *kpstSlot, TcpConnStats *pstOut)
+{
+    unsigned int uiBefore;
+    unsigned int uiAfter;
+    int iRetries = 0;
+
+    do {
+        if (iRetries++ == CONN_SNAPSHOT_RETRIES) {
+            return -1;
+        }
+        uiBefore = __atomic_load_n(&kpstSlot->uiSeq, __ATOMIC_ACQUIRE);
+        if (uiBefore & 1) {
+            uiAfter = uiBefore;
+            continue;
+        }
+        pstOut->iSock = __atomic_load_n(&kpstSlot->iSock, __ATOMIC_RELAXED);
+        pstOut->iOwnerTid = __atomic_load_n(&kpstSlot->iOwnerTid, __ATOMIC_RELAXED);
+        pstOut->ullCreatedNsec = __atomic_load_n(&kpstSlot->ullCreatedNsec, __ATOMIC_RELAXED);
+        pstOut->ullLastActiveNsec = __atomic_load_n(&kpstSlot->ullLastActiveNsec, __ATOMIC_RELAXED);
+        pstOut->ullBytesIn = __atomic_load_n(&kpstSlot->ullBytesIn, __ATOMIC_RELAXED);
+        pstOut->ullBytesOut = __atomic_load_n(&kpstSlot->ullBytesOut, __ATOMIC_RELAXED);
+        pstOut->ullMsgsIn = __atomic_load_n(&kpstSlot->ullMsgsIn, __ATOMIC_RELAXED);
+        pstOut->ullMsgsOut = __atomic_load_n(&kpstSlot->ullMsgsOut, __ATOMIC_RELAXED);
+        for (int i = 0; i < TCP_COST_KIND_COUNT; i++) {
+            pstOut->aullCostCycles[i] = __atomic_load_n(&kpstSlot->aullCostCycles[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uiAfter = __atomic_load_n(&kpstSlot->uiSeq, __ATOMIC_RELAXED);
+    } while ((uiBefore & 1) || uiBefore != uiAfter);
+
+    pstOut->uiSeq = uiAfter;
+    pstOut->uiReserved = 0;
+    return pstOut->iSock >= 0 && pstOut->ullCreatedNsec != 0;
+}
@@ -0,0 +1,466 @@
+/**
+ * @file tcp-metrics.c
+ * @brief 라이브러리 계측용 시계, 카운터, 게이지 및 히스토그램 구현
+ *
+ * 송수신 경로의 지연 시간을 기록하기 위한 로그-선형 히스토그램과 스레드별 카운터,
+ * 연결별 통계를 제공합니다. 모든 값은 메트릭 세그먼트에 저장되며, 세그먼트는 공유 메모리로
+ * 게시될 수 있습니다(tcp-metrics-shm.c).
+ *
+ * 주요 기능:
+ * - 단조/실시간 시계 조회 (나노초)
+ * - 잠금 없는 히스토그램 기록 및 백분위 계산
+ * - 스레드별 카운터, 게이지, 연결별 통계
+ * - 요청 처리 단계별 지연 측정 (샘플링)
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tcp-metrics.h"
+#include "tcp-metrics-shm.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+
+#include <stdio.h>
+#include <time.h>
+#include <string.h>
+
+static TcpMetricsSegment g_stLocalSegment;
+TcpMetricsSegment *g_pstMetricsSegment = &g_stLocalSegment;
+
+static const char *g_kapchCounterNames[TCP_METRIC_COUNTER_COUNT] = {
+    "bytes_sent",
+    "bytes_received",
+    "send_calls",
+    "recv_calls",
+    "accepts",
+    "connects",
+    "connect_failures",
+    "timeouts",
+    "disconnects",
+    "listen_alerts",
+    "resolve_cache_hits",
+    "resolve_queries",
+    "resolve_failures",
+    "backend_ejections",
+    "hedged_requests",
+    "hedge_wins",
+    "hedge_denied",
+};
+
+static const char *g_kapchGaugeNames[TCP_METRIC_GAUGE_COUNT] = {
+    "open_connections",
+    "accept_queue",
+    "accept_backlog",
+    "listen_overflows",
+    "listen_drops",
+};
+
+/**
+ * @brief 현재 스레드가 사용하는 스레드 슬롯 (인덱스 + 1, 0이면 미할당)
+ */
+static __thread int t_iThreadSlot;
+
+/**
+ * @brief 스레드 종료 시 슬롯을 반납하기 위한 키
+ */
+static pthread_key_t g_stThreadSlotKey;
+static pthread_once_t g_stThreadSlotOnce = PTHREAD_ONCE_INIT;
+
+static const char *g_kapchHistogramNames[TCP_METRIC_HISTOGRAM_COUNT] = {
+    "wire_to_app_ns",
+    "app_to_ack_ns",
+    "stage_recv_ns",
+    "stage_parse_ns",
+    "stage_handoff_ns",
+    "stage_handler_ns",
+    "stage_enqueue_ns",
+    "stage_syscall_ns",
+    "stage_total_ns",
+};
+
+__thread TcpStageStamps *t_pstThreadStages;
+
+static unsigned int g_uiStageSampleRate;
+static __thread unsigned int t_uiStageCounter;
+
+
+static TcpMetricsSegment *getSegment(void)
+{
+    return __atomic_load_n(&g_pstMetricsSegment, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief 종료하는 스레드의 슬롯을 반납합니다.
+ *
+ * @details 카운터 값은 공용 슬롯에 더해 전역 합계를 유지하고, 슬롯을 비운 뒤에야 사용 표시를 지워
+ *          새 스레드가 이전 값을 이어받지 않도록 합니다. 옮기는 동안 읽는 쪽은 잠시 중복된 값을 볼 수 있습니다.
+ */
+static void releaseThreadSlot(void *pvSlot)
+{
+    TcpMetricsSegment *pstSegment = getSegment();
+    int iSlot = (int)(long)pvSlot - 1;
+
+    t_iThreadSlot = 0;
+    if (iSlot < 0 || iSlot >= TCP_SHM_THREAD_SLOTS - 1) {
+        return;
+    }
+
+    TcpShmThreadSlot *pstSlot = &pstSegment->astThreads[iSlot];
+    TcpShmThreadSlot *pstRetired = &pstSegment->astThreads[TCP_SHM_THREAD_SLOTS - 1];
+    for (int i = 0; i < TCP_SHM_MAX_COUNTERS; i++) {
+        unsigned long long ullValue = __atomic_load_n(&pstSlot->aullCounters[i], __ATOMIC_RELAXED);
+        if (ullValue != 0) {
+            __atomic_fetch_add(&pstRetired->aullCounters[i], ullValue, __ATOMIC_RELAXED);
+            __atomic_store_n(&pstSlot->aullCounters[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+    pstSlot->iTid = 0;
+    memset(pstSlot->achName, 0, sizeof(pstSlot->achName));
+    __atomic_store_n(&pstSlot->uiInUse, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 슬롯 반납 키를 만들고 공용 슬롯을 준비합니다 (한 번만 실행).
+ *
+ * @details 마지막 슬롯은 슬롯이 부족할 때 여러 스레드가 함께 쓰고, 종료한 스레드의 카운터도 모이는
+ *          공용 슬롯이므로 처음부터 사용 중으로 표시합니다.
+ */
+static void initThreadSlots(void)
+{
+    TcpShmThreadSlot *pstShared = &getSegment()->astThreads[TCP_SHM_THREAD_SLOTS - 1];
+
+    if (pthread_key_create(&g_stThreadSlotKey, releaseThreadSlot) != 0) {
+        perror("pthread_key_create failed");
+    }
+    strcpy(pstShared->achName, "overflow");
+    __atomic_store_n(&pstShared->uiInUse, 1, __ATOMIC_RELEASE);
+}
+
+static TcpShmThreadSlot *getThreadSlot(void)
+{
+    TcpMetricsSegment *pstSegment = getSegment();
+
+    if (t_iThreadSlot == 0) {
+        pthread_once(&g_stThreadSlotOnce, initThreadSlots);
+
+        int iSlot = TCP_SHM_THREAD_SLOTS - 1;
+        for (int i = 0; i < TCP_SHM_THREAD_SLOTS - 1; i++) {
+            unsigned int uiFree = 0;
+            if (__atomic_compare_exchange_n(&pstSegment->astThreads[i].uiInUse, &uiFree, 1, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                iSlot = i;
+                break;
+            }
+        }
+
+        if (iSlot != TCP_SHM_THREAD_SLOTS - 1) {
+            TcpShmThreadSlot *pstSlot = &pstSegment->astThreads[iSlot];
+            pstSlot->iTid = (int)syscall(SYS_gettid);
+            pthread_getname_np(pthread_self(), pstSlot->achName, sizeof(pstSlot->achName));
+            pthread_setspecific(g_stThreadSlotKey, (void *)(long)(iSlot + 1));
+        }
+        t_iThreadSlot = iSlot + 1;
+    }
+    return &pstSegment->astThreads[t_iThreadSlot - 1];
+}
+
+static unsigned int getHistogramIndex(unsigned long long ullValue)
+{
+    if (ullValue < TCP_HIST_SUB_BUCKETS) {
+        return (unsigned int)ullValue;
+    }
+
+    unsigned int uiMsb = 63 - __builtin_clzll(ullValue);
+    unsigned int uiSub = (unsigned int)(ullValue >> (uiMsb - TCP_HIST_SUB_BITS)) & (TCP_HIST_SUB_BUCKETS - 1);
+    return (uiMsb - TCP_HIST_SUB_BITS + 1) * TCP_HIST_SUB_BUCKETS + uiSub;
+}
+
+static unsigned long long getHistogramUpperBound(unsigned int uiIndex)
+{
+    if (uiIndex < TCP_HIST_SUB_BUCKETS) {
+        return uiIndex;
+    }
+
+    unsigned int uiShift = uiIndex / TCP_HIST_SUB_BUCKETS - 1;
+    unsigned long long ullLower = (unsigned long long)(TCP_HIST_SUB_BUCKETS + uiIndex % TCP_HIST_SUB_BUCKETS) << uiShift;
+    return ullLower + ((1ULL << uiShift) - 1);
+}
+
+
+unsigned long long getMonotonicNsec(void)
+{
+    struct timespec stNow;
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return (unsigned long long)stNow.tv_sec * 1000000000ULL + (unsigned long long)stNow.tv_nsec;
+}
+
+unsigned long long getRealtimeNsec(void)
+{
+    struct timespec stNow;
+    clock_gettime(CLOCK_REALTIME, &stNow);
+    return (unsigned long long)stNow.tv_sec * 1000000000ULL + (unsigned long long)stNow.tv_nsec;
+}
+
+unsigned long long getCycleCount(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    unsigned long long ullValue;
+    __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (ullValue));
+    return ullValue;
+#else
+    return getMonotonicNsec();
+#endif
+}
+
+unsigned long long getCycleFrequency(void)
+{
+    static unsigned long long s_ullFrequency;
+    unsigned long long ullFrequency = __atomic_load_n(&s_ullFrequency, __ATOMIC_RELAXED);
+
+    if (ullFrequency == 0) {
+        struct timespec stSleep = { 0, 10000000L };
+        unsigned long long ullStartNsec = getMonotonicNsec();
+        unsigned long long ullStartCycles = getCycleCount();
+        nanosleep(&stSleep, NULL);
+        unsigned long long ullElapsedNsec = getMonotonicNsec() - ullStartNsec;
+        unsigned long long ullElapsedCycles = getCycleCount() - ullStartCycles;
+
+        ullFrequency = (ullElapsedNsec > 0)
+                     ? (unsigned long long)((double)ullElapsedCycles * 1e9 / (double)ullElapsedNsec) : 1000000000ULL;
+        if (ullFrequency == 0) {
+            ullFrequency = 1000000000ULL;
+        }
+        __atomic_store_n(&s_ullFrequency, ullFrequency, __ATOMIC_RELAXED);
+    }
+    return ullFrequency;
+}
+
+void recordHistogram(TcpHistogram *pstHist, unsigned long long ullValue)
+{
+    __atomic_fetch_add(&pstHist->aullBuckets[getHistogramIndex(ullValue)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pstHist->ullSum, ullValue, __ATOMIC_RELAXED);
+
+    unsigned long long ullMax = __atomic_load_n(&pstHist->ullMax, __ATOMIC_RELAXED);
+    while (ullValue > ullMax
+           && !__atomic_compare_exchange_n(&pstHist->ullMax, &ullMax, ullValue, 1,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    // 개수는 마지막에 증가시켜, 읽는 쪽이 개수만큼의 버킷 기록을 볼 수 있도록 함
+    __atomic_fetch_add(&pstHist->ullCount, 1, __ATOMIC_RELEASE);
+}
+
+unsigned long long getHistogramPercentile(const TcpHistogram *pstHist, double dPercentile)
+{
+    unsigned long long ullCount = __atomic_load_n(&pstHist->ullCount, __ATOMIC_ACQUIRE);
+    if (ullCount == 0) {
+        return 0;
+    }
+
+    unsigned long long ullTarget = (unsigned long long)(dPercentile / 100.0 * (double)ullCount + 0.5);
+    if (ullTarget == 0) {
+        ullTarget = 1;
+    }
+
+    unsigned long long ullSeen = 0;
+    for (unsigned int i = 0; i < TCP_HIST_BUCKETS; i++) {
+        ullSeen += __atomic_load_n(&pstHist->aullBuckets[i], __ATOMIC_RELAXED);
+        if (ullSeen >= ullTarget) {
+            unsigned long long ullUpper = getHistogramUpperBound(i);
+            unsigned long long ullMax = __atomic_load_n(&pstHist->ullMax, __ATOMIC_RELAXED);
+            return (ullUpper < ullMax) ? ullUpper : ullMax;
+        }
+    }
+    return __atomic_load_n(&pstHist->ullMax, __ATOMIC_RELAXED);
+}
+
+void resetHistogram(TcpHistogram *pstHist)
+{
+    memset(pstHist, 0, sizeof(*pstHist));
+}
+
+TcpHistogram *getMetricHistogram(TcpMetricHistogram eId)
+{
+    if ((unsigned int)eId >= TCP_METRIC_HISTOGRAM_COUNT) {
+        return NULL;
+    }
+    return &getSegment()->astHistograms[eId];
+}
+
+const char *getMetricHistogramName(TcpMetricHistogram eId)
+{
+    if ((unsigned int)eId >= TCP_METRIC_HISTOGRAM_COUNT) {
+        return NULL;
+    }
+    return g_kapchHistogramNames[eId];
+}
+
+void addMetricCounter(TcpMetricCounter eId, unsigned long long ullDelta)
+{
+    if ((unsigned int)eId < TCP_METRIC_COUNTER_COUNT) {
+        __atomic_fetch_add(&getThreadSlot()->aullCounters[eId], ullDelta, __ATOMIC_RELAXED);
+    }
+}
+
+unsigned long long getMetricCounter(TcpMetricCounter eId)
+{
+    TcpMetricsSegment *pstSegment = getSegment();
+    unsigned long long ullSum = 0;
+
+    if ((unsigned int)eId >= TCP_METRIC_COUNTER_COUNT) {
+        return 0;
+    }
+    for (int i = 0; i < TCP_SHM_THREAD_SLOTS; i++) {
+        if (__atomic_load_n(&pstSegment->astThreads[i].uiInUse, __ATOMIC_ACQUIRE)) {
+            ullSum += __atomic_load_n(&pstSegment->astThreads[i].aullCounters[eId], __ATOMIC_RELAXED);
+        }
+    }
+    return ullSum;
+}
+
+const char *getMetricCounterName(TcpMetricCounter eId)
+{
+    if ((unsigned int)eId >= TCP_METRIC_COUNTER_COUNT) {
+        return NULL;
+    }
+    return g_kapchCounterNames[eId];
+}
+
+void addMetricGauge(TcpMetricGauge eId, long long llDelta)
+{
+    if ((unsigned int)eId < TCP_METRIC_GAUGE_COUNT) {
+        __atomic_fetch_add(&getSegment()->stHeader.allGauges[eId], llDelta, __ATOMIC_RELAXED);
+    }
+}
+
+void setMetricGauge(TcpMetricGauge eId, long long llValue)
+{
+    if ((unsigned int)eId < TCP_METRIC_GAUGE_COUNT) {
+        __atomic_store_n(&getSegment()->stHeader.allGauges[eId], llValue, __ATOMIC_RELAXED);
+    }
+}
+
+long long getMetricGauge(TcpMetricGauge eId)
+{
+    if ((unsigned int)eId >= TCP_METRIC_GAUGE_COUNT) {
+        return 0;
+    }
+    return __atomic_load_n(&getSegment()->stHeader.allGauges[eId], __ATOMIC_RELAXED);
+}
+
+const char *getMetricGaugeName(TcpMetricGauge eId)
+{
+    if ((unsigned int)eId >= TCP_METRIC_GAUGE_COUNT) {
+        return NULL;
+    }
+    return g_kapchGaugeNames[eId];
+}
+
+void initConnStats(TcpConnStats *pstStats, int iSock)
+{
+    __atomic_fetch_add(&pstStats->uiSeq, 1, __ATOMIC_ACQ_REL);
+    pstStats->iSock = iSock;
+    pstStats->iOwnerTid = (iSock >= 0) ? (int)syscall(SYS_gettid) : 0;
+    pstStats->ullCreatedNsec = (iSock >= 0) ? getMonotonicNsec() : 0;
+    pstStats->ullLastActiveNsec = pstStats->ullCreatedNsec;
+    pstStats->ullBytesIn = 0;
+    pstStats->ullBytesOut = 0;
+    pstStats->ullMsgsIn = 0;
+    pstStats->ullMsgsOut = 0;
+    memset(pstStats->aullCostCycles, 0, sizeof(pstStats->aullCostCycles));
+    __atomic_fetch_add(&pstStats->uiSeq, 1, __ATOMIC_RELEASE);
+}
+
+void countSend(TcpConnStats *pstStats, size_t uiBytes)
+{
+    TcpShmThreadSlot *pstSlot = getThreadSlot();
+    __atomic_fetch_add(&pstSlot->aullCounters[TCP_COUNTER_BYTES_SENT], uiBytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pstSlot->aullCounters[TCP_COUNTER_SEND_CALLS], 1, __ATOMIC_RELAXED);
+
+    if (pstStats != NULL) {
+        __atomic_fetch_add(&pstStats->uiSeq, 1, __ATOMIC_ACQ_REL);
+        __atomic_fetch_add(&pstStats->ullBytesOut, uiBytes, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&pstStats->ullMsgsOut, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&pstStats->ullLastActiveNsec, getMonotonicNsec(), __ATOMIC_RELAXED);
+        __atomic_fetch_add(&pstStats->uiSeq, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void countRecv(TcpConnStats *pstStats, size_t uiBytes)
+{
+    TcpShmThreadSlot *pstSlot = getThreadSlot();
+    __atomic_fetch_add(&pstSlot->aullCounters[TCP_COUNTER_BYTES_RECEIVED], uiBytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pstSlot->aullCounters[TCP_COUNTER_RECV_CALLS], 1, __ATOMIC_RELAXED);
+
+    if (pstStats != NULL) {
+        __atomic_fetch_add(&pstStats->uiSeq, 1, __ATOMIC_ACQ_REL);
+        __atomic_fetch_add(&pstStats->ullBytesIn, uiBytes, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&pstStats->ullMsgsIn, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&pstStats->ullLastActiveNsec, getMonotonicNsec(), __ATOMIC_RELAXED);
+        __atomic_fetch_add(&pstStats->uiSeq, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void setStageSampleRate(unsigned int uiOneInN)
+{
+    __atomic_store_n(&g_uiStageSampleRate, uiOneInN, __ATOMIC_RELAXED);
+}
+
+int beginStageStamps(TcpStageStamps *pstStages)
+{
+    unsigned int uiRate = __atomic_load_n(&g_uiStageSampleRate, __ATOMIC_RELAXED);
+
+    pstStages->iSampled = (uiRate != 0 && ++t_uiStageCounter % uiRate == 0);
+    if (!pstStages->iSampled) {
+        t_pstThreadStages = NULL;
+        return 0;
+    }
+
+    memset(pstStages->aullStampNsec, 0, sizeof(pstStages->aullStampNsec));
+    t_pstThreadStages = pstStages;
+    return 1;
+}
+
+void markStage(TcpStageStamps *pstStages, TcpStage eStage)
+{
+    if (pstStages->iSampled && (unsigned int)eStage < TCP_STAGE_COUNT) {
+        pstStages->aullStampNsec[eStage] = getMonotonicNsec();
+    }
+}
+
+void endStageStamps(TcpStageStamps *pstStages)
+{
+    if (t_pstThreadStages == pstStages) {
+        t_pstThreadStages = NULL;
+    }
+    if (!pstStages->iSampled) {
+        return;
+    }
+
+    unsigned long long ullFirst = 0;
+    unsigned long long ullPrev = 0;
+    for (unsigned int i = 0; i < TCP_STAGE_COUNT; i++) {
+        unsigned long long ullStamp = pstStages->aullStampNsec[i];
+        if (ullStamp == 0) {
+            continue;
+        }
+        // 단계 i의 히스토그램은 TCP_METRIC_STAGE_RECV부터 순서대로 대응 (READY는 기준점)
+        if (ullPrev != 0 && i > TCP_STAGE_READY) {
+            recordHistogram(getMetricHistogram((TcpMetricHistogram)(TCP_METRIC_STAGE_RECV + i - 1)),
+                            (ullStamp > ullPrev) ? ullStamp - ullPrev : 0);
+        }
+        if (ullFirst == 0) {
+            ullFirst = ullStamp;
+        }
+        ullPrev = ullStamp;
+    }
+
+    if (ullFirst != 0 && ullPrev > ullFirst) {
+        recordHistogram(getMetricHistogram(TCP_METRIC_STAGE_TOTAL), ullPrev - ullFirst);
+    }
+    pstStages->iSampled = 0;
+}
@@ -0,0 +1,1027 @@
+/**
+ * @file tcp-resolve.c
+ * @brief 캐시를 갖춘 비동기 이름 해석기 구현
+ *
+ * createClientSocket()은 숫자 IPv4 주소만 받으므로 호출자가 블로킹 getaddrinfo()로 이름을
+ * 직접 풀어 왔고, 느린 DNS 서버 하나가 호출 스레드를 수 초씩 멈추게 했습니다. 이 모듈은
+ * hosts 파일과 resolv.conf를 직접 읽고 A/AAAA 질의를 UDP로 보내는 작은 스텁 해석기로, 해석을
+ * 별도 스레드에서 수행하고 결과를 TTL 동안(없는 이름은 SOA 최소값 동안) 캐시합니다.
+ *
+ * 주요 기능:
+ * - 숫자 주소, 캐시, hosts 파일, DNS 순서의 이름 해석
+ * - resolv.conf의 nameserver, search/domain, options timeout/attempts/ndots 처리
+ * - TTL 기반 캐시와 부정 캐시 (RFC 2308)
+ * - 해석 스레드 풀과 완료 콜백
+ * - "host:port" 엔드포인트 연결 (주소 간 연결 경쟁)
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tcp-resolve.h"
+#include "tcp-sock.h"
+#include "tcp-metrics.h"
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/random.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <poll.h>
+#include <limits.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define RESOLVE_HOSTS_PATH      "/etc/hosts"
+#define RESOLVE_CONF_PATH       "/etc/resolv.conf"
+#define RESOLVE_LINE_SIZE       1024
+#define RESOLVE_CACHE_PROBE     8
+#define RESOLVE_DNS_PORT        53
+#define RESOLVE_PACKET_SIZE     512
+#define RESOLVE_DEFAULT_NDOTS   1
+#define RESOLVE_PORT_RANGE_PATH "/proc/sys/net/ipv4/ip_local_port_range"
+#define RESOLVE_PORT_MIN        32768       /**< 포트 범위를 읽지 못할 때의 임시 포트 범위 (리눅스 기본값) */
+#define RESOLVE_PORT_MAX        60999
+#define RESOLVE_PORT_TRIES      8
+
+#define DNS_HEADER_SIZE         12
+#define DNS_FLAG_RD             0x0100
+#define DNS_FLAG_QR             0x8000
+#define DNS_RCODE_MASK          0x000f
+#define DNS_RCODE_NXDOMAIN      3
+#define DNS_TYPE_A              1
+#define DNS_TYPE_SOA            6
+#define DNS_TYPE_AAAA           28
+#define DNS_CLASS_IN            1
+
+typedef struct {
+    char achHost[TCP_RESOLVE_HOST_MAX];
+    unsigned long long ullExpireNsec;   /* 0이면 빈 항목 */
+    TcpResolveResult stResult;
+} ResolveCacheEntry;
+
+typedef struct {
+    char achHost[TCP_RESOLVE_HOST_MAX];
+    TcpResolveCallback pfnCallback;
+    void *pvArg;
+} ResolveJob;
+
+typedef struct {
+    int iServers;
+    struct sockaddr_storage astServers[TCP_RESOLVE_MAX_SERVERS];
+    socklen_t auiServerLens[TCP_RESOLVE_MAX_SERVERS];
+    int iSearch;
+    char aachSearch[TCP_RESOLVE_MAX_SEARCH][TCP_RESOLVE_HOST_MAX];
+    int iNdots;
+    unsigned int uiTimeoutMsec;
+    unsigned int uiAttempts;
+} ResolvConf;
+
+/**
+ * @brief 이름 하나에 대한 A/AAAA 응답을 모은 결과
+ */
+typedef struct {
+    int iAnswered;                      /* 응답을 받은 질의 수 */
+    int iV4;
+    int iV6;
+    TcpResolvedAddr astV4[TCP_RESOLVE_MAX_ADDRS];
+    TcpResolvedAddr astV6[TCP_RESOLVE_MAX_ADDRS];
+    unsigned int uiTtl;                 /* 주소 레코드 TTL 최소값 */
+    unsigned int uiNegativeTtl;         /* SOA에서 얻은 부정 캐시 시간 (없으면 UINT_MAX) */
+} DnsAnswer;
+
+static pthread_mutex_t g_stResolveLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_stResolveWake = PTHREAD_COND_INITIALIZER;
+static TcpResolverConfig g_stResolveConfig;
+static char g_achHostsPath[PATH_MAX];
+static char g_achResolvConfPath[PATH_MAX];
+static ResolveCacheEntry g_astResolveCache[TCP_RESOLVE_CACHE_SIZE];
+static ResolveJob g_astResolveQueue[TCP_RESOLVE_MAX_QUEUE];
+static int g_iResolveHead;
+static int g_iResolveQueued;
+static pthread_t g_astResolveThreads[TCP_RESOLVE_MAX_THREADS];
+static int g_iResolveThreads;
+static int g_iResolveStop;
+
+
+static unsigned int orDefault(unsigned int uiValue, unsigned int uiDefault)
+{
+    return (uiValue != 0) ? uiValue : uiDefault;
+}
+
+/**
+ * @brief 현재 설정을 복사합니다 (경로 문자열은 호출자 버퍼로 복사).
+ */
+static void snapshotResolveConfig(TcpResolverConfig *pstConfig, char *pchHosts, char *pchConf)
+{
+    pthread_mutex_lock(&g_stResolveLock);
+    *pstConfig = g_stResolveConfig;
+    strcpy(pchHosts, (g_achHostsPath[0] != '\0') ? g_achHostsPath : RESOLVE_HOSTS_PATH);
+    strcpy(pchConf, (g_achResolvConfPath[0] != '\0') ? g_achResolvConfPath : RESOLVE_CONF_PATH);
+    pthread_mutex_unlock(&g_stResolveLock);
+    pstConfig->kpchHostsPath = pchHosts;
+    pstConfig->kpchResolvConfPath = pchConf;
+}
+
+/**
+ * @brief 이름을 소문자로 바꿔 복사합니다.
+ *
+ * @return 성공 시 0, 빈 이름이거나 너무 길면 -1
+ */
+static int normalizeHost(const char *kpchHost, char *pchOut)
+{
+    size_t uiLength = strlen(kpchHost);
+
+    if (uiLength == 0 || uiLength >= TCP_RESOLVE_HOST_MAX) {
+        return -1;
+    }
+    for (size_t i = 0; i <= uiLength; i++) {
+        pchOut[i] = (char)tolower((unsigned char)kpchHost[i]);
+    }
+    return 0;
+}
+
+static int parseNumericHost(const char *kpchHost, TcpResolveResult *pstResult)
+{
+    TcpResolvedAddr *pstAddr = &pstResult->astAddrs[0];
+
+    if (inet_pton(AF_INET, kpchHost, pstAddr->aucAddr) == 1) {
+        pstAddr->iFamily = AF_INET;
+    } else if (inet_pton(AF_INET6, kpchHost, pstAddr->aucAddr) == 1) {
+        pstAddr->iFamily = AF_INET6;
+    } else {
+        return 0;
+    }
+    pstResult->iStatus = 0;
+    pstResult->iSource = TCP_RESOLVE_SOURCE_NUMERIC;
+    pstResult->iAddrs = 1;
+    return 1;
+}
+
+
+/*
+ * 캐시 (g_stResolveLock 보유 상태에서 호출)
+ */
+
+static unsigned int hashResolveHost(const char *kpchHost)
+{
+    unsigned int uiHash = 2166136261u;
+    for (const unsigned char *kpucChar = (const unsigned char *)kpchHost; *kpucChar != '\0'; kpucChar++) {
+        uiHash = (uiHash ^ *kpucChar) * 16777619u;
+    }
+    return uiHash;
+}
+
+static int lookupResolveCache(const char *kpchHost, unsigned long long ullNow, TcpResolveResult *pstResult)
+{
+    unsigned int uiSlot = hashResolveHost(kpchHost);
+
+    for (int i = 0; i < RESOLVE_CACHE_PROBE; i++) {
+        const ResolveCacheEntry *kpstEntry = &g_astResolveCache[(uiSlot + (unsigned int)i) & (TCP_RESOLVE_CACHE_SIZE - 1)];
+        if (kpstEntry->ullExpireNsec > ullNow && strcmp(kpstEntry->achHost, kpchHost) == 0) {
+            *pstResult = kpstEntry->stResult;
+            pstResult->iCached = 1;
+            pstResult->uiTtl = (unsigned int)((kpstEntry->ullExpireNsec - ullNow) / 1000000000ULL);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 결과를 캐시에 넣습니다. 탐색 범위 안에서 같은 이름, 만료된 항목, 가장 먼저 만료될 항목
+ *        순서로 자리를 고릅니다.
+ */
+static void storeResolveCache(const char *kpchHost, const TcpResolveResult *kpstResult, unsigned long long ullNow)
+{
+    unsigned int uiSlot = hashResolveHost(kpchHost);
+    ResolveCacheEntry *pstVictim = NULL;
+
+    if (kpstResult->uiTtl == 0) {
+        return;
+    }
+    for (int i = 0; i < RESOLVE_CACHE_PROBE; i++) {
+        ResolveCacheEntry *pstEntry = &g_astResolveCache[(uiSlot + (unsigned int)i) & (TCP_RESOLVE_CACHE_SIZE - 1)];
+        if (strcmp(pstEntry->achHost, kpchHost) == 0 || pstEntry->ullExpireNsec <= ullNow) {
+            pstVictim = pstEntry;
+            break;
+        }
+        if (pstVictim == NULL || pstEntry->ullExpireNsec < pstVictim->ullExpireNsec) {
+            pstVictim = pstEntry;
+        }
+    }
+    strcpy(pstVictim->achHost, kpchHost);
+    pstVictim->stResult = *kpstResult;
+    pstVictim->stResult.iCached = 0;
+    pstVictim->ullExpireNsec = ullNow + (unsigned long long)kpstResult->uiTtl * 1000000000ULL;
+}
+
+
+/*
+ * hosts 파일과 resolv.conf
+ */
+
+/**
+ * @brief IPv6 주소를 앞에 두고 두 목록을 이어 결과에 채웁니다.
+ */
+static void mergeResolvedAddrs(TcpResolveResult *pstResult, const TcpResolvedAddr *kpstV6, int iV6,
+                               const TcpResolvedAddr *kpstV4, int iV4)
+{
+    pstResult->iAddrs = 0;
+    for (int i = 0; i < iV6 && pstResult->iAddrs < TCP_RESOLVE_MAX_ADDRS; i++) {
+        pstResult->astAddrs[pstResult->iAddrs++] = kpstV6[i];
+    }
+    for (int i = 0; i < iV4 && pstResult->iAddrs < TCP_RESOLVE_MAX_ADDRS; i++) {
+        pstResult->astAddrs[pstResult->iAddrs++] = kpstV4[i];
+    }
+}
+
+/**
+ * @brief hosts 파일에서 이름을 찾습니다 (대소문자 무시, 여러 줄에 걸친 주소를 모두 모음).
+ *
+ * @return 찾으면 1, 없거나 파일을 읽지 못하면 0
+ */
+static int readHostsFile(const char *kpchPath, const char *kpchHost, TcpResolveResult *pstResult)
+{
+    char achLine[RESOLVE_LINE_SIZE];
+    TcpResolvedAddr astV4[TCP_RESOLVE_MAX_ADDRS];
+    TcpResolvedAddr astV6[TCP_RESOLVE_MAX_ADDRS];
+    int iV4 = 0;
+    int iV6 = 0;
+    FILE *pstFile = fopen(kpchPath, "r");
+
+    if (pstFile == NULL) {
+        return 0;
+    }
+    while (fgets(achLine, sizeof(achLine), pstFile) != NULL) {
+        char *pchSave = NULL;
+        char *pchComment = strchr(achLine, '#');
+        if (pchComment != NULL) {
+            *pchComment = '\0';
+        }
+        char *pchAddr = strtok_r(achLine, " \t\r\n", &pchSave);
+        if (pchAddr == NULL) {
+            continue;
+        }
+        for (char *pchName = strtok_r(NULL, " \t\r\n", &pchSave); pchName != NULL;
+             pchName = strtok_r(NULL, " \t\r\n", &pchSave)) {
+            if (strcasecmp(pchName, kpchHost) != 0) {
+                continue;
+            }
+            TcpResolvedAddr stAddr;
+            memset(&stAddr, 0, sizeof(stAddr));
+            if (inet_pton(AF_INET, pchAddr, stAddr.aucAddr) == 1 && iV4 < TCP_RESOLVE_MAX_ADDRS) {
+                stAddr.iFamily = AF_INET;
+                astV4[iV4++] = stAddr;
+            } else if (inet_pton(AF_INET6, pchAddr, stAddr.aucAddr) == 1 && iV6 < TCP_RESOLVE_MAX_ADDRS) {
+                stAddr.iFamily = AF_INET6;
+                astV6[iV6++] = stAddr;
+            }
+            break;
+        }
+    }
+    fclose(pstFile);
+
+    if (iV4 + iV6 == 0) {
+        return 0;
+    }
+    mergeResolvedAddrs(pstResult, astV6, iV6, astV4, iV4);
+    return 1;
+}
+
+/**
+ * @brief resolv.conf를 읽습니다. 네임서버가 없으면 glibc처럼 로컬 주소를 씁니다.
+ */
+static void readResolvConf(const TcpResolverConfig *kpstConfig, ResolvConf *pstConf)
+{
+    char achLine[RESOLVE_LINE_SIZE];
+    unsigned int uiTimeoutSec = 0;
+    unsigned int uiAttempts = 0;
+    int iPort = (int)orDefault(kpstConfig->uiNameserverPort, RESOLVE_DNS_PORT);
+    FILE *pstFile = fopen(kpstConfig->kpchResolvConfPath, "r");
+
+    memset(pstConf, 0, sizeof(*pstConf));
+    pstConf->iNdots = RESOLVE_DEFAULT_NDOTS;
+    while (pstFile != NULL && fgets(achLine, sizeof(achLine), pstFile) != NULL) {
+        char *pchSave = NULL;
+        char *pchKey = strtok_r(achLine, " \t\r\n", &pchSave);
+        if (pchKey == NULL || pchKey[0] == '#' || pchKey[0] == ';') {
+            continue;
+        }
+        if (strcmp(pchKey, "nameserver") == 0) {
+            char *pchAddr = strtok_r(NULL, " \t\r\n", &pchSave);
+            TcpResolveResult stAddr;
+            if (pchAddr == NULL || pstConf->iServers == TCP_RESOLVE_MAX_SERVERS
+                || !parseNumericHost(pchAddr, &stAddr)) {
+                continue;
+            }
+            pstConf->auiServerLens[pstConf->iServers] =
+                makeResolvedSockAddr(&stAddr.astAddrs[0], iPort, &pstConf->astServers[pstConf->iServers]);
+            pstConf->iServers++;
+        } else if (strcmp(pchKey, "search") == 0 || strcmp(pchKey, "domain") == 0) {
+            // 둘 중 나중에 나온 줄이 앞의 목록을 대체
+            pstConf->iSearch = 0;
+            for (char *pchDomain = strtok_r(NULL, " \t\r\n", &pchSave);
+                 pchDomain != NULL && pstConf->iSearch < TCP_RESOLVE_MAX_SEARCH;
+                 pchDomain = strtok_r(NULL, " \t\r\n", &pchSave)) {
+                if (normalizeHost(pchDomain, pstConf->aachSearch[pstConf->iSearch]) == 0) {
+                    pstConf->iSearch++;
+                }
+            }
+        } else if (strcmp(pchKey, "options") == 0) {
+            for (char *pchOption = strtok_r(NULL, " \t\r\n", &pchSave); pchOption != NULL;
+                 pchOption = strtok_r(NULL, " \t\r\n", &pchSave)) {
+                if (strncmp(pchOption, "timeout:", 8) == 0) {
+                    uiTimeoutSec = (unsigned int)atoi(pchOption + 8);
+                } else if (strncmp(pchOption, "attempts:", 9) == 0) {
+                    uiAttempts = (unsigned int)atoi(pchOption + 9);
+                } else if (strncmp(pchOption, "ndots:", 6) == 0) {
+                    pstConf->iNdots = atoi(pchOption + 6);
+                }
+            }
+        }
+    }
+    if (pstFile != NULL) {
+        fclose(pstFile);
+    }
+
+    if (pstConf->iServers == 0) {
+        TcpResolveResult stAddr;
+        parseNumericHost("127.0.0.1", &stAddr);
+        pstConf->auiServerLens[0] = makeResolvedSockAddr(&stAddr.astAddrs[0], iPort, &pstConf->astServers[0]);
+        pstConf->iServers = 1;
+    }
+    pstConf->uiTimeoutMsec = orDefault(kpstConfig->uiTimeoutMsec,
+                                       orDefault(uiTimeoutSec * 1000, TCP_RESOLVE_DEFAULT_TIMEOUT));
+    pstConf->uiAttempts = orDefault(kpstConfig->uiAttempts, orDefault(uiAttempts, TCP_RESOLVE_DEFAULT_ATTEMPTS));
+}
+
+
+/*
+ * DNS 질의
+ */
+
+/**
+ * @brief 커널 난수(getrandom())로 버퍼를 채웁니다.
+ *
+ * @details 경로 밖에서 위조한 응답을 받아들이지 않도록(RFC 5452) 질의 ID와 출발지 포트는
+ *          추측할 수 있는 시계나 스레드 ID가 아닌 커널 난수로 정합니다.
+ */
+static int readDnsRandom(void *pvBuffer, size_t uiLength)
+{
+    ssize_t lRead;
+
+    do {
+        lRead = getrandom(pvBuffer, uiLength, 0);
+    } while (lRead < 0 && errno == EINTR);
+    if (lRead != (ssize_t)uiLength) {
+        perror("getrandom failed");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 질의 소켓을 임시 포트 범위 안의 무작위 포트에 바인드합니다.
+ *
+ * @details 골라 둔 포트가 모두 사용 중이면 커널이 자동으로 고르는 포트에 맡깁니다.
+ */
+static void bindRandomDnsPort(int iSock, int iFamily)
+{
+    unsigned int uiMin = RESOLVE_PORT_MIN;
+    unsigned int uiMax = RESOLVE_PORT_MAX;
+    FILE *pstFile = fopen(RESOLVE_PORT_RANGE_PATH, "r");
+
+    if (pstFile != NULL) {
+        unsigned int uiLow;
+        unsigned int uiHigh;
+        if (fscanf(pstFile, "%u %u", &uiLow, &uiHigh) == 2 && uiLow >= 1024 && uiLow < uiHigh && uiHigh <= 65535) {
+            uiMin = uiLow;
+            uiMax = uiHigh;
+        }
+        fclose(pstFile);
+    }
+
+    for (int i = 0; i < RESOLVE_PORT_TRIES; i++) {
+        unsigned int uiRandom;
+        struct sockaddr_storage stLocal;
+        socklen_t uiLocalLen;
+
+        if (readDnsRandom(&uiRandom, sizeof(uiRandom)) != 0) {
+            return;
+        }
+        unsigned short usPort = htons((unsigned short)(uiMin + uiRandom % (uiMax - uiMin + 1)));
+        memset(&stLocal, 0, sizeof(stLocal));
+        if (iFamily == AF_INET6) {
+            ((struct sockaddr_in6 *)&stLocal)->sin6_family = AF_INET6;
+            ((struct sockaddr_in6 *)&stLocal)->sin6_port = usPort;
+            uiLocalLen = sizeof(struct sockaddr_in6);
+        } else {
+            ((struct sockaddr_in *)&stLocal)->sin_family = AF_INET;
+            ((struct sockaddr_in *)&stLocal)->sin_port = usPort;
+            uiLocalLen = sizeof(struct sockaddr_in);
+        }
+        if (bind(iSock, (struct sockaddr *)&stLocal, uiLocalLen) == 0 || errno != EADDRINUSE) {
+            return;
+        }
+    }
+}
+
+static unsigned int readDns16(const unsigned char *kpucData)
+{
+    return ((unsigned int)kpucData[0] << 8) | kpucData[1];
+}
+
+static unsigned int readDns32(const unsigned char *kpucData)
+{
+    return (readDns16(kpucData) << 16) | readDns16(kpucData + 2);
+}
+
+/**
+ * @brief 질의 패킷을 만듭니다.
+ *
+ * @return 패킷 길이, 이름이 올바르지 않으면 -1
+ */
+static int encodeDnsQuery(unsigned char *pucOut, unsigned short usId, const char *kpchName, int iType)
+{
+    int iOffset = DNS_HEADER_SIZE;
+
+    memset(pucOut, 0, DNS_HEADER_SIZE);
+    pucOut[0] = (unsigned char)(usId >> 8);
+    pucOut[1] = (unsigned char)usId;
+    pucOut[2] = (unsigned char)(DNS_FLAG_RD >> 8);
+    pucOut[5] = 1;
+
+    while (*kpchName != '\0') {
+        const char *kpchDot = strchr(kpchName, '.');
+        size_t uiLabel = (kpchDot != NULL) ? (size_t)(kpchDot - kpchName) : strlen(kpchName);
+        if (uiLabel == 0 || uiLabel > 63 || iOffset + (int)uiLabel + 1 > RESOLVE_PACKET_SIZE - 5) {
+            return -1;
+        }
+        pucOut[iOffset++] = (unsigned char)uiLabel;
+        memcpy(pucOut + iOffset, kpchName, uiLabel);
+        iOffset += (int)uiLabel;
+        kpchName += uiLabel + ((kpchDot != NULL) ? 1 : 0);
+    }
+    pucOut[iOffset++] = 0;
+    pucOut[iOffset++] = (unsigned char)(iType >> 8);
+    pucOut[iOffset++] = (unsigned char)iType;
+    pucOut[iOffset++] = 0;
+    pucOut[iOffset++] = DNS_CLASS_IN;
+    return iOffset;
+}
+
+/**
+ * @brief 압축 포인터를 포함한 이름 하나를 건너뜁니다.
+ *
+ * @return 이름 다음 위치, 잘못된 패킷이면 -1
+ */
+static int skipDnsName(const unsigned char *kpucPacket, int iLength, int iOffset)
+{
+    while (iOffset < iLength) {
+        unsigned int uiLabel = kpucPacket[iOffset];
+        if (uiLabel == 0) {
+            return iOffset + 1;
+        }
+        if ((uiLabel & 0xc0) == 0xc0) {
+            return (iOffset + 2 <= iLength) ? iOffset + 2 : -1;
+        }
+        iOffset += (int)uiLabel + 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief 응답 하나를 해석하여 주소와 TTL을 모읍니다.
+ *
+ * @details 질문 부분이 보낸 질의와 같은지(대소문자 무시) 확인합니다. answer의 A/AAAA 레코드는
+ *          CNAME 사슬 끝의 주소이므로 이름과 관계없이 모두 모읍니다.
+ *
+ * @return 받아들인 응답이면 1, 다른 질의의 응답이면 0, 서버 오류이면 -1
+ */
+static int parseDnsResponse(const unsigned char *kpucPacket, int iLength, const unsigned char *kpucQuery,
+                            int iQueryLength, DnsAnswer *pstAnswer)
+{
+    if (iLength < iQueryLength || readDns16(kpucPacket) != readDns16(kpucQuery)
+        || !(readDns16(kpucPacket + 2) & DNS_FLAG_QR) || readDns16(kpucPacket + 4) != 1) {
+        return 0;
+    }
+    for (int i = DNS_HEADER_SIZE; i < iQueryLength; i++) {
+        if (tolower(kpucPacket[i]) != tolower(kpucQuery[i])) {
+            return 0;
+        }
+    }
+
+    // NXDOMAIN은 주소 없이 받아들이고 SOA로 부정 캐시 시간을 정함
+    unsigned int uiRcode = readDns16(kpucPacket + 2) & DNS_RCODE_MASK;
+    if (uiRcode != 0 && uiRcode != DNS_RCODE_NXDOMAIN) {
+        return -1;
+    }
+
+    unsigned int uiAnswers = readDns16(kpucPacket + 6);
+    unsigned int uiAuthority = readDns16(kpucPacket + 8);
+    int iOffset = iQueryLength;
+    for (unsigned int i = 0; i < uiAnswers + uiAuthority; i++) {
+        iOffset = skipDnsName(kpucPacket, iLength, iOffset);
+        if (iOffset < 0 || iOffset + 10 > iLength) {
+            break;
+        }
+        unsigned int uiType = readDns16(kpucPacket + iOffset);
+        unsigned int uiTtl = readDns32(kpucPacket + iOffset + 4);
+        int iRdLength = (int)readDns16(kpucPacket + iOffset + 8);
+        const unsigned char *kpucRdata = kpucPacket + iOffset + 10;
+        iOffset += 10 + iRdLength;
+        if (iOffset > iLength) {
+            break;
+        }
+
+        if (i < uiAnswers && uiType == DNS_TYPE_A && iRdLength == 4 && pstAnswer->iV4 < TCP_RESOLVE_MAX_ADDRS) {
+            TcpResolvedAddr *pstAddr = &pstAnswer->astV4[pstAnswer->iV4++];
+            memset(pstAddr, 0, sizeof(*pstAddr));
+            pstAddr->iFamily = AF_INET;
+            memcpy(pstAddr->aucAddr, kpucRdata, 4);
+        } else if (i < uiAnswers && uiType == DNS_TYPE_AAAA && iRdLength == 16
+                   && pstAnswer->iV6 < TCP_RESOLVE_MAX_ADDRS) {
+            TcpResolvedAddr *pstAddr = &pstAnswer->astV6[pstAnswer->iV6++];
+            pstAddr->iFamily = AF_INET6;
+            memcpy(pstAddr->aucAddr, kpucRdata, 16);
+        } else if (i >= uiAnswers && uiType == DNS_TYPE_SOA && iRdLength >= 20) {
+            // 부정 캐시 시간은 SOA 레코드 TTL과 SOA MINIMUM 중 작은 값 (RFC 2308)
+            unsigned int uiMinimum = readDns32(kpucRdata + iRdLength - 4);
+            unsigned int uiNegative = (uiTtl < uiMinimum) ? uiTtl : uiMinimum;
+            if (uiNegative < pstAnswer->uiNegativeTtl) {
+                pstAnswer->uiNegativeTtl = uiNegative;
+            }
+            continue;
+        } else {
+            continue;
+        }
+        if (uiTtl < pstAnswer->uiTtl) {
+            pstAnswer->uiTtl = uiTtl;
+        }
+    }
+    pstAnswer->iAnswered++;
+    return 1;
+}
+
+/**
+ * @brief 네임서버 하나에 A와 AAAA 질의를 함께 보내고 두 응답을 기다립니다.
+ *
+ * @return 응답을 모두 받았거나 하나라도 주소를 받았으면 0, 그 밖에는 -1
+ */
+static int queryDnsServer(const struct sockaddr *kpstServer, socklen_t uiServerLen, unsigned int uiTimeoutMsec,
+                          const char *kpchName, DnsAnswer *pstAnswer)
+{
+    static const int s_kaiTypes[2] = { DNS_TYPE_AAAA, DNS_TYPE_A };
+    unsigned char aaucQuery[2][RESOLVE_PACKET_SIZE];
+    int aiQueryLength[2];
+    int aiDone[2] = { 0, 0 };
+    unsigned char aucPacket[RESOLVE_PACKET_SIZE];
+
+    int iSock = socket(kpstServer->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (iSock < 0) {
+        perror("resolver socket");
+        return -1;
+    }
+    bindRandomDnsPort(iSock, kpstServer->sa_family);
+    if (connect(iSock, kpstServer, uiServerLen) < 0) {
+        close(iSock);
+        return -1;
+    }
+    unsigned short ausId[2];
+    if (readDnsRandom(ausId, sizeof(ausId)) != 0) {
+        close(iSock);
+        return -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        aiQueryLength[i] = encodeDnsQuery(aaucQuery[i], ausId[i], kpchName, s_kaiTypes[i]);
+        if (aiQueryLength[i] < 0 || send(iSock, aaucQuery[i], (size_t)aiQueryLength[i], 0) < 0) {
+            close(iSock);
+            return -1;
+        }
+        addMetricCounter(TCP_COUNTER_RESOLVE_QUERIES, 1);
+    }
+
+    unsigned long long ullDeadline = getMonotonicNsec() + (unsigned long long)uiTimeoutMsec * 1000000ULL;
+    int iResult = -1;
+    while (!(aiDone[0] && aiDone[1])) {
+        unsigned long long ullNow = getMonotonicNsec();
+        if (ullNow >= ullDeadline) {
+            break;
+        }
+        struct pollfd stPoll = { iSock, POLLIN, 0 };
+        int iReady = poll(&stPoll, 1, (int)((ullDeadline - ullNow + 999999ULL) / 1000000ULL));
+        if (iReady < 0 && errno == EINTR) {
+            continue;
+        }
+        if (iReady <= 0) {
+            break;
+        }
+        ssize_t lReceived = recv(iSock, aucPacket, sizeof(aucPacket), 0);
+        if (lReceived < DNS_HEADER_SIZE) {
+            continue;
+        }
+        for (int i = 0; i < 2; i++) {
+            int iParsed = aiDone[i] ? 0
+                          : parseDnsResponse(aucPacket, (int)lReceived, aaucQuery[i], aiQueryLength[i], pstAnswer);
+            if (iParsed != 0) {
+                aiDone[i] = 1;
+            }
+            if (iParsed < 0) {
+                aiDone[0] = 1;
+                aiDone[1] = 1;
+            }
+        }
+    }
+    close(iSock);
+
+    if (pstAnswer->iV4 + pstAnswer->iV6 > 0 || (aiDone[0] && aiDone[1] && pstAnswer->iAnswered == 2)) {
+        iResult = 0;
+    }
+    return iResult;
+}
+
+/**
+ * @brief 네임서버를 차례로 시도하여 이름 하나를 질의합니다.
+ */
+static int queryDns(const ResolvConf *kpstConf, const char *kpchName, DnsAnswer *pstAnswer)
+{
+    for (unsigned int uiAttempt = 0; uiAttempt < kpstConf->uiAttempts; uiAttempt++) {
+        for (int i = 0; i < kpstConf->iServers; i++) {
+            memset(pstAnswer, 0, sizeof(*pstAnswer));
+            pstAnswer->uiTtl = UINT_MAX;
+            pstAnswer->uiNegativeTtl = UINT_MAX;
+            if (queryDnsServer((const struct sockaddr *)&kpstConf->astServers[i], kpstConf->auiServerLens[i],
+                               kpstConf->uiTimeoutMsec, kpchName, pstAnswer) == 0) {
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief resolv.conf의 검색 도메인과 ndots에 따라 후보 이름을 차례로 질의합니다.
+ */
+static void resolveDnsName(const TcpResolverConfig *kpstConfig, const char *kpchHost, TcpResolveResult *pstResult)
+{
+    ResolvConf stConf;
+    DnsAnswer stAnswer;
+    char achName[TCP_RESOLVE_HOST_MAX];
+    char achCandidate[TCP_RESOLVE_HOST_MAX * 2];
+    unsigned int uiNegativeTtl = UINT_MAX;
+    int iDots = 0;
+
+    readResolvConf(kpstConfig, &stConf);
+    strcpy(achName, kpchHost);
+    size_t uiLength = strlen(achName);
+    int iAbsolute = (achName[uiLength - 1] == '.');
+    if (iAbsolute) {
+        achName[uiLength - 1] = '\0';
+    }
+    for (const char *kpchChar = achName; *kpchChar != '\0'; kpchChar++) {
+        iDots += (*kpchChar == '.');
+    }
+
+    // 점이 ndots 이상이면 이름 그대로 먼저, 아니면 검색 도메인을 먼저 붙여 봄
+    int iCandidates = iAbsolute ? 1 : stConf.iSearch + 1;
+    int iAsIsFirst = iAbsolute || iDots >= stConf.iNdots;
+    pstResult->iStatus = TCP_RESOLVE_NOT_FOUND;
+    pstResult->iSource = TCP_RESOLVE_SOURCE_DNS;
+    for (int i = 0; i < iCandidates; i++) {
+        int iSearch = iAsIsFirst ? i - 1 : i;
+        if (iSearch < 0 || iSearch == stConf.iSearch) {
+            snprintf(achCandidate, sizeof(achCandidate), "%s", achName);
+        } else {
+            snprintf(achCandidate, sizeof(achCandidate), "%s.%s", achName, stConf.aachSearch[iSearch]);
+        }
+        if (strlen(achCandidate) > 253) {
+            continue;
+        }
+        if (queryDns(&stConf, achCandidate, &stAnswer) < 0) {
+            pstResult->iStatus = -1;
+            return;
+        }
+        if (stAnswer.iV4 + stAnswer.iV6 > 0) {
+            mergeResolvedAddrs(pstResult, stAnswer.astV6, stAnswer.iV6, stAnswer.astV4, stAnswer.iV4);
+            pstResult->iStatus = 0;
+            pstResult->uiTtl = stAnswer.uiTtl;
+            return;
+        }
+        if (stAnswer.uiNegativeTtl < uiNegativeTtl) {
+            uiNegativeTtl = stAnswer.uiNegativeTtl;
+        }
+    }
+    pstResult->uiTtl = (uiNegativeTtl != UINT_MAX)
+                       ? uiNegativeTtl : orDefault(kpstConfig->uiNegativeTtl, TCP_RESOLVE_DEFAULT_NEGATIVE);
+}
+
+/**
+ * @brief 캐시에 없는 이름을 hosts 파일과 DNS로 해석하고 결과를 캐시합니다.
+ */
+static void resolveUncached(const char *kpchHost, TcpResolveResult *pstResult)
+{
+    TcpResolverConfig stConfig;
+    char achHosts[PATH_MAX];
+    char achConf[PATH_MAX];
+
+    snapshotResolveConfig(&stConfig, achHosts, achConf);
+    if (readHostsFile(stConfig.kpchHostsPath, kpchHost, pstResult)) {
+        pstResult->iStatus = 0;
+        pstResult->iSource = TCP_RESOLVE_SOURCE_HOSTS;
+        pstResult->uiTtl = orDefault(stConfig.uiHostsTtl, TCP_RESOLVE_DEFAULT_HOSTS_TTL);
+    } else {
+        resolveDnsName(&stConfig, kpchHost, pstResult);
+    }
+
+    if (pstResult->iStatus == -1) {
+        addMetricCounter(TCP_COUNTER_RESOLVE_FAILURES, 1);
+        pstResult->uiTtl = 0;
+        return;
+    }
+    unsigned int uiMaxTtl = orDefault(stConfig.uiMaxTtl, TCP_RESOLVE_DEFAULT_MAX_TTL);
+    if (pstResult->uiTtl > uiMaxTtl) {
+        pstResult->uiTtl = uiMaxTtl;
+    }
+    pthread_mutex_lock(&g_stResolveLock);
+    storeResolveCache(kpchHost, pstResult, getMonotonicNsec());
+    pthread_mutex_unlock(&g_stResolveLock);
+}
+
+/**
+ * @brief 숫자 주소와 캐시로 바로 답할 수 있는지 확인합니다.
+ *
+ * @return 답했으면 1, 해석이 필요하면 0, 이름이 올바르지 않으면 -1
+ */
+static int resolveFast(const char *kpchHost, char *pchNormalized, TcpResolveResult *pstResult)
+{
+    memset(pstResult, 0, sizeof(*pstResult));
+    pstResult->iStatus = -1;
+    if (normalizeHost(kpchHost, pchNormalized) < 0) {
+        fprintf(stderr, "resolveHost: invalid name\n");
+        return -1;
+    }
+    if (parseNumericHost(pchNormalized, pstResult)) {
+        return 1;
+    }
+
+    pthread_mutex_lock(&g_stResolveLock);
+    int iHit = lookupResolveCache(pchNormalized, getMonotonicNsec(), pstResult);
+    pthread_mutex_unlock(&g_stResolveLock);
+    if (iHit) {
+        addMetricCounter(TCP_COUNTER_RESOLVE_HITS, 1);
+    }
+    return iHit;
+}
+
+int resolveHost(const char *kpchHost, TcpResolveResult *pstResult)
+{
+    char achHost[TCP_RESOLVE_HOST_MAX];
+
+    if (resolveFast(kpchHost, achHost, pstResult) == 0) {
+        resolveUncached(achHost, pstResult);
+    }
+    return pstResult->iStatus;
+}
+
+
+/*
+ * 해석 스레드
+ */
+
+static void *runResolverThread(void *pvArg)
+{
+    (void)pvArg;
+
+    pthread_mutex_lock(&g_stResolveLock);
+    for (;;) {
+        while (!g_iResolveStop && g_iResolveQueued == 0) {
+            pthread_cond_wait(&g_stResolveWake, &g_stResolveLock);
+        }
+        if (g_iResolveStop) {
+            break;
+        }
+        ResolveJob stJob = g_astResolveQueue[g_iResolveHead];
+        g_iResolveHead = (g_iResolveHead + 1) % TCP_RESOLVE_MAX_QUEUE;
+        g_iResolveQueued--;
+        pthread_mutex_unlock(&g_stResolveLock);
+
+        // 같은 이름이 앞서 해석되었으면 캐시에서 바로 답함
+        char achHost[TCP_RESOLVE_HOST_MAX];
+        TcpResolveResult stResult;
+        if (resolveFast(stJob.achHost, achHost, &stResult) == 0) {
+            resolveUncached(achHost, &stResult);
+        }
+        stJob.pfnCallback(stJob.achHost, &stResult, stJob.pvArg);
+
+        pthread_mutex_lock(&g_stResolveLock);
+    }
+    pthread_mutex_unlock(&g_stResolveLock);
+    return NULL;
+}
+
+int resolveHostAsync(const char *kpchHost, TcpResolveCallback pfnCallback, void *pvArg)
+{
+    char achHost[TCP_RESOLVE_HOST_MAX];
+    TcpResolveResult stResult;
+
+    int iFast = resolveFast(kpchHost, achHost, &stResult);
+    if (iFast < 0) {
+        return -1;
+    }
+    if (iFast > 0) {
+        pfnCallback(kpchHost, &stResult, pvArg);
+        return 1;
+    }
+
+    pthread_mutex_lock(&g_stResolveLock);
+    if (g_iResolveThreads == 0 || g_iResolveQueued == TCP_RESOLVE_MAX_QUEUE) {
+        pthread_mutex_unlock(&g_stResolveLock);
+        fprintf(stderr, "resolveHostAsync: %s\n", (g_iResolveThreads == 0) ? "resolver not started" : "queue full");
+        return -1;
+    }
+    ResolveJob *pstJob = &g_astResolveQueue[(g_iResolveHead + g_iResolveQueued) % TCP_RESOLVE_MAX_QUEUE];
+    strcpy(pstJob->achHost, kpchHost);
+    pstJob->pfnCallback = pfnCallback;
+    pstJob->pvArg = pvArg;
+    g_iResolveQueued++;
+    pthread_cond_signal(&g_stResolveWake);
+    pthread_mutex_unlock(&g_stResolveLock);
+    return 0;
+}
+
+int startResolver(const TcpResolverConfig *kpstConfig)
+{
+    pthread_mutex_lock(&g_stResolveLock);
+    if (g_iResolveThreads > 0) {
+        pthread_mutex_unlock(&g_stResolveLock);
+        fprintf(stderr, "resolver already running\n");
+        return -1;
+    }
+    memset(&g_stResolveConfig, 0, sizeof(g_stResolveConfig));
+    g_achHostsPath[0] = '\0';
+    g_achResolvConfPath[0] = '\0';
+    if (kpstConfig != NULL) {
+        g_stResolveConfig = *kpstConfig;
+        if (kpstConfig->kpchHostsPath != NULL) {
+            snprintf(g_achHostsPath, sizeof(g_achHostsPath), "%s", kpstConfig->kpchHostsPath);
+        }
+        if (kpstConfig->kpchResolvConfPath != NULL) {
+            snprintf(g_achResolvConfPath, sizeof(g_achResolvConfPath), "%s", kpstConfig->kpchResolvConfPath);
+        }
+    }
+    g_stResolveConfig.kpchHostsPath = NULL;
+    g_stResolveConfig.kpchResolvConfPath = NULL;
+    g_iResolveStop = 0;
+
+    unsigned int uiThreads = orDefault(g_stResolveConfig.uiThreads, TCP_RESOLVE_DEFAULT_THREADS);
+    if (uiThreads > TCP_RESOLVE_MAX_THREADS) {
+        uiThreads = TCP_RESOLVE_MAX_THREADS;
+    }
+    for (unsigned int i = 0; i < uiThreads; i++) {
+        if (pthread_create(&g_astResolveThreads[g_iResolveThreads], NULL, runResolverThread, NULL) != 0) {
+            perror("pthread_create failed");
+            break;
+        }
+        pthread_setname_np(g_astResolveThreads[g_iResolveThreads], "tcp-resolve");
+        g_iResolveThreads++;
+    }
+    int iStarted = g_iResolveThreads;
+    pthread_mutex_unlock(&g_stResolveLock);
+
+    if (iStarted < (int)uiThreads) {
+        stopResolver();
+        return -1;
+    }
+    return 0;
+}
+
+void stopResolver(void)
+{
+    ResolveJob stJob;
+
+    pthread_mutex_lock(&g_stResolveLock);
+    g_iResolveStop = 1;
+    pthread_cond_broadcast(&g_stResolveWake);
+    pthread_mutex_unlock(&g_stResolveLock);
+    for (int i = 0; i < g_iResolveThreads; i++) {
+        pthread_join(g_astResolveThreads[i], NULL);
+    }
+
+    pthread_mutex_lock(&g_stResolveLock);
+    g_iResolveThreads = 0;
+    g_iResolveStop = 0;
+    while (g_iResolveQueued > 0) {
+        TcpResolveResult stResult;
+        stJob = g_astResolveQueue[g_iResolveHead];
+        g_iResolveHead = (g_iResolveHead + 1) % TCP_RESOLVE_MAX_QUEUE;
+        g_iResolveQueued--;
+        pthread_mutex_unlock(&g_stResolveLock);
+        memset(&stResult, 0, sizeof(stResult));
+        stResult.iStatus = -1;
+        stJob.pfnCallback(stJob.achHost, &stResult, stJob.pvArg);
+        pthread_mutex_lock(&g_stResolveLock);
+    }
+    memset(g_astResolveCache, 0, sizeof(g_astResolveCache));
+    memset(&g_stResolveConfig, 0, sizeof(g_stResolveConfig));
+    g_achHostsPath[0] = '\0';
+    g_achResolvConfPath[0] = '\0';
+    pthread_mutex_unlock(&g_stResolveLock);
+}
+
+void flushResolverCache(void)
+{
+    pthread_mutex_lock(&g_stResolveLock);
+    memset(g_astResolveCache, 0, sizeof(g_astResolveCache));
+    pthread_mutex_unlock(&g_stResolveLock);
+}
+
+
+/*
+ * 엔드포인트
+ */
+int parseEndpoint(const char *kpchEndpoint, char *pchHost, size_t uiHostSize, int *piPort)
+{
+    const char *kpchHostStart = kpchEndpoint;
+    const char *kpchHostEnd;
+    const char *kpchPort;
+
+    if (kpchEndpoint[0] == '[') {
+        kpchHostStart = kpchEndpoint + 1;
+        kpchHostEnd = strchr(kpchHostStart, ']');
+        if (kpchHostEnd == NULL || kpchHostEnd[1] != ':') {
+            fprintf(stderr, "parseEndpoint: invalid endpoint %s\n", kpchEndpoint);
+            return -1;
+        }
+        kpchPort = kpchHostEnd + 2;
+    } else {
+        kpchHostEnd = strrchr(kpchEndpoint, ':');
+        // 괄호 없는 IPv6 주소는 포트와 구분할 수 없음
+        if (kpchHostEnd == NULL || memchr(kpchEndpoint, ':', (size_t)(kpchHostEnd - kpchEndpoint)) != NULL) {
+            fprintf(stderr, "parseEndpoint: invalid endpoint %s\n", kpchEndpoint);
+            return -1;
+        }
+        kpchPort = kpchHostEnd + 1;
+    }
+
+    char *pchEnd = NULL;
+    long lPort = strtol(kpchPort, &pchEnd, 10);
+    size_t uiLength = (size_t)(kpchHostEnd - kpchHostStart);
+    if (uiLength == 0 || uiLength >= uiHostSize || pchEnd == kpchPort || *pchEnd != '\0' || lPort <= 0
+        || lPort > 65535) {
+        fprintf(stderr, "parseEndpoint: invalid endpoint %s\n", kpchEndpoint);
+        return -1;
+    }
+    memcpy(pchHost, kpchHostStart, uiLength);
+    pchHost[uiLength] = '\0';
+    *piPort = (int)lPort;
+    return 0;
+}
+
+socklen_t makeResolvedSockAddr(const TcpResolvedAddr *kpstAddr, int iPort, struct sockaddr_storage *pstStorage)
+{
+    memset(pstStorage, 0, sizeof(*pstStorage));
+    if (kpstAddr->iFamily == AF_INET6) {
+        struct sockaddr_in6 *pstIn6 = (struct sockaddr_in6 *)pstStorage;
+        pstIn6->sin6_family = AF_INET6;
+        pstIn6->sin6_port = htons((unsigned short)iPort);
+        memcpy(&pstIn6->sin6_addr, kpstAddr->aucAddr, 16);
+        return sizeof(*pstIn6);
+    }
+    struct sockaddr_in *pstIn = (struct sockaddr_in *)pstStorage;
+    pstIn->sin_family = AF_INET;
+    pstIn->sin_port = htons((unsigned short)iPort);
+    memcpy(&pstIn->sin_addr, kpstAddr->aucAddr, 4);
+    return sizeof(*pstIn);
+}
+
+int createClientSocketTo(const char *kpchEndpoint)
+{
+    char achHost[TCP_RESOLVE_HOST_MAX];
+    TcpResolveResult stResult;
+    int iPort;
+
+    if (parseEndpoint(kpchEndpoint, achHost, sizeof(achHost), &iPort) < 0) {
+        return -1;
+    }
+    if (resolveHost(achHost, &stResult) != 0) {
+        fprintf(stderr, "createClientSocketTo: cannot resolve %s\n", achHost);
+        return -1;
+    }
+
+    struct sockaddr_storage astAddrs[TCP_RESOLVE_MAX_ADDRS];
+    for (int i = 0; i < stResult.iAddrs; i++) {
+        makeResolvedSockAddr(&stResult.astAddrs[i], iPort, &astAddrs[i]);
+    }
+    pthread_mutex_lock(&g_stResolveLock);
+    int iDelayMsec = (int)orDefault(g_stResolveConfig.uiAttemptDelayMsec, TCP_CONNECT_RACE_DELAY);
+    int iTimeoutMsec = (int)g_stResolveConfig.uiConnectTimeoutMsec;
+    pthread_mutex_unlock(&g_stResolveLock);
+    return createClientSocketRace(astAddrs, stResult.iAddrs, iDelayMsec, iTimeoutMsec);
+}
@@ -0,0 +1,566 @@
+/**
+ * @file tcp-resp.c
+ * @brief RESP2/RESP3 코덱과 파이프라인 클라이언트 구현
+ *
+ * Redis 직렬화 프로토콜(RESP) 값을 호출자가 제공한 수신 버퍼 안에서 해석하여 문자열을 복사하지
+ * 않고 가리키기만 합니다. 클라이언트는 명령을 송신 버퍼에 쌓아 두었다가 writev() 한 번으로
+ * 보내고, 응답은 보낸 순서대로 각 명령의 콜백으로 넘깁니다. 명령마다 왕복 시간을 기다리지
+ * 않으므로 처리량은 파이프라인 깊이에 비례해 늘어납니다.
+ *
+ * 주요 기능:
+ * - RESP2/RESP3 값 해석 (집합은 평탄한 전위 순서 배열로, attribute는 건너뜀)
+ * - 명령 인코딩 (짧은 인자는 송신 버퍼로 복사, 긴 인자는 iovec으로 참조)
+ * - 명령 번호로 기다리는 순서 보장 응답 처리와 RESP3 push 분리
+ */
+#include "tcp-resp.h"
+#include "tcp-sock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/**
+ * @brief   double 값 원문 최대 길이
+ */
+#define RESP_DOUBLE_MAX         64
+
+/**
+ * @brief   명령 헤더("*<n>\r\n")나 인자 헤더("$<n>\r\n")의 최대 길이
+ */
+#define RESP_HEADER_MAX         24
+
+
+/*
+ * 값 해석
+ */
+static int parseRespInteger(const char *kpchData, const char *kpchEnd, long long *pllValue)
+{
+    int iNegative = 0;
+    unsigned long long ullValue = 0;
+
+    if (kpchData < kpchEnd && (*kpchData == '-' || *kpchData == '+')) {
+        iNegative = (*kpchData == '-');
+        kpchData++;
+    }
+    if (kpchData == kpchEnd || kpchEnd - kpchData > 19) {
+        return -1;
+    }
+    for (; kpchData < kpchEnd; kpchData++) {
+        if (*kpchData < '0' || *kpchData > '9') {
+            return -1;
+        }
+        ullValue = ullValue * 10 + (unsigned long long)(*kpchData - '0');
+    }
+    if (ullValue > (unsigned long long)LLONG_MAX + (unsigned long long)iNegative) {
+        return -1;
+    }
+    *pllValue = iNegative ? (long long)(0ULL - ullValue) : (long long)ullValue;
+    return 0;
+}
+
+/**
+ * @brief kpchCur에서 시작하는 값 하나를 해석하여 pstValues[*piUsed]부터 저장합니다.
+ *
+ * @return 값의 길이, 데이터가 부족하면 0, 잘못된 형식이면 -1, 값 배열이 부족하면 TCP_RESP_ERR_TOO_MANY
+ */
+static int parseRespAt(const char *kpchCur, const char *kpchEnd, TcpRespValue *pstValues, int iMaxValues,
+                       int *piUsed, int iDepth)
+{
+    const char *kpchStart = kpchCur;
+
+    if (iDepth > TCP_RESP_MAX_DEPTH) {
+        return -1;
+    }
+
+    const char *kpchLine;
+    const char *kpchCr;
+    const char *kpchNext;
+    unsigned char ucType;
+    long long llCount;
+    for (;;) {
+        if (kpchCur == kpchEnd) {
+            return 0;
+        }
+        kpchLine = kpchCur + 1;
+        kpchCr = (const char *)memchr(kpchLine, '\r', (size_t)(kpchEnd - kpchLine));
+        if (kpchCr == NULL || kpchCr + 1 == kpchEnd) {
+            return 0;
+        }
+        if (kpchCr[1] != '\n') {
+            return -1;
+        }
+        kpchNext = kpchCr + 2;
+        ucType = (unsigned char)*kpchCur;
+        if (ucType != TCP_RESP_ATTRIBUTE) {
+            break;
+        }
+
+        // attribute는 해석만 하고 버림. 이어지는 attribute도 재귀 없이 같은 깊이에서 건너뜀
+        int iMark = *piUsed;
+        if (parseRespInteger(kpchLine, kpchCr, &llCount) < 0 || llCount < 0 || llCount > (long long)INT_MAX) {
+            return -1;
+        }
+        for (long long i = 0; i < llCount * 2; i++) {
+            int iLength = parseRespAt(kpchNext, kpchEnd, pstValues, iMaxValues, piUsed, iDepth + 1);
+            if (iLength <= 0) {
+                return iLength;
+            }
+            kpchNext += iLength;
+        }
+        *piUsed = iMark;
+        kpchCur = kpchNext;
+    }
+
+    if (*piUsed == iMaxValues) {
+        return TCP_RESP_ERR_TOO_MANY;
+    }
+    int iIndex = (*piUsed)++;
+    TcpRespValue *pstValue = &pstValues[iIndex];
+    memset(pstValue, 0, sizeof(*pstValue));
+    pstValue->ucType = ucType;
+
+    switch (ucType) {
+    case TCP_RESP_SIMPLE:
+    case TCP_RESP_ERROR:
+    case TCP_RESP_BIG_NUMBER:
+        pstValue->kpchData = kpchLine;
+        pstValue->uiLength = (size_t)(kpchCr - kpchLine);
+        break;
+
+    case TCP_RESP_INTEGER:
+        if (parseRespInteger(kpchLine, kpchCr, &pstValue->llInteger) < 0) {
+            return -1;
+        }
+        break;
+
+    case TCP_RESP_DOUBLE: {
+        char achDouble[RESP_DOUBLE_MAX];
+        char *pchParsed;
+        size_t uiLength = (size_t)(kpchCr - kpchLine);
+        if (uiLength == 0 || uiLength >= sizeof(achDouble)) {
+            return -1;
+        }
+        memcpy(achDouble, kpchLine, uiLength);
+        achDouble[uiLength] = '\0';
+        pstValue->dDouble = strtod(achDouble, &pchParsed);
+        if (pchParsed != achDouble + uiLength) {
+            return -1;
+        }
+        pstValue->kpchData = kpchLine;
+        pstValue->uiLength = uiLength;
+        break;
+    }
+
+    case TCP_RESP_BOOLEAN:
+        if (kpchCr - kpchLine != 1 || (*kpchLine != 't' && *kpchLine != 'f')) {
+            return -1;
+        }
+        pstValue->llInteger = (*kpchLine == 't');
+        break;
+
+    case TCP_RESP_NULL:
+        if (kpchCr != kpchLine) {
+            return -1;
+        }
+        pstValue->ucNull = 1;
+        break;
+
+    case TCP_RESP_BULK:
+    case TCP_RESP_BULK_ERROR:
+    case TCP_RESP_VERBATIM:
+        if (parseRespInteger(kpchLine, kpchCr, &llCount) < 0 || llCount < -1) {
+            return -1;
+        }
+        if (llCount == -1) {
+            if (ucType != TCP_RESP_BULK) {
+                return -1;
+            }
+            pstValue->ucNull = 1;
+            break;
+        }
+        if ((unsigned long long)llCount + 2 > (unsigned long long)(kpchEnd - kpchNext)) {
+            return 0;
+        }
+        if (kpchNext[llCount] != '\r' || kpchNext[llCount + 1] != '\n') {
+            return -1;
+        }
+        pstValue->kpchData = kpchNext;
+        pstValue->uiLength = (size_t)llCount;
+        if (ucType == TCP_RESP_VERBATIM) {
+            // "txt:" 같은 3바이트 형식 접두어를 뺌
+            if (llCount < 4 || kpchNext[3] != ':') {
+                return -1;
+            }
+            pstValue->kpchData += 4;
+            pstValue->uiLength -= 4;
+        }
+        kpchNext += llCount + 2;
+        break;
+
+    case TCP_RESP_ARRAY:
+    case TCP_RESP_MAP:
+    case TCP_RESP_SET:
+    case TCP_RESP_PUSH:
+        if (parseRespInteger(kpchLine, kpchCr, &llCount) < 0 || llCount < -1) {
+            return -1;
+        }
+        if (llCount == -1) {
+            if (ucType != TCP_RESP_ARRAY) {
+                return -1;
+            }
+            pstValue->ucNull = 1;
+            break;
+        }
+        if (ucType == TCP_RESP_MAP) {
+            llCount *= 2;
+        }
+        if (llCount > (long long)INT_MAX) {
+            return -1;
+        }
+        pstValue->uiElements = (size_t)llCount;
+        for (long long i = 0; i < llCount; i++) {
+            int iLength = parseRespAt(kpchNext, kpchEnd, pstValues, iMaxValues, piUsed, iDepth + 1);
+            if (iLength <= 0) {
+                return iLength;
+            }
+            kpchNext += iLength;
+        }
+        break;
+
+    default:
+        return -1;
+    }
+
+    pstValue->uiSpan = (unsigned int)(*piUsed - iIndex);
+    return (int)(kpchNext - kpchStart);
+}
+
+int parseRespValue(const void *kpvData, size_t uiLength, TcpRespValue *pstValues, int iMaxValues, int *piValues)
+{
+    const char *kpchData = (const char *)kpvData;
+    int iUsed = 0;
+
+    if (uiLength > (size_t)INT_MAX) {
+        uiLength = (size_t)INT_MAX;
+    }
+    int iResult = parseRespAt(kpchData, kpchData + uiLength, pstValues, iMaxValues, &iUsed, 1);
+    *piValues = (iResult > 0) ? iUsed : 0;
+    return iResult;
+}
+
+
+/*
+ * 인코딩
+ */
+int encodeRespHeader(char *pchOut, char chType, long long llValue)
+{
+    char achDigits[24];
+    unsigned long long ullValue = (llValue < 0) ? 0ULL - (unsigned long long)llValue : (unsigned long long)llValue;
+    int iDigits = 0;
+    int iLength = 0;
+
+    do {
+        achDigits[iDigits++] = (char)('0' + ullValue % 10);
+        ullValue /= 10;
+    } while (ullValue != 0);
+
+    pchOut[iLength++] = chType;
+    if (llValue < 0) {
+        pchOut[iLength++] = '-';
+    }
+    while (iDigits > 0) {
+        pchOut[iLength++] = achDigits[--iDigits];
+    }
+    pchOut[iLength++] = '\r';
+    pchOut[iLength++] = '\n';
+    return iLength;
+}
+
+int encodeRespCommand(char *pchOut, size_t uiSize, int iArgc, const char *const *kppchArgv,
+                      const size_t *kpuiArgLengths)
+{
+    size_t uiUsed = 0;
+
+    if (uiSize < RESP_HEADER_MAX) {
+        return -1;
+    }
+    uiUsed += (size_t)encodeRespHeader(pchOut, TCP_RESP_ARRAY, iArgc);
+    for (int i = 0; i < iArgc; i++) {
+        if (uiSize - uiUsed < RESP_HEADER_MAX + kpuiArgLengths[i] + 2) {
+            return -1;
+        }
+        uiUsed += (size_t)encodeRespHeader(pchOut + uiUsed, TCP_RESP_BULK, (long long)kpuiArgLengths[i]);
+        memcpy(pchOut + uiUsed, kppchArgv[i], kpuiArgLengths[i]);
+        uiUsed += kpuiArgLengths[i];
+        pchOut[uiUsed++] = '\r';
+        pchOut[uiUsed++] = '\n';
+    }
+    return (uiUsed > (size_t)INT_MAX) ? -1 : (int)uiUsed;
+}
+
+
+/*
+ * 코덱 파이프라인
+ */
+static int decodeRespCodec(void *pvState, void *pvData, size_t uiLength, TcpCodecMsg *pstMsg)
+{
+    TcpRespCodecState *pstState = (TcpRespCodecState *)pvState;
+    int iLength = parseRespValue(pvData, uiLength, pstState->pstValues, pstState->iMaxValues, &pstState->iValues);
+
+    if (iLength <= 0) {
+        return (iLength == 0) ? 0 : -1;
+    }
+    pstMsg->pvData = pvData;
+    pstMsg->uiLength = (size_t)iLength;
+    return iLength;
+}
+
+static int encodeRespCodec(TcpCodecPipe *pstPipe, void *pvState, struct iovec *pstIov, int iIov, int iMaxIov)
+{
+    (void)pstPipe;
+    (void)pvState;
+    (void)pstIov;
+    (void)iMaxIov;
+    return iIov;
+}
+
+static const TcpCodec g_stRespCodec = { "resp", decodeRespCodec, encodeRespCodec };
+
+const TcpCodec *getRespCodec(void)
+{
+    return &g_stRespCodec;
+}
+
+
+/*
+ * 클라이언트
+ */
+void initRespClient(TcpRespClient *pstClient, int iSock, void *pvBuffer, size_t uiCapacity,
+                    TcpRespValue *pstValues, int iMaxValues)
+{
+    pstClient->iSock = iSock;
+    pstClient->pchBuffer = (char *)pvBuffer;
+    pstClient->uiCapacity = uiCapacity;
+    pstClient->uiStart = 0;
+    pstClient->uiEnd = 0;
+    pstClient->pstValues = pstValues;
+    pstClient->iMaxValues = iMaxValues;
+    pstClient->iIov = 0;
+    pstClient->uiOutUsed = 0;
+    pstClient->ullQueued = 0;
+    pstClient->ullResolved = 0;
+    pstClient->pfnPush = NULL;
+    pstClient->pvPushArg = NULL;
+}
+
+void setRespPushHandler(TcpRespClient *pstClient, TcpRespCallback pfnPush, void *pvArg)
+{
+    pstClient->pfnPush = pfnPush;
+    pstClient->pvPushArg = pvArg;
+}
+
+int flushRespClient(TcpRespClient *pstClient)
+{
+    if (pstClient->iIov == 0) {
+        return 0;
+    }
+    int iResult = sendMessageV(pstClient->iSock, pstClient->astIov, pstClient->iIov);
+    pstClient->iIov = 0;
+    pstClient->uiOutUsed = 0;
+    return (iResult < 0) ? -1 : 0;
+}
+
+/**
+ * @brief 송신 버퍼에 바이트를 덧붙이고, 직전 iovec이 송신 버퍼의 끝을 가리키면 그 길이를 늘립니다.
+ */
+static void appendRespOut(TcpRespClient *pstClient, const void *kpvData, size_t uiLength)
+{
+    char *pchDest = pstClient->achOut + pstClient->uiOutUsed;
+    struct iovec *pstLast = (pstClient->iIov > 0) ? &pstClient->astIov[pstClient->iIov - 1] : NULL;
+
+    memcpy(pchDest, kpvData, uiLength);
+    if (pstLast != NULL && (char *)pstLast->iov_base + pstLast->iov_len == pchDest) {
+        pstLast->iov_len += uiLength;
+    } else {
+        pstLast = &pstClient->astIov[pstClient->iIov++];
+        pstLast->iov_base = pchDest;
+        pstLast->iov_len = uiLength;
+    }
+    pstClient->uiOutUsed += uiLength;
+}
+
+/**
+ * @brief 명령 하나에 필요한 송신 버퍼와 iovec 크기를 계산합니다.
+ */
+static void measureRespCommand(int iArgc, const size_t *kpuiArgLengths, size_t *puiOut, int *piIov)
+{
+    size_t uiOut = RESP_HEADER_MAX;
+    int iIov = 1;
+
+    for (int i = 0; i < iArgc; i++) {
+        if (kpuiArgLengths[i] <= TCP_RESP_INLINE_MAX) {
+            uiOut += RESP_HEADER_MAX + kpuiArgLengths[i] + 2;
+        } else {
+            // 인자 헤더, 인자, 다음 송신 버퍼 구간
+            uiOut += RESP_HEADER_MAX + 2;
+            iIov += 2;
+        }
+    }
+    *puiOut = uiOut;
+    *piIov = iIov;
+}
+
+long long queueRespCommand(TcpRespClient *pstClient, int iArgc, const char *const *kppchArgv,
+                           const size_t *kpuiArgLengths, TcpRespCallback pfnCallback, void *pvArg)
+{
+    char achHeader[RESP_HEADER_MAX];
+    size_t uiOut;
+    int iIov;
+
+    if (iArgc <= 0) {
+        fprintf(stderr, "queueRespCommand: empty command\n");
+        return -1;
+    }
+    measureRespCommand(iArgc, kpuiArgLengths, &uiOut, &iIov);
+    if (uiOut > TCP_RESP_OUT_SIZE || iIov > TCP_IOV_MAX) {
+        fprintf(stderr, "queueRespCommand: command with %d arguments does not fit in one batch\n", iArgc);
+        return -1;
+    }
+    if (pstClient->uiOutUsed + uiOut > TCP_RESP_OUT_SIZE || pstClient->iIov + iIov > TCP_IOV_MAX) {
+        if (flushRespClient(pstClient) < 0) {
+            return -1;
+        }
+    }
+    while (pstClient->ullQueued - pstClient->ullResolved >= TCP_RESP_MAX_PENDING) {
+        if (pumpRespClient(pstClient, 1) <= 0) {
+            return -1;
+        }
+    }
+
+    appendRespOut(pstClient, achHeader, (size_t)encodeRespHeader(achHeader, TCP_RESP_ARRAY, iArgc));
+    for (int i = 0; i < iArgc; i++) {
+        appendRespOut(pstClient, achHeader,
+                      (size_t)encodeRespHeader(achHeader, TCP_RESP_BULK, (long long)kpuiArgLengths[i]));
+        if (kpuiArgLengths[i] <= TCP_RESP_INLINE_MAX) {
+            appendRespOut(pstClient, kppchArgv[i], kpuiArgLengths[i]);
+        } else {
+            struct iovec *pstIov = &pstClient->astIov[pstClient->iIov++];
+            pstIov->iov_base = (void *)kppchArgv[i];
+            pstIov->iov_len = kpuiArgLengths[i];
+        }
+        appendRespOut(pstClient, "\r\n", 2);
+    }
+
+    TcpRespPending *pstPending = &pstClient->astPending[pstClient->ullQueued % TCP_RESP_MAX_PENDING];
+    pstPending->pfnCallback = pfnCallback;
+    pstPending->pvArg = pvArg;
+    return (long long)pstClient->ullQueued++;
+}
+
+/**
+ * @brief 해석하지 않은 응답을 버퍼 앞쪽으로 당기고 한 번 수신합니다.
+ *
+ * @return 수신한 바이트 수, 연결 종료 시 TCP_DISCONNECTION, 실패 시 -1
+ */
+static int fillRespBuffer(TcpRespClient *pstClient)
+{
+    if (pstClient->uiEnd == pstClient->uiCapacity) {
+        if (pstClient->uiStart == 0) {
+            fprintf(stderr, "fillRespBuffer: reply larger than %zu bytes\n", pstClient->uiCapacity);
+            return -1;
+        }
+        size_t uiPending = pstClient->uiEnd - pstClient->uiStart;
+        memmove(pstClient->pchBuffer, pstClient->pchBuffer + pstClient->uiStart, uiPending);
+        pstClient->uiStart = 0;
+        pstClient->uiEnd = uiPending;
+    }
+
+    int iReceived = recvMsgBlocking(pstClient->iSock, pstClient->pchBuffer + pstClient->uiEnd,
+                                    pstClient->uiCapacity - pstClient->uiEnd);
+    if (iReceived > 0) {
+        pstClient->uiEnd += (size_t)iReceived;
+    }
+    return iReceived;
+}
+
+int pumpRespClient(TcpRespClient *pstClient, int iMinReplies)
+{
+    int iResolved = 0;
+
+    if (flushRespClient(pstClient) < 0) {
+        return -1;
+    }
+    unsigned long long ullOutstanding = pstClient->ullQueued - pstClient->ullResolved;
+    if (iMinReplies < 0 || (unsigned long long)iMinReplies > ullOutstanding) {
+        iMinReplies = (int)ullOutstanding;
+    }
+
+    for (;;) {
+        int iValues;
+        int iLength = 0;
+
+        if (pstClient->ullQueued != pstClient->ullResolved || pstClient->uiStart != pstClient->uiEnd) {
+            iLength = parseRespValue(pstClient->pchBuffer + pstClient->uiStart, pstClient->uiEnd - pstClient->uiStart,
+                                     pstClient->pstValues, pstClient->iMaxValues, &iValues);
+        }
+        if (iLength < 0) {
+            fprintf(stderr, "pumpRespClient: %s reply on socket %d\n",
+                    (iLength == TCP_RESP_ERR_TOO_MANY) ? "oversized" : "malformed", pstClient->iSock);
+            return -1;
+        }
+        if (iLength == 0) {
+            if (iResolved >= iMinReplies) {
+                break;
+            }
+            if (pstClient->uiStart == pstClient->uiEnd) {
+                pstClient->uiStart = 0;
+                pstClient->uiEnd = 0;
+            }
+            int iReceived = fillRespBuffer(pstClient);
+            if (iReceived < 0) {
+                return -1;
+            }
+            if (iReceived == 0) {
+                // 이미 처리한 응답이 있으면 그 수를 먼저 돌려주고, 다음 호출에서 종료를 알림
+                return (iResolved > 0) ? iResolved : TCP_DISCONNECTION;
+            }
+            continue;
+        }
+        pstClient->uiStart += (size_t)iLength;
+
+        if (pstClient->pstValues[0].ucType == TCP_RESP_PUSH) {
+            // RESP3 push는 명령 응답이 아니므로 순서를 소비하지 않음
+            if (pstClient->pfnPush != NULL) {
+                pstClient->pfnPush(pstClient->pvPushArg, pstClient->pstValues, iValues);
+            }
+            continue;
+        }
+        if (pstClient->ullResolved == pstClient->ullQueued) {
+            fprintf(stderr, "pumpRespClient: unsolicited reply on socket %d\n", pstClient->iSock);
+            return -1;
+        }
+        TcpRespPending *pstPending = &pstClient->astPending[pstClient->ullResolved % TCP_RESP_MAX_PENDING];
+        pstClient->ullResolved++;
+        iResolved++;
+        if (pstPending->pfnCallback != NULL) {
+            pstPending->pfnCallback(pstPending->pvArg, pstClient->pstValues, iValues);
+        }
+    }
+    return iResolved;
+}
+
+int waitRespReply(TcpRespClient *pstClient, long long llCommand)
+{
+    if (llCommand < 0 || (unsigned long long)llCommand >= pstClient->ullQueued) {
+        fprintf(stderr, "waitRespReply: unknown command %lld\n", llCommand);
+        return -1;
+    }
+    while ((unsigned long long)llCommand >= pstClient->ullResolved) {
+        unsigned long long ullRemaining = (unsigned long long)llCommand + 1 - pstClient->ullResolved;
+        if (pumpRespClient(pstClient, (int)ullRemaining) <= 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
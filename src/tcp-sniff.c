@@ -0,0 +1,265 @@
+/**
+ * @file tcp-sniff.c
+ * @brief 수신 대기 포트 하나에서 프로토콜 자동 판별
+ *
+ * accept() 직후 연결의 첫 바이트를 MSG_PEEK으로 엿보아 등록한 코덱(길이 접두 프레이밍,
+ * HTTP, WebSocket 등)을 고르고 그 처리 함수로 소켓을 넘깁니다. 데이터를 소비하지 않으므로
+ * 코덱은 판별 단계가 없었던 것처럼 소켓에서 바로 수신하며, 사용자 공간 버퍼로 옮겨 두었다가
+ * 다시 넘기는 복사가 없습니다. TCP_DEFER_ACCEPT와 함께 쓰면 첫 데이터가 도착한 연결만
+ * accept되어 판별 단계에서 기다리는 일이 거의 없습니다.
+ *
+ * 주요 기능:
+ * - 코덱 등록 (등록 순서가 우선순위)
+ * - MSG_PEEK + SO_RCVLOWAT을 이용한 첫 바이트 판별
+ * - 프레이밍, HTTP, WebSocket 판별 함수
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tcp-sniff.h"
+#include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-frame.h"
+#include "tcp-http.h"
+#include "tcp-metrics.h"
+#include "tcp-probe.h"
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief   판별 중 데이터를 더 기다려야 함 (내부 전용)
+ */
+#define SNIFF_WAIT              -100
+
+/**
+ * @brief   HTTP 메서드 토큰 최대 길이
+ */
+#define SNIFF_METHOD_MAX        16
+
+typedef struct {
+    const char *kpchName;
+    TcpSniffMatcher pfnMatch;
+    TcpSniffHandler pfnHandler;
+    void *pvArg;
+} SniffCodec;
+
+static SniffCodec g_astSniffCodecs[TCP_SNIFF_MAX_CODECS];
+static int g_iSniffCodecs;
+
+
+int matchFrameProtocol(const unsigned char *kpucData, size_t uiLength)
+{
+    TcpFrameHeader stHeader;
+
+    // 길이 상한(16MB) 때문에 첫 바이트는 0 또는 1
+    if (kpucData[0] > (TCP_FRAME_MAX_PAYLOAD >> 24)) {
+        return TCP_SNIFF_NO_MATCH;
+    }
+    if (uiLength < TCP_FRAME_HEADER_SIZE) {
+        return TCP_SNIFF_NEED_MORE;
+    }
+    return (parseFrameHeader(kpucData, TCP_FRAME_HEADER_SIZE, &stHeader) < 0) ? TCP_SNIFF_NO_MATCH : TCP_SNIFF_MATCH;
+}
+
+int matchHttpProtocol(const unsigned char *kpucData, size_t uiLength)
+{
+    for (size_t i = 0; i < uiLength && i <= SNIFF_METHOD_MAX; i++) {
+        if (kpucData[i] == ' ') {
+            return (i > 0) ? TCP_SNIFF_MATCH : TCP_SNIFF_NO_MATCH;
+        }
+        if (kpucData[i] < 'A' || kpucData[i] > 'Z') {
+            return TCP_SNIFF_NO_MATCH;
+        }
+    }
+    return (uiLength <= SNIFF_METHOD_MAX) ? TCP_SNIFF_NEED_MORE : TCP_SNIFF_NO_MATCH;
+}
+
+int matchWsProtocol(const unsigned char *kpucData, size_t uiLength)
+{
+    TcpHttpRequest stRequest;
+
+    if (uiLength < 4) {
+        return (memcmp(kpucData, "GET ", uiLength) == 0) ? TCP_SNIFF_NEED_MORE : TCP_SNIFF_NO_MATCH;
+    }
+    if (memcmp(kpucData, "GET ", 4) != 0) {
+        return TCP_SNIFF_NO_MATCH;
+    }
+
+    int iHeader = parseHttpRequest(kpucData, uiLength, &stRequest);
+    if (iHeader == 0) {
+        return TCP_SNIFF_NEED_MORE;
+    }
+    if (iHeader < 0) {
+        return TCP_SNIFF_NO_MATCH;
+    }
+    const TcpHttpStr *kpstUpgrade = findHttpHeader(&stRequest, "Upgrade");
+    return (kpstUpgrade != NULL && hasHttpToken(kpstUpgrade, "websocket")) ? TCP_SNIFF_MATCH : TCP_SNIFF_NO_MATCH;
+}
+
+
+int registerSniffCodec(const char *kpchName, TcpSniffMatcher pfnMatch, TcpSniffHandler pfnHandler, void *pvArg)
+{
+    if (g_iSniffCodecs == TCP_SNIFF_MAX_CODECS) {
+        fprintf(stderr, "registerSniffCodec: more than %d codecs\n", TCP_SNIFF_MAX_CODECS);
+        return -1;
+    }
+    SniffCodec *pstCodec = &g_astSniffCodecs[g_iSniffCodecs];
+    pstCodec->kpchName = kpchName;
+    pstCodec->pfnMatch = pfnMatch;
+    pstCodec->pfnHandler = pfnHandler;
+    pstCodec->pvArg = pvArg;
+    return g_iSniffCodecs++;
+}
+
+void clearSniffCodecs(void)
+{
+    memset(g_astSniffCodecs, 0, sizeof(g_astSniffCodecs));
+    g_iSniffCodecs = 0;
+}
+
+const char *getSniffCodecName(int iCodec)
+{
+    return (iCodec >= 0 && iCodec < g_iSniffCodecs) ? g_astSniffCodecs[iCodec].kpchName : NULL;
+}
+
+int enableDeferredAccept(int iServerSock, int iSeconds)
+{
+    if (setsockopt(iServerSock, IPPROTO_TCP, TCP_DEFER_ACCEPT, &iSeconds, sizeof(iSeconds)) < 0) {
+        perror("Setsockopt TCP_DEFER_ACCEPT failed");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 우선순위 순서로 판별 함수를 적용합니다.
+ *
+ * @param iFinal 더 기다릴 수 없으면 1 (판단을 미룬 코덱은 불일치로 봄)
+ * @return 코덱 번호, 더 기다려야 하면 SNIFF_WAIT, 일치하는 코덱이 없으면 TCP_SNIFF_UNKNOWN
+ */
+static int matchSniffCodecs(const unsigned char *kpucData, size_t uiLength, int iFinal)
+{
+    for (int i = 0; i < g_iSniffCodecs; i++) {
+        int iResult = g_astSniffCodecs[i].pfnMatch(kpucData, uiLength);
+        if (iResult == TCP_SNIFF_MATCH) {
+            return i;
+        }
+        if (iResult == TCP_SNIFF_NEED_MORE && !iFinal) {
+            return SNIFF_WAIT;
+        }
+    }
+    return TCP_SNIFF_UNKNOWN;
+}
+
+static void setRecvLowat(int iSock, int iLowat)
+{
+    setsockopt(iSock, SOL_SOCKET, SO_RCVLOWAT, &iLowat, sizeof(iLowat));
+}
+
+int sniffProtocol(int iSock, int iTimeoutMs)
+{
+    unsigned char aucPeek[TCP_SNIFF_PEEK_SIZE];
+    unsigned long long ullDeadline = getMonotonicNsec() + (unsigned long long)iTimeoutMs * 1000000ULL;
+    size_t uiLast = 0;
+    int iLowat = 1;
+    int iHangup = 0;
+    int iResult;
+
+    for (;;) {
+        ssize_t peeked = recv(iSock, aucPeek, sizeof(aucPeek), MSG_PEEK | MSG_DONTWAIT);
+        if (peeked == 0) {
+            iResult = TCP_SNIFF_CLOSED;
+            break;
+        }
+        if (peeked < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("sniffProtocol: recv failed");
+                iResult = TCP_SNIFF_UNKNOWN;
+                break;
+            }
+            peeked = 0;
+        }
+
+        unsigned long long ullNow = getMonotonicNsec();
+        int iFinal = iHangup || ullNow >= ullDeadline || (size_t)peeked == sizeof(aucPeek);
+        if (peeked > 0) {
+            iResult = matchSniffCodecs(aucPeek, (size_t)peeked, iFinal);
+            if (iResult != SNIFF_WAIT) {
+                break;
+            }
+        } else if (iFinal) {
+            iResult = TCP_TIME_OUT;
+            break;
+        }
+
+        // 지금까지 받은 것보다 1바이트 더 도착해야 깨어나도록 함
+        if ((size_t)peeked + 1 != (size_t)iLowat) {
+            iLowat = (int)peeked + 1;
+            setRecvLowat(iSock, iLowat);
+        }
+        if ((size_t)peeked == uiLast && peeked > 0) {
+            // SO_RCVLOWAT을 따르지 않는 소켓(AF_UNIX 등)에서 같은 데이터로 계속 깨지 않도록 잠시 쉼
+            struct timespec stPause = { 0, 1000000L };
+            nanosleep(&stPause, NULL);
+        }
+        uiLast = (size_t)peeked;
+
+        struct pollfd stPoll;
+        stPoll.fd = iSock;
+        stPoll.events = POLLIN | POLLRDHUP;
+        stPoll.revents = 0;
+        int iWaitMs = (int)((ullDeadline - ullNow + 999999ULL) / 1000000ULL);
+        int iReady = poll(&stPoll, 1, iWaitMs);
+        if (iReady < 0 && errno != EINTR) {
+            perror("sniffProtocol: poll failed");
+            iResult = TCP_SNIFF_UNKNOWN;
+            break;
+        }
+        if (iReady > 0 && (stPoll.revents & (POLLRDHUP | POLLHUP | POLLERR))) {
+            iHangup = 1;
+        }
+    }
+
+    if (iLowat != 1) {
+        setRecvLowat(iSock, 1);
+    }
+    return iResult;
+}
+
+int dispatchSniffedConn(int iSock, int iTimeoutMs)
+{
+    int iCodec = sniffProtocol(iSock, iTimeoutMs);
+
+    if (iCodec < 0) {
+        if (iCodec == TCP_SNIFF_UNKNOWN) {
+            fprintf(stderr, "dispatchSniffedConn: unrecognized protocol on socket %d\n", iSock);
+        }
+        TCP_PROBE1(close, iSock);
+        removeConnInfo(iSock);
+        close(iSock);
+        return iCodec;
+    }
+
+    g_astSniffCodecs[iCodec].pfnHandler(iSock, g_astSniffCodecs[iCodec].pvArg);
+    return iCodec;
+}
+
+int acceptSniffedConn(int iServerSock, int iTimeoutMs)
+{
+    int iSock = acceptClientSocket(iServerSock);
+
+    if (iSock < 0) {
+        return TCP_SNIFF_ACCEPT_FAILED;
+    }
+    return dispatchSniffedConn(iSock, iTimeoutMs);
+}
@@ -17,18 +17,73 @@
  * @date 2024-12-04
  */
 #include "tcp-sock.h"
+#include "tcp-conn.h"
+#include "tcp-capture.h"
+#include "tcp-cost.h"
+#include "tcp-impair.h"
+#include "tcp-metrics.h"
+#include "tcp-probe.h"
 
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
-#include <sys/select.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include <fcntl.h>
+#include <errno.h>
+
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @brief 타임스탬프 제어 메시지를 받기 위한 버퍼 크기
+ */
+#define TSTAMP_CONTROL_SIZE     256
+
+
+static unsigned long long timespecToNsec(const struct timespec *pstTime)
+{
+    return (unsigned long long)pstTime->tv_sec * 1000000000ULL + (unsigned long long)pstTime->tv_nsec;
+}
+
+static void recordTxSend(TcpConnInfo *pstConn, size_t uiSent, unsigned long long ullSendNsec)
+{
+    TcpTxStampRing *pstRing = pstConn->pstTxStamps;
+    unsigned int uiKey = pstConn->uiTxKey + (unsigned int)uiSent - 1;
+
+    pstConn->uiTxKey += (unsigned int)uiSent;
+    if (pstRing->uiHead - pstRing->uiTail == TCP_TX_STAMP_SLOTS) {
+        pstRing->uiTail++;
+    }
+    pstRing->auiKey[pstRing->uiHead % TCP_TX_STAMP_SLOTS] = uiKey;
+    pstRing->aullSendNsec[pstRing->uiHead % TCP_TX_STAMP_SLOTS] = ullSendNsec;
+    pstRing->uiHead++;
+}
+
+static unsigned long long matchTxSend(TcpConnInfo *pstConn, unsigned int uiId)
+{
+    TcpTxStampRing *pstRing = pstConn->pstTxStamps;
+
+    // ACK는 전송 순서대로 도착하므로, 앞선 ID의 기록(타임스탬프 유실)은 버림
+    while (pstRing->uiTail != pstRing->uiHead) {
+        unsigned int uiSlot = pstRing->uiTail % TCP_TX_STAMP_SLOTS;
+        int iDiff = (int)(pstRing->auiKey[uiSlot] - uiId);
+        if (iDiff > 0) {
+            break;
+        }
+        pstRing->uiTail++;
+        if (iDiff == 0) {
+            return pstRing->aullSendNsec[uiSlot];
+        }
+    }
+    return 0;
+}
+
 
 int isPortAvailable(int iPort) 
 {
@@ -55,9 +110,9 @@ int createServerSocket(int iPort, int iMaxClients)
     struct sockaddr_in stSockAddr;
     int iSockOpt = 1;
 
-    if ((iServerSock = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+    if ((iServerSock = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
         perror("Socket failed");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     /**
@@ -65,7 +120,8 @@ int createServerSocket(int iPort, int iMaxClients)
      */
     if (setsockopt(iServerSock, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &iSockOpt, sizeof(iSockOpt))) {
         perror("Setsockopt failed");
-        exit(EXIT_FAILURE);
+        close(iServerSock);
+        return -1;
     }
 
     // TCP Keep-Alive 설정 추가
@@ -81,7 +137,8 @@ int createServerSocket(int iPort, int iMaxClients)
      */
     if (setsockopt(iServerSock, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive)) < 0) {
         perror("Setsockopt SO_KEEPALIVE failed");
-        exit(EXIT_FAILURE);
+        close(iServerSock);
+        return -1;
     }
     /**
      * @brief 첫 번째 Keep-Alive 프로브를 보내기 전에 대기하는 시간을 설정합니다.
@@ -90,7 +147,8 @@ int createServerSocket(int iPort, int iMaxClients)
      */
     if (setsockopt(iServerSock, IPPROTO_TCP, TCP_KEEPIDLE, &keepidle, sizeof(keepidle)) < 0) {
         perror("Setsockopt TCP_KEEPIDLE failed");
-        exit(EXIT_FAILURE);
+        close(iServerSock);
+        return -1;
     }
     /**
      * @brief Keep-Alive 프로브 간의 간격을 설정합니다.
@@ -99,7 +157,8 @@ int createServerSocket(int iPort, int iMaxClients)
      */
     if (setsockopt(iServerSock, IPPROTO_TCP, TCP_KEEPINTVL, &keepinterval, sizeof(keepinterval)) < 0) {
         perror("Setsockopt TCP_KEEPINTVL failed");
-        exit(EXIT_FAILURE);
+        close(iServerSock);
+        return -1;
     }
     /**
      * @brief 연결이 끊긴 것으로 간주하기 전까지 보낼 최대 Keep-Alive 프로브 수를 설정합니다.
@@ -108,7 +167,8 @@ int createServerSocket(int iPort, int iMaxClients)
      */
     if (setsockopt(iServerSock, IPPROTO_TCP, TCP_KEEPCNT, &keepcount, sizeof(keepcount)) < 0) {
         perror("Setsockopt TCP_KEEPCNT failed");
-        exit(EXIT_FAILURE);
+        close(iServerSock);
+        return -1;
     }
 
     stSockAddr.sin_family = AF_INET;
@@ -117,19 +177,45 @@ int createServerSocket(int iPort, int iMaxClients)
 
     if (bind(iServerSock, (struct sockaddr *)&stSockAddr, sizeof(stSockAddr)) < 0) {
         perror("Bind failed");
-        exit(EXIT_FAILURE);
+        close(iServerSock);
+        return -1;
     }
 
     if (listen(iServerSock, iMaxClients) < 0) {
         perror("Listen failed");
-        exit(EXIT_FAILURE);
+        close(iServerSock);
+        return -1;
     }
 
     return iServerSock;
 }
 
 
+/**
+ * @brief 소켓을 서버에 연결하고 연결 통계, 추적점, 캡처를 기록합니다. 실패하면 소켓을 닫습니다.
+ */
+static int connectClientSocket(int iSock, const struct sockaddr *kpstAddr, socklen_t uiAddrLen, int iPort) {
+    TCP_PROBE2(connect_start, iSock, iPort);
+    if (connect(iSock, kpstAddr, uiAddrLen) < 0) {
+        TCP_PROBE3(connect_done, iSock, -1, errno);
+        addMetricCounter(TCP_COUNTER_CONNECT_FAILURES, 1);
+        perror("Connection failed");
+        close(iSock);
+        return -1;
+    }
+    TCP_PROBE3(connect_done, iSock, 0, 0);
+    addMetricCounter(TCP_COUNTER_CONNECTS, 1);
+    registerConnInfo(iSock);
+    captureTraffic(iSock, TCP_CAPTURE_CONNECT, NULL, 0);
+
+    return iSock;
+}
+
 int createClientSocket(const char *kpchIp, int iPort) {
+    return createClientSocketFrom(NULL, kpchIp, iPort);
+}
+
+int createClientSocketFrom(const char *kpchLocalIp, const char *kpchIp, int iPort) {
     int iSock;
     struct sockaddr_in stSockServAddr;
 
@@ -143,19 +229,217 @@ int createClientSocket(const char *kpchIp, int iPort) {
 
     if (inet_pton(AF_INET, kpchIp, &stSockServAddr.sin_addr) <= 0) {
         perror("Invalid address/ Address not supported");
+        close(iSock);
         return -1;
     }
 
-    if (connect(iSock, (struct sockaddr *)&stSockServAddr, sizeof(stSockServAddr)) < 0) {
-        perror("Connection failed");
+    if (kpchLocalIp != NULL) {
+        struct sockaddr_in stSockLocalAddr;
+        memset(&stSockLocalAddr, 0, sizeof(stSockLocalAddr));
+        stSockLocalAddr.sin_family = AF_INET;
+        stSockLocalAddr.sin_port = 0;
+        if (inet_pton(AF_INET, kpchLocalIp, &stSockLocalAddr.sin_addr) <= 0) {
+            perror("Invalid local address");
+            close(iSock);
+            return -1;
+        }
+#ifdef IP_BIND_ADDRESS_NO_PORT
+        // 포트 할당을 connect()까지 미뤄 출발지 주소마다 (목적지별) 임시 포트 범위 전체를 쓰도록 함
+        int iNoPort = 1;
+        setsockopt(iSock, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &iNoPort, sizeof(iNoPort));
+#endif
+        if (bind(iSock, (struct sockaddr *)&stSockLocalAddr, sizeof(stSockLocalAddr)) < 0) {
+            perror("Bind local address failed");
+            close(iSock);
+            return -1;
+        }
+    }
+
+    return connectClientSocket(iSock, (struct sockaddr *)&stSockServAddr, sizeof(stSockServAddr), iPort);
+}
+
+static int getSockAddrPort(const struct sockaddr *kpstAddr) {
+    if (kpstAddr->sa_family == AF_INET6) {
+        return ntohs(((const struct sockaddr_in6 *)kpstAddr)->sin6_port);
+    }
+    return ntohs(((const struct sockaddr_in *)kpstAddr)->sin_port);
+}
+
+static socklen_t getSockAddrLen(const struct sockaddr *kpstAddr) {
+    return (kpstAddr->sa_family == AF_INET6) ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+}
+
+int createClientSocketAddr(const struct sockaddr *kpstAddr, socklen_t uiAddrLen) {
+    int iSock;
+
+    if ((iSock = socket(kpstAddr->sa_family, SOCK_STREAM, 0)) < 0) {
+        perror("Socket creation error");
         return -1;
     }
+    return connectClientSocket(iSock, kpstAddr, uiAddrLen, getSockAddrPort(kpstAddr));
+}
 
-    return iSock;
+/**
+ * @brief 주소 계열이 번갈아 나오도록 시도 순서를 정합니다 (RFC 8305 4절).
+ *
+ * @details 첫 주소의 계열부터 시작하고, 같은 계열 안에서는 주어진 순서를 유지합니다.
+ */
+static void orderRaceAttempts(const struct sockaddr_storage *kpstAddrs, int iAddrs, int *piOrder) {
+    int iFirstFamily = kpstAddrs[0].ss_family;
+    int iFirst = 0;
+    int iOther = 0;
+
+    for (int i = 0; i < iAddrs; i++) {
+        // 다음 차례 계열의 남은 주소 중 가장 앞의 것을 고르고, 없으면 다른 계열에서 고름
+        int iWantFirst = (i % 2 == 0);
+        int *piCursor = iWantFirst ? &iFirst : &iOther;
+        while (*piCursor < iAddrs && ((kpstAddrs[*piCursor].ss_family == iFirstFamily) != iWantFirst)) {
+            (*piCursor)++;
+        }
+        if (*piCursor == iAddrs) {
+            iWantFirst = !iWantFirst;
+            piCursor = iWantFirst ? &iFirst : &iOther;
+            while (*piCursor < iAddrs && ((kpstAddrs[*piCursor].ss_family == iFirstFamily) != iWantFirst)) {
+                (*piCursor)++;
+            }
+        }
+        piOrder[i] = (*piCursor)++;
+    }
+}
+
+int createClientSocketRace(const struct sockaddr_storage *kpstAddrs, int iAddrs, int iDelayMsec, int iTimeoutMsec) {
+    struct pollfd astPoll[TCP_CONNECT_RACE_MAX];
+    int aiOrder[TCP_CONNECT_RACE_MAX];
+    int iActive = 0;
+    int iNext = 0;
+    int iWinner = -1;
+    int iLastError = ETIMEDOUT;
+
+    if (iAddrs <= 0) {
+        fprintf(stderr, "createClientSocketRace: no address\n");
+        return -1;
+    }
+    if (iAddrs > TCP_CONNECT_RACE_MAX) {
+        iAddrs = TCP_CONNECT_RACE_MAX;
+    }
+    orderRaceAttempts(kpstAddrs, iAddrs, aiOrder);
+
+    unsigned long long ullNow = getMonotonicNsec();
+    unsigned long long ullNextStart = ullNow;
+    unsigned long long ullDeadline = (iTimeoutMsec > 0) ? ullNow + (unsigned long long)iTimeoutMsec * 1000000ULL : 0;
+    while (iWinner < 0) {
+        ullNow = getMonotonicNsec();
+        if (ullDeadline != 0 && ullNow >= ullDeadline) {
+            break;
+        }
+
+        // 진행 중인 시도가 없거나 간격이 지나면 다음 주소로 시도를 시작
+        if (iNext < iAddrs && (iActive == 0 || ullNow >= ullNextStart)) {
+            const struct sockaddr *kpstAddr = (const struct sockaddr *)&kpstAddrs[aiOrder[iNext++]];
+            int iSock = socket(kpstAddr->sa_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if (iSock < 0) {
+                iLastError = errno;
+                continue;
+            }
+            TCP_PROBE2(connect_start, iSock, getSockAddrPort(kpstAddr));
+            if (connect(iSock, kpstAddr, getSockAddrLen(kpstAddr)) == 0) {
+                iWinner = iSock;
+                break;
+            }
+            if (errno != EINPROGRESS) {
+                iLastError = errno;
+                TCP_PROBE3(connect_done, iSock, -1, errno);
+                addMetricCounter(TCP_COUNTER_CONNECT_FAILURES, 1);
+                close(iSock);
+                continue;
+            }
+            astPoll[iActive].fd = iSock;
+            astPoll[iActive].events = POLLOUT;
+            astPoll[iActive].revents = 0;
+            iActive++;
+            ullNextStart = ullNow + (unsigned long long)iDelayMsec * 1000000ULL;
+            continue;
+        }
+        if (iActive == 0) {
+            break;
+        }
+
+        unsigned long long ullWake = (iNext < iAddrs) ? ullNextStart : 0;
+        if (ullDeadline != 0 && (ullWake == 0 || ullDeadline < ullWake)) {
+            ullWake = ullDeadline;
+        }
+        int iWaitMsec = (ullWake == 0) ? -1 : (int)((ullWake - ullNow + 999999ULL) / 1000000ULL);
+        if (poll(astPoll, (nfds_t)iActive, iWaitMsec) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll failed");
+            break;
+        }
+        for (int i = 0; i < iActive && iWinner < 0; i++) {
+            if (astPoll[i].revents == 0) {
+                continue;
+            }
+            int iError = 0;
+            socklen_t uiErrorLen = sizeof(iError);
+            getsockopt(astPoll[i].fd, SOL_SOCKET, SO_ERROR, &iError, &uiErrorLen);
+            if (iError == 0) {
+                iWinner = astPoll[i].fd;
+                astPoll[i] = astPoll[--iActive];
+                break;
+            }
+            // 실패하면 간격을 기다리지 않고 바로 다음 주소를 시도
+            iLastError = iError;
+            TCP_PROBE3(connect_done, astPoll[i].fd, -1, iError);
+            addMetricCounter(TCP_COUNTER_CONNECT_FAILURES, 1);
+            close(astPoll[i].fd);
+            astPoll[i--] = astPoll[--iActive];
+            ullNextStart = ullNow;
+        }
+    }
+
+    // 이긴 시도를 뺀 나머지는 취소
+    for (int i = 0; i < iActive; i++) {
+        TCP_PROBE3(connect_done, astPoll[i].fd, -1, ECANCELED);
+        close(astPoll[i].fd);
+    }
+    if (iWinner < 0) {
+        fprintf(stderr, "Connection failed: %s\n", strerror(iLastError));
+        return -1;
+    }
+
+    fcntl(iWinner, F_SETFL, fcntl(iWinner, F_GETFL) & ~O_NONBLOCK);
+    TCP_PROBE3(connect_done, iWinner, 0, 0);
+    addMetricCounter(TCP_COUNTER_CONNECTS, 1);
+    registerConnInfo(iWinner);
+    captureTraffic(iWinner, TCP_CAPTURE_CONNECT, NULL, 0);
+
+    return iWinner;
+}
+
+int acceptClientSocket(int iServerSock)
+{
+    struct sockaddr_in stSockAddr;
+    socklen_t uiSockAddrLen = sizeof(stSockAddr);
+
+    int iClientSock = accept(iServerSock, (struct sockaddr *)&stSockAddr, &uiSockAddrLen);
+    if (iClientSock < 0) {
+        TCP_PROBE3(accept, -1, iServerSock, errno);
+        perror("Accept failed");
+        return -1;
+    }
+    TCP_PROBE3(accept, iClientSock, iServerSock, 0);
+    addMetricCounter(TCP_COUNTER_ACCEPTS, 1);
+    registerConnInfo(iClientSock);
+    captureTraffic(iClientSock, TCP_CAPTURE_ACCEPT, NULL, 0);
+
+    return iClientSock;
 }
 
 void handleClientDisconnection(int iClientSockfd) {
     printf("Client disconnected, closing socket\n");
+    TCP_PROBE1(close, iClientSockfd);
+    removeConnInfo(iClientSockfd);
     close(iClientSockfd);
 }
 
@@ -166,6 +450,8 @@ void checkClientConnections(int *piClientSockets, int iMaxClients) {
             int result = recv(piClientSockets[i], buffer, sizeof(buffer), MSG_PEEK | MSG_DONTWAIT);
             if (result == 0) {
                 printf("Client socket %d appears to have disconnected\n", piClientSockets[i]);
+                TCP_PROBE1(disconnect, piClientSockets[i]);
+                addMetricCounter(TCP_COUNTER_DISCONNECTS, 1);
                 handleClientDisconnection(piClientSockets[i]);
                 piClientSockets[i] = 0;
             }
@@ -189,51 +475,315 @@ void setSocketBufferSize(int iSock, int iRxSize, int iTxSize)
 
 
 int sendMessage(int iSock, const void *cpvBuffer, size_t iLength) {
-    ssize_t sent = send(iSock, cpvBuffer, iLength, 0);
+    // 루프백에서는 send() 도중에 ACK가 처리될 수 있으므로 전송 시각은 호출 전에 기록
+    TcpConnInfo *pstConn = findConnInfo(iSock);
+    unsigned long long ullSendNsec = (pstConn != NULL && pstConn->pstTxStamps != NULL) ? getRealtimeNsec() : 0;
+
+    TCP_STAGE_MARK(TCP_STAGE_ENQUEUE);
+    unsigned long long ullCost = beginConnCost();
+    ssize_t sent;
+    if (pstConn != NULL && pstConn->pstImpair != NULL) {
+        struct iovec stIov;
+        stIov.iov_base = (void *)cpvBuffer;
+        stIov.iov_len = iLength;
+        sent = sendImpaired(pstConn, &stIov, 1);
+    } else {
+        sent = send(iSock, cpvBuffer, iLength, 0);
+    }
     if (sent < 0) {
+        TCP_PROBE3(send, iSock, -1, errno);
         perror("send failed");
         return -1;
     }
+    TCP_PROBE3(send, iSock, sent, 0);
+    TCP_STAGE_MARK(TCP_STAGE_SENT);
+    countSend((pstConn != NULL) ? pstConn->pstStats : NULL, (size_t)sent);
+    endConnCost(iSock, TCP_COST_SEND, ullCost);
+    captureTraffic(iSock, TCP_CAPTURE_OUT, cpvBuffer, (size_t)sent);
+
+    if (ullSendNsec != 0 && sent > 0) {
+        recordTxSend(pstConn, (size_t)sent, ullSendNsec);
+    }
     return (int)sent;
 }
 
 
+int sendMessageV(int iSock, const struct iovec *kpstIov, int iIovCnt)
+{
+    struct iovec astIov[TCP_IOV_MAX];
+    size_t uiTotal = 0;
+
+    if (iIovCnt < 0 || iIovCnt > TCP_IOV_MAX) {
+        fprintf(stderr, "sendMessageV: invalid iovec count %d\n", iIovCnt);
+        return -1;
+    }
+    memcpy(astIov, kpstIov, sizeof(struct iovec) * (size_t)iIovCnt);
+    TCP_STAGE_MARK(TCP_STAGE_ENQUEUE);
+
+    TcpConnInfo *pstConn = findConnInfo(iSock);
+    int iTxStamp = (pstConn != NULL && pstConn->pstTxStamps != NULL);
+    unsigned long long ullCost = beginConnCost();
+
+    struct iovec *pstCur = astIov;
+    int iRemain = iIovCnt;
+    while (iRemain > 0) {
+        unsigned long long ullSendNsec = iTxStamp ? getRealtimeNsec() : 0;
+        ssize_t sent = (pstConn != NULL && pstConn->pstImpair != NULL) ? sendImpaired(pstConn, pstCur, iRemain)
+                                                                          : writev(iSock, pstCur, iRemain);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            TCP_PROBE3(send, iSock, -1, errno);
+            perror("writev failed");
+            return -1;
+        }
+        TCP_PROBE3(send, iSock, sent, 0);
+        countSend((pstConn != NULL) ? pstConn->pstStats : NULL, (size_t)sent);
+        captureTrafficV(iSock, TCP_CAPTURE_OUT, pstCur, iRemain, (size_t)sent);
+        if (iTxStamp && sent > 0) {
+            recordTxSend(pstConn, (size_t)sent, ullSendNsec);
+        }
+        uiTotal += (size_t)sent;
+
+        // 전송이 끝난 버퍼는 건너뛰고, 일부만 전송된 버퍼는 시작 위치를 옮김
+        while (iRemain > 0 && (size_t)sent >= pstCur->iov_len) {
+            sent -= (ssize_t)pstCur->iov_len;
+            pstCur++;
+            iRemain--;
+        }
+        if (iRemain > 0) {
+            pstCur->iov_base = (char *)pstCur->iov_base + sent;
+            pstCur->iov_len -= (size_t)sent;
+        }
+    }
+    TCP_STAGE_MARK(TCP_STAGE_SENT);
+    endConnCost(iSock, TCP_COST_SEND, ullCost);
+    return (int)uiTotal;
+}
+
+
 int recvMsgBlocking(int iSock, void *pvBuffer, size_t iLength) {
-    ssize_t received = recv(iSock, pvBuffer, iLength, 0);
+    unsigned long long ullCost = beginConnCost();
+    ssize_t received = recv(iSock, pvBuffer, limitImpairedRecv(iSock, iLength), 0);
     if (received < 0) {
+        TCP_PROBE3(recv, iSock, -1, errno);
         perror("recv failed");
         return -1;
     }
+    TCP_PROBE3(recv, iSock, received, 0);
+    TCP_STAGE_MARK(TCP_STAGE_RECV);
+    countRecv(findConnStats(iSock), (size_t)received);
+    endConnCost(iSock, TCP_COST_RECV, ullCost);
+    captureTraffic(iSock, TCP_CAPTURE_IN, pvBuffer, (size_t)received);
     return (int)received;
 }
 
 
 int recvMsgTimeout(int iSock, void *pvBuffer, size_t iLength, int iTimeoutMsec) {
-    fd_set read_fds;
-    struct timeval timeout;
+    struct pollfd stPollFd;
 
-    FD_ZERO(&read_fds);
-    FD_SET(iSock, &read_fds);
+    // select()는 FD_SETSIZE(1024) 이상의 소켓을 다룰 수 없으므로 poll()로 대기
+    stPollFd.fd = iSock;
+    stPollFd.events = POLLIN;
+    stPollFd.revents = 0;
 
-    timeout.tv_sec = 0;
-    timeout.tv_usec = (iTimeoutMsec * 1000);
-
-    int ret = select(iSock + 1, &read_fds, NULL, NULL, &timeout);
+    int ret;
+    do {
+        ret = poll(&stPollFd, 1, iTimeoutMsec);
+    } while (ret < 0 && errno == EINTR);
     if (ret < 0) {
-        perror("select error");
+        perror("poll error");
         return -1;
     } else if (ret == 0) {
-        fprintf(stderr, "Timeout: no data received within %d seconds.\n", iTimeoutMsec);
+        TCP_PROBE2(timeout, iSock, iTimeoutMsec);
+        addMetricCounter(TCP_COUNTER_TIMEOUTS, 1);
+        fprintf(stderr, "Timeout: no data received within %d ms.\n", iTimeoutMsec);
         return TCP_TIME_OUT;
     }
+    TCP_STAGE_MARK(TCP_STAGE_READY);
 
-    ssize_t received = recv(iSock, pvBuffer, iLength, 0);//MSG_WAITALL
+    unsigned long long ullCost = beginConnCost();
+    ssize_t received = recv(iSock, pvBuffer, limitImpairedRecv(iSock, iLength), 0);//MSG_WAITALL
     if (received < 0) {
+        TCP_PROBE3(recv, iSock, -1, errno);
         perror("recv failed");
         return -1;
-    }else if(received == 0){
+    }
+    TCP_PROBE3(recv, iSock, received, 0);
+    if(received == 0){
         return TCP_DISCONNECTION;
     }
+    TCP_STAGE_MARK(TCP_STAGE_RECV);
+    countRecv(findConnStats(iSock), (size_t)received);
+    endConnCost(iSock, TCP_COST_RECV, ullCost);
+    captureTraffic(iSock, TCP_CAPTURE_IN, pvBuffer, (size_t)received);
 
     return (int)received;
-}
\ No newline at end of file
+}
+
+
+int enableSocketTimestamping(int iSock, int iFlags)
+{
+    unsigned int uiOpt = 0;
+
+    // 등록되지 않은 fd에 엔트리를 만들면 open_connections 게이지가 틀어지므로 조회만 함
+    TcpConnInfo *pstConn = findConnInfo(iSock);
+    if (pstConn == NULL) {
+        fprintf(stderr, "enableSocketTimestamping: socket %d is not registered\n", iSock);
+        return -1;
+    }
+
+    if (iFlags & TCP_TSTAMP_RX) {
+        uiOpt |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    }
+    if (iFlags & TCP_TSTAMP_HW) {
+        uiOpt |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    }
+    if (iFlags & TCP_TSTAMP_TX) {
+        uiOpt |= SOF_TIMESTAMPING_TX_ACK | SOF_TIMESTAMPING_SOFTWARE
+               | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    }
+
+    // 옵션을 바꾼 뒤 할당에 실패하면 커널과 키가 어긋나므로 대기열을 먼저 할당
+    TcpTxStampRing *pstNewRing = NULL;
+    if ((iFlags & TCP_TSTAMP_TX) && pstConn->pstTxStamps == NULL) {
+        pstNewRing = (TcpTxStampRing *)calloc(1, sizeof(TcpTxStampRing));
+        if (pstNewRing == NULL) {
+            perror("calloc failed");
+            return -1;
+        }
+    }
+
+    if (setsockopt(iSock, SOL_SOCKET, SO_TIMESTAMPING, &uiOpt, sizeof(uiOpt)) < 0) {
+        perror("Setsockopt SO_TIMESTAMPING failed");
+        free(pstNewRing);
+        return -1;
+    }
+
+    if (iFlags & TCP_TSTAMP_TX) {
+        if (pstNewRing != NULL) {
+            pstConn->pstTxStamps = pstNewRing;
+        }
+        // 커널은 OPT_ID가 꺼져 있다가 켜질 때만 ID를 0부터 다시 세므로, 이미 켜져 있었으면 키를 이어 감
+        if (!(pstConn->iTimestamping & TCP_TSTAMP_TX)) {
+            pstConn->uiTxKey = 0;
+        }
+    } else if (pstConn->pstTxStamps != NULL) {
+        free(pstConn->pstTxStamps);
+        pstConn->pstTxStamps = NULL;
+    }
+    pstConn->iTimestamping = iFlags;
+    return 0;
+}
+
+
+int recvMsgTimestamped(int iSock, void *pvBuffer, size_t iLength, TcpRxTimestamp *pstStamp)
+{
+    char achControl[TSTAMP_CONTROL_SIZE];
+    struct iovec stIov;
+    struct msghdr stMsg;
+
+    stIov.iov_base = pvBuffer;
+    stIov.iov_len = limitImpairedRecv(iSock, iLength);
+    memset(&stMsg, 0, sizeof(stMsg));
+    stMsg.msg_iov = &stIov;
+    stMsg.msg_iovlen = 1;
+    stMsg.msg_control = achControl;
+    stMsg.msg_controllen = sizeof(achControl);
+
+    unsigned long long ullCost = beginConnCost();
+    ssize_t received = recvmsg(iSock, &stMsg, 0);
+    if (received < 0) {
+        TCP_PROBE3(recv, iSock, -1, errno);
+        perror("recvmsg failed");
+        return -1;
+    }
+    TCP_PROBE3(recv, iSock, received, 0);
+    if (received == 0) {
+        return TCP_DISCONNECTION;
+    }
+    TCP_STAGE_MARK(TCP_STAGE_RECV);
+    countRecv(findConnStats(iSock), (size_t)received);
+    endConnCost(iSock, TCP_COST_RECV, ullCost);
+    captureTraffic(iSock, TCP_CAPTURE_IN, pvBuffer, (size_t)received);
+
+    memset(pstStamp, 0, sizeof(*pstStamp));
+    for (struct cmsghdr *pstCmsg = CMSG_FIRSTHDR(&stMsg); pstCmsg != NULL; pstCmsg = CMSG_NXTHDR(&stMsg, pstCmsg)) {
+        if (pstCmsg->cmsg_level == SOL_SOCKET && pstCmsg->cmsg_type == SCM_TIMESTAMPING) {
+            struct scm_timestamping stTs;
+            memcpy(&stTs, CMSG_DATA(pstCmsg), sizeof(stTs));
+            pstStamp->stSoftware = stTs.ts[0];
+            pstStamp->stHardware = stTs.ts[2];
+        }
+    }
+
+    unsigned long long ullWireNsec = timespecToNsec(&pstStamp->stSoftware);
+    if (ullWireNsec != 0) {
+        unsigned long long ullNowNsec = getRealtimeNsec();
+        if (ullNowNsec >= ullWireNsec) {
+            pstStamp->ullWireToAppNsec = ullNowNsec - ullWireNsec;
+            recordHistogram(getMetricHistogram(TCP_METRIC_WIRE_TO_APP), pstStamp->ullWireToAppNsec);
+        }
+    }
+
+    return (int)received;
+}
+
+
+int readTxTimestamp(int iSock, TcpTxTimestamp *pstStamp)
+{
+    char achControl[TSTAMP_CONTROL_SIZE];
+    struct msghdr stMsg;
+
+    for (;;) {
+        memset(&stMsg, 0, sizeof(stMsg));
+        stMsg.msg_control = achControl;
+        stMsg.msg_controllen = sizeof(achControl);
+
+        if (recvmsg(iSock, &stMsg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            perror("recvmsg MSG_ERRQUEUE failed");
+            return -1;
+        }
+
+        int iHasStamp = 0;
+        int iHasId = 0;
+        memset(pstStamp, 0, sizeof(*pstStamp));
+        for (struct cmsghdr *pstCmsg = CMSG_FIRSTHDR(&stMsg); pstCmsg != NULL; pstCmsg = CMSG_NXTHDR(&stMsg, pstCmsg)) {
+            if (pstCmsg->cmsg_level == SOL_SOCKET && pstCmsg->cmsg_type == SCM_TIMESTAMPING) {
+                struct scm_timestamping stTs;
+                memcpy(&stTs, CMSG_DATA(pstCmsg), sizeof(stTs));
+                pstStamp->stAck = stTs.ts[0];
+                iHasStamp = 1;
+            } else if ((pstCmsg->cmsg_level == SOL_IP && pstCmsg->cmsg_type == IP_RECVERR)
+                       || (pstCmsg->cmsg_level == SOL_IPV6 && pstCmsg->cmsg_type == IPV6_RECVERR)) {
+                struct sock_extended_err stErr;
+                memcpy(&stErr, CMSG_DATA(pstCmsg), sizeof(stErr));
+                if (stErr.ee_errno == ENOMSG && stErr.ee_origin == SO_EE_ORIGIN_TIMESTAMPING
+                    && stErr.ee_info == SCM_TSTAMP_ACK) {
+                    pstStamp->uiId = stErr.ee_data;
+                    iHasId = 1;
+                }
+            }
+        }
+
+        // ACK 타임스탬프가 아닌 에러 큐 메시지는 건너뜀
+        if (!iHasStamp || !iHasId) {
+            continue;
+        }
+
+        TcpConnInfo *pstConn = findConnInfo(iSock);
+        if (pstConn != NULL && pstConn->pstTxStamps != NULL) {
+            unsigned long long ullSendNsec = matchTxSend(pstConn, pstStamp->uiId);
+            unsigned long long ullAckNsec = timespecToNsec(&pstStamp->stAck);
+            if (ullSendNsec != 0 && ullAckNsec >= ullSendNsec) {
+                pstStamp->ullAppToAckNsec = ullAckNsec - ullSendNsec;
+                recordHistogram(getMetricHistogram(TCP_METRIC_APP_TO_ACK), pstStamp->ullAppToAckNsec);
+            }
+        }
+        return 1;
+    }
+}
@@ -0,0 +1,171 @@
+/**
+ * @file tcp-timer.c
+ * @brief 해시 타이밍 휠 구현
+ *
+ * 만료 틱을 슬롯 수로 나눈 나머지 슬롯의 이중 연결 리스트에 타이머를 넣고,
+ * 틱마다 현재 슬롯에서 만료 틱에 도달한 타이머만 꺼내 콜백을 호출합니다.
+ *
+ * 주요 기능:
+ * - O(1) 타이머 설정/취소
+ * - 지난 틱을 한꺼번에 처리하는 휠 진행
+ * - 다음 깨어날 시각 계산
+ */
+#include "tcp-timer.h"
+
+#include <stdlib.h>
+
+
+static void unlinkTimer(TcpTimer *pstTimer)
+{
+    pstTimer->pstPrev->pstNext = pstTimer->pstNext;
+    pstTimer->pstNext->pstPrev = pstTimer->pstPrev;
+    pstTimer->pstNext = NULL;
+    pstTimer->pstPrev = NULL;
+}
+
+static void linkTimer(TcpTimer *pstHead, TcpTimer *pstTimer)
+{
+    pstTimer->pstNext = pstHead;
+    pstTimer->pstPrev = pstHead->pstPrev;
+    pstHead->pstPrev->pstNext = pstTimer;
+    pstHead->pstPrev = pstTimer;
+}
+
+static unsigned long long nsecToTick(const TcpTimerWheel *kpstWheel, unsigned long long ullNsec)
+{
+    if (ullNsec <= kpstWheel->ullStartNsec) {
+        return 0;
+    }
+    return (ullNsec - kpstWheel->ullStartNsec) / kpstWheel->ullTickNsec;
+}
+
+
+int initTimerWheel(TcpTimerWheel *pstWheel, unsigned int uiSlots, unsigned long long ullTickNsec,
+                   unsigned long long ullNowNsec)
+{
+    if (uiSlots == 0) {
+        uiSlots = TCP_TIMER_DEFAULT_SLOTS;
+    }
+    if (ullTickNsec == 0) {
+        ullTickNsec = TCP_TIMER_DEFAULT_TICK_NSEC;
+    }
+    if ((uiSlots & (uiSlots - 1)) != 0) {
+        return -1;
+    }
+
+    pstWheel->pstSlots = (TcpTimer *)malloc(sizeof(TcpTimer) * uiSlots);
+    if (pstWheel->pstSlots == NULL) {
+        return -1;
+    }
+    for (unsigned int i = 0; i < uiSlots; i++) {
+        pstWheel->pstSlots[i].pstNext = &pstWheel->pstSlots[i];
+        pstWheel->pstSlots[i].pstPrev = &pstWheel->pstSlots[i];
+    }
+    pstWheel->uiSlotMask = uiSlots - 1;
+    pstWheel->uiArmed = 0;
+    pstWheel->ullTickNsec = ullTickNsec;
+    pstWheel->ullStartNsec = ullNowNsec;
+    pstWheel->ullCurrentTick = 0;
+    return 0;
+}
+
+void destroyTimerWheel(TcpTimerWheel *pstWheel)
+{
+    free(pstWheel->pstSlots);
+    pstWheel->pstSlots = NULL;
+    pstWheel->uiArmed = 0;
+}
+
+void initTimer(TcpTimer *pstTimer, TcpTimerCallback pfnCallback, void *pvArg)
+{
+    pstTimer->pstNext = NULL;
+    pstTimer->pstPrev = NULL;
+    pstTimer->ullExpireTick = 0;
+    pstTimer->pfnCallback = pfnCallback;
+    pstTimer->pvArg = pvArg;
+    pstTimer->iArmed = 0;
+}
+
+void armTimer(TcpTimerWheel *pstWheel, TcpTimer *pstTimer, unsigned long long ullExpireNsec)
+{
+    cancelTimer(pstWheel, pstTimer);
+
+    // 틱 경계로 올림하여 만료 시각보다 일찍 호출되지 않도록 함
+    unsigned long long ullTick = nsecToTick(pstWheel, ullExpireNsec + pstWheel->ullTickNsec - 1);
+    if (ullTick <= pstWheel->ullCurrentTick) {
+        ullTick = pstWheel->ullCurrentTick + 1;
+    }
+
+    pstTimer->ullExpireTick = ullTick;
+    pstTimer->iArmed = 1;
+    linkTimer(&pstWheel->pstSlots[ullTick & pstWheel->uiSlotMask], pstTimer);
+    pstWheel->uiArmed++;
+}
+
+void cancelTimer(TcpTimerWheel *pstWheel, TcpTimer *pstTimer)
+{
+    if (pstTimer->iArmed) {
+        unlinkTimer(pstTimer);
+        pstTimer->iArmed = 0;
+        pstWheel->uiArmed--;
+    }
+}
+
+int advanceTimerWheel(TcpTimerWheel *pstWheel, unsigned long long ullNowNsec)
+{
+    unsigned long long ullTarget = nsecToTick(pstWheel, ullNowNsec);
+    if (ullTarget <= pstWheel->ullCurrentTick) {
+        return 0;
+    }
+
+    // 한 바퀴 이상 지났으면 모든 슬롯을 한 번씩만 확인
+    unsigned long long ullTicks = ullTarget - pstWheel->ullCurrentTick;
+    if (ullTicks > (unsigned long long)pstWheel->uiSlotMask + 1) {
+        ullTicks = (unsigned long long)pstWheel->uiSlotMask + 1;
+    }
+
+    // 만료된 타이머를 먼저 모두 떼어낸 뒤 콜백을 호출하여, 콜백이 휠을 바꿔도 순회가 깨지지 않도록 함
+    TcpTimer stExpired;
+    stExpired.pstNext = &stExpired;
+    stExpired.pstPrev = &stExpired;
+    for (unsigned long long i = 1; i <= ullTicks; i++) {
+        TcpTimer *pstHead = &pstWheel->pstSlots[(pstWheel->ullCurrentTick + i) & pstWheel->uiSlotMask];
+        TcpTimer *pstTimer = pstHead->pstNext;
+        while (pstTimer != pstHead) {
+            TcpTimer *pstNext = pstTimer->pstNext;
+            if (pstTimer->ullExpireTick <= ullTarget) {
+                unlinkTimer(pstTimer);
+                linkTimer(&stExpired, pstTimer);
+            }
+            pstTimer = pstNext;
+        }
+    }
+    pstWheel->ullCurrentTick = ullTarget;
+
+    int iFired = 0;
+    while (stExpired.pstNext != &stExpired) {
+        TcpTimer *pstTimer = stExpired.pstNext;
+        unlinkTimer(pstTimer);
+        pstTimer->iArmed = 0;
+        pstWheel->uiArmed--;
+        pstTimer->pfnCallback(pstTimer, pstTimer->pvArg);
+        iFired++;
+    }
+    return iFired;
+}
+
+unsigned long long getNextTimerExpiry(const TcpTimerWheel *kpstWheel)
+{
+    if (kpstWheel->uiArmed == 0) {
+        return 0;
+    }
+
+    for (unsigned int i = 1; i <= kpstWheel->uiSlotMask + 1; i++) {
+        unsigned long long ullTick = kpstWheel->ullCurrentTick + i;
+        const TcpTimer *kpstHead = &kpstWheel->pstSlots[ullTick & kpstWheel->uiSlotMask];
+        if (kpstHead->pstNext != kpstHead) {
+            return kpstWheel->ullStartNsec + ullTick * kpstWheel->ullTickNsec;
+        }
+    }
+    return kpstWheel->ullStartNsec + (kpstWheel->ullCurrentTick + 1) * kpstWheel->ullTickNsec;
+}
@@ -0,0 +1,284 @@
+/**
+ * @file tcp-trace.c
+ * @brief 분산 추적 컨텍스트 생성 및 스레드별 스팬 기록 구현
+ *
+ * 스팬은 스레드별 링 버퍼에 잠금 없이 기록되며, 각 슬롯의 시퀀스 번호를 이용해
+ * 내보내기(export) 도중 덮어써진 스팬을 걸러냅니다. 스레드 버퍼는 전역 연결 리스트에
+ * CAS로 등록되며, 스레드가 종료하면 반납되어 다음에 시작하는 스레드가 재사용합니다.
+ *
+ * 주요 기능:
+ * - 추적/스팬 ID 생성 및 샘플링
+ * - 스레드별 잠금 없는 스팬 버퍼
+ * - Chrome Trace Event 형식(JSON) 내보내기
+ */
+#include "tcp-trace.h"
+#include "tcp-metrics.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+typedef struct {
+    unsigned long long ullSeq;          /**< 기록 완료 시 (인덱스 + 1), 기록 중이면 0 */
+    unsigned long long ullStartNsec;
+    unsigned long long ullEndNsec;
+    unsigned char aucTraceId[TCP_TRACE_ID_SIZE];
+    unsigned char aucSpanId[TCP_SPAN_ID_SIZE];
+    int iSock;
+    unsigned int uiBytes;
+    int iKind;
+    int iTid;                           /**< 기록한 스레드 (버퍼가 재사용되어도 유지) */
+} TraceSpan;
+
+typedef struct TraceSpanBuffer {
+    struct TraceSpanBuffer *pstNext;
+    int iOwned;                         /**< 스레드가 사용 중이면 1 (0이면 다음 스레드가 재사용) */
+    int iTid;
+    unsigned long long ullHead;         /**< 다음에 기록할 인덱스 */
+    unsigned long long ullBase;         /**< clearTraceSpans() 시점의 인덱스 */
+    TraceSpan astSpans[TCP_SPAN_BUFFER_SLOTS];
+} TraceSpanBuffer;
+
+static const char *g_kapchSpanNames[TCP_SPAN_KIND_COUNT] = {
+    "enqueue",
+    "send",
+    "recv",
+    "handler",
+};
+
+static TraceSpanBuffer *g_pstSpanBuffers;
+static unsigned int g_uiSampleRate;
+
+/**
+ * @brief 스레드 종료 시 스팬 버퍼를 반납하기 위한 키
+ */
+static pthread_key_t g_stSpanBufferKey;
+static pthread_once_t g_stSpanBufferOnce = PTHREAD_ONCE_INIT;
+
+static __thread TraceSpanBuffer *t_pstSpanBuffer;
+static __thread unsigned long long t_ullRandState;
+
+
+static unsigned long long nextRandom(void)
+{
+    if (t_ullRandState == 0) {
+        t_ullRandState = getMonotonicNsec() ^ ((unsigned long long)(uintptr_t)&t_ullRandState << 16)
+                       ^ (unsigned long long)getpid();
+        if (t_ullRandState == 0) {
+            t_ullRandState = 0x9E3779B97F4A7C15ULL;
+        }
+    }
+
+    // xorshift64*
+    t_ullRandState ^= t_ullRandState >> 12;
+    t_ullRandState ^= t_ullRandState << 25;
+    t_ullRandState ^= t_ullRandState >> 27;
+    return t_ullRandState * 0x2545F4914F6CDD1DULL;
+}
+
+static void fillRandomId(unsigned char *pucId, size_t uiSize)
+{
+    for (size_t i = 0; i < uiSize; i += sizeof(unsigned long long)) {
+        unsigned long long ullRand = nextRandom();
+        size_t uiCopy = (uiSize - i < sizeof(ullRand)) ? uiSize - i : sizeof(ullRand);
+        memcpy(pucId + i, &ullRand, uiCopy);
+    }
+}
+
+/**
+ * @brief 종료하는 스레드의 스팬 버퍼를 반납합니다.
+ *
+ * @details 내보내기가 잠금 없이 목록을 순회하므로 버퍼는 해제하지 않고 재사용 표시만 합니다.
+ *          기록된 스팬은 다음 스레드가 덮어쓸 때까지 내보내기에 남습니다.
+ */
+static void releaseSpanBuffer(void *pvBuffer)
+{
+    TraceSpanBuffer *pstBuffer = (TraceSpanBuffer *)pvBuffer;
+
+    t_pstSpanBuffer = NULL;
+    __atomic_store_n(&pstBuffer->iOwned, 0, __ATOMIC_RELEASE);
+}
+
+static void initSpanBuffers(void)
+{
+    if (pthread_key_create(&g_stSpanBufferKey, releaseSpanBuffer) != 0) {
+        perror("pthread_key_create failed");
+    }
+}
+
+static TraceSpanBuffer *getThreadSpanBuffer(void)
+{
+    if (t_pstSpanBuffer != NULL) {
+        return t_pstSpanBuffer;
+    }
+    pthread_once(&g_stSpanBufferOnce, initSpanBuffers);
+
+    // 종료한 스레드가 반납한 버퍼를 먼저 재사용 (인덱스는 이어서 증가하므로 이전 스팬은 차례로 덮어씀)
+    TraceSpanBuffer *pstBuffer;
+    for (pstBuffer = __atomic_load_n(&g_pstSpanBuffers, __ATOMIC_ACQUIRE); pstBuffer != NULL;
+         pstBuffer = pstBuffer->pstNext) {
+        int iFree = 0;
+        if (__atomic_compare_exchange_n(&pstBuffer->iOwned, &iFree, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (pstBuffer == NULL) {
+        pstBuffer = (TraceSpanBuffer *)calloc(1, sizeof(TraceSpanBuffer));
+        if (pstBuffer == NULL) {
+            return NULL;
+        }
+        pstBuffer->iOwned = 1;
+
+        TraceSpanBuffer *pstHead = __atomic_load_n(&g_pstSpanBuffers, __ATOMIC_RELAXED);
+        do {
+            pstBuffer->pstNext = pstHead;
+        } while (!__atomic_compare_exchange_n(&g_pstSpanBuffers, &pstHead, pstBuffer, 1,
+                                              __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+    pstBuffer->iTid = (int)syscall(SYS_gettid);
+
+    pthread_setspecific(g_stSpanBufferKey, pstBuffer);
+    t_pstSpanBuffer = pstBuffer;
+    return pstBuffer;
+}
+
+static void writeHexId(FILE *pFile, const unsigned char *kpucId, size_t uiSize)
+{
+    for (size_t i = 0; i < uiSize; i++) {
+        fprintf(pFile, "%02x", kpucId[i]);
+    }
+}
+
+
+void setTraceSampleRate(unsigned int uiOneInN)
+{
+    __atomic_store_n(&g_uiSampleRate, uiOneInN, __ATOMIC_RELAXED);
+}
+
+int startTrace(TcpTraceContext *pstCtx)
+{
+    unsigned int uiRate = __atomic_load_n(&g_uiSampleRate, __ATOMIC_RELAXED);
+
+    memset(pstCtx, 0, sizeof(*pstCtx));
+    if (uiRate == 0) {
+        return 0;
+    }
+
+    fillRandomId(pstCtx->aucTraceId, TCP_TRACE_ID_SIZE);
+    fillRandomId(pstCtx->aucSpanId, TCP_SPAN_ID_SIZE);
+    if (uiRate == 1 || nextRandom() % uiRate == 0) {
+        pstCtx->ucFlags |= TCP_TRACE_FLAG_SAMPLED;
+        return 1;
+    }
+    return 0;
+}
+
+void newChildSpan(const TcpTraceContext *kpstParent, TcpTraceContext *pstChild)
+{
+    if (pstChild != kpstParent) {
+        memcpy(pstChild->aucTraceId, kpstParent->aucTraceId, TCP_TRACE_ID_SIZE);
+        pstChild->ucFlags = kpstParent->ucFlags;
+    }
+    fillRandomId(pstChild->aucSpanId, TCP_SPAN_ID_SIZE);
+}
+
+void recordSpan(const TcpTraceContext *kpstCtx, TcpSpanKind eKind, int iSock, unsigned int uiBytes,
+                unsigned long long ullStartNsec, unsigned long long ullEndNsec)
+{
+    if (!TCP_TRACE_SAMPLED(kpstCtx) || (unsigned int)eKind >= TCP_SPAN_KIND_COUNT) {
+        return;
+    }
+
+    TraceSpanBuffer *pstBuffer = getThreadSpanBuffer();
+    if (pstBuffer == NULL) {
+        return;
+    }
+
+    unsigned long long ullIndex = pstBuffer->ullHead;
+    TraceSpan *pstSpan = &pstBuffer->astSpans[ullIndex % TCP_SPAN_BUFFER_SLOTS];
+
+    __atomic_store_n(&pstSpan->ullSeq, 0ULL, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    pstSpan->ullStartNsec = ullStartNsec;
+    pstSpan->ullEndNsec = ullEndNsec;
+    memcpy(pstSpan->aucTraceId, kpstCtx->aucTraceId, TCP_TRACE_ID_SIZE);
+    memcpy(pstSpan->aucSpanId, kpstCtx->aucSpanId, TCP_SPAN_ID_SIZE);
+    pstSpan->iSock = iSock;
+    pstSpan->uiBytes = uiBytes;
+    pstSpan->iKind = (int)eKind;
+    pstSpan->iTid = pstBuffer->iTid;
+    __atomic_store_n(&pstSpan->ullSeq, ullIndex + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&pstBuffer->ullHead, ullIndex + 1, __ATOMIC_RELEASE);
+}
+
+int exportTraceSpans(const char *kpchPath)
+{
+    FILE *pFile = fopen(kpchPath, "w");
+    if (pFile == NULL) {
+        perror("fopen failed");
+        return -1;
+    }
+
+    int iCount = 0;
+    int iPid = (int)getpid();
+    fprintf(pFile, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    for (TraceSpanBuffer *pstBuffer = __atomic_load_n(&g_pstSpanBuffers, __ATOMIC_ACQUIRE);
+         pstBuffer != NULL; pstBuffer = pstBuffer->pstNext) {
+        unsigned long long ullHead = __atomic_load_n(&pstBuffer->ullHead, __ATOMIC_ACQUIRE);
+        unsigned long long ullStart = __atomic_load_n(&pstBuffer->ullBase, __ATOMIC_RELAXED);
+        if (ullHead > TCP_SPAN_BUFFER_SLOTS && ullHead - TCP_SPAN_BUFFER_SLOTS > ullStart) {
+            ullStart = ullHead - TCP_SPAN_BUFFER_SLOTS;
+        }
+
+        for (unsigned long long i = ullStart; i < ullHead; i++) {
+            TraceSpan *pstSlot = &pstBuffer->astSpans[i % TCP_SPAN_BUFFER_SLOTS];
+            TraceSpan stSpan;
+
+            // 복사 전후의 시퀀스가 같을 때만 온전한 스팬으로 간주
+            if (__atomic_load_n(&pstSlot->ullSeq, __ATOMIC_ACQUIRE) != i + 1) {
+                continue;
+            }
+            memcpy(&stSpan, pstSlot, sizeof(stSpan));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&pstSlot->ullSeq, __ATOMIC_RELAXED) != i + 1) {
+                continue;
+            }
+
+            unsigned long long ullDuration = (stSpan.ullEndNsec > stSpan.ullStartNsec)
+                                           ? stSpan.ullEndNsec - stSpan.ullStartNsec : 0;
+            fprintf(pFile, "%s\n{\"name\":\"%s\",\"cat\":\"tcp\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                           "\"pid\":%d,\"tid\":%d,\"args\":{\"trace_id\":\"",
+                    (iCount == 0) ? "" : ",", g_kapchSpanNames[stSpan.iKind],
+                    (double)stSpan.ullStartNsec / 1000.0, (double)ullDuration / 1000.0,
+                    iPid, stSpan.iTid);
+            writeHexId(pFile, stSpan.aucTraceId, TCP_TRACE_ID_SIZE);
+            fprintf(pFile, "\",\"span_id\":\"");
+            writeHexId(pFile, stSpan.aucSpanId, TCP_SPAN_ID_SIZE);
+            fprintf(pFile, "\",\"fd\":%d,\"bytes\":%u}}", stSpan.iSock, stSpan.uiBytes);
+            iCount++;
+        }
+    }
+
+    fprintf(pFile, "\n]}\n");
+    if (fclose(pFile) != 0) {
+        perror("fclose failed");
+        return -1;
+    }
+    return iCount;
+}
+
+void clearTraceSpans(void)
+{
+    for (TraceSpanBuffer *pstBuffer = __atomic_load_n(&g_pstSpanBuffers, __ATOMIC_ACQUIRE);
+         pstBuffer != NULL; pstBuffer = pstBuffer->pstNext) {
+        __atomic_store_n(&pstBuffer->ullBase, __atomic_load_n(&pstBuffer->ullHead, __ATOMIC_ACQUIRE),
+                         __ATOMIC_RELAXED);
+    }
+}
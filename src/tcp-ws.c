@@ -0,0 +1,731 @@
+/**
+ * @file tcp-ws.c
+ * @brief WebSocket(RFC 6455) 서버 코덱 구현
+ *
+ * HTTP 업그레이드 핸드셰이크, 프레임 헤더 인코딩/해석, 조각 메시지 조립, ping/pong/close
+ * 처리를 제공합니다. 업그레이드 요청은 HTTP 코덱(tcp-http)의 parseHttpRequest()로 해석합니다.
+ * 길이 접두 프레이밍(tcp-frame)과 같은 송수신 경로(sendMessageV(), recvMsgBlocking())를
+ * 사용하므로 연결 통계, 캡처, 장애 시뮬레이션이 그대로 적용됩니다.
+ * 페이로드 마스크는 수신 버퍼 안에서 바로 풀고, x86에서는 AVX2/SSE2로 처리합니다.
+ *
+ * 주요 기능:
+ * - 핸드셰이크 요청 검증과 Sec-WebSocket-Accept 계산 (SHA-1, base64)
+ * - 프레임 헤더 인코딩/해석
+ * - SIMD 페이로드 마스크 적용/해제
+ * - 복사 없는 단일 프레임 메시지 수신과 버퍼 내 조각 메시지 조립
+ * - 텍스트 메시지 UTF-8 검사와 close 코드 검사
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "tcp-ws.h"
+#include "tcp-http.h"
+#include "tcp-sock.h"
+#include "tcp-cpu.h"
+
+#include <sys/uio.h>
+#include <stdint.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WS_MASK_X86     1
+#endif
+
+#define WS_GUID             "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_KEY_MAX          64
+#define WS_ERR_TOO_BIG      -2
+
+#define WS_RESPONSE_BAD_REQUEST \
+    "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n"
+#define WS_RESPONSE_BAD_VERSION \
+    "HTTP/1.1 426 Upgrade Required\r\nSec-WebSocket-Version: 13\r\nConnection: close\r\nContent-Length: 0\r\n\r\n"
+
+typedef struct {
+    uint32_t auiState[5];
+    uint64_t ullLength;
+    unsigned char aucBlock[64];
+    size_t uiBlockUsed;
+} WsSha1;
+
+
+/*
+ * SHA-1 (핸드셰이크 응답 키 계산 전용)
+ */
+static uint32_t rotl32(uint32_t uiValue, int iBits)
+{
+    return (uiValue << iBits) | (uiValue >> (32 - iBits));
+}
+
+static void sha1Block(WsSha1 *pstSha, const unsigned char *kpucBlock)
+{
+    uint32_t auiW[80];
+
+    for (int i = 0; i < 16; i++) {
+        auiW[i] = ((uint32_t)kpucBlock[i * 4] << 24) | ((uint32_t)kpucBlock[i * 4 + 1] << 16)
+                | ((uint32_t)kpucBlock[i * 4 + 2] << 8) | (uint32_t)kpucBlock[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        auiW[i] = rotl32(auiW[i - 3] ^ auiW[i - 8] ^ auiW[i - 14] ^ auiW[i - 16], 1);
+    }
+
+    uint32_t a = pstSha->auiState[0];
+    uint32_t b = pstSha->auiState[1];
+    uint32_t c = pstSha->auiState[2];
+    uint32_t d = pstSha->auiState[3];
+    uint32_t e = pstSha->auiState[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f;
+        uint32_t k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rotl32(a, 5) + f + e + k + auiW[i];
+        e = d;
+        d = c;
+        c = rotl32(b, 30);
+        b = a;
+        a = t;
+    }
+    pstSha->auiState[0] += a;
+    pstSha->auiState[1] += b;
+    pstSha->auiState[2] += c;
+    pstSha->auiState[3] += d;
+    pstSha->auiState[4] += e;
+}
+
+static void sha1Init(WsSha1 *pstSha)
+{
+    pstSha->auiState[0] = 0x67452301;
+    pstSha->auiState[1] = 0xEFCDAB89;
+    pstSha->auiState[2] = 0x98BADCFE;
+    pstSha->auiState[3] = 0x10325476;
+    pstSha->auiState[4] = 0xC3D2E1F0;
+    pstSha->ullLength = 0;
+    pstSha->uiBlockUsed = 0;
+}
+
+static void sha1Update(WsSha1 *pstSha, const void *kpvData, size_t uiLength)
+{
+    const unsigned char *kpucData = (const unsigned char *)kpvData;
+
+    pstSha->ullLength += uiLength;
+    while (uiLength > 0) {
+        size_t uiCopy = sizeof(pstSha->aucBlock) - pstSha->uiBlockUsed;
+        if (uiCopy > uiLength) {
+            uiCopy = uiLength;
+        }
+        memcpy(pstSha->aucBlock + pstSha->uiBlockUsed, kpucData, uiCopy);
+        pstSha->uiBlockUsed += uiCopy;
+        kpucData += uiCopy;
+        uiLength -= uiCopy;
+        if (pstSha->uiBlockUsed == sizeof(pstSha->aucBlock)) {
+            sha1Block(pstSha, pstSha->aucBlock);
+            pstSha->uiBlockUsed = 0;
+        }
+    }
+}
+
+static void sha1Final(WsSha1 *pstSha, unsigned char *pucDigest)
+{
+    uint64_t ullBits = pstSha->ullLength * 8;
+    unsigned char aucLength[8];
+    unsigned char ucPad = 0x80;
+    unsigned char ucZero = 0;
+
+    for (int i = 0; i < 8; i++) {
+        aucLength[i] = (unsigned char)(ullBits >> (56 - i * 8));
+    }
+    sha1Update(pstSha, &ucPad, 1);
+    while (pstSha->uiBlockUsed != 56) {
+        sha1Update(pstSha, &ucZero, 1);
+    }
+    sha1Update(pstSha, aucLength, sizeof(aucLength));
+    for (int i = 0; i < 5; i++) {
+        pucDigest[i * 4] = (unsigned char)(pstSha->auiState[i] >> 24);
+        pucDigest[i * 4 + 1] = (unsigned char)(pstSha->auiState[i] >> 16);
+        pucDigest[i * 4 + 2] = (unsigned char)(pstSha->auiState[i] >> 8);
+        pucDigest[i * 4 + 3] = (unsigned char)pstSha->auiState[i];
+    }
+}
+
+static void encodeBase64(const unsigned char *kpucData, size_t uiLength, char *pchOut)
+{
+    static const char s_kachTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t uiOut = 0;
+
+    for (size_t i = 0; i < uiLength; i += 3) {
+        uint32_t uiGroup = (uint32_t)kpucData[i] << 16;
+        if (i + 1 < uiLength) {
+            uiGroup |= (uint32_t)kpucData[i + 1] << 8;
+        }
+        if (i + 2 < uiLength) {
+            uiGroup |= (uint32_t)kpucData[i + 2];
+        }
+        pchOut[uiOut++] = s_kachTable[(uiGroup >> 18) & 0x3F];
+        pchOut[uiOut++] = s_kachTable[(uiGroup >> 12) & 0x3F];
+        pchOut[uiOut++] = (i + 1 < uiLength) ? s_kachTable[(uiGroup >> 6) & 0x3F] : '=';
+        pchOut[uiOut++] = (i + 2 < uiLength) ? s_kachTable[uiGroup & 0x3F] : '=';
+    }
+    pchOut[uiOut] = '\0';
+}
+
+
+/*
+ * 페이로드 마스크
+ */
+#ifdef WS_MASK_X86
+__attribute__((target("avx2")))
+static size_t maskAvx2(unsigned char *pucData, size_t uiLength, uint32_t uiMask)
+{
+    __m256i vMask = _mm256_set1_epi32((int)uiMask);
+    size_t i = 0;
+
+    for (; i + 32 <= uiLength; i += 32) {
+        __m256i vData = _mm256_loadu_si256((const __m256i *)(pucData + i));
+        _mm256_storeu_si256((__m256i *)(pucData + i), _mm256_xor_si256(vData, vMask));
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static size_t maskSse2(unsigned char *pucData, size_t uiLength, uint32_t uiMask)
+{
+    __m128i vMask = _mm_set1_epi32((int)uiMask);
+    size_t i = 0;
+
+    for (; i + 16 <= uiLength; i += 16) {
+        __m128i vData = _mm_loadu_si128((const __m128i *)(pucData + i));
+        _mm_storeu_si128((__m128i *)(pucData + i), _mm_xor_si128(vData, vMask));
+    }
+    return i;
+}
+#endif
+
+void maskWsPayload(void *pvData, size_t uiLength, const unsigned char *kpucMask, size_t uiOffset)
+{
+    unsigned char *pucData = (unsigned char *)pvData;
+    unsigned char aucMask[8];
+    size_t i = 0;
+
+    // 위상을 맞춘 마스크 키를 두 번 이어 8바이트 단위로도 쓸 수 있게 함
+    for (int j = 0; j < 8; j++) {
+        aucMask[j] = kpucMask[(uiOffset + (size_t)j) & 3];
+    }
+
+#ifdef WS_MASK_X86
+    if (uiLength >= 16) {
+        uint32_t uiMask;
+        memcpy(&uiMask, aucMask, sizeof(uiMask));
+        i = hasCpuAvx2() ? maskAvx2(pucData, uiLength, uiMask) : 0;
+        i += maskSse2(pucData + i, uiLength - i, uiMask);
+    }
+#endif
+
+    // 벡터 단위는 4의 배수이므로 남은 부분도 같은 위상에서 이어짐
+    uint64_t ullMask;
+    memcpy(&ullMask, aucMask, sizeof(ullMask));
+    for (; i + 8 <= uiLength; i += 8) {
+        uint64_t ullData;
+        memcpy(&ullData, pucData + i, sizeof(ullData));
+        ullData ^= ullMask;
+        memcpy(pucData + i, &ullData, sizeof(ullData));
+    }
+    for (; i < uiLength; i++) {
+        pucData[i] ^= aucMask[i & 7];
+    }
+}
+
+
+int encodeWsFrameHeader(unsigned char *pucOut, unsigned char ucOpcode, int iFin,
+                        unsigned long long ullPayloadLength, const unsigned char *kpucMask)
+{
+    int iLength = 2;
+
+    pucOut[0] = (unsigned char)((iFin ? 0x80 : 0) | (ucOpcode & 0x0F));
+    if (ullPayloadLength < 126) {
+        pucOut[1] = (unsigned char)ullPayloadLength;
+    } else if (ullPayloadLength <= 0xFFFF) {
+        pucOut[1] = 126;
+        pucOut[2] = (unsigned char)(ullPayloadLength >> 8);
+        pucOut[3] = (unsigned char)ullPayloadLength;
+        iLength = 4;
+    } else {
+        pucOut[1] = 127;
+        for (int i = 0; i < 8; i++) {
+            pucOut[2 + i] = (unsigned char)(ullPayloadLength >> (56 - i * 8));
+        }
+        iLength = 10;
+    }
+
+    if (kpucMask != NULL) {
+        pucOut[1] |= 0x80;
+        memcpy(pucOut + iLength, kpucMask, 4);
+        iLength += 4;
+    }
+    return iLength;
+}
+
+int parseWsFrameHeader(const void *kpvData, size_t uiLength, TcpWsFrameHeader *pstHeader)
+{
+    const unsigned char *kpucData = (const unsigned char *)kpvData;
+    unsigned int uiHeaderLength = 2;
+
+    if (uiLength < 2) {
+        return 0;
+    }
+    if (kpucData[0] & 0x70) {
+        return -1;      // 확장을 협상하지 않았으므로 예약 비트는 0이어야 함
+    }
+
+    pstHeader->ucFin = (unsigned char)(kpucData[0] >> 7);
+    pstHeader->ucOpcode = (unsigned char)(kpucData[0] & 0x0F);
+    pstHeader->ucMasked = (unsigned char)(kpucData[1] >> 7);
+    switch (pstHeader->ucOpcode) {
+    case TCP_WS_OP_CONTINUATION:
+    case TCP_WS_OP_TEXT:
+    case TCP_WS_OP_BINARY:
+    case TCP_WS_OP_CLOSE:
+    case TCP_WS_OP_PING:
+    case TCP_WS_OP_PONG:
+        break;
+    default:
+        return -1;
+    }
+
+    unsigned long long ullPayloadLength = kpucData[1] & 0x7F;
+    if (ullPayloadLength == 126) {
+        if (uiLength < 4) {
+            return 0;
+        }
+        ullPayloadLength = ((unsigned long long)kpucData[2] << 8) | kpucData[3];
+        uiHeaderLength = 4;
+    } else if (ullPayloadLength == 127) {
+        if (uiLength < 10) {
+            return 0;
+        }
+        ullPayloadLength = 0;
+        for (int i = 0; i < 8; i++) {
+            ullPayloadLength = (ullPayloadLength << 8) | kpucData[2 + i];
+        }
+        if (ullPayloadLength >> 63) {
+            return -1;
+        }
+        uiHeaderLength = 10;
+    }
+
+    if ((pstHeader->ucOpcode & 0x08) && (!pstHeader->ucFin || ullPayloadLength > TCP_WS_MAX_CONTROL)) {
+        return -1;
+    }
+
+    if (pstHeader->ucMasked) {
+        if (uiLength < uiHeaderLength + 4) {
+            return 0;
+        }
+        memcpy(pstHeader->aucMask, kpucData + uiHeaderLength, 4);
+        uiHeaderLength += 4;
+    } else {
+        memset(pstHeader->aucMask, 0, sizeof(pstHeader->aucMask));
+    }
+
+    pstHeader->ullPayloadLength = ullPayloadLength;
+    pstHeader->uiHeaderLength = uiHeaderLength;
+    return (int)uiHeaderLength;
+}
+
+void computeWsAcceptKey(const char *kpchKey, size_t uiKeyLength, char *pchOut)
+{
+    WsSha1 stSha;
+    unsigned char aucDigest[20];
+
+    sha1Init(&stSha);
+    sha1Update(&stSha, kpchKey, uiKeyLength);
+    sha1Update(&stSha, WS_GUID, strlen(WS_GUID));
+    sha1Final(&stSha, aucDigest);
+    encodeBase64(aucDigest, sizeof(aucDigest), pchOut);
+}
+
+
+/*
+ * 연결 상태와 수신 버퍼
+ */
+void initWsConn(TcpWsConn *pstConn, int iSock, void *pvBuffer, size_t uiCapacity)
+{
+    memset(pstConn, 0, sizeof(*pstConn));
+    pstConn->iSock = iSock;
+    pstConn->pucBuffer = (unsigned char *)pvBuffer;
+    pstConn->uiCapacity = uiCapacity;
+}
+
+/**
+ * @brief 해석 위치부터 uiNeeded 바이트가 들어갈 자리를 만들고 한 번 수신합니다.
+ *
+ * @return 수신한 바이트 수, 연결 종료 시 TCP_DISCONNECTION, 자리가 없으면 WS_ERR_TOO_BIG, 실패 시 -1
+ */
+static int fillWsBuffer(TcpWsConn *pstConn, size_t uiNeeded)
+{
+    if (pstConn->uiStart + uiNeeded > pstConn->uiCapacity) {
+        // 해석하지 않은 데이터를 조립 중인 메시지 바로 뒤로 당김
+        size_t uiPending = pstConn->uiEnd - pstConn->uiStart;
+        memmove(pstConn->pucBuffer + pstConn->uiMessageLength, pstConn->pucBuffer + pstConn->uiStart, uiPending);
+        pstConn->uiStart = pstConn->uiMessageLength;
+        pstConn->uiEnd = pstConn->uiStart + uiPending;
+        if (pstConn->uiStart + uiNeeded > pstConn->uiCapacity) {
+            return WS_ERR_TOO_BIG;
+        }
+    }
+
+    int iReceived = recvMsgBlocking(pstConn->iSock, pstConn->pucBuffer + pstConn->uiEnd,
+                                    pstConn->uiCapacity - pstConn->uiEnd);
+    if (iReceived > 0) {
+        pstConn->uiEnd += (size_t)iReceived;
+    }
+    return iReceived;
+}
+
+static int sendWsRaw(int iSock, const void *kpvData, size_t uiLength)
+{
+    struct iovec stIov;
+
+    stIov.iov_base = (void *)kpvData;
+    stIov.iov_len = uiLength;
+    return sendMessageV(iSock, &stIov, 1);
+}
+
+static int sendWsReject(TcpWsConn *pstConn, const char *kpchResponse)
+{
+    sendWsRaw(pstConn->iSock, kpchResponse, strlen(kpchResponse));
+    return -1;
+}
+
+int acceptWsHandshake(TcpWsConn *pstConn)
+{
+    TcpHttpRequest stRequest;
+    int iHeader;
+
+    // 빈 줄까지 수신하여 요청 줄과 헤더를 해석
+    for (;;) {
+        iHeader = parseHttpRequest(pstConn->pucBuffer + pstConn->uiStart, pstConn->uiEnd - pstConn->uiStart,
+                                   &stRequest);
+        if (iHeader != 0) {
+            break;
+        }
+        int iReceived = fillWsBuffer(pstConn, pstConn->uiEnd - pstConn->uiStart + 1);
+        if (iReceived == WS_ERR_TOO_BIG) {
+            fprintf(stderr, "acceptWsHandshake: request header larger than %zu bytes\n", pstConn->uiCapacity);
+            return sendWsReject(pstConn, WS_RESPONSE_BAD_REQUEST);
+        }
+        if (iReceived <= 0) {
+            return iReceived;
+        }
+    }
+    if (iHeader < 0 || stRequest.iMinorVersion != 1 || stRequest.stMethod.uiLength != 3
+        || strncmp(stRequest.stMethod.kpchData, "GET", 3) != 0) {
+        return sendWsReject(pstConn, WS_RESPONSE_BAD_REQUEST);
+    }
+    pstConn->uiStart += (size_t)iHeader;
+
+    size_t uiPath = stRequest.stTarget.uiLength;
+    if (uiPath >= sizeof(pstConn->achPath)) {
+        uiPath = sizeof(pstConn->achPath) - 1;
+    }
+    memcpy(pstConn->achPath, stRequest.stTarget.kpchData, uiPath);
+    pstConn->achPath[uiPath] = '\0';
+
+    const TcpHttpStr *kpstVersion = findHttpHeader(&stRequest, "Sec-WebSocket-Version");
+    if (kpstVersion != NULL && (kpstVersion->uiLength != 2 || strncmp(kpstVersion->kpchData, "13", 2) != 0)) {
+        return sendWsReject(pstConn, WS_RESPONSE_BAD_VERSION);
+    }
+    const TcpHttpStr *kpstUpgrade = findHttpHeader(&stRequest, "Upgrade");
+    const TcpHttpStr *kpstConnection = findHttpHeader(&stRequest, "Connection");
+    const TcpHttpStr *kpstKey = findHttpHeader(&stRequest, "Sec-WebSocket-Key");
+    if (kpstVersion == NULL || kpstUpgrade == NULL || !hasHttpToken(kpstUpgrade, "websocket")
+        || kpstConnection == NULL || !hasHttpToken(kpstConnection, "upgrade")
+        || kpstKey == NULL || kpstKey->uiLength == 0 || kpstKey->uiLength > WS_KEY_MAX) {
+        return sendWsReject(pstConn, WS_RESPONSE_BAD_REQUEST);
+    }
+
+    char achAccept[TCP_WS_ACCEPT_KEY_SIZE + 1];
+    char achResponse[160];
+    computeWsAcceptKey(kpstKey->kpchData, kpstKey->uiLength, achAccept);
+    int iResponse = snprintf(achResponse, sizeof(achResponse),
+                             "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                             "Sec-WebSocket-Accept: %s\r\n\r\n", achAccept);
+    if (sendWsRaw(pstConn->iSock, achResponse, (size_t)iResponse) < 0) {
+        return -1;
+    }
+    return 1;
+}
+
+
+static int failWsRecv(TcpWsConn *pstConn, int iResult)
+{
+    if (iResult == WS_ERR_TOO_BIG) {
+        fprintf(stderr, "recvWsMessage: message larger than %zu bytes\n", pstConn->uiCapacity);
+        sendWsClose(pstConn, TCP_WS_CLOSE_TOO_BIG, NULL);
+        return -1;
+    }
+    return iResult;
+}
+
+static int failWsProtocol(TcpWsConn *pstConn, const char *kpchReason)
+{
+    fprintf(stderr, "recvWsMessage: %s\n", kpchReason);
+    sendWsClose(pstConn, TCP_WS_CLOSE_PROTOCOL, NULL);
+    return -1;
+}
+
+static int failWsInvalidData(TcpWsConn *pstConn, const char *kpchReason)
+{
+    fprintf(stderr, "recvWsMessage: %s\n", kpchReason);
+    sendWsClose(pstConn, TCP_WS_CLOSE_BAD_DATA, NULL);
+    return -1;
+}
+
+/**
+ * @brief UTF-8 유효성 검사 (과잉 표현, 서로게이트, U+10FFFF 초과는 잘못된 값)
+ */
+static int isValidUtf8(const unsigned char *kpucData, size_t uiLength)
+{
+    size_t i = 0;
+
+    while (i < uiLength) {
+        // ASCII 구간은 8바이트씩 건너뜀
+        while (i + 8 <= uiLength) {
+            uint64_t ullChunk;
+            memcpy(&ullChunk, kpucData + i, sizeof(ullChunk));
+            if (ullChunk & 0x8080808080808080ULL) {
+                break;
+            }
+            i += 8;
+        }
+        if (i == uiLength) {
+            break;
+        }
+
+        unsigned char ucLead = kpucData[i];
+        size_t uiExtra;
+        unsigned char ucMin = 0x80;
+        unsigned char ucMax = 0xBF;
+
+        if (ucLead < 0x80) {
+            i++;
+            continue;
+        } else if (ucLead >= 0xC2 && ucLead <= 0xDF) {
+            uiExtra = 1;
+        } else if (ucLead >= 0xE0 && ucLead <= 0xEF) {
+            uiExtra = 2;
+            if (ucLead == 0xE0) {
+                ucMin = 0xA0;       // 과잉 표현
+            } else if (ucLead == 0xED) {
+                ucMax = 0x9F;       // 서로게이트 (U+D800~U+DFFF)
+            }
+        } else if (ucLead >= 0xF0 && ucLead <= 0xF4) {
+            uiExtra = 3;
+            if (ucLead == 0xF0) {
+                ucMin = 0x90;       // 과잉 표현
+            } else if (ucLead == 0xF4) {
+                ucMax = 0x8F;       // U+10FFFF 초과
+            }
+        } else {
+            return 0;
+        }
+
+        if (uiLength - i <= uiExtra) {
+            return 0;
+        }
+        if (kpucData[i + 1] < ucMin || kpucData[i + 1] > ucMax) {
+            return 0;
+        }
+        for (size_t j = 2; j <= uiExtra; j++) {
+            if ((kpucData[i + j] & 0xC0) != 0x80) {
+                return 0;
+            }
+        }
+        i += uiExtra + 1;
+    }
+    return 1;
+}
+
+/**
+ * @brief 상대가 close 프레임에 담아 보낼 수 있는 종료 코드인지 확인
+ *
+ * @details 1005/1006/1015는 프레임에 담지 않는 예약 값이고, 1004와 1016~2999는 아직 정의되지
+ *          않았으며, 3000~4999는 라이브러리/애플리케이션용입니다.
+ */
+static int isValidWsCloseCode(unsigned short usCode)
+{
+    if (usCode >= 3000 && usCode <= 4999) {
+        return 1;
+    }
+    if (usCode < 1000 || usCode > 1014) {
+        return 0;
+    }
+    return usCode != 1004 && usCode != 1005 && usCode != 1006;
+}
+
+int recvWsMessage(TcpWsConn *pstConn, TcpWsMessage *pstMessage)
+{
+    unsigned char *pucBuffer = pstConn->pucBuffer;
+
+    // 직전에 돌려준 조립 메시지는 이제 버림
+    if (pstConn->ucDelivered) {
+        pstConn->uiMessageLength = 0;
+        pstConn->ucMessageOpcode = 0;
+        pstConn->ucDelivered = 0;
+    }
+
+    for (;;) {
+        TcpWsFrameHeader stHeader;
+        int iHeader;
+
+        if (pstConn->uiStart == pstConn->uiEnd) {
+            pstConn->uiStart = pstConn->uiMessageLength;
+            pstConn->uiEnd = pstConn->uiMessageLength;
+        }
+        while ((iHeader = parseWsFrameHeader(pucBuffer + pstConn->uiStart, pstConn->uiEnd - pstConn->uiStart,
+                                             &stHeader)) == 0) {
+            int iReceived = fillWsBuffer(pstConn, pstConn->uiEnd - pstConn->uiStart + 1);
+            if (iReceived <= 0) {
+                return failWsRecv(pstConn, iReceived);
+            }
+        }
+        if (iHeader < 0) {
+            return failWsProtocol(pstConn, "invalid frame header");
+        }
+        if (!stHeader.ucMasked) {
+            return failWsProtocol(pstConn, "unmasked client frame");
+        }
+        if (stHeader.ullPayloadLength > pstConn->uiCapacity) {
+            return failWsRecv(pstConn, WS_ERR_TOO_BIG);
+        }
+
+        size_t uiFrame = (size_t)iHeader + (size_t)stHeader.ullPayloadLength;
+        while (pstConn->uiEnd - pstConn->uiStart < uiFrame) {
+            int iReceived = fillWsBuffer(pstConn, uiFrame);
+            if (iReceived <= 0) {
+                return failWsRecv(pstConn, iReceived);
+            }
+        }
+
+        unsigned char *pucPayload = pucBuffer + pstConn->uiStart + iHeader;
+        size_t uiPayload = (size_t)stHeader.ullPayloadLength;
+        maskWsPayload(pucPayload, uiPayload, stHeader.aucMask, 0);
+        pstConn->uiStart += uiFrame;
+
+        switch (stHeader.ucOpcode) {
+        case TCP_WS_OP_PING:
+            if (!pstConn->ucCloseSent && sendWsMessage(pstConn->iSock, TCP_WS_OP_PONG, pucPayload, uiPayload) < 0) {
+                return -1;
+            }
+            continue;
+
+        case TCP_WS_OP_PONG:
+            continue;
+
+        case TCP_WS_OP_CLOSE:
+            if (uiPayload == 1) {
+                return failWsProtocol(pstConn, "invalid close payload");
+            }
+            pstConn->usCloseCode = (uiPayload >= 2) ? (unsigned short)((pucPayload[0] << 8) | pucPayload[1]) : 0;
+            if (uiPayload >= 2 && !isValidWsCloseCode(pstConn->usCloseCode)) {
+                return failWsProtocol(pstConn, "invalid close code");
+            }
+            if (uiPayload > 2 && !isValidUtf8(pucPayload + 2, uiPayload - 2)) {
+                return failWsInvalidData(pstConn, "close reason is not valid UTF-8");
+            }
+            sendWsClose(pstConn, pstConn->usCloseCode ? pstConn->usCloseCode : TCP_WS_CLOSE_NORMAL, NULL);
+            return TCP_DISCONNECTION;
+
+        case TCP_WS_OP_TEXT:
+        case TCP_WS_OP_BINARY:
+            if (pstConn->ucMessageOpcode != 0) {
+                return failWsProtocol(pstConn, "new message before the previous one finished");
+            }
+            if (stHeader.ucFin) {
+                if (stHeader.ucOpcode == TCP_WS_OP_TEXT && !isValidUtf8(pucPayload, uiPayload)) {
+                    return failWsInvalidData(pstConn, "text message is not valid UTF-8");
+                }
+                // 조각나지 않은 메시지는 수신 버퍼 안의 페이로드를 그대로 돌려줌
+                pstMessage->ucOpcode = stHeader.ucOpcode;
+                pstMessage->pvData = pucPayload;
+                pstMessage->uiLength = uiPayload;
+                return stHeader.ucOpcode;
+            }
+            pstConn->ucMessageOpcode = stHeader.ucOpcode;
+            memmove(pucBuffer + pstConn->uiMessageLength, pucPayload, uiPayload);
+            pstConn->uiMessageLength += uiPayload;
+            continue;
+
+        default:    // TCP_WS_OP_CONTINUATION
+            if (pstConn->ucMessageOpcode == 0) {
+                return failWsProtocol(pstConn, "continuation without a message");
+            }
+            memmove(pucBuffer + pstConn->uiMessageLength, pucPayload, uiPayload);
+            pstConn->uiMessageLength += uiPayload;
+            if (stHeader.ucFin) {
+                if (pstConn->ucMessageOpcode == TCP_WS_OP_TEXT
+                    && !isValidUtf8(pucBuffer, pstConn->uiMessageLength)) {
+                    return failWsInvalidData(pstConn, "text message is not valid UTF-8");
+                }
+                pstMessage->ucOpcode = pstConn->ucMessageOpcode;
+                pstMessage->pvData = pucBuffer;
+                pstMessage->uiLength = pstConn->uiMessageLength;
+                pstConn->ucDelivered = 1;
+                return pstMessage->ucOpcode;
+            }
+            continue;
+        }
+    }
+}
+
+int sendWsMessage(int iSock, unsigned char ucOpcode, const void *kpvPayload, size_t uiLength)
+{
+    unsigned char aucHeader[TCP_WS_MAX_HEADER];
+    struct iovec astIov[2];
+
+    int iHeader = encodeWsFrameHeader(aucHeader, ucOpcode, 1, uiLength, NULL);
+    astIov[0].iov_base = aucHeader;
+    astIov[0].iov_len = (size_t)iHeader;
+    astIov[1].iov_base = (void *)kpvPayload;
+    astIov[1].iov_len = uiLength;
+
+    int iSent = sendMessageV(iSock, astIov, (uiLength > 0) ? 2 : 1);
+    if (iSent < 0) {
+        return -1;
+    }
+    return iSent - iHeader;
+}
+
+int sendWsClose(TcpWsConn *pstConn, unsigned short usCode, const char *kpchReason)
+{
+    unsigned char aucPayload[TCP_WS_MAX_CONTROL];
+    size_t uiReason = (kpchReason != NULL) ? strlen(kpchReason) : 0;
+
+    if (pstConn->ucCloseSent) {
+        return 0;
+    }
+    pstConn->ucCloseSent = 1;
+
+    if (uiReason > TCP_WS_MAX_CONTROL - 2) {
+        uiReason = TCP_WS_MAX_CONTROL - 2;
+    }
+    aucPayload[0] = (unsigned char)(usCode >> 8);
+    aucPayload[1] = (unsigned char)usCode;
+    if (uiReason > 0) {
+        memcpy(aucPayload + 2, kpchReason, uiReason);
+    }
+    return (sendWsMessage(pstConn->iSock, TCP_WS_OP_CLOSE, aucPayload, uiReason + 2) < 0) ? -1 : 0;
+}
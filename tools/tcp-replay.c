@@ -0,0 +1,291 @@
+/**
+ * @file tcp-replay.c
+ * @brief 캡처 파일 재생 도구
+ *
+ * startTrafficCapture()로 기록한 캡처 파일을 읽어, 연결마다 대상 서버(createServerSocket()으로
+ * 만든 서버 등)에 새 연결을 만들고 요청 바이트를 원래 시각 간격대로(또는 배속/최대 속도로) 전송합니다.
+ * 응답 방향 레코드는 같은 크기의 응답이 도착할 때까지 기다리며, 요청 전송부터 응답 수신 완료까지의
+ * 지연 시간을 히스토그램으로 집계합니다.
+ *
+ * 같은 프로세스가 서버와 클라이언트 역할을 함께 한 경우에는 연결 등록 레코드로 역할을 구분하여,
+ * 기본값은 수락한 연결, --client는 연결한 연결만 재생합니다.
+ *
+ * 사용법: tcp-replay <캡처 파일> <서버 IP> <포트> [-x 배속 | --max] [--client]
+ *   -x 배속    원래 간격을 배속으로 나누어 재생 (기본 1.0)
+ *   --max      간격 없이 최대 속도로 재생
+ *   --client   캡처가 클라이언트 쪽에서 기록된 경우 (전송 레코드를 요청으로 사용)
+ */
+#include "tcp-sock.h"
+#include "tcp-capture.h"
+#include "tcp-metrics.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_RECV_TIMEOUT_MSEC    500
+#define REPLAY_RECV_RETRIES         4
+#define REPLAY_BUFFER_SIZE          65536
+
+typedef struct {
+    int iCapturedSock;                  /**< 캡처 당시 소켓 번호 */
+    unsigned long long ullConnId;       /**< 캡처 당시 연결 식별자 */
+    int iRole;                          /**< TCP_CAPTURE_ACCEPT/CONNECT (0이면 등록 레코드 없음) */
+    int iSock;                          /**< 재생 연결 (-1이면 실패 또는 종료) */
+    unsigned long long ullPendingNsec;  /**< 응답을 기다리는 첫 요청의 전송 시각 (0이면 없음) */
+} ReplayConn;
+
+typedef struct {
+    ReplayConn *pstConns;
+    int iCount;
+    int iCapacity;
+} ReplayConnTable;
+
+static unsigned long long g_ullConnections;
+static unsigned long long g_ullRequests;
+static unsigned long long g_ullRequestBytes;
+static unsigned long long g_ullResponseBytes;
+static unsigned long long g_ullErrors;
+static TcpHistogram g_stLatency;
+
+
+static ReplayConn *findReplayConn(ReplayConnTable *pstTable, const TcpCaptureRecord *kpstRecord)
+{
+    for (int i = 0; i < pstTable->iCount; i++) {
+        ReplayConn *pstConn = &pstTable->pstConns[i];
+        if (pstConn->iCapturedSock == kpstRecord->iSock && pstConn->ullConnId == kpstRecord->ullConnId) {
+            return pstConn;
+        }
+    }
+    return NULL;
+}
+
+static ReplayConn *addReplayConn(ReplayConnTable *pstTable, const TcpCaptureRecord *kpstRecord, int iRole)
+{
+    ReplayConn *pstConn = NULL;
+
+    // 종료된 엔트리를 재사용하여 테이블이 동시 연결 수만큼만 커지도록 함
+    for (int i = 0; i < pstTable->iCount && pstConn == NULL; i++) {
+        if (pstTable->pstConns[i].iCapturedSock < 0) {
+            pstConn = &pstTable->pstConns[i];
+        }
+    }
+    if (pstConn == NULL && pstTable->iCount == pstTable->iCapacity) {
+        int iCapacity = (pstTable->iCapacity > 0) ? pstTable->iCapacity * 2 : 64;
+        ReplayConn *pstConns = (ReplayConn *)realloc(pstTable->pstConns, sizeof(ReplayConn) * (size_t)iCapacity);
+        if (pstConns == NULL) {
+            perror("realloc failed");
+            return NULL;
+        }
+        pstTable->pstConns = pstConns;
+        pstTable->iCapacity = iCapacity;
+    }
+
+    if (pstConn == NULL) {
+        pstConn = &pstTable->pstConns[pstTable->iCount++];
+    }
+    pstConn->iCapturedSock = kpstRecord->iSock;
+    pstConn->ullConnId = kpstRecord->ullConnId;
+    pstConn->iRole = iRole;
+    pstConn->iSock = -1;
+    pstConn->ullPendingNsec = 0;
+    return pstConn;
+}
+
+/**
+ * @brief 첫 요청에서 대상 서버로 연결합니다.
+ */
+static int connectReplayConn(ReplayConn *pstConn, const char *kpchIp, int iPort)
+{
+    if (pstConn->iSock < 0 && pstConn->iCapturedSock >= 0) {
+        pstConn->iSock = createClientSocket(kpchIp, iPort);
+        if (pstConn->iSock < 0) {
+            g_ullErrors++;
+            pstConn->iCapturedSock = -1;
+        } else {
+            g_ullConnections++;
+        }
+    }
+    return pstConn->iSock;
+}
+
+static void closeReplayConn(ReplayConn *pstConn)
+{
+    if (pstConn->iSock >= 0) {
+        close(pstConn->iSock);
+        pstConn->iSock = -1;
+    }
+    // 같은 번호가 다음 연결에 재사용되므로 식별자를 지워 새 연결로 인식되게 함
+    pstConn->iCapturedSock = -1;
+}
+
+static void waitUntil(unsigned long long ullTargetNsec)
+{
+    unsigned long long ullNow = getMonotonicNsec();
+    if (ullTargetNsec > ullNow) {
+        struct timespec stSleep;
+        unsigned long long ullDelta = ullTargetNsec - ullNow;
+        stSleep.tv_sec = (time_t)(ullDelta / 1000000000ULL);
+        stSleep.tv_nsec = (long)(ullDelta % 1000000000ULL);
+        nanosleep(&stSleep, NULL);
+    }
+}
+
+static void sendRequest(ReplayConn *pstConn, const unsigned char *kpucData, unsigned int uiLength)
+{
+    unsigned int uiSent = 0;
+
+    if (pstConn->ullPendingNsec == 0) {
+        pstConn->ullPendingNsec = getMonotonicNsec();
+    }
+    while (uiSent < uiLength) {
+        int iRet = sendMessage(pstConn->iSock, kpucData + uiSent, uiLength - uiSent);
+        if (iRet <= 0) {
+            g_ullErrors++;
+            closeReplayConn(pstConn);
+            return;
+        }
+        uiSent += (unsigned int)iRet;
+    }
+    g_ullRequests++;
+    g_ullRequestBytes += uiLength;
+}
+
+static void recvResponse(ReplayConn *pstConn, unsigned int uiLength)
+{
+    static unsigned char s_aucBuffer[REPLAY_BUFFER_SIZE];
+    unsigned int uiReceived = 0;
+    int iRetries = 0;
+
+    while (uiReceived < uiLength) {
+        size_t uiWant = uiLength - uiReceived;
+        int iRet = recvMsgTimeout(pstConn->iSock, s_aucBuffer,
+                                  (uiWant < sizeof(s_aucBuffer)) ? uiWant : sizeof(s_aucBuffer),
+                                  REPLAY_RECV_TIMEOUT_MSEC);
+        if (iRet == TCP_TIME_OUT && ++iRetries < REPLAY_RECV_RETRIES) {
+            continue;
+        }
+        if (iRet <= 0) {
+            g_ullErrors++;
+            closeReplayConn(pstConn);
+            return;
+        }
+        uiReceived += (unsigned int)iRet;
+        iRetries = 0;
+    }
+    g_ullResponseBytes += uiLength;
+
+    if (pstConn->ullPendingNsec != 0) {
+        recordHistogram(&g_stLatency, getMonotonicNsec() - pstConn->ullPendingNsec);
+        pstConn->ullPendingNsec = 0;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <capture file> <server ip> <port> [-x speed | --max] [--client]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    double dSpeed = 1.0;
+    int iMaxSpeed = 0;
+    int iRequestDirection = TCP_CAPTURE_IN;
+    int iRole = TCP_CAPTURE_ACCEPT;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "-x") == 0 && i + 1 < argc) {
+            dSpeed = atof(argv[++i]);
+            if (dSpeed <= 0.0) {
+                dSpeed = 1.0;
+            }
+        } else if (strcmp(argv[i], "--max") == 0) {
+            iMaxSpeed = 1;
+        } else if (strcmp(argv[i], "--client") == 0) {
+            iRequestDirection = TCP_CAPTURE_OUT;
+            iRole = TCP_CAPTURE_CONNECT;
+        } else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    size_t uiSize = 0;
+    const TcpCaptureHeader *kpstHeader = openTrafficCapture(argv[1], &uiSize);
+    if (kpstHeader == NULL) {
+        return EXIT_FAILURE;
+    }
+    if (kpstHeader->ullDropped > 0) {
+        fprintf(stderr, "warning: capture dropped %llu records\n", kpstHeader->ullDropped);
+    }
+
+    const char *kpchIp = argv[2];
+    int iPort = atoi(argv[3]);
+    ReplayConnTable stTable;
+    memset(&stTable, 0, sizeof(stTable));
+
+    unsigned long long ullStart = getMonotonicNsec();
+    for (const TcpCaptureRecord *kpstRecord = nextTrafficRecord(kpstHeader, NULL); kpstRecord != NULL;
+         kpstRecord = nextTrafficRecord(kpstHeader, kpstRecord)) {
+        // 캡처는 등록된 연결만 기록하므로, 식별자가 없는 레코드(이전 형식)는 연결을 구분할 수 없어 건너뜀
+        if (kpstRecord->ullConnId == 0) {
+            continue;
+        }
+        if (kpstRecord->iDirection == TCP_CAPTURE_ACCEPT || kpstRecord->iDirection == TCP_CAPTURE_CONNECT) {
+            addReplayConn(&stTable, kpstRecord, kpstRecord->iDirection);
+            continue;
+        }
+
+        ReplayConn *pstConn = findReplayConn(&stTable, kpstRecord);
+        if (kpstRecord->iDirection == TCP_CAPTURE_CLOSE) {
+            if (pstConn != NULL) {
+                closeReplayConn(pstConn);
+            }
+            continue;
+        }
+        if (pstConn == NULL) {
+            // 캡처 시작 전에 등록된 연결은 역할을 모르므로 방향만으로 재생
+            pstConn = addReplayConn(&stTable, kpstRecord, 0);
+            if (pstConn == NULL) {
+                break;
+            }
+        }
+        if (pstConn->iRole != 0 && pstConn->iRole != iRole) {
+            continue;
+        }
+
+        if (kpstRecord->iDirection == iRequestDirection) {
+            if (!iMaxSpeed) {
+                waitUntil(ullStart + (unsigned long long)((double)kpstRecord->ullOffsetNsec / dSpeed));
+            }
+            if (connectReplayConn(pstConn, kpchIp, iPort) >= 0) {
+                sendRequest(pstConn, TCP_CAPTURE_DATA(kpstRecord), kpstRecord->uiLength);
+            }
+        } else if (pstConn->iSock >= 0) {
+            recvResponse(pstConn, kpstRecord->uiLength);
+        }
+    }
+    unsigned long long ullElapsed = getMonotonicNsec() - ullStart;
+
+    for (int i = 0; i < stTable.iCount; i++) {
+        closeReplayConn(&stTable.pstConns[i]);
+    }
+    free(stTable.pstConns);
+
+    double dSeconds = (double)ullElapsed / 1e9;
+    printf("connections %llu, requests %llu, errors %llu, elapsed %.3f s\n",
+           g_ullConnections, g_ullRequests, g_ullErrors, dSeconds);
+    printf("request bytes %llu, response bytes %llu, %.0f req/s\n",
+           g_ullRequestBytes, g_ullResponseBytes, (dSeconds > 0.0) ? (double)g_ullRequests / dSeconds : 0.0);
+    if (g_stLatency.ullCount > 0) {
+        printf("latency_us count %llu, p50 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n", g_stLatency.ullCount,
+               (double)getHistogramPercentile(&g_stLatency, 50.0) / 1000.0,
+               (double)getHistogramPercentile(&g_stLatency, 99.0) / 1000.0,
+               (double)getHistogramPercentile(&g_stLatency, 99.9) / 1000.0,
+               (double)g_stLatency.ullMax / 1000.0);
+    }
+    return (g_ullErrors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
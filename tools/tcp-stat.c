@@ -0,0 +1,147 @@
+/**
+ * @file tcp-stat.c
+ * @brief 공유 메모리 메트릭 세그먼트 조회 도구
+ *
+ * publishMetricsShm()으로 게시된 세그먼트를 읽기 전용으로 매핑하여 카운터, 게이지,
+ * 히스토그램 백분위, 연결별 통계를 출력합니다. 대상 프로세스에는 어떤 시스템 콜도 발생시키지 않습니다.
+ *
+ * 사용법: tcp-stat <세그먼트 경로> [갱신 주기(ms) | --once]
+ */
+#include "tcp-metrics.h"
+#include "tcp-metrics-shm.h"
+
+#include <unistd.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static void printCounters(const TcpMetricsSegment *kpstSegment)
+{
+    const TcpShmHeader *kpstHeader = &kpstSegment->stHeader;
+
+    printf("%-20s %16s\n", "counter", "total");
+    for (unsigned int i = 0; i < kpstHeader->uiCounterCount && i < TCP_SHM_MAX_COUNTERS; i++) {
+        unsigned long long ullSum = 0;
+        for (unsigned int j = 0; j < kpstHeader->uiThreadSlots && j < TCP_SHM_THREAD_SLOTS; j++) {
+            if (__atomic_load_n(&kpstSegment->astThreads[j].uiInUse, __ATOMIC_ACQUIRE)) {
+                ullSum += __atomic_load_n(&kpstSegment->astThreads[j].aullCounters[i], __ATOMIC_RELAXED);
+            }
+        }
+        printf("%-20s %16llu\n", kpstHeader->aachCounterNames[i], ullSum);
+    }
+
+    printf("\n%-8s %-16s %16s %16s\n", "tid", "thread", "bytes_sent", "bytes_received");
+    for (unsigned int j = 0; j < kpstHeader->uiThreadSlots && j < TCP_SHM_THREAD_SLOTS; j++) {
+        const TcpShmThreadSlot *kpstSlot = &kpstSegment->astThreads[j];
+        if (__atomic_load_n(&kpstSlot->uiInUse, __ATOMIC_ACQUIRE)) {
+            printf("%-8d %-16.16s %16llu %16llu\n", kpstSlot->iTid, kpstSlot->achName,
+                   __atomic_load_n(&kpstSlot->aullCounters[TCP_COUNTER_BYTES_SENT], __ATOMIC_RELAXED),
+                   __atomic_load_n(&kpstSlot->aullCounters[TCP_COUNTER_BYTES_RECEIVED], __ATOMIC_RELAXED));
+        }
+    }
+}
+
+static void printGauges(const TcpMetricsSegment *kpstSegment)
+{
+    const TcpShmHeader *kpstHeader = &kpstSegment->stHeader;
+
+    printf("\n%-20s %16s\n", "gauge", "value");
+    for (unsigned int i = 0; i < kpstHeader->uiGaugeCount && i < TCP_SHM_MAX_GAUGES; i++) {
+        printf("%-20s %16lld\n", kpstHeader->aachGaugeNames[i],
+               __atomic_load_n(&kpstHeader->allGauges[i], __ATOMIC_RELAXED));
+    }
+}
+
+static void printHistograms(const TcpMetricsSegment *kpstSegment)
+{
+    const TcpShmHeader *kpstHeader = &kpstSegment->stHeader;
+
+    printf("\n%-20s %12s %12s %12s %12s\n", "histogram", "count", "p50", "p99", "max");
+    for (unsigned int i = 0; i < kpstHeader->uiHistogramCount && i < TCP_SHM_MAX_HISTOGRAMS; i++) {
+        const TcpHistogram *kpstHist = &kpstSegment->astHistograms[i];
+        unsigned long long ullCount = __atomic_load_n(&kpstHist->ullCount, __ATOMIC_RELAXED);
+        if (ullCount == 0) {
+            continue;
+        }
+        printf("%-20s %12llu %12llu %12llu %12llu\n", kpstHeader->aachHistogramNames[i], ullCount,
+               getHistogramPercentile(kpstHist, 50.0), getHistogramPercentile(kpstHist, 99.0),
+               __atomic_load_n(&kpstHist->ullMax, __ATOMIC_RELAXED));
+    }
+}
+
+static void printConnections(const TcpMetricsSegment *kpstSegment)
+{
+    const TcpShmHeader *kpstHeader = &kpstSegment->stHeader;
+    const TcpConnStats *kpstSlots = TCP_SHM_CONN_SLOTS(kpstSegment);
+    unsigned long long ullNow = getMonotonicNsec();
+
+    double dCycleHz = (kpstHeader->ullCycleHz > 0) ? (double)kpstHeader->ullCycleHz : 1e9;
+
+    printf("\n%-6s %-8s %10s %10s %12s %12s %10s %10s %10s\n",
+           "fd", "owner", "age_ms", "idle_ms", "bytes_in", "bytes_out", "msgs_in", "msgs_out", "cpu_us");
+    for (unsigned int i = 0; i < kpstHeader->uiConnSlots; i++) {
+        TcpConnStats stStats;
+        if (readConnStatsSnapshot(&kpstSlots[i], &stStats) <= 0) {
+            continue;
+        }
+        unsigned long long ullAge = (ullNow > stStats.ullCreatedNsec) ? ullNow - stStats.ullCreatedNsec : 0;
+        unsigned long long ullIdle = (ullNow > stStats.ullLastActiveNsec) ? ullNow - stStats.ullLastActiveNsec : 0;
+        unsigned long long ullCostCycles = 0;
+        for (int j = 0; j < TCP_COST_KIND_COUNT; j++) {
+            ullCostCycles += stStats.aullCostCycles[j];
+        }
+        printf("%-6d %-8d %10llu %10llu %12llu %12llu %10llu %10llu %10.0f\n",
+               stStats.iSock, stStats.iOwnerTid, ullAge / 1000000ULL, ullIdle / 1000000ULL,
+               stStats.ullBytesIn, stStats.ullBytesOut, stStats.ullMsgsIn, stStats.ullMsgsOut,
+               (double)ullCostCycles * 1e6 / dCycleHz);
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <segment path> [interval_ms | --once]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int iIntervalMsec = 1000;
+    int iOnce = 0;
+    if (argc >= 3) {
+        if (strcmp(argv[2], "--once") == 0) {
+            iOnce = 1;
+        } else {
+            iIntervalMsec = atoi(argv[2]);
+            if (iIntervalMsec <= 0) {
+                iIntervalMsec = 1000;
+            }
+        }
+    }
+
+    size_t uiSize = 0;
+    const TcpMetricsSegment *kpstSegment = openMetricsShm(argv[1], &uiSize);
+    if (kpstSegment == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    for (;;) {
+        if (!iOnce) {
+            printf("\033[H\033[J");
+        }
+        printf("pid %d, uptime %llu ms\n\n", kpstSegment->stHeader.iPid,
+               (getMonotonicNsec() - kpstSegment->stHeader.ullStartNsec) / 1000000ULL);
+        printCounters(kpstSegment);
+        printGauges(kpstSegment);
+        printHistograms(kpstSegment);
+        printConnections(kpstSegment);
+        fflush(stdout);
+
+        if (iOnce) {
+            break;
+        }
+        usleep((useconds_t)iIntervalMsec * 1000);
+    }
+    return EXIT_SUCCESS;
+}